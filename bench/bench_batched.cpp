@@ -0,0 +1,184 @@
+// Batched small-matrix benchmarks.
+//
+// `n` sizes the batch rather than the matrices: each case holds about n * n
+// elements (like the vector cases in bench_dense.cpp) split into s x s
+// matrices, s fixed per case. `_soa` cases use the interleaved layout, and
+// `fixed_matmul4` is the same product as batched_gemm4 on Matrix<T, 4, 4>
+// values in a plain loop.
+// Factorizations restore their input from a pristine copy on every call,
+// and that copy is included in the byte count.
+
+#include "harness.hpp"
+
+#include <lana/batched.hpp>
+#include <lana/matrix.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace lana::bench {
+namespace {
+
+/// count s x s matrices, each diagonally dominant (so also well-conditioned
+/// for LU) and made symmetric when `spd` is set.
+template <typename T>
+std::vector<T> small_matrices(index_t s, index_t count, bool spd, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    std::vector<T> v(static_cast<std::size_t>(s * s * count));
+    for (index_t b = 0; b < count; ++b) {
+        T* m = v.data() + b * s * s;
+        for (index_t j = 0; j < s; ++j) {
+            for (index_t i = 0; i < s; ++i) {
+                m[i + j * s] = i == j ? T(s) : dist(gen);
+            }
+        }
+        if (spd) {
+            for (index_t j = 0; j < s; ++j) {
+                for (index_t i = j + 1; i < s; ++i) {
+                    m[j + i * s] = m[i + j * s];
+                }
+            }
+        }
+    }
+    return v;
+}
+
+index_t batch_count(index_t n, index_t s) { return std::max<index_t>(1, n * n / (s * s)); }
+
+template <typename T, index_t S, bool Soa>
+Workload gemm_batch_workload(index_t n) {
+    struct State {
+        index_t count;
+        std::vector<T> a, b, c;
+        batched::InterleavedBatch<T> ia, ib, ic;
+        explicit State(index_t nn)
+            : count(batch_count(nn, S)),
+              a(small_matrices<T>(S, count, false, 1)),
+              b(small_matrices<T>(S, count, false, 2)),
+              c(a.size()) {
+            if (Soa) {
+                ia = batched::InterleavedBatch<T>(S, S, count);
+                ib = batched::InterleavedBatch<T>(S, S, count);
+                ic = batched::InterleavedBatch<T>(S, S, count);
+                batched::pack(batched::StridedBatch<const T>(a.data(), S, S, count), ia.view());
+                batched::pack(batched::StridedBatch<const T>(b.data(), S, S, count), ib.view());
+            }
+        }
+    };
+    auto st = std::make_shared<State>(n);
+    const double count = static_cast<double>(st->count);
+    return {2.0 * S * S * S * count, 3.0 * S * S * count * sizeof(T), [st] {
+                if constexpr (Soa) {
+                    batched::gemm(T(1), st->ia, st->ib, T(0), st->ic.view());
+                } else {
+                    batched::gemm(T(1), batched::StridedBatch<const T>(st->a.data(), S, S, st->count),
+                                  batched::StridedBatch<const T>(st->b.data(), S, S, st->count), T(0),
+                                  batched::StridedBatch<T>(st->c.data(), S, S, st->count));
+                }
+            }};
+}
+
+template <typename T, index_t S, bool Soa, bool Chol>
+Workload factor_batch_workload(index_t n) {
+    struct State {
+        index_t count;
+        std::vector<T> pristine, work;
+        std::vector<std::int32_t> ipiv, info;
+        batched::InterleavedBatch<T> ipristine, iwork;
+        explicit State(index_t nn)
+            : count(batch_count(nn, S)),
+              pristine(small_matrices<T>(S, count, Chol, 3)),
+              work(pristine.size()),
+              ipiv(static_cast<std::size_t>(S * count)),
+              info(static_cast<std::size_t>(count)) {
+            if (Soa) {
+                ipristine = batched::InterleavedBatch<T>(S, S, count);
+                iwork = batched::InterleavedBatch<T>(S, S, count);
+                batched::pack(batched::StridedBatch<const T>(pristine.data(), S, S, count), ipristine.view());
+            }
+        }
+    };
+    auto st = std::make_shared<State>(n);
+    const double count = static_cast<double>(st->count);
+    const double flops = (Chol ? 1.0 : 2.0) / 3.0 * S * S * S * count;
+    return {flops, 3.0 * S * S * count * sizeof(T), [st] {
+                if constexpr (Soa) {
+                    std::copy_n(st->ipristine.data(), st->ipristine.size(), st->iwork.data());
+                    if constexpr (Chol) {
+                        batched::potrf(st->iwork, st->info.data());
+                    } else {
+                        batched::getrf(st->iwork, st->ipiv.data(), st->info.data());
+                    }
+                } else {
+                    std::copy(st->pristine.begin(), st->pristine.end(), st->work.begin());
+                    const batched::StridedBatch<T> a(st->work.data(), S, S, st->count);
+                    if constexpr (Chol) {
+                        batched::potrf(a, st->info.data());
+                    } else {
+                        batched::getrf(a, st->ipiv.data(), st->info.data());
+                    }
+                }
+            }};
+}
+
+template <typename T>
+Workload fixed_matmul4_workload(index_t n) {
+    using M4 = Matrix<T, 4, 4>;
+    struct State {
+        std::vector<M4> a, b, c;
+        explicit State(index_t nn) : a(batch_count(nn, 4)), b(a.size()), c(a.size()) {
+            const std::vector<T> va = small_matrices<T>(4, static_cast<index_t>(a.size()), false, 1);
+            const std::vector<T> vb = small_matrices<T>(4, static_cast<index_t>(a.size()), false, 2);
+            for (std::size_t i = 0; i < a.size(); ++i) {
+                std::copy_n(va.data() + 16 * i, 16, a[i].data());
+                std::copy_n(vb.data() + 16 * i, 16, b[i].data());
+            }
+        }
+    };
+    auto st = std::make_shared<State>(n);
+    const double count = static_cast<double>(st->a.size());
+    return {2.0 * 64 * count, 3.0 * 16 * count * sizeof(T), [st] {
+                for (std::size_t i = 0; i < st->a.size(); ++i) {
+                    st->c[i] = st->a[i] * st->b[i];
+                }
+            }};
+}
+
+template <typename T>
+Workload gemm4_workload(index_t n) {
+    return gemm_batch_workload<T, 4, false>(n);
+}
+template <typename T>
+Workload gemm4_soa_workload(index_t n) {
+    return gemm_batch_workload<T, 4, true>(n);
+}
+template <typename T>
+Workload getrf8_workload(index_t n) {
+    return factor_batch_workload<T, 8, false, false>(n);
+}
+template <typename T>
+Workload getrf8_soa_workload(index_t n) {
+    return factor_batch_workload<T, 8, true, false>(n);
+}
+template <typename T>
+Workload potrf16_workload(index_t n) {
+    return factor_batch_workload<T, 16, false, true>(n);
+}
+template <typename T>
+Workload potrf16_soa_workload(index_t n) {
+    return factor_batch_workload<T, 16, true, true>(n);
+}
+
+LANA_BENCH_FLOAT_KERNEL(batched_gemm4, gemm4_workload);
+LANA_BENCH_FLOAT_KERNEL(batched_gemm4_soa, gemm4_soa_workload);
+LANA_BENCH_FLOAT_KERNEL(batched_getrf8, getrf8_workload);
+LANA_BENCH_FLOAT_KERNEL(batched_getrf8_soa, getrf8_soa_workload);
+LANA_BENCH_FLOAT_KERNEL(batched_potrf16, potrf16_workload);
+LANA_BENCH_FLOAT_KERNEL(batched_potrf16_soa, potrf16_soa_workload);
+LANA_BENCH_FLOAT_KERNEL(fixed_matmul4, fixed_matmul4_workload);
+
+}  // namespace
+}  // namespace lana::bench
@@ -0,0 +1,129 @@
+// Dense-kernel benchmarks: GEMM, BLAS-1 and fused expressions.
+//
+// `n` is the matrix dimension; vector kernels run on n * n elements so every
+// row of the sweep touches a comparable amount of memory. `gemm_mixed` has
+// 16-bit A and B and a float C; its dtype names the operand type.
+
+#include "harness.hpp"
+
+#include <lana/blas1.hpp>
+#include <lana/expr.hpp>
+#include <lana/gemm.hpp>
+#include <lana/half.hpp>
+
+#include <memory>
+#include <random>
+
+namespace lana::bench {
+namespace {
+
+template <typename T>
+void randomize(T* p, index_t n, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    for (index_t i = 0; i < n; ++i) {
+        p[i] = dist(gen);
+    }
+}
+
+template <typename T>
+Workload gemm_workload(index_t n) {
+    auto a = std::make_shared<Matrix<T>>(n, n);
+    auto b = std::make_shared<Matrix<T>>(n, n);
+    auto c = std::make_shared<Matrix<T>>(n, n);
+    randomize(a->data(), a->size(), 1);
+    randomize(b->data(), b->size(), 2);
+    const double nn = static_cast<double>(n);
+    return {2 * nn * nn * nn, 3 * nn * nn * sizeof(T), [a, b, c] { gemm(T(1), a->view(), b->view(), T(0), c->view()); }};
+}
+
+template <typename H>
+Workload gemm_mixed_workload(index_t n) {
+    auto a = std::make_shared<Matrix<H>>(n, n, uninitialized);
+    auto b = std::make_shared<Matrix<H>>(n, n, uninitialized);
+    auto c = std::make_shared<Matrix<float>>(n, n);
+    Matrix<float> tmp(n, n, uninitialized);
+    randomize(tmp.data(), tmp.size(), 1);
+    convert<H, float>(tmp.view(), a->view());
+    randomize(tmp.data(), tmp.size(), 2);
+    convert<H, float>(tmp.view(), b->view());
+    const double nn = static_cast<double>(n);
+    return {2 * nn * nn * nn, nn * nn * (2 * sizeof(H) + sizeof(float)),
+            [a, b, c] { gemm(1.0f, a->view(), b->view(), 0.0f, c->view()); }};
+}
+
+template <typename T>
+struct VectorPair {
+    Vector<T> x;
+    Vector<T> y;
+    explicit VectorPair(index_t len) : x(len, uninitialized), y(len, uninitialized) {
+        randomize(x.data(), len, 3);
+        randomize(y.data(), len, 4);
+    }
+};
+
+template <typename T>
+Workload dot_workload(index_t n) {
+    auto v = std::make_shared<VectorPair<T>>(n * n);
+    const double len = static_cast<double>(n * n);
+    return {2 * len, 2 * len * sizeof(T), [v] {
+                volatile T r = dot(v->x.view(), v->y.view());
+                (void)r;
+            }};
+}
+
+template <typename T>
+Workload axpy_workload(index_t n) {
+    auto v = std::make_shared<VectorPair<T>>(n * n);
+    const double len = static_cast<double>(n * n);
+    return {2 * len, 3 * len * sizeof(T), [v] { axpy(T(1e-6), v->x.view(), v->y.view()); }};
+}
+
+template <typename T>
+Workload sum_workload(index_t n) {
+    auto v = std::make_shared<VectorPair<T>>(n * n);
+    const double len = static_cast<double>(n * n);
+    return {len, len * sizeof(T), [v] {
+                volatile T r = sum(v->x.view());
+                (void)r;
+            }};
+}
+
+template <typename T>
+Workload nrm2_workload(index_t n) {
+    auto v = std::make_shared<VectorPair<T>>(n * n);
+    const double len = static_cast<double>(n * n);
+    return {2 * len, len * sizeof(T), [v] {
+                volatile T r = nrm2(v->x.view());
+                (void)r;
+            }};
+}
+
+/// a = alpha * x + beta * y - z, fused into one pass by the expression templates.
+template <typename T>
+Workload lincomb_workload(index_t n) {
+    struct State {
+        VectorPair<T> xy;
+        Vector<T> z;
+        Vector<T> a;
+        explicit State(index_t len) : xy(len), z(len, uninitialized), a(len, uninitialized) {
+            randomize(z.data(), len, 5);
+        }
+    };
+    auto s = std::make_shared<State>(n * n);
+    const double len = static_cast<double>(n * n);
+    return {4 * len, 4 * len * sizeof(T), [s] { s->a = T(0.5) * s->xy.x + T(2) * s->xy.y - s->z; }};
+}
+
+LANA_BENCH_FLOAT_KERNEL(gemm, gemm_workload);
+const Registrar gemm_mixed_registrar("gemm_mixed", {"bf16", "f16"}, [](const std::string& dtype, index_t n) {
+    return dtype == "bf16" ? gemm_mixed_workload<bfloat16>(n) : gemm_mixed_workload<half>(n);
+});
+LANA_BENCH_FLOAT_KERNEL(dot, dot_workload);
+LANA_BENCH_FLOAT_KERNEL(axpy, axpy_workload);
+LANA_BENCH_FLOAT_KERNEL(sum, sum_workload);
+LANA_BENCH_FLOAT_KERNEL(nrm2, nrm2_workload);
+LANA_BENCH_FLOAT_KERNEL(lincomb, lincomb_workload);
+
+}  // namespace
+}  // namespace lana::bench
@@ -0,0 +1,110 @@
+// Dense factorization benchmarks.
+//
+// `n` is the matrix dimension. Each call restores the input from a pristine
+// copy first; the copy is included in the byte count. The `_refine` solves
+// (f64 only) count the flops of the double factorization they replace.
+
+#include "harness.hpp"
+
+#include <lana/factor.hpp>
+#include <lana/gemm.hpp>
+
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace lana::bench {
+namespace {
+
+/// Random n x n matrix; made symmetric positive definite when `spd` is set.
+template <typename T>
+Matrix<T> dense_matrix(index_t n, bool spd, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<T> dist(T(-1), T(1));
+    Matrix<T> a(n, n, uninitialized);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < n; ++i) {
+            a(i, j) = dist(gen);
+        }
+    }
+    if (!spd) {
+        return a;
+    }
+    Matrix<T> s(n, n, uninitialized);
+    gemm(T(1), a.view(), a.t(), T(0), s.view());
+    for (index_t i = 0; i < n; ++i) {
+        s(i, i) += T(n);
+    }
+    return s;
+}
+
+enum class Factor { Lu, Cholesky, Qr };
+
+template <typename T, Factor F>
+Workload factor_workload(index_t n) {
+    struct State {
+        Matrix<T> pristine, work;
+        std::vector<std::int32_t> ipiv;
+        Vector<T> tau;
+        explicit State(index_t nn)
+            : pristine(dense_matrix<T>(nn, F == Factor::Cholesky, 1)),
+              work(pristine),
+              ipiv(static_cast<std::size_t>(nn)),
+              tau(nn) {}
+    };
+    auto st = std::make_shared<State>(n);
+    const double nn = static_cast<double>(n);
+    const double flops = (F == Factor::Lu ? 2.0 : F == Factor::Cholesky ? 1.0 : 4.0) / 3.0 * nn * nn * nn;
+    return {flops, 3 * nn * nn * sizeof(T), [st] {
+                st->work.view().assign(st->pristine);
+                if constexpr (F == Factor::Lu) {
+                    getrf(st->work.view(), st->ipiv.data());
+                } else if constexpr (F == Factor::Cholesky) {
+                    potrf(st->work.view());
+                } else {
+                    geqrf(st->work.view(), st->tau.view());
+                }
+            }};
+}
+
+template <typename T>
+Workload getrf_workload(index_t n) {
+    return factor_workload<T, Factor::Lu>(n);
+}
+template <typename T>
+Workload potrf_workload(index_t n) {
+    return factor_workload<T, Factor::Cholesky>(n);
+}
+template <typename T>
+Workload geqrf_workload(index_t n) {
+    return factor_workload<T, Factor::Qr>(n);
+}
+
+template <bool Spd>
+Workload refine_workload(index_t n) {
+    struct State {
+        Matrix<double> a, pristine, x;
+        explicit State(index_t nn) : a(dense_matrix<double>(nn, Spd, 1)), pristine(nn, 1, 1.0), x(nn, 1) {}
+    };
+    auto st = std::make_shared<State>(n);
+    const double nn = static_cast<double>(n);
+    return {(Spd ? 1.0 : 2.0) / 3.0 * nn * nn * nn, 1.5 * nn * nn * sizeof(double), [st] {
+                st->x.view().assign(st->pristine);
+                if constexpr (Spd) {
+                    posv_refine(st->a.view(), st->x.view());
+                } else {
+                    gesv_refine(st->a.view(), st->x.view());
+                }
+            }};
+}
+
+LANA_BENCH_FLOAT_KERNEL(getrf, getrf_workload);
+LANA_BENCH_FLOAT_KERNEL(potrf, potrf_workload);
+LANA_BENCH_FLOAT_KERNEL(geqrf, geqrf_workload);
+const Registrar gesv_refine_registrar("gesv_refine", {"f64"},
+                                      [](const std::string&, index_t n) { return refine_workload<false>(n); });
+const Registrar posv_refine_registrar("posv_refine", {"f64"},
+                                      [](const std::string&, index_t n) { return refine_workload<true>(n); });
+
+}  // namespace
+}  // namespace lana::bench
@@ -0,0 +1,133 @@
+// Sparse-kernel benchmarks on 2-D grid operators.
+//
+// `n` is the grid side. CSR runs the 5-point Laplacian on an n x n grid
+// (n * n rows, like the vector cases in bench_dense.cpp). BSR couples 4
+// unknowns per point with dense 4 x 4 blocks on an n/4 x n/4 grid, which
+// stores about as many nonzeros as the CSR case. Solver cases run a fixed
+// number of iterations on the CSR Laplacian so every call does the same work.
+
+#include "harness.hpp"
+
+#include <lana/krylov.hpp>
+#include <lana/sparse.hpp>
+
+#include <algorithm>
+#include <memory>
+
+namespace lana::bench {
+namespace {
+
+/// 5-point stencil on a side x side grid with `dofs` unknowns per point and
+/// dense dofs x dofs couplings.
+template <typename T>
+Csr<T> grid_operator(index_t side, index_t dofs) {
+    const index_t points = side * side;
+    Coo<T> coo(points * dofs, points * dofs);
+    coo.reserve(5 * points * dofs * dofs);
+    auto couple = [&](index_t p, index_t q, T w) {
+        for (index_t a = 0; a < dofs; ++a) {
+            for (index_t b = 0; b < dofs; ++b) {
+                coo.add(p * dofs + a, q * dofs + b, a == b ? w : w / T(8));
+            }
+        }
+    };
+    for (index_t y = 0; y < side; ++y) {
+        for (index_t x = 0; x < side; ++x) {
+            const index_t p = y * side + x;
+            couple(p, p, T(4));
+            if (x > 0) couple(p, p - 1, T(-1));
+            if (x + 1 < side) couple(p, p + 1, T(-1));
+            if (y > 0) couple(p, p - side, T(-1));
+            if (y + 1 < side) couple(p, p + side, T(-1));
+        }
+    }
+    return Csr<T>(coo);
+}
+
+template <typename T>
+Workload spmv_csr_workload(index_t n) {
+    struct State {
+        Csr<T> a;
+        Vector<T> x, y;
+        explicit State(index_t side) : a(grid_operator<T>(side, 1)), x(a.cols(), T(1)), y(a.rows()) {}
+    };
+    auto s = std::make_shared<State>(n);
+    const double nnz = static_cast<double>(s->a.nnz());
+    const double rows = static_cast<double>(s->a.rows());
+    return {2 * nnz, nnz * (sizeof(T) + sizeof(sparse_index_t)) + rows * (3 * sizeof(T) + sizeof(index_t)),
+            [s] { spmv(T(1), s->a, s->x.view(), T(0), s->y.view()); }};
+}
+
+template <typename T>
+Workload spmv_bsr_workload(index_t n) {
+    struct State {
+        Bsr<T> a;
+        Vector<T> x, y;
+        explicit State(index_t side) : a(grid_operator<T>(side / 4, 4), 4, 4), x(a.cols(), T(1)), y(a.rows()) {}
+    };
+    auto s = std::make_shared<State>(n);
+    const double blocks = static_cast<double>(s->a.nnz_blocks());
+    const double rows = static_cast<double>(s->a.rows());
+    return {2 * 16 * blocks, blocks * (16 * sizeof(T) + sizeof(sparse_index_t)) + 3 * rows * sizeof(T),
+            [s] { spmv(T(1), s->a, s->x.view(), T(0), s->y.view()); }};
+}
+
+/// CSR times an 8-column dense block, as in block Krylov methods.
+template <typename T>
+Workload spmm_csr_workload(index_t n) {
+    constexpr index_t k = 8;
+    struct State {
+        Csr<T> a;
+        Matrix<T> b, c;
+        explicit State(index_t side) : a(grid_operator<T>(side, 1)), b(a.cols(), k, T(1)), c(a.rows(), k) {}
+    };
+    auto s = std::make_shared<State>(n);
+    const double nnz = static_cast<double>(s->a.nnz());
+    const double rows = static_cast<double>(s->a.rows());
+    return {2 * nnz * k, nnz * (sizeof(T) + sizeof(sparse_index_t)) + 2 * rows * k * sizeof(T),
+            [s] { spmm(T(1), s->a, s->b.view(), T(0), s->c.view()); }};
+}
+
+/// Iterations per solver call.
+constexpr index_t solver_iterations = 50;
+
+/// Preconditioned CG on the Laplacian; per iteration one SpMV, the
+/// preconditioner and about 13 flops per row of vector updates.
+template <typename T, typename Precond>
+Workload cg_workload(index_t n) {
+    struct State {
+        Csr<T> a;
+        Precond m;
+        Vector<T> b, x;
+        explicit State(index_t side) : a(grid_operator<T>(side, 1)), m(a), b(a.rows(), T(1)), x(a.rows()) {}
+    };
+    auto s = std::make_shared<State>(n);
+    const double nnz = static_cast<double>(s->a.nnz());
+    const double rows = static_cast<double>(s->a.rows());
+    krylov::Options opts;
+    opts.rtol = 0;
+    opts.max_iterations = solver_iterations;
+    return {solver_iterations * (2 * nnz + 13 * rows),
+            solver_iterations * (nnz * (sizeof(T) + sizeof(sparse_index_t)) + 16 * rows * sizeof(T)), [s, opts] {
+                std::fill_n(s->x.data(), s->x.size(), T(0));
+                krylov::cg(s->a, VectorView<const T>(s->b.view()), s->x.view(), s->m, opts);
+            }};
+}
+
+template <typename T>
+Workload cg_jacobi_workload(index_t n) {
+    return cg_workload<T, krylov::Jacobi<T>>(n);
+}
+template <typename T>
+Workload cg_ilu0_workload(index_t n) {
+    return cg_workload<T, krylov::Ilu0<T>>(n);
+}
+
+LANA_BENCH_FLOAT_KERNEL(spmv_csr, spmv_csr_workload);
+LANA_BENCH_FLOAT_KERNEL(spmv_bsr, spmv_bsr_workload);
+LANA_BENCH_FLOAT_KERNEL(spmm_csr, spmm_csr_workload);
+LANA_BENCH_FLOAT_KERNEL(cg_jacobi, cg_jacobi_workload);
+LANA_BENCH_FLOAT_KERNEL(cg_ilu0, cg_ilu0_workload);
+
+}  // namespace
+}  // namespace lana::bench
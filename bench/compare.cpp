@@ -0,0 +1,260 @@
+#include "compare.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <ostream>
+#include <stdexcept>
+#include <tuple>
+
+namespace lana::bench {
+
+namespace {
+
+/// MAD to standard deviation for normal samples, and the standard error of
+/// a median relative to that of a mean (sqrt(pi / 2)).
+constexpr double mad_to_sigma = 1.4826;
+constexpr double median_se = 1.2533;
+
+double parse_number(const std::string& key, const std::string& value) {
+    char* end = nullptr;
+    const double v = std::strtod(value.c_str(), &end);
+    if (end == value.c_str() || *end != '\0' || !(v >= 0)) {
+        throw std::runtime_error("bad value for " + key + ": " + value);
+    }
+    return v;
+}
+
+/// Standard error of r's p50 relative to p50; 0 when its spread is unknown.
+/// With several rounds p50 is a median of round medians and the spread
+/// between rounds is what counts; a single round only has its samples.
+double relative_se(const Result& r) {
+    if (r.p50_s <= 0 || r.samples <= 0) {
+        return 0;
+    }
+    if (r.rounds > 1) {
+        return median_se * mad_to_sigma * r.round_mad_s / r.p50_s / std::sqrt(static_cast<double>(r.rounds));
+    }
+    return median_se * mad_to_sigma * r.mad_s / r.p50_s / std::sqrt(static_cast<double>(r.samples));
+}
+
+auto key_of(const Result& r) { return std::tie(r.kernel, r.dtype, r.n, r.threads); }
+
+}  // namespace
+
+double GateOptions::tolerance_for(const std::string& kernel) const {
+    const auto it = kernel_tolerance.find(kernel);
+    return it != kernel_tolerance.end() ? it->second : tolerance;
+}
+
+GateOptions gate_options(const Metadata& baseline_meta) {
+    GateOptions opt;
+    for (const auto& [key, value] : baseline_meta) {
+        if (key.rfind("gate.", 0) != 0) {
+            continue;
+        }
+        const std::string name = key.substr(5);
+        if (name == "tolerance") {
+            opt.tolerance = parse_number(key, value);
+        } else if (name.rfind("tolerance.", 0) == 0) {
+            opt.kernel_tolerance[name.substr(10)] = parse_number(key, value);
+        } else if (name == "tail_tolerance") {
+            opt.tail_tolerance = parse_number(key, value);
+        } else if (name == "z") {
+            opt.z = parse_number(key, value);
+        } else if (name == "tail_min_samples") {
+            opt.tail_min_samples = static_cast<int>(parse_number(key, value));
+        } else {
+            throw std::runtime_error("unknown gate setting " + key);
+        }
+    }
+    return opt;
+}
+
+const char* verdict_name(Verdict v) {
+    switch (v) {
+        case Verdict::Same:
+            return "ok";
+        case Verdict::Faster:
+            return "faster";
+        case Verdict::Slower:
+            return "SLOWER";
+        case Verdict::SlowerTail:
+            return "SLOWER_P99";
+        case Verdict::Missing:
+            return "MISSING";
+        case Verdict::Added:
+            return "new";
+    }
+    return "?";
+}
+
+bool Comparison::fails(const GateOptions& opt) const {
+    return verdict == Verdict::Slower || verdict == Verdict::SlowerTail ||
+           (verdict == Verdict::Missing && opt.fail_missing);
+}
+
+std::vector<Comparison> compare(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                                const GateOptions& opt) {
+    std::vector<const Result*> base;
+    std::vector<const Result*> cur;
+    for (const Result& r : baseline) {
+        base.push_back(&r);
+    }
+    for (const Result& r : current) {
+        cur.push_back(&r);
+    }
+    const auto order = [](const Result* a, const Result* b) { return key_of(*a) < key_of(*b); };
+    std::sort(base.begin(), base.end(), order);
+    std::sort(cur.begin(), cur.end(), order);
+
+    std::vector<Comparison> out;
+    std::size_t i = 0;
+    std::size_t j = 0;
+    while (i < base.size() || j < cur.size()) {
+        const Result* b = i < base.size() ? base[i] : nullptr;
+        const Result* c = j < cur.size() ? cur[j] : nullptr;
+        if (b != nullptr && c != nullptr && key_of(*b) == key_of(*c)) {
+            ++i;
+            ++j;
+        } else if (c == nullptr || (b != nullptr && key_of(*b) < key_of(*c))) {
+            c = nullptr;
+            ++i;
+        } else {
+            b = nullptr;
+            ++j;
+        }
+        const Result& any = b != nullptr ? *b : *c;
+        Comparison cmp;
+        cmp.kernel = any.kernel;
+        cmp.dtype = any.dtype;
+        cmp.n = any.n;
+        cmp.threads = any.threads;
+        if (b == nullptr || c == nullptr) {
+            cmp.base_p50_s = b != nullptr ? b->p50_s : 0;
+            cmp.cur_p50_s = c != nullptr ? c->p50_s : 0;
+            cmp.verdict = b != nullptr ? Verdict::Missing : Verdict::Added;
+            out.push_back(std::move(cmp));
+            continue;
+        }
+        cmp.base_p50_s = b->p50_s;
+        cmp.cur_p50_s = c->p50_s;
+        const double se = std::hypot(relative_se(*b), relative_se(*c));
+        cmp.se = se;
+        cmp.threshold = opt.tolerance_for(b->kernel) + opt.z * se;
+        cmp.change = b->p50_s > 0 ? c->p50_s / b->p50_s - 1 : 0;
+        cmp.tail_change = b->p99_s > 0 ? c->p99_s / b->p99_s - 1 : 0;
+        // A speedup is judged the same way: base / cur - 1 past the threshold.
+        const double speedup = c->p50_s > 0 ? b->p50_s / c->p50_s - 1 : 0;
+        if (cmp.change > cmp.threshold) {
+            cmp.verdict = Verdict::Slower;
+        } else if (std::min(b->samples, c->samples) >= opt.tail_min_samples &&
+                   cmp.tail_change > opt.tail_tolerance + opt.z * se) {
+            cmp.verdict = Verdict::SlowerTail;
+        } else if (speedup > cmp.threshold) {
+            cmp.verdict = Verdict::Faster;
+        }
+        out.push_back(std::move(cmp));
+    }
+    return out;
+}
+
+std::vector<KernelSummary> summarize(const std::vector<Comparison>& cases, const GateOptions& opt) {
+    std::vector<KernelSummary> out;
+    double log_sum = 0;
+    double var_sum = 0;
+    const auto finish = [&] {
+        if (out.empty() || out.back().cases == 0) {
+            return;
+        }
+        KernelSummary& k = out.back();
+        const double m = static_cast<double>(k.cases);
+        k.change = std::exp(log_sum / m) - 1;
+        k.threshold = opt.tolerance_for(k.kernel) + opt.z * std::sqrt(var_sum) / m;
+        if (k.change > k.threshold) {
+            k.verdict = Verdict::Slower;
+        } else if (1 / (1 + k.change) - 1 > k.threshold) {
+            k.verdict = Verdict::Faster;
+        }
+    };
+    for (const Comparison& c : cases) {
+        if (c.verdict == Verdict::Missing || c.verdict == Verdict::Added || c.base_p50_s <= 0 || c.cur_p50_s <= 0) {
+            continue;
+        }
+        if (out.empty() || out.back().kernel != c.kernel) {
+            finish();
+            out.push_back({c.kernel});
+            log_sum = 0;
+            var_sum = 0;
+        }
+        ++out.back().cases;
+        log_sum += std::log1p(c.change);
+        var_sum += c.se * c.se;
+    }
+    finish();
+    return out;
+}
+
+void merge_fastest(std::vector<Result>& into, const std::vector<Result>& more) {
+    for (const Result& m : more) {
+        const auto it = std::find_if(into.begin(), into.end(), [&](const Result& r) { return key_of(r) == key_of(m); });
+        if (it == into.end()) {
+            into.push_back(m);
+        } else {
+            const double p99 = std::min(it->p99_s, m.p99_s);
+            if (m.p50_s < it->p50_s) {
+                *it = m;
+            }
+            it->p99_s = p99;
+        }
+    }
+}
+
+int write_gate(std::ostream& os, const std::vector<Comparison>& cases, const std::vector<KernelSummary>& kernels,
+               const GateOptions& opt, bool all) {
+    char line[256];
+    std::snprintf(line, sizeof line, "%-18s %-6s %7s %7s %14s %14s %9s %9s %9s  %s\n", "kernel", "dtype", "n",
+                  "threads", "base_p50_us", "p50_us", "change", "allowed", "p99", "verdict");
+    os << line;
+    int counts[6] = {};
+    int failures = 0;
+    for (const Comparison& c : cases) {
+        ++counts[static_cast<int>(c.verdict)];
+        failures += c.fails(opt) ? 1 : 0;
+        if (!all && c.verdict == Verdict::Same) {
+            continue;
+        }
+        const bool both = c.verdict != Verdict::Missing && c.verdict != Verdict::Added;
+        std::snprintf(line, sizeof line, "%-18s %-6s %7td %7d %14.3f %14.3f %+8.1f%% %8.1f%% %+8.1f%%  %s\n",
+                      c.kernel.c_str(), c.dtype.c_str(), c.n, c.threads, c.base_p50_s * 1e6, c.cur_p50_s * 1e6,
+                      both ? c.change * 100 : 0.0, both ? c.threshold * 100 : 0.0, both ? c.tail_change * 100 : 0.0,
+                      verdict_name(c.verdict));
+        os << line;
+    }
+    os << '\n';
+    std::snprintf(line, sizeof line, "%-18s %6s %9s %9s  %s\n", "kernel", "cases", "geomean", "allowed", "verdict");
+    os << line;
+    int slower_kernels = 0;
+    for (const KernelSummary& k : kernels) {
+        slower_kernels += k.verdict == Verdict::Slower ? 1 : 0;
+        if (!all && k.verdict == Verdict::Same) {
+            continue;
+        }
+        std::snprintf(line, sizeof line, "%-18s %6d %+8.1f%% %8.1f%%  %s\n", k.kernel.c_str(), k.cases,
+                      k.change * 100, k.threshold * 100, verdict_name(k.verdict));
+        os << line;
+    }
+    failures += slower_kernels;
+    std::snprintf(line, sizeof line,
+                  "gate: %zu cases, %d slower, %d slower p99, %d missing, %d faster, %d new; %d of %zu kernels "
+                  "slower: %s\n",
+                  cases.size(), counts[static_cast<int>(Verdict::Slower)],
+                  counts[static_cast<int>(Verdict::SlowerTail)], counts[static_cast<int>(Verdict::Missing)],
+                  counts[static_cast<int>(Verdict::Faster)], counts[static_cast<int>(Verdict::Added)], slower_kernels,
+                  kernels.size(), failures > 0 ? "FAIL" : "PASS");
+    os << line;
+    return failures;
+}
+
+}  // namespace lana::bench
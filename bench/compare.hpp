@@ -0,0 +1,106 @@
+#pragma once
+
+// Performance regression gate: compares a lana_bench report against a
+// checked-in baseline report.
+//
+// A baseline is an ordinary text report (write_text), usually recorded on
+// the machine that runs the gate, whose metadata may carry the gate's
+// settings as "# gate.<name>=<value>" lines:
+//
+//     # gate.tolerance=0.10          slowdown of p50 allowed for every case
+//     # gate.tolerance.spmv_csr=0.2  ... or for one kernel
+//     # gate.tail_tolerance=0.5      slowdown of p99 allowed
+//     # gate.z=3                     noise allowance, in standard errors
+//
+// A case (kernel, dtype, n, threads) fails when its p50 time grew by more
+// than tolerance + z * se, se being the combined standard error of the two
+// p50s: from the spread between rounds for reports run with --rounds, else
+// from the samples' MAD. The tolerance absorbs drift (clock, cache,
+// neighbours) that neither spread shows. p99 is checked the same way
+// against tail_tolerance, only for cases with enough samples for p99 to
+// mean something. Each kernel is also judged on the geometric mean over
+// its cases (summarize), so a loss spread over every size and dtype, say a
+// slower GEMM microkernel, fails the gate before any single noisy case
+// crosses its own threshold. Comparing times rather than GFLOP/s treats
+// throughput and latency kernels alike: a 30% GFLOP/s loss is a 43% p50
+// slowdown.
+
+#include "harness.hpp"
+
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace lana::bench {
+
+struct GateOptions {
+    double tolerance = 0.10;
+    std::map<std::string, double> kernel_tolerance;
+    double tail_tolerance = 0.50;
+    double z = 3.0;
+    /// Fewest samples in both runs for the p99 check.
+    int tail_min_samples = 100;
+    /// Whether cases missing from the current report fail the gate.
+    bool fail_missing = true;
+
+    double tolerance_for(const std::string& kernel) const;
+};
+
+/// Defaults overridden by the gate.* entries of a baseline's metadata.
+/// Throws std::runtime_error on a malformed value.
+GateOptions gate_options(const Metadata& baseline_meta);
+
+enum class Verdict { Same, Faster, Slower, SlowerTail, Missing, Added };
+
+const char* verdict_name(Verdict v);
+
+struct Comparison {
+    std::string kernel;
+    std::string dtype;
+    index_t n = 0;
+    int threads = 0;
+    double base_p50_s = 0;
+    double cur_p50_s = 0;
+    /// cur / base - 1 of p50, and the largest change the gate allows.
+    double change = 0;
+    double threshold = 0;
+    double tail_change = 0;
+    /// Combined standard error of the two p50s, relative to p50.
+    double se = 0;
+    Verdict verdict = Verdict::Same;
+
+    bool fails(const GateOptions& opt) const;
+};
+
+/// A kernel's matched cases taken together: the geometric mean of their
+/// p50 changes, held to the kernel's tolerance plus z times the standard
+/// error of that mean, which shrinks with the number of cases. Only ever
+/// Same, Faster or Slower.
+struct KernelSummary {
+    std::string kernel;
+    int cases = 0;
+    double change = 0;
+    double threshold = 0;
+    Verdict verdict = Verdict::Same;
+};
+
+/// One comparison per case in either report, sorted like the reports.
+std::vector<Comparison> compare(const std::vector<Result>& baseline, const std::vector<Result>& current,
+                                const GateOptions& opt);
+
+/// One summary per kernel with matched cases in `cases` (as from compare).
+std::vector<KernelSummary> summarize(const std::vector<Comparison>& cases, const GateOptions& opt);
+
+/// Adds a re-measurement to `into`: cases found in both keep the result
+/// with the lower p50, and the lower p99 of the two; cases only in `more`
+/// are appended. See combine_rounds for why the fastest.
+void merge_fastest(std::vector<Result>& into, const std::vector<Result>& more);
+
+/// The case and kernel tables and a summary line; returns the number of
+/// failing cases and kernels. With `all` unset only rows that are not Same
+/// are listed.
+int write_gate(std::ostream& os, const std::vector<Comparison>& cases, const std::vector<KernelSummary>& kernels,
+               const GateOptions& opt, bool all);
+
+}  // namespace lana::bench
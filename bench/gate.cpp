@@ -0,0 +1,231 @@
+// lana_gate: fails (exit 1) when a lana_bench report regressed against a
+// baseline report, or records a new baseline. See compare.hpp.
+//
+// Reports after the first current one re-measure some of its cases (the
+// gate target reruns the kernels that failed); each case keeps its fastest
+// measurement.
+
+#include "compare.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+struct Options {
+    std::string baseline;
+    std::vector<std::string> current;
+    std::string out;
+    std::string failed;
+    bool all = false;
+    bool allow_missing = false;
+    bool allow_meta_mismatch = false;
+    bool write_baseline = false;
+    double tolerance = -1;
+    double tail_tolerance = -1;
+    double z = -1;
+};
+
+/// Metadata that has to match for timings to be comparable at all.
+const char* const machine_keys[] = {"isa"};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: lana_gate [options] baseline.txt current.txt [rerun.txt...]\n"
+                 "  --all                  list every case, not only those that changed\n"
+                 "  --tolerance x          allowed p50 slowdown, e.g. 0.1 (default: baseline's gate.tolerance)\n"
+                 "  --tail-tolerance x     allowed p99 slowdown (default: baseline's gate.tail_tolerance)\n"
+                 "  --z x                  noise allowance in standard errors (default: baseline's gate.z)\n"
+                 "  --allow-missing        do not fail on baseline cases absent from the current report\n"
+                 "  --allow-meta-mismatch  compare even if the reports come from different ISAs\n"
+                 "  --out path             also write the comparison to path\n"
+                 "  --failed path          write the kernels that were slower to path, comma separated\n"
+                 "  --write-baseline       replace the baseline's results with the current ones, keeping\n"
+                 "                         its gate.* settings, and exit\n");
+}
+
+bool parse(int argc, char** argv, Options& opt) {
+    std::vector<std::string> files;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "lana_gate: %s needs a value\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--all") {
+            opt.all = true;
+        } else if (arg == "--tolerance") {
+            opt.tolerance = std::atof(value().c_str());
+        } else if (arg == "--tail-tolerance") {
+            opt.tail_tolerance = std::atof(value().c_str());
+        } else if (arg == "--z") {
+            opt.z = std::atof(value().c_str());
+        } else if (arg == "--allow-missing") {
+            opt.allow_missing = true;
+        } else if (arg == "--allow-meta-mismatch") {
+            opt.allow_meta_mismatch = true;
+        } else if (arg == "--out") {
+            opt.out = value();
+        } else if (arg == "--failed") {
+            opt.failed = value();
+        } else if (arg == "--write-baseline") {
+            opt.write_baseline = true;
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage();
+            return false;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() < 2) {
+        usage();
+        return false;
+    }
+    opt.baseline = files[0];
+    opt.current.assign(files.begin() + 1, files.end());
+    return true;
+}
+
+void read_report(const std::string& path, lana::bench::Metadata& meta, std::vector<lana::bench::Result>& results) {
+    std::ifstream in(path);
+    if (!in) {
+        throw std::runtime_error("cannot read " + path);
+    }
+    try {
+        lana::bench::read_text(in, meta, results);
+    } catch (const std::runtime_error& e) {
+        throw std::runtime_error(path + ": " + e.what());
+    }
+}
+
+std::string lookup(const lana::bench::Metadata& meta, const std::string& key) {
+    for (const auto& [k, v] : meta) {
+        if (k == key) {
+            return v;
+        }
+    }
+    return "";
+}
+
+int write_baseline(const Options& opt, const lana::bench::Metadata& current_meta,
+                   const std::vector<lana::bench::Result>& current) {
+    lana::bench::Metadata meta = current_meta;
+    std::ifstream old(opt.baseline);
+    if (old) {
+        lana::bench::Metadata old_meta;
+        std::vector<lana::bench::Result> ignored;
+        lana::bench::read_text(old, old_meta, ignored);
+        for (const auto& kv : old_meta) {
+            if (kv.first.rfind("gate.", 0) == 0) {
+                meta.push_back(kv);
+            }
+        }
+    }
+    std::ofstream out(opt.baseline);
+    if (!out) {
+        std::fprintf(stderr, "lana_gate: cannot write %s\n", opt.baseline.c_str());
+        return 2;
+    }
+    lana::bench::write_text(out, meta, current);
+    std::fprintf(stderr, "lana_gate: wrote %zu cases to %s\n", current.size(), opt.baseline.c_str());
+    return 0;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        return 2;
+    }
+    try {
+        lana::bench::Metadata current_meta;
+        std::vector<lana::bench::Result> current;
+        read_report(opt.current.front(), current_meta, current);
+        for (std::size_t i = 1; i < opt.current.size(); ++i) {
+            lana::bench::Metadata ignored;
+            std::vector<lana::bench::Result> more;
+            read_report(opt.current[i], ignored, more);
+            lana::bench::merge_fastest(current, more);
+        }
+        if (opt.write_baseline) {
+            return write_baseline(opt, current_meta, current);
+        }
+        lana::bench::Metadata base_meta;
+        std::vector<lana::bench::Result> baseline;
+        read_report(opt.baseline, base_meta, baseline);
+
+        for (const char* key : machine_keys) {
+            const std::string b = lookup(base_meta, key);
+            const std::string c = lookup(current_meta, key);
+            if (b != c && !opt.allow_meta_mismatch) {
+                std::fprintf(stderr,
+                             "lana_gate: baseline has %s=%s but this run has %s=%s; record a baseline on this "
+                             "machine (--write-baseline) or pass --allow-meta-mismatch\n",
+                             key, b.c_str(), key, c.c_str());
+                return 2;
+            }
+        }
+
+        lana::bench::GateOptions gate = lana::bench::gate_options(base_meta);
+        if (opt.tolerance >= 0) {
+            gate.tolerance = opt.tolerance;
+            gate.kernel_tolerance.clear();
+        }
+        if (opt.tail_tolerance >= 0) {
+            gate.tail_tolerance = opt.tail_tolerance;
+        }
+        if (opt.z >= 0) {
+            gate.z = opt.z;
+        }
+        gate.fail_missing = !opt.allow_missing;
+
+        const auto cases = lana::bench::compare(baseline, current, gate);
+        const auto kernels = lana::bench::summarize(cases, gate);
+        std::ostringstream table;
+        table << "# lana_gate " << opt.baseline << " ->";
+        for (const std::string& path : opt.current) {
+            table << ' ' << path;
+        }
+        table << '\n';
+        const int failures = lana::bench::write_gate(table, cases, kernels, gate, opt.all);
+        std::cout << table.str();
+        if (!opt.out.empty()) {
+            std::ofstream out(opt.out);
+            out << table.str();
+        }
+        if (!opt.failed.empty()) {
+            std::vector<std::string> failed;
+            for (const auto& c : cases) {
+                const bool slower = c.verdict == lana::bench::Verdict::Slower ||
+                                    c.verdict == lana::bench::Verdict::SlowerTail;
+                if (slower && std::find(failed.begin(), failed.end(), c.kernel) == failed.end()) {
+                    failed.push_back(c.kernel);
+                }
+            }
+            for (const auto& k : kernels) {
+                if (k.verdict == lana::bench::Verdict::Slower &&
+                    std::find(failed.begin(), failed.end(), k.kernel) == failed.end()) {
+                    failed.push_back(k.kernel);
+                }
+            }
+            std::ofstream out(opt.failed);
+            for (std::size_t i = 0; i < failed.size(); ++i) {
+                out << (i ? "," : "") << failed[i];
+            }
+        }
+        return failures > 0 ? 1 : 0;
+    } catch (const std::runtime_error& e) {
+        std::fprintf(stderr, "lana_gate: %s\n", e.what());
+        return 2;
+    }
+}
@@ -0,0 +1,240 @@
+#include "harness.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <istream>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <tuple>
+
+namespace lana::bench {
+
+std::vector<Kernel>& registry() {
+    static std::vector<Kernel> kernels;
+    return kernels;
+}
+
+Registrar::Registrar(std::string name, std::vector<std::string> dtypes, WorkloadFactory make) {
+    registry().push_back({std::move(name), std::move(dtypes), std::move(make)});
+}
+
+double percentile(std::vector<double> samples, double q) {
+    if (samples.empty()) {
+        return 0;
+    }
+    std::sort(samples.begin(), samples.end());
+    const auto rank = static_cast<std::size_t>(std::ceil(q * static_cast<double>(samples.size())));
+    return samples[std::clamp<std::size_t>(rank, 1, samples.size()) - 1];
+}
+
+Result measure(const Workload& w, const TimingOptions& opt) {
+    using clock = std::chrono::steady_clock;
+    for (int i = 0; i < opt.warmup; ++i) {
+        w.run();
+    }
+    std::vector<double> samples;
+    samples.reserve(static_cast<std::size_t>(opt.min_samples));
+    double total = 0;
+    while (static_cast<int>(samples.size()) < opt.max_samples &&
+           (static_cast<int>(samples.size()) < opt.min_samples || total < opt.min_time_s)) {
+        const auto t0 = clock::now();
+        w.run();
+        const double dt = std::chrono::duration<double>(clock::now() - t0).count();
+        samples.push_back(dt);
+        total += dt;
+    }
+    Result r;
+    r.flops = w.flops;
+    r.bytes = w.bytes;
+    r.samples = static_cast<int>(samples.size());
+    r.p50_s = percentile(samples, 0.50);
+    r.p99_s = percentile(samples, 0.99);
+    r.min_s = *std::min_element(samples.begin(), samples.end());
+    r.mean_s = total / static_cast<double>(samples.size());
+    for (double& t : samples) {
+        t = std::abs(t - r.p50_s);
+    }
+    r.mad_s = percentile(std::move(samples), 0.50);
+    return r;
+}
+
+Result combine_rounds(const std::vector<Result>& rounds) {
+    if (rounds.size() == 1) {
+        return rounds.front();
+    }
+    // Interference from the rest of the machine only ever adds time, and
+    // on a shared host it comes in stretches of seconds that can swallow a
+    // whole round, so the fastest round is the one closest to the kernel's
+    // own cost (p50 and p99 each); the spread of the rounds around their
+    // median says how far to trust it.
+    Result r = rounds.front();
+    std::vector<double> p50;
+    r.samples = 0;
+    r.mean_s = 0;
+    for (const Result& x : rounds) {
+        p50.push_back(x.p50_s);
+        if (x.p50_s < r.p50_s) {
+            r.p50_s = x.p50_s;
+            r.mad_s = x.mad_s;
+        }
+        r.p99_s = std::min(r.p99_s, x.p99_s);
+        r.samples += x.samples;
+        r.min_s = std::min(r.min_s, x.min_s);
+        r.mean_s += x.mean_s / static_cast<double>(rounds.size());
+    }
+    r.rounds = static_cast<int>(rounds.size());
+    const double median = percentile(p50, 0.50);
+    for (double& t : p50) {
+        t = std::abs(t - median);
+    }
+    r.round_mad_s = percentile(std::move(p50), 0.50);
+    return r;
+}
+
+namespace {
+
+void sort_results(std::vector<Result>& results) {
+    std::sort(results.begin(), results.end(), [](const Result& a, const Result& b) {
+        return std::tie(a.kernel, a.dtype, a.n, a.threads) < std::tie(b.kernel, b.dtype, b.n, b.threads);
+    });
+}
+
+std::string fmt(const char* spec, double v) {
+    char buf[64];
+    std::snprintf(buf, sizeof buf, spec, v);
+    return buf;
+}
+
+std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out;
+}
+
+}  // namespace
+
+void write_text(std::ostream& os, const Metadata& meta, std::vector<Result> results) {
+    sort_results(results);
+    os << "# lana_bench report v2\n";
+    for (const auto& [k, v] : meta) {
+        os << "# " << k << '=' << v << '\n';
+    }
+    char line[256];
+    std::snprintf(line, sizeof line, "%-16s %-6s %7s %7s %12s %14s %14s %14s %8s %12s %6s %12s\n", "kernel", "dtype",
+                  "n", "threads", "gflops", "bytes_per_flop", "p50_us", "p99_us", "samples", "mad_us", "rounds",
+                  "round_mad_us");
+    os << line;
+    for (const Result& r : results) {
+        std::snprintf(line, sizeof line, "%-16s %-6s %7td %7d %12.3f %14.5f %14.3f %14.3f %8d %12.3f %6d %12.3f\n",
+                      r.kernel.c_str(), r.dtype.c_str(), r.n, r.threads, r.gflops(), r.bytes_per_flop(),
+                      r.p50_s * 1e6, r.p99_s * 1e6, r.samples, r.mad_s * 1e6, r.rounds, r.round_mad_s * 1e6);
+        os << line;
+    }
+}
+
+void read_text(std::istream& is, Metadata& meta, std::vector<Result>& results) {
+    std::string line;
+    int version = 0;
+    bool header_seen = false;
+    for (int number = 1; std::getline(is, line); ++number) {
+        const auto fail = [&](const char* what) {
+            throw std::runtime_error("line " + std::to_string(number) + ": " + what + ": " + line);
+        };
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] == '#') {
+            if (line.rfind("# lana_bench report v", 0) == 0) {
+                version = std::atoi(line.c_str() + 21);
+                if (version < 1 || version > 2) {
+                    fail("unsupported report version");
+                }
+            } else if (const auto eq = line.find('='); eq != std::string::npos && line.size() > 2) {
+                meta.emplace_back(line.substr(2, eq - 2), line.substr(eq + 1));
+            }
+            continue;
+        }
+        if (version == 0) {
+            fail("missing '# lana_bench report' header");
+        }
+        if (line.rfind("kernel ", 0) == 0) {
+            if (header_seen) {
+                break;  // the lana::profile table appended by --profile
+            }
+            header_seen = true;
+            continue;
+        }
+        std::istringstream fields(line);
+        Result r;
+        double gflops = 0;
+        double bytes_per_flop = 0;
+        double p50_us = 0;
+        double p99_us = 0;
+        double mad_us = 0;
+        double round_mad_us = 0;
+        fields >> r.kernel >> r.dtype >> r.n >> r.threads >> gflops >> bytes_per_flop >> p50_us >> p99_us >> r.samples;
+        if (version >= 2) {
+            fields >> mad_us >> r.rounds >> round_mad_us;
+        }
+        if (!fields) {
+            fail("malformed result row");
+        }
+        r.p50_s = p50_us * 1e-6;
+        r.p99_s = p99_us * 1e-6;
+        r.mad_s = mad_us * 1e-6;
+        r.round_mad_s = round_mad_us * 1e-6;
+        r.mean_s = r.p50_s;
+        r.flops = gflops * 1e9 * r.p50_s;
+        r.bytes = bytes_per_flop * r.flops;
+        results.push_back(std::move(r));
+    }
+    if (version == 0) {
+        throw std::runtime_error("not a lana_bench text report");
+    }
+}
+
+void write_json(std::ostream& os, const Metadata& meta, std::vector<Result> results) {
+    sort_results(results);
+    os << "{\n  \"format\": \"lana_bench/2\",\n  \"meta\": {";
+    for (std::size_t i = 0; i < meta.size(); ++i) {
+        os << (i ? ", " : "") << '"' << json_escape(meta[i].first) << "\": \"" << json_escape(meta[i].second)
+           << '"';
+    }
+    os << "},\n  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"kernel\": \"" << json_escape(r.kernel) << "\", \"dtype\": \"" << r.dtype << "\", \"n\": " << r.n
+           << ", \"threads\": " << r.threads << ", \"gflops\": " << fmt("%.6g", r.gflops())
+           << ", \"bytes_per_flop\": " << fmt("%.6g", r.bytes_per_flop()) << ", \"p50_us\": "
+           << fmt("%.6g", r.p50_s * 1e6) << ", \"p99_us\": " << fmt("%.6g", r.p99_s * 1e6)
+           << ", \"min_us\": " << fmt("%.6g", r.min_s * 1e6) << ", \"mean_us\": " << fmt("%.6g", r.mean_s * 1e6)
+           << ", \"mad_us\": " << fmt("%.6g", r.mad_s * 1e6) << ", \"samples\": " << r.samples
+           << ", \"rounds\": " << r.rounds << ", \"round_mad_us\": " << fmt("%.6g", r.round_mad_s * 1e6) << "}"
+           << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    os << "  ]\n}\n";
+}
+
+std::vector<std::string> split_list(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            out.push_back(item);
+        }
+    }
+    return out;
+}
+
+}  // namespace lana::bench
@@ -0,0 +1,106 @@
+#pragma once
+
+// Benchmark harness shared by lana_bench (and any other sweep driver).
+//
+// A benchmark is a named kernel that, given a dtype and a problem size,
+// prepares a Workload: a callable plus its flop and compulsory-byte counts.
+// The harness times repeated calls, reduces the samples to latency
+// percentiles and throughput, and writes the stable text / JSON reports.
+
+#include "lana/config.hpp"
+
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+namespace lana::bench {
+
+struct Workload {
+    double flops = 0;
+    double bytes = 0;
+    std::function<void()> run;
+};
+
+using WorkloadFactory = std::function<Workload(const std::string& dtype, index_t n)>;
+
+struct Kernel {
+    std::string name;
+    std::vector<std::string> dtypes;
+    WorkloadFactory make;
+};
+
+/// Global kernel registry, populated by static Registrar objects.
+std::vector<Kernel>& registry();
+
+struct Registrar {
+    Registrar(std::string name, std::vector<std::string> dtypes, WorkloadFactory make);
+};
+
+/// Registers `name` for f32 and f64, built by the template factory<T>(n).
+/// Use at namespace scope inside lana::bench.
+#define LANA_BENCH_FLOAT_KERNEL(name, factory)                                                        \
+    const Registrar name##_registrar(#name, {"f32", "f64"}, [](const std::string& dtype, index_t n) { \
+        return dtype == "f32" ? factory<float>(n) : factory<double>(n);                               \
+    })
+
+struct TimingOptions {
+    double min_time_s = 0.2;  ///< keep sampling until this much time was spent
+    int min_samples = 5;
+    int max_samples = 2000;
+    int warmup = 1;
+};
+
+struct Result {
+    std::string kernel;
+    std::string dtype;
+    index_t n = 0;
+    int threads = 1;
+    double flops = 0;
+    double bytes = 0;
+    int samples = 0;
+    double p50_s = 0;
+    double p99_s = 0;
+    double min_s = 0;
+    double mean_s = 0;
+    /// Median absolute deviation of the samples from p50, a spread that
+    /// ignores the occasional preempted sample; 0 when not known.
+    double mad_s = 0;
+    /// Sweeps merged by combine_rounds, and the MAD of their p50s: the
+    /// run-to-run spread a single sweep cannot see.
+    int rounds = 1;
+    double round_mad_s = 0;
+
+    double gflops() const { return p50_s > 0 ? flops / p50_s * 1e-9 : 0; }
+    double bytes_per_flop() const { return flops > 0 ? bytes / flops : 0; }
+};
+
+/// Times `w.run` and reduces the samples; the workload fields are copied in.
+Result measure(const Workload& w, const TimingOptions& opt);
+
+/// One result from the same case measured in several sweeps: the lowest
+/// p50 and p99 of any round, the spread of all rounds' p50s and the summed
+/// sample count.
+Result combine_rounds(const std::vector<Result>& rounds);
+
+/// Percentile `q` in [0, 1] of `samples` (nearest-rank on a sorted copy).
+double percentile(std::vector<double> samples, double q);
+
+/// Key/value lines written at the top of both report formats.
+using Metadata = std::vector<std::pair<std::string, std::string>>;
+
+/// Fixed-column, sorted, timestamp-free report: diffs between runs show
+/// only the numbers that moved.
+void write_text(std::ostream& os, const Metadata& meta, std::vector<Result> results);
+void write_json(std::ostream& os, const Metadata& meta, std::vector<Result> results);
+
+/// Reads a text report back (v1 reports have no mad_us, rounds and
+/// round_mad_us columns; those fields and min_s keep their defaults).
+/// "# key=value" lines go to `meta`. Throws std::runtime_error naming the
+/// line it could not parse.
+void read_text(std::istream& is, Metadata& meta, std::vector<Result>& results);
+
+/// Splits "a,b,c"; empty input gives an empty list.
+std::vector<std::string> split_list(const std::string& s);
+
+}  // namespace lana::bench
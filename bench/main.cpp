@@ -0,0 +1,189 @@
+// lana_bench: sweeps every registered kernel over dtypes and sizes and writes
+// bench_output.txt (fixed-column text) and bench_output.json.
+
+#include "harness.hpp"
+
+#include <lana/cpu.hpp>
+#include <lana/profile.hpp>
+#include <lana/thread_pool.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+namespace {
+
+struct Options {
+    std::vector<std::string> kernels;
+    std::vector<std::string> dtypes;
+    std::vector<lana::index_t> sizes{256, 512, 1024, 2048};
+    std::vector<int> threads;  // empty: 1 and the default pool size
+    lana::bench::TimingOptions timing;
+    int rounds = 1;
+    std::string out = "bench_output.txt";
+    std::string json = "bench_output.json";
+    bool list = false;
+    bool profile = false;
+};
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: lana_bench [options]\n"
+                 "  --kernels a,b     kernels to run (default: all, see --list)\n"
+                 "  --dtypes f32,f64  element types (default: all a kernel supports)\n"
+                 "  --sizes n1,n2     problem sizes (default: 256,512,1024,2048)\n"
+                 "  --threads t1,t2   thread counts (default: 1 and the default pool size)\n"
+                 "  --min-time s      minimum sampling time per case (default: 0.2)\n"
+                 "  --quick           sizes 64,128,256 and 0.05 s per case\n"
+                 "  --rounds r        repeat the sweep r times, report each case's fastest round (default: 1)\n"
+                 "  --out path        text report (default: bench_output.txt)\n"
+                 "  --json path       JSON report, empty to skip (default: bench_output.json)\n"
+                 "  --profile         count kernel calls and append lana::profile totals to the text report\n"
+                 "  --list            list kernels and exit\n");
+}
+
+bool parse(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "lana_bench: %s needs a value\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--kernels") {
+            opt.kernels = lana::bench::split_list(value());
+        } else if (arg == "--dtypes") {
+            opt.dtypes = lana::bench::split_list(value());
+        } else if (arg == "--sizes") {
+            opt.sizes.clear();
+            for (const auto& s : lana::bench::split_list(value())) {
+                opt.sizes.push_back(std::atol(s.c_str()));
+            }
+        } else if (arg == "--threads") {
+            opt.threads.clear();
+            for (const auto& s : lana::bench::split_list(value())) {
+                opt.threads.push_back(std::max(1, std::atoi(s.c_str())));
+            }
+        } else if (arg == "--min-time") {
+            opt.timing.min_time_s = std::atof(value().c_str());
+        } else if (arg == "--quick") {
+            opt.sizes = {64, 128, 256};
+            opt.timing.min_time_s = 0.05;
+        } else if (arg == "--rounds") {
+            opt.rounds = std::max(1, std::atoi(value().c_str()));
+        } else if (arg == "--out") {
+            opt.out = value();
+        } else if (arg == "--json") {
+            opt.json = value();
+        } else if (arg == "--profile") {
+            opt.profile = true;
+        } else if (arg == "--list") {
+            opt.list = true;
+        } else {
+            usage();
+            return false;
+        }
+    }
+    return true;
+}
+
+bool selected(const std::vector<std::string>& filter, const std::string& name) {
+    return filter.empty() || std::find(filter.begin(), filter.end(), name) != filter.end();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        return 2;
+    }
+    auto& kernels = lana::bench::registry();
+    std::sort(kernels.begin(), kernels.end(), [](const auto& a, const auto& b) { return a.name < b.name; });
+    if (opt.list) {
+        for (const auto& k : kernels) {
+            std::printf("%s\n", k.name.c_str());
+        }
+        return 0;
+    }
+
+    if (opt.threads.empty()) {
+        opt.threads.push_back(1);
+        if (const int pool = lana::num_threads(); pool > 1) {
+            opt.threads.push_back(pool);
+        }
+    }
+
+    if (opt.profile) {
+        lana::profile::reset();
+        lana::profile::set_enabled(true);
+    }
+    std::vector<lana::bench::Result> results;
+    // Thread count is the outer loop: changing it rebuilds the pool. Rounds
+    // go inside it, each a full sweep, so that a slow stretch of the machine
+    // lands on one round of many cases rather than on every round of one.
+    for (int threads : opt.threads) {
+        lana::set_num_threads(threads);
+        std::vector<std::vector<lana::bench::Result>> cases;
+        for (int round = 0; round < opt.rounds; ++round) {
+            std::size_t index = 0;
+            for (const auto& k : kernels) {
+                if (!selected(opt.kernels, k.name)) {
+                    continue;
+                }
+                for (const auto& dtype : k.dtypes) {
+                    if (!selected(opt.dtypes, dtype)) {
+                        continue;
+                    }
+                    for (lana::index_t n : opt.sizes) {
+                        const lana::bench::Workload w = k.make(dtype, n);
+                        lana::bench::Result r = lana::bench::measure(w, opt.timing);
+                        r.kernel = k.name;
+                        r.dtype = dtype;
+                        r.n = n;
+                        r.threads = threads;
+                        std::fprintf(stderr, "%-16s %-4s n=%-6td t=%-3d %10.3f GFLOP/s  p50 %.1f us\n",
+                                     k.name.c_str(), dtype.c_str(), n, threads, r.gflops(), r.p50_s * 1e6);
+                        if (round == 0) {
+                            cases.emplace_back();
+                        }
+                        cases[index++].push_back(std::move(r));
+                    }
+                }
+            }
+        }
+        for (const auto& rounds : cases) {
+            results.push_back(lana::bench::combine_rounds(rounds));
+        }
+    }
+    lana::set_num_threads(0);
+    if (opt.profile) {
+        lana::profile::set_enabled(false);
+    }
+
+    const lana::bench::Metadata meta{
+        {"lana_version", std::to_string(LANA_VERSION_MAJOR) + "." + std::to_string(LANA_VERSION_MINOR) + "." +
+                             std::to_string(LANA_VERSION_PATCH)},
+        {"isa", lana::isa_name(lana::active_isa())},
+    };
+    std::ofstream out(opt.out);
+    if (!out) {
+        std::fprintf(stderr, "lana_bench: cannot write %s\n", opt.out.c_str());
+        return 1;
+    }
+    lana::bench::write_text(out, meta, results);
+    if (opt.profile) {
+        // Includes warm-up and timing repetitions of every case.
+        out << "\n";
+        lana::profile::write_report(out, lana::profile::snapshot());
+    }
+    if (!opt.json.empty()) {
+        std::ofstream json(opt.json);
+        lana::bench::write_json(json, meta, results);
+    }
+    return 0;
+}
@@ -0,0 +1,248 @@
+// lana_tune: searches GEMM blocking (MC/KC/NC), micro-kernel tile and the
+// parallel split on this host and saves the winner to the tuning file the
+// library reads at startup.
+//
+// The search is coordinate descent from the host-derived defaults: for
+// every tile the ISA offers, KC, then MC, then NC; finally n_split. Each
+// candidate is scored by the geometric mean GFLOP/s of the `gemm`
+// benchmark over the tuning sizes, timed with the lana_bench harness.
+
+#include "harness.hpp"
+
+#include <lana/cpu.hpp>
+#include <lana/error.hpp>
+#include <lana/gemm.hpp>
+#include <lana/thread_pool.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+using lana::GemmBlocking;
+using lana::index_t;
+
+struct Options {
+    std::vector<std::string> dtypes{"f32", "f64"};
+    std::vector<index_t> sizes{512, 1024, 2048};
+    int threads = 0;  // 0: the default pool size
+    lana::bench::TimingOptions timing{0.1, 3, 200, 1};
+    std::string out;  // empty: lana::gemm_tuning_path()
+    bool dry_run = false;
+};
+
+/// Candidates must beat the incumbent by this much, so timing noise alone
+/// does not move the result away from the defaults.
+constexpr double min_gain = 0.01;
+
+void usage() {
+    std::fprintf(stderr,
+                 "usage: lana_tune [options]\n"
+                 "  --dtypes f32,f64  element types to tune (default: both)\n"
+                 "  --sizes n1,n2     square GEMM sizes scored (default: 512,1024,2048)\n"
+                 "  --threads t       pool size to tune for (default: the default pool size)\n"
+                 "  --min-time s      minimum sampling time per candidate and size (default: 0.1)\n"
+                 "  --quick           sizes 256,512 and 0.03 s per candidate\n"
+                 "  --out path        tuning file (default: LANA_TUNE_FILE or ~/.cache/lana/gemm_tuning.txt)\n"
+                 "  --dry-run         search and report, but do not write the file\n");
+}
+
+bool parse(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&]() -> std::string {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "lana_tune: %s needs a value\n", arg.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (arg == "--dtypes") {
+            opt.dtypes = lana::bench::split_list(value());
+        } else if (arg == "--sizes") {
+            opt.sizes.clear();
+            for (const auto& s : lana::bench::split_list(value())) {
+                opt.sizes.push_back(std::atol(s.c_str()));
+            }
+        } else if (arg == "--threads") {
+            opt.threads = std::max(1, std::atoi(value().c_str()));
+        } else if (arg == "--min-time") {
+            opt.timing.min_time_s = std::atof(value().c_str());
+        } else if (arg == "--quick") {
+            opt.sizes = {256, 512};
+            opt.timing.min_time_s = 0.03;
+        } else if (arg == "--out") {
+            opt.out = value();
+        } else if (arg == "--dry-run") {
+            opt.dry_run = true;
+        } else {
+            usage();
+            return false;
+        }
+    }
+    return !opt.sizes.empty();
+}
+
+std::vector<index_t> scaled(index_t base, std::initializer_list<double> factors) {
+    std::vector<index_t> out;
+    for (double f : factors) {
+        const auto v = static_cast<index_t>(std::lround(static_cast<double>(base) * f));
+        if (v > 0 && std::find(out.begin(), out.end(), v) == out.end()) {
+            out.push_back(v);
+        }
+    }
+    return out;
+}
+
+class Tuner {
+public:
+    Tuner(const std::string& dtype, const Options& opt) : f64_(dtype == "f64"), opt_(opt) {
+        const lana::bench::Kernel* gemm = nullptr;
+        for (const auto& k : lana::bench::registry()) {
+            if (k.name == "gemm") {
+                gemm = &k;
+            }
+        }
+        if (gemm == nullptr) {
+            throw lana::Error("lana_tune: gemm benchmark not registered");
+        }
+        for (index_t n : opt.sizes) {
+            workloads_.push_back(gemm->make(dtype, n));
+        }
+    }
+
+    /// Runs the search and leaves the best blocking set; returns the
+    /// default and best scores.
+    std::pair<double, double> run() {
+        set({});
+        const double base = score();
+        best_ = current();
+        best_score_ = base;
+        report("default", best_, base);
+
+        const std::vector<lana::GemmTile> tiles = f64_ ? lana::gemm_tiles_f64() : lana::gemm_tiles_f32();
+        for (const lana::GemmTile& tile : tiles) {
+            GemmBlocking b;
+            b.mr = tile.mr;
+            b.nr = tile.nr;
+            b.n_split = best_.n_split;
+            // KC with MC and NC derived from it, then MC and NC around the
+            // values derived for the best KC.
+            GemmBlocking tile_best = b;
+            double tile_score = 0;
+            for (index_t kc : {128, 192, 256, 320, 384, 512, 768}) {
+                GemmBlocking c = b;
+                c.kc = kc;
+                consider(c, tile_best, tile_score);
+            }
+            set(tile_best);
+            const GemmBlocking derived = current();
+            for (index_t mc : scaled(derived.mc, {0.5, 0.75, 1.5, 2.0})) {
+                GemmBlocking c = tile_best;
+                c.mc = mc;
+                consider(c, tile_best, tile_score);
+            }
+            for (index_t nc : scaled(derived.nc, {0.25, 0.5, 2.0})) {
+                GemmBlocking c = tile_best;
+                c.nc = nc;
+                consider(c, tile_best, tile_score);
+            }
+            if (tile_score > best_score_ * (1 + min_gain)) {
+                set(tile_best);
+                best_ = current();
+                best_score_ = tile_score;
+            }
+        }
+
+        if (lana::num_threads() > 1) {
+            for (int split = 2; split <= lana::num_threads(); split *= 2) {
+                GemmBlocking c = best_;
+                c.n_split = split;
+                consider(c, best_, best_score_);
+            }
+        }
+        set(best_);
+        best_ = current();
+        report("best", best_, best_score_);
+        return {base, best_score_};
+    }
+
+private:
+    void set(const GemmBlocking& b) const {
+        if (f64_) {
+            lana::set_gemm_blocking_f64(b);
+        } else {
+            lana::set_gemm_blocking_f32(b);
+        }
+    }
+
+    GemmBlocking current() const { return f64_ ? lana::gemm_blocking_f64() : lana::gemm_blocking_f32(); }
+
+    /// Geometric mean GFLOP/s of the tuning sizes under the current blocking.
+    double score() const {
+        double log_sum = 0;
+        for (const lana::bench::Workload& w : workloads_) {
+            log_sum += std::log(std::max(1e-9, lana::bench::measure(w, opt_.timing).gflops()));
+        }
+        return std::exp(log_sum / static_cast<double>(workloads_.size()));
+    }
+
+    void consider(const GemmBlocking& cand, GemmBlocking& best, double& best_score) const {
+        set(cand);
+        const double s = score();
+        report("try", current(), s);
+        if (s > best_score * (1 + min_gain)) {
+            best = cand;
+            best_score = s;
+        }
+    }
+
+    void report(const char* what, const GemmBlocking& b, double gflops) const {
+        std::fprintf(stderr, "%s %-7s mc=%-5td kc=%-4td nc=%-5td tile=%tdx%-3td n_split=%d  %8.2f GFLOP/s\n",
+                     f64_ ? "f64" : "f32", what, b.mc, b.kc, b.nc, b.mr, b.nr, b.n_split, gflops);
+    }
+
+    bool f64_;
+    const Options& opt_;
+    std::vector<lana::bench::Workload> workloads_;
+    GemmBlocking best_;
+    double best_score_ = 0;
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parse(argc, argv, opt)) {
+        return 2;
+    }
+    if (opt.threads > 0) {
+        lana::set_num_threads(opt.threads);
+    }
+    std::printf("host %s, %d threads\n", lana::gemm_tuning_host().c_str(), lana::num_threads());
+    for (const std::string& dtype : opt.dtypes) {
+        if (dtype != "f32" && dtype != "f64") {
+            std::fprintf(stderr, "lana_tune: unknown dtype %s\n", dtype.c_str());
+            return 2;
+        }
+        const auto [base, best] = Tuner(dtype, opt).run();
+        const GemmBlocking b = dtype == "f64" ? lana::gemm_blocking_f64() : lana::gemm_blocking_f32();
+        std::printf("%s  %8.2f -> %8.2f GFLOP/s (%+.1f%%)  mc=%td kc=%td nc=%td tile=%tdx%td n_split=%d\n",
+                    dtype.c_str(), base, best, (best / base - 1) * 100, b.mc, b.kc, b.nc, b.mr, b.nr, b.n_split);
+    }
+    if (opt.dry_run) {
+        return 0;
+    }
+    try {
+        lana::save_gemm_tuning(opt.out);
+    } catch (const lana::IoError& e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::printf("wrote %s\n", (opt.out.empty() ? lana::gemm_tuning_path() : opt.out).c_str());
+    return 0;
+}
@@ -0,0 +1,91 @@
+# Script behind the `gate` target (see bench/CMakeLists.txt): correctness
+# first, then performance.
+#
+#   CTEST, BUILD_DIR   ctest and the build tree whose tests to run
+#   BENCH, GATE        the lana_bench and lana_gate executables
+#   BASELINE           baseline report to compare against
+#   OUTPUT_DIR         where test_output.txt and bench_output.{txt,json} go
+#   BENCH_ARGS         lana_bench arguments, space separated
+#   GATE_ARGS          extra lana_gate arguments, space separated
+#   RETRIES            re-measurements of failing kernels before failing
+
+cmake_minimum_required(VERSION 3.16)
+
+foreach(_var CTEST BUILD_DIR BENCH GATE BASELINE OUTPUT_DIR)
+  if(NOT DEFINED ${_var})
+    message(FATAL_ERROR "gate.cmake: ${_var} is not set")
+  endif()
+endforeach()
+separate_arguments(_bench_args UNIX_COMMAND "${BENCH_ARGS}")
+separate_arguments(_gate_args UNIX_COMMAND "${GATE_ARGS}")
+if(NOT DEFINED RETRIES)
+  set(RETRIES 0)
+endif()
+
+message(STATUS "gate: tests -> ${OUTPUT_DIR}/test_output.txt")
+execute_process(
+  COMMAND ${CTEST} --test-dir ${BUILD_DIR} --output-on-failure --no-tests=error
+  OUTPUT_FILE ${OUTPUT_DIR}/test_output.txt
+  ERROR_FILE ${OUTPUT_DIR}/test_output.txt
+  RESULT_VARIABLE _result)
+if(NOT _result EQUAL 0)
+  message(FATAL_ERROR "gate: tests failed (${_result}), see ${OUTPUT_DIR}/test_output.txt")
+endif()
+# The exit status alone has passed a tree with no tests registered, so the
+# summary must also show that some ran and none failed.
+file(READ ${OUTPUT_DIR}/test_output.txt _tests)
+if(NOT _tests MATCHES "100% tests passed, 0 tests failed out of [1-9][0-9]*")
+  message(FATAL_ERROR "gate: no passing test run recorded, see ${OUTPUT_DIR}/test_output.txt")
+endif()
+
+message(STATUS "gate: lana_bench ${BENCH_ARGS} -> ${OUTPUT_DIR}/bench_output.txt")
+execute_process(
+  COMMAND ${BENCH} ${_bench_args} --out ${OUTPUT_DIR}/bench_output.txt --json ${OUTPUT_DIR}/bench_output.json
+  OUTPUT_QUIET
+  ERROR_QUIET
+  RESULT_VARIABLE _result)
+if(NOT _result EQUAL 0)
+  message(FATAL_ERROR "gate: lana_bench failed (${_result})")
+endif()
+
+if(NOT EXISTS ${BASELINE})
+  message(FATAL_ERROR "gate: no baseline at ${BASELINE}; record one with\n"
+    "  ${GATE} --write-baseline ${BASELINE} ${OUTPUT_DIR}/bench_output.txt")
+endif()
+
+# A slow stretch of a shared machine can outlast a whole sweep, so a
+# regression has to survive RETRIES re-measurements of the kernels it was
+# found in; lana_gate keeps every case's fastest measurement.
+set(_reports ${OUTPUT_DIR}/bench_output.txt)
+set(_attempt 0)
+while(TRUE)
+  execute_process(
+    COMMAND ${GATE} ${_gate_args} --out ${BUILD_DIR}/gate_output.txt --failed ${BUILD_DIR}/gate_failed.txt
+      ${BASELINE} ${_reports}
+    RESULT_VARIABLE _result)
+  if(NOT _result EQUAL 1 OR _attempt EQUAL RETRIES)
+    break()
+  endif()
+  math(EXPR _attempt "${_attempt} + 1")
+  file(READ ${BUILD_DIR}/gate_failed.txt _failed)
+  if(_failed STREQUAL "")
+    break()  # only missing cases; measuring again will not bring them back
+  endif()
+  message(STATUS "gate: measuring ${_failed} again (${_attempt}/${RETRIES})")
+  set(_retry ${BUILD_DIR}/gate_retry${_attempt}.txt)
+  execute_process(
+    COMMAND ${BENCH} ${_bench_args} --kernels ${_failed} --out ${_retry} --json ""
+    OUTPUT_QUIET
+    ERROR_QUIET
+    RESULT_VARIABLE _bench_result)
+  if(NOT _bench_result EQUAL 0)
+    message(FATAL_ERROR "gate: lana_bench failed (${_bench_result})")
+  endif()
+  list(APPEND _reports ${_retry})
+endwhile()
+
+if(_result EQUAL 1)
+  message(FATAL_ERROR "gate: performance regression against ${BASELINE}, see ${BUILD_DIR}/gate_output.txt")
+elseif(NOT _result EQUAL 0)
+  message(FATAL_ERROR "gate: lana_gate failed (${_result})")
+endif()
@@ -0,0 +1,28 @@
+# Test behind static_init (see tests/CMakeLists.txt): fails if LIBRARY has a
+# dynamic initializer, which lana/warmup.hpp promises it does not.
+#
+#   NM        nm from the toolchain
+#   LIBRARY   the lana library to inspect
+
+cmake_minimum_required(VERSION 3.16)
+
+foreach(_var NM LIBRARY)
+  if(NOT DEFINED ${_var})
+    message(FATAL_ERROR "static_init.cmake: ${_var} is not set")
+  endif()
+endforeach()
+
+execute_process(
+  COMMAND ${NM} ${LIBRARY}
+  OUTPUT_VARIABLE _symbols
+  RESULT_VARIABLE _result)
+if(NOT _result EQUAL 0)
+  message(FATAL_ERROR "static_init: ${NM} ${LIBRARY} failed (${_result})")
+endif()
+# GCC and Clang name a translation unit's initializer _GLOBAL__sub_I_<file>.
+string(REGEX MATCHALL "_GLOBAL__sub_I_[A-Za-z0-9_.]+" _inits "${_symbols}")
+if(_inits)
+  list(REMOVE_DUPLICATES _inits)
+  string(REPLACE ";" "\n  " _inits "${_inits}")
+  message(FATAL_ERROR "static_init: ${LIBRARY} runs code at load:\n  ${_inits}")
+endif()
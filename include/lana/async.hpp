@@ -0,0 +1,330 @@
+#pragma once
+
+/// Non-blocking lana calls.
+///
+/// Every function in lana::async starts the matching lana call on lana's
+/// executor and returns a Future at once. A Future can be waited on, or
+/// awaited from a C++20 coroutine, and can gate later operations without
+/// the caller waiting in between:
+///
+///     auto lu = async::getrf(a, ipiv);                       // starts now
+///     auto x  = async::getrs(async::after(lu), Op::NoTrans, a, ipiv, b);
+///     auto r  = async::gemm(async::after(x), -1.0, a0, b, 1.0, r0);
+///     co_await r;                                            // or r.wait()
+///
+/// An operation runs once every future it comes after has completed; if
+/// one of them failed, it does not run and completes with that exception.
+///
+/// Arguments are captured when the call is made: views, scalars, pointers
+/// and options by value, owning objects (Matrix, Csc, ...) by reference.
+/// Whatever the arguments refer to must stay alive, and must not be written
+/// by anything else, until the future completes.
+///
+/// Coroutines resume on the thread that completed the awaited operation,
+/// usually a lana worker; hop back to your own loop before doing I/O there.
+/// Operations must not block on another Future (use after() or co_await).
+/// On an executor with no threads besides the caller, an operation runs
+/// inline in the call that makes it ready.
+
+#include "lana/blas1.hpp"
+#include "lana/config.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/sparse.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lana::async {
+
+template <typename T = void>
+class Future;
+class After;
+
+namespace detail {
+
+/// Completion state shared by a Future's copies and the operation.
+class LANA_API StateBase {
+public:
+    virtual ~StateBase();
+
+    bool ready() const noexcept { return done_.load(std::memory_order_acquire); }
+    void wait() const;
+
+    /// Queues k to run (on the completing thread) once complete and returns
+    /// true, or returns false without calling k if already complete.
+    bool subscribe(std::function<void()> k);
+
+    /// Marks the state complete and runs the queued continuations.
+    void finish(std::exception_ptr error) noexcept;
+
+    /// Valid once ready().
+    const std::exception_ptr& error() const noexcept { return error_; }
+
+private:
+    std::atomic<bool> done_{false};
+    mutable std::mutex mutex_;
+    mutable std::condition_variable cv_;
+    std::exception_ptr error_;
+    std::vector<std::function<void()>> continuations_;
+};
+
+template <typename T>
+class State final : public StateBase {
+public:
+    std::optional<T> value;
+};
+
+template <>
+class State<void> final : public StateBase {};
+
+using StateList = std::vector<std::shared_ptr<StateBase>>;
+
+/// Calls k(first error or null) once every state in `deps` is complete: on
+/// lana's executor when `post` is set, else on the thread completing the
+/// last one (or right here if they all are).
+LANA_API void when_complete(StateList deps, std::function<void(std::exception_ptr)> k, bool post);
+
+template <typename T>
+void store_result(State<T>& st, auto& fn) {
+    if constexpr (std::is_void_v<T>) {
+        fn();
+    } else {
+        st.value.emplace(fn());
+    }
+}
+
+template <typename T>
+struct PromiseBase {
+    std::shared_ptr<State<T>> state = std::make_shared<State<T>>();
+
+    Future<T> get_return_object();
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void unhandled_exception() noexcept { state->finish(std::current_exception()); }
+};
+
+template <typename T>
+struct Promise : PromiseBase<T> {
+    template <typename U>
+    void return_value(U&& v) {
+        this->state->value.emplace(std::forward<U>(v));
+        this->state->finish(nullptr);
+    }
+};
+
+template <>
+struct Promise<void> : PromiseBase<void> {
+    void return_void() { this->state->finish(nullptr); }
+};
+
+/// Reaches the state behind After and Future.
+struct Access {
+    template <typename T>
+    static Future<T> make(std::shared_ptr<State<T>> s) noexcept;
+    template <typename T>
+    static const std::shared_ptr<State<T>>& state(const Future<T>& f) noexcept;
+    static StateList& states(After& a) noexcept;
+};
+
+}  // namespace detail
+
+/// The operations a later call waits for; built by after().
+class After {
+public:
+    After() = default;
+
+private:
+    friend struct detail::Access;
+
+    detail::StateList states_;
+};
+
+/// Result of an asynchronous operation. Copies share one state.
+///
+/// A Future is also a coroutine return type: a coroutine declared to
+/// return Future<T> starts running right away, and its future completes
+/// with the value it co_returns (or the exception that escapes it).
+template <typename T>
+class Future {
+public:
+    using promise_type = detail::Promise<T>;
+
+    Future() = default;
+
+    bool valid() const noexcept { return state_ != nullptr; }
+    bool ready() const noexcept { return state_->ready(); }
+    void wait() const { state_->wait(); }
+
+    /// Waits, then returns the result or rethrows the operation's exception.
+    T get() const {
+        state_->wait();
+        if (state_->error()) {
+            std::rethrow_exception(state_->error());
+        }
+        if constexpr (!std::is_void_v<T>) {
+            return *state_->value;
+        }
+    }
+
+    bool await_ready() const noexcept { return state_->ready(); }
+    bool await_suspend(std::coroutine_handle<> h) const {
+        return state_->subscribe([h] { h.resume(); });
+    }
+    T await_resume() const { return get(); }
+
+private:
+    friend struct detail::Access;
+
+    explicit Future(std::shared_ptr<detail::State<T>> s) noexcept : state_(std::move(s)) {}
+
+    std::shared_ptr<detail::State<T>> state_;
+};
+
+namespace detail {
+
+template <typename T>
+Future<T> Access::make(std::shared_ptr<State<T>> s) noexcept {
+    return Future<T>(std::move(s));
+}
+template <typename T>
+const std::shared_ptr<State<T>>& Access::state(const Future<T>& f) noexcept {
+    return f.state_;
+}
+inline StateList& Access::states(After& a) noexcept { return a.states_; }
+
+template <typename T>
+Future<T> PromiseBase<T>::get_return_object() {
+    return Access::make(state);
+}
+
+}  // namespace detail
+
+/// Dependencies for a later call: it starts once all of `fs` have completed.
+template <typename... Ts>
+After after(const Future<Ts>&... fs) {
+    After deps;
+    (detail::Access::states(deps).push_back(detail::Access::state(fs)), ...);
+    return deps;
+}
+
+/// Runs fn() on lana's executor once `deps` have completed, or on the
+/// thread that completed the last of them if the executor throws instead
+/// of taking the job.
+template <typename F>
+auto submit(After deps, F fn) -> Future<std::invoke_result_t<F&>> {
+    using R = std::invoke_result_t<F&>;
+    auto st = std::make_shared<detail::State<R>>();
+    detail::when_complete(
+        std::move(detail::Access::states(deps)),
+        [st, fn = std::move(fn)](std::exception_ptr dep_error) mutable {
+            if (dep_error) {
+                st->finish(dep_error);
+                return;
+            }
+            try {
+                detail::store_result(*st, fn);
+            } catch (...) {
+                st->finish(std::current_exception());
+                return;
+            }
+            st->finish(nullptr);
+        },
+        true);
+    return detail::Access::make(std::move(st));
+}
+
+template <typename F>
+auto submit(F fn) -> Future<std::invoke_result_t<F&>> {
+    return submit(After{}, std::move(fn));
+}
+
+/// Completes when all of `deps` have, without running anything itself.
+inline Future<void> when_all(After deps) {
+    auto st = std::make_shared<detail::State<void>>();
+    detail::when_complete(
+        std::move(detail::Access::states(deps)), [st](std::exception_ptr error) { st->finish(error); }, false);
+    return detail::Access::make(std::move(st));
+}
+
+template <typename... Ts>
+Future<void> when_all(const Future<Ts>&... fs) {
+    return when_all(after(fs...));
+}
+
+namespace detail {
+
+/// Trivially copyable arguments (views, scalars, pointers, options) are
+/// copied; anything else is referenced.
+template <typename A>
+auto capture(A& a) {
+    if constexpr (std::is_trivially_copyable_v<std::remove_const_t<A>>) {
+        return std::remove_const_t<A>(a);
+    } else {
+        return std::ref(a);
+    }
+}
+
+template <typename A>
+A& unwrap(A& a) noexcept {
+    return a;
+}
+template <typename A>
+A& unwrap(std::reference_wrapper<A> a) noexcept {
+    return a.get();
+}
+
+template <typename F, typename... Args>
+auto launch(After deps, F f, Args&&... args) {
+    static_assert(((std::is_lvalue_reference_v<Args> || std::is_trivially_copyable_v<std::decay_t<Args>>) && ...),
+                  "lana::async: owning arguments must be lvalues that outlive the future");
+    return submit(std::move(deps),
+                  [f, ... cap = capture(args)]() mutable -> decltype(auto) { return f(unwrap(cap)...); });
+}
+
+}  // namespace detail
+
+// async::name(args...) and async::name(after(...), args...) for the lana
+// call of the same name.
+#define LANA_ASYNC_OP(name)                                                                             \
+    template <typename... Args>                                                                          \
+    auto name(Args&&... args)->Future<decltype(::lana::name(std::forward<Args>(args)...))> {             \
+        return detail::launch(                                                                           \
+            After{}, [](auto&... a) -> decltype(auto) { return ::lana::name(a...); },                    \
+            std::forward<Args>(args)...);                                                                \
+    }                                                                                                    \
+    template <typename... Args>                                                                          \
+    auto name(After deps, Args&&... args)->Future<decltype(::lana::name(std::forward<Args>(args)...))> { \
+        return detail::launch(                                                                           \
+            std::move(deps), [](auto&... a) -> decltype(auto) { return ::lana::name(a...); },            \
+            std::forward<Args>(args)...);                                                                \
+    }
+
+LANA_ASYNC_OP(gemm)
+LANA_ASYNC_OP(trsm)
+LANA_ASYNC_OP(getrf)
+LANA_ASYNC_OP(getrs)
+LANA_ASYNC_OP(potrf)
+LANA_ASYNC_OP(potrs)
+LANA_ASYNC_OP(geqrf)
+LANA_ASYNC_OP(ormqr)
+LANA_ASYNC_OP(gesv_refine)
+LANA_ASYNC_OP(posv_refine)
+LANA_ASYNC_OP(spmv)
+LANA_ASYNC_OP(spmm)
+LANA_ASYNC_OP(dot)
+LANA_ASYNC_OP(axpy)
+LANA_ASYNC_OP(nrm2)
+
+#undef LANA_ASYNC_OP
+
+}  // namespace lana::async
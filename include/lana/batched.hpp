@@ -0,0 +1,273 @@
+#pragma once
+
+/// Batched kernels for many small matrices.
+///
+/// A batch is `count` matrices of one shape, described by one of:
+///
+/// - `StridedBatch`: column-major matrices `stride` elements apart;
+/// - `PointerBatch`: column-major matrices at arbitrary addresses;
+/// - `InterleavedView` / `InterleavedBatch`: element (i, j) of each group
+///   of consecutive matrices stored side by side, so one SIMD register holds
+///   that element for a whole run of matrices.
+///
+/// Strided and pointer batches run one matrix at a time on kernels built
+/// for common sizes at compile time (2 to 8, 12, 16, 32), so loops unroll
+/// and there is no blocking or packing overhead. Interleaved batches run
+/// the same arithmetic across lanes of the dispatched SIMD width, which is
+/// the fastest layout whenever the batch can be kept in it. Every entry
+/// point splits the batch across the thread pool.
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+
+namespace lana::batched {
+
+/// `count` column-major rows x cols matrices with leading dimension `ld`;
+/// matrix b starts at `data() + b * stride()`.
+template <typename T>
+class StridedBatch {
+public:
+    StridedBatch() = default;
+    StridedBatch(T* data, index_t rows, index_t cols, index_t ld, index_t stride, index_t count) noexcept
+        : data_(data), rows_(rows), cols_(cols), ld_(ld), stride_(stride), count_(count) {}
+
+    /// Tightly packed: ld = rows and stride = rows * cols.
+    StridedBatch(T* data, index_t rows, index_t cols, index_t count) noexcept
+        : StridedBatch(data, rows, cols, rows, rows * cols, count) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    StridedBatch(const StridedBatch<U>& other) noexcept  // NOLINT(google-explicit-constructor)
+        : StridedBatch(other.data(), other.rows(), other.cols(), other.ld(), other.stride(), other.count()) {}
+
+    T* data() const noexcept { return data_; }
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t ld() const noexcept { return ld_; }
+    index_t stride() const noexcept { return stride_; }
+    index_t count() const noexcept { return count_; }
+
+    T* ptr(index_t b) const noexcept { return data_ + b * stride_; }
+    MatrixView<T> operator[](index_t b) const noexcept { return MatrixView<T>(ptr(b), rows_, cols_, ld_); }
+
+private:
+    T* data_ = nullptr;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t ld_ = 0;
+    index_t stride_ = 0;
+    index_t count_ = 0;
+};
+
+/// `count` column-major rows x cols matrices with leading dimension `ld`;
+/// matrix b starts at `ptrs()[b]`. The pointer array must outlive the batch.
+template <typename T>
+class PointerBatch {
+public:
+    PointerBatch() = default;
+    PointerBatch(T* const* ptrs, index_t rows, index_t cols, index_t ld, index_t count) noexcept
+        : ptrs_(ptrs), rows_(rows), cols_(cols), ld_(ld), count_(count) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    PointerBatch(const PointerBatch<U>& other) noexcept  // NOLINT(google-explicit-constructor)
+        : PointerBatch(other.ptrs(), other.rows(), other.cols(), other.ld(), other.count()) {}
+
+    T* const* ptrs() const noexcept { return ptrs_; }
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t ld() const noexcept { return ld_; }
+    index_t count() const noexcept { return count_; }
+
+    T* ptr(index_t b) const noexcept { return ptrs_[b]; }
+    MatrixView<T> operator[](index_t b) const noexcept { return MatrixView<T>(ptr(b), rows_, cols_, ld_); }
+
+private:
+    T* const* ptrs_ = nullptr;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t ld_ = 0;
+    index_t count_ = 0;
+};
+
+/// Matrices per group of an interleaved batch: one 64-byte line of T.
+template <typename T>
+inline constexpr index_t interleave_width = index_t(64 / sizeof(std::remove_const_t<T>));
+
+/// Interleaved batch. Matrices are stored in groups of G =
+/// interleave_width<T>; within a group, element (i, j) of the G matrices
+/// occupies G consecutive slots, so element (i, j) of matrix b lives at
+///
+///     data()[((b / G) * rows() * cols() + i + j * rows()) * G + b % G].
+///
+/// Each group is a contiguous rows * cols * 64-byte block. Storage covers
+/// whole groups (groups() * G matrices); the padding matrices past count()
+/// are computed on like the others but never reported.
+template <typename T>
+class InterleavedView {
+public:
+    using value_type = std::remove_const_t<T>;
+    static constexpr index_t group = interleave_width<T>;
+
+    InterleavedView() = default;
+    InterleavedView(T* data, index_t rows, index_t cols, index_t count) noexcept
+        : data_(data), rows_(rows), cols_(cols), count_(count) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    InterleavedView(const InterleavedView<U>& other) noexcept  // NOLINT(google-explicit-constructor)
+        : InterleavedView(other.data(), other.rows(), other.cols(), other.count()) {}
+
+    T* data() const noexcept { return data_; }
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t count() const noexcept { return count_; }
+    index_t groups() const noexcept { return (count_ + group - 1) / group; }
+    /// Elements of storage, padding included.
+    index_t size() const noexcept { return groups() * rows_ * cols_ * group; }
+
+    T& operator()(index_t b, index_t i, index_t j) const noexcept {
+        return data_[((b / group) * rows_ * cols_ + i + j * rows_) * group + b % group];
+    }
+
+    /// Matrix b as a strided view.
+    MatrixView<T> operator[](index_t b) const noexcept {
+        return MatrixView<T>(&(*this)(b, 0, 0), rows_, cols_, group, rows_ * group);
+    }
+
+private:
+    T* data_ = nullptr;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t count_ = 0;
+};
+
+/// Owning interleaved batch, zero-initialized, 64-byte aligned.
+template <typename T>
+class InterleavedBatch {
+    static_assert(std::is_trivially_copyable_v<T>,
+                  "lana::batched::InterleavedBatch requires a trivially copyable element type");
+
+public:
+    InterleavedBatch() = default;
+    InterleavedBatch(index_t rows, index_t cols, index_t count)
+        : buf_(static_cast<std::size_t>(InterleavedView<T>(nullptr, rows, cols, count).size())),
+          rows_(rows),
+          cols_(cols),
+          count_(count) {
+        std::fill_n(buf_.data(), buf_.size(), T(0));
+    }
+
+    InterleavedBatch(InterleavedBatch&&) noexcept = default;
+    InterleavedBatch& operator=(InterleavedBatch&&) noexcept = default;
+
+    InterleavedBatch(const InterleavedBatch& other) : InterleavedBatch(other.rows_, other.cols_, other.count_) {
+        std::copy_n(other.buf_.data(), buf_.size(), buf_.data());
+    }
+    InterleavedBatch& operator=(const InterleavedBatch& other) {
+        if (this != &other) {
+            *this = InterleavedBatch(other);
+        }
+        return *this;
+    }
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t count() const noexcept { return count_; }
+    index_t size() const noexcept { return static_cast<index_t>(buf_.size()); }
+    T* data() noexcept { return buf_.data(); }
+    const T* data() const noexcept { return buf_.data(); }
+
+    T& operator()(index_t b, index_t i, index_t j) noexcept { return view()(b, i, j); }
+    const T& operator()(index_t b, index_t i, index_t j) const noexcept { return view()(b, i, j); }
+
+    InterleavedView<T> view() noexcept { return {buf_.data(), rows_, cols_, count_}; }
+    InterleavedView<const T> view() const noexcept { return {buf_.data(), rows_, cols_, count_}; }
+    operator InterleavedView<T>() noexcept { return view(); }  // NOLINT(google-explicit-constructor)
+    operator InterleavedView<const T>() const noexcept { return view(); }  // NOLINT(google-explicit-constructor)
+
+private:
+    detail::AlignedBuffer<T> buf_;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t count_ = 0;
+};
+
+/// Copies a strided batch into interleaved storage of the same shape.
+template <typename T>
+void pack(StridedBatch<const T> src, InterleavedView<T> dst) {
+    detail::require_dims(src.rows() == dst.rows() && src.cols() == dst.cols() && src.count() == dst.count(),
+                         "batched::pack");
+    for (index_t b = 0; b < src.count(); ++b) {
+        const T* s = src.ptr(b);
+        for (index_t j = 0; j < src.cols(); ++j) {
+            for (index_t i = 0; i < src.rows(); ++i) {
+                dst(b, i, j) = s[i + j * src.ld()];
+            }
+        }
+    }
+}
+
+/// Copies an interleaved batch back out to strided storage.
+template <typename T>
+void unpack(InterleavedView<const T> src, StridedBatch<T> dst) {
+    detail::require_dims(src.rows() == dst.rows() && src.cols() == dst.cols() && src.count() == dst.count(),
+                         "batched::unpack");
+    for (index_t b = 0; b < src.count(); ++b) {
+        T* d = dst.ptr(b);
+        for (index_t j = 0; j < src.cols(); ++j) {
+            for (index_t i = 0; i < src.rows(); ++i) {
+                d[i + j * dst.ld()] = src(b, i, j);
+            }
+        }
+    }
+}
+
+/// C[b] = alpha * A[b] * B[b] + beta * C[b] for every b. When beta is zero
+/// C is not read. C must not alias A or B.
+LANA_API void gemm(float alpha, StridedBatch<const float> a, StridedBatch<const float> b, float beta,
+                   StridedBatch<float> c);
+LANA_API void gemm(double alpha, StridedBatch<const double> a, StridedBatch<const double> b, double beta,
+                   StridedBatch<double> c);
+LANA_API void gemm(float alpha, PointerBatch<const float> a, PointerBatch<const float> b, float beta,
+                   PointerBatch<float> c);
+LANA_API void gemm(double alpha, PointerBatch<const double> a, PointerBatch<const double> b, double beta,
+                   PointerBatch<double> c);
+LANA_API void gemm(float alpha, InterleavedView<const float> a, InterleavedView<const float> b, float beta,
+                   InterleavedView<float> c);
+LANA_API void gemm(double alpha, InterleavedView<const double> a, InterleavedView<const double> b, double beta,
+                   InterleavedView<double> c);
+
+/// In-place LU factorization with partial pivoting, P * A[b] = L * U, of
+/// square matrices. L is unit lower triangular below the diagonal and U on
+/// and above it, as in LAPACK getrf.
+///
+/// `ipiv` receives rows() 0-based pivots per matrix, matrix b's at
+/// `ipiv + b * rows()`: row k was swapped with row ipiv[k] before step k.
+/// `info` (optional, count() entries) is 0 on
+/// success or k + 1 when U(k, k) is exactly zero; the factorization still
+/// completes. Returns the number of singular matrices.
+LANA_API index_t getrf(StridedBatch<float> a, std::int32_t* ipiv, std::int32_t* info = nullptr);
+LANA_API index_t getrf(StridedBatch<double> a, std::int32_t* ipiv, std::int32_t* info = nullptr);
+LANA_API index_t getrf(PointerBatch<float> a, std::int32_t* ipiv, std::int32_t* info = nullptr);
+LANA_API index_t getrf(PointerBatch<double> a, std::int32_t* ipiv, std::int32_t* info = nullptr);
+LANA_API index_t getrf(InterleavedView<float> a, std::int32_t* ipiv, std::int32_t* info = nullptr);
+LANA_API index_t getrf(InterleavedView<double> a, std::int32_t* ipiv, std::int32_t* info = nullptr);
+
+/// In-place Cholesky factorization A[b] = L * L^T of symmetric positive
+/// definite matrices. Only the lower triangle is read and L overwrites it;
+/// the strict upper triangle is left untouched. `info` (optional) is 0 on
+/// success or k + 1 when the leading k+1 x k+1 minor is not positive
+/// definite, in which case that matrix's contents are unspecified beyond
+/// the first k columns. Returns the number of failed matrices.
+LANA_API index_t potrf(StridedBatch<float> a, std::int32_t* info = nullptr);
+LANA_API index_t potrf(StridedBatch<double> a, std::int32_t* info = nullptr);
+LANA_API index_t potrf(PointerBatch<float> a, std::int32_t* info = nullptr);
+LANA_API index_t potrf(PointerBatch<double> a, std::int32_t* info = nullptr);
+LANA_API index_t potrf(InterleavedView<float> a, std::int32_t* info = nullptr);
+LANA_API index_t potrf(InterleavedView<double> a, std::int32_t* info = nullptr);
+
+}  // namespace lana::batched
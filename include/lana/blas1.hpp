@@ -0,0 +1,24 @@
+#pragma once
+
+#include "lana/config.hpp"
+#include "lana/vector.hpp"
+
+namespace lana {
+
+/// x . y
+LANA_API float dot(VectorView<const float> x, VectorView<const float> y);
+LANA_API double dot(VectorView<const double> x, VectorView<const double> y);
+
+/// y += alpha * x
+LANA_API void axpy(float alpha, VectorView<const float> x, VectorView<float> y);
+LANA_API void axpy(double alpha, VectorView<const double> x, VectorView<double> y);
+
+/// Sum of the elements of x.
+LANA_API float sum(VectorView<const float> x);
+LANA_API double sum(VectorView<const double> x);
+
+/// Euclidean norm of x, computed without intermediate overflow or underflow.
+LANA_API float nrm2(VectorView<const float> x);
+LANA_API double nrm2(VectorView<const double> x);
+
+}  // namespace lana
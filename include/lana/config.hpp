@@ -0,0 +1,56 @@
+#pragma once
+
+/// Build-wide configuration: version, symbol export and small compiler
+/// portability helpers shared by every lana header.
+
+#define LANA_VERSION_MAJOR 0
+#define LANA_VERSION_MINOR 1
+#define LANA_VERSION_PATCH 0
+
+#if defined(_WIN32)
+#  if defined(LANA_BUILDING_LIBRARY)
+#    define LANA_API __declspec(dllexport)
+#  else
+#    define LANA_API __declspec(dllimport)
+#  endif
+#else
+#  define LANA_API __attribute__((visibility("default")))
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#  define LANA_RESTRICT __restrict__
+#  define LANA_ALWAYS_INLINE inline __attribute__((always_inline))
+#  define LANA_LIKELY(x) __builtin_expect(!!(x), 1)
+#  define LANA_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#  define LANA_RESTRICT
+#  define LANA_ALWAYS_INLINE inline
+#  define LANA_LIKELY(x) (x)
+#  define LANA_UNLIKELY(x) (x)
+#endif
+
+/// Asks the compiler to unroll the following loop; used on the constant
+/// trip-count loops of fixed-size kernels.
+#if defined(__clang__)
+#  define LANA_UNROLL _Pragma("unroll")
+#elif defined(__GNUC__)
+#  define LANA_UNROLL _Pragma("GCC unroll 16")
+#else
+#  define LANA_UNROLL
+#endif
+
+#include <cstddef>
+
+namespace lana {
+
+/// Signed index type used for all dimensions and strides.
+using index_t = std::ptrdiff_t;
+
+/// Extent placeholder for a dimension known only at run time:
+/// `Matrix<T>` is `Matrix<T, dynamic, dynamic>`.
+inline constexpr index_t dynamic = -1;
+
+/// Alignment, in bytes, of every buffer lana allocates.
+inline constexpr std::size_t default_alignment = 64;
+
+}  // namespace lana
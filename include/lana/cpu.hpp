@@ -0,0 +1,31 @@
+#pragma once
+
+#include "lana/config.hpp"
+
+namespace lana {
+
+/// Instruction-set paths lana ships micro-kernels for.
+enum class Isa {
+    Scalar,
+    Sse42,
+    Avx2,    ///< AVX2 + FMA3
+    Avx512,  ///< AVX-512F
+    Neon,    ///< AArch64 Advanced SIMD
+};
+
+/// The kernel path selected for this process.
+///
+/// Chosen from CPUID/XGETBV (x86) or HWCAP (AArch64) by the first kernel
+/// call, the first call to this function or warmup(). Setting `LANA_ISA`
+/// to one of the names returned by isa_name() forces a path, provided the
+/// host supports it.
+LANA_API Isa active_isa() noexcept;
+
+/// Whether the library was built with kernels for `isa` and the host can
+/// run them.
+LANA_API bool isa_supported(Isa isa) noexcept;
+
+/// Stable lower-case name: "scalar", "sse4.2", "avx2", "avx512", "neon".
+LANA_API const char* isa_name(Isa isa) noexcept;
+
+}  // namespace lana
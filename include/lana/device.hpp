@@ -0,0 +1,111 @@
+#pragma once
+
+/// Optional offload of large operations to a GPU through a plugin.
+///
+/// lana itself has no GPU dependency. A device backend is a separate shared
+/// object (liblana_cuda.so or liblana_hip.so, built with -DLANA_WITH_CUDA=ON
+/// or -DLANA_WITH_HIP=ON) that lana loads at run time, from the path in
+/// LANA_DEVICE_PLUGIN or from load(). Once one is loaded, these calls decide
+/// per call whether to run on the device:
+///
+///   - gemm (float and double, with or without an epilogue);
+///   - getrf and potrf;
+///   - spmv on a CSR matrix kept on the device by a ResidentCsr.
+///
+/// Operands stay ordinary host views, so the caller sees the same API. The
+/// plugin stages them through pinned buffers and keeps device memory in a
+/// caching allocator. It orders copies and compute on its own streams, so
+/// the transfer of one panel overlaps the compute of the previous one.
+///
+/// The dispatcher uses a cost model. It offloads only when the device time
+/// (transfers at the link rate plus compute at the device rate) beats the
+/// CPU time, and when the operation passes the size floors in Policy. Thin
+/// or small products are transfer-bound and stay on the CPU. A plugin
+/// failure, such as out-of-memory or a driver error, makes that call run on
+/// the CPU instead.
+///
+///     lana::device::load("/opt/lana/lib/liblana_cuda.so");
+///     lana::gemm(1.0f, a, b, 0.0f, c);                    // 8192^3: on the GPU
+///     lana::gemm(1.0f, a_small, b_small, 0.0f, c_small);  // stays on the CPU
+
+#include "lana/config.hpp"
+#include "lana/sparse.hpp"
+
+#include <cstddef>
+#include <string>
+
+namespace lana::device {
+
+struct Info {
+    std::string name;
+    std::string platform;
+    double gflops_f32 = 0;
+    double gflops_f64 = 0;
+    double link_gbps = 0;
+    std::size_t memory_bytes = 0;
+};
+
+/// Loads a device plugin, replacing any loaded one; loading the one already
+/// loaded keeps it. Throws Error if the file cannot be loaded, lacks the
+/// entry point or speaks another ABI version, leaving the loaded plugin in
+/// place. No lana call may be running meanwhile.
+LANA_API void load(const std::string& path);
+
+/// Shuts the plugin down and unloads it; later calls run on the CPU.
+LANA_API void unload() noexcept;
+
+/// Whether a plugin is loaded. The first call tries LANA_DEVICE_PLUGIN,
+/// quietly staying on the CPU if it cannot be loaded.
+LANA_API bool available() noexcept;
+
+/// The loaded device. Throws Error if there is none.
+LANA_API Info info();
+
+struct Policy {
+    /// False keeps everything on the CPU with the plugin loaded.
+    bool enabled = true;
+    /// Operations below this many flops never leave the CPU.
+    double min_flops = 2e9;
+    /// Nor do products and factorizations with a dimension below this.
+    index_t min_dim = 512;
+    /// Host GEMM rates the cost model compares against, GFLOP/s; 0
+    /// estimates them from the kernel ISA and the pool size.
+    double cpu_gflops_f32 = 0;
+    double cpu_gflops_f64 = 0;
+    /// ResidentCsr keeps matrices with fewer nonzeros on the host.
+    index_t min_spmv_nnz = index_t(1) << 20;
+};
+
+LANA_API Policy policy();
+LANA_API void set_policy(const Policy& p);
+
+/// Whether a gemm of this shape would currently run on the device, for
+/// checking the policy against a workload.
+LANA_API bool offloads_gemm(index_t m, index_t n, index_t k, bool f64) noexcept;
+
+/// Keeps a copy of a CSR matrix on the device for its lifetime. spmv on the
+/// same arrays then runs there, and only x and y cross the link. The host
+/// arrays must not change while it lives. Without a device, or below
+/// Policy::min_spmv_nnz, it holds nothing and spmv stays on the CPU.
+class LANA_API ResidentCsr {
+public:
+    explicit ResidentCsr(CsrView<float> a);
+    explicit ResidentCsr(CsrView<double> a);
+    ~ResidentCsr();
+
+    ResidentCsr(ResidentCsr&& other) noexcept;
+    ResidentCsr& operator=(ResidentCsr&& other) noexcept;
+    ResidentCsr(const ResidentCsr&) = delete;
+    ResidentCsr& operator=(const ResidentCsr&) = delete;
+
+    bool resident() const noexcept { return handle_ != nullptr; }
+
+private:
+    void attach(index_t rows, index_t cols, const index_t* row_ptr, const sparse_index_t* col_idx,
+                const void* values, bool f64);
+    void release() noexcept;
+
+    void* handle_ = nullptr;
+};
+
+}  // namespace lana::device
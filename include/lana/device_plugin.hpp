@@ -0,0 +1,88 @@
+#pragma once
+
+/// The C ABI between lana and a device plugin (see lana/device.hpp).
+///
+/// A plugin is a shared object exporting
+///
+///     extern "C" const lana_device_backend* lana_device_backend_v1(void);
+///
+/// which returns a table that stays valid until its shutdown() is called.
+/// Everything crossing the boundary is a plain C type, so a plugin can be
+/// built with another compiler or a different standard library than lana,
+/// and never links against lana itself.
+///
+/// Host operands are described by lana_device_matrix: element (i, j) is at
+/// data + i * row_stride + j * col_stride, in elements, with one of the two
+/// strides equal to 1. Every entry point is synchronous: when it returns,
+/// results are in host memory. A nonzero return means the plugin did not
+/// run the operation and left every output untouched; lana then runs it on
+/// the CPU. Entry points may be called from several threads at once.
+
+#include <cstdint>
+
+extern "C" {
+
+#define LANA_DEVICE_ABI_VERSION 1
+
+#define LANA_DEVICE_F32 1
+#define LANA_DEVICE_F64 2
+
+struct lana_device_matrix {
+    void* data;
+    std::int64_t rows;
+    std::int64_t cols;
+    std::int64_t row_stride;
+    std::int64_t col_stride;
+    std::int32_t dtype;
+};
+
+/// CSR in lana's layout: rows + 1 offsets, 32-bit column indices.
+struct lana_device_csr {
+    std::int64_t rows;
+    std::int64_t cols;
+    std::int64_t nnz;
+    const std::int64_t* row_ptr;
+    const std::int32_t* col_idx;
+    const void* values;
+    std::int32_t dtype;
+};
+
+struct lana_device_info {
+    char name[128];
+    char platform[16];  ///< "cuda", "hip", ...
+    double gflops_f32;  ///< sustained GEMM rate
+    double gflops_f64;
+    double link_gbps;   ///< host <-> device bandwidth, GB/s
+    std::uint64_t memory_bytes;
+};
+
+struct lana_device_backend {
+    std::uint32_t abi_version;  ///< LANA_DEVICE_ABI_VERSION
+    void* self;
+
+    int (*query)(void* self, lana_device_info* out);
+
+    /// C = alpha * A * B + beta * C; alpha and beta in C's precision.
+    int (*gemm)(void* self, double alpha, const lana_device_matrix* a, const lana_device_matrix* b, double beta,
+                const lana_device_matrix* c);
+    /// LU with partial pivoting as lana::getrf: 0-based ipiv of length
+    /// min(rows, cols); *info is 0 or k + 1 for the first zero pivot.
+    int (*getrf)(void* self, const lana_device_matrix* a, std::int32_t* ipiv, std::int64_t* info);
+    /// Lower Cholesky as lana::potrf.
+    int (*potrf)(void* self, const lana_device_matrix* a, std::int64_t* info);
+
+    /// Copies a CSR matrix to the device; *handle names it for spmv until
+    /// csr_release.
+    int (*csr_upload)(void* self, const lana_device_csr* a, void** handle);
+    void (*csr_release)(void* self, void* handle);
+    /// y = alpha * A * x + beta * y with strided host vectors.
+    int (*spmv)(void* self, void* handle, double alpha, const void* x, std::int64_t incx, double beta, void* y,
+                std::int64_t incy);
+
+    /// Releases every device resource; the table is dead afterwards.
+    void (*shutdown)(void* self);
+};
+
+typedef const lana_device_backend* (*lana_device_entry_fn)(void);
+
+}  // extern "C"
@@ -0,0 +1,184 @@
+#pragma once
+
+/// Distributed dense matrices over MPI, in ScaLAPACK's 2D block-cyclic
+/// layout. Built as the separate library lana::dist (-DLANA_WITH_MPI=ON),
+/// so the core library has no MPI dependency.
+///
+/// The processes of a communicator form a P x Q Grid. A dist::Matrix is cut
+/// into mb x nb blocks, and block (I, J) lives on process (I mod P, J mod Q)
+/// as part of that process's local column-major matrix. Every process
+/// stores a near-equal share, and every block row and column is spread over
+/// the whole grid, so the trailing updates of a factorization stay balanced
+/// until the end.
+///
+///     MPI_Init(&argc, &argv);
+///     {
+///         dist::Grid grid(MPI_COMM_WORLD);                  // near-square P x Q
+///         dist::Matrix<double> a(grid, n, n), b(grid, n, n), c(grid, n, n);
+///         a.generate([](index_t i, index_t j) { return f(i, j); });
+///         dist::gemm(1.0, a, b, 0.0, c);                    // SUMMA
+///         std::vector<std::int32_t> ipiv(n);
+///         dist::getrf(a, ipiv.data());
+///     }                                                   // before MPI_Finalize
+///     MPI_Finalize();
+///
+/// Local compute goes through lana's own blocked kernels and thread pool.
+/// MPI is called only from the thread calling into lana::dist, so
+/// MPI_THREAD_FUNNELED is enough. All functions here are collective over
+/// the grid: every process calls them with the same arguments, except for
+/// the views that only the root reads or writes.
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+
+#include <mpi.h>
+
+#include <cstdint>
+
+namespace lana::dist {
+
+/// Number of indices of an extent n, cut into blocks of nb, that fall on
+/// process p of np (ScaLAPACK's numroc). With n a global index g, the
+/// number of local indices below g.
+constexpr index_t local_extent(index_t n, index_t nb, int p, int np) noexcept {
+    const index_t full = n / nb;
+    index_t count = (full / np) * nb;
+    const index_t extra = full % np;
+    if (p < extra) {
+        count += nb;
+    } else if (p == extra) {
+        count += n % nb;
+    }
+    return count;
+}
+
+/// A P x Q arrangement of the processes of a communicator. Rank r sits at
+/// (r / Q, r % Q). Holds duplicated row and column communicators, freed by
+/// the destructor, which must therefore run before MPI_Finalize.
+class LANA_API Grid {
+public:
+    /// prows * pcols must equal the size of `comm`.
+    Grid(MPI_Comm comm, int prows, int pcols);
+    /// The most nearly square grid with prows <= pcols.
+    explicit Grid(MPI_Comm comm);
+    ~Grid();
+
+    Grid(const Grid&) = delete;
+    Grid& operator=(const Grid&) = delete;
+
+    int prows() const noexcept { return prows_; }
+    int pcols() const noexcept { return pcols_; }
+    int prow() const noexcept { return prow_; }
+    int pcol() const noexcept { return pcol_; }
+    int rank() const noexcept { return rank_; }
+
+    MPI_Comm comm() const noexcept { return comm_; }
+    /// The processes of this process row, ranked by process column.
+    MPI_Comm row_comm() const noexcept { return row_comm_; }
+    /// The processes of this process column, ranked by process row.
+    MPI_Comm col_comm() const noexcept { return col_comm_; }
+
+private:
+    MPI_Comm comm_ = MPI_COMM_NULL;
+    MPI_Comm row_comm_ = MPI_COMM_NULL;
+    MPI_Comm col_comm_ = MPI_COMM_NULL;
+    int prows_ = 1;
+    int pcols_ = 1;
+    int prow_ = 0;
+    int pcol_ = 0;
+    int rank_ = 0;
+};
+
+/// A rows x cols matrix distributed block-cyclically over a grid, which
+/// must outlive it. Each process holds its blocks as one local
+/// column-major matrix, zero-initialized.
+template <typename T>
+class Matrix {
+public:
+    using value_type = T;
+
+    Matrix(const Grid& grid, index_t rows, index_t cols, index_t mb, index_t nb)
+        : grid_(&grid),
+          rows_(rows),
+          cols_(cols),
+          mb_(mb),
+          nb_(nb),
+          local_(local_extent(rows, mb, grid.prow(), grid.prows()), local_extent(cols, nb, grid.pcol(), grid.pcols())) {
+        lana::detail::require_dims(mb > 0 && nb > 0, "dist::Matrix block size");
+    }
+    Matrix(const Grid& grid, index_t rows, index_t cols, index_t nb = 128) : Matrix(grid, rows, cols, nb, nb) {}
+
+    const Grid& grid() const noexcept { return *grid_; }
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t mb() const noexcept { return mb_; }
+    index_t nb() const noexcept { return nb_; }
+
+    /// This process's blocks.
+    MatrixView<T> local() noexcept { return local_.view(); }
+    MatrixView<const T> local() const noexcept { return local_.view(); }
+
+    /// Grid coordinates of the process holding global row i (column j).
+    int owner_row(index_t i) const noexcept { return static_cast<int>((i / mb_) % grid_->prows()); }
+    int owner_col(index_t j) const noexcept { return static_cast<int>((j / nb_) % grid_->pcols()); }
+
+    /// Local index of a global row (column) held here, and back.
+    index_t local_row(index_t i) const noexcept { return (i / (mb_ * grid_->prows())) * mb_ + i % mb_; }
+    index_t local_col(index_t j) const noexcept { return (j / (nb_ * grid_->pcols())) * nb_ + j % nb_; }
+    index_t global_row(index_t li) const noexcept {
+        return ((li / mb_) * grid_->prows() + grid_->prow()) * mb_ + li % mb_;
+    }
+    index_t global_col(index_t lj) const noexcept {
+        return ((lj / nb_) * grid_->pcols() + grid_->pcol()) * nb_ + lj % nb_;
+    }
+
+    /// local(i, j) = f(global row, global column) for every local element;
+    /// not collective.
+    template <typename F>
+    void generate(F&& f) {
+        const MatrixView<T> v = local_.view();
+        for (index_t lj = 0; lj < v.cols(); ++lj) {
+            const index_t j = global_col(lj);
+            for (index_t li = 0; li < v.rows(); ++li) {
+                v(li, lj) = f(global_row(li), j);
+            }
+        }
+    }
+
+private:
+    const Grid* grid_;
+    index_t rows_;
+    index_t cols_;
+    index_t mb_;
+    index_t nb_;
+    lana::Matrix<T> local_;
+};
+
+/// Distributes `src` (rows x cols, read on `root` only) into `dst`.
+LANA_API void scatter(MatrixView<const float> src, int root, Matrix<float>& dst);
+LANA_API void scatter(MatrixView<const double> src, int root, Matrix<double>& dst);
+
+/// Collects `src` into `dst` (rows x cols, written on `root` only).
+LANA_API void gather(const Matrix<float>& src, int root, MatrixView<float> dst);
+LANA_API void gather(const Matrix<double>& src, int root, MatrixView<double> dst);
+
+/// C = alpha * A * B + beta * C by SUMMA: for each block column of A (block
+/// row of B), the owners broadcast it along process rows (columns) and
+/// every process updates its local C. The next panels' broadcasts are in
+/// flight while the current one is multiplied. All three matrices share a
+/// grid, with a.nb() == b.mb(), c.mb() == a.mb() and c.nb() == b.nb().
+LANA_API void gemm(float alpha, const Matrix<float>& a, const Matrix<float>& b, float beta, Matrix<float>& c);
+LANA_API void gemm(double alpha, const Matrix<double>& a, const Matrix<double>& b, double beta,
+                   Matrix<double>& c);
+
+/// Right-looking LU with partial pivoting, as lana::getrf: on return `a`
+/// holds L and U of P * A = L * U, and ipiv[0, min(rows, cols)) the global
+/// row interchanges, replicated on every process. Needs square blocks
+/// (mb() == nb()). Each panel's broadcast along process rows overlaps its
+/// row interchanges in the other block columns. Returns 0, or k + 1 for
+/// the first exactly zero pivot.
+LANA_API index_t getrf(Matrix<float>& a, std::int32_t* ipiv);
+LANA_API index_t getrf(Matrix<double>& a, std::int32_t* ipiv);
+
+}  // namespace lana::dist
@@ -0,0 +1,45 @@
+#pragma once
+
+/// Dense symmetric eigen-decomposition and singular value decomposition.
+///
+/// syevd reduces A to tridiagonal form in two stages. The first is a
+/// blocked reduction to a band of width nb, A = Q1 * B * Q1^T, whose
+/// two-sided updates are GEMM calls. The second chases B down to
+/// tridiagonal T = Q2^T * B * Q2 with small reflectors, touching only the
+/// band. T is then solved by divide and conquer: each merge is a secular
+/// equation whose roots are found in parallel, followed by one GEMM that
+/// rotates the eigenvectors of the two halves. The eigenvectors of A are
+/// Q1 * Q2 * Z, with Q2 applied to column blocks of Z on the thread pool and
+/// Q1 applied through ormqr.
+///
+/// gesdd computes A = U_p * H, the polar decomposition, by the QDWH
+/// iteration (a few QR or Cholesky based steps, again almost all GEMM),
+/// then H = V * S * V^T with syevd, so U = U_p * V.
+///
+/// lana matrices are real, so Hermitian problems are not covered.
+
+#include "lana/config.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+namespace lana {
+
+enum class EigenJob { ValuesOnly, Vectors };
+
+/// Eigenvalues of symmetric A, read from its lower triangle, in ascending
+/// order into `w`. With EigenJob::Vectors A is overwritten with the
+/// orthonormal eigenvectors, column i belonging to w[i]; otherwise its
+/// contents are destroyed. Returns 0, or k + 1 if the tridiagonal QL
+/// iteration for eigenvalue k failed to converge (ValuesOnly only).
+LANA_API index_t syevd(EigenJob job, MatrixView<float> a, VectorView<float> w);
+LANA_API index_t syevd(EigenJob job, MatrixView<double> a, VectorView<double> w);
+
+/// Thin SVD A = U * diag(s) * V^T of an m x n matrix, k = min(m, n): the
+/// singular values in descending order into `s` (k elements), U into `u`
+/// (m x k) and V^T into `vt` (k x n). Pass empty `u` and `vt` for values
+/// only. Returns 0, or 1 if the polar iteration failed to converge.
+LANA_API index_t gesdd(MatrixView<const float> a, VectorView<float> s, MatrixView<float> u, MatrixView<float> vt);
+LANA_API index_t gesdd(MatrixView<const double> a, VectorView<double> s, MatrixView<double> u,
+                       MatrixView<double> vt);
+
+}  // namespace lana
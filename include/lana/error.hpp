@@ -0,0 +1,35 @@
+#pragma once
+
+#include <stdexcept>
+#include <string>
+
+namespace lana {
+
+/// Base class of every exception thrown by lana.
+class Error : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
+/// Operand shapes do not agree (e.g. inner dimensions of a product).
+class DimensionError : public Error {
+public:
+    using Error::Error;
+};
+
+/// A file could not be read, written or mapped, or is not a valid lana file.
+class IoError : public Error {
+public:
+    using Error::Error;
+};
+
+namespace detail {
+
+constexpr void require_dims(bool ok, const char* what) {
+    if (!ok) {
+        throw DimensionError(std::string("lana: dimension mismatch in ") + what);
+    }
+}
+
+}  // namespace detail
+}  // namespace lana
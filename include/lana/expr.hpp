@@ -0,0 +1,333 @@
+#pragma once
+
+/// Expression templates for fused elementwise arithmetic.
+///
+/// `y = alpha * x + beta * w - z` on lana vectors and matrices builds a small
+/// tree of nodes instead of temporaries; assignment then evaluates it in one
+/// pass. Trees that are a linear combination of contiguous operands (any mix
+/// of +, -, unary minus and scalar scaling) are handed to the dispatched SIMD
+/// `lincomb` kernel; everything else is evaluated by an inlined loop.
+///
+/// Nodes hold views, not copies: an expression must not outlive its operands.
+/// Evaluation is elementwise, so the destination may appear in the expression
+/// (`x = 2 * x + y`) as long as it is not aliased at a different offset.
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+
+#include <type_traits>
+
+namespace lana {
+
+template <typename T>
+class Vector;
+template <typename T>
+class VectorView;
+template <typename T, index_t R = dynamic, index_t C = dynamic>
+class Matrix;
+template <typename T>
+class MatrixView;
+
+namespace detail {
+
+/// Most terms the SIMD lincomb kernel accepts in one call.
+inline constexpr int lincomb_max_terms = 8;
+
+/// y[i] = sum_t coeffs[t] * xs[t][i] for i in [0, n); y may equal any xs[t].
+LANA_API void lincomb(index_t n, int terms, const float* coeffs, const float* const* xs, float* y);
+LANA_API void lincomb(index_t n, int terms, const double* coeffs, const double* const* xs, double* y);
+
+}  // namespace detail
+
+namespace expr {
+
+template <typename D>
+struct Base {
+    const D& self() const noexcept { return static_cast<const D&>(*this); }
+};
+
+/// Strided operand. Vectors are rows x 1 with row stride = element stride.
+template <typename T>
+struct Leaf : Base<Leaf<T>> {
+    using value_type = T;
+    static constexpr int linear_terms = 1;
+
+    Leaf(const T* d, index_t r, index_t c, index_t row_stride, index_t col_stride) noexcept
+        : data(d), rows_(r), cols_(c), rs(row_stride), cs(col_stride) {}
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    /// Element (i, j) lives at data[i + j * rows()].
+    bool contiguous() const noexcept { return rs == 1 && (cs == rows_ || cols_ == 1); }
+    T coeff(index_t i, index_t j) const noexcept { return data[i * rs + j * cs]; }
+    T linear(index_t k) const noexcept { return data[k]; }
+
+    template <typename F>
+    void collect_linear(T scale, F&& emit) const {
+        emit(scale, data);
+    }
+
+    const T* data;
+    index_t rows_, cols_, rs, cs;
+};
+
+template <typename E>
+struct Scaled : Base<Scaled<E>> {
+    using value_type = typename E::value_type;
+    static constexpr int linear_terms = E::linear_terms;
+
+    Scaled(value_type s, const E& e) : scale(s), inner(e) {}
+
+    index_t rows() const noexcept { return inner.rows(); }
+    index_t cols() const noexcept { return inner.cols(); }
+    bool contiguous() const noexcept { return inner.contiguous(); }
+    value_type coeff(index_t i, index_t j) const noexcept { return scale * inner.coeff(i, j); }
+    value_type linear(index_t k) const noexcept { return scale * inner.linear(k); }
+
+    template <typename F>
+    void collect_linear(value_type s, F&& emit) const {
+        inner.collect_linear(s * scale, emit);
+    }
+
+    value_type scale;
+    E inner;
+};
+
+struct AddOp {
+    template <typename T>
+    static T apply(T a, T b) noexcept {
+        return a + b;
+    }
+    static constexpr bool linear = true;
+    static constexpr int rhs_sign = 1;
+};
+struct SubOp {
+    template <typename T>
+    static T apply(T a, T b) noexcept {
+        return a - b;
+    }
+    static constexpr bool linear = true;
+    static constexpr int rhs_sign = -1;
+};
+struct MulOp {
+    template <typename T>
+    static T apply(T a, T b) noexcept {
+        return a * b;
+    }
+    static constexpr bool linear = false;
+    static constexpr int rhs_sign = 1;
+};
+struct DivOp {
+    template <typename T>
+    static T apply(T a, T b) noexcept {
+        return a / b;
+    }
+    static constexpr bool linear = false;
+    static constexpr int rhs_sign = 1;
+};
+
+/// Sentinel term count for trees that are not a linear combination.
+inline constexpr int nonlinear = 1 << 20;
+
+template <typename L, typename R, typename Op>
+struct Binary : Base<Binary<L, R, Op>> {
+    using value_type = typename L::value_type;
+    static_assert(std::is_same_v<value_type, typename R::value_type>, "lana: operands must share an element type");
+    static constexpr int linear_terms = Op::linear ? L::linear_terms + R::linear_terms : nonlinear;
+
+    Binary(const L& l, const R& r) : lhs(l), rhs(r) {
+        detail::require_dims(l.rows() == r.rows() && l.cols() == r.cols(), "elementwise expression");
+    }
+
+    index_t rows() const noexcept { return lhs.rows(); }
+    index_t cols() const noexcept { return lhs.cols(); }
+    bool contiguous() const noexcept { return lhs.contiguous() && rhs.contiguous(); }
+    value_type coeff(index_t i, index_t j) const noexcept { return Op::apply(lhs.coeff(i, j), rhs.coeff(i, j)); }
+    value_type linear(index_t k) const noexcept { return Op::apply(lhs.linear(k), rhs.linear(k)); }
+
+    template <typename F>
+    void collect_linear(value_type s, F&& emit) const {
+        lhs.collect_linear(s, emit);
+        rhs.collect_linear(Op::rhs_sign > 0 ? s : -s, emit);
+    }
+
+    L lhs;
+    R rhs;
+};
+
+template <typename E>
+struct Negate : Base<Negate<E>> {
+    using value_type = typename E::value_type;
+    static constexpr int linear_terms = E::linear_terms;
+
+    explicit Negate(const E& e) : inner(e) {}
+
+    index_t rows() const noexcept { return inner.rows(); }
+    index_t cols() const noexcept { return inner.cols(); }
+    bool contiguous() const noexcept { return inner.contiguous(); }
+    value_type coeff(index_t i, index_t j) const noexcept { return -inner.coeff(i, j); }
+    value_type linear(index_t k) const noexcept { return -inner.linear(k); }
+
+    template <typename F>
+    void collect_linear(value_type s, F&& emit) const {
+        inner.collect_linear(-s, emit);
+    }
+
+    E inner;
+};
+
+// as_expr: lift containers and views to leaves; expressions pass through.
+
+template <typename T>
+Leaf<T> as_expr(const Vector<T>& v) noexcept {
+    return {v.data(), v.size(), 1, 1, v.size()};
+}
+template <typename T>
+Leaf<std::remove_const_t<T>> as_expr(const VectorView<T>& v) noexcept {
+    return {v.data(), v.size(), 1, v.stride(), v.size() * v.stride()};
+}
+template <typename T, index_t R, index_t C>
+Leaf<T> as_expr(const Matrix<T, R, C>& m) noexcept {
+    return {m.data(), m.rows(), m.cols(), 1, m.rows()};
+}
+template <typename T>
+Leaf<std::remove_const_t<T>> as_expr(const MatrixView<T>& m) noexcept {
+    return {m.data(), m.rows(), m.cols(), m.row_stride(), m.col_stride()};
+}
+template <typename D>
+const D& as_expr(const Base<D>& e) noexcept {
+    return e.self();
+}
+
+template <typename A>
+using expr_of = std::decay_t<decltype(as_expr(std::declval<const A&>()))>;
+
+template <typename A>
+concept Operand = requires(const A& a) { as_expr(a); };
+
+}  // namespace expr
+
+template <typename A, typename B>
+    requires expr::Operand<A> && expr::Operand<B>
+auto operator+(const A& a, const B& b) {
+    return expr::Binary<expr::expr_of<A>, expr::expr_of<B>, expr::AddOp>(expr::as_expr(a), expr::as_expr(b));
+}
+
+template <typename A, typename B>
+    requires expr::Operand<A> && expr::Operand<B>
+auto operator-(const A& a, const B& b) {
+    return expr::Binary<expr::expr_of<A>, expr::expr_of<B>, expr::SubOp>(expr::as_expr(a), expr::as_expr(b));
+}
+
+template <typename A>
+    requires expr::Operand<A>
+auto operator-(const A& a) {
+    return expr::Negate<expr::expr_of<A>>(expr::as_expr(a));
+}
+
+template <typename A>
+    requires expr::Operand<A>
+auto operator*(typename expr::expr_of<A>::value_type s, const A& a) {
+    return expr::Scaled<expr::expr_of<A>>(s, expr::as_expr(a));
+}
+
+template <typename A>
+    requires expr::Operand<A>
+auto operator*(const A& a, typename expr::expr_of<A>::value_type s) {
+    return expr::Scaled<expr::expr_of<A>>(s, expr::as_expr(a));
+}
+
+template <typename A>
+    requires expr::Operand<A>
+auto operator/(const A& a, typename expr::expr_of<A>::value_type s) {
+    return expr::Scaled<expr::expr_of<A>>(typename expr::expr_of<A>::value_type(1) / s, expr::as_expr(a));
+}
+
+/// Elementwise product; `*` between two operands is reserved for matrix products.
+template <typename A, typename B>
+    requires expr::Operand<A> && expr::Operand<B>
+auto cwise_mul(const A& a, const B& b) {
+    return expr::Binary<expr::expr_of<A>, expr::expr_of<B>, expr::MulOp>(expr::as_expr(a), expr::as_expr(b));
+}
+
+/// Elementwise quotient.
+template <typename A, typename B>
+    requires expr::Operand<A> && expr::Operand<B>
+auto cwise_div(const A& a, const B& b) {
+    return expr::Binary<expr::expr_of<A>, expr::expr_of<B>, expr::DivOp>(expr::as_expr(a), expr::as_expr(b));
+}
+
+namespace expr {
+
+// The nodes live here, so argument-dependent lookup searches this namespace
+// and not lana's: without these, `2 * x + y` would only combine inside lana.
+using lana::operator+;
+using lana::operator-;
+using lana::operator*;
+using lana::operator/;
+
+}  // namespace expr
+
+namespace detail {
+
+/// Evaluates `e` into the strided rows x cols destination at `dst`.
+template <typename T, typename E>
+void assign_expr(T* dst, index_t rows, index_t cols, index_t rs, index_t cs, const expr::Base<E>& src) {
+    const E& e = src.self();
+    require_dims(e.rows() == rows && e.cols() == cols, "expression assignment");
+    const bool contiguous = rs == 1 && (cs == rows || cols == 1) && e.contiguous();
+
+    if constexpr ((std::is_same_v<T, float> || std::is_same_v<T, double>) &&
+                  E::linear_terms <= lincomb_max_terms) {
+        if (contiguous) {
+            T coeffs[lincomb_max_terms];
+            const T* xs[lincomb_max_terms];
+            int terms = 0;
+            e.collect_linear(T(1), [&](T c, const T* x) {
+                coeffs[terms] = c;
+                xs[terms] = x;
+                ++terms;
+            });
+            lincomb(rows * cols, terms, coeffs, xs, dst);
+            return;
+        }
+    }
+    if (contiguous) {
+        const index_t n = rows * cols;
+        for (index_t k = 0; k < n; ++k) {
+            dst[k] = e.linear(k);
+        }
+        return;
+    }
+    for (index_t j = 0; j < cols; ++j) {
+        for (index_t i = 0; i < rows; ++i) {
+            dst[i * rs + j * cs] = e.coeff(i, j);
+        }
+    }
+}
+
+/// assign_expr for a contiguous R x C destination whose extents are known
+/// at compile time: the loops have constant trip counts and unroll, and
+/// linear combinations skip the dispatched kernel, whose call would cost
+/// more than the arithmetic.
+template <index_t R, index_t C, typename T, typename E>
+void assign_fixed(T* dst, const expr::Base<E>& src) {
+    const E& e = src.self();
+    require_dims(e.rows() == R && e.cols() == C, "expression assignment");
+    if (e.contiguous()) {
+        LANA_UNROLL
+        for (index_t k = 0; k < R * C; ++k) {
+            dst[k] = e.linear(k);
+        }
+        return;
+    }
+    for (index_t j = 0; j < C; ++j) {
+        LANA_UNROLL
+        for (index_t i = 0; i < R; ++i) {
+            dst[i + j * R] = e.coeff(i, j);
+        }
+    }
+}
+
+}  // namespace detail
+}  // namespace lana
@@ -0,0 +1,115 @@
+#pragma once
+
+/// Blocked dense factorizations and the solves built on them.
+///
+/// Each factorization is right-looking: a narrow panel is factored, then the
+/// trailing matrix is updated with triangular solves and GEMM calls, which
+/// is where nearly all of the flops go. For matrices larger than one block
+/// the panels and tile updates form a task graph run on lana's executor,
+/// with the next panel prioritised so that it is factored while the rest of
+/// the previous update is still in flight (lookahead).
+///
+/// Storage follows LAPACK: factors overwrite the input, pivots are row
+/// indices, and a nonzero return value k means the factorization broke down
+/// at step k - 1. Pivots here are zero-based.
+
+#include "lana/config.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+#include <cstdint>
+
+namespace lana {
+
+enum class Side { Left, Right };
+enum class Uplo { Lower, Upper };
+enum class Op { NoTrans, Trans };
+enum class Diag { NonUnit, Unit };
+enum class UpdateSign { Plus, Minus };
+
+/// Tile size of the blocked factorizations; 0 (the default) picks one from
+/// the matrix size.
+LANA_API index_t factor_block_size() noexcept;
+LANA_API void set_factor_block_size(index_t nb) noexcept;
+
+/// B = alpha * op(A)^-1 * B (Side::Left) or B = alpha * B * op(A)^-1
+/// (Side::Right), with A square and triangular as given by `uplo` and
+/// `diag`; the other triangle of A is not read.
+LANA_API void trsm(Side side, Uplo uplo, Op op, Diag diag, float alpha, MatrixView<const float> a,
+                   MatrixView<float> b);
+LANA_API void trsm(Side side, Uplo uplo, Op op, Diag diag, double alpha, MatrixView<const double> a,
+                   MatrixView<double> b);
+
+/// LU with partial pivoting: P * A = L * U for an m x n matrix A, L unit
+/// lower triangular (the unit diagonal is not stored) and U upper.
+/// Row i was interchanged with row ipiv[i] for i in [0, min(m, n)), in that
+/// order. Returns 0, or k + 1 for the first exactly zero pivot U(k, k); the
+/// factorization is still completed in that case.
+LANA_API index_t getrf(MatrixView<float> a, std::int32_t* ipiv);
+LANA_API index_t getrf(MatrixView<double> a, std::int32_t* ipiv);
+
+/// Solves op(A) * X = B in place of B from getrf's output.
+LANA_API void getrs(Op op, MatrixView<const float> lu, const std::int32_t* ipiv, MatrixView<float> b);
+LANA_API void getrs(Op op, MatrixView<const double> lu, const std::int32_t* ipiv, MatrixView<double> b);
+
+/// Cholesky: A = L * L^T for symmetric positive definite A, read from and
+/// overwritten in the lower triangle; the strict upper triangle is not
+/// touched. Returns 0, or k + 1 if the leading (k + 1) x (k + 1) minor is
+/// not positive definite, in which case the factor is left incomplete.
+LANA_API index_t potrf(MatrixView<float> a);
+LANA_API index_t potrf(MatrixView<double> a);
+
+/// Solves A * X = B in place of B from potrf's output.
+LANA_API void potrs(MatrixView<const float> l, MatrixView<float> b);
+LANA_API void potrs(MatrixView<const double> l, MatrixView<double> b);
+
+/// Rank-k update of potrf's output: L becomes the Cholesky factor of
+/// L * L^T + X * X^T (UpdateSign::Plus) or L * L^T - X * X^T (Minus), for X
+/// n x k, in O(k * n^2) instead of refactoring, by Givens (or hyperbolic)
+/// rotations; X is overwritten. Returns 0, or j + 1 if a downdate leaves
+/// the matrix not positive definite at column j, in which case L is no
+/// longer a valid factor.
+LANA_API index_t potrf_update(MatrixView<float> l, MatrixView<float> x, UpdateSign sign);
+LANA_API index_t potrf_update(MatrixView<double> l, MatrixView<double> x, UpdateSign sign);
+
+/// Householder QR: A = Q * R for an m x n matrix A. R overwrites the upper
+/// triangle; below the diagonal, column j holds the tail of the reflector
+/// H_j = I - tau[j] * v * v^T (v(j) = 1 implied), and Q = H_0 * H_1 * ...
+/// `tau` has min(m, n) elements.
+LANA_API void geqrf(MatrixView<float> a, VectorView<float> tau);
+LANA_API void geqrf(MatrixView<double> a, VectorView<double> tau);
+
+/// C = op(Q) * C for the Q held in geqrf's output; C has m rows.
+LANA_API void ormqr(Op op, MatrixView<const float> qr, VectorView<const float> tau, MatrixView<float> c);
+LANA_API void ormqr(Op op, MatrixView<const double> qr, VectorView<const double> tau, MatrixView<double> c);
+
+/// Mixed-precision solves with iterative refinement (LAPACK dsgesv and
+/// dsposv). A is factored in float, at twice the speed and half the memory
+/// traffic of a double factorization, and the solution is refined with
+/// double-precision residuals R = B - A * X until every column satisfies
+/// max|r| <= max|x| * |A|_inf * eps * sqrt(n), the accuracy of a double
+/// solve. If A does not fit in float, its float factorization breaks down
+/// or refinement stalls (roughly, cond(A) beyond 1e7), the system is solved
+/// with a double factorization instead.
+struct RefineOptions {
+    /// Refinement steps before falling back to double.
+    index_t max_iterations = 30;
+};
+
+struct RefineResult {
+    /// 0, or getrf/potrf's result for the double factorization when the
+    /// fallback ran into a singular or indefinite matrix; B is then left
+    /// unchanged.
+    index_t info = 0;
+    /// Refinement steps taken in float.
+    index_t iterations = 0;
+    /// False if the solution came from the double fallback.
+    bool mixed = true;
+};
+
+/// Solves A * X = B in place of B for a general square A.
+LANA_API RefineResult gesv_refine(MatrixView<const double> a, MatrixView<double> b, const RefineOptions& opts = {});
+/// The same for symmetric positive definite A, read from its lower triangle.
+LANA_API RefineResult posv_refine(MatrixView<const double> a, MatrixView<double> b, const RefineOptions& opts = {});
+
+}  // namespace lana
@@ -0,0 +1,294 @@
+#pragma once
+
+/// Memoized factorizations for solving against the same matrix many times.
+///
+/// A FactorCache maps a FactorKey to a dense LU or Cholesky factorization,
+/// or a sparse one, so that a repeated solve costs the O(n^2) triangular
+/// solves instead of a new O(n^3) factorization. A key identifies the
+/// matrix in one of two ways:
+///
+///     auto lu = cache.lu(a.view());                       // content_key(a)
+///     auto ch = cache.cholesky(lana::version_key(id, rev), a.view());
+///     lu->solve(b.view());
+///
+/// content_key hashes the shape and values, one pass over A. A version key
+/// is a caller's matrix id plus a stamp it bumps whenever the matrix
+/// changes, so a lookup costs nothing, but a stale stamp returns a stale
+/// factor.
+///
+/// Entries are released least recently used first once their total size
+/// exceeds the memory budget. Lookups hand out shared_ptrs, so an entry
+/// evicted while another thread is still solving with it lives until that
+/// solve is done. The cache is safe to use from several threads; a miss is
+/// factored outside its lock, and two threads missing the same key at once
+/// both factor, the second result being dropped.
+///
+/// For a slowly changing SPD matrix, cholesky_update moves a cached dense
+/// Cholesky factor to a new key through a rank-k update or downdate
+/// (potrf_update), at O(k * n^2).
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/matrix.hpp"
+#include "lana/sparse.hpp"
+#include "lana/sparse_factor.hpp"
+#include "lana/vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace lana {
+
+/// Identity of a matrix in a FactorCache.
+struct FactorKey {
+    std::uint64_t id = 0;
+    std::uint64_t version = 0;
+    bool content = false;  ///< id is a content hash
+
+    friend bool operator==(const FactorKey&, const FactorKey&) = default;
+};
+
+/// Key for a caller-managed matrix: `id` names it, `version` changes with
+/// its contents.
+inline FactorKey version_key(std::uint64_t id, std::uint64_t version) noexcept { return {id, version, false}; }
+
+/// Key from the shape and values of `a` (and the pattern, for CSR). Two
+/// matrices with equal keys are taken to be equal; they collide with
+/// probability about 2^-64.
+LANA_API FactorKey content_key(MatrixView<const float> a);
+LANA_API FactorKey content_key(MatrixView<const double> a);
+LANA_API FactorKey content_key(CsrView<float> a);
+LANA_API FactorKey content_key(CsrView<double> a);
+
+/// P * A = L * U of a square matrix, from getrf. Throws Error if A is
+/// exactly singular.
+template <typename T>
+class LuFactor {
+public:
+    using value_type = T;
+
+    explicit LuFactor(MatrixView<const T> a) : lu_(a), ipiv_(static_cast<std::size_t>(a.rows())) {
+        detail::require_dims(a.rows() == a.cols(), "LuFactor");
+        if (getrf(lu_.view(), ipiv_.data()) != 0) {
+            throw Error("lana: LuFactor needs a nonsingular matrix");
+        }
+    }
+
+    /// B = A^-1 * B.
+    void solve(MatrixView<T> b) const { getrs(Op::NoTrans, MatrixView<const T>(lu_.view()), ipiv_.data(), b); }
+    void solve(VectorView<T> b) const {
+        solve(MatrixView<T>(b.data(), b.size(), 1, b.stride(), b.size() * b.stride()));
+    }
+
+    index_t rows() const noexcept { return lu_.rows(); }
+    std::size_t bytes() const noexcept {
+        return static_cast<std::size_t>(lu_.rows() * lu_.cols()) * sizeof(T) + ipiv_.size() * sizeof(std::int32_t);
+    }
+
+private:
+    Matrix<T> lu_;
+    std::vector<std::int32_t> ipiv_;
+};
+
+/// A = L * L^T of a symmetric positive definite matrix read from its lower
+/// triangle, from potrf. Throws Error if A is not positive definite.
+template <typename T>
+class CholeskyFactor {
+public:
+    using value_type = T;
+
+    explicit CholeskyFactor(MatrixView<const T> a) : l_(a) {
+        detail::require_dims(a.rows() == a.cols(), "CholeskyFactor");
+        if (potrf(l_.view()) != 0) {
+            throw Error("lana: CholeskyFactor needs a positive definite matrix");
+        }
+    }
+
+    /// B = A^-1 * B.
+    void solve(MatrixView<T> b) const { potrs(MatrixView<const T>(l_.view()), b); }
+    void solve(VectorView<T> b) const {
+        solve(MatrixView<T>(b.data(), b.size(), 1, b.stride(), b.size() * b.stride()));
+    }
+
+    /// Refactors A +- X * X^T in place (see potrf_update); returns 0, or
+    /// j + 1 if a downdate lost definiteness and the factor is invalid.
+    index_t update(MatrixView<const T> x, UpdateSign sign) {
+        Matrix<T> w(x);
+        return potrf_update(l_.view(), w.view(), sign);
+    }
+
+    index_t rows() const noexcept { return l_.rows(); }
+    MatrixView<const T> factor() const noexcept { return l_.view(); }
+    std::size_t bytes() const noexcept { return static_cast<std::size_t>(l_.rows() * l_.cols()) * sizeof(T); }
+
+private:
+    Matrix<T> l_;
+};
+
+enum class FactorKind : std::uint8_t { Lu, Cholesky, SparseLu, SparseCholesky };
+
+struct FactorCacheStats {
+    std::uint64_t hits = 0;
+    std::uint64_t misses = 0;
+    std::uint64_t evictions = 0;
+    std::uint64_t updates = 0;  ///< successful cholesky_update calls
+    std::size_t entries = 0;
+    std::size_t bytes = 0;
+};
+
+namespace detail {
+
+class FactorCacheImpl;
+
+struct FactorSlot {
+    FactorKey key;
+    FactorKind kind;
+    bool f64;
+
+    friend bool operator==(const FactorSlot&, const FactorSlot&) = default;
+};
+
+}  // namespace detail
+
+class LANA_API FactorCache {
+public:
+    static constexpr std::size_t default_budget = std::size_t(1) << 30;
+
+    /// A cache holding at most `budget_bytes` of factors. A single factor
+    /// larger than the budget is computed but not kept.
+    explicit FactorCache(std::size_t budget_bytes = default_budget);
+    ~FactorCache();
+
+    FactorCache(const FactorCache&) = delete;
+    FactorCache& operator=(const FactorCache&) = delete;
+
+    /// The factorization of `a` under `key`: the cached one, or a new one,
+    /// which is inserted. Throws as the factor's constructor does.
+    std::shared_ptr<const LuFactor<float>> lu(const FactorKey& key, MatrixView<const float> a) {
+        return get<LuFactor<float>>(FactorKind::Lu, key, a);
+    }
+    std::shared_ptr<const LuFactor<double>> lu(const FactorKey& key, MatrixView<const double> a) {
+        return get<LuFactor<double>>(FactorKind::Lu, key, a);
+    }
+    std::shared_ptr<const CholeskyFactor<float>> cholesky(const FactorKey& key, MatrixView<const float> a) {
+        return get<CholeskyFactor<float>>(FactorKind::Cholesky, key, a);
+    }
+    std::shared_ptr<const CholeskyFactor<double>> cholesky(const FactorKey& key, MatrixView<const double> a) {
+        return get<CholeskyFactor<double>>(FactorKind::Cholesky, key, a);
+    }
+    std::shared_ptr<const SparseLu<float>> sparse_lu(const FactorKey& key, CsrView<float> a,
+                                                     Ordering ordering = Ordering::Amd) {
+        return get<SparseLu<float>>(FactorKind::SparseLu, key, a, ordering);
+    }
+    std::shared_ptr<const SparseLu<double>> sparse_lu(const FactorKey& key, CsrView<double> a,
+                                                      Ordering ordering = Ordering::Amd) {
+        return get<SparseLu<double>>(FactorKind::SparseLu, key, a, ordering);
+    }
+    std::shared_ptr<const SparseCholesky<float>> sparse_cholesky(const FactorKey& key, CsrView<float> a,
+                                                                 Ordering ordering = Ordering::Amd) {
+        return get<SparseCholesky<float>>(FactorKind::SparseCholesky, key, a, ordering);
+    }
+    std::shared_ptr<const SparseCholesky<double>> sparse_cholesky(const FactorKey& key, CsrView<double> a,
+                                                                  Ordering ordering = Ordering::Amd) {
+        return get<SparseCholesky<double>>(FactorKind::SparseCholesky, key, a, ordering);
+    }
+
+    /// The same, keyed by content_key(a).
+    std::shared_ptr<const LuFactor<float>> lu(MatrixView<const float> a) { return lu(content_key(a), a); }
+    std::shared_ptr<const LuFactor<double>> lu(MatrixView<const double> a) { return lu(content_key(a), a); }
+    std::shared_ptr<const CholeskyFactor<float>> cholesky(MatrixView<const float> a) {
+        return cholesky(content_key(a), a);
+    }
+    std::shared_ptr<const CholeskyFactor<double>> cholesky(MatrixView<const double> a) {
+        return cholesky(content_key(a), a);
+    }
+    std::shared_ptr<const SparseLu<float>> sparse_lu(CsrView<float> a, Ordering ordering = Ordering::Amd) {
+        return sparse_lu(content_key(a), a, ordering);
+    }
+    std::shared_ptr<const SparseLu<double>> sparse_lu(CsrView<double> a, Ordering ordering = Ordering::Amd) {
+        return sparse_lu(content_key(a), a, ordering);
+    }
+    std::shared_ptr<const SparseCholesky<float>> sparse_cholesky(CsrView<float> a, Ordering ordering = Ordering::Amd) {
+        return sparse_cholesky(content_key(a), a, ordering);
+    }
+    std::shared_ptr<const SparseCholesky<double>> sparse_cholesky(CsrView<double> a,
+                                                                  Ordering ordering = Ordering::Amd) {
+        return sparse_cholesky(content_key(a), a, ordering);
+    }
+
+    /// Takes the dense Cholesky factor cached under `from`, updates it to
+    /// the factor of A +- X * X^T and caches that under `to`. The update is
+    /// in place unless another thread still holds the old factor, which is
+    /// then copied. Returns null, and leaves nothing under `from`, if there
+    /// was no such factor or a downdate lost definiteness; the caller then
+    /// factors the new matrix itself.
+    std::shared_ptr<const CholeskyFactor<float>> cholesky_update(const FactorKey& from, const FactorKey& to,
+                                                                 MatrixView<const float> x, UpdateSign sign) {
+        return update<float>(from, to, x, sign);
+    }
+    std::shared_ptr<const CholeskyFactor<double>> cholesky_update(const FactorKey& from, const FactorKey& to,
+                                                                  MatrixView<const double> x, UpdateSign sign) {
+        return update<double>(from, to, x, sign);
+    }
+
+    /// Drops every factor cached under `key`.
+    void erase(const FactorKey& key);
+    void clear();
+
+    std::size_t budget() const;
+    /// Changes the budget, evicting at once if it shrank.
+    void set_budget(std::size_t budget_bytes);
+    FactorCacheStats stats() const;
+
+private:
+    template <typename F, typename... Args>
+    std::shared_ptr<const F> get(FactorKind kind, const FactorKey& key, const Args&... args) {
+        const detail::FactorSlot slot{key, kind, std::is_same_v<typename F::value_type, double>};
+        if (std::shared_ptr<void> hit = find(slot)) {
+            return std::static_pointer_cast<const F>(hit);
+        }
+        auto made = std::make_shared<F>(args...);
+        const std::size_t bytes = made->bytes();
+        return std::static_pointer_cast<const F>(insert(slot, std::move(made), bytes));
+    }
+
+    template <typename T>
+    std::shared_ptr<const CholeskyFactor<T>> update(const FactorKey& from, const FactorKey& to, MatrixView<const T> x,
+                                                    UpdateSign sign) {
+        const bool f64 = std::is_same_v<T, double>;
+        bool shared = false;
+        std::shared_ptr<void> old = take(detail::FactorSlot{from, FactorKind::Cholesky, f64}, shared);
+        if (!old) {
+            return nullptr;
+        }
+        auto cached = std::static_pointer_cast<CholeskyFactor<T>>(old);
+        auto f = shared ? std::make_shared<CholeskyFactor<T>>(*cached) : std::move(cached);
+        if (f->update(x, sign) != 0) {
+            return nullptr;
+        }
+        note_update();
+        const std::size_t bytes = f->bytes();
+        return std::static_pointer_cast<const CholeskyFactor<T>>(
+            insert(detail::FactorSlot{to, FactorKind::Cholesky, f64}, std::move(f), bytes));
+    }
+
+    /// Cached value under `slot`, marked most recently used; counts a hit
+    /// or a miss.
+    std::shared_ptr<void> find(const detail::FactorSlot& slot);
+    /// Caches `value` unless something is already under `slot` (then that
+    /// is returned instead) or it exceeds the budget, then evicts down to
+    /// the budget.
+    std::shared_ptr<void> insert(const detail::FactorSlot& slot, std::shared_ptr<void> value, std::size_t bytes);
+    /// Removes and returns the value under `slot`; `shared` tells whether
+    /// anyone outside the cache still holds it.
+    std::shared_ptr<void> take(const detail::FactorSlot& slot, bool& shared);
+    void note_update();
+
+    std::unique_ptr<detail::FactorCacheImpl> impl_;
+};
+
+}  // namespace lana
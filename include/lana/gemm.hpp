@@ -0,0 +1,124 @@
+#pragma once
+
+#include "lana/config.hpp"
+#include "lana/half.hpp"
+#include "lana/matrix.hpp"
+
+#include <string>
+#include <vector>
+
+namespace lana {
+
+/// Cache-blocking parameters of the GEMM engine.
+///
+/// `kc` sizes the packed B micro-panel for L1, `mc` the packed A block for L2
+/// and `nc` the packed B block for L3. A zero field means "derive from the
+/// cache sizes reported by the host".
+struct GemmBlocking {
+    index_t mc = 0;
+    index_t kc = 0;
+    index_t nc = 0;
+    /// Micro-kernel tile, one of gemm_tiles_f32() / gemm_tiles_f64(); zero
+    /// (or a tile the active ISA does not have) selects the ISA's default.
+    index_t mr = 0;
+    index_t nr = 0;
+    /// Threads that share one MC row block of a parallel GEMM, each taking
+    /// a slice of its NR panels. 1 gives every thread its own row block
+    /// while M allows; larger values trade A-packing work for B reuse.
+    int n_split = 0;
+};
+
+/// Returns the blocking currently used for `float` / `double` GEMM, with
+/// every zero field resolved to its host-derived value.
+LANA_API GemmBlocking gemm_blocking_f32();
+LANA_API GemmBlocking gemm_blocking_f64();
+
+/// Overrides the blocking for subsequent GEMM calls. Zero fields fall back
+/// to the host-derived default; values are rounded to micro-kernel multiples.
+LANA_API void set_gemm_blocking_f32(const GemmBlocking& b);
+LANA_API void set_gemm_blocking_f64(const GemmBlocking& b);
+
+struct GemmTile {
+    index_t mr = 0;
+    index_t nr = 0;
+};
+
+/// Micro-kernel tiles the active ISA offers, its default first.
+LANA_API std::vector<GemmTile> gemm_tiles_f32();
+LANA_API std::vector<GemmTile> gemm_tiles_f64();
+
+/// Per-machine tuning file.
+///
+/// On the first GEMM (or blocking query) the library reads the blocking
+/// written for this host by `lana_tune`: the path is `$LANA_TUNE_FILE`, or
+/// `$XDG_CACHE_HOME/lana/gemm_tuning.txt`, or `~/.cache/lana/gemm_tuning.txt`;
+/// an empty LANA_TUNE_FILE turns loading off. One file can hold entries
+/// for several machines (a shared home directory on a mixed fleet); each
+/// is keyed by gemm_tuning_host(). Explicit set_gemm_blocking_*() calls
+/// override what was loaded.
+LANA_API std::string gemm_tuning_path();
+
+/// "<cpu model>;<isa>", the key of this process's entry.
+LANA_API std::string gemm_tuning_host();
+
+/// Writes the current f32 and f64 overrides as this host's entry of the
+/// file at `path` (default: gemm_tuning_path()), keeping other hosts'
+/// entries. Throws IoError if the file cannot be written.
+LANA_API void save_gemm_tuning(const std::string& path = {});
+
+/// C = alpha * A * B + beta * C.
+///
+/// Operands are arbitrary strided views, so transposes and sub-blocks are
+/// expressed by passing `a.t()` or `a.block(...)`. When beta is zero C is
+/// not read. C must not alias A or B.
+LANA_API void gemm(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta,
+                   MatrixView<float> c);
+LANA_API void gemm(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+                   MatrixView<double> c);
+
+/// C = alpha * A * B + beta * C with 16-bit A and B and float C; products
+/// are accumulated in float. bfloat16 runs on the AVX512_BF16 dot-product
+/// instructions where the host has them; otherwise, and for half, operands
+/// are widened to float while they are packed, so memory traffic on A and
+/// B is still halved against a float GEMM. Blocking follows the f32 setting.
+LANA_API void gemm(float alpha, MatrixView<const bfloat16> a, MatrixView<const bfloat16> b, float beta,
+                   MatrixView<float> c);
+LANA_API void gemm(float alpha, MatrixView<const half> a, MatrixView<const half> b, float beta,
+                   MatrixView<float> c);
+
+/// Elementwise function applied by a GEMM epilogue. Gelu is the tanh
+/// approximation.
+enum class Activation { None, Relu, Sigmoid, Tanh, Gelu };
+
+/// Work folded into the GEMM's stores: once the product is complete,
+/// every element becomes c(i, j) = act(c(i, j) + row_bias[i] + col_bias[j])
+/// while its register tile is still in L1, so no second pass rereads C.
+/// Null biases are skipped.
+template <typename T>
+struct GemmEpilogue {
+    const T* row_bias = nullptr;  ///< c.rows() entries, or null
+    const T* col_bias = nullptr;  ///< c.cols() entries, or null
+    Activation act = Activation::None;
+};
+
+/// gemm followed by `epilogue`, fused into the micro-kernel loop.
+LANA_API void gemm(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta,
+                   MatrixView<float> c, const GemmEpilogue<float>& epilogue);
+LANA_API void gemm(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+                   MatrixView<double> c, const GemmEpilogue<double>& epilogue);
+
+/// Returns A * B as a new matrix.
+template <typename T>
+Matrix<T> matmul(MatrixView<const T> a, MatrixView<const T> b) {
+    detail::require_dims(a.cols() == b.rows(), "matmul");
+    Matrix<T> c(a.rows(), b.cols(), uninitialized);
+    gemm(T(1), a, b, T(0), c.view());
+    return c;
+}
+
+template <typename T>
+Matrix<T> matmul(const Matrix<T>& a, const Matrix<T>& b) {
+    return matmul<T>(a.view(), b.view());
+}
+
+}  // namespace lana
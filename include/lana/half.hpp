@@ -0,0 +1,116 @@
+#pragma once
+
+/// 16-bit floating-point storage types.
+///
+/// `bfloat16` is the upper half of an IEEE binary32 (8-bit exponent, 7-bit
+/// mantissa): the range of float at a quarter of the precision of half.
+/// `half` is IEEE binary16 (5-bit exponent, 10-bit mantissa). Both are
+/// storage formats: they convert implicitly to float for arithmetic, and
+/// from float only explicitly, rounding to nearest even. lana's mixed GEMM
+/// (gemm.hpp) reads them directly and accumulates in float.
+
+#include "lana/config.hpp"
+#include "lana/matrix.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+
+namespace lana {
+
+struct bfloat16 {
+    std::uint16_t bits;
+
+    bfloat16() = default;
+    constexpr explicit bfloat16(float f) noexcept : bits(round(f)) {}
+
+    constexpr operator float() const noexcept {  // NOLINT(google-explicit-constructor)
+        return std::bit_cast<float>(static_cast<std::uint32_t>(bits) << 16);
+    }
+
+    static constexpr bfloat16 from_bits(std::uint16_t b) noexcept {
+        bfloat16 h;
+        h.bits = b;
+        return h;
+    }
+
+private:
+    static constexpr std::uint16_t round(float f) noexcept {
+        const auto u = std::bit_cast<std::uint32_t>(f);
+        if ((u & 0x7fffffffu) > 0x7f800000u) {
+            return static_cast<std::uint16_t>((u >> 16) | 0x40u);  // quiet NaN
+        }
+        return static_cast<std::uint16_t>((u + 0x7fffu + ((u >> 16) & 1u)) >> 16);
+    }
+};
+
+struct half {
+    std::uint16_t bits;
+
+    half() = default;
+    constexpr explicit half(float f) noexcept : bits(round(f)) {}
+
+    constexpr operator float() const noexcept {  // NOLINT(google-explicit-constructor)
+        const std::uint32_t sign = static_cast<std::uint32_t>(bits & 0x8000u) << 16;
+        const std::uint32_t exp = (bits >> 10) & 0x1fu;
+        const std::uint32_t mant = bits & 0x3ffu;
+        if (exp == 0x1f) {
+            return std::bit_cast<float>(sign | 0x7f800000u | (mant << 13));
+        }
+        if (exp == 0) {
+            // Zero or subnormal: mant * 2^-24, exact in float.
+            return std::bit_cast<float>(sign | std::bit_cast<std::uint32_t>(static_cast<float>(mant) * 0x1p-24f));
+        }
+        return std::bit_cast<float>(sign | ((exp + 112) << 23) | (mant << 13));
+    }
+
+    static constexpr half from_bits(std::uint16_t b) noexcept {
+        half h;
+        h.bits = b;
+        return h;
+    }
+
+private:
+    static constexpr std::uint16_t round(float f) noexcept {
+        const auto x = std::bit_cast<std::uint32_t>(f);
+        const std::uint32_t sign = (x >> 16) & 0x8000u;
+        std::uint32_t ax = x & 0x7fffffffu;
+        if (ax >= 0x7f800000u) {
+            return static_cast<std::uint16_t>(sign | (ax > 0x7f800000u ? 0x7e00u : 0x7c00u));
+        }
+        if (ax >= 0x477ff000u) {  // rounds past 65504
+            return static_cast<std::uint16_t>(sign | 0x7c00u);
+        }
+        if (ax < 0x38800000u) {
+            // Below 2^-14: adding 0.5 puts the half ulp (2^-24) at the last
+            // float mantissa bit, so the FPU does the rounding.
+            const float shifted = std::bit_cast<float>(ax) + 0.5f;
+            return static_cast<std::uint16_t>(sign | (std::bit_cast<std::uint32_t>(shifted) - 0x3f000000u));
+        }
+        // Rebias the exponent (127 -> 15) and round the mantissa to 10 bits.
+        ax += 0xc8000fffu + ((ax >> 13) & 1u);
+        return static_cast<std::uint16_t>(sign | (ax >> 13));
+    }
+};
+
+/// dst = src elementwise, converting through float when either side is a
+/// 16-bit type; columns are converted in parallel.
+template <typename D, typename S>
+void convert(MatrixView<const S> src, MatrixView<D> dst) {
+    detail::require_dims(src.rows() == dst.rows() && src.cols() == dst.cols(), "convert");
+    const index_t grain = std::max<index_t>(1, (index_t(1) << 16) / std::max<index_t>(src.rows(), 1));
+    parallel_for(0, src.cols(), grain, [&](index_t lo, index_t hi) {
+        for (index_t j = lo; j < hi; ++j) {
+            for (index_t i = 0; i < src.rows(); ++i) {
+                if constexpr (sizeof(S) == 2 || sizeof(D) == 2) {
+                    dst(i, j) = D(static_cast<float>(src(i, j)));
+                } else {
+                    dst(i, j) = static_cast<D>(src(i, j));
+                }
+            }
+        }
+    });
+}
+
+}  // namespace lana
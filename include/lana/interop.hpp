@@ -0,0 +1,348 @@
+#pragma once
+
+/// Zero-copy exchange of matrices with other runtimes.
+///
+/// There are three formats, all of them plain C ABIs, so lana depends on
+/// none of the projects that define them:
+///
+///   - DLPack (DLTensor, DLManagedTensor), as NumPy, PyTorch, JAX and
+///     CuPy exchange through __dlpack__;
+///   - the Python buffer protocol, through BufferInfo, which carries the
+///     fields of a Py_buffer. With <Python.h> included first, Py_buffer
+///     converts directly;
+///   - the Arrow C data interface (ArrowArray, ArrowSchema): a
+///     fixed-size-list array, one list per matrix row.
+///
+/// The from_*() functions return views of the foreign memory. They throw
+/// DimensionError when it is not a 2-D (or 1-D, seen as one column) array of
+/// T in host memory, with strides that are whole elements. External keeps
+/// the producer's memory alive for as long as the view is used. The to_*()
+/// functions hand lana memory out the same way: a moved-in Matrix stays
+/// alive until the consumer releases it, and a view is lent, unowned.
+///
+///     // Python: capsule = a.__dlpack__()  ->  C++:
+///     lana::interop::External<double> a(managed);   // takes ownership
+///     lana::gemm(1.0, a.view(), b, 0.0, c);         // no copy in
+///     return lana::interop::to_dlpack(std::move(c_matrix));   // no copy out
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+// DLPack ABI v0.8, under dlpack.h's own include guard: either header may
+// come first and the other then adds nothing.
+#ifndef DLPACK_DLPACK_H_
+#define DLPACK_DLPACK_H_
+#define DLPACK_VERSION 80
+#define DLPACK_ABI_VERSION 1
+extern "C" {
+typedef enum {
+    kDLCPU = 1,
+    kDLCUDA = 2,
+    kDLCUDAHost = 3,
+    kDLOpenCL = 4,
+    kDLVulkan = 7,
+    kDLMetal = 8,
+    kDLVPI = 9,
+    kDLROCM = 10,
+    kDLROCMHost = 11,
+    kDLExtDev = 12,
+    kDLCUDAManaged = 13,
+    kDLOneAPI = 14,
+    kDLWebGPU = 15,
+    kDLHexagon = 16,
+} DLDeviceType;
+typedef struct {
+    DLDeviceType device_type;
+    int32_t device_id;
+} DLDevice;
+typedef enum {
+    kDLInt = 0U,
+    kDLUInt = 1U,
+    kDLFloat = 2U,
+    kDLOpaqueHandle = 3U,
+    kDLBfloat = 4U,
+    kDLComplex = 5U,
+    kDLBool = 6U,
+} DLDataTypeCode;
+typedef struct {
+    uint8_t code;
+    uint8_t bits;
+    uint16_t lanes;
+} DLDataType;
+typedef struct {
+    void* data;
+    DLDevice device;
+    int32_t ndim;
+    DLDataType dtype;
+    int64_t* shape;
+    int64_t* strides;  // in elements; null means row-major contiguous
+    uint64_t byte_offset;
+} DLTensor;
+typedef struct DLManagedTensor {
+    DLTensor dl_tensor;
+    void* manager_ctx;
+    void (*deleter)(struct DLManagedTensor* self);
+} DLManagedTensor;
+}
+#endif
+
+// Arrow C data interface, under the guard the Arrow specification sets.
+#ifndef ARROW_C_DATA_INTERFACE
+#define ARROW_C_DATA_INTERFACE
+#define ARROW_FLAG_DICTIONARY_ORDERED 1
+#define ARROW_FLAG_NULLABLE 2
+#define ARROW_FLAG_MAP_KEYS_SORTED 4
+extern "C" {
+struct ArrowSchema {
+    const char* format;
+    const char* name;
+    const char* metadata;
+    int64_t flags;
+    int64_t n_children;
+    struct ArrowSchema** children;
+    struct ArrowSchema* dictionary;
+    void (*release)(struct ArrowSchema*);
+    void* private_data;
+};
+struct ArrowArray {
+    int64_t length;
+    int64_t null_count;
+    int64_t offset;
+    int64_t n_buffers;
+    int64_t n_children;
+    const void** buffers;
+    struct ArrowArray** children;
+    struct ArrowArray* dictionary;
+    void (*release)(struct ArrowArray*);
+    void* private_data;
+};
+}
+#endif
+
+namespace lana::interop {
+
+/// A buffer-protocol buffer: the Py_buffer fields lana needs, with shape
+/// and strides (in bytes) held by value since a matrix has at most two
+/// dimensions. A 1-D buffer uses shape[0] and strides[0] only.
+struct BufferInfo {
+    void* buf = nullptr;
+    index_t itemsize = 0;
+    const char* format = nullptr;
+    int ndim = 0;
+    index_t shape[2] = {0, 0};
+    index_t strides[2] = {0, 0};
+    bool readonly = false;
+};
+
+namespace detail {
+
+/// A strided 2-D array of unknown element type.
+struct Strided {
+    void* data;
+    index_t rows;
+    index_t cols;
+    index_t row_stride;  // in elements
+    index_t col_stride;
+};
+
+/// The foreign layouts as Strided, after checking the element is a
+/// floating-point type of `bits` bits.
+LANA_API Strided dlpack_strided(const DLTensor& t, int bits);
+LANA_API Strided buffer_strided(const BufferInfo& b, int bits);
+LANA_API Strided arrow_strided(const ArrowArray& a, const ArrowSchema& s, int bits);
+
+template <typename T>
+MatrixView<T> as_view(const Strided& s) noexcept {
+    return MatrixView<T>(static_cast<T*>(s.data), s.rows, s.cols, s.row_stride, s.col_stride);
+}
+
+template <typename T>
+constexpr int bits_of() noexcept {
+    using V = std::remove_const_t<T>;
+    static_assert(std::is_same_v<V, float> || std::is_same_v<V, double>, "interop supports float and double");
+    return 8 * static_cast<int>(sizeof(V));
+}
+
+}  // namespace detail
+
+/// View of a DLPack tensor: shape {rows, cols} (or {rows}) with any
+/// element strides, in CPU or CUDA-pinned memory.
+template <typename T>
+MatrixView<T> from_dlpack(const DLTensor& t) {
+    return detail::as_view<T>(detail::dlpack_strided(t, detail::bits_of<T>()));
+}
+
+/// View of a buffer of format "d" or "f" (native or little-endian).
+template <typename T>
+MatrixView<T> from_buffer(const BufferInfo& b) {
+    return detail::as_view<T>(detail::buffer_strided(b, detail::bits_of<T>()));
+}
+
+/// The matrix whose row i is list i of a fixed-size-list array without
+/// nulls. Arrow memory is immutable, hence the const view.
+template <typename T>
+MatrixView<const T> from_arrow(const ArrowArray& a, const ArrowSchema& s) {
+    return detail::as_view<const T>(detail::arrow_strided(a, s, detail::bits_of<T>()));
+}
+
+/// Foreign memory held for the lifetime of the object, released through
+/// the producer's own callback.
+template <typename T>
+class External {
+public:
+    /// Takes ownership of `t`; throws, leaving it with the caller, if it is
+    /// not a host matrix of T.
+    explicit External(DLManagedTensor* t) : view_(from_dlpack<T>(t->dl_tensor)), dl_(t) {}
+
+    /// Moves the array and schema in, marking the originals released as
+    /// the Arrow spec requires. Arrow memory is immutable, so T should be
+    /// const.
+    External(ArrowArray* array, ArrowSchema* schema)
+        : view_(detail::as_view<T>(detail::arrow_strided(*array, *schema, detail::bits_of<T>()))),
+          array_(*array),
+          schema_(*schema) {
+        static_assert(std::is_const_v<T>, "Arrow memory is read-only; use External<const T>");
+        array->release = nullptr;
+        schema->release = nullptr;
+    }
+
+    ~External() { reset(); }
+    External(External&& other) noexcept
+        : view_(other.view_), dl_(other.dl_), array_(other.array_), schema_(other.schema_) {
+        other.dl_ = nullptr;
+        other.array_.release = nullptr;
+        other.schema_.release = nullptr;
+    }
+    External& operator=(External&& other) noexcept {
+        if (this != &other) {
+            reset();
+            view_ = other.view_;
+            dl_ = other.dl_;
+            array_ = other.array_;
+            schema_ = other.schema_;
+            other.dl_ = nullptr;
+            other.array_.release = nullptr;
+            other.schema_.release = nullptr;
+        }
+        return *this;
+    }
+    External(const External&) = delete;
+    External& operator=(const External&) = delete;
+
+    MatrixView<T> view() const noexcept { return view_; }
+    operator MatrixView<T>() const noexcept { return view_; }
+
+private:
+    void reset() noexcept {
+        if (dl_ != nullptr && dl_->deleter != nullptr) {
+            dl_->deleter(dl_);
+        }
+        dl_ = nullptr;
+        if (array_.release != nullptr) {
+            array_.release(&array_);
+        }
+        if (schema_.release != nullptr) {
+            schema_.release(&schema_);
+        }
+    }
+
+    MatrixView<T> view_;
+    DLManagedTensor* dl_ = nullptr;
+    ArrowArray array_{};
+    ArrowSchema schema_{};
+};
+
+/// A DLPack tensor owning `m`; its deleter frees the matrix.
+LANA_API DLManagedTensor* to_dlpack(Matrix<float>&& m);
+LANA_API DLManagedTensor* to_dlpack(Matrix<double>&& m);
+
+/// A DLPack tensor lending `v`, which must outlive the consumer's use; the
+/// deleter frees only the descriptor.
+LANA_API DLManagedTensor* to_dlpack(MatrixView<float> v);
+LANA_API DLManagedTensor* to_dlpack(MatrixView<double> v);
+
+/// Exports `m` as a fixed-size-list array with one list per column, the
+/// column-major storage being list-contiguous. Arrow readers therefore see
+/// the transpose; export `Matrix(v.t())` for a row per list. Fills the
+/// (unreleased) `array` and `schema`, which own the matrix until both are
+/// released.
+LANA_API void to_arrow(Matrix<float>&& m, ArrowArray* array, ArrowSchema* schema);
+LANA_API void to_arrow(Matrix<double>&& m, ArrowArray* array, ArrowSchema* schema);
+
+/// Buffer-protocol description of `v`, 2-D with byte strides, to be handed
+/// out by fill_buffer from an object that keeps `v`'s memory alive.
+LANA_API BufferInfo to_buffer(MatrixView<float> v, bool readonly = false);
+LANA_API BufferInfo to_buffer(MatrixView<double> v, bool readonly = false);
+
+#if defined(Py_PYTHON_H)
+static_assert(sizeof(Py_ssize_t) == sizeof(index_t), "Py_ssize_t and index_t differ");
+
+/// Py_buffer as BufferInfo; `b` must stay acquired while the memory is
+/// used. Request it with PyBUF_FORMAT, since a null format means bytes;
+/// null strides (PyBUF_ND) mean row-major contiguous.
+inline BufferInfo buffer_info(const Py_buffer& b) {
+    lana::detail::require_dims((b.ndim == 1 || b.ndim == 2) && b.shape != nullptr && b.suboffsets == nullptr,
+                               "interop::buffer_info");
+    BufferInfo info;
+    info.buf = b.buf;
+    info.itemsize = b.itemsize;
+    info.format = b.format != nullptr ? b.format : "B";
+    info.ndim = b.ndim;
+    info.readonly = b.readonly != 0;
+    for (int d = 0; d < b.ndim; ++d) {
+        info.shape[d] = b.shape[d];
+    }
+    if (b.strides != nullptr) {
+        for (int d = 0; d < b.ndim; ++d) {
+            info.strides[d] = b.strides[d];
+        }
+    } else {
+        info.strides[b.ndim - 1] = b.itemsize;
+        info.strides[0] = b.ndim == 2 ? b.itemsize * b.shape[1] : b.itemsize;
+    }
+    return info;
+}
+
+template <typename T>
+MatrixView<T> from_buffer(const Py_buffer& b) {
+    if constexpr (!std::is_const_v<T>) {
+        lana::detail::require_dims(b.readonly == 0, "interop::from_buffer (read-only buffer)");
+    }
+    return from_buffer<T>(buffer_info(b));
+}
+
+/// Fills `view` from `info` in a bf_getbuffer slot of `owner`; `info` must
+/// live as long as `owner`, for instance as one of its members.
+inline int fill_buffer(Py_buffer* view, PyObject* owner, const BufferInfo& info, int flags) {
+    if ((flags & PyBUF_WRITABLE) == PyBUF_WRITABLE && info.readonly) {
+        PyErr_SetString(PyExc_BufferError, "lana buffer is read-only");
+        view->obj = nullptr;
+        return -1;
+    }
+    if ((flags & PyBUF_STRIDES) != PyBUF_STRIDES) {
+        PyErr_SetString(PyExc_BufferError, "lana buffers are strided");
+        view->obj = nullptr;
+        return -1;
+    }
+    view->buf = info.buf;
+    view->obj = owner;
+    Py_INCREF(owner);
+    view->len = info.itemsize * info.shape[0] * (info.ndim > 1 ? info.shape[1] : 1);
+    view->itemsize = info.itemsize;
+    view->readonly = info.readonly ? 1 : 0;
+    view->ndim = info.ndim;
+    view->format = (flags & PyBUF_FORMAT) != 0 ? const_cast<char*>(info.format) : nullptr;
+    view->shape = const_cast<Py_ssize_t*>(info.shape);
+    view->strides = const_cast<Py_ssize_t*>(info.strides);
+    view->suboffsets = nullptr;
+    view->internal = nullptr;
+    return 0;
+}
+#endif
+
+}  // namespace lana::interop
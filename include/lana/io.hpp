@@ -0,0 +1,164 @@
+#pragma once
+
+/// lana binary matrix files.
+///
+/// A file is a 64-byte header, a set of named sections whose payloads each
+/// start on a 4 KiB boundary, and a section table at the end. A section is
+/// either a dense matrix (f32 or f64, column- or row-major, with a leading
+/// dimension) or a CSR matrix (int64 row pointers, int32 column indices,
+/// f32 or f64 values). Payloads are stored exactly as lana lays them out in
+/// memory, so MappedFile can hand out views straight into the mapping:
+/// opening a file costs one mmap and a table read, pages are faulted in as
+/// they are touched, and processes mapping the same file share the page
+/// cache instead of each holding a private copy.
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/sparse.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace lana {
+
+enum class Dtype : std::uint32_t { F32 = 1, F64 = 2 };
+
+enum class Layout : std::uint32_t { ColMajor = 0, RowMajor = 1 };
+
+enum class SectionKind : std::uint32_t { Dense = 1, Csr = 2 };
+
+struct SectionInfo {
+    std::string name;
+    SectionKind kind;
+    Dtype dtype;
+    Layout layout;  ///< dense sections only
+    index_t rows;
+    index_t cols;
+    index_t ld;   ///< dense sections only
+    index_t nnz;  ///< CSR sections only
+};
+
+namespace detail {
+class FileWriterImpl;
+}  // namespace detail
+
+/// Streams sections into a new lana file. The file is complete only after
+/// close() (or destruction) has written the section table; a writer that
+/// fails part-way leaves a file that readers reject.
+class LANA_API FileWriter {
+public:
+    /// Creates or truncates `path`. Throws IoError.
+    explicit FileWriter(const std::string& path);
+    ~FileWriter();
+
+    FileWriter(const FileWriter&) = delete;
+    FileWriter& operator=(const FileWriter&) = delete;
+
+    /// Appends a dense section. A contiguous row-major view is stored
+    /// row-major; anything else is written column-major with ld = rows.
+    /// Names are at most 47 bytes and must be unique within the file.
+    void add(const std::string& name, MatrixView<const float> a);
+    void add(const std::string& name, MatrixView<const double> a);
+
+    /// Appends a CSR section.
+    void add(const std::string& name, CsrView<float> a);
+    void add(const std::string& name, CsrView<double> a);
+
+    /// Writes the section table and closes the file. Throws IoError.
+    void close();
+
+private:
+    std::unique_ptr<detail::FileWriterImpl> impl_;
+};
+
+/// Writes a file holding a single dense section named "matrix".
+LANA_API void save(const std::string& path, MatrixView<const float> a);
+LANA_API void save(const std::string& path, MatrixView<const double> a);
+
+enum class MapAdvice {
+    Normal,
+    Sequential,  ///< aggressive readahead, pages dropped after use
+    Random,      ///< no readahead
+    WillNeed,    ///< start reading the whole file in the background
+};
+
+struct MapOptions {
+    MapAdvice advice = MapAdvice::Normal;
+    /// Fault every page in up front (MAP_POPULATE) rather than on first use.
+    bool populate = false;
+};
+
+/// Read-only mapping of a lana file.
+///
+/// Views returned by matrix() and csr() point into the mapping and stay
+/// valid while the MappedFile (or a MappedFile it was moved into) lives.
+/// Opening validates the header and section table and checks that every
+/// payload lies inside the file; it does not read the payloads, so CSR
+/// arrays are trusted as written (copy into a Csr to validate them).
+class LANA_API MappedFile {
+public:
+    /// Maps `path`. Throws IoError if it cannot be opened or is not a
+    /// valid lana file.
+    explicit MappedFile(const std::string& path, MapOptions options = {});
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::vector<SectionInfo>& sections() const noexcept { return sections_; }
+    /// Section named `name`; throws IoError if there is none.
+    const SectionInfo& section(const std::string& name) const;
+    bool contains(const std::string& name) const noexcept;
+
+    /// Zero-copy view of a dense section. Throws IoError on a kind or dtype
+    /// mismatch.
+    MatrixView<const float> matrix_f32(const std::string& name) const;
+    MatrixView<const double> matrix_f64(const std::string& name) const;
+    template <typename T>
+    MatrixView<const T> matrix(const std::string& name) const;
+
+    /// Zero-copy view of a CSR section.
+    CsrView<float> csr_f32(const std::string& name) const;
+    CsrView<double> csr_f64(const std::string& name) const;
+    template <typename T>
+    CsrView<T> csr(const std::string& name) const;
+
+    /// Asks the kernel to read a section's pages ahead of use.
+    void prefetch(const std::string& name) const noexcept;
+
+    const std::byte* data() const noexcept { return base_; }
+    std::size_t size() const noexcept { return size_; }
+
+private:
+    const void* payload(const SectionInfo& s, int array) const noexcept;
+    const SectionInfo& expect(const std::string& name, SectionKind kind, Dtype dtype) const;
+
+    const std::byte* base_ = nullptr;
+    std::size_t size_ = 0;
+    std::vector<SectionInfo> sections_;
+    std::vector<std::uint64_t> offsets_;  // three per section
+};
+
+template <>
+inline MatrixView<const float> MappedFile::matrix<float>(const std::string& name) const {
+    return matrix_f32(name);
+}
+template <>
+inline MatrixView<const double> MappedFile::matrix<double>(const std::string& name) const {
+    return matrix_f64(name);
+}
+template <>
+inline CsrView<float> MappedFile::csr<float>(const std::string& name) const {
+    return csr_f32(name);
+}
+template <>
+inline CsrView<double> MappedFile::csr<double>(const std::string& name) const {
+    return csr_f64(name);
+}
+
+}  // namespace lana
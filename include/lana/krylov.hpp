@@ -0,0 +1,549 @@
+#pragma once
+
+/// Krylov solvers for A * x = b: CG (symmetric positive definite A),
+/// restarted GMRES and BiCGSTAB (general A).
+///
+/// A is anything modelling LinearOperator: a matrix type with rows(),
+/// cols() and an `spmv(alpha, a, x, beta, y)` overload found by
+/// argument-dependent lookup. Csr, CsrView, Csc and Bsr qualify as they
+/// are; FunctionOperator wraps a callable for matrix-free use. The solvers
+/// only call spmv with alpha = 1 and beta = 0.
+///
+/// A preconditioner M provides `apply(r, z)` computing z = M^-1 r. CG and
+/// BiCGSTAB apply it every iteration; GMRES preconditions on the right, so
+/// the residual it monitors is the true residual.
+///
+/// Every vector a solver needs comes from a Workspace (the caller's thread
+/// workspace unless Options::workspace says otherwise) under a Scope, and
+/// the parallel regions beneath it take their bookkeeping from the thread
+/// workspaces too, so on lana's own pool a solve allocates nothing once the
+/// workspaces have grown to its size. The preconditioners allocate only
+/// when they are built; a foreign executor (set_executor) may allocate for
+/// each task it is handed. Vector updates are
+/// single expression-template assignments (`p = z + beta * p`), which run
+/// as one fused lincomb pass rather than a chain of axpy calls.
+
+#include "lana/blas1.hpp"
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/expr.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/matrix.hpp"
+#include "lana/sparse.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/vector.hpp"
+#include "lana/workspace.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <concepts>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lana {
+
+template <typename A>
+concept LinearOperator =
+    requires(const A& a, typename A::value_type s, VectorView<const typename A::value_type> x,
+             VectorView<typename A::value_type> y) {
+        { a.rows() } -> std::convertible_to<index_t>;
+        { a.cols() } -> std::convertible_to<index_t>;
+        spmv(s, a, x, s, y);
+    };
+
+/// Matrix-free operator: f(x, y) must overwrite y with A * x.
+template <typename T, typename F>
+class FunctionOperator {
+public:
+    using value_type = T;
+
+    FunctionOperator(index_t rows, index_t cols, F f) : rows_(rows), cols_(cols), f_(std::move(f)) {}
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+
+    /// y = alpha * A * x; nonzero beta is not supported and throws Error.
+    friend void spmv(T alpha, const FunctionOperator& a, VectorView<const T> x, T beta, VectorView<T> y) {
+        detail::require_dims(x.size() == a.cols_ && y.size() == a.rows_, "spmv");
+        if (beta != T(0)) {
+            throw Error("lana: FunctionOperator spmv supports beta == 0 only");
+        }
+        a.f_(x, y);
+        if (alpha != T(1)) {
+            y *= alpha;
+        }
+    }
+
+private:
+    index_t rows_;
+    index_t cols_;
+    F f_;
+};
+
+template <typename T, typename F>
+FunctionOperator<T, F> make_operator(index_t rows, index_t cols, F f) {
+    return FunctionOperator<T, F>(rows, cols, std::move(f));
+}
+
+namespace detail {
+
+template <typename T>
+MatrixView<T> as_column(VectorView<T> v) noexcept {
+    return MatrixView<T>(v.data(), v.size(), 1, v.stride(), v.size() * v.stride());
+}
+
+/// r = b - A * x, with A * x formed in r.
+template <LinearOperator A, typename T>
+void residual(const A& a, VectorView<const T> b, VectorView<const T> x, VectorView<T> r) {
+    spmv(T(1), a, x, T(0), r);
+    r = b - r;
+}
+
+template <typename T, typename A>
+void check_system(const A& a, VectorView<const T> b, VectorView<T> x, const char* what) {
+    require_dims(a.rows() == a.cols() && b.size() == a.rows() && x.size() == a.cols(), what);
+}
+
+}  // namespace detail
+
+namespace krylov {
+
+template <typename M, typename T>
+concept Preconditioner = requires(const M& m, VectorView<const T> r, VectorView<T> z) { m.apply(r, z); };
+
+struct Options {
+    /// Converged once ||b - A x|| <= max(rtol * ||b||, atol).
+    double rtol = 1e-8;
+    double atol = 0;
+    /// Iteration cap; one iteration is one product with A.
+    index_t max_iterations = 1000;
+    /// GMRES basis size between restarts.
+    index_t restart = 30;
+    /// Scratch source; nullptr means thread_workspace().
+    Workspace* workspace = nullptr;
+};
+
+struct Result {
+    bool converged = false;
+    index_t iterations = 0;
+    /// Final ||b - A x|| as tracked by the method's recurrence.
+    double residual_norm = 0;
+};
+
+/// M = I.
+struct Identity {
+    template <typename T>
+    void apply(VectorView<const T> r, VectorView<T> z) const {
+        z.assign(r);
+    }
+};
+
+/// M = diag(A).
+template <typename T>
+class Jacobi {
+public:
+    /// Throws Error if a diagonal entry is missing or zero.
+    explicit Jacobi(CsrView<T> a) : inv_(a.rows(), uninitialized) {
+        detail::require_dims(a.rows() == a.cols(), "Jacobi");
+        for (index_t i = 0; i < a.rows(); ++i) {
+            T d = T(0);
+            for (index_t k = a.row_ptr()[i]; k < a.row_ptr()[i + 1]; ++k) {
+                if (a.col_idx()[k] == i) {
+                    d = a.values()[k];
+                }
+            }
+            if (d == T(0)) {
+                throw Error("lana: Jacobi needs a nonzero diagonal");
+            }
+            inv_[i] = T(1) / d;
+        }
+    }
+
+    void apply(VectorView<const T> r, VectorView<T> z) const { z = cwise_mul(inv_, r); }
+
+private:
+    Vector<T> inv_;
+};
+
+/// Incomplete LU with no fill: L * U restricted to the pattern of A, with
+/// L unit lower triangular. Building it is sequential; apply() is a forward
+/// and a backward sweep over the factor.
+template <typename T>
+class Ilu0 {
+public:
+    /// Throws Error if a pivot is missing or becomes zero.
+    explicit Ilu0(CsrView<T> a) : lu_(a), diag_(static_cast<std::size_t>(a.rows())) {
+        detail::require_dims(a.rows() == a.cols(), "Ilu0");
+        const index_t n = a.rows();
+        const index_t* ptr = lu_.row_ptr().data();
+        const sparse_index_t* col = lu_.col_idx().data();
+        T* val = lu_.values().data();
+        // pos[j]: position of column j in the current row, or -1.
+        std::vector<index_t> pos(static_cast<std::size_t>(n), -1);
+        for (index_t i = 0; i < n; ++i) {
+            index_t d = -1;
+            for (index_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                pos[static_cast<std::size_t>(col[k])] = k;
+                if (col[k] == i) {
+                    d = k;
+                }
+            }
+            if (d < 0) {
+                throw Error("lana: Ilu0 needs every diagonal entry in the pattern");
+            }
+            for (index_t k = ptr[i]; k < d; ++k) {
+                const index_t p = col[k];
+                const T lik = val[k] / val[diag_[static_cast<std::size_t>(p)]];
+                val[k] = lik;
+                for (index_t q = diag_[static_cast<std::size_t>(p)] + 1; q < ptr[p + 1]; ++q) {
+                    if (const index_t at = pos[static_cast<std::size_t>(col[q])]; at >= 0) {
+                        val[at] -= lik * val[q];
+                    }
+                }
+            }
+            if (val[d] == T(0)) {
+                throw Error("lana: zero pivot in Ilu0");
+            }
+            diag_[static_cast<std::size_t>(i)] = d;
+            for (index_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+                pos[static_cast<std::size_t>(col[k])] = -1;
+            }
+        }
+    }
+
+    void apply(VectorView<const T> r, VectorView<T> z) const {
+        const index_t n = lu_.rows();
+        const index_t* ptr = lu_.row_ptr().data();
+        const sparse_index_t* col = lu_.col_idx().data();
+        const T* val = lu_.values().data();
+        for (index_t i = 0; i < n; ++i) {
+            T s = r[i];
+            for (index_t k = ptr[i]; k < diag_[static_cast<std::size_t>(i)]; ++k) {
+                s -= val[k] * z[col[k]];
+            }
+            z[i] = s;
+        }
+        for (index_t i = n - 1; i >= 0; --i) {
+            const index_t d = diag_[static_cast<std::size_t>(i)];
+            T s = z[i];
+            for (index_t k = d + 1; k < ptr[i + 1]; ++k) {
+                s -= val[k] * z[col[k]];
+            }
+            z[i] = s / val[d];
+        }
+    }
+
+    /// The factors, L strictly below and U on and above the diagonal.
+    const Csr<T>& factors() const noexcept { return lu_; }
+
+private:
+    Csr<T> lu_;
+    std::vector<index_t> diag_;
+};
+
+/// M = the block diagonal of A in blocks of `block` consecutive rows (the
+/// last may be smaller), each LU-factored with partial pivoting. apply()
+/// solves the blocks in parallel.
+template <typename T>
+class BlockJacobi {
+public:
+    /// Throws Error if a diagonal block is singular.
+    BlockJacobi(CsrView<T> a, index_t block)
+        : n_(a.rows()),
+          bs_(std::max<index_t>(block, 1)),
+          lu_(static_cast<std::size_t>((n_ + bs_ - 1) / bs_ * bs_ * bs_), T(0)),
+          ipiv_(static_cast<std::size_t>((n_ + bs_ - 1) / bs_ * bs_)) {
+        detail::require_dims(a.rows() == a.cols(), "BlockJacobi");
+        const index_t nblocks = (n_ + bs_ - 1) / bs_;
+        std::int32_t singular = 0;
+        parallel_for(0, nblocks, 1, [&](index_t lo, index_t hi) {
+            for (index_t b = lo; b < hi; ++b) {
+                const index_t r0 = b * bs_;
+                const index_t m = std::min(bs_, n_ - r0);
+                const MatrixView<T> blk = block_view(b);
+                for (index_t i = 0; i < m; ++i) {
+                    for (index_t k = a.row_ptr()[r0 + i]; k < a.row_ptr()[r0 + i + 1]; ++k) {
+                        const index_t j = a.col_idx()[k] - r0;
+                        if (j >= 0 && j < m) {
+                            blk(i, j) = a.values()[k];
+                        }
+                    }
+                }
+                if (getrf(blk, ipiv_.data() + r0) != 0) {
+                    std::atomic_ref<std::int32_t>(singular).store(1, std::memory_order_relaxed);
+                }
+            }
+        });
+        if (singular != 0) {
+            throw Error("lana: singular diagonal block in BlockJacobi");
+        }
+    }
+
+    void apply(VectorView<const T> r, VectorView<T> z) const {
+        const index_t nblocks = (n_ + bs_ - 1) / bs_;
+        const index_t grain = std::max<index_t>(1, (index_t(1) << 14) / (bs_ * bs_));
+        parallel_for(0, nblocks, grain, [&](index_t lo, index_t hi) {
+            for (index_t b = lo; b < hi; ++b) {
+                const index_t r0 = b * bs_;
+                const index_t m = std::min(bs_, n_ - r0);
+                const MatrixView<const T> lu = block_view(b);
+                const std::int32_t* ipiv = ipiv_.data() + r0;
+                for (index_t i = 0; i < m; ++i) {
+                    z[r0 + i] = r[r0 + i];
+                }
+                for (index_t i = 0; i < m; ++i) {
+                    if (ipiv[i] != i) {
+                        std::swap(z[r0 + i], z[r0 + ipiv[i]]);
+                    }
+                }
+                for (index_t j = 0; j < m; ++j) {
+                    const T x = z[r0 + j];
+                    for (index_t i = j + 1; i < m; ++i) {
+                        z[r0 + i] -= lu(i, j) * x;
+                    }
+                }
+                for (index_t j = m - 1; j >= 0; --j) {
+                    const T x = z[r0 + j] /= lu(j, j);
+                    for (index_t i = 0; i < j; ++i) {
+                        z[r0 + i] -= lu(i, j) * x;
+                    }
+                }
+            }
+        });
+    }
+
+    index_t block_size() const noexcept { return bs_; }
+
+private:
+    MatrixView<T> block_view(index_t b) {
+        const index_t m = std::min(bs_, n_ - b * bs_);
+        return MatrixView<T>(lu_.data() + b * bs_ * bs_, m, m, 1, m);
+    }
+    MatrixView<const T> block_view(index_t b) const {
+        const index_t m = std::min(bs_, n_ - b * bs_);
+        return MatrixView<const T>(lu_.data() + b * bs_ * bs_, m, m, 1, m);
+    }
+
+    index_t n_;
+    index_t bs_;
+    std::vector<T> lu_;  // block b at b * bs * bs, column-major with ld = its size
+    std::vector<std::int32_t> ipiv_;
+};
+
+
+/// Preconditioned conjugate gradients; A and M must be symmetric positive
+/// definite. `x` holds the initial guess on entry.
+template <LinearOperator A, typename T, typename M = Identity>
+    requires Preconditioner<M, T>
+Result cg(const A& a, VectorView<const T> b, VectorView<T> x, const M& m = {}, const Options& opts = {}) {
+    detail::check_system(a, b, x, "cg");
+    Workspace& ws = opts.workspace ? *opts.workspace : thread_workspace();
+    Workspace::Scope scope(ws);
+    const index_t n = b.size();
+    const VectorView<T> r = ws.vector<T>(n);
+    const VectorView<T> z = ws.vector<T>(n);
+    const VectorView<T> p = ws.vector<T>(n);
+    const VectorView<T> q = ws.vector<T>(n);
+
+    Result res;
+    const double target = std::max(opts.rtol * double(nrm2(b)), opts.atol);
+    detail::residual<A, T>(a, b, x, r);
+    res.residual_norm = nrm2(r);
+    if (res.residual_norm <= target) {
+        res.converged = true;
+        return res;
+    }
+    m.apply(VectorView<const T>(r), z);
+    p.assign(z);
+    T rz = dot(r, z);
+    while (res.iterations < opts.max_iterations) {
+        spmv(T(1), a, VectorView<const T>(p), T(0), q);
+        ++res.iterations;
+        const T pq = dot(p, q);
+        if (pq == T(0)) {
+            break;
+        }
+        const T alpha = rz / pq;
+        x += alpha * p;
+        r -= alpha * q;
+        res.residual_norm = nrm2(r);
+        if (res.residual_norm <= target) {
+            res.converged = true;
+            break;
+        }
+        m.apply(VectorView<const T>(r), z);
+        const T rz_next = dot(r, z);
+        p = z + (rz_next / rz) * p;
+        rz = rz_next;
+    }
+    return res;
+}
+
+/// Right-preconditioned BiCGSTAB. `x` holds the initial guess on entry.
+/// Stops early, unconverged, on a breakdown (rho or omega reaching zero).
+template <LinearOperator A, typename T, typename M = Identity>
+    requires Preconditioner<M, T>
+Result bicgstab(const A& a, VectorView<const T> b, VectorView<T> x, const M& m = {}, const Options& opts = {}) {
+    detail::check_system(a, b, x, "bicgstab");
+    Workspace& ws = opts.workspace ? *opts.workspace : thread_workspace();
+    Workspace::Scope scope(ws);
+    const index_t n = b.size();
+    const VectorView<T> r = ws.vector<T>(n);
+    const VectorView<T> rhat = ws.vector<T>(n);
+    const VectorView<T> p = ws.vector<T>(n);
+    const VectorView<T> v = ws.vector<T>(n);
+    const VectorView<T> s = ws.vector<T>(n);
+    const VectorView<T> t = ws.vector<T>(n);
+    const VectorView<T> phat = ws.vector<T>(n);
+    const VectorView<T> shat = ws.vector<T>(n);
+
+    Result res;
+    const double target = std::max(opts.rtol * double(nrm2(b)), opts.atol);
+    detail::residual<A, T>(a, b, x, r);
+    res.residual_norm = nrm2(r);
+    if (res.residual_norm <= target) {
+        res.converged = true;
+        return res;
+    }
+    rhat.assign(r);
+    std::fill_n(p.data(), n, T(0));
+    std::fill_n(v.data(), n, T(0));
+    T rho = T(1), alpha = T(1), omega = T(1);
+    while (res.iterations < opts.max_iterations) {
+        const T rho_next = dot(rhat, r);
+        if (rho_next == T(0)) {
+            break;
+        }
+        const T beta = (rho_next / rho) * (alpha / omega);
+        rho = rho_next;
+        p = r + beta * p - (beta * omega) * v;
+        m.apply(VectorView<const T>(p), phat);
+        spmv(T(1), a, VectorView<const T>(phat), T(0), v);
+        ++res.iterations;
+        alpha = rho / dot(rhat, v);
+        s = r - alpha * v;
+        res.residual_norm = nrm2(s);
+        if (res.residual_norm <= target) {
+            x += alpha * phat;
+            res.converged = true;
+            break;
+        }
+        if (res.iterations == opts.max_iterations) {
+            x += alpha * phat;
+            break;
+        }
+        m.apply(VectorView<const T>(s), shat);
+        spmv(T(1), a, VectorView<const T>(shat), T(0), t);
+        ++res.iterations;
+        const T tt = dot(t, t);
+        omega = tt == T(0) ? T(0) : dot(t, s) / tt;
+        x += alpha * phat + omega * shat;
+        r = s - omega * t;
+        res.residual_norm = nrm2(r);
+        if (res.residual_norm <= target) {
+            res.converged = true;
+            break;
+        }
+        if (omega == T(0)) {
+            break;
+        }
+    }
+    return res;
+}
+
+/// Right-preconditioned GMRES(restart) with classical Gram-Schmidt run
+/// twice: each orthogonalisation step is two GEMMs against the basis
+/// instead of one dot product per basis vector. `x` holds the initial guess
+/// on entry.
+template <LinearOperator A, typename T, typename M = Identity>
+    requires Preconditioner<M, T>
+Result gmres(const A& a, VectorView<const T> b, VectorView<T> x, const M& m = {}, const Options& opts = {}) {
+    detail::check_system(a, b, x, "gmres");
+    Workspace& ws = opts.workspace ? *opts.workspace : thread_workspace();
+    Workspace::Scope scope(ws);
+    const index_t n = b.size();
+    const index_t k = std::clamp<index_t>(opts.restart, 1, std::max<index_t>(n, 1));
+    const MatrixView<T> basis = ws.matrix<T>(n, k + 1);
+    const MatrixView<T> h = ws.matrix<T>(k + 1, k);
+    const VectorView<T> cs = ws.vector<T>(k);
+    const VectorView<T> sn = ws.vector<T>(k);
+    const VectorView<T> g = ws.vector<T>(k + 1);
+    const VectorView<T> h2 = ws.vector<T>(k + 1);
+    const VectorView<T> z = ws.vector<T>(n);
+    const auto v = [&](index_t j) { return VectorView<T>(basis.data() + j * n, n); };
+
+    Result res;
+    const double target = std::max(opts.rtol * double(nrm2(b)), opts.atol);
+    detail::residual<A, T>(a, b, x, v(0));
+    res.residual_norm = nrm2(v(0));
+    while (res.residual_norm > target && res.iterations < opts.max_iterations) {
+        const T beta = T(res.residual_norm);
+        v(0) *= T(1) / beta;
+        g[0] = beta;
+        index_t j = 0;
+        while (j < k && res.iterations < opts.max_iterations) {
+            m.apply(VectorView<const T>(v(j)), z);
+            const VectorView<T> w = v(j + 1);
+            spmv(T(1), a, VectorView<const T>(z), T(0), w);
+            ++res.iterations;
+            const MatrixView<const T> vj = basis.block(0, 0, n, j + 1);
+            const MatrixView<T> hj = h.block(0, j, j + 1, 1);
+            const MatrixView<T> h2j = detail::as_column(h2.segment(0, j + 1));
+            gemm(T(1), vj.t(), detail::as_column(VectorView<const T>(w)), T(0), hj);
+            gemm(T(-1), vj, MatrixView<const T>(hj), T(1), detail::as_column(w));
+            gemm(T(1), vj.t(), detail::as_column(VectorView<const T>(w)), T(0), h2j);
+            gemm(T(-1), vj, MatrixView<const T>(h2j), T(1), detail::as_column(w));
+            for (index_t i = 0; i <= j; ++i) {
+                h(i, j) += h2[i];
+            }
+            const T wnorm = nrm2(w);
+            h(j + 1, j) = wnorm;
+            if (wnorm != T(0)) {
+                w *= T(1) / wnorm;
+            }
+            for (index_t i = 0; i < j; ++i) {
+                const T t = cs[i] * h(i, j) + sn[i] * h(i + 1, j);
+                h(i + 1, j) = -sn[i] * h(i, j) + cs[i] * h(i + 1, j);
+                h(i, j) = t;
+            }
+            const T d = std::hypot(h(j, j), h(j + 1, j));
+            cs[j] = d == T(0) ? T(1) : h(j, j) / d;
+            sn[j] = d == T(0) ? T(0) : h(j + 1, j) / d;
+            h(j, j) = d;
+            h(j + 1, j) = T(0);
+            g[j + 1] = -sn[j] * g[j];
+            g[j] = cs[j] * g[j];
+            res.residual_norm = std::abs(double(g[j + 1]));
+            ++j;
+            if (res.residual_norm <= target || wnorm == T(0)) {
+                break;
+            }
+        }
+        // x += M^-1 * V * y with H * y = g.
+        for (index_t i = j - 1; i >= 0; --i) {
+            T s = g[i];
+            for (index_t q = i + 1; q < j; ++q) {
+                s -= h(i, q) * g[q];
+            }
+            g[i] = h(i, i) == T(0) ? T(0) : s / h(i, i);
+        }
+        const VectorView<T> u = v(k);
+        gemm(T(1), MatrixView<const T>(basis.block(0, 0, n, j)),
+             detail::as_column(VectorView<const T>(g.segment(0, j))), T(0), detail::as_column(u));
+        m.apply(VectorView<const T>(u), z);
+        x += z;
+        if (res.residual_norm <= target || res.iterations >= opts.max_iterations) {
+            break;
+        }
+        detail::residual<A, T>(a, b, x, v(0));
+        res.residual_norm = nrm2(v(0));
+    }
+    res.converged = res.residual_norm <= target;
+    return res;
+}
+
+}  // namespace krylov
+}  // namespace lana
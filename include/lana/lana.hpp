@@ -0,0 +1,33 @@
+#pragma once
+
+/// Umbrella header: includes the whole public lana API.
+
+#include "lana/async.hpp"
+#include "lana/batched.hpp"
+#include "lana/blas1.hpp"
+#include "lana/config.hpp"
+#include "lana/cpu.hpp"
+#include "lana/device.hpp"
+#include "lana/eigen.hpp"
+#include "lana/error.hpp"
+#include "lana/expr.hpp"
+#include "lana/factor.hpp"
+#include "lana/factor_cache.hpp"
+#include "lana/gemm.hpp"
+#include "lana/half.hpp"
+#include "lana/interop.hpp"
+#include "lana/io.hpp"
+#include "lana/krylov.hpp"
+#include "lana/lazy.hpp"
+#include "lana/matrix.hpp"
+#include "lana/memory.hpp"
+#include "lana/profile.hpp"
+#include "lana/solve_queue.hpp"
+#include "lana/sparse.hpp"
+#include "lana/sparse_factor.hpp"
+#include "lana/stream.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/tiled.hpp"
+#include "lana/vector.hpp"
+#include "lana/warmup.hpp"
+#include "lana/workspace.hpp"
@@ -0,0 +1,268 @@
+#pragma once
+
+/// Deferred evaluation of whole pipelines.
+///
+/// Operations on lazy::Expr build a DAG instead of computing anything;
+/// eval() optimizes the graph and then runs it:
+///
+///   - transposes are pushed down to the inputs, where they are free
+///     (strided views), so `t(A * B)` runs as `t(B) * t(A)`;
+///   - chains of products are re-associated to the cheapest order, so
+///     `(A * B) * v` runs as `A * (B * v)`;
+///   - bias and activation on a product (and a matrix added to it) are
+///     fused into the GEMM epilogue, so its output is written once;
+///   - every other elementwise subtree runs as one pass over its inputs.
+///
+///     auto x = lazy::ref(a), w = lazy::ref(w0);
+///     auto y = lazy::relu(lazy::add_bias(w * t(x), b));   // nothing runs yet
+///     Matrix<float> out = lazy::eval(y);
+///
+/// A node used twice (the same Expr object reused) is evaluated once. The
+/// graph holds views of its inputs, which must outlive the Expr and must not
+/// alias the destination of eval_into().
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/gemm.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace lana::lazy {
+
+namespace detail {
+
+enum class Kind { Input, Transpose, Product, Add, Scale, CwiseMul, Activate, Bias, Sum };
+
+/// One graph node; children are shared so a subexpression can feed several
+/// consumers.
+template <typename T>
+struct Node {
+    Kind kind = Kind::Input;
+    index_t rows = 0;
+    index_t cols = 0;
+    std::shared_ptr<const Node> lhs;
+    std::shared_ptr<const Node> rhs;
+    MatrixView<const T> input;           // Input
+    T scale = T(1);                      // Scale
+    Activation act = Activation::None;   // Activate
+    VectorView<const T> bias;            // Bias
+    bool per_row = true;                 // Bias: one entry per row (else per column)
+    bool transposed = false;             // Input reached through a transpose
+};
+
+}  // namespace detail
+
+/// Handle to a node of a deferred computation. Copies share the node.
+template <typename T>
+class Expr {
+public:
+    using value_type = T;
+    using node_type = detail::Node<T>;
+
+    explicit Expr(std::shared_ptr<const node_type> node) noexcept : node_(std::move(node)) {}
+
+    index_t rows() const noexcept { return node_->rows; }
+    index_t cols() const noexcept { return node_->cols; }
+    const std::shared_ptr<const node_type>& node() const noexcept { return node_; }
+
+private:
+    std::shared_ptr<const node_type> node_;
+};
+
+namespace detail {
+
+template <typename T>
+Expr<T> make(Node<T> n) {
+    return Expr<T>(std::make_shared<const Node<T>>(std::move(n)));
+}
+
+template <typename T>
+Expr<T> binary(Kind kind, const Expr<T>& a, const Expr<T>& b, index_t rows, index_t cols) {
+    Node<T> n;
+    n.kind = kind;
+    n.rows = rows;
+    n.cols = cols;
+    n.lhs = a.node();
+    n.rhs = b.node();
+    return make(std::move(n));
+}
+
+template <typename T>
+Expr<T> elementwise(Kind kind, const Expr<T>& a, const Expr<T>& b, const char* what) {
+    lana::detail::require_dims(a.rows() == b.rows() && a.cols() == b.cols(), what);
+    return binary(kind, a, b, a.rows(), a.cols());
+}
+
+}  // namespace detail
+
+/// Graph inputs. Vectors enter as n x 1 matrices.
+template <typename T>
+Expr<T> ref(MatrixView<const T> m) {
+    detail::Node<T> n;
+    n.rows = m.rows();
+    n.cols = m.cols();
+    n.input = m;
+    return detail::make(std::move(n));
+}
+template <typename T>
+Expr<T> ref(MatrixView<T> m) {
+    return ref(MatrixView<const T>(m));
+}
+template <typename T, index_t R, index_t C>
+Expr<T> ref(const Matrix<T, R, C>& m) {
+    return ref(m.view());
+}
+template <typename T>
+Expr<T> ref(VectorView<const T> v) {
+    return ref(MatrixView<const T>(v.data(), v.size(), 1, v.stride(), v.stride() * v.size()));
+}
+template <typename T>
+Expr<T> ref(VectorView<T> v) {
+    return ref(VectorView<const T>(v));
+}
+template <typename T>
+Expr<T> ref(const Vector<T>& v) {
+    return ref(v.view());
+}
+
+template <typename T>
+Expr<T> t(const Expr<T>& a) {
+    detail::Node<T> n;
+    n.kind = detail::Kind::Transpose;
+    n.rows = a.cols();
+    n.cols = a.rows();
+    n.lhs = a.node();
+    return detail::make(std::move(n));
+}
+
+/// Matrix product.
+template <typename T>
+Expr<T> operator*(const Expr<T>& a, const Expr<T>& b) {
+    lana::detail::require_dims(a.cols() == b.rows(), "lazy product");
+    return detail::binary(detail::Kind::Product, a, b, a.rows(), b.cols());
+}
+
+template <typename T>
+Expr<T> operator*(std::type_identity_t<T> s, const Expr<T>& a) {
+    detail::Node<T> n;
+    n.kind = detail::Kind::Scale;
+    n.rows = a.rows();
+    n.cols = a.cols();
+    n.lhs = a.node();
+    n.scale = s;
+    return detail::make(std::move(n));
+}
+template <typename T>
+Expr<T> operator*(const Expr<T>& a, std::type_identity_t<T> s) {
+    return s * a;
+}
+template <typename T>
+Expr<T> operator-(const Expr<T>& a) {
+    return T(-1) * a;
+}
+
+template <typename T>
+Expr<T> operator+(const Expr<T>& a, const Expr<T>& b) {
+    return detail::elementwise(detail::Kind::Add, a, b, "lazy add");
+}
+template <typename T>
+Expr<T> operator-(const Expr<T>& a, const Expr<T>& b) {
+    return detail::elementwise(detail::Kind::Add, a, -b, "lazy subtract");
+}
+
+/// Elementwise product.
+template <typename T>
+Expr<T> cwise_mul(const Expr<T>& a, const Expr<T>& b) {
+    return detail::elementwise(detail::Kind::CwiseMul, a, b, "lazy cwise_mul");
+}
+
+template <typename T>
+Expr<T> activate(const Expr<T>& a, Activation act) {
+    detail::Node<T> n;
+    n.kind = detail::Kind::Activate;
+    n.rows = a.rows();
+    n.cols = a.cols();
+    n.lhs = a.node();
+    n.act = act;
+    return detail::make(std::move(n));
+}
+template <typename T>
+Expr<T> relu(const Expr<T>& a) {
+    return activate(a, Activation::Relu);
+}
+template <typename T>
+Expr<T> sigmoid(const Expr<T>& a) {
+    return activate(a, Activation::Sigmoid);
+}
+template <typename T>
+Expr<T> tanh(const Expr<T>& a) {
+    return activate(a, Activation::Tanh);
+}
+template <typename T>
+Expr<T> gelu(const Expr<T>& a) {
+    return activate(a, Activation::Gelu);
+}
+
+/// a(i, j) + bias[i]: one entry per row, broadcast along the columns.
+template <typename T>
+Expr<T> add_bias(const Expr<T>& a, VectorView<const T> bias) {
+    lana::detail::require_dims(bias.size() == a.rows(), "lazy add_bias");
+    detail::Node<T> n;
+    n.kind = detail::Kind::Bias;
+    n.rows = a.rows();
+    n.cols = a.cols();
+    n.lhs = a.node();
+    n.bias = bias;
+    return detail::make(std::move(n));
+}
+template <typename T>
+Expr<T> add_bias(const Expr<T>& a, const Vector<T>& bias) {
+    return add_bias(a, bias.view());
+}
+
+/// Sum of all elements, as a 1 x 1 result.
+template <typename T>
+Expr<T> sum(const Expr<T>& a) {
+    detail::Node<T> n;
+    n.kind = detail::Kind::Sum;
+    n.rows = 1;
+    n.cols = 1;
+    n.lhs = a.node();
+    return detail::make(std::move(n));
+}
+template <typename T>
+Expr<T> dot(const Expr<T>& a, const Expr<T>& b) {
+    return sum(cwise_mul(a, b));
+}
+
+/// Optimizes and runs the graph into `dst` (e.rows() x e.cols()).
+LANA_API void eval_into(const Expr<float>& e, MatrixView<float> dst);
+LANA_API void eval_into(const Expr<double>& e, MatrixView<double> dst);
+
+template <typename T>
+Matrix<T> eval(const Expr<T>& e) {
+    Matrix<T> out(e.rows(), e.cols(), uninitialized);
+    eval_into(e, out.view());
+    return out;
+}
+
+/// Evaluates a 1 x 1 graph (a sum or dot) to its value.
+template <typename T>
+T eval_scalar(const Expr<T>& e) {
+    lana::detail::require_dims(e.rows() == 1 && e.cols() == 1, "lazy eval_scalar");
+    T v{};
+    eval_into(e, MatrixView<T>(&v, 1, 1, 1, 1));
+    return v;
+}
+
+/// The optimized plan eval() would run, one step per line; for checking
+/// what was reordered and fused.
+LANA_API std::string explain(const Expr<float>& e);
+LANA_API std::string explain(const Expr<double>& e);
+
+}  // namespace lana::lazy
@@ -0,0 +1,528 @@
+#pragma once
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/expr.hpp"
+#include "lana/memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+namespace lana {
+
+/// Non-owning view of a strided 2-D array.
+///
+/// Element (i, j) lives at `data()[i * row_stride() + j * col_stride()]`, so
+/// column-major, row-major, transposed and sub-block views all share one type.
+/// `T` may be const-qualified for read-only views.
+template <typename T>
+class MatrixView {
+public:
+    using value_type = std::remove_const_t<T>;
+
+    MatrixView() = default;
+    MatrixView(T* data, index_t rows, index_t cols, index_t row_stride, index_t col_stride) noexcept
+        : data_(data), rows_(rows), cols_(cols), rs_(row_stride), cs_(col_stride) {}
+
+    /// Column-major view with leading dimension `ld`.
+    MatrixView(T* data, index_t rows, index_t cols, index_t ld) noexcept
+        : MatrixView(data, rows, cols, 1, ld) {}
+
+    /// A mutable view converts to a read-only one.
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    MatrixView(const MatrixView<U>& other) noexcept
+        : MatrixView(other.data(), other.rows(), other.cols(), other.row_stride(), other.col_stride()) {}
+
+    T* data() const noexcept { return data_; }
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t row_stride() const noexcept { return rs_; }
+    index_t col_stride() const noexcept { return cs_; }
+    bool empty() const noexcept { return rows_ == 0 || cols_ == 0; }
+
+    T& operator()(index_t i, index_t j) const noexcept { return data_[i * rs_ + j * cs_]; }
+
+    /// Rows [i, i + r) and columns [j, j + c).
+    MatrixView block(index_t i, index_t j, index_t r, index_t c) const noexcept {
+        return MatrixView(data_ + i * rs_ + j * cs_, r, c, rs_, cs_);
+    }
+    MatrixView col(index_t j) const noexcept { return block(0, j, rows_, 1); }
+    MatrixView row(index_t i) const noexcept { return block(i, 0, 1, cols_); }
+
+    /// Transposed view; no data is moved.
+    MatrixView t() const noexcept { return MatrixView(data_, cols_, rows_, cs_, rs_); }
+
+    /// Writes an expression into the viewed elements. Assigning another view
+    /// rebinds instead; use assign() to copy through a view.
+    template <typename E>
+    const MatrixView& operator=(const expr::Base<E>& e) const {
+        assign(e);
+        return *this;
+    }
+    template <expr::Operand E>
+    void assign(const E& e) const {
+        static_assert(!std::is_const_v<T>, "cannot assign through a read-only view");
+        detail::assign_expr(data_, rows_, cols_, rs_, cs_, expr::as_expr(e));
+    }
+    template <expr::Operand E>
+    const MatrixView& operator+=(const E& e) const {
+        assign(*this + e);
+        return *this;
+    }
+    template <expr::Operand E>
+    const MatrixView& operator-=(const E& e) const {
+        assign(*this - e);
+        return *this;
+    }
+    const MatrixView& operator*=(value_type s) const {
+        assign(s * *this);
+        return *this;
+    }
+
+private:
+    T* data_ = nullptr;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t rs_ = 1;
+    index_t cs_ = 0;
+};
+
+/// Owning dense matrix, column-major, 64-byte aligned, with extents chosen
+/// at run time. (`Matrix<T, R, C>` with compile-time extents is below.)
+template <typename T>
+class Matrix<T, dynamic, dynamic> {
+    static_assert(std::is_trivially_copyable_v<T>, "lana::Matrix requires a trivially copyable element type");
+
+public:
+    using value_type = T;
+
+    Matrix() = default;
+
+    /// rows x cols matrix filled with zeros.
+    Matrix(index_t rows, index_t cols) : Matrix(rows, cols, uninitialized) { fill(T(0)); }
+
+    Matrix(index_t rows, index_t cols, T value) : Matrix(rows, cols, uninitialized) { fill(value); }
+
+    /// rows x cols matrix whose contents are indeterminate.
+    Matrix(index_t rows, index_t cols, Uninitialized)
+        : buf_(static_cast<std::size_t>(rows * cols)), rows_(rows), cols_(cols) {}
+
+    /// rows x cols matrix of zeros whose storage follows `policy` (see
+    /// AllocPolicy). With policy.first_touch the pool writes it column
+    /// range by column range, as the parallel kernels split their output.
+    /// Mapped storage reads as zeros already and only needs placing.
+    Matrix(index_t rows, index_t cols, const AllocPolicy& policy)
+        : Matrix(rows, cols, uninitialized, policy, policy.mapped() && policy.first_touch) {
+        if (policy.mapped()) {
+            return;
+        }
+        if (policy.first_touch) {
+            detail::first_touch(data(), bytes(), column_bytes(), true);
+        } else {
+            fill(T(0));
+        }
+    }
+
+    /// rows x cols matrix under `policy` whose contents are indeterminate;
+    /// with policy.first_touch its pages are already placed.
+    Matrix(index_t rows, index_t cols, Uninitialized, const AllocPolicy& policy)
+        : Matrix(rows, cols, uninitialized, policy, policy.first_touch) {}
+
+    /// Row-by-row initializer: `Matrix<double>{{1, 2}, {3, 4}}`.
+    Matrix(std::initializer_list<std::initializer_list<T>> rows)
+        : Matrix(static_cast<index_t>(rows.size()), rows.size() ? static_cast<index_t>(rows.begin()->size()) : 0,
+                 uninitialized) {
+        index_t i = 0;
+        for (const auto& r : rows) {
+            detail::require_dims(static_cast<index_t>(r.size()) == cols_, "Matrix initializer list");
+            index_t j = 0;
+            for (const T& v : r) {
+                (*this)(i, j++) = v;
+            }
+            ++i;
+        }
+    }
+
+    /// Deep copy of an arbitrary strided view.
+    explicit Matrix(MatrixView<const T> src) : Matrix(src.rows(), src.cols(), uninitialized) { copy_from(src); }
+
+    /// Evaluates an elementwise expression (see expr.hpp) in a single pass.
+    template <typename E>
+    Matrix(const expr::Base<E>& e)  // NOLINT(google-explicit-constructor)
+        : Matrix(e.self().rows(), e.self().cols(), uninitialized) {
+        view().assign(e);
+    }
+    template <typename E>
+    Matrix& operator=(const expr::Base<E>& e) {
+        if (rows_ != e.self().rows() || cols_ != e.self().cols()) {
+            *this = Matrix(e.self().rows(), e.self().cols(), uninitialized, alloc_policy());
+        }
+        view().assign(e);
+        return *this;
+    }
+    template <expr::Operand E>
+    Matrix& operator+=(const E& e) {
+        view() += e;
+        return *this;
+    }
+    template <expr::Operand E>
+    Matrix& operator-=(const E& e) {
+        view() -= e;
+        return *this;
+    }
+    Matrix& operator*=(T s) {
+        view() *= s;
+        return *this;
+    }
+
+    /// Copies keep the source's AllocPolicy; assignment keeps the target's.
+    Matrix(const Matrix& other) : Matrix(other.rows_, other.cols_, uninitialized, other.alloc_policy()) {
+        copy_from(other.view());
+    }
+    Matrix& operator=(const Matrix& other) {
+        if (this != &other) {
+            if (rows_ != other.rows_ || cols_ != other.cols_) {
+                *this = Matrix(other.rows_, other.cols_, uninitialized, alloc_policy());
+            }
+            copy_from(other.view());
+        }
+        return *this;
+    }
+    Matrix(Matrix&& other) noexcept
+        : buf_(std::move(other.buf_)), rows_(std::exchange(other.rows_, 0)), cols_(std::exchange(other.cols_, 0)) {}
+    Matrix& operator=(Matrix&& other) noexcept {
+        buf_ = std::move(other.buf_);
+        rows_ = std::exchange(other.rows_, 0);
+        cols_ = std::exchange(other.cols_, 0);
+        return *this;
+    }
+
+    T* data() noexcept { return buf_.data(); }
+    const T* data() const noexcept { return buf_.data(); }
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t size() const noexcept { return rows_ * cols_; }
+    index_t ld() const noexcept { return rows_; }
+    bool empty() const noexcept { return size() == 0; }
+    const AllocPolicy& alloc_policy() const noexcept { return buf_.policy(); }
+
+    T& operator()(index_t i, index_t j) noexcept { return data()[i + j * rows_]; }
+    const T& operator()(index_t i, index_t j) const noexcept { return data()[i + j * rows_]; }
+
+    MatrixView<T> view() noexcept { return MatrixView<T>(data(), rows_, cols_, 1, rows_); }
+    MatrixView<const T> view() const noexcept { return MatrixView<const T>(data(), rows_, cols_, 1, rows_); }
+    operator MatrixView<T>() noexcept { return view(); }
+    operator MatrixView<const T>() const noexcept { return view(); }
+
+    MatrixView<T> block(index_t i, index_t j, index_t r, index_t c) noexcept { return view().block(i, j, r, c); }
+    MatrixView<const T> block(index_t i, index_t j, index_t r, index_t c) const noexcept {
+        return view().block(i, j, r, c);
+    }
+    MatrixView<T> t() noexcept { return view().t(); }
+    MatrixView<const T> t() const noexcept { return view().t(); }
+
+    void fill(T value) noexcept { std::fill_n(data(), size(), value); }
+
+    /// Copies `src` into this matrix; shapes must agree.
+    void copy_from(MatrixView<const T> src) {
+        detail::require_dims(src.rows() == rows_ && src.cols() == cols_, "Matrix::copy_from");
+        if (src.row_stride() == 1 && src.col_stride() == rows_) {
+            if (size() > 0) {
+                std::memcpy(data(), src.data(), static_cast<std::size_t>(size()) * sizeof(T));
+            }
+            return;
+        }
+        for (index_t j = 0; j < cols_; ++j) {
+            for (index_t i = 0; i < rows_; ++i) {
+                (*this)(i, j) = src(i, j);
+            }
+        }
+    }
+
+    static Matrix identity(index_t n) {
+        Matrix m(n, n);
+        for (index_t i = 0; i < n; ++i) {
+            m(i, i) = T(1);
+        }
+        return m;
+    }
+
+private:
+    Matrix(index_t rows, index_t cols, Uninitialized, const AllocPolicy& policy, bool touch)
+        : buf_(static_cast<std::size_t>(rows * cols), policy), rows_(rows), cols_(cols) {
+        if (touch) {
+            detail::first_touch(data(), bytes(), column_bytes(), false);
+        }
+    }
+
+    std::size_t bytes() const noexcept { return static_cast<std::size_t>(size()) * sizeof(T); }
+    std::size_t column_bytes() const noexcept { return static_cast<std::size_t>(rows_) * sizeof(T); }
+
+    detail::AlignedBuffer<T> buf_;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+};
+
+/// Fixed-size matrix: R x C elements stored inline, column-major.
+///
+/// There is no heap allocation and no run-time size to check: the matrix is
+/// a trivially copyable value of R * C elements, products and solves below
+/// are unrolled loops the compiler sees through, and elementwise expressions
+/// assign without going through the dispatched kernels. view() (or the
+/// implicit conversion) hands it to any API taking a MatrixView, and
+/// `Matrix<T>(m.view())` copies it into a dynamic matrix.
+template <typename T, index_t R, index_t C>
+class Matrix {
+    static_assert(std::is_trivially_copyable_v<T>, "lana::Matrix requires a trivially copyable element type");
+    static_assert(R > 0 && C > 0, "lana::Matrix extents must both be positive or both be lana::dynamic");
+
+public:
+    using value_type = T;
+
+    /// Zero matrix.
+    constexpr Matrix() noexcept : data_{} {}
+
+    /// Matrix whose contents are indeterminate.
+    constexpr explicit Matrix(Uninitialized) noexcept {}
+
+    /// Row-by-row initializer: `Matrix<double, 2, 2>{{1, 2}, {3, 4}}`.
+    constexpr Matrix(std::initializer_list<std::initializer_list<T>> rows) : data_{} {
+        detail::require_dims(static_cast<index_t>(rows.size()) == R, "Matrix initializer list");
+        index_t i = 0;
+        for (const auto& r : rows) {
+            detail::require_dims(static_cast<index_t>(r.size()) == C, "Matrix initializer list");
+            index_t j = 0;
+            for (const T& v : r) {
+                (*this)(i, j++) = v;
+            }
+            ++i;
+        }
+    }
+
+    /// Copy of an R x C strided view.
+    explicit Matrix(MatrixView<const T> src) : Matrix(uninitialized) { copy_from(src); }
+
+    template <typename E>
+    Matrix(const expr::Base<E>& e)  // NOLINT(google-explicit-constructor)
+        : Matrix(uninitialized) {
+        detail::assign_fixed<R, C>(data_, e);
+    }
+    template <typename E>
+    Matrix& operator=(const expr::Base<E>& e) {
+        detail::assign_fixed<R, C>(data_, e);
+        return *this;
+    }
+    template <expr::Operand E>
+    Matrix& operator+=(const E& e) {
+        detail::assign_fixed<R, C>(data_, *this + e);
+        return *this;
+    }
+    template <expr::Operand E>
+    Matrix& operator-=(const E& e) {
+        detail::assign_fixed<R, C>(data_, *this - e);
+        return *this;
+    }
+    constexpr Matrix& operator*=(T s) noexcept {
+        LANA_UNROLL
+        for (index_t k = 0; k < R * C; ++k) {
+            data_[k] *= s;
+        }
+        return *this;
+    }
+
+    constexpr T* data() noexcept { return data_; }
+    constexpr const T* data() const noexcept { return data_; }
+    static constexpr index_t rows() noexcept { return R; }
+    static constexpr index_t cols() noexcept { return C; }
+    static constexpr index_t size() noexcept { return R * C; }
+    static constexpr index_t ld() noexcept { return R; }
+    static constexpr bool empty() noexcept { return false; }
+
+    constexpr T& operator()(index_t i, index_t j) noexcept { return data_[i + j * R]; }
+    constexpr const T& operator()(index_t i, index_t j) const noexcept { return data_[i + j * R]; }
+    /// Element k in storage (column-major) order; for R x 1 vectors, row k.
+    constexpr T& operator[](index_t k) noexcept { return data_[k]; }
+    constexpr const T& operator[](index_t k) const noexcept { return data_[k]; }
+
+    MatrixView<T> view() noexcept { return MatrixView<T>(data_, R, C, 1, R); }
+    MatrixView<const T> view() const noexcept { return MatrixView<const T>(data_, R, C, 1, R); }
+    operator MatrixView<T>() noexcept { return view(); }
+    operator MatrixView<const T>() const noexcept { return view(); }
+
+    MatrixView<T> block(index_t i, index_t j, index_t r, index_t c) noexcept { return view().block(i, j, r, c); }
+    MatrixView<const T> block(index_t i, index_t j, index_t r, index_t c) const noexcept {
+        return view().block(i, j, r, c);
+    }
+    MatrixView<T> t() noexcept { return view().t(); }
+    MatrixView<const T> t() const noexcept { return view().t(); }
+
+    /// Transposed copy; t() gives a view instead.
+    constexpr Matrix<T, C, R> transpose() const noexcept {
+        Matrix<T, C, R> r(uninitialized);
+        for (index_t j = 0; j < C; ++j) {
+            LANA_UNROLL
+            for (index_t i = 0; i < R; ++i) {
+                r(j, i) = (*this)(i, j);
+            }
+        }
+        return r;
+    }
+
+    constexpr void fill(T value) noexcept {
+        LANA_UNROLL
+        for (index_t k = 0; k < R * C; ++k) {
+            data_[k] = value;
+        }
+    }
+
+    /// Copies `src` into this matrix; shapes must agree.
+    void copy_from(MatrixView<const T> src) {
+        detail::require_dims(src.rows() == R && src.cols() == C, "Matrix::copy_from");
+        for (index_t j = 0; j < C; ++j) {
+            LANA_UNROLL
+            for (index_t i = 0; i < R; ++i) {
+                (*this)(i, j) = src(i, j);
+            }
+        }
+    }
+
+    static constexpr Matrix identity() noexcept {
+        static_assert(R == C, "identity() needs a square matrix");
+        Matrix m;
+        for (index_t i = 0; i < R; ++i) {
+            m(i, i) = T(1);
+        }
+        return m;
+    }
+
+private:
+    T data_[R * C];
+};
+
+/// Matrix product of fixed-size matrices (`*` between two dynamic operands
+/// stays reserved; use gemm or matmul there).
+template <typename T, index_t R, index_t K, index_t C>
+    requires(R != dynamic && K != dynamic && C != dynamic)
+constexpr Matrix<T, R, C> operator*(const Matrix<T, R, K>& a, const Matrix<T, K, C>& b) noexcept {
+    Matrix<T, R, C> c;
+    for (index_t j = 0; j < C; ++j) {
+        LANA_UNROLL
+        for (index_t p = 0; p < K; ++p) {
+            const T bpj = b(p, j);
+            LANA_UNROLL
+            for (index_t i = 0; i < R; ++i) {
+                c(i, j) += a(i, p) * bpj;
+            }
+        }
+    }
+    return c;
+}
+
+namespace detail {
+
+/// In-place LU with partial pivoting of a fixed N x N matrix; piv[k] is the
+/// row swapped with row k at step k. Returns false at an exactly zero pivot.
+template <typename T, index_t N>
+constexpr bool fixed_lu(Matrix<T, N, N>& a, index_t (&piv)[N]) noexcept {
+    for (index_t k = 0; k < N; ++k) {
+        index_t p = k;
+        T best = a(k, k) < T(0) ? -a(k, k) : a(k, k);
+        for (index_t i = k + 1; i < N; ++i) {
+            const T v = a(i, k) < T(0) ? -a(i, k) : a(i, k);
+            if (v > best) {
+                best = v;
+                p = i;
+            }
+        }
+        piv[k] = p;
+        if (best == T(0)) {
+            return false;
+        }
+        if (p != k) {
+            LANA_UNROLL
+            for (index_t j = 0; j < N; ++j) {
+                const T t = a(k, j);
+                a(k, j) = a(p, j);
+                a(p, j) = t;
+            }
+        }
+        const T inv = T(1) / a(k, k);
+        LANA_UNROLL
+        for (index_t i = k + 1; i < N; ++i) {
+            a(i, k) *= inv;
+        }
+        for (index_t j = k + 1; j < N; ++j) {
+            const T u = a(k, j);
+            LANA_UNROLL
+            for (index_t i = k + 1; i < N; ++i) {
+                a(i, j) -= a(i, k) * u;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace detail
+
+/// Determinant of a fixed-size square matrix (by LU with partial pivoting).
+template <typename T, index_t N>
+    requires(N != dynamic)
+constexpr T det(Matrix<T, N, N> a) noexcept {
+    index_t piv[N];
+    if (!detail::fixed_lu(a, piv)) {
+        return T(0);
+    }
+    T d = T(1);
+    for (index_t k = 0; k < N; ++k) {
+        d *= piv[k] == k ? a(k, k) : -a(k, k);
+    }
+    return d;
+}
+
+/// Solves A X = B for fixed-size A and B. Throws Error if A is singular.
+template <typename T, index_t N, index_t C>
+    requires(N != dynamic && C != dynamic)
+constexpr Matrix<T, N, C> solve(Matrix<T, N, N> a, Matrix<T, N, C> b) {
+    index_t piv[N];
+    if (!detail::fixed_lu(a, piv)) {
+        throw Error("lana: singular matrix in solve");
+    }
+    for (index_t j = 0; j < C; ++j) {
+        for (index_t k = 0; k < N; ++k) {
+            if (piv[k] != k) {
+                const T t = b(k, j);
+                b(k, j) = b(piv[k], j);
+                b(piv[k], j) = t;
+            }
+        }
+        // L y = P b, then U x = y.
+        for (index_t k = 0; k < N; ++k) {
+            const T y = b(k, j);
+            LANA_UNROLL
+            for (index_t i = k + 1; i < N; ++i) {
+                b(i, j) -= a(i, k) * y;
+            }
+        }
+        for (index_t k = N - 1; k >= 0; --k) {
+            b(k, j) /= a(k, k);
+            const T x = b(k, j);
+            LANA_UNROLL
+            for (index_t i = 0; i < k; ++i) {
+                b(i, j) -= a(i, k) * x;
+            }
+        }
+    }
+    return b;
+}
+
+/// Inverse of a fixed-size square matrix. Throws Error if it is singular.
+template <typename T, index_t N>
+    requires(N != dynamic)
+constexpr Matrix<T, N, N> inverse(const Matrix<T, N, N>& a) {
+    return solve(a, Matrix<T, N, N>::identity());
+}
+
+}  // namespace lana
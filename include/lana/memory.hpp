@@ -0,0 +1,175 @@
+#pragma once
+
+#include "lana/config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace lana {
+
+/// Tag selecting the constructor that leaves container storage uninitialized.
+struct Uninitialized {};
+inline constexpr Uninitialized uninitialized{};
+
+/// Allocates `bytes` bytes aligned to `alignment` (a power of two).
+/// Throws std::bad_alloc on failure; a zero-byte request returns nullptr.
+LANA_API void* aligned_alloc(std::size_t bytes, std::size_t alignment = default_alignment);
+
+/// Releases memory obtained from lana::aligned_alloc. Accepts nullptr.
+LANA_API void aligned_free(void* p) noexcept;
+
+/// Pages behind an allocation made under an AllocPolicy.
+enum class PageSize : std::uint8_t {
+    /// Ordinary allocation from the pooled allocator.
+    Default,
+    /// 2 MiB-aligned anonymous mapping with a transparent-huge-page hint
+    /// (madvise). The kernel may still use 4 KiB pages.
+    Transparent,
+    /// Explicit 2 MiB or 1 GiB pages (MAP_HUGETLB), which must have been
+    /// reserved, e.g. vm.nr_hugepages or hugepages= on the kernel command
+    /// line. Without a reservation the request falls back a size, down to
+    /// Transparent, unless AllocPolicy::strict.
+    Huge2M,
+    Huge1G,
+};
+
+/// Which NUMA nodes an allocation's pages may come from.
+enum class NumaPolicy : std::uint8_t {
+    /// The kernel's default: each page on the node of the thread that
+    /// first writes it.
+    Local,
+    /// Pages spread round-robin over every node, so that threads on all
+    /// sockets see the same average bandwidth.
+    Interleave,
+    /// Every page on AllocPolicy::node.
+    Bind,
+};
+
+/// How a large Matrix, TiledMatrix or Workspace gets its memory.
+///
+/// Page size and NUMA placement are fixed when the pages are first
+/// written, which for a matrix built by one thread means every page lands
+/// on that thread's node. `first_touch` has the pool write the pages
+/// instead, split the way lana's kernels hand out the same storage
+/// (columns of a Matrix, tiles of a TiledMatrix in storage order), so with
+/// a pinned pool (ThreadPoolOptions::pin_threads) each part starts out on
+/// the node of a thread that will compute on it. With Interleave or Bind
+/// the placement is decided by the policy and first touch only saves the
+/// single-threaded fill.
+///
+///     lana::AllocPolicy policy;
+///     policy.pages = lana::PageSize::Huge2M;
+///     policy.first_touch = true;
+///     lana::Matrix<double> c(n, n, policy);   // zeroed by the pool
+struct AllocPolicy {
+    PageSize pages = PageSize::Default;
+    NumaPolicy numa = NumaPolicy::Local;
+    /// Node for NumaPolicy::Bind.
+    int node = 0;
+    bool first_touch = false;
+    /// Throw std::bad_alloc rather than fall back when explicit huge
+    /// pages are not reserved or the NUMA policy cannot be applied.
+    bool strict = false;
+
+    /// Whether storage comes from a dedicated mapping rather than the
+    /// pooled allocator.
+    bool mapped() const noexcept { return pages != PageSize::Default || numa != NumaPolicy::Local; }
+
+    friend bool operator==(const AllocPolicy&, const AllocPolicy&) = default;
+};
+
+/// Allocates `bytes` bytes under `policy`, at least 64-byte aligned (page
+/// aligned when policy.mapped()). Mapped memory reads as zeros. Throws
+/// std::bad_alloc on failure; a zero-byte request returns nullptr.
+LANA_API void* policy_alloc(std::size_t bytes, const AllocPolicy& policy);
+
+/// Releases memory from policy_alloc; `bytes` and `policy` must match the
+/// request. Accepts nullptr.
+LANA_API void policy_free(void* p, std::size_t bytes, const AllocPolicy& policy) noexcept;
+
+/// Returns the calling thread's cached small blocks (see detail::pooled_alloc)
+/// to the system. Thread exit does this automatically.
+LANA_API void release_thread_cache() noexcept;
+
+namespace detail {
+
+/// Largest request served from the per-thread small-block cache.
+inline constexpr std::size_t pooled_max_bytes = std::size_t(64) << 10;
+
+/// 64-byte aligned allocation for container storage. Requests up to
+/// pooled_max_bytes are rounded to a power of two and recycled through a
+/// per-thread free list, so short-lived small matrices do not reach malloc.
+/// Blocks may be freed on any thread; `bytes` must match the request.
+LANA_API void* pooled_alloc(std::size_t bytes);
+LANA_API void pooled_free(void* p, std::size_t bytes) noexcept;
+
+/// Writes [p, p + bytes) from the pool: the range is cut into `unit`-byte
+/// pieces handed out as parallel_for(0, pieces, 1) does, and each task
+/// zeroes its pieces, or with `zero` unset writes one byte per page, which
+/// is enough to place pages that either read as zeros already or are
+/// about to be overwritten anyway.
+LANA_API void first_touch(void* p, std::size_t bytes, std::size_t unit, bool zero);
+
+/// Owning, uninitialized, 64-byte aligned array of trivially copyable T,
+/// allocated through pooled_alloc, or policy_alloc for a mapped policy.
+template <typename T>
+class AlignedBuffer {
+public:
+    AlignedBuffer() = default;
+    explicit AlignedBuffer(std::size_t n)
+        : data_(static_cast<T*>(pooled_alloc(n * sizeof(T)))), size_(n) {}
+    AlignedBuffer(std::size_t n, const AllocPolicy& policy)
+        : data_(static_cast<T*>(policy.mapped() ? policy_alloc(n * sizeof(T), policy) : pooled_alloc(n * sizeof(T)))),
+          size_(n),
+          policy_(policy) {}
+
+    AlignedBuffer(const AlignedBuffer&) = delete;
+    AlignedBuffer& operator=(const AlignedBuffer&) = delete;
+
+    AlignedBuffer(AlignedBuffer&& other) noexcept : data_(other.data_), size_(other.size_), policy_(other.policy_) {
+        other.data_ = nullptr;
+        other.size_ = 0;
+    }
+    AlignedBuffer& operator=(AlignedBuffer&& other) noexcept {
+        if (this != &other) {
+            release();
+            data_ = other.data_;
+            size_ = other.size_;
+            policy_ = other.policy_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+        }
+        return *this;
+    }
+
+    ~AlignedBuffer() { release(); }
+
+    /// Grows the buffer to hold at least `n` elements; contents are discarded.
+    void reserve_discard(std::size_t n) {
+        if (n > size_) {
+            *this = AlignedBuffer(n, policy_);
+        }
+    }
+
+    T* data() noexcept { return data_; }
+    const T* data() const noexcept { return data_; }
+    std::size_t size() const noexcept { return size_; }
+    const AllocPolicy& policy() const noexcept { return policy_; }
+
+private:
+    void release() noexcept {
+        if (policy_.mapped()) {
+            policy_free(data_, size_ * sizeof(T), policy_);
+        } else {
+            pooled_free(data_, size_ * sizeof(T));
+        }
+    }
+
+    T* data_ = nullptr;
+    std::size_t size_ = 0;
+    AllocPolicy policy_;
+};
+
+}  // namespace detail
+}  // namespace lana
@@ -0,0 +1,189 @@
+#pragma once
+
+/// Opt-in counters for lana's public kernels and its thread pool.
+///
+/// Profiling is off by default and then costs one relaxed load and branch
+/// per kernel call. Once on (set_enabled(true), or LANA_PROFILE=1 in the
+/// environment at the first kernel call), each call of a public kernel adds its count,
+/// flops, bytes moved and wall time to a per-thread table keyed by kernel,
+/// element type and size bucket, and the pool counts regions, tasks, steals
+/// and queue depth. snapshot() sums the tables of every thread.
+///
+/// Times are inclusive: a factorization's time includes the public GEMM
+/// and trsm calls it makes, and those calls are counted as well. Kernels
+/// called from inside lana's own tasks are not counted separately.
+///
+/// Markers: while profiling is on, every counted call is also bracketed by
+/// the hooks given to set_marker_hooks(), for Tracy zones, ITT tasks or
+/// similar. Builds with LANA_WITH_ITT emit ITT tasks (VTune) and builds
+/// with LANA_WITH_SDT emit USDT probes lana:kernel_begin/kernel_end
+/// (perf, bpftrace) without any hook.
+
+#include "lana/config.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lana {
+struct bfloat16;
+struct half;
+}  // namespace lana
+
+namespace lana::profile {
+
+namespace detail {
+
+/// `unknown` until the first enabled() reads LANA_PROFILE, so loading lana
+/// runs no initializer for it.
+enum class State : std::uint8_t { unknown, off, on };
+
+LANA_API extern std::atomic<State> enabled_state;
+
+/// Settles `unknown` from LANA_PROFILE; a set_enabled() that got there
+/// first wins.
+LANA_API bool enabled_from_env() noexcept;
+
+}  // namespace detail
+
+inline bool enabled() noexcept {
+    const detail::State s = detail::enabled_state.load(std::memory_order_relaxed);
+    if (s == detail::State::unknown) [[unlikely]] {
+        return detail::enabled_from_env();
+    }
+    return s == detail::State::on;
+}
+LANA_API void set_enabled(bool on) noexcept;
+
+/// Zeroes every counter. Calls in flight on other threads may land on
+/// either side of the reset.
+LANA_API void reset() noexcept;
+
+enum class Dtype : std::uint8_t { f32, f64, bf16, f16, other };
+
+LANA_API const char* dtype_name(Dtype d) noexcept;
+
+template <typename T>
+constexpr Dtype dtype_of() noexcept {
+    if constexpr (sizeof(T) == 4 && std::is_floating_point_v<T>) {
+        return Dtype::f32;
+    } else if constexpr (sizeof(T) == 8 && std::is_floating_point_v<T>) {
+        return Dtype::f64;
+    } else if constexpr (std::is_same_v<T, bfloat16>) {
+        return Dtype::bf16;
+    } else if constexpr (std::is_same_v<T, half>) {
+        return Dtype::f16;
+    } else {
+        return Dtype::other;
+    }
+}
+
+/// Totals for one kernel, element type and size bucket. The bucket holds
+/// calls whose size (the largest matrix dimension, or the vector length)
+/// is in [size_lo, size_hi].
+struct KernelCounters {
+    std::string kernel;
+    Dtype dtype = Dtype::other;
+    std::int64_t size_lo = 0;
+    std::int64_t size_hi = 0;
+    std::uint64_t calls = 0;
+    double flops = 0;
+    double bytes = 0;
+    double seconds = 0;
+};
+
+struct PoolCounters {
+    /// Parallel regions opened (parallel_run with two or more chunks).
+    std::uint64_t regions = 0;
+    /// Region chunks and detached jobs run by pool threads or helping callers.
+    std::uint64_t tasks = 0;
+    /// Tasks taken from another worker's deque.
+    std::uint64_t steals = 0;
+    /// Tasks handed in through the injection queue by non-pool threads.
+    std::uint64_t injected = 0;
+    /// Times a worker ran out of work and went to sleep.
+    std::uint64_t sleeps = 0;
+    /// Queue length right after each push: sum (for the mean) and maximum.
+    std::uint64_t pushes = 0;
+    std::uint64_t depth_sum = 0;
+    std::uint64_t depth_max = 0;
+};
+
+struct Snapshot {
+    /// Sorted by kernel, dtype and size.
+    std::vector<KernelCounters> kernels;
+    PoolCounters pool;
+    /// Calls not recorded because a thread's table was full.
+    std::uint64_t dropped = 0;
+};
+
+LANA_API Snapshot snapshot();
+
+/// Fixed-column text: one line per kernel counter (with GFLOP/s and bytes
+/// per flop), then the pool counters.
+LANA_API void write_report(std::ostream& os, const Snapshot& snap);
+
+/// Called around every counted kernel call while profiling is on, with the
+/// kernel's name (a string literal) and `user`. A null `begin` removes
+/// the hooks. Hooks run on the calling thread and must not call lana.
+struct MarkerHooks {
+    void (*begin)(const char* kernel, void* user) = nullptr;
+    void (*end)(const char* kernel, void* user) = nullptr;
+    void* user = nullptr;
+};
+
+LANA_API void set_marker_hooks(const MarkerHooks& hooks) noexcept;
+
+namespace detail {
+
+/// Interns a kernel name (a string literal) as a small id, once per call
+/// site: `static const int id = kernel_id("gemm");`.
+LANA_API int kernel_id(const char* name);
+
+LANA_API void record(int id, Dtype dtype, std::int64_t size, double flops, double bytes,
+                     std::chrono::steady_clock::duration elapsed) noexcept;
+LANA_API void marker_begin(int id) noexcept;
+LANA_API void marker_end(int id) noexcept;
+
+}  // namespace detail
+
+/// Counts one kernel call over its lifetime; does nothing unless profiling
+/// was on when it was constructed.
+class Scope {
+public:
+    Scope(int id, Dtype dtype, std::int64_t size, double flops, double bytes) noexcept {
+        if (enabled()) {
+            id_ = id;
+            dtype_ = dtype;
+            size_ = size;
+            flops_ = flops;
+            bytes_ = bytes;
+            detail::marker_begin(id);
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    ~Scope() {
+        if (id_ >= 0) {
+            detail::record(id_, dtype_, size_, flops_, bytes_, std::chrono::steady_clock::now() - start_);
+            detail::marker_end(id_);
+        }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    int id_ = -1;
+    Dtype dtype_ = Dtype::other;
+    std::int64_t size_ = 0;
+    double flops_ = 0;
+    double bytes_ = 0;
+    std::chrono::steady_clock::time_point start_;
+};
+
+}  // namespace lana::profile
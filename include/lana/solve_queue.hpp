@@ -0,0 +1,149 @@
+#pragma once
+
+/// Batching of independent solves against one factorization.
+///
+/// A single right-hand side makes a triangular solve BLAS-2: every element
+/// of the factor is read for two flops, so many threads solving one
+/// vector each are bound by memory bandwidth. A SolveQueue collects their
+/// requests instead and hands them to the factorization as the columns of
+/// one block, a BLAS-3 solve that reads the factor once for the whole
+/// batch:
+///
+///     lana::SolveQueue<double> queue(cache.lu(a.view()));
+///     auto done = queue.submit(b.view());   // from any thread
+///     done.wait();                          // b = A^-1 b
+///
+/// A batch is solved once its oldest request has waited `window`, once it
+/// holds max_batch right-hand sides, or on flush(). Requests keep arriving
+/// while a batch is being solved, so under load batches grow to whatever
+/// the solve time lets accumulate and the window only bounds the latency
+/// of a lone request.
+///
+/// Batches run on a thread owned by the queue (the solve itself uses the
+/// thread pool as usual), which also completes the futures, so their
+/// continuations and resumed coroutines run there.
+
+#include "lana/async.hpp"
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace lana {
+
+struct SolveQueueOptions {
+    /// Longest the oldest queued request waits for others to join it.
+    std::chrono::microseconds window{100};
+    /// Right-hand sides that send a batch off without waiting further; a
+    /// single request wider than this is solved on its own.
+    index_t max_batch = 256;
+};
+
+struct SolveQueueStats {
+    std::uint64_t requests = 0;
+    std::uint64_t batches = 0;
+    std::uint64_t columns = 0;  ///< right-hand sides solved
+    index_t largest_batch = 0;  ///< in right-hand sides
+};
+
+namespace detail {
+
+/// One queued right-hand side block, type-erased.
+struct SolveRequest {
+    void* data;
+    index_t cols;
+    index_t row_stride;
+    index_t col_stride;
+};
+
+class SolveBatcherImpl;
+
+/// The request queue and batching thread behind SolveQueue. `run` solves a
+/// batch of requests holding `cols` columns in all.
+class LANA_API SolveBatcher {
+public:
+    using Run = std::function<void(const std::vector<SolveRequest>& batch, index_t cols)>;
+
+    SolveBatcher(Run run, const SolveQueueOptions& options);
+    /// Solves whatever is still queued, then stops the thread.
+    ~SolveBatcher();
+
+    SolveBatcher(const SolveBatcher&) = delete;
+    SolveBatcher& operator=(const SolveBatcher&) = delete;
+
+    async::Future<void> push(const SolveRequest& request);
+    void flush();
+    SolveQueueStats stats() const;
+
+private:
+    std::unique_ptr<SolveBatcherImpl> impl_;
+};
+
+}  // namespace detail
+
+template <typename T>
+class SolveQueue {
+public:
+    /// Queue in front of `solver`, anything with rows() and
+    /// `solve(MatrixView<T>) const`: LuFactor, CholeskyFactor, SparseLu or
+    /// SparseCholesky, as handed out by FactorCache. The queue keeps it
+    /// alive.
+    template <typename Solver>
+    explicit SolveQueue(std::shared_ptr<const Solver> solver, const SolveQueueOptions& options = {})
+        : rows_(solver->rows()),
+          batcher_(
+              [solver, n = rows_](const std::vector<detail::SolveRequest>& batch, index_t cols) {
+                  if (batch.size() == 1) {
+                      solver->solve(view_of(batch.front(), n));
+                      return;
+                  }
+                  Matrix<T> block(n, cols, uninitialized);
+                  index_t c = 0;
+                  for (const detail::SolveRequest& r : batch) {
+                      block.view().block(0, c, n, r.cols).assign(view_of(r, n));
+                      c += r.cols;
+                  }
+                  solver->solve(block.view());
+                  c = 0;
+                  for (const detail::SolveRequest& r : batch) {
+                      view_of(r, n).assign(block.view().block(0, c, n, r.cols));
+                      c += r.cols;
+                  }
+              },
+              options) {}
+
+    /// Queues B = A^-1 * B in place. B must stay alive, and must not be
+    /// touched, until the future completes; it completes with the solver's
+    /// exception if the batch failed.
+    async::Future<void> submit(MatrixView<T> b) {
+        detail::require_dims(b.rows() == rows_, "SolveQueue::submit");
+        return batcher_.push({b.data(), b.cols(), b.row_stride(), b.col_stride()});
+    }
+    async::Future<void> submit(VectorView<T> b) {
+        return submit(MatrixView<T>(b.data(), b.size(), 1, b.stride(), b.size() * b.stride()));
+    }
+
+    /// Solves the queued requests now instead of waiting out the window.
+    /// Requests submitted later wait as usual.
+    void flush() { batcher_.flush(); }
+
+    index_t rows() const noexcept { return rows_; }
+    SolveQueueStats stats() const { return batcher_.stats(); }
+
+private:
+    static MatrixView<T> view_of(const detail::SolveRequest& r, index_t n) {
+        return MatrixView<T>(static_cast<T*>(r.data), n, r.cols, r.row_stride, r.col_stride);
+    }
+
+    index_t rows_;
+    detail::SolveBatcher batcher_;
+};
+
+}  // namespace lana
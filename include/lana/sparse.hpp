@@ -0,0 +1,484 @@
+#pragma once
+
+/// Sparse matrices: COO for assembly; CSR, CSC and BSR for computation.
+///
+/// Row and column indices are 32-bit (sparse_index_t); offsets into the
+/// nonzero arrays are index_t, so a matrix may hold more than 2^31 entries
+/// as long as each dimension fits in 32 bits. Compressed formats keep the
+/// entries of every row (CSR, BSR) or column (CSC) sorted and free of
+/// duplicates; converting from COO sums duplicates.
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace lana {
+
+using sparse_index_t = std::int32_t;
+
+template <typename T>
+class Csr;
+template <typename T>
+class Csc;
+
+namespace detail {
+
+inline void require_sparse_dims(index_t rows, index_t cols) {
+    constexpr index_t max = std::numeric_limits<sparse_index_t>::max();
+    if (rows < 0 || cols < 0 || rows > max || cols > max) {
+        throw DimensionError("lana: sparse dimensions must fit in 32-bit indices");
+    }
+}
+
+/// Compressed arrays along one axis: ptr has n_major + 1 entries.
+template <typename T>
+struct Compressed {
+    std::vector<index_t> ptr;
+    std::vector<sparse_index_t> idx;
+    std::vector<T> val;
+};
+
+/// Builds compressed storage from `nnz` entries given by major(k), minor(k)
+/// and value(k). Two stable counting sorts (by minor, then by major) leave
+/// every major slice sorted by minor; duplicates are then summed in place.
+template <typename T, typename Major, typename Minor, typename Value>
+Compressed<T> compress(index_t n_major, index_t n_minor, index_t nnz, Major major, Minor minor, Value value) {
+    const auto un = static_cast<std::size_t>(nnz);
+    std::vector<index_t> minor_ptr(static_cast<std::size_t>(n_minor) + 1, 0);
+    for (index_t k = 0; k < nnz; ++k) {
+        ++minor_ptr[static_cast<std::size_t>(minor(k)) + 1];
+    }
+    for (index_t j = 0; j < n_minor; ++j) {
+        minor_ptr[static_cast<std::size_t>(j) + 1] += minor_ptr[static_cast<std::size_t>(j)];
+    }
+    std::vector<index_t> by_minor(un);
+    for (index_t k = 0; k < nnz; ++k) {
+        by_minor[static_cast<std::size_t>(minor_ptr[static_cast<std::size_t>(minor(k))]++)] = k;
+    }
+
+    Compressed<T> out;
+    out.ptr.assign(static_cast<std::size_t>(n_major) + 1, 0);
+    for (index_t k = 0; k < nnz; ++k) {
+        ++out.ptr[static_cast<std::size_t>(major(k)) + 1];
+    }
+    for (index_t i = 0; i < n_major; ++i) {
+        out.ptr[static_cast<std::size_t>(i) + 1] += out.ptr[static_cast<std::size_t>(i)];
+    }
+    out.idx.resize(un);
+    out.val.resize(un);
+    std::vector<index_t> next(out.ptr.begin(), out.ptr.end() - 1);
+    for (index_t k : by_minor) {
+        const auto dst = static_cast<std::size_t>(next[static_cast<std::size_t>(major(k))]++);
+        out.idx[dst] = static_cast<sparse_index_t>(minor(k));
+        out.val[dst] = value(k);
+    }
+
+    // Merge duplicates and close the gaps.
+    index_t w = 0;
+    for (index_t i = 0; i < n_major; ++i) {
+        const index_t lo = out.ptr[static_cast<std::size_t>(i)];
+        const index_t hi = out.ptr[static_cast<std::size_t>(i) + 1];
+        out.ptr[static_cast<std::size_t>(i)] = w;
+        for (index_t k = lo; k < hi; ++k) {
+            const auto uk = static_cast<std::size_t>(k);
+            if (w > out.ptr[static_cast<std::size_t>(i)] && out.idx[static_cast<std::size_t>(w) - 1] == out.idx[uk]) {
+                out.val[static_cast<std::size_t>(w) - 1] += out.val[uk];
+            } else {
+                out.idx[static_cast<std::size_t>(w)] = out.idx[uk];
+                out.val[static_cast<std::size_t>(w)] = out.val[uk];
+                ++w;
+            }
+        }
+    }
+    out.ptr[static_cast<std::size_t>(n_major)] = w;
+    out.idx.resize(static_cast<std::size_t>(w));
+    out.val.resize(static_cast<std::size_t>(w));
+    return out;
+}
+
+/// Re-compresses (ptr, idx, val) along the other axis (CSR <-> CSC).
+template <typename T>
+Compressed<T> transpose_compressed(index_t n_major, index_t n_minor, const std::vector<index_t>& ptr,
+                                   const std::vector<sparse_index_t>& idx, const std::vector<T>& val) {
+    std::vector<sparse_index_t> major_of(idx.size());
+    for (index_t i = 0; i < n_major; ++i) {
+        std::fill(major_of.begin() + ptr[static_cast<std::size_t>(i)],
+                  major_of.begin() + ptr[static_cast<std::size_t>(i) + 1], static_cast<sparse_index_t>(i));
+    }
+    return compress<T>(
+        n_minor, n_major, static_cast<index_t>(idx.size()), [&](index_t k) { return idx[static_cast<std::size_t>(k)]; },
+        [&](index_t k) { return major_of[static_cast<std::size_t>(k)]; },
+        [&](index_t k) { return val[static_cast<std::size_t>(k)]; });
+}
+
+template <typename T>
+void validate_compressed(index_t n_major, index_t n_minor, const std::vector<index_t>& ptr,
+                         const std::vector<sparse_index_t>& idx, const std::vector<T>& val, const char* what) {
+    bool ok = ptr.size() == static_cast<std::size_t>(n_major) + 1 && ptr.front() == 0 && idx.size() == val.size() &&
+              ptr.back() == static_cast<index_t>(idx.size());
+    for (index_t i = 0; ok && i < n_major; ++i) {
+        const index_t lo = ptr[static_cast<std::size_t>(i)];
+        const index_t hi = ptr[static_cast<std::size_t>(i) + 1];
+        ok = lo <= hi;
+        for (index_t k = lo; ok && k < hi; ++k) {
+            const sparse_index_t j = idx[static_cast<std::size_t>(k)];
+            ok = j >= 0 && j < n_minor && (k == lo || idx[static_cast<std::size_t>(k) - 1] < j);
+        }
+    }
+    if (!ok) {
+        throw Error(std::string("lana: malformed ") + what + " arrays");
+    }
+}
+
+}  // namespace detail
+
+/// Coordinate (triplet) format for assembling a matrix entry by entry.
+template <typename T>
+class Coo {
+public:
+    using value_type = T;
+
+    Coo() = default;
+    Coo(index_t rows, index_t cols) : rows_(rows), cols_(cols) { detail::require_sparse_dims(rows, cols); }
+
+    void reserve(index_t nnz) {
+        row_.reserve(static_cast<std::size_t>(nnz));
+        col_.reserve(static_cast<std::size_t>(nnz));
+        val_.reserve(static_cast<std::size_t>(nnz));
+    }
+
+    /// Records a(i, j) += v; repeated coordinates are summed on conversion.
+    void add(index_t i, index_t j, T v) {
+        if (i < 0 || i >= rows_ || j < 0 || j >= cols_) {
+            throw DimensionError("lana: Coo::add index out of range");
+        }
+        row_.push_back(static_cast<sparse_index_t>(i));
+        col_.push_back(static_cast<sparse_index_t>(j));
+        val_.push_back(v);
+    }
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t nnz() const noexcept { return static_cast<index_t>(val_.size()); }
+    const std::vector<sparse_index_t>& row_indices() const noexcept { return row_; }
+    const std::vector<sparse_index_t>& col_indices() const noexcept { return col_; }
+    const std::vector<T>& values() const noexcept { return val_; }
+
+private:
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    std::vector<sparse_index_t> row_;
+    std::vector<sparse_index_t> col_;
+    std::vector<T> val_;
+};
+
+/// Non-owning, read-only view of CSR arrays: a Csr, or arrays that live
+/// elsewhere (e.g. a mapped file, see io.hpp). The arrays must be well
+/// formed; the view does not check them.
+template <typename T>
+class CsrView {
+public:
+    using value_type = T;
+
+    CsrView() = default;
+    CsrView(index_t rows, index_t cols, const index_t* row_ptr, const sparse_index_t* col_idx,
+            const T* values) noexcept
+        : rows_(rows), cols_(cols), row_ptr_(row_ptr), col_idx_(col_idx), val_(values) {}
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t nnz() const noexcept { return row_ptr_ ? row_ptr_[rows_] : 0; }
+    const index_t* row_ptr() const noexcept { return row_ptr_; }
+    const sparse_index_t* col_idx() const noexcept { return col_idx_; }
+    const T* values() const noexcept { return val_; }
+
+private:
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    const index_t* row_ptr_ = nullptr;
+    const sparse_index_t* col_idx_ = nullptr;
+    const T* val_ = nullptr;
+};
+
+/// Compressed sparse rows.
+template <typename T>
+class Csr {
+public:
+    using value_type = T;
+
+    Csr() : row_ptr_(1, 0) {}
+
+    /// Adopts existing CSR arrays; throws Error unless they are well formed
+    /// (monotone row_ptr, in-range and strictly increasing columns per row).
+    Csr(index_t rows, index_t cols, std::vector<index_t> row_ptr, std::vector<sparse_index_t> col_idx,
+        std::vector<T> values)
+        : rows_(rows),
+          cols_(cols),
+          row_ptr_(std::move(row_ptr)),
+          col_idx_(std::move(col_idx)),
+          val_(std::move(values)) {
+        detail::require_sparse_dims(rows, cols);
+        detail::validate_compressed(rows_, cols_, row_ptr_, col_idx_, val_, "CSR");
+    }
+
+    explicit Csr(const Coo<T>& coo)
+        : Csr(coo.rows(), coo.cols(),
+              detail::compress<T>(
+                  coo.rows(), coo.cols(), coo.nnz(),
+                  [&](index_t k) { return coo.row_indices()[static_cast<std::size_t>(k)]; },
+                  [&](index_t k) { return coo.col_indices()[static_cast<std::size_t>(k)]; },
+                  [&](index_t k) { return coo.values()[static_cast<std::size_t>(k)]; })) {}
+
+    explicit Csr(const Csc<T>& csc)
+        : Csr(csc.rows(), csc.cols(),
+              detail::transpose_compressed(csc.cols(), csc.rows(), csc.col_ptr(), csc.row_idx(), csc.values())) {}
+
+    /// Deep, validated copy of a view.
+    explicit Csr(CsrView<T> v)
+        : Csr(v.rows(), v.cols(), std::vector<index_t>(v.row_ptr(), v.row_ptr() + v.rows() + 1),
+              std::vector<sparse_index_t>(v.col_idx(), v.col_idx() + v.nnz()),
+              std::vector<T>(v.values(), v.values() + v.nnz())) {}
+
+    /// Nonzero entries of a dense matrix.
+    static Csr from_dense(MatrixView<const T> a) {
+        detail::require_sparse_dims(a.rows(), a.cols());
+        Csr out;
+        out.rows_ = a.rows();
+        out.cols_ = a.cols();
+        out.row_ptr_.assign(static_cast<std::size_t>(a.rows()) + 1, 0);
+        for (index_t i = 0; i < a.rows(); ++i) {
+            for (index_t j = 0; j < a.cols(); ++j) {
+                if (a(i, j) != T(0)) {
+                    out.col_idx_.push_back(static_cast<sparse_index_t>(j));
+                    out.val_.push_back(a(i, j));
+                }
+            }
+            out.row_ptr_[static_cast<std::size_t>(i) + 1] = static_cast<index_t>(out.val_.size());
+        }
+        return out;
+    }
+
+    Matrix<T> to_dense() const {
+        Matrix<T> d(rows_, cols_);
+        for (index_t i = 0; i < rows_; ++i) {
+            const auto ui = static_cast<std::size_t>(i);
+            for (index_t k = row_ptr_[ui]; k < row_ptr_[ui + 1]; ++k) {
+                d(i, col_idx_[static_cast<std::size_t>(k)]) = val_[static_cast<std::size_t>(k)];
+            }
+        }
+        return d;
+    }
+
+    Csr transpose() const {
+        return Csr(cols_, rows_, detail::transpose_compressed(rows_, cols_, row_ptr_, col_idx_, val_));
+    }
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t nnz() const noexcept { return static_cast<index_t>(val_.size()); }
+    const std::vector<index_t>& row_ptr() const noexcept { return row_ptr_; }
+    const std::vector<sparse_index_t>& col_idx() const noexcept { return col_idx_; }
+    const std::vector<T>& values() const noexcept { return val_; }
+    /// Values may be rewritten in place; the sparsity pattern is fixed.
+    std::vector<T>& values() noexcept { return val_; }
+
+    CsrView<T> view() const noexcept {
+        return CsrView<T>(rows_, cols_, row_ptr_.data(), col_idx_.data(), val_.data());
+    }
+    operator CsrView<T>() const noexcept { return view(); }  // NOLINT(google-explicit-constructor)
+
+private:
+    Csr(index_t rows, index_t cols, detail::Compressed<T>&& c)
+        : rows_(rows), cols_(cols), row_ptr_(std::move(c.ptr)), col_idx_(std::move(c.idx)), val_(std::move(c.val)) {}
+
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    std::vector<index_t> row_ptr_;
+    std::vector<sparse_index_t> col_idx_;
+    std::vector<T> val_;
+};
+
+/// Compressed sparse columns.
+template <typename T>
+class Csc {
+public:
+    using value_type = T;
+
+    Csc() : col_ptr_(1, 0) {}
+
+    /// Adopts existing CSC arrays; validated like the CSR constructor.
+    Csc(index_t rows, index_t cols, std::vector<index_t> col_ptr, std::vector<sparse_index_t> row_idx,
+        std::vector<T> values)
+        : rows_(rows),
+          cols_(cols),
+          col_ptr_(std::move(col_ptr)),
+          row_idx_(std::move(row_idx)),
+          val_(std::move(values)) {
+        detail::require_sparse_dims(rows, cols);
+        detail::validate_compressed(cols_, rows_, col_ptr_, row_idx_, val_, "CSC");
+    }
+
+    explicit Csc(const Coo<T>& coo)
+        : Csc(coo.rows(), coo.cols(),
+              detail::compress<T>(
+                  coo.cols(), coo.rows(), coo.nnz(),
+                  [&](index_t k) { return coo.col_indices()[static_cast<std::size_t>(k)]; },
+                  [&](index_t k) { return coo.row_indices()[static_cast<std::size_t>(k)]; },
+                  [&](index_t k) { return coo.values()[static_cast<std::size_t>(k)]; })) {}
+
+    explicit Csc(const Csr<T>& csr)
+        : Csc(csr.rows(), csr.cols(),
+              detail::transpose_compressed(csr.rows(), csr.cols(), csr.row_ptr(), csr.col_idx(), csr.values())) {}
+
+    Matrix<T> to_dense() const {
+        Matrix<T> d(rows_, cols_);
+        for (index_t j = 0; j < cols_; ++j) {
+            const auto uj = static_cast<std::size_t>(j);
+            for (index_t k = col_ptr_[uj]; k < col_ptr_[uj + 1]; ++k) {
+                d(row_idx_[static_cast<std::size_t>(k)], j) = val_[static_cast<std::size_t>(k)];
+            }
+        }
+        return d;
+    }
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t nnz() const noexcept { return static_cast<index_t>(val_.size()); }
+    const std::vector<index_t>& col_ptr() const noexcept { return col_ptr_; }
+    const std::vector<sparse_index_t>& row_idx() const noexcept { return row_idx_; }
+    const std::vector<T>& values() const noexcept { return val_; }
+    std::vector<T>& values() noexcept { return val_; }
+
+private:
+    Csc(index_t rows, index_t cols, detail::Compressed<T>&& c)
+        : rows_(rows), cols_(cols), col_ptr_(std::move(c.ptr)), row_idx_(std::move(c.idx)), val_(std::move(c.val)) {}
+
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    std::vector<index_t> col_ptr_;
+    std::vector<sparse_index_t> row_idx_;
+    std::vector<T> val_;
+};
+
+/// Block compressed sparse rows: a CSR pattern over dense br x bc blocks,
+/// each stored column-major. Suits problems with several unknowns per mesh
+/// node, where every coupling is a small dense block.
+template <typename T>
+class Bsr {
+public:
+    using value_type = T;
+
+    Bsr() : block_ptr_(1, 0) {}
+
+    /// Groups a CSR matrix into br x bc blocks; rows() and cols() must be
+    /// multiples of the block shape. Entries missing inside a block are
+    /// stored as explicit zeros.
+    Bsr(const Csr<T>& a, index_t br, index_t bc) : rows_(a.rows()), cols_(a.cols()), br_(br), bc_(bc) {
+        detail::require_dims(br > 0 && bc > 0 && a.rows() % br == 0 && a.cols() % bc == 0, "Bsr block shape");
+        const index_t mb = a.rows() / br;
+        const index_t nb = a.cols() / bc;
+        const auto& rp = a.row_ptr();
+        const auto& ci = a.col_idx();
+        const auto& av = a.values();
+        block_ptr_.assign(static_cast<std::size_t>(mb) + 1, 0);
+        std::vector<index_t> slot(static_cast<std::size_t>(nb), -1);
+        std::vector<sparse_index_t> cols_here;
+        for (index_t ib = 0; ib < mb; ++ib) {
+            cols_here.clear();
+            const index_t first = rp[static_cast<std::size_t>(ib * br)];
+            const index_t last = rp[static_cast<std::size_t>((ib + 1) * br)];
+            for (index_t k = first; k < last; ++k) {
+                const auto jb = static_cast<sparse_index_t>(ci[static_cast<std::size_t>(k)] / bc);
+                if (slot[static_cast<std::size_t>(jb)] < 0) {
+                    slot[static_cast<std::size_t>(jb)] = 0;
+                    cols_here.push_back(jb);
+                }
+            }
+            std::sort(cols_here.begin(), cols_here.end());
+            const index_t base = static_cast<index_t>(block_col_.size());
+            for (std::size_t s = 0; s < cols_here.size(); ++s) {
+                slot[static_cast<std::size_t>(cols_here[s])] = base + static_cast<index_t>(s);
+                block_col_.push_back(cols_here[s]);
+            }
+            val_.resize(block_col_.size() * static_cast<std::size_t>(br * bc), T(0));
+            for (index_t i = ib * br; i < (ib + 1) * br; ++i) {
+                for (index_t k = rp[static_cast<std::size_t>(i)]; k < rp[static_cast<std::size_t>(i) + 1]; ++k) {
+                    const index_t j = ci[static_cast<std::size_t>(k)];
+                    const index_t s = slot[static_cast<std::size_t>(j / bc)];
+                    val_[static_cast<std::size_t>(s * br * bc + (j % bc) * br + (i - ib * br))] =
+                        av[static_cast<std::size_t>(k)];
+                }
+            }
+            for (sparse_index_t jb : cols_here) {
+                slot[static_cast<std::size_t>(jb)] = -1;
+            }
+            block_ptr_[static_cast<std::size_t>(ib) + 1] = static_cast<index_t>(block_col_.size());
+        }
+    }
+
+    Matrix<T> to_dense() const {
+        Matrix<T> d(rows_, cols_);
+        for (index_t ib = 0; ib < block_row_count(); ++ib) {
+            for (index_t s = block_ptr_[static_cast<std::size_t>(ib)]; s < block_ptr_[static_cast<std::size_t>(ib) + 1];
+                 ++s) {
+                const index_t jb = block_col_[static_cast<std::size_t>(s)];
+                d.block(ib * br_, jb * bc_, br_, bc_).assign(block(s));
+            }
+        }
+        return d;
+    }
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t block_rows() const noexcept { return br_; }
+    index_t block_cols() const noexcept { return bc_; }
+    index_t block_row_count() const noexcept { return br_ ? rows_ / br_ : 0; }
+    /// Stored blocks (each br x bc values, explicit zeros included).
+    index_t nnz_blocks() const noexcept { return static_cast<index_t>(block_col_.size()); }
+    const std::vector<index_t>& block_ptr() const noexcept { return block_ptr_; }
+    const std::vector<sparse_index_t>& block_col() const noexcept { return block_col_; }
+    const std::vector<T>& values() const noexcept { return val_; }
+    std::vector<T>& values() noexcept { return val_; }
+
+    /// Stored block `s` (an index into block_col()).
+    MatrixView<const T> block(index_t s) const noexcept {
+        return MatrixView<const T>(val_.data() + s * br_ * bc_, br_, bc_, 1, br_);
+    }
+
+private:
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t br_ = 1;
+    index_t bc_ = 1;
+    std::vector<index_t> block_ptr_;
+    std::vector<sparse_index_t> block_col_;
+    std::vector<T> val_;
+};
+
+/// y = alpha * A * x + beta * y; y is not read when beta is zero.
+///
+/// A Csr converts to CsrView implicitly. CSR and BSR run in parallel over
+/// row ranges holding roughly equal numbers of nonzeros. CSC scatters into
+/// y and runs on the calling thread; convert to CSR for repeated products.
+LANA_API void spmv(float alpha, CsrView<float> a, VectorView<const float> x, float beta, VectorView<float> y);
+LANA_API void spmv(double alpha, CsrView<double> a, VectorView<const double> x, double beta, VectorView<double> y);
+LANA_API void spmv(float alpha, const Csc<float>& a, VectorView<const float> x, float beta, VectorView<float> y);
+LANA_API void spmv(double alpha, const Csc<double>& a, VectorView<const double> x, double beta, VectorView<double> y);
+LANA_API void spmv(float alpha, const Bsr<float>& a, VectorView<const float> x, float beta, VectorView<float> y);
+LANA_API void spmv(double alpha, const Bsr<double>& a, VectorView<const double> x, double beta, VectorView<double> y);
+
+/// C = alpha * A * B + beta * C for a dense, arbitrarily strided B and C.
+LANA_API void spmm(float alpha, CsrView<float> a, MatrixView<const float> b, float beta, MatrixView<float> c);
+LANA_API void spmm(double alpha, CsrView<double> a, MatrixView<const double> b, double beta, MatrixView<double> c);
+LANA_API void spmm(float alpha, const Bsr<float>& a, MatrixView<const float> b, float beta, MatrixView<float> c);
+LANA_API void spmm(double alpha, const Bsr<double>& a, MatrixView<const double> b, double beta, MatrixView<double> c);
+
+}  // namespace lana
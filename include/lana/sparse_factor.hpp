@@ -0,0 +1,315 @@
+#pragma once
+
+/// Sparse direct solvers: fill-reducing orderings and supernodal
+/// multifrontal Cholesky and LU.
+///
+/// Factoring a sparse matrix in its given order usually fills most of L
+/// in. The orderings here permute A symmetrically first: approximate
+/// minimum degree (AMD, Amestoy-Davis-Duff on a quotient graph) or nested
+/// dissection (recursive level-structure vertex separators, with AMD on
+/// the small pieces). Nested dissection suits large 2D and 3D meshes; AMD
+/// is the better default elsewhere.
+///
+/// The analysis then computes the elimination tree of P A P^T, postorders
+/// it and groups columns with nested structure into supernodes, merging
+/// small ones when that adds few explicit zeros. Each supernode is a dense
+/// front: the original entries of its columns plus the update matrices of
+/// its children are assembled, its pivot columns are factored with the
+/// blocked dense kernels (potrf or getrf, trsm, and syrk or GEMM for the
+/// update matrix passed to its parent). Fronts are tasks of a graph over
+/// the assembly tree, so independent subtrees run concurrently on the
+/// thread pool; wide fronts near the root are factored one at a time with
+/// the parallel dense kernels instead.
+///
+/// SparseLu first permutes the columns of A so that its diagonal is free
+/// of structural zeros, preferring large entries (a maximum transversal),
+/// then uses the pattern of A Q + (A Q)^T and pivots within each front's
+/// pivot block. A pivot that is still tiny is replaced by sqrt(eps) * |A|
+/// (static pivoting). When that happened, or when a pivot is small next to
+/// the entries below it that the block could not reach, solve() corrects
+/// the result with iterative refinement against A.
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/sparse.hpp"
+#include "lana/vector.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace lana {
+
+enum class Ordering { Natural, Amd, NestedDissection };
+
+namespace detail {
+
+/// Supernodal structure of the factor of P A P^T, shared by both solvers.
+/// Indices are in the permuted numbering unless noted.
+struct SupernodalSymbolic {
+    index_t n = 0;
+    std::vector<sparse_index_t> perm;   // perm[k]: original index of pivot k
+    std::vector<sparse_index_t> iperm;  // inverse of perm
+    /// Supernode s holds pivots [first[s], first[s + 1]), in postorder.
+    std::vector<index_t> first;
+    /// Parent supernode in the assembly tree, -1 at roots.
+    std::vector<index_t> parent;
+    /// Rows of front s, ascending: rows[row_ptr[s] .. row_ptr[s + 1]),
+    /// starting with its own pivots.
+    std::vector<index_t> row_ptr;
+    std::vector<sparse_index_t> rows;
+    /// Offset of the m x ns column panel of s (L, or L and U11 for LU),
+    /// and of its ns x (m - ns) U12 block for LU.
+    std::vector<index_t> l_ptr;
+    std::vector<index_t> u_ptr;
+
+    index_t supernodes() const noexcept { return static_cast<index_t>(first.size()) - 1; }
+    std::size_t bytes() const noexcept {
+        return (perm.size() + iperm.size() + rows.size()) * sizeof(sparse_index_t) +
+               (first.size() + parent.size() + row_ptr.size() + l_ptr.size() + u_ptr.size()) * sizeof(index_t);
+    }
+};
+
+/// Fill-reducing order of the square pattern (ptr, idx) symmetrized as
+/// A + A^T, or of its lower triangle only when `lower` is set.
+LANA_API std::vector<sparse_index_t> fill_order(index_t n, const index_t* ptr, const sparse_index_t* idx,
+                                                Ordering ordering, bool lower);
+
+LANA_API SupernodalSymbolic analyse(index_t n, const index_t* ptr, const sparse_index_t* idx, Ordering ordering,
+                                    bool lower);
+
+/// Column matched to each row, so that a(i, match[i]) is a stored entry:
+/// Duff's maximum transversal after a pass giving each row its largest
+/// free entry. Fills match[0, a.rows()) and returns the number of rows
+/// matched, the structural rank of A; the rows left over get -1.
+LANA_API index_t transversal(CsrView<float> a, sparse_index_t* match);
+LANA_API index_t transversal(CsrView<double> a, sparse_index_t* match);
+
+/// Multifrontal factorizations into the panels of `s`; Cholesky returns 0
+/// or the failing pivot + 1, LU the number of weak pivots: those perturbed
+/// by static pivoting or with an entry below them, outside their front's
+/// pivot block, over ten times their size.
+LANA_API index_t cholesky_numeric(const SupernodalSymbolic& s, CsrView<float> a, float* l);
+LANA_API index_t cholesky_numeric(const SupernodalSymbolic& s, CsrView<double> a, double* l);
+LANA_API index_t lu_numeric(const SupernodalSymbolic& s, CsrView<float> a, float* l, float* u, std::int32_t* ipiv);
+LANA_API index_t lu_numeric(const SupernodalSymbolic& s, CsrView<double> a, double* l, double* u,
+                            std::int32_t* ipiv);
+
+/// B = A^-1 * B from the factors, in the original numbering.
+LANA_API void cholesky_solve(const SupernodalSymbolic& s, const float* l, MatrixView<float> b);
+LANA_API void cholesky_solve(const SupernodalSymbolic& s, const double* l, MatrixView<double> b);
+LANA_API void lu_solve(const SupernodalSymbolic& s, const float* l, const float* u, const std::int32_t* ipiv,
+                       MatrixView<float> b);
+LANA_API void lu_solve(const SupernodalSymbolic& s, const double* l, const double* u, const std::int32_t* ipiv,
+                       MatrixView<double> b);
+
+}  // namespace detail
+
+/// Fill-reducing permutation of square `a`: perm[k] is the original index
+/// of the k-th pivot. The pattern is symmetrized as A + A^T.
+template <typename T>
+std::vector<sparse_index_t> fill_reducing_order(CsrView<T> a, Ordering ordering = Ordering::Amd) {
+    detail::require_dims(a.rows() == a.cols(), "fill_reducing_order");
+    return detail::fill_order(a.rows(), a.row_ptr(), a.col_idx(), ordering, false);
+}
+
+/// P A P^T = L * L^T for symmetric positive definite A, of which only the
+/// entries on and below the diagonal are read.
+template <typename T>
+class SparseCholesky {
+public:
+    using value_type = T;
+
+    /// Analyses and factors `a`; throws Error if it is not positive
+    /// definite.
+    explicit SparseCholesky(CsrView<T> a, Ordering ordering = Ordering::Amd)
+        : sym_(analyse_checked(a, ordering)), l_(static_cast<std::size_t>(sym_.l_ptr.back())) {
+        refactor(a);
+    }
+
+    /// Factors a matrix with the sparsity pattern of the one analysed,
+    /// reusing the ordering and the symbolic factorization.
+    void refactor(CsrView<T> a) {
+        detail::require_dims(a.rows() == sym_.n && a.cols() == sym_.n, "SparseCholesky::refactor");
+        if (detail::cholesky_numeric(sym_, a, l_.data()) != 0) {
+            throw Error("lana: SparseCholesky needs a positive definite matrix");
+        }
+    }
+
+    /// B = A^-1 * B.
+    void solve(MatrixView<T> b) const {
+        detail::require_dims(b.rows() == sym_.n, "SparseCholesky::solve");
+        detail::cholesky_solve(sym_, l_.data(), b);
+    }
+    void solve(VectorView<T> b) const {
+        solve(MatrixView<T>(b.data(), b.size(), 1, b.stride(), b.size() * b.stride()));
+    }
+
+    index_t rows() const noexcept { return sym_.n; }
+    /// Stored entries of L, explicit zeros inside supernodes included.
+    index_t factor_nnz() const noexcept { return static_cast<index_t>(l_.size()); }
+    /// Memory held by the factor and its symbolic analysis.
+    std::size_t bytes() const noexcept { return l_.size() * sizeof(T) + sym_.bytes(); }
+    index_t supernodes() const noexcept { return sym_.supernodes(); }
+    const std::vector<sparse_index_t>& permutation() const noexcept { return sym_.perm; }
+
+private:
+    static detail::SupernodalSymbolic analyse_checked(CsrView<T> a, Ordering ordering) {
+        detail::require_dims(a.rows() == a.cols(), "SparseCholesky");
+        return detail::analyse(a.rows(), a.row_ptr(), a.col_idx(), ordering, true);
+    }
+
+    detail::SupernodalSymbolic sym_;
+    std::vector<T> l_;
+};
+
+/// Pr P A Q P^T = L * U for general square A, where Q is the column
+/// matching of detail::transversal and Pr only interchanges rows within a
+/// supernode.
+template <typename T>
+class SparseLu {
+public:
+    using value_type = T;
+
+    /// Analyses and factors `a`, keeping a copy of it for refinement.
+    /// Throws Error if `a` is structurally singular: no column permutation
+    /// puts a stored entry on every diagonal position.
+    explicit SparseLu(CsrView<T> a, Ordering ordering = Ordering::Amd)
+        : match_(matched_columns(a)),
+          sym_(analyse_matched(a, ordering)),
+          l_(static_cast<std::size_t>(sym_.l_ptr.back())),
+          u_(static_cast<std::size_t>(sym_.u_ptr.back())),
+          ipiv_(static_cast<std::size_t>(sym_.n)) {
+        refactor(a);
+    }
+
+    /// Factors a matrix with the sparsity pattern of the one analysed,
+    /// reusing its ordering and column matching.
+    void refactor(CsrView<T> a) {
+        detail::require_dims(a.rows() == sym_.n && a.cols() == sym_.n, "SparseLu::refactor");
+        a_ = Csr<T>(a);
+        const Csr<T> aq = matched(a);
+        weak_ = detail::lu_numeric(sym_, aq.view(), l_.data(), u_.data(), ipiv_.data());
+    }
+
+    /// B = A^-1 * B. With weak pivots, each column is refined up to
+    /// refine_steps times, stopping once a correction no longer shrinks.
+    void solve(MatrixView<T> b) const {
+        detail::require_dims(b.rows() == sym_.n, "SparseLu::solve");
+        if (weak_ == 0) {
+            solve_once(b);
+            return;
+        }
+        const Matrix<T> rhs{MatrixView<const T>(b)};
+        solve_once(b);
+        Matrix<T> r(b.rows(), b.cols(), uninitialized);
+        std::vector<T> last(static_cast<std::size_t>(b.cols()), T(-1));
+        for (index_t step = 0; step < refine_steps; ++step) {
+            r.view().assign(rhs.view());
+            spmm(T(-1), a_.view(), MatrixView<const T>(b), T(1), r.view());
+            solve_once(r.view());
+            bool shrinking = false;
+            for (index_t j = 0; j < b.cols(); ++j) {
+                T size = T(0);
+                for (index_t i = 0; i < b.rows(); ++i) {
+                    size = std::max(size, std::abs(r(i, j)));
+                }
+                auto& prev = last[static_cast<std::size_t>(j)];
+                if (prev < T(0) || size < prev / 2) {
+                    for (index_t i = 0; i < b.rows(); ++i) {
+                        b(i, j) += r(i, j);
+                    }
+                    shrinking = shrinking || size > T(0);
+                    prev = size;
+                } else {
+                    prev = T(0);
+                }
+            }
+            if (!shrinking) {
+                break;
+            }
+        }
+    }
+    void solve(VectorView<T> b) const {
+        solve(MatrixView<T>(b.data(), b.size(), 1, b.stride(), b.size() * b.stride()));
+    }
+
+    index_t rows() const noexcept { return sym_.n; }
+    /// Stored entries of L and U, explicit zeros inside supernodes included.
+    index_t factor_nnz() const noexcept { return static_cast<index_t>(l_.size() + u_.size()); }
+    /// Memory held by the factors, the symbolic analysis and the copy of A.
+    std::size_t bytes() const noexcept {
+        return (l_.size() + u_.size()) * sizeof(T) + ipiv_.size() * sizeof(std::int32_t) +
+               match_.size() * sizeof(sparse_index_t) + sym_.bytes() +
+               static_cast<std::size_t>(a_.nnz()) * (sizeof(T) + sizeof(sparse_index_t)) +
+               static_cast<std::size_t>(a_.rows() + 1) * sizeof(index_t);
+    }
+    index_t supernodes() const noexcept { return sym_.supernodes(); }
+    /// Symmetric permutation P, applied after the column matching.
+    const std::vector<sparse_index_t>& permutation() const noexcept { return sym_.perm; }
+    /// Pivots of the last factorization that were perturbed or failed the
+    /// threshold test (see detail::lu_numeric).
+    index_t weak_pivots() const noexcept { return weak_; }
+
+    static constexpr index_t refine_steps = 3;
+
+private:
+    static std::vector<sparse_index_t> matched_columns(CsrView<T> a) {
+        detail::require_dims(a.rows() == a.cols(), "SparseLu");
+        std::vector<sparse_index_t> match(static_cast<std::size_t>(a.rows()));
+        if (detail::transversal(a, match.data()) < a.rows()) {
+            throw Error("lana: SparseLu needs a structurally nonsingular matrix");
+        }
+        return match;
+    }
+
+    /// A Q: row i keeps its entries, column match_[i] becomes column i.
+    Csr<T> matched(CsrView<T> a) const {
+        std::vector<sparse_index_t> slot(match_.size());
+        for (std::size_t i = 0; i < match_.size(); ++i) {
+            slot[static_cast<std::size_t>(match_[i])] = static_cast<sparse_index_t>(i);
+        }
+        Coo<T> c(a.rows(), a.cols());
+        c.reserve(a.nnz());
+        for (index_t i = 0; i < a.rows(); ++i) {
+            for (index_t k = a.row_ptr()[i]; k < a.row_ptr()[i + 1]; ++k) {
+                c.add(i, slot[static_cast<std::size_t>(a.col_idx()[k])], a.values()[k]);
+            }
+        }
+        return Csr<T>(c);
+    }
+
+    detail::SupernodalSymbolic analyse_matched(CsrView<T> a, Ordering ordering) const {
+        const Csr<T> aq = matched(a);
+        const CsrView<T> v = aq.view();
+        return detail::analyse(v.rows(), v.row_ptr(), v.col_idx(), ordering, false);
+    }
+
+    /// Solves A Q y = b with the factors, then scatters x = Q y.
+    void solve_once(MatrixView<T> b) const {
+        detail::lu_solve(sym_, l_.data(), u_.data(), ipiv_.data(), b);
+        std::vector<T> x(match_.size());
+        for (index_t j = 0; j < b.cols(); ++j) {
+            for (index_t i = 0; i < b.rows(); ++i) {
+                x[static_cast<std::size_t>(match_[static_cast<std::size_t>(i)])] = b(i, j);
+            }
+            for (index_t i = 0; i < b.rows(); ++i) {
+                b(i, j) = x[static_cast<std::size_t>(i)];
+            }
+        }
+    }
+
+    std::vector<sparse_index_t> match_;
+    detail::SupernodalSymbolic sym_;
+    std::vector<T> l_;
+    std::vector<T> u_;
+    std::vector<std::int32_t> ipiv_;
+    Csr<T> a_;
+    index_t weak_ = 0;
+};
+
+}  // namespace lana
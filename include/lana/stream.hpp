@@ -0,0 +1,112 @@
+#pragma once
+
+/// Out-of-core operations on dense sections of lana files.
+///
+/// A MappedFile serves matrices that fit in the page cache. Past that,
+/// page faults fetch 4 KiB at a time. They stall the thread that takes
+/// them, and the pages they bring in evict each other. The functions here
+/// instead read the section tile by tile into two buffers of
+/// StreamOptions::tile_bytes each:
+///
+/// - tile t + 1 is read while tile t is computed on lana's thread pool;
+/// - reads go through io_uring when the kernel offers it, otherwise
+///   through preads on a helper thread;
+/// - pages already consumed are dropped from the page cache.
+///
+/// Resident memory stays at two tiles plus the in-memory operands, however
+/// large the file is. One sequential pass over a 200 GB matrix runs at disk
+/// bandwidth, with no manual sharding.
+///
+///     stream::Source x("samples.lana", "X");            // 10^8 x 512, f64
+///     Matrix<double> cov(512, 512);
+///     stream::covariance(x, cov.view());                // one pass
+///     Matrix<double> proj(x.rows(), 16);
+///     stream::gemm(Op::NoTrans, 1.0, x, w.view(), 0.0, proj.view());
+///
+/// Tiles follow the section's storage order where the operation allows it,
+/// so a column-major section streams in column panels, one read each.
+
+#include "lana/config.hpp"
+#include "lana/factor.hpp"
+#include "lana/io.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace lana::stream {
+
+struct StreamOptions {
+    /// Bytes per tile buffer; two are allocated. gram() and covariance()
+    /// need whole rows, so their tiles hold at least one row regardless.
+    std::size_t tile_bytes = std::size_t(64) << 20;
+    /// Read through io_uring where available (Linux 5.1+); false always
+    /// uses the pread thread.
+    bool io_uring = true;
+    /// Drop consumed pages from the page cache, so one pass does not evict
+    /// everything else.
+    bool drop_cache = true;
+};
+
+/// A dense section of a lana file opened for streaming. Opening validates
+/// the file like MappedFile and keeps one read-only descriptor.
+class LANA_API Source {
+public:
+    /// Throws IoError if the file cannot be opened, is not a lana file, or
+    /// `section` is not a dense section.
+    Source(const std::string& path, const std::string& section);
+    ~Source();
+
+    Source(Source&& other) noexcept;
+    Source& operator=(Source&& other) noexcept;
+    Source(const Source&) = delete;
+    Source& operator=(const Source&) = delete;
+
+    const SectionInfo& info() const noexcept { return info_; }
+    index_t rows() const noexcept { return info_.rows; }
+    index_t cols() const noexcept { return info_.cols; }
+    const std::string& path() const noexcept { return path_; }
+
+    int fd() const noexcept { return fd_; }
+    /// File offset of element (0, 0).
+    std::uint64_t offset() const noexcept { return offset_; }
+
+private:
+    std::string path_;
+    SectionInfo info_{};
+    std::uint64_t offset_ = 0;
+    int fd_ = -1;
+};
+
+/// C = alpha * op(A) * B + beta * C, with A streamed from `a` and B, C in
+/// memory. Throws IoError on a read failure or an element type mismatch.
+LANA_API void gemm(Op op, float alpha, const Source& a, MatrixView<const float> b, float beta, MatrixView<float> c,
+                   const StreamOptions& opts = {});
+LANA_API void gemm(Op op, double alpha, const Source& a, MatrixView<const double> b, double beta,
+                   MatrixView<double> c, const StreamOptions& opts = {});
+
+/// C = alpha * A^T * A + beta * C (cols x cols). Only the lower triangle is
+/// computed, then it is mirrored.
+LANA_API void gram(float alpha, const Source& a, float beta, MatrixView<float> c, const StreamOptions& opts = {});
+LANA_API void gram(double alpha, const Source& a, double beta, MatrixView<double> c,
+                   const StreamOptions& opts = {});
+
+/// Sample covariance of the columns (rows are observations), in one pass.
+/// Data are shifted by the first row before accumulating, which keeps the
+/// one-pass formula accurate when the means are large against the spread.
+/// `mean`, if not empty, receives the column means.
+LANA_API void covariance(const Source& a, MatrixView<float> c, VectorView<float> mean = {},
+                         const StreamOptions& opts = {});
+LANA_API void covariance(const Source& a, MatrixView<double> c, VectorView<double> mean = {},
+                         const StreamOptions& opts = {});
+
+/// out[j] = sum of column j.
+LANA_API void column_sums(const Source& a, VectorView<float> out, const StreamOptions& opts = {});
+LANA_API void column_sums(const Source& a, VectorView<double> out, const StreamOptions& opts = {});
+
+/// Frobenius norm of the whole section, accumulated in double.
+LANA_API double frobenius_norm(const Source& a, const StreamOptions& opts = {});
+
+}  // namespace lana::stream
@@ -0,0 +1,178 @@
+#pragma once
+
+#include "lana/config.hpp"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace lana {
+
+/// Something that can run lana's parallel work: lana's own ThreadPool, or an
+/// adapter around the host application's scheduler.
+///
+/// lana never blocks inside an executor job waiting for a job it has not
+/// started itself: the thread that opens a parallel region always works
+/// through the remaining chunks, so an executor with a fixed number of
+/// threads (even one) cannot deadlock.
+class LANA_API Executor {
+public:
+    virtual ~Executor();
+
+    /// Threads that may run lana work at once, counting the caller.
+    virtual int concurrency() const noexcept = 0;
+
+    /// Runs `fn` later on some executor thread.
+    virtual void execute(std::function<void()> fn) = 0;
+};
+
+struct ThreadPoolOptions {
+    /// Total concurrency including the calling thread; the pool starts
+    /// num_threads - 1 workers. 0 means `LANA_NUM_THREADS` if set, else the
+    /// number of CPUs in the process affinity mask.
+    int num_threads = 0;
+    /// Pin worker i to one CPU, filling NUMA nodes in order so that
+    /// consecutive workers share a node.
+    bool pin_threads = false;
+};
+
+namespace detail {
+
+/// Non-owning reference to a callable; valid only while the callable lives.
+template <typename Signature>
+class FunctionRef;
+
+template <typename R, typename... Args>
+class FunctionRef<R(Args...)> {
+public:
+    template <typename F, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, FunctionRef>>>
+    FunctionRef(F&& f) noexcept  // NOLINT(google-explicit-constructor)
+        : obj_(const_cast<void*>(static_cast<const void*>(std::addressof(f)))),
+          call_([](void* obj, Args... args) -> R {
+              return (*static_cast<std::remove_reference_t<F>*>(obj))(std::forward<Args>(args)...);
+          }) {}
+
+    R operator()(Args... args) const { return call_(obj_, std::forward<Args>(args)...); }
+
+private:
+    void* obj_;
+    R (*call_)(void*, Args...);
+};
+
+class PoolImpl;
+
+}  // namespace detail
+
+/// Work-stealing thread pool.
+///
+/// Each worker owns a Chase-Lev deque: it pushes and pops its own tasks at
+/// the bottom, idle workers steal from the top (same NUMA node first).
+/// Threads outside the pool hand work in through a shared injection queue.
+/// A parallel region opened from inside a worker pushes onto that worker's
+/// deque, so nested regions reuse the same threads instead of spawning more.
+class LANA_API ThreadPool final : public Executor {
+public:
+    explicit ThreadPool(ThreadPoolOptions options = {});
+    ~ThreadPool() override;
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int concurrency() const noexcept override;
+    void execute(std::function<void()> fn) override;
+
+    /// Calls body(i) for every i in [0, n) and returns when all calls have
+    /// finished. The caller runs tasks while it waits. Once a call throws,
+    /// calls not yet started are skipped, and the first exception is
+    /// rethrown here after the ones already running return.
+    void run(index_t n, detail::FunctionRef<void(index_t)> body);
+
+    /// NUMA node worker `w` is pinned to, or -1 when unpinned or unknown.
+    /// Worker 0 is the calling thread.
+    int worker_node(int w) const noexcept;
+
+    /// Index of the calling thread within this pool (1..concurrency()-1),
+    /// or 0 when the caller is not one of its workers.
+    int current_worker() const noexcept;
+
+private:
+    std::unique_ptr<detail::PoolImpl> impl_;
+};
+
+/// Caps lana's own pool at `n` total threads (0 restores the default) by
+/// rebuilding it. Call it at startup or between parallel calls.
+LANA_API void set_num_threads(int n);
+
+/// Concurrency of the executor lana currently schedules onto.
+LANA_API int num_threads();
+
+/// Routes all of lana's parallel work to `executor`; nullptr restores lana's
+/// own pool. The executor is kept alive while regions are still using it.
+LANA_API void set_executor(std::shared_ptr<Executor> executor);
+
+/// lana's own pool, created on first use.
+LANA_API ThreadPool& default_thread_pool();
+
+/// How parallel reductions (dot, sum, nrm2 and the solvers built on them)
+/// order their additions.
+enum class Determinism {
+    /// One partial sum per task. The rounding depends on how many tasks
+    /// the pool size gives.
+    Fast,
+    /// Partial sums over fixed-size blocks, combined in a fixed pairwise
+    /// tree. Results are bit-identical for any thread count, executor or
+    /// steal pattern, at the cost of one extra store per block. Device
+    /// offload is off, since it would round differently. GEMM and the
+    /// factorizations never split a sum across tasks, so they are
+    /// reproducible in either mode. Bits still depend on the kernel ISA;
+    /// pin LANA_ISA to compare across machines.
+    Bitwise,
+};
+
+/// Sets the mode for later calls. The default is Fast, or Bitwise when
+/// LANA_DETERMINISM=bitwise.
+LANA_API void set_determinism(Determinism mode) noexcept;
+LANA_API Determinism determinism() noexcept;
+
+namespace detail {
+
+/// Runs body(i) for i in [0, n) on the current executor (see set_executor).
+LANA_API void parallel_run(index_t n, FunctionRef<void(index_t)> body);
+
+/// Concurrency parallel_run would use from the calling thread.
+LANA_API int parallel_concurrency() noexcept;
+
+/// Runs fn later on the current executor; right here when that is lana's
+/// pool without worker threads, since nothing else would ever run it.
+LANA_API void post(std::function<void()> fn);
+
+}  // namespace detail
+
+/// Calls f(lo, hi) over disjoint subranges covering [begin, end), each at
+/// least `grain` long (except possibly the last), in parallel.
+template <typename F>
+void parallel_for(index_t begin, index_t end, index_t grain, F&& f) {
+    const index_t n = end - begin;
+    if (n <= 0) {
+        return;
+    }
+    grain = std::max<index_t>(grain, 1);
+    const index_t max_chunks = 4 * static_cast<index_t>(detail::parallel_concurrency());
+    const index_t chunks = std::clamp<index_t>((n + grain - 1) / grain, 1, max_chunks);
+    if (chunks == 1) {
+        f(begin, end);
+        return;
+    }
+    const index_t step = (n + chunks - 1) / chunks;
+    detail::parallel_run(chunks, [&](index_t c) {
+        const index_t lo = begin + c * step;
+        const index_t hi = std::min(end, lo + step);
+        if (lo < hi) {
+            f(lo, hi);
+        }
+    });
+}
+
+}  // namespace lana
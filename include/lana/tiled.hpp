@@ -0,0 +1,276 @@
+#pragma once
+
+/// Tile-major storage for block algorithms.
+///
+/// A TiledMatrix keeps every tile x tile block of the matrix in its own
+/// contiguous column-major slot. A block algorithm walking tiles then
+/// touches a few pages per tile rather than one page per column, as a
+/// large column- or row-major matrix does. Slots follow one of two orders:
+///
+///   - TileOrder::ColumnMajor: tile (i, j) follows tile (i - 1, j);
+///   - TileOrder::Morton: Z-order over the tile grid, so tiles that are
+///     close in either direction are also close in memory.
+///
+/// tile(i, j) is an ordinary MatrixView with leading dimension tile_size().
+/// Every lana kernel takes it without a copy, like a block(), t() or
+/// row-major view of a Matrix. gemm and potrf below run directly on tiled
+/// operands, one tile call at a time.
+///
+///     lana::TiledMatrix<double> a(spd_view, 256);   // copy in, Morton order
+///     lana::potrf(a);                               // DAG over the tiles
+///     lana::trsm(..., a.tile(0, 0), x);             // any tile, any kernel
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lana {
+
+enum class TileOrder {
+    ColumnMajor,
+    Morton,
+};
+
+namespace detail {
+
+/// The low 32 bits of v moved to the even bit positions.
+constexpr std::uint64_t spread_bits(std::uint64_t v) noexcept {
+    v &= 0xffffffffu;
+    v = (v | (v << 16)) & 0x0000ffff0000ffffu;
+    v = (v | (v << 8)) & 0x00ff00ff00ff00ffu;
+    v = (v | (v << 4)) & 0x0f0f0f0f0f0f0f0fu;
+    v = (v | (v << 2)) & 0x3333333333333333u;
+    v = (v | (v << 1)) & 0x5555555555555555u;
+    return v;
+}
+
+/// Z-order key of tile (i, j): the bits of i and j interleaved.
+constexpr std::uint64_t morton_key(index_t i, index_t j) noexcept {
+    return spread_bits(static_cast<std::uint64_t>(i)) | (spread_bits(static_cast<std::uint64_t>(j)) << 1);
+}
+
+}  // namespace detail
+
+/// Owning rows x cols matrix stored as tile x tile blocks (the last tile
+/// row and column may be shorter). Element access goes through a slot
+/// table. Kernels should work on tile() views.
+template <typename T>
+class TiledMatrix {
+    static_assert(std::is_trivially_copyable_v<T>, "lana::TiledMatrix requires a trivially copyable element type");
+
+public:
+    using value_type = T;
+
+    TiledMatrix() = default;
+
+    /// Zero matrix.
+    TiledMatrix(index_t rows, index_t cols, index_t tile = 128, TileOrder order = TileOrder::Morton)
+        : TiledMatrix(rows, cols, tile, order, uninitialized) {
+        fill(T(0));
+    }
+
+    /// Matrix whose contents are indeterminate.
+    TiledMatrix(index_t rows, index_t cols, index_t tile, TileOrder order, Uninitialized)
+        : TiledMatrix(rows, cols, tile, order, uninitialized, AllocPolicy{}) {}
+
+    /// Zero matrix whose storage follows `policy` (see AllocPolicy). With
+    /// policy.first_touch the pool writes it tile by tile in storage order,
+    /// the way tiled gemm hands out C's tiles.
+    TiledMatrix(index_t rows, index_t cols, index_t tile, TileOrder order, const AllocPolicy& policy)
+        : TiledMatrix(rows, cols, tile, order, uninitialized, policy, policy.mapped() && policy.first_touch) {
+        if (policy.mapped()) {
+            return;
+        }
+        if (policy.first_touch) {
+            detail::first_touch(buf_.data(), buf_.size() * sizeof(T), tile_bytes(), true);
+        } else {
+            fill(T(0));
+        }
+    }
+
+    /// Matrix under `policy` whose contents are indeterminate; with
+    /// policy.first_touch its pages are already placed.
+    TiledMatrix(index_t rows, index_t cols, index_t tile, TileOrder order, Uninitialized, const AllocPolicy& policy)
+        : TiledMatrix(rows, cols, tile, order, uninitialized, policy, policy.first_touch) {}
+
+    /// Tiled copy of a strided view.
+    explicit TiledMatrix(MatrixView<const T> src, index_t tile = 128, TileOrder order = TileOrder::Morton)
+        : TiledMatrix(src.rows(), src.cols(), tile, order, uninitialized) {
+        copy_from(src);
+    }
+
+    /// Copies keep the source's AllocPolicy.
+    TiledMatrix(const TiledMatrix& other)
+        : buf_(other.buf_.size(), other.buf_.policy()),
+          rows_(other.rows_),
+          cols_(other.cols_),
+          tile_(other.tile_),
+          order_(other.order_),
+          row_tiles_(other.row_tiles_),
+          col_tiles_(other.col_tiles_),
+          slot_(other.slot_),
+          at_(other.at_) {
+        if (buf_.size() > 0) {
+            std::memcpy(buf_.data(), other.buf_.data(), buf_.size() * sizeof(T));
+        }
+    }
+    TiledMatrix& operator=(const TiledMatrix& other) {
+        if (this != &other) {
+            *this = TiledMatrix(other);
+        }
+        return *this;
+    }
+    TiledMatrix(TiledMatrix&&) noexcept = default;
+    TiledMatrix& operator=(TiledMatrix&&) noexcept = default;
+
+    index_t rows() const noexcept { return rows_; }
+    index_t cols() const noexcept { return cols_; }
+    index_t tile_size() const noexcept { return tile_; }
+    TileOrder order() const noexcept { return order_; }
+    const AllocPolicy& alloc_policy() const noexcept { return buf_.policy(); }
+    /// Tiles down a column and along a row of the tile grid.
+    index_t row_tiles() const noexcept { return row_tiles_; }
+    index_t col_tiles() const noexcept { return col_tiles_; }
+    index_t tile_count() const noexcept { return row_tiles_ * col_tiles_; }
+
+    /// Tile (i, j), tile(i, j).rows() x tile(i, j).cols(), in its slot.
+    MatrixView<T> tile(index_t i, index_t j) noexcept {
+        return MatrixView<T>(slot_data(slot(i, j)), extent(i, rows_), extent(j, cols_), 1, tile_);
+    }
+    MatrixView<const T> tile(index_t i, index_t j) const noexcept {
+        return MatrixView<const T>(slot_data(slot(i, j)), extent(i, rows_), extent(j, cols_), 1, tile_);
+    }
+
+    /// Grid coordinates of the tile in storage slot `s`; visiting s = 0, 1,
+    /// ... walks memory in order.
+    std::pair<index_t, index_t> tile_at(index_t s) const noexcept {
+        const index_t t = at_[static_cast<std::size_t>(s)];
+        return {t % row_tiles_, t / row_tiles_};
+    }
+
+    T& operator()(index_t i, index_t j) noexcept {
+        return slot_data(slot(i / tile_, j / tile_))[i % tile_ + (j % tile_) * tile_];
+    }
+    const T& operator()(index_t i, index_t j) const noexcept {
+        return slot_data(slot(i / tile_, j / tile_))[i % tile_ + (j % tile_) * tile_];
+    }
+
+    /// Sets every element, padding included.
+    void fill(T value) noexcept { std::fill_n(buf_.data(), buf_.size(), value); }
+
+    /// Copies `src` in; shapes must agree.
+    void copy_from(MatrixView<const T> src) {
+        detail::require_dims(src.rows() == rows_ && src.cols() == cols_, "TiledMatrix::copy_from");
+        for_tiles([&](index_t i, index_t j) {
+            copy_tile(src.block(i * tile_, j * tile_, extent(i, rows_), extent(j, cols_)), tile(i, j));
+        });
+    }
+
+    /// Copies the matrix out into `dst`; shapes must agree.
+    void copy_to(MatrixView<T> dst) const {
+        detail::require_dims(dst.rows() == rows_ && dst.cols() == cols_, "TiledMatrix::copy_to");
+        for_tiles([&](index_t i, index_t j) {
+            copy_tile(tile(i, j), dst.block(i * tile_, j * tile_, extent(i, rows_), extent(j, cols_)));
+        });
+    }
+
+    /// Column-major copy.
+    Matrix<T> to_matrix() const {
+        Matrix<T> m(rows_, cols_, uninitialized);
+        copy_to(m.view());
+        return m;
+    }
+
+private:
+    TiledMatrix(index_t rows, index_t cols, index_t tile, TileOrder order, Uninitialized, const AllocPolicy& policy,
+                bool touch)
+        : rows_(rows), cols_(cols), tile_(tile), order_(order) {
+        detail::require_dims(rows >= 0 && cols >= 0 && tile > 0, "TiledMatrix");
+        row_tiles_ = (rows + tile - 1) / tile;
+        col_tiles_ = (cols + tile - 1) / tile;
+        const index_t count = row_tiles_ * col_tiles_;
+        buf_ = detail::AlignedBuffer<T>(static_cast<std::size_t>(count * tile * tile), policy);
+        at_.resize(static_cast<std::size_t>(count));
+        std::iota(at_.begin(), at_.end(), index_t(0));
+        if (order == TileOrder::Morton) {
+            const index_t tr = row_tiles_;
+            std::sort(at_.begin(), at_.end(), [tr](index_t x, index_t y) {
+                return detail::morton_key(x % tr, x / tr) < detail::morton_key(y % tr, y / tr);
+            });
+        }
+        slot_.resize(static_cast<std::size_t>(count));
+        for (index_t s = 0; s < count; ++s) {
+            slot_[static_cast<std::size_t>(at_[static_cast<std::size_t>(s)])] = s;
+        }
+        if (touch) {
+            detail::first_touch(buf_.data(), buf_.size() * sizeof(T), tile_bytes(), false);
+        }
+    }
+
+    std::size_t tile_bytes() const noexcept { return static_cast<std::size_t>(tile_ * tile_) * sizeof(T); }
+
+    index_t slot(index_t i, index_t j) const noexcept { return slot_[static_cast<std::size_t>(i + j * row_tiles_)]; }
+    T* slot_data(index_t s) noexcept { return buf_.data() + s * tile_ * tile_; }
+    const T* slot_data(index_t s) const noexcept { return buf_.data() + s * tile_ * tile_; }
+    /// Length of tile index `t` along a dimension of `total` elements.
+    index_t extent(index_t t, index_t total) const noexcept { return std::min(tile_, total - t * tile_); }
+
+    /// Calls f(i, j) for every tile, in storage order.
+    template <typename F>
+    void for_tiles(F&& f) const {
+        for (index_t s = 0; s < tile_count(); ++s) {
+            const auto [i, j] = tile_at(s);
+            f(i, j);
+        }
+    }
+
+    template <typename U>
+    static void copy_tile(MatrixView<const T> src, MatrixView<U> dst) {
+        for (index_t c = 0; c < src.cols(); ++c) {
+            if (src.row_stride() == 1 && dst.row_stride() == 1) {
+                std::memcpy(&dst(0, c), &src(0, c), static_cast<std::size_t>(src.rows()) * sizeof(T));
+            } else {
+                for (index_t r = 0; r < src.rows(); ++r) {
+                    dst(r, c) = src(r, c);
+                }
+            }
+        }
+    }
+
+    detail::AlignedBuffer<T> buf_;
+    index_t rows_ = 0;
+    index_t cols_ = 0;
+    index_t tile_ = 0;
+    TileOrder order_ = TileOrder::Morton;
+    index_t row_tiles_ = 0;
+    index_t col_tiles_ = 0;
+    std::vector<index_t> slot_;  // tile (i, j), at i + j * row_tiles_ -> storage slot
+    std::vector<index_t> at_;    // storage slot -> the tile's i + j * row_tiles_
+};
+
+/// C = alpha * A * B + beta * C, tile by tile: C(i, j) accumulates
+/// A(i, p) * B(p, j) over p in order, one gemm per tile pair. The three
+/// operands must share a tile size. C tiles are spread over the pool in
+/// storage order, so with Morton order each thread works on a compact
+/// patch of C.
+LANA_API void gemm(float alpha, const TiledMatrix<float>& a, const TiledMatrix<float>& b, float beta,
+                   TiledMatrix<float>& c);
+LANA_API void gemm(double alpha, const TiledMatrix<double>& a, const TiledMatrix<double>& b, double beta,
+                   TiledMatrix<double>& c);
+
+/// Cholesky of a tiled SPD matrix in place, as lana::potrf: the lower
+/// tiles hold L, the strict upper tiles are left alone. The tile DAG is
+/// the same as potrf's own, with each task working on one contiguous tile.
+LANA_API index_t potrf(TiledMatrix<float>& a);
+LANA_API index_t potrf(TiledMatrix<double>& a);
+
+}  // namespace lana
@@ -0,0 +1,171 @@
+#pragma once
+
+#include "lana/config.hpp"
+#include "lana/error.hpp"
+#include "lana/expr.hpp"
+#include "lana/memory.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <initializer_list>
+#include <type_traits>
+#include <utility>
+
+namespace lana {
+
+/// Non-owning view of a strided 1-D array; element i is `data()[i * stride()]`.
+template <typename T>
+class VectorView {
+public:
+    using value_type = std::remove_const_t<T>;
+
+    VectorView() = default;
+    VectorView(T* data, index_t size, index_t stride = 1) noexcept : data_(data), size_(size), stride_(stride) {}
+
+    template <typename U, typename = std::enable_if_t<std::is_same_v<const U, T> && !std::is_same_v<U, T>>>
+    VectorView(const VectorView<U>& other) noexcept : VectorView(other.data(), other.size(), other.stride()) {}
+
+    T* data() const noexcept { return data_; }
+    index_t size() const noexcept { return size_; }
+    index_t stride() const noexcept { return stride_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& operator[](index_t i) const noexcept { return data_[i * stride_]; }
+    T& operator()(index_t i) const noexcept { return data_[i * stride_]; }
+
+    /// Elements [i, i + n).
+    VectorView segment(index_t i, index_t n) const noexcept { return VectorView(data_ + i * stride_, n, stride_); }
+
+    /// Writes an expression into the viewed elements. Assigning another view
+    /// rebinds instead; use assign() to copy through a view.
+    template <typename E>
+    const VectorView& operator=(const expr::Base<E>& e) const {
+        assign(e);
+        return *this;
+    }
+    template <expr::Operand E>
+    void assign(const E& e) const {
+        static_assert(!std::is_const_v<T>, "cannot assign through a read-only view");
+        detail::assign_expr(data_, size_, 1, stride_, size_ * stride_, expr::as_expr(e));
+    }
+    template <expr::Operand E>
+    const VectorView& operator+=(const E& e) const {
+        assign(*this + e);
+        return *this;
+    }
+    template <expr::Operand E>
+    const VectorView& operator-=(const E& e) const {
+        assign(*this - e);
+        return *this;
+    }
+    const VectorView& operator*=(value_type s) const {
+        assign(s * *this);
+        return *this;
+    }
+
+private:
+    T* data_ = nullptr;
+    index_t size_ = 0;
+    index_t stride_ = 1;
+};
+
+/// Owning contiguous vector, 64-byte aligned.
+template <typename T>
+class Vector {
+    static_assert(std::is_trivially_copyable_v<T>, "lana::Vector requires a trivially copyable element type");
+
+public:
+    using value_type = T;
+
+    Vector() = default;
+    explicit Vector(index_t n) : Vector(n, T(0)) {}
+    Vector(index_t n, T value) : buf_(static_cast<std::size_t>(n)), size_(n) { std::fill_n(data(), n, value); }
+    Vector(index_t n, Uninitialized) : buf_(static_cast<std::size_t>(n)), size_(n) {}
+    Vector(std::initializer_list<T> init) : Vector(static_cast<index_t>(init.size()), uninitialized) {
+        std::copy(init.begin(), init.end(), data());
+    }
+    explicit Vector(VectorView<const T> src) : Vector(src.size(), uninitialized) { copy_from(src); }
+
+    /// Evaluates an elementwise expression (see expr.hpp) in a single pass.
+    template <typename E>
+    Vector(const expr::Base<E>& e) : Vector(e.self().rows(), uninitialized) {  // NOLINT(google-explicit-constructor)
+        detail::require_dims(e.self().cols() == 1, "Vector from expression");
+        view().assign(e);
+    }
+    template <typename E>
+    Vector& operator=(const expr::Base<E>& e) {
+        detail::require_dims(e.self().cols() == 1, "Vector from expression");
+        if (size_ != e.self().rows()) {
+            *this = Vector(e.self().rows(), uninitialized);
+        }
+        view().assign(e);
+        return *this;
+    }
+    template <expr::Operand E>
+    Vector& operator+=(const E& e) {
+        view() += e;
+        return *this;
+    }
+    template <expr::Operand E>
+    Vector& operator-=(const E& e) {
+        view() -= e;
+        return *this;
+    }
+    Vector& operator*=(T s) {
+        view() *= s;
+        return *this;
+    }
+
+    Vector(const Vector& other) : Vector(other.view()) {}
+    Vector& operator=(const Vector& other) {
+        if (this != &other) {
+            if (size_ != other.size_) {
+                *this = Vector(other.size_, uninitialized);
+            }
+            copy_from(other.view());
+        }
+        return *this;
+    }
+    Vector(Vector&& other) noexcept : buf_(std::move(other.buf_)), size_(std::exchange(other.size_, 0)) {}
+    Vector& operator=(Vector&& other) noexcept {
+        buf_ = std::move(other.buf_);
+        size_ = std::exchange(other.size_, 0);
+        return *this;
+    }
+
+    T* data() noexcept { return buf_.data(); }
+    const T* data() const noexcept { return buf_.data(); }
+    index_t size() const noexcept { return size_; }
+    bool empty() const noexcept { return size_ == 0; }
+
+    T& operator[](index_t i) noexcept { return data()[i]; }
+    const T& operator[](index_t i) const noexcept { return data()[i]; }
+    T& operator()(index_t i) noexcept { return data()[i]; }
+    const T& operator()(index_t i) const noexcept { return data()[i]; }
+
+    VectorView<T> view() noexcept { return VectorView<T>(data(), size_); }
+    VectorView<const T> view() const noexcept { return VectorView<const T>(data(), size_); }
+    operator VectorView<T>() noexcept { return view(); }
+    operator VectorView<const T>() const noexcept { return view(); }
+
+    void fill(T value) noexcept { std::fill_n(data(), size_, value); }
+
+    void copy_from(VectorView<const T> src) {
+        detail::require_dims(src.size() == size_, "Vector::copy_from");
+        if (src.stride() == 1) {
+            if (size_ > 0) {
+                std::memcpy(data(), src.data(), static_cast<std::size_t>(size_) * sizeof(T));
+            }
+            return;
+        }
+        for (index_t i = 0; i < size_; ++i) {
+            data()[i] = src[i];
+        }
+    }
+
+private:
+    detail::AlignedBuffer<T> buf_;
+    index_t size_ = 0;
+};
+
+}  // namespace lana
@@ -0,0 +1,32 @@
+#pragma once
+
+/// Up-front initialization, for processes that would rather pay for it
+/// before their first request than during it.
+///
+/// Loading liblana runs no code beyond constant initialization: no CPUID
+/// probing, no file reads, no threads. Each piece of per-process state is
+/// set up by the first call that needs it. The first GEMM selects the
+/// kernel tables, reads the cache sizes and the tuning file and starts the
+/// thread pool, so a cold call can take milliseconds where a warm one takes
+/// microseconds. warmup() does all of that now instead:
+///
+///     lana::set_num_threads(4);   // if the default is not wanted
+///     lana::warmup();
+///
+/// It is safe to call from several threads; only the first call does any
+/// work. Anything it does not cover stays lazy: the bfloat16 kernels (and
+/// the AMX state they request), the GPU plugin and per-thread scratch of
+/// threads outside the pool.
+
+#include "lana/config.hpp"
+
+namespace lana {
+
+/// Selects the SIMD kernel tables (see active_isa), probes the cache sizes
+/// and NUMA topology, loads the GEMM tuning file, reads LANA_PROFILE, and
+/// starts lana's thread pool (unless set_executor() has routed lana
+/// elsewhere), then runs one empty parallel region on it. Honours
+/// set_num_threads() calls made before it.
+LANA_API void warmup();
+
+}  // namespace lana
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "lana/config.hpp"
+#include "lana/matrix.hpp"
+#include "lana/memory.hpp"
+#include "lana/vector.hpp"
+
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace lana {
+
+struct WorkspaceOptions {
+    /// Bytes reserved up front; the arena grows on demand either way.
+    std::size_t initial_bytes = 0;
+    /// Back chunks with 2 MiB-aligned anonymous mappings and ask the kernel
+    /// for transparent huge pages (madvise). Falls back to ordinary pages.
+    /// Shorthand for policy.pages = PageSize::Transparent.
+    bool huge_pages = false;
+    /// Page size and NUMA placement of the chunks (see AllocPolicy).
+    /// first_touch does not apply: scratch is written by the thread that
+    /// owns the workspace, which places it. Unless policy.strict, a chunk
+    /// that cannot be mapped comes from ordinary memory.
+    AllocPolicy policy;
+};
+
+/// Bump-pointer arena for scratch memory.
+///
+/// Allocations are released together, in LIFO order, by rolling back to a
+/// mark (usually through Workspace::Scope). Memory is never returned to the
+/// system until the workspace is destroyed: when the arena has had to grow
+/// into several chunks and is rolled back to empty, they are merged into one
+/// chunk of the combined size, so a repeated workload stops allocating after
+/// its first run.
+///
+/// A Workspace is not thread-safe; use one per thread (see thread_workspace).
+class LANA_API Workspace {
+public:
+    struct Mark {
+        std::size_t chunk = 0;
+        std::size_t offset = 0;
+    };
+
+    /// Rolls the workspace back to where it was on construction.
+    class Scope {
+    public:
+        explicit Scope(Workspace& ws) noexcept : ws_(ws), mark_(ws.mark()) {}
+        ~Scope() { ws_.release(mark_); }
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        Workspace& ws_;
+        Mark mark_;
+    };
+
+    explicit Workspace(WorkspaceOptions options = {});
+    ~Workspace();
+
+    Workspace(Workspace&& other) noexcept;
+    Workspace& operator=(Workspace&& other) noexcept;
+    Workspace(const Workspace&) = delete;
+    Workspace& operator=(const Workspace&) = delete;
+
+    /// Uninitialized storage for `bytes` bytes aligned to `alignment` (a
+    /// power of two, at most 4096). Never returns nullptr for bytes > 0.
+    void* allocate(std::size_t bytes, std::size_t alignment = default_alignment);
+
+    /// Uninitialized, 64-byte aligned storage for `n` elements of T.
+    template <typename T>
+    T* allocate_n(std::size_t n) {
+        static_assert(std::is_trivially_copyable_v<T>, "Workspace holds trivially copyable types only");
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T) > default_alignment ? alignof(T) : default_alignment));
+    }
+
+    /// Uninitialized column-major rows x cols scratch matrix.
+    template <typename T>
+    MatrixView<T> matrix(index_t rows, index_t cols) {
+        return MatrixView<T>(allocate_n<T>(static_cast<std::size_t>(rows * cols)), rows, cols, 1, rows);
+    }
+
+    /// Uninitialized contiguous scratch vector.
+    template <typename T>
+    VectorView<T> vector(index_t n) {
+        return VectorView<T>(allocate_n<T>(static_cast<std::size_t>(n)), n);
+    }
+
+    Mark mark() const noexcept { return {cur_, chunks_.empty() ? 0 : chunks_[cur_].used}; }
+
+    /// Frees everything allocated after `m`.
+    void release(Mark m) noexcept;
+
+    /// Frees everything.
+    void reset() noexcept { release(Mark{}); }
+
+    /// Makes sure `bytes` can be allocated from an empty workspace without
+    /// growing. Only valid while nothing is allocated.
+    void reserve(std::size_t bytes);
+
+    /// Bytes currently handed out, including alignment padding.
+    std::size_t used() const noexcept;
+    /// Bytes held across all chunks.
+    std::size_t capacity() const noexcept;
+    /// Largest used() seen so far.
+    std::size_t high_water() const noexcept { return high_water_; }
+
+private:
+    struct Chunk {
+        char* data = nullptr;
+        std::size_t size = 0;
+        std::size_t used = 0;
+        bool mapped = false;  // from policy_alloc rather than aligned_alloc
+    };
+
+    AllocPolicy chunk_policy() const noexcept;
+    void add_chunk(std::size_t min_bytes);
+    void free_chunk(Chunk& c) noexcept;
+    void merge_chunks() noexcept;
+
+    WorkspaceOptions options_;
+    std::vector<Chunk> chunks_;
+    std::size_t cur_ = 0;
+    std::size_t high_water_ = 0;
+};
+
+/// The calling thread's workspace, created on first use. lana's own kernels
+/// draw packing buffers and other scratch from it under a Scope, so callers
+/// may use it too as long as they release in LIFO order.
+LANA_API Workspace& thread_workspace();
+
+}  // namespace lana
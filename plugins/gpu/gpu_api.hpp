@@ -0,0 +1,311 @@
+#pragma once
+
+// The slice of the CUDA (runtime, cuBLAS, cuSOLVER, cuSPARSE) and HIP
+// (runtime, hipBLAS, hipSOLVER, hipSPARSE) APIs the plugin uses, behind
+// one set of names. LANA_GPU_HIP selects HIP. Wrappers return true on
+// success; dimensions are checked to fit the libraries' int arguments by
+// the caller.
+
+#include <climits>
+#include <cstdio>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(LANA_GPU_HIP)
+#  include <hip/hip_runtime.h>
+#  include <hipblas/hipblas.h>
+#  include <hipsolver/hipsolver.h>
+#  include <hipsparse/hipsparse.h>
+#  define LANA_GPU_PLATFORM "hip"
+#else
+#  include <cublas_v2.h>
+#  include <cuda_runtime.h>
+#  include <cusolverDn.h>
+#  include <cusparse.h>
+#  define LANA_GPU_PLATFORM "cuda"
+#endif
+
+namespace lana_gpu {
+
+#if defined(LANA_GPU_HIP)
+
+using Stream = hipStream_t;
+using Event = hipEvent_t;
+using BlasHandle = hipblasHandle_t;
+using SolverHandle = hipsolverDnHandle_t;
+using SparseHandle = hipsparseHandle_t;
+using SpMat = hipsparseSpMatDescr_t;
+using DnVec = hipsparseDnVecDescr_t;
+
+inline bool set_device(int d) { return hipSetDevice(d) == hipSuccess; }
+inline int device_count() {
+    int n = 0;
+    return hipGetDeviceCount(&n) == hipSuccess ? n : 0;
+}
+inline bool device_name(int d, char* out, std::size_t n) {
+    hipDeviceProp_t p;
+    if (hipGetDeviceProperties(&p, d) != hipSuccess) {
+        return false;
+    }
+    std::snprintf(out, n, "%s", p.name);
+    return true;
+}
+inline bool memory_total(std::size_t* total) {
+    std::size_t free = 0;
+    return hipMemGetInfo(&free, total) == hipSuccess;
+}
+
+inline bool malloc_device(void** p, std::size_t n) { return hipMalloc(p, n) == hipSuccess; }
+inline void free_device(void* p) { (void)hipFree(p); }
+inline bool malloc_host(void** p, std::size_t n) { return hipHostMalloc(p, n, hipHostMallocDefault) == hipSuccess; }
+inline void free_host(void* p) { (void)hipHostFree(p); }
+
+inline bool stream_create(Stream* s) { return hipStreamCreateWithFlags(s, hipStreamNonBlocking) == hipSuccess; }
+inline void stream_destroy(Stream s) { (void)hipStreamDestroy(s); }
+inline bool stream_sync(Stream s) { return hipStreamSynchronize(s) == hipSuccess; }
+inline bool stream_wait(Stream s, Event e) { return hipStreamWaitEvent(s, e, 0) == hipSuccess; }
+inline bool event_create(Event* e) { return hipEventCreateWithFlags(e, hipEventDisableTiming) == hipSuccess; }
+inline bool event_create_timed(Event* e) { return hipEventCreate(e) == hipSuccess; }
+inline void event_destroy(Event e) { (void)hipEventDestroy(e); }
+inline bool event_record(Event e, Stream s) { return hipEventRecord(e, s) == hipSuccess; }
+inline bool event_sync(Event e) { return hipEventSynchronize(e) == hipSuccess; }
+inline bool event_ms(Event a, Event b, float* ms) { return hipEventElapsedTime(ms, a, b) == hipSuccess; }
+
+inline bool copy_h2d(void* d, const void* h, std::size_t n, Stream s) {
+    return hipMemcpyAsync(d, h, n, hipMemcpyHostToDevice, s) == hipSuccess;
+}
+inline bool copy_d2h(void* h, const void* d, std::size_t n, Stream s) {
+    return hipMemcpyAsync(h, d, n, hipMemcpyDeviceToHost, s) == hipSuccess;
+}
+
+inline bool blas_create(BlasHandle* h, Stream s) {
+    return hipblasCreate(h) == HIPBLAS_STATUS_SUCCESS && hipblasSetStream(*h, s) == HIPBLAS_STATUS_SUCCESS;
+}
+inline void blas_destroy(BlasHandle h) { (void)hipblasDestroy(h); }
+
+inline hipblasOperation_t blas_op(bool trans) { return trans ? HIPBLAS_OP_T : HIPBLAS_OP_N; }
+
+inline bool gemm(BlasHandle h, bool ta, bool tb, int m, int n, int k, float alpha, const float* a, int lda,
+                 const float* b, int ldb, float beta, float* c, int ldc) {
+    return hipblasSgemm(h, blas_op(ta), blas_op(tb), m, n, k, &alpha, a, lda, b, ldb, &beta, c, ldc) ==
+           HIPBLAS_STATUS_SUCCESS;
+}
+inline bool gemm(BlasHandle h, bool ta, bool tb, int m, int n, int k, double alpha, const double* a, int lda,
+                 const double* b, int ldb, double beta, double* c, int ldc) {
+    return hipblasDgemm(h, blas_op(ta), blas_op(tb), m, n, k, &alpha, a, lda, b, ldb, &beta, c, ldc) ==
+           HIPBLAS_STATUS_SUCCESS;
+}
+/// c (m x n) = a^T, with a n x m.
+inline bool transpose(BlasHandle h, int m, int n, const float* a, int lda, float* c, int ldc) {
+    const float one = 1;
+    const float zero = 0;
+    return hipblasSgeam(h, HIPBLAS_OP_T, HIPBLAS_OP_N, m, n, &one, a, lda, &zero, c, ldc, c, ldc) ==
+           HIPBLAS_STATUS_SUCCESS;
+}
+inline bool transpose(BlasHandle h, int m, int n, const double* a, int lda, double* c, int ldc) {
+    const double one = 1;
+    const double zero = 0;
+    return hipblasDgeam(h, HIPBLAS_OP_T, HIPBLAS_OP_N, m, n, &one, a, lda, &zero, c, ldc, c, ldc) ==
+           HIPBLAS_STATUS_SUCCESS;
+}
+
+inline bool solver_create(SolverHandle* h, Stream s) {
+    return hipsolverDnCreate(h) == HIPSOLVER_STATUS_SUCCESS && hipsolverDnSetStream(*h, s) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline void solver_destroy(SolverHandle h) { (void)hipsolverDnDestroy(h); }
+
+inline bool getrf_work(SolverHandle h, int m, int n, float* a, int lda, int* lwork) {
+    return hipsolverDnSgetrf_bufferSize(h, m, n, a, lda, lwork) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool getrf_work(SolverHandle h, int m, int n, double* a, int lda, int* lwork) {
+    return hipsolverDnDgetrf_bufferSize(h, m, n, a, lda, lwork) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool getrf(SolverHandle h, int m, int n, float* a, int lda, float* work, int lwork, int* ipiv, int* info) {
+    return hipsolverDnSgetrf(h, m, n, a, lda, work, lwork, ipiv, info) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool getrf(SolverHandle h, int m, int n, double* a, int lda, double* work, int lwork, int* ipiv, int* info) {
+    return hipsolverDnDgetrf(h, m, n, a, lda, work, lwork, ipiv, info) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf_work(SolverHandle h, int n, float* a, int lda, int* lwork) {
+    return hipsolverDnSpotrf_bufferSize(h, HIPSOLVER_FILL_MODE_LOWER, n, a, lda, lwork) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf_work(SolverHandle h, int n, double* a, int lda, int* lwork) {
+    return hipsolverDnDpotrf_bufferSize(h, HIPSOLVER_FILL_MODE_LOWER, n, a, lda, lwork) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf(SolverHandle h, int n, float* a, int lda, float* work, int lwork, int* info) {
+    return hipsolverDnSpotrf(h, HIPSOLVER_FILL_MODE_LOWER, n, a, lda, work, lwork, info) == HIPSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf(SolverHandle h, int n, double* a, int lda, double* work, int lwork, int* info) {
+    return hipsolverDnDpotrf(h, HIPSOLVER_FILL_MODE_LOWER, n, a, lda, work, lwork, info) == HIPSOLVER_STATUS_SUCCESS;
+}
+
+inline bool sparse_create(SparseHandle* h, Stream s) {
+    return hipsparseCreate(h) == HIPSPARSE_STATUS_SUCCESS && hipsparseSetStream(*h, s) == HIPSPARSE_STATUS_SUCCESS;
+}
+inline void sparse_destroy(SparseHandle h) { (void)hipsparseDestroy(h); }
+
+inline hipDataType data_type(bool f64) { return f64 ? HIP_R_64F : HIP_R_32F; }
+
+inline bool csr_create(SpMat* a, std::int64_t rows, std::int64_t cols, std::int64_t nnz, void* row_ptr, void* col_idx,
+                       void* values, bool f64) {
+    return hipsparseCreateCsr(a, rows, cols, nnz, row_ptr, col_idx, values, HIPSPARSE_INDEX_32I, HIPSPARSE_INDEX_32I,
+                              HIPSPARSE_INDEX_BASE_ZERO, data_type(f64)) == HIPSPARSE_STATUS_SUCCESS;
+}
+inline void csr_destroy(SpMat a) { (void)hipsparseDestroySpMat(a); }
+inline bool vec_create(DnVec* v, std::int64_t n, void* data, bool f64) {
+    return hipsparseCreateDnVec(v, n, data, data_type(f64)) == HIPSPARSE_STATUS_SUCCESS;
+}
+inline void vec_destroy(DnVec v) { (void)hipsparseDestroyDnVec(v); }
+inline bool spmv_work(SparseHandle h, const void* alpha, SpMat a, DnVec x, const void* beta, DnVec y, bool f64,
+                      std::size_t* bytes) {
+    return hipsparseSpMV_bufferSize(h, HIPSPARSE_OPERATION_NON_TRANSPOSE, alpha, a, x, beta, y, data_type(f64),
+                                    HIPSPARSE_SPMV_ALG_DEFAULT, bytes) == HIPSPARSE_STATUS_SUCCESS;
+}
+inline bool spmv(SparseHandle h, const void* alpha, SpMat a, DnVec x, const void* beta, DnVec y, bool f64, void* work) {
+    return hipsparseSpMV(h, HIPSPARSE_OPERATION_NON_TRANSPOSE, alpha, a, x, beta, y, data_type(f64),
+                         HIPSPARSE_SPMV_ALG_DEFAULT, work) == HIPSPARSE_STATUS_SUCCESS;
+}
+
+#else  // CUDA
+
+using Stream = cudaStream_t;
+using Event = cudaEvent_t;
+using BlasHandle = cublasHandle_t;
+using SolverHandle = cusolverDnHandle_t;
+using SparseHandle = cusparseHandle_t;
+using SpMat = cusparseSpMatDescr_t;
+using DnVec = cusparseDnVecDescr_t;
+
+inline bool set_device(int d) { return cudaSetDevice(d) == cudaSuccess; }
+inline int device_count() {
+    int n = 0;
+    return cudaGetDeviceCount(&n) == cudaSuccess ? n : 0;
+}
+inline bool device_name(int d, char* out, std::size_t n) {
+    cudaDeviceProp p;
+    if (cudaGetDeviceProperties(&p, d) != cudaSuccess) {
+        return false;
+    }
+    std::snprintf(out, n, "%s", p.name);
+    return true;
+}
+inline bool memory_total(std::size_t* total) {
+    std::size_t free = 0;
+    return cudaMemGetInfo(&free, total) == cudaSuccess;
+}
+
+inline bool malloc_device(void** p, std::size_t n) { return cudaMalloc(p, n) == cudaSuccess; }
+inline void free_device(void* p) { (void)cudaFree(p); }
+inline bool malloc_host(void** p, std::size_t n) { return cudaMallocHost(p, n) == cudaSuccess; }
+inline void free_host(void* p) { (void)cudaFreeHost(p); }
+
+inline bool stream_create(Stream* s) { return cudaStreamCreateWithFlags(s, cudaStreamNonBlocking) == cudaSuccess; }
+inline void stream_destroy(Stream s) { (void)cudaStreamDestroy(s); }
+inline bool stream_sync(Stream s) { return cudaStreamSynchronize(s) == cudaSuccess; }
+inline bool stream_wait(Stream s, Event e) { return cudaStreamWaitEvent(s, e, 0) == cudaSuccess; }
+inline bool event_create(Event* e) { return cudaEventCreateWithFlags(e, cudaEventDisableTiming) == cudaSuccess; }
+inline bool event_create_timed(Event* e) { return cudaEventCreate(e) == cudaSuccess; }
+inline void event_destroy(Event e) { (void)cudaEventDestroy(e); }
+inline bool event_record(Event e, Stream s) { return cudaEventRecord(e, s) == cudaSuccess; }
+inline bool event_sync(Event e) { return cudaEventSynchronize(e) == cudaSuccess; }
+inline bool event_ms(Event a, Event b, float* ms) { return cudaEventElapsedTime(ms, a, b) == cudaSuccess; }
+
+inline bool copy_h2d(void* d, const void* h, std::size_t n, Stream s) {
+    return cudaMemcpyAsync(d, h, n, cudaMemcpyHostToDevice, s) == cudaSuccess;
+}
+inline bool copy_d2h(void* h, const void* d, std::size_t n, Stream s) {
+    return cudaMemcpyAsync(h, d, n, cudaMemcpyDeviceToHost, s) == cudaSuccess;
+}
+
+inline bool blas_create(BlasHandle* h, Stream s) {
+    return cublasCreate(h) == CUBLAS_STATUS_SUCCESS && cublasSetStream(*h, s) == CUBLAS_STATUS_SUCCESS;
+}
+inline void blas_destroy(BlasHandle h) { (void)cublasDestroy(h); }
+
+inline cublasOperation_t blas_op(bool trans) { return trans ? CUBLAS_OP_T : CUBLAS_OP_N; }
+
+inline bool gemm(BlasHandle h, bool ta, bool tb, int m, int n, int k, float alpha, const float* a, int lda,
+                 const float* b, int ldb, float beta, float* c, int ldc) {
+    return cublasSgemm(h, blas_op(ta), blas_op(tb), m, n, k, &alpha, a, lda, b, ldb, &beta, c, ldc) ==
+           CUBLAS_STATUS_SUCCESS;
+}
+inline bool gemm(BlasHandle h, bool ta, bool tb, int m, int n, int k, double alpha, const double* a, int lda,
+                 const double* b, int ldb, double beta, double* c, int ldc) {
+    return cublasDgemm(h, blas_op(ta), blas_op(tb), m, n, k, &alpha, a, lda, b, ldb, &beta, c, ldc) ==
+           CUBLAS_STATUS_SUCCESS;
+}
+/// c (m x n) = a^T, with a n x m.
+inline bool transpose(BlasHandle h, int m, int n, const float* a, int lda, float* c, int ldc) {
+    const float one = 1;
+    const float zero = 0;
+    return cublasSgeam(h, CUBLAS_OP_T, CUBLAS_OP_N, m, n, &one, a, lda, &zero, c, ldc, c, ldc) ==
+           CUBLAS_STATUS_SUCCESS;
+}
+inline bool transpose(BlasHandle h, int m, int n, const double* a, int lda, double* c, int ldc) {
+    const double one = 1;
+    const double zero = 0;
+    return cublasDgeam(h, CUBLAS_OP_T, CUBLAS_OP_N, m, n, &one, a, lda, &zero, c, ldc, c, ldc) ==
+           CUBLAS_STATUS_SUCCESS;
+}
+
+inline bool solver_create(SolverHandle* h, Stream s) {
+    return cusolverDnCreate(h) == CUSOLVER_STATUS_SUCCESS && cusolverDnSetStream(*h, s) == CUSOLVER_STATUS_SUCCESS;
+}
+inline void solver_destroy(SolverHandle h) { (void)cusolverDnDestroy(h); }
+
+inline bool getrf_work(SolverHandle h, int m, int n, float* a, int lda, int* lwork) {
+    return cusolverDnSgetrf_bufferSize(h, m, n, a, lda, lwork) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool getrf_work(SolverHandle h, int m, int n, double* a, int lda, int* lwork) {
+    return cusolverDnDgetrf_bufferSize(h, m, n, a, lda, lwork) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool getrf(SolverHandle h, int m, int n, float* a, int lda, float* work, int /*lwork*/, int* ipiv, int* info) {
+    return cusolverDnSgetrf(h, m, n, a, lda, work, ipiv, info) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool getrf(SolverHandle h, int m, int n, double* a, int lda, double* work, int /*lwork*/, int* ipiv,
+                  int* info) {
+    return cusolverDnDgetrf(h, m, n, a, lda, work, ipiv, info) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf_work(SolverHandle h, int n, float* a, int lda, int* lwork) {
+    return cusolverDnSpotrf_bufferSize(h, CUBLAS_FILL_MODE_LOWER, n, a, lda, lwork) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf_work(SolverHandle h, int n, double* a, int lda, int* lwork) {
+    return cusolverDnDpotrf_bufferSize(h, CUBLAS_FILL_MODE_LOWER, n, a, lda, lwork) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf(SolverHandle h, int n, float* a, int lda, float* work, int lwork, int* info) {
+    return cusolverDnSpotrf(h, CUBLAS_FILL_MODE_LOWER, n, a, lda, work, lwork, info) == CUSOLVER_STATUS_SUCCESS;
+}
+inline bool potrf(SolverHandle h, int n, double* a, int lda, double* work, int lwork, int* info) {
+    return cusolverDnDpotrf(h, CUBLAS_FILL_MODE_LOWER, n, a, lda, work, lwork, info) == CUSOLVER_STATUS_SUCCESS;
+}
+
+inline bool sparse_create(SparseHandle* h, Stream s) {
+    return cusparseCreate(h) == CUSPARSE_STATUS_SUCCESS && cusparseSetStream(*h, s) == CUSPARSE_STATUS_SUCCESS;
+}
+inline void sparse_destroy(SparseHandle h) { (void)cusparseDestroy(h); }
+
+inline cudaDataType data_type(bool f64) { return f64 ? CUDA_R_64F : CUDA_R_32F; }
+
+inline bool csr_create(SpMat* a, std::int64_t rows, std::int64_t cols, std::int64_t nnz, void* row_ptr, void* col_idx,
+                       void* values, bool f64) {
+    return cusparseCreateCsr(a, rows, cols, nnz, row_ptr, col_idx, values, CUSPARSE_INDEX_32I, CUSPARSE_INDEX_32I,
+                             CUSPARSE_INDEX_BASE_ZERO, data_type(f64)) == CUSPARSE_STATUS_SUCCESS;
+}
+inline void csr_destroy(SpMat a) { (void)cusparseDestroySpMat(a); }
+inline bool vec_create(DnVec* v, std::int64_t n, void* data, bool f64) {
+    return cusparseCreateDnVec(v, n, data, data_type(f64)) == CUSPARSE_STATUS_SUCCESS;
+}
+inline void vec_destroy(DnVec v) { (void)cusparseDestroyDnVec(v); }
+inline bool spmv_work(SparseHandle h, const void* alpha, SpMat a, DnVec x, const void* beta, DnVec y, bool f64,
+                      std::size_t* bytes) {
+    return cusparseSpMV_bufferSize(h, CUSPARSE_OPERATION_NON_TRANSPOSE, alpha, a, x, beta, y, data_type(f64),
+                                   CUSPARSE_SPMV_ALG_DEFAULT, bytes) == CUSPARSE_STATUS_SUCCESS;
+}
+inline bool spmv(SparseHandle h, const void* alpha, SpMat a, DnVec x, const void* beta, DnVec y, bool f64, void* work) {
+    return cusparseSpMV(h, CUSPARSE_OPERATION_NON_TRANSPOSE, alpha, a, x, beta, y, data_type(f64),
+                        CUSPARSE_SPMV_ALG_DEFAULT, work) == CUSPARSE_STATUS_SUCCESS;
+}
+
+#endif
+
+}  // namespace lana_gpu
@@ -0,0 +1,870 @@
+// lana device plugin for CUDA or HIP (LANA_GPU_HIP); see lana/device.hpp.
+//
+// One device and two streams: copies go on `copy_`, kernels on `compute_`,
+// ordered against each other with events. Host operands are staged
+// through two pinned buffers, so packing one chunk on the CPU overlaps the
+// transfer of the other, and a GEMM is cut into column panels of C so
+// panel p + 1 uploads while panel p computes. Device memory comes from a
+// cache that keeps freed blocks for reuse instead of returning them to the
+// driver. Every entry point drains both streams before it returns.
+
+#include "gpu_api.hpp"
+#include "lana/device_plugin.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace lana_gpu {
+namespace {
+
+/// Bytes per pinned staging buffer; there are two.
+constexpr std::size_t staging_bytes = std::size_t(32) << 20;
+/// Smallest device allocation; requests round up to a power of two from
+/// here so freed blocks fit nearby sizes.
+constexpr std::size_t granule = std::size_t(1) << 20;
+/// GEMM column panels are at least this wide; narrower C runs as one panel.
+constexpr std::int64_t min_panel_cols = 1024;
+
+bool fits_int(std::int64_t v) { return v >= 0 && v <= INT_MAX; }
+
+/// Cache of device blocks by size class.
+class DeviceCache {
+public:
+    DeviceCache() = default;
+    DeviceCache(const DeviceCache&) = delete;
+    DeviceCache& operator=(const DeviceCache&) = delete;
+    ~DeviceCache() {
+        trim();
+        for (const auto& [p, cls] : live_) {
+            free_device(p);
+        }
+    }
+
+    void* get(std::size_t bytes) {
+        std::size_t cls = granule;
+        while (cls < bytes) {
+            cls *= 2;
+        }
+        std::vector<void*>& list = free_[cls];
+        void* p = nullptr;
+        if (!list.empty()) {
+            p = list.back();
+            list.pop_back();
+        } else if (!malloc_device(&p, cls)) {
+            // Out of memory: hand the cached blocks back to the driver once.
+            trim();
+            if (!malloc_device(&p, cls)) {
+                return nullptr;
+            }
+        }
+        live_[p] = cls;
+        return p;
+    }
+
+    void put(void* p) {
+        if (p == nullptr) {
+            return;
+        }
+        const auto it = live_.find(p);
+        free_[it->second].push_back(p);
+        live_.erase(it);
+    }
+
+    void trim() {
+        for (auto& [cls, list] : free_) {
+            for (void* p : list) {
+                free_device(p);
+            }
+        }
+        free_.clear();
+    }
+
+private:
+    std::map<std::size_t, std::vector<void*>> free_;
+    std::map<void*, std::size_t> live_;
+};
+
+/// A block from the cache for the duration of one call.
+class DevBuf {
+public:
+    DevBuf(DeviceCache& cache, std::size_t bytes)
+        : cache_(&cache), p_(bytes > 0 ? cache.get(bytes) : nullptr), ok_(bytes == 0 || p_ != nullptr) {}
+    ~DevBuf() { cache_->put(p_); }
+    DevBuf(const DevBuf&) = delete;
+    DevBuf& operator=(const DevBuf&) = delete;
+
+    explicit operator bool() const noexcept { return ok_; }
+    template <typename T = std::byte>
+    T* as() const noexcept {
+        return static_cast<T*>(p_);
+    }
+
+private:
+    DeviceCache* cache_;
+    void* p_;
+    bool ok_;
+};
+
+/// Two pinned buffers for host <-> device copies of strided host data. A
+/// transfer is `lines` lines of `len` bytes, `host_ld` bytes apart on the
+/// host and `dev_ld` apart on the device; runs that are contiguous on both
+/// sides go as one copy.
+class Staging {
+public:
+    Staging() = default;
+    Staging(const Staging&) = delete;
+    Staging& operator=(const Staging&) = delete;
+    ~Staging() {
+        for (Slot& s : slots_) {
+            if (s.mem != nullptr) {
+                free_host(s.mem);
+            }
+            if (s.done != nullptr) {
+                event_destroy(s.done);
+            }
+        }
+    }
+
+    bool init() {
+        for (Slot& s : slots_) {
+            void* p = nullptr;
+            if (!malloc_host(&p, staging_bytes) || !event_create(&s.done)) {
+                return false;
+            }
+            s.mem = static_cast<std::byte*>(p);
+        }
+        return true;
+    }
+
+    std::byte* buffer() noexcept { return slots_[0].mem; }
+
+    bool upload(Stream st, const std::byte* host, std::int64_t host_ld, std::int64_t len, std::int64_t lines,
+                std::byte* dev, std::int64_t dev_ld) {
+        if (!next()) {
+            return false;
+        }
+        Run run{};
+        for (std::int64_t l = 0; l < lines; ++l) {
+            const std::byte* h = host + l * host_ld;
+            std::byte* d = dev + l * dev_ld;
+            std::size_t left = static_cast<std::size_t>(len);
+            while (left > 0) {
+                Slot& s = slots_[cur_];
+                if (s.used == staging_bytes) {
+                    if (!flush_h2d(st, run) || !event_record(s.done, st)) {
+                        return false;
+                    }
+                    s.in_flight = true;
+                    if (!next()) {
+                        return false;
+                    }
+                    continue;
+                }
+                const std::size_t n = std::min(left, staging_bytes - s.used);
+                std::memcpy(s.mem + s.used, h, n);
+                if (!extend(run, d, s.used, n) && (!flush_h2d(st, run) || !start(run, d, s.used, n))) {
+                    return false;
+                }
+                s.used += n;
+                h += n;
+                d += n;
+                left -= n;
+            }
+        }
+        Slot& s = slots_[cur_];
+        if (!flush_h2d(st, run) || !event_record(s.done, st)) {
+            return false;
+        }
+        s.in_flight = true;
+        return true;
+    }
+
+    /// Returns once the data is in host memory.
+    bool download(Stream st, const std::byte* dev, std::int64_t dev_ld, std::int64_t len, std::int64_t lines,
+                  std::byte* host, std::int64_t host_ld) {
+        if (!next()) {
+            return false;
+        }
+        Run run{};
+        for (std::int64_t l = 0; l < lines; ++l) {
+            const std::byte* d = dev + l * dev_ld;
+            std::byte* h = host + l * host_ld;
+            std::size_t left = static_cast<std::size_t>(len);
+            while (left > 0) {
+                Slot& s = slots_[cur_];
+                if (s.used == staging_bytes) {
+                    if (!flush_d2h(st, run) || !event_record(s.done, st)) {
+                        return false;
+                    }
+                    s.in_flight = true;
+                    if (!next()) {
+                        return false;
+                    }
+                    continue;
+                }
+                const std::size_t n = std::min(left, staging_bytes - s.used);
+                if (!extend(run, const_cast<std::byte*>(d), s.used, n) &&
+                    (!flush_d2h(st, run) || !start(run, const_cast<std::byte*>(d), s.used, n))) {
+                    return false;
+                }
+                s.unpack.push_back({s.used, h, n});
+                s.used += n;
+                d += n;
+                h += n;
+                left -= n;
+            }
+        }
+        Slot& s = slots_[cur_];
+        if (!flush_d2h(st, run) || !event_record(s.done, st)) {
+            return false;
+        }
+        s.in_flight = true;
+        return acquire(slots_[0]) && acquire(slots_[1]);
+    }
+
+private:
+    struct Piece {
+        std::size_t off;
+        std::byte* host;
+        std::size_t bytes;
+    };
+    struct Slot {
+        std::byte* mem = nullptr;
+        Event done = nullptr;
+        bool in_flight = false;
+        std::size_t used = 0;
+        std::vector<Piece> unpack;  // device -> host data waiting in `mem`
+    };
+    /// A pending copy between the current slot and the device.
+    struct Run {
+        std::byte* dev;
+        std::size_t off;
+        std::size_t bytes;
+    };
+
+    /// Waits for a slot's copies, delivers its downloads and empties it.
+    bool acquire(Slot& s) {
+        if (s.in_flight) {
+            if (!event_sync(s.done)) {
+                return false;
+            }
+            s.in_flight = false;
+        }
+        for (const Piece& p : s.unpack) {
+            std::memcpy(p.host, s.mem + p.off, p.bytes);
+        }
+        s.unpack.clear();
+        s.used = 0;
+        return true;
+    }
+
+    bool next() {
+        cur_ ^= 1;
+        return acquire(slots_[cur_]);
+    }
+
+    static bool extend(Run& r, std::byte* dev, std::size_t off, std::size_t n) {
+        if (r.bytes == 0 || r.dev + r.bytes != dev || r.off + r.bytes != off) {
+            return false;
+        }
+        r.bytes += n;
+        return true;
+    }
+    static bool start(Run& r, std::byte* dev, std::size_t off, std::size_t n) {
+        r = {dev, off, n};
+        return true;
+    }
+    bool flush_h2d(Stream st, Run& r) {
+        const bool ok = r.bytes == 0 || copy_h2d(r.dev, slots_[cur_].mem + r.off, r.bytes, st);
+        r.bytes = 0;
+        return ok;
+    }
+    bool flush_d2h(Stream st, Run& r) {
+        const bool ok = r.bytes == 0 || copy_d2h(slots_[cur_].mem + r.off, r.dev, r.bytes, st);
+        r.bytes = 0;
+        return ok;
+    }
+
+    Slot slots_[2];
+    int cur_ = 0;
+};
+
+/// A host matrix as column-major storage: `lines` lines of `len`
+/// elements, `ld` apart. `trans` when the storage holds the transpose
+/// (a row-major matrix).
+struct Storage {
+    std::byte* data;
+    std::int64_t len;
+    std::int64_t lines;
+    std::int64_t ld;
+    bool trans;
+};
+
+Storage storage_of(const lana_device_matrix& m) {
+    if (m.row_stride == 1) {
+        return {static_cast<std::byte*>(m.data), m.rows, m.cols, std::max(m.col_stride, m.rows), false};
+    }
+    return {static_cast<std::byte*>(m.data), m.cols, m.rows, std::max(m.row_stride, m.cols), true};
+}
+
+lana_device_matrix transposed(const lana_device_matrix& m) {
+    return {m.data, m.cols, m.rows, m.col_stride, m.row_stride, m.dtype};
+}
+
+struct CsrHandle {
+    std::int64_t rows;
+    std::int64_t cols;
+    std::int64_t nnz;
+    bool f64;
+    void* row_ptr;
+    void* col_idx;
+    void* values;
+    SpMat mat;
+    void* work;
+    std::size_t work_bytes;
+};
+
+class Plugin {
+public:
+    Plugin() = default;
+    Plugin(const Plugin&) = delete;
+    Plugin& operator=(const Plugin&) = delete;
+
+    ~Plugin() {
+        if (copy_ != nullptr) {
+            stream_sync(copy_);
+        }
+        if (compute_ != nullptr) {
+            stream_sync(compute_);
+        }
+        if (sparse_ != nullptr) {
+            sparse_destroy(sparse_);
+        }
+        if (solver_ != nullptr) {
+            solver_destroy(solver_);
+        }
+        if (blas_ != nullptr) {
+            blas_destroy(blas_);
+        }
+        for (Event e : {uploaded_[0], uploaded_[1], computed_[0], computed_[1], ready_}) {
+            if (e != nullptr) {
+                event_destroy(e);
+            }
+        }
+        for (Stream s : {copy_, compute_}) {
+            if (s != nullptr) {
+                stream_destroy(s);
+            }
+        }
+    }
+
+    bool init(int device) {
+        if (device < 0 || device >= device_count() || !set_device(device)) {
+            return false;
+        }
+        device_ = device;
+        std::size_t mem = 0;
+        if (!stream_create(&copy_) || !stream_create(&compute_) || !memory_total(&mem)) {
+            return false;
+        }
+        for (Event* e : {&uploaded_[0], &uploaded_[1], &computed_[0], &computed_[1], &ready_}) {
+            if (!event_create(e)) {
+                return false;
+            }
+        }
+        if (!blas_create(&blas_, compute_) || !solver_create(&solver_, compute_) ||
+            !sparse_create(&sparse_, compute_) || !staging_.init()) {
+            return false;
+        }
+        info_.memory_bytes = mem;
+        device_name(device, info_.name, sizeof(info_.name));
+        std::snprintf(info_.platform, sizeof(info_.platform), "%s", LANA_GPU_PLATFORM);
+        return measure();
+    }
+
+    int query(lana_device_info* out) {
+        *out = info_;
+        return 0;
+    }
+
+    template <typename T>
+    int gemm(T alpha, lana_device_matrix a, lana_device_matrix b, T beta, lana_device_matrix c) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        set_device(device_);
+        if (c.row_stride != 1) {
+            // Row-major C: compute C^T = B^T * A^T into its column-major storage.
+            const lana_device_matrix at = transposed(a);
+            a = transposed(b);
+            b = at;
+            c = transposed(c);
+        }
+        const std::int64_t m = c.rows;
+        const std::int64_t n = c.cols;
+        const std::int64_t k = a.cols;
+        const Storage sa = storage_of(a);
+        const Storage sb = storage_of(b);
+        const Storage sc = storage_of(c);
+        if (!fits_int(m) || !fits_int(n) || !fits_int(k)) {
+            return 1;
+        }
+        if (m == 0 || n == 0) {
+            return 0;
+        }
+        const std::int64_t w = n <= 2 * min_panel_cols ? n : std::max(min_panel_cols, (n + 3) / 4);
+        const std::int64_t panels = (n + w - 1) / w;
+        constexpr std::size_t es = sizeof(T);
+        DevBuf da(cache_, static_cast<std::size_t>(m * k) * es);
+        DevBuf db0(cache_, static_cast<std::size_t>(k * w) * es);
+        DevBuf db1(cache_, panels > 1 ? static_cast<std::size_t>(k * w) * es : 0);
+        DevBuf dc0(cache_, static_cast<std::size_t>(m * w) * es);
+        DevBuf dc1(cache_, panels > 1 ? static_cast<std::size_t>(m * w) * es : 0);
+        if (!da || !db0 || !db1 || !dc0 || !dc1) {
+            return 1;
+        }
+        const Drain drain(*this);
+        const DevBuf* db[2] = {&db0, &db1};
+        const DevBuf* dc[2] = {&dc0, &dc1};
+
+        if (!staging_.upload(copy_, sa.data, sa.ld * es, sa.len * es, sa.lines, da.as(), sa.len * es)) {
+            return 1;
+        }
+        const auto upload = [&](std::int64_t p, int s) {
+            const std::int64_t j0 = p * w;
+            const std::int64_t wj = std::min(w, n - j0);
+            const bool ok_b =
+                sb.trans
+                    ? staging_.upload(copy_, sb.data + j0 * es, sb.ld * es, wj * es, k, db[s]->as(), wj * es)
+                    : staging_.upload(copy_, sb.data + j0 * sb.ld * es, sb.ld * es, k * es, wj, db[s]->as(), k * es);
+            const bool ok_c = beta == T(0) || staging_.upload(copy_, sc.data + j0 * sc.ld * es, sc.ld * es, m * es, wj,
+                                                              dc[s]->as(), m * es);
+            return ok_b && ok_c && event_record(uploaded_[s], copy_);
+        };
+        if (!upload(0, 0)) {
+            return 1;
+        }
+        for (std::int64_t p = 0; p < panels; ++p) {
+            const int s = static_cast<int>(p % 2);
+            const std::int64_t j0 = p * w;
+            const std::int64_t wj = std::min(w, n - j0);
+            if (!stream_wait(compute_, uploaded_[s]) ||
+                !lana_gpu::gemm(blas_, sa.trans, sb.trans, static_cast<int>(m), static_cast<int>(wj),
+                                static_cast<int>(k), alpha, da.as<const T>(), static_cast<int>(std::max<std::int64_t>(sa.len, 1)),
+                                db[s]->as<const T>(), static_cast<int>(std::max<std::int64_t>(sb.trans ? wj : k, 1)),
+                                beta, dc[s]->as<T>(), static_cast<int>(m)) ||
+                !event_record(computed_[s], compute_)) {
+                return 1;
+            }
+            if (p + 1 < panels && !upload(p + 1, 1 - s)) {
+                return 1;
+            }
+            if (!stream_wait(copy_, computed_[s]) ||
+                !staging_.download(copy_, dc[s]->as(), m * es, m * es, wj, sc.data + j0 * sc.ld * es, sc.ld * es)) {
+                return 1;
+            }
+        }
+        return 0;
+    }
+
+    template <typename T>
+    int getrf(const lana_device_matrix& a, std::int32_t* ipiv, std::int64_t* info) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        set_device(device_);
+        const std::int64_t m = a.rows;
+        const std::int64_t n = a.cols;
+        const std::int64_t kmax = std::min(m, n);
+        if (!fits_int(m) || !fits_int(n) || kmax == 0) {
+            return 1;
+        }
+        constexpr std::size_t es = sizeof(T);
+        const Storage st = storage_of(a);
+        DevBuf da(cache_, static_cast<std::size_t>(m * n) * es);
+        DevBuf dt(cache_, st.trans ? static_cast<std::size_t>(m * n) * es : 0);
+        DevBuf dpiv(cache_, static_cast<std::size_t>(kmax) * sizeof(int));
+        DevBuf dinfo(cache_, sizeof(int));
+        if (!da || !dt || !dpiv || !dinfo) {
+            return 1;
+        }
+        int lwork = 0;
+        if (!lana_gpu::getrf_work(solver_, static_cast<int>(m), static_cast<int>(n), da.as<T>(), static_cast<int>(m),
+                                  &lwork)) {
+            return 1;
+        }
+        DevBuf work(cache_, static_cast<std::size_t>(std::max(lwork, 1)) * es);
+        if (!work) {
+            return 1;
+        }
+        const Drain drain(*this);
+        if (!to_device<T>(st, m, n, da, dt) ||
+            !lana_gpu::getrf(solver_, static_cast<int>(m), static_cast<int>(n), da.as<T>(), static_cast<int>(m),
+                             work.as<T>(), lwork, dpiv.as<int>(), dinfo.as<int>())) {
+            return 1;
+        }
+        std::vector<int> piv(static_cast<std::size_t>(kmax));
+        int hinfo = 0;
+        if (!event_record(ready_, compute_) || !stream_wait(copy_, ready_) ||
+            !staging_.download(copy_, dinfo.as(), sizeof(int), sizeof(int), 1, reinterpret_cast<std::byte*>(&hinfo),
+                               sizeof(int)) ||
+            !staging_.download(copy_, dpiv.as(), kmax * 4, kmax * 4, 1, reinterpret_cast<std::byte*>(piv.data()),
+                               kmax * 4) ||
+            hinfo < 0 || !to_host<T>(st, m, n, da, dt)) {
+            return 1;
+        }
+        for (std::int64_t i = 0; i < kmax; ++i) {
+            ipiv[i] = piv[static_cast<std::size_t>(i)] - 1;
+        }
+        *info = hinfo;
+        return 0;
+    }
+
+    template <typename T>
+    int potrf(const lana_device_matrix& a, std::int64_t* info) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        set_device(device_);
+        const std::int64_t n = a.rows;
+        if (!fits_int(n) || n == 0 || a.cols != n) {
+            return 1;
+        }
+        constexpr std::size_t es = sizeof(T);
+        const Storage st = storage_of(a);
+        DevBuf da(cache_, static_cast<std::size_t>(n * n) * es);
+        DevBuf dt(cache_, st.trans ? static_cast<std::size_t>(n * n) * es : 0);
+        DevBuf dinfo(cache_, sizeof(int));
+        if (!da || !dt || !dinfo) {
+            return 1;
+        }
+        int lwork = 0;
+        if (!lana_gpu::potrf_work(solver_, static_cast<int>(n), da.as<T>(), static_cast<int>(n), &lwork)) {
+            return 1;
+        }
+        DevBuf work(cache_, static_cast<std::size_t>(std::max(lwork, 1)) * es);
+        if (!work) {
+            return 1;
+        }
+        const Drain drain(*this);
+        int hinfo = 0;
+        if (!to_device<T>(st, n, n, da, dt) ||
+            !lana_gpu::potrf(solver_, static_cast<int>(n), da.as<T>(), static_cast<int>(n), work.as<T>(), lwork,
+                             dinfo.as<int>()) ||
+            !event_record(ready_, compute_) || !stream_wait(copy_, ready_) ||
+            !staging_.download(copy_, dinfo.as(), sizeof(int), sizeof(int), 1, reinterpret_cast<std::byte*>(&hinfo),
+                               sizeof(int)) ||
+            hinfo < 0 || !to_host<T>(st, n, n, da, dt)) {
+            return 1;
+        }
+        *info = hinfo;
+        return 0;
+    }
+
+    int csr_upload(const lana_device_csr& a, void** handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        set_device(device_);
+        // 32-bit offsets for cuSPARSE/hipSPARSE; larger matrices stay on the host.
+        if (!fits_int(a.rows) || !fits_int(a.cols) || !fits_int(a.nnz)) {
+            return 1;
+        }
+        const bool f64 = a.dtype == LANA_DEVICE_F64;
+        const std::size_t es = f64 ? sizeof(double) : sizeof(float);
+        std::vector<std::int32_t> rp(static_cast<std::size_t>(a.rows) + 1);
+        for (std::int64_t i = 0; i <= a.rows; ++i) {
+            rp[static_cast<std::size_t>(i)] = static_cast<std::int32_t>(a.row_ptr[i]);
+        }
+        auto* h = new (std::nothrow) CsrHandle{a.rows, a.cols, a.nnz, f64, nullptr, nullptr, nullptr, nullptr,
+                                               nullptr, 0};
+        if (h == nullptr) {
+            return 1;
+        }
+        const auto bytes_rp = static_cast<std::int64_t>(rp.size() * sizeof(std::int32_t));
+        const auto bytes_ci = a.nnz * static_cast<std::int64_t>(sizeof(std::int32_t));
+        const auto bytes_v = a.nnz * static_cast<std::int64_t>(es);
+        h->row_ptr = cache_.get(static_cast<std::size_t>(bytes_rp));
+        h->col_idx = cache_.get(static_cast<std::size_t>(std::max<std::int64_t>(bytes_ci, 1)));
+        h->values = cache_.get(static_cast<std::size_t>(std::max<std::int64_t>(bytes_v, 1)));
+        const bool ok =
+            h->row_ptr != nullptr && h->col_idx != nullptr && h->values != nullptr &&
+            staging_.upload(copy_, reinterpret_cast<const std::byte*>(rp.data()), bytes_rp, bytes_rp, 1,
+                            static_cast<std::byte*>(h->row_ptr), bytes_rp) &&
+            staging_.upload(copy_, reinterpret_cast<const std::byte*>(a.col_idx), bytes_ci, bytes_ci, 1,
+                            static_cast<std::byte*>(h->col_idx), bytes_ci) &&
+            staging_.upload(copy_, static_cast<const std::byte*>(a.values), bytes_v, bytes_v, 1,
+                            static_cast<std::byte*>(h->values), bytes_v) &&
+            stream_sync(copy_) &&
+            csr_create(&h->mat, a.rows, a.cols, a.nnz, h->row_ptr, h->col_idx, h->values, f64);
+        if (!ok) {
+            stream_sync(copy_);
+            release_locked(h);
+            return 1;
+        }
+        *handle = h;
+        return 0;
+    }
+
+    void csr_release(void* handle) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        set_device(device_);
+        release_locked(static_cast<CsrHandle*>(handle));
+    }
+
+    int spmv(void* handle, double alpha, const void* x, std::int64_t incx, double beta, void* y, std::int64_t incy) {
+        auto* h = static_cast<CsrHandle*>(handle);
+        return h->f64 ? spmv_typed<double>(*h, alpha, static_cast<const double*>(x), incx, beta,
+                                           static_cast<double*>(y), incy)
+                      : spmv_typed<float>(*h, static_cast<float>(alpha), static_cast<const float*>(x), incx,
+                                          static_cast<float>(beta), static_cast<float*>(y), incy);
+    }
+
+private:
+    /// Waits for both streams when a call ends, before its buffers return
+    /// to the cache.
+    struct Drain {
+        Plugin& p;
+        explicit Drain(Plugin& pl) : p(pl) {}
+        ~Drain() {
+            stream_sync(p.copy_);
+            stream_sync(p.compute_);
+        }
+        Drain(const Drain&) = delete;
+        Drain& operator=(const Drain&) = delete;
+    };
+
+    /// Host matrix -> tight column-major m x n in `da`, ready on compute_.
+    template <typename T>
+    bool to_device(const Storage& st, std::int64_t m, std::int64_t n, const DevBuf& da, const DevBuf& dt) {
+        constexpr std::size_t es = sizeof(T);
+        std::byte* dst = st.trans ? dt.as() : da.as();
+        if (!staging_.upload(copy_, st.data, st.ld * es, st.len * es, st.lines, dst, st.len * es) ||
+            !event_record(ready_, copy_) || !stream_wait(compute_, ready_)) {
+            return false;
+        }
+        return !st.trans || transpose(blas_, static_cast<int>(m), static_cast<int>(n), dt.as<const T>(),
+                                      static_cast<int>(n), da.as<T>(), static_cast<int>(m));
+    }
+
+    /// The reverse of to_device, after the work queued on compute_.
+    template <typename T>
+    bool to_host(const Storage& st, std::int64_t m, std::int64_t n, const DevBuf& da, const DevBuf& dt) {
+        constexpr std::size_t es = sizeof(T);
+        if (st.trans && !transpose(blas_, static_cast<int>(n), static_cast<int>(m), da.as<const T>(),
+                                   static_cast<int>(m), dt.as<T>(), static_cast<int>(n))) {
+            return false;
+        }
+        return event_record(ready_, compute_) && stream_wait(copy_, ready_) &&
+               staging_.download(copy_, st.trans ? dt.as() : da.as(), st.len * es, st.len * es, st.lines, st.data,
+                                 st.ld * es);
+    }
+
+    template <typename T>
+    int spmv_typed(CsrHandle& h, T alpha, const T* x, std::int64_t incx, T beta, T* y, std::int64_t incy) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        set_device(device_);
+        constexpr std::size_t es = sizeof(T);
+        DevBuf dx(cache_, static_cast<std::size_t>(std::max<std::int64_t>(h.cols, 1)) * es);
+        DevBuf dy(cache_, static_cast<std::size_t>(std::max<std::int64_t>(h.rows, 1)) * es);
+        if (!dx || !dy) {
+            return 1;
+        }
+        const Drain drain(*this);
+        // Strided vectors are lines of one element.
+        const auto xb = reinterpret_cast<const std::byte*>(x);
+        auto* yb = reinterpret_cast<std::byte*>(y);
+        const bool ok_x = incx == 1 ? staging_.upload(copy_, xb, h.cols * es, h.cols * es, 1, dx.as(), h.cols * es)
+                                    : staging_.upload(copy_, xb, incx * es, es, h.cols, dx.as(), es);
+        const bool ok_y = beta == T(0) ||
+                          (incy == 1 ? staging_.upload(copy_, yb, h.rows * es, h.rows * es, 1, dy.as(), h.rows * es)
+                                     : staging_.upload(copy_, yb, incy * es, es, h.rows, dy.as(), es));
+        if (!ok_x || !ok_y || !event_record(ready_, copy_) || !stream_wait(compute_, ready_)) {
+            return 1;
+        }
+        DnVec vx = nullptr;
+        DnVec vy = nullptr;
+        bool ok = vec_create(&vx, h.cols, dx.as(), h.f64) && vec_create(&vy, h.rows, dy.as(), h.f64);
+        std::size_t bytes = 0;
+        ok = ok && spmv_work(sparse_, &alpha, h.mat, vx, &beta, vy, h.f64, &bytes);
+        if (ok && bytes > h.work_bytes) {
+            cache_.put(h.work);
+            h.work = cache_.get(bytes);
+            h.work_bytes = h.work != nullptr ? bytes : 0;
+            ok = h.work != nullptr;
+        }
+        ok = ok && lana_gpu::spmv(sparse_, &alpha, h.mat, vx, &beta, vy, h.f64, h.work) &&
+             event_record(ready_, compute_) && stream_wait(copy_, ready_) &&
+             (incy == 1 ? staging_.download(copy_, dy.as(), h.rows * es, h.rows * es, 1, yb, h.rows * es)
+                        : staging_.download(copy_, dy.as(), es, es, h.rows, yb, incy * es));
+        if (vx != nullptr) {
+            vec_destroy(vx);
+        }
+        if (vy != nullptr) {
+            vec_destroy(vy);
+        }
+        return ok ? 0 : 1;
+    }
+
+    void release_locked(CsrHandle* h) {
+        if (h->mat != nullptr) {
+            csr_destroy(h->mat);
+        }
+        cache_.put(h->row_ptr);
+        cache_.put(h->col_idx);
+        cache_.put(h->values);
+        cache_.put(h->work);
+        delete h;
+    }
+
+    /// Sustained GEMM rates and the pinned upload rate, for the dispatcher's
+    /// cost model.
+    bool measure() {
+        constexpr int n = 2048;
+        Event t0 = nullptr;
+        Event t1 = nullptr;
+        if (!event_create_timed(&t0) || !event_create_timed(&t1)) {
+            return false;
+        }
+        bool ok = true;
+        float ms = 0;
+        {
+            DevBuf buf(cache_, staging_bytes);
+            constexpr int reps = 4;
+            ok = buf && event_record(t0, copy_);
+            for (int r = 0; ok && r < reps; ++r) {
+                ok = copy_h2d(buf.as(), staging_.buffer(), staging_bytes, copy_);
+            }
+            ok = ok && event_record(t1, copy_) && event_sync(t1) && event_ms(t0, t1, &ms) && ms > 0;
+            if (ok) {
+                info_.link_gbps = reps * static_cast<double>(staging_bytes) / (ms * 1e6);
+            }
+        }
+        const auto rate = [&](auto zero) -> double {
+            using T = decltype(zero);
+            DevBuf buf(cache_, std::size_t(3) * n * n * sizeof(T));
+            if (!buf) {
+                return 0;
+            }
+            T* a = buf.as<T>();
+            T* c = a + 2 * std::size_t(n) * n;
+            constexpr int reps = 3;
+            bool good = lana_gpu::gemm(blas_, false, false, n, n, n, T(0), a, n, a + std::size_t(n) * n, n, T(0), c, n) &&
+                        event_record(t0, compute_);
+            for (int r = 0; good && r < reps; ++r) {
+                good = lana_gpu::gemm(blas_, false, false, n, n, n, T(0), a, n, a + std::size_t(n) * n, n, T(0), c, n);
+            }
+            float t = 0;
+            good = good && event_record(t1, compute_) && event_sync(t1) && event_ms(t0, t1, &t) && t > 0;
+            return good ? reps * 2.0 * n * n * n / (t * 1e6) : 0;
+        };
+        if (ok) {
+            info_.gflops_f32 = rate(float{});
+            info_.gflops_f64 = rate(double{});
+        }
+        event_destroy(t0);
+        event_destroy(t1);
+        return ok && info_.gflops_f32 > 0;
+    }
+
+    std::mutex mutex_;
+    int device_ = 0;
+    Stream copy_ = nullptr;
+    Stream compute_ = nullptr;
+    Event uploaded_[2] = {nullptr, nullptr};
+    Event computed_[2] = {nullptr, nullptr};
+    Event ready_ = nullptr;
+    BlasHandle blas_ = nullptr;
+    SolverHandle solver_ = nullptr;
+    SparseHandle sparse_ = nullptr;
+    DeviceCache cache_;
+    Staging staging_;
+    lana_device_info info_{};
+};
+
+// C entry points: no exception may cross into lana.
+
+Plugin* instance = nullptr;
+
+int query_cb(void* self, lana_device_info* out) { return static_cast<Plugin*>(self)->query(out); }
+
+int gemm_cb(void* self, double alpha, const lana_device_matrix* a, const lana_device_matrix* b, double beta,
+            const lana_device_matrix* c) {
+    try {
+        if (a->dtype != c->dtype || b->dtype != c->dtype) {
+            return 1;
+        }
+        auto* p = static_cast<Plugin*>(self);
+        return c->dtype == LANA_DEVICE_F64
+                   ? p->gemm<double>(alpha, *a, *b, beta, *c)
+                   : p->gemm<float>(static_cast<float>(alpha), *a, *b, static_cast<float>(beta), *c);
+    } catch (...) {
+        return 1;
+    }
+}
+
+int getrf_cb(void* self, const lana_device_matrix* a, std::int32_t* ipiv, std::int64_t* info) {
+    try {
+        auto* p = static_cast<Plugin*>(self);
+        return a->dtype == LANA_DEVICE_F64 ? p->getrf<double>(*a, ipiv, info) : p->getrf<float>(*a, ipiv, info);
+    } catch (...) {
+        return 1;
+    }
+}
+
+int potrf_cb(void* self, const lana_device_matrix* a, std::int64_t* info) {
+    try {
+        auto* p = static_cast<Plugin*>(self);
+        return a->dtype == LANA_DEVICE_F64 ? p->potrf<double>(*a, info) : p->potrf<float>(*a, info);
+    } catch (...) {
+        return 1;
+    }
+}
+
+int csr_upload_cb(void* self, const lana_device_csr* a, void** handle) {
+    try {
+        return static_cast<Plugin*>(self)->csr_upload(*a, handle);
+    } catch (...) {
+        return 1;
+    }
+}
+
+void csr_release_cb(void* self, void* handle) {
+    try {
+        static_cast<Plugin*>(self)->csr_release(handle);
+    } catch (...) {
+    }
+}
+
+int spmv_cb(void* self, void* handle, double alpha, const void* x, std::int64_t incx, double beta, void* y,
+            std::int64_t incy) {
+    try {
+        return static_cast<Plugin*>(self)->spmv(handle, alpha, x, incx, beta, y, incy);
+    } catch (...) {
+        return 1;
+    }
+}
+
+void shutdown_cb(void* self) {
+    delete static_cast<Plugin*>(self);
+    instance = nullptr;
+}
+
+}  // namespace
+}  // namespace lana_gpu
+
+/// LANA_GPU_DEVICE picks the device ordinal (default 0).
+extern "C" __attribute__((visibility("default"))) const lana_device_backend* lana_device_backend_v1(void) {
+    using namespace lana_gpu;
+    static lana_device_backend table{};
+    if (instance == nullptr) {
+        const char* env = std::getenv("LANA_GPU_DEVICE");
+        auto* p = new (std::nothrow) Plugin;
+        if (p == nullptr || !p->init(env != nullptr ? std::atoi(env) : 0)) {
+            delete p;
+            return nullptr;
+        }
+        instance = p;
+    }
+    table = {LANA_DEVICE_ABI_VERSION, instance, &query_cb,      &gemm_cb, &getrf_cb,   &potrf_cb,
+             &csr_upload_cb,          &csr_release_cb, &spmv_cb, &shutdown_cb};
+    return &table;
+}
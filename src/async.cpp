@@ -0,0 +1,93 @@
+#include "lana/async.hpp"
+#include "lana/thread_pool.hpp"
+
+namespace lana::async::detail {
+
+StateBase::~StateBase() = default;
+
+void StateBase::wait() const {
+    if (ready()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [&] { return done_.load(std::memory_order_relaxed); });
+}
+
+bool StateBase::subscribe(std::function<void()> k) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (done_.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    continuations_.push_back(std::move(k));
+    return true;
+}
+
+void StateBase::finish(std::exception_ptr error) noexcept {
+    std::vector<std::function<void()>> ks;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::move(error);
+        done_.store(true, std::memory_order_release);
+        ks.swap(continuations_);
+    }
+    cv_.notify_all();
+    for (auto& k : ks) {
+        k();
+    }
+}
+
+namespace {
+
+struct Join {
+    Join(std::size_t n, std::function<void(std::exception_ptr)> f, bool p) : pending(n), k(std::move(f)), post(p) {}
+
+    std::atomic<std::size_t> pending;
+    std::mutex mutex;
+    std::exception_ptr first_error;
+    std::function<void(std::exception_ptr)> k;
+    const bool post;
+
+    /// Runs from StateBase::finish(), which is noexcept. post() can throw
+    /// (out of memory, or a foreign executor refusing work); the
+    /// continuation then runs here instead, so it still completes its
+    /// state rather than the process terminating.
+    static void fire(const std::shared_ptr<Join>& join) {
+        if (join->post) {
+            try {
+                lana::detail::post([join] { join->k(join->first_error); });
+                return;
+            } catch (...) {
+            }
+        }
+        join->k(join->first_error);
+    }
+
+    static void arrive(const std::shared_ptr<Join>& join, const std::exception_ptr& error) {
+        if (error) {
+            std::lock_guard<std::mutex> lock(join->mutex);
+            if (!join->first_error) {
+                join->first_error = error;
+            }
+        }
+        if (join->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            fire(join);
+        }
+    }
+};
+
+}  // namespace
+
+void when_complete(StateList deps, std::function<void(std::exception_ptr)> k, bool post) {
+    // One extra count held while subscribing, so the join cannot fire
+    // before every dependency has been looked at.
+    auto join = std::make_shared<Join>(deps.size() + 1, std::move(k), post);
+    for (const std::shared_ptr<StateBase>& dep : deps) {
+        StateBase* d = dep.get();
+        if (!dep->subscribe([join, d] { Join::arrive(join, d->error()); })) {
+            Join::arrive(join, dep->error());
+        }
+    }
+    Join::arrive(join, nullptr);
+}
+
+}  // namespace lana::async::detail
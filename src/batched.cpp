@@ -0,0 +1,392 @@
+// Batched small-matrix kernels.
+//
+// Strided and pointer batches go one matrix at a time through kernels
+// instantiated for common sizes, so a 4 x 4 product is a fixed sequence of
+// multiply-adds rather than a trip through GEMM blocking and packing.
+// Interleaved batches run the dispatched SoA kernels over whole groups,
+// padding included, with the batch split between threads at group
+// boundaries.
+
+#include "lana/batched.hpp"
+#include "lana/gemm.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/workspace.hpp"
+
+#include "kernels/kernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <type_traits>
+
+namespace lana {
+namespace batched {
+namespace {
+
+/// Flops per task below which the batch is not split further.
+constexpr double batch_min_task_flops = double(1 << 17);
+
+/// Matrices per task for matrices costing `flops` each.
+index_t batch_grain(double flops) {
+    return std::max<index_t>(1, static_cast<index_t>(batch_min_task_flops / std::max(flops, 1.0)));
+}
+
+/// Products at least this large (m * n * k) go through lana::gemm, whose
+/// blocking pays off by then.
+constexpr index_t batch_gemm_large = index_t(64) * 64 * 64;
+
+/// Calls f(std::integral_constant<int, S>) with S = n for the sizes that
+/// have a dedicated instantiation, and S = 0 (runtime size) otherwise.
+template <typename F>
+decltype(auto) with_size(index_t n, F&& f) {
+    switch (n) {
+        case 2: return f(std::integral_constant<int, 2>{});
+        case 3: return f(std::integral_constant<int, 3>{});
+        case 4: return f(std::integral_constant<int, 4>{});
+        case 5: return f(std::integral_constant<int, 5>{});
+        case 6: return f(std::integral_constant<int, 6>{});
+        case 7: return f(std::integral_constant<int, 7>{});
+        case 8: return f(std::integral_constant<int, 8>{});
+        case 12: return f(std::integral_constant<int, 12>{});
+        case 16: return f(std::integral_constant<int, 16>{});
+        case 32: return f(std::integral_constant<int, 32>{});
+        default: return f(std::integral_constant<int, 0>{});
+    }
+}
+
+/// C = alpha * A * B + beta * C for one column-major matrix; S > 0 fixes
+/// m = n = k = S at compile time.
+template <int S, typename T>
+void gemm_one(index_t m, index_t n, index_t k, T alpha, const T* LANA_RESTRICT a, index_t lda,
+              const T* LANA_RESTRICT b, index_t ldb, T beta, T* LANA_RESTRICT c, index_t ldc) {
+    if constexpr (S > 0) {
+        m = n = k = S;
+    }
+    for (index_t j = 0; j < n; ++j) {
+        T* cj = c + j * ldc;
+        if (beta == T(0)) {
+            std::fill_n(cj, m, T(0));
+        } else if (beta != T(1)) {
+            for (index_t i = 0; i < m; ++i) {
+                cj[i] *= beta;
+            }
+        }
+        for (index_t p = 0; p < k; ++p) {
+            const T t = alpha * b[p + j * ldb];
+            const T* ap = a + p * lda;
+            for (index_t i = 0; i < m; ++i) {
+                cj[i] += t * ap[i];
+            }
+        }
+    }
+}
+
+/// Unblocked right-looking LU with partial pivoting; returns info.
+template <int S, typename T>
+std::int32_t getrf_one(index_t n, T* LANA_RESTRICT a, index_t lda, std::int32_t* LANA_RESTRICT ipiv) {
+    if constexpr (S > 0) {
+        n = S;
+    }
+    std::int32_t info = 0;
+    for (index_t k = 0; k < n; ++k) {
+        index_t p = k;
+        T best = std::abs(a[k + k * lda]);
+        for (index_t i = k + 1; i < n; ++i) {
+            const T v = std::abs(a[i + k * lda]);
+            if (v > best) {
+                best = v;
+                p = i;
+            }
+        }
+        ipiv[k] = static_cast<std::int32_t>(p);
+        if (p != k) {
+            for (index_t j = 0; j < n; ++j) {
+                std::swap(a[k + j * lda], a[p + j * lda]);
+            }
+        }
+        const T pivot = a[k + k * lda];
+        if (pivot == T(0)) {
+            // The column below is zero as well, so there is nothing to scale.
+            if (info == 0) {
+                info = static_cast<std::int32_t>(k + 1);
+            }
+            continue;
+        }
+        const T inv = T(1) / pivot;
+        T* lk = a + k * lda;
+        for (index_t i = k + 1; i < n; ++i) {
+            lk[i] *= inv;
+        }
+        for (index_t j = k + 1; j < n; ++j) {
+            T* aj = a + j * lda;
+            const T u = aj[k];
+            for (index_t i = k + 1; i < n; ++i) {
+                aj[i] -= lk[i] * u;
+            }
+        }
+    }
+    return info;
+}
+
+/// Right-looking lower Cholesky; returns info and stops at the first
+/// non-positive pivot.
+template <int S, typename T>
+std::int32_t potrf_one(index_t n, T* LANA_RESTRICT a, index_t lda) {
+    if constexpr (S > 0) {
+        n = S;
+    }
+    for (index_t j = 0; j < n; ++j) {
+        T* lj = a + j * lda;
+        const T d = lj[j];
+        if (!(d > T(0))) {
+            return static_cast<std::int32_t>(j + 1);
+        }
+        const T r = std::sqrt(d);
+        lj[j] = r;
+        const T inv = T(1) / r;
+        for (index_t i = j + 1; i < n; ++i) {
+            lj[i] *= inv;
+        }
+        for (index_t k = j + 1; k < n; ++k) {
+            T* ak = a + k * lda;
+            const T u = lj[k];
+            for (index_t i = k; i < n; ++i) {
+                ak[i] -= lj[i] * u;
+            }
+        }
+    }
+    return 0;
+}
+
+template <typename Batch>
+void require_square(const Batch& a, const char* what) {
+    detail::require_dims(a.rows() == a.cols(), what);
+}
+
+/// Profile scope of a batch call: `size` and the per-matrix `flops` and
+/// `elems` are those of one problem, the recorded totals cover the batch.
+template <typename T>
+profile::Scope batch_scope(int id, index_t count, index_t size, double flops, double elems) {
+    const auto c = static_cast<double>(count);
+    return profile::Scope(id, profile::dtype_of<T>(), size, c * flops, c * elems * sizeof(T));
+}
+
+template <typename T, typename BatchA, typename BatchB, typename BatchC>
+profile::Scope gemm_batch_scope(const BatchA& a, const BatchB& b, const BatchC& c) {
+    static const int id = profile::detail::kernel_id("batched_gemm");
+    const auto m = static_cast<double>(c.rows());
+    const auto n = static_cast<double>(c.cols());
+    const auto k = static_cast<double>(a.cols());
+    return batch_scope<T>(id, c.count(), std::max({c.rows(), c.cols(), b.rows()}), 2 * m * n * k,
+                          m * k + k * n + 2 * m * n);
+}
+
+template <typename T, typename Batch>
+profile::Scope getrf_batch_scope(const Batch& a) {
+    static const int id = profile::detail::kernel_id("batched_getrf");
+    const auto n = static_cast<double>(a.rows());
+    return batch_scope<T>(id, a.count(), a.rows(), 2.0 / 3.0 * n * n * n, 2 * n * n);
+}
+
+template <typename T, typename Batch>
+profile::Scope potrf_batch_scope(const Batch& a) {
+    static const int id = profile::detail::kernel_id("batched_potrf");
+    const auto n = static_cast<double>(a.rows());
+    return batch_scope<T>(id, a.count(), a.rows(), 1.0 / 3.0 * n * n * n, n * n);
+}
+
+template <typename T, typename BatchA, typename BatchB, typename BatchC>
+void gemm_batch(T alpha, const BatchA& a, const BatchB& b, T beta, const BatchC& c) {
+    detail::require_dims(a.count() == b.count() && a.count() == c.count() && a.rows() == c.rows() &&
+                             b.cols() == c.cols() && a.cols() == b.rows(),
+                         "batched::gemm");
+    const auto prof = gemm_batch_scope<T>(a, b, c);
+    const index_t m = c.rows();
+    const index_t n = c.cols();
+    const index_t k = a.cols();
+    if (m * n * k >= batch_gemm_large) {
+        // Already big enough for gemm to split each product across threads.
+        for (index_t i = 0; i < c.count(); ++i) {
+            lana::gemm(alpha, MatrixView<const T>(a[i]), MatrixView<const T>(b[i]), beta, c[i]);
+        }
+        return;
+    }
+    const index_t grain = batch_grain(2.0 * double(m) * double(n) * double(k));
+    auto run = [&](auto size) {
+        parallel_for(0, c.count(), grain, [&](index_t lo, index_t hi) {
+            for (index_t i = lo; i < hi; ++i) {
+                gemm_one<decltype(size)::value>(m, n, k, alpha, a.ptr(i), a.ld(), b.ptr(i), b.ld(), beta, c.ptr(i),
+                                                c.ld());
+            }
+        });
+    };
+    if (m == n && n == k) {
+        with_size(m, run);
+    } else {
+        run(std::integral_constant<int, 0>{});
+    }
+}
+
+template <typename T, typename Batch>
+index_t getrf_batch(const Batch& a, std::int32_t* ipiv, std::int32_t* info) {
+    require_square(a, "batched::getrf");
+    const auto prof = getrf_batch_scope<T>(a);
+    const index_t n = a.rows();
+    const double flops = 2.0 / 3.0 * double(n) * double(n) * double(n);
+    index_t failed = 0;
+    with_size(n, [&](auto size) {
+        parallel_for(0, a.count(), batch_grain(flops), [&](index_t lo, index_t hi) {
+            index_t f = 0;
+            for (index_t i = lo; i < hi; ++i) {
+                const std::int32_t r = getrf_one<decltype(size)::value>(n, a.ptr(i), a.ld(), ipiv + i * n);
+                f += r != 0;
+                if (info) {
+                    info[i] = r;
+                }
+            }
+            std::atomic_ref<index_t>(failed).fetch_add(f, std::memory_order_relaxed);
+        });
+    });
+    return failed;
+}
+
+template <typename T, typename Batch>
+index_t potrf_batch(const Batch& a, std::int32_t* info) {
+    require_square(a, "batched::potrf");
+    const auto prof = potrf_batch_scope<T>(a);
+    const index_t n = a.rows();
+    const double flops = 1.0 / 3.0 * double(n) * double(n) * double(n);
+    index_t failed = 0;
+    with_size(n, [&](auto size) {
+        parallel_for(0, a.count(), batch_grain(flops), [&](index_t lo, index_t hi) {
+            index_t f = 0;
+            for (index_t i = lo; i < hi; ++i) {
+                const std::int32_t r = potrf_one<decltype(size)::value>(n, a.ptr(i), a.ld());
+                f += r != 0;
+                if (info) {
+                    info[i] = r;
+                }
+            }
+            std::atomic_ref<index_t>(failed).fetch_add(f, std::memory_order_relaxed);
+        });
+    });
+    return failed;
+}
+
+/// Runs body(g0, g1) over ranges of whole groups of an interleaved batch.
+template <typename T, typename F>
+void for_groups(const InterleavedView<T>& a, double flops, F&& body) {
+    constexpr index_t g = interleave_width<T>;
+    parallel_for(0, a.groups(), (batch_grain(flops) + g - 1) / g, body);
+}
+
+template <typename T>
+void gemm_interleaved(T alpha, InterleavedView<const T> a, InterleavedView<const T> b, T beta,
+                      InterleavedView<T> c) {
+    detail::require_dims(a.count() == b.count() && a.count() == c.count() && a.rows() == c.rows() &&
+                             b.cols() == c.cols() && a.cols() == b.rows(),
+                         "batched::gemm");
+    const auto prof = gemm_batch_scope<T>(a, b, c);
+    constexpr index_t g = interleave_width<T>;
+    const index_t m = c.rows();
+    const index_t n = c.cols();
+    const index_t k = a.cols();
+    const auto kern = detail::kernels<T>().soa_gemm;
+    for_groups(c, 2.0 * double(m) * double(n) * double(k), [&](index_t g0, index_t g1) {
+        kern(m, n, k, g1 - g0, alpha, a.data() + g0 * m * k * g, b.data() + g0 * k * n * g, beta,
+             c.data() + g0 * m * n * g);
+    });
+}
+
+index_t count_failed(const std::int32_t* info, index_t count) {
+    return static_cast<index_t>(std::count_if(info, info + count, [](std::int32_t r) { return r != 0; }));
+}
+
+template <typename T>
+index_t getrf_interleaved(InterleavedView<T> a, std::int32_t* ipiv, std::int32_t* info) {
+    require_square(a, "batched::getrf");
+    const auto prof = getrf_batch_scope<T>(a);
+    constexpr index_t g = interleave_width<T>;
+    const index_t n = a.rows();
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    std::int32_t* out = info ? info : ws.allocate_n<std::int32_t>(static_cast<std::size_t>(a.count()));
+    const auto kern = detail::kernels<T>().soa_getrf;
+    const index_t count = a.count();
+    for_groups(a, 2.0 / 3.0 * double(n) * double(n) * double(n), [&](index_t g0, index_t g1) {
+        kern(n, g1 - g0, count - g0 * g, a.data() + g0 * n * n * g, ipiv + g0 * g * n, out + g0 * g);
+    });
+    return count_failed(out, count);
+}
+
+template <typename T>
+index_t potrf_interleaved(InterleavedView<T> a, std::int32_t* info) {
+    require_square(a, "batched::potrf");
+    const auto prof = potrf_batch_scope<T>(a);
+    constexpr index_t g = interleave_width<T>;
+    const index_t n = a.rows();
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    std::int32_t* out = info ? info : ws.allocate_n<std::int32_t>(static_cast<std::size_t>(a.count()));
+    const auto kern = detail::kernels<T>().soa_potrf;
+    const index_t count = a.count();
+    for_groups(a, 1.0 / 3.0 * double(n) * double(n) * double(n), [&](index_t g0, index_t g1) {
+        kern(n, g1 - g0, count - g0 * g, a.data() + g0 * n * n * g, out + g0 * g);
+    });
+    return count_failed(out, count);
+}
+
+}  // namespace
+
+void gemm(float alpha, StridedBatch<const float> a, StridedBatch<const float> b, float beta, StridedBatch<float> c) {
+    gemm_batch(alpha, a, b, beta, c);
+}
+void gemm(double alpha, StridedBatch<const double> a, StridedBatch<const double> b, double beta,
+          StridedBatch<double> c) {
+    gemm_batch(alpha, a, b, beta, c);
+}
+void gemm(float alpha, PointerBatch<const float> a, PointerBatch<const float> b, float beta, PointerBatch<float> c) {
+    gemm_batch(alpha, a, b, beta, c);
+}
+void gemm(double alpha, PointerBatch<const double> a, PointerBatch<const double> b, double beta,
+          PointerBatch<double> c) {
+    gemm_batch(alpha, a, b, beta, c);
+}
+void gemm(float alpha, InterleavedView<const float> a, InterleavedView<const float> b, float beta,
+          InterleavedView<float> c) {
+    gemm_interleaved(alpha, a, b, beta, c);
+}
+void gemm(double alpha, InterleavedView<const double> a, InterleavedView<const double> b, double beta,
+          InterleavedView<double> c) {
+    gemm_interleaved(alpha, a, b, beta, c);
+}
+
+index_t getrf(StridedBatch<float> a, std::int32_t* ipiv, std::int32_t* info) {
+    return getrf_batch<float>(a, ipiv, info);
+}
+index_t getrf(StridedBatch<double> a, std::int32_t* ipiv, std::int32_t* info) {
+    return getrf_batch<double>(a, ipiv, info);
+}
+index_t getrf(PointerBatch<float> a, std::int32_t* ipiv, std::int32_t* info) {
+    return getrf_batch<float>(a, ipiv, info);
+}
+index_t getrf(PointerBatch<double> a, std::int32_t* ipiv, std::int32_t* info) {
+    return getrf_batch<double>(a, ipiv, info);
+}
+index_t getrf(InterleavedView<float> a, std::int32_t* ipiv, std::int32_t* info) {
+    return getrf_interleaved(a, ipiv, info);
+}
+index_t getrf(InterleavedView<double> a, std::int32_t* ipiv, std::int32_t* info) {
+    return getrf_interleaved(a, ipiv, info);
+}
+
+index_t potrf(StridedBatch<float> a, std::int32_t* info) { return potrf_batch<float>(a, info); }
+index_t potrf(StridedBatch<double> a, std::int32_t* info) { return potrf_batch<double>(a, info); }
+index_t potrf(PointerBatch<float> a, std::int32_t* info) { return potrf_batch<float>(a, info); }
+index_t potrf(PointerBatch<double> a, std::int32_t* info) { return potrf_batch<double>(a, info); }
+index_t potrf(InterleavedView<float> a, std::int32_t* info) { return potrf_interleaved(a, info); }
+index_t potrf(InterleavedView<double> a, std::int32_t* info) { return potrf_interleaved(a, info); }
+
+}  // namespace batched
+}  // namespace lana
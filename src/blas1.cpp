@@ -0,0 +1,234 @@
+#include "lana/blas1.hpp"
+#include "lana/expr.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/workspace.hpp"
+
+#include "kernels/kernels.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace lana {
+namespace detail {
+namespace {
+
+/// Elements per task below which BLAS-1 stays on the calling thread; these
+/// kernels are bandwidth-bound and only pay off in parallel on large inputs.
+constexpr index_t parallel_min_elems = index_t(1) << 16;
+
+index_t blas1_tasks(index_t n) {
+    if (n < 2 * parallel_min_elems) {
+        return 1;
+    }
+    return std::min<index_t>(parallel_concurrency(), n / parallel_min_elems);
+}
+
+/// Elements per partial sum under Determinism::Bitwise. It is fixed, so the
+/// partials, and hence the rounding, do not depend on the task count.
+constexpr index_t bitwise_block = index_t(1) << 12;
+
+/// Sum of p[0, n) by recursive halving; the order depends on n alone.
+template <typename T>
+T pairwise_sum(const T* p, index_t n) {
+    if (n <= 8) {
+        T s = T(0);
+        for (index_t i = 0; i < n; ++i) {
+            s += p[i];
+        }
+        return s;
+    }
+    const index_t h = n / 2;
+    return pairwise_sum(p, h) + pairwise_sum(p + h, n - h);
+}
+
+/// chunked_reduce for Determinism::Bitwise: one partial per bitwise_block
+/// elements, each task filling a contiguous run of them.
+template <typename T, typename F>
+T blocked_reduce(index_t n, index_t tasks, F& chunk) {
+    const index_t blocks = (n + bitwise_block - 1) / bitwise_block;
+    if (blocks <= 1) {
+        return chunk(index_t(0), n);
+    }
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    T* partial = ws.allocate_n<T>(static_cast<std::size_t>(blocks));
+    const auto fill = [&](index_t b0, index_t b1) {
+        for (index_t b = b0; b < b1; ++b) {
+            const index_t lo = b * bitwise_block;
+            partial[b] = chunk(lo, std::min(n, lo + bitwise_block));
+        }
+    };
+    if (tasks <= 1) {
+        fill(0, blocks);
+    } else {
+        parallel_for(0, blocks, (blocks + tasks - 1) / tasks, fill);
+    }
+    return pairwise_sum(partial, blocks);
+}
+
+/// Sum over `tasks` contiguous chunks of [0, n), each reduced by `chunk(lo, hi)`.
+template <typename T, typename F>
+T chunked_reduce(index_t n, index_t tasks, F&& chunk) {
+    if (determinism() == Determinism::Bitwise) {
+        return blocked_reduce<T>(n, tasks, chunk);
+    }
+    if (tasks <= 1) {
+        return chunk(index_t(0), n);
+    }
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    T* partial = ws.allocate_n<T>(static_cast<std::size_t>(tasks));
+    const index_t step = (n + tasks - 1) / tasks;
+    parallel_run(tasks, [&](index_t t) {
+        const index_t lo = t * step;
+        partial[t] = lo < n ? chunk(lo, std::min(n, lo + step)) : T(0);
+    });
+    T s = T(0);
+    for (index_t t = 0; t < tasks; ++t) {
+        s += partial[t];
+    }
+    return s;
+}
+
+template <typename T>
+T dot_impl(VectorView<const T> x, VectorView<const T> y) {
+    require_dims(x.size() == y.size(), "dot");
+    static const int prof_id = profile::detail::kernel_id("dot");
+    const auto n = static_cast<double>(x.size());
+    const profile::Scope prof(prof_id, profile::dtype_of<T>(), x.size(), 2.0 * n, 2.0 * n * sizeof(T));
+    if (x.stride() == 1 && y.stride() == 1) {
+        const auto kdot = kernels<T>().dot;
+        return chunked_reduce<T>(x.size(), blas1_tasks(x.size()),
+                                 [&](index_t lo, index_t hi) { return kdot(hi - lo, x.data() + lo, y.data() + lo); });
+    }
+    T s = T(0);
+    for (index_t i = 0; i < x.size(); ++i) {
+        s += x[i] * y[i];
+    }
+    return s;
+}
+
+template <typename T>
+void axpy_impl(T alpha, VectorView<const T> x, VectorView<T> y) {
+    require_dims(x.size() == y.size(), "axpy");
+    static const int prof_id = profile::detail::kernel_id("axpy");
+    const auto n = static_cast<double>(x.size());
+    const profile::Scope prof(prof_id, profile::dtype_of<T>(), x.size(), 2.0 * n, 3.0 * n * sizeof(T));
+    if (alpha == T(0)) {
+        return;
+    }
+    if (x.stride() == 1 && y.stride() == 1) {
+        const auto kaxpy = kernels<T>().axpy;
+        const index_t n = x.size();
+        const index_t tasks = blas1_tasks(n);
+        if (tasks <= 1) {
+            kaxpy(n, alpha, x.data(), y.data());
+            return;
+        }
+        parallel_for(0, n, (n + tasks - 1) / tasks,
+                     [&](index_t lo, index_t hi) { kaxpy(hi - lo, alpha, x.data() + lo, y.data() + lo); });
+        return;
+    }
+    for (index_t i = 0; i < x.size(); ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template <typename T>
+T sum_impl(VectorView<const T> x) {
+    static const int prof_id = profile::detail::kernel_id("sum");
+    const auto n = static_cast<double>(x.size());
+    const profile::Scope prof(prof_id, profile::dtype_of<T>(), x.size(), n, n * sizeof(T));
+    if (x.stride() == 1) {
+        const auto ksum = kernels<T>().sum;
+        return chunked_reduce<T>(x.size(), blas1_tasks(x.size()),
+                                 [&](index_t lo, index_t hi) { return ksum(hi - lo, x.data() + lo); });
+    }
+    T s = T(0);
+    for (index_t i = 0; i < x.size(); ++i) {
+        s += x[i];
+    }
+    return s;
+}
+
+template <typename T>
+T nrm2_impl(VectorView<const T> x) {
+    static const int prof_id = profile::detail::kernel_id("nrm2");
+    const auto n = static_cast<double>(x.size());
+    const profile::Scope prof(prof_id, profile::dtype_of<T>(), x.size(), 2.0 * n, n * sizeof(T));
+    T ss = T(0);
+    if (x.stride() == 1) {
+        const auto ksumsq = kernels<T>().sumsq;
+        ss = chunked_reduce<T>(x.size(), blas1_tasks(x.size()),
+                               [&](index_t lo, index_t hi) { return ksumsq(hi - lo, x.data() + lo); });
+    } else {
+        for (index_t i = 0; i < x.size(); ++i) {
+            ss += x[i] * x[i];
+        }
+    }
+    // The fast unscaled sum is exact enough unless it over- or underflowed;
+    // only then pay for a second, scaled pass.
+    if (std::isfinite(ss) && ss >= std::numeric_limits<T>::min() / std::numeric_limits<T>::epsilon()) {
+        return std::sqrt(ss);
+    }
+    T scale = T(0);
+    for (index_t i = 0; i < x.size(); ++i) {
+        scale = std::max(scale, std::abs(x[i]));
+    }
+    if (scale == T(0) || !std::isfinite(scale)) {
+        return scale;
+    }
+    T s = T(0);
+    for (index_t i = 0; i < x.size(); ++i) {
+        const T v = x[i] / scale;
+        s += v * v;
+    }
+    return scale * std::sqrt(s);
+}
+
+template <typename T>
+void lincomb_impl(index_t n, int terms, const T* coeffs, const T* const* xs, T* y) {
+    static const int prof_id = profile::detail::kernel_id("lincomb");
+    const auto len = static_cast<double>(n);
+    const profile::Scope prof(prof_id, profile::dtype_of<T>(), n, 2.0 * terms * len, (terms + 1.0) * len * sizeof(T));
+    const auto klincomb = kernels<T>().lincomb;
+    const index_t tasks = blas1_tasks(n);
+    if (tasks <= 1) {
+        klincomb(n, terms, coeffs, xs, y);
+        return;
+    }
+    parallel_for(0, n, (n + tasks - 1) / tasks, [&](index_t lo, index_t hi) {
+        const T* shifted[lincomb_max_terms];
+        for (int t = 0; t < terms; ++t) {
+            shifted[t] = xs[t] + lo;
+        }
+        klincomb(hi - lo, terms, coeffs, shifted, y + lo);
+    });
+}
+
+}  // namespace
+
+void lincomb(index_t n, int terms, const float* coeffs, const float* const* xs, float* y) {
+    lincomb_impl(n, terms, coeffs, xs, y);
+}
+void lincomb(index_t n, int terms, const double* coeffs, const double* const* xs, double* y) {
+    lincomb_impl(n, terms, coeffs, xs, y);
+}
+
+}  // namespace detail
+
+float dot(VectorView<const float> x, VectorView<const float> y) { return detail::dot_impl(x, y); }
+double dot(VectorView<const double> x, VectorView<const double> y) { return detail::dot_impl(x, y); }
+
+void axpy(float alpha, VectorView<const float> x, VectorView<float> y) { detail::axpy_impl(alpha, x, y); }
+void axpy(double alpha, VectorView<const double> x, VectorView<double> y) { detail::axpy_impl(alpha, x, y); }
+
+float sum(VectorView<const float> x) { return detail::sum_impl(x); }
+double sum(VectorView<const double> x) { return detail::sum_impl(x); }
+
+float nrm2(VectorView<const float> x) { return detail::nrm2_impl(x); }
+double nrm2(VectorView<const double> x) { return detail::nrm2_impl(x); }
+
+}  // namespace lana
@@ -0,0 +1,448 @@
+// Device plugin loading and the offload decision for the public kernels.
+
+#include "lana/device.hpp"
+#include "lana/cpu.hpp"
+#include "lana/device_plugin.hpp"
+#include "lana/error.hpp"
+#include "lana/thread_pool.hpp"
+
+#include "device_internal.hpp"
+
+#include <dlfcn.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lana::device {
+namespace detail {
+namespace {
+
+static_assert(sizeof(index_t) == sizeof(std::int64_t) && sizeof(sparse_index_t) == sizeof(std::int32_t),
+              "lana_device_csr mirrors lana's CSR index types");
+
+/// Nominal clock for the CPU rate estimate; Policy overrides the estimate.
+constexpr double nominal_ghz = 2.5;
+
+struct Resident {
+    const void* values;
+    const index_t* row_ptr;
+    const sparse_index_t* col_idx;
+    index_t rows;
+    index_t cols;
+    bool f64;
+    void* handle;
+};
+
+struct State {
+    std::mutex mutex;  // guards everything but `backend` and `resident_count`
+    std::atomic<const lana_device_backend*> backend{nullptr};
+    void* library = nullptr;
+    Info info;
+    Policy policy;
+    std::vector<Resident> resident;
+    std::atomic<int> resident_count{0};
+    std::once_flag env_once;
+    std::atomic<bool> loaded_explicitly{false};
+};
+
+/// Never destroyed: the plugin's runtime may already be torn down by the
+/// time static destructors run, so shutdown is left to process exit.
+State& state() {
+    static State* s = new State;
+    return *s;
+}
+
+void unload_locked(State& s) noexcept {
+    const lana_device_backend* be = s.backend.exchange(nullptr, std::memory_order_acq_rel);
+    if (be != nullptr) {
+        for (const Resident& r : s.resident) {
+            be->csr_release(be->self, r.handle);
+        }
+        s.resident.clear();
+        s.resident_count.store(0, std::memory_order_relaxed);
+        be->shutdown(be->self);
+    }
+    if (s.library != nullptr) {
+        ::dlclose(s.library);
+        s.library = nullptr;
+    }
+    s.info = Info{};
+}
+
+void load_plugin(const std::string& path);
+
+/// The loaded backend, or null; tries LANA_DEVICE_PLUGIN on first use
+/// unless load() came first.
+const lana_device_backend* active() noexcept {
+    State& s = state();
+    std::call_once(s.env_once, [&s] {
+        const char* path = std::getenv("LANA_DEVICE_PLUGIN");
+        if (path == nullptr || *path == '\0' || s.loaded_explicitly.load(std::memory_order_acquire)) {
+            return;
+        }
+        try {
+            load_plugin(path);
+        } catch (const Error&) {
+            // No usable device: everything stays on the CPU.
+        }
+    });
+    return s.backend.load(std::memory_order_acquire);
+}
+
+Policy current_policy() {
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.policy;
+}
+
+double cpu_gflops(const Policy& p, bool f64) {
+    const double set = f64 ? p.cpu_gflops_f64 : p.cpu_gflops_f32;
+    if (set > 0) {
+        return set;
+    }
+    double per_cycle = 2;  // f64 flops per cycle and core
+    switch (active_isa()) {
+    case Isa::Avx512:
+        per_cycle = 32;
+        break;
+    case Isa::Avx2:
+        per_cycle = 16;
+        break;
+    case Isa::Neon:
+        per_cycle = 8;
+        break;
+    case Isa::Sse42:
+        per_cycle = 4;
+        break;
+    case Isa::Scalar:
+        break;
+    }
+    return per_cycle * (f64 ? 1 : 2) * nominal_ghz * lana::detail::parallel_concurrency();
+}
+
+/// Device time (link transfers plus compute) against CPU time.
+bool worth_it(double flops, double bytes, index_t min_dim, bool f64) {
+    const Policy p = current_policy();
+    if (!p.enabled || determinism() == Determinism::Bitwise || flops < p.min_flops || min_dim < p.min_dim) {
+        return false;
+    }
+    const Info& info = state().info;
+    const double dev = f64 ? info.gflops_f64 : info.gflops_f32;
+    if (dev <= 0 || info.link_gbps <= 0) {
+        return false;
+    }
+    const double t_cpu = flops / (cpu_gflops(p, f64) * 1e9);
+    const double t_dev = bytes / (info.link_gbps * 1e9) + flops / (dev * 1e9);
+    return t_dev < t_cpu;
+}
+
+template <typename T>
+constexpr std::int32_t dtype_of() {
+    return std::is_same_v<T, float> ? LANA_DEVICE_F32 : LANA_DEVICE_F64;
+}
+
+template <typename T>
+bool describable(MatrixView<T> v) {
+    return v.row_stride() == 1 || v.col_stride() == 1;
+}
+
+template <typename T>
+lana_device_matrix describe(MatrixView<T> v) {
+    return {const_cast<std::remove_const_t<T>*>(v.data()), v.rows(), v.cols(), v.row_stride(), v.col_stride(),
+            dtype_of<std::remove_const_t<T>>()};
+}
+
+double gemm_flops(index_t m, index_t n, index_t k) {
+    return 2.0 * static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k);
+}
+
+template <typename T>
+bool gemm_impl(T alpha, MatrixView<const T> a, MatrixView<const T> b, T beta, MatrixView<T> c) {
+    const lana_device_backend* be = active();
+    if (be == nullptr || a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols()) {
+        return false;
+    }
+    if (!describable(a) || !describable(b) || !describable(c)) {
+        return false;
+    }
+    const index_t m = c.rows();
+    const index_t n = c.cols();
+    const index_t k = a.cols();
+    const auto dm = static_cast<double>(m);
+    const auto dn = static_cast<double>(n);
+    const auto dk = static_cast<double>(k);
+    const double bytes = (dm * dk + dk * dn + (beta == T(0) ? 1.0 : 2.0) * dm * dn) * sizeof(T);
+    if (!worth_it(gemm_flops(m, n, k), bytes, std::min({m, n, k}), std::is_same_v<T, double>)) {
+        return false;
+    }
+    const lana_device_matrix da = describe(a);
+    const lana_device_matrix db = describe(b);
+    const lana_device_matrix dc = describe(c);
+    return be->gemm(be->self, alpha, &da, &db, beta, &dc) == 0;
+}
+
+template <typename T>
+bool getrf_impl(MatrixView<T> a, std::int32_t* ipiv, index_t& info) {
+    const lana_device_backend* be = active();
+    if (be == nullptr || !describable(a)) {
+        return false;
+    }
+    const auto m = static_cast<double>(a.rows());
+    const auto n = static_cast<double>(a.cols());
+    const double k = std::min(m, n);
+    const double flops = m * n * k - (m + n) * k * k / 2 + k * k * k / 3;
+    if (!worth_it(flops, 2 * m * n * sizeof(T), std::min(a.rows(), a.cols()), std::is_same_v<T, double>)) {
+        return false;
+    }
+    const lana_device_matrix da = describe(a);
+    std::int64_t dinfo = 0;
+    if (be->getrf(be->self, &da, ipiv, &dinfo) != 0) {
+        return false;
+    }
+    info = static_cast<index_t>(dinfo);
+    return true;
+}
+
+template <typename T>
+bool potrf_impl(MatrixView<T> a, index_t& info) {
+    const lana_device_backend* be = active();
+    if (be == nullptr || a.rows() != a.cols() || !describable(a)) {
+        return false;
+    }
+    const auto n = static_cast<double>(a.rows());
+    if (!worth_it(n * n * n / 3, 2 * n * n * sizeof(T), a.rows(), std::is_same_v<T, double>)) {
+        return false;
+    }
+    const lana_device_matrix da = describe(a);
+    std::int64_t dinfo = 0;
+    if (be->potrf(be->self, &da, &dinfo) != 0) {
+        return false;
+    }
+    info = static_cast<index_t>(dinfo);
+    return true;
+}
+
+template <typename T>
+bool spmv_impl(T alpha, CsrView<T> a, VectorView<const T> x, T beta, VectorView<T> y) {
+    State& s = state();
+    if (s.resident_count.load(std::memory_order_acquire) == 0 || x.size() != a.cols() || y.size() != a.rows()) {
+        return false;
+    }
+    const lana_device_backend* be = active();
+    void* handle = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (!s.policy.enabled || determinism() == Determinism::Bitwise) {
+            return false;
+        }
+        for (const Resident& r : s.resident) {
+            if (r.values == a.values() && r.row_ptr == a.row_ptr() && r.col_idx == a.col_idx() && r.rows == a.rows() &&
+                r.cols == a.cols() && r.f64 == std::is_same_v<T, double>) {
+                handle = r.handle;
+                break;
+            }
+        }
+    }
+    if (be == nullptr || handle == nullptr) {
+        return false;
+    }
+    return be->spmv(be->self, handle, alpha, x.data(), x.stride(), beta, y.data(), y.stride()) == 0;
+}
+
+void load_plugin(const std::string& path) {
+    void* lib = ::dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (lib == nullptr) {
+        const char* why = ::dlerror();
+        throw Error("lana: cannot load device plugin '" + path + "': " + (why != nullptr ? why : "unknown error"));
+    }
+    {
+        // The same object again: its entry point would hand back the live
+        // backend, which replacing would then shut down under us.
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        if (lib == s.library && s.backend.load(std::memory_order_acquire) != nullptr) {
+            ::dlclose(lib);
+            return;
+        }
+    }
+    const auto entry = reinterpret_cast<lana_device_entry_fn>(::dlsym(lib, "lana_device_backend_v1"));
+    if (entry == nullptr) {
+        ::dlclose(lib);
+        throw Error("lana: '" + path + "' is not a lana device plugin (no lana_device_backend_v1)");
+    }
+    const lana_device_backend* be = entry();
+    if (be == nullptr) {
+        ::dlclose(lib);
+        throw Error("lana: device plugin '" + path + "' found no usable device");
+    }
+    if (be->abi_version != LANA_DEVICE_ABI_VERSION) {
+        ::dlclose(lib);
+        throw Error("lana: device plugin '" + path + "' has ABI version " + std::to_string(be->abi_version) +
+                    ", expected " + std::to_string(LANA_DEVICE_ABI_VERSION));
+    }
+    lana_device_info raw{};
+    if (be->query(be->self, &raw) != 0) {
+        be->shutdown(be->self);
+        ::dlclose(lib);
+        throw Error("lana: device plugin '" + path + "' could not query its device");
+    }
+    raw.name[sizeof(raw.name) - 1] = '\0';
+    raw.platform[sizeof(raw.platform) - 1] = '\0';
+
+    State& s = state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    unload_locked(s);
+    s.library = lib;
+    s.info = Info{raw.name, raw.platform, raw.gflops_f32, raw.gflops_f64, raw.link_gbps,
+                  static_cast<std::size_t>(raw.memory_bytes)};
+    s.backend.store(be, std::memory_order_release);
+}
+
+}  // namespace
+}  // namespace detail
+
+void load(const std::string& path) {
+    detail::state().loaded_explicitly.store(true, std::memory_order_release);
+    detail::load_plugin(path);
+}
+
+void unload() noexcept {
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    detail::unload_locked(s);
+}
+
+bool available() noexcept { return detail::active() != nullptr; }
+
+Info info() {
+    if (!available()) {
+        throw Error("lana: no device plugin is loaded");
+    }
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    return s.info;
+}
+
+Policy policy() { return detail::current_policy(); }
+
+void set_policy(const Policy& p) {
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.policy = p;
+}
+
+bool offloads_gemm(index_t m, index_t n, index_t k, bool f64) noexcept {
+    if (detail::active() == nullptr) {
+        return false;
+    }
+    const double elem = f64 ? sizeof(double) : sizeof(float);
+    const auto dm = static_cast<double>(m);
+    const auto dn = static_cast<double>(n);
+    const auto dk = static_cast<double>(k);
+    return detail::worth_it(detail::gemm_flops(m, n, k), (dm * dk + dk * dn + 2 * dm * dn) * elem, std::min({m, n, k}),
+                            f64);
+}
+
+ResidentCsr::ResidentCsr(CsrView<float> a) {
+    attach(a.rows(), a.cols(), a.row_ptr(), a.col_idx(), a.values(), false);
+}
+ResidentCsr::ResidentCsr(CsrView<double> a) {
+    attach(a.rows(), a.cols(), a.row_ptr(), a.col_idx(), a.values(), true);
+}
+
+ResidentCsr::~ResidentCsr() { release(); }
+
+ResidentCsr::ResidentCsr(ResidentCsr&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+
+ResidentCsr& ResidentCsr::operator=(ResidentCsr&& other) noexcept {
+    if (this != &other) {
+        release();
+        handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+}
+
+void ResidentCsr::attach(index_t rows, index_t cols, const index_t* row_ptr, const sparse_index_t* col_idx,
+                         const void* values, bool f64) {
+    const lana_device_backend* be = detail::active();
+    const index_t nnz = row_ptr != nullptr ? row_ptr[rows] : 0;
+    if (be == nullptr) {
+        return;
+    }
+    const Policy p = detail::current_policy();
+    if (!p.enabled || nnz < p.min_spmv_nnz) {
+        return;
+    }
+    const lana_device_csr desc{rows,
+                               cols,
+                               nnz,
+                               reinterpret_cast<const std::int64_t*>(row_ptr),
+                               col_idx,
+                               values,
+                               f64 ? LANA_DEVICE_F64 : LANA_DEVICE_F32};
+    void* handle = nullptr;
+    if (be->csr_upload(be->self, &desc, &handle) != 0) {
+        return;
+    }
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    s.resident.push_back({values, row_ptr, col_idx, rows, cols, f64, handle});
+    s.resident_count.fetch_add(1, std::memory_order_release);
+    handle_ = handle;
+}
+
+void ResidentCsr::release() noexcept {
+    if (handle_ == nullptr) {
+        return;
+    }
+    detail::State& s = detail::state();
+    std::lock_guard<std::mutex> lock(s.mutex);
+    // unload() may have released it already.
+    const auto it = std::find_if(s.resident.begin(), s.resident.end(),
+                                 [&](const detail::Resident& r) { return r.handle == handle_; });
+    if (it != s.resident.end()) {
+        s.resident.erase(it);
+        s.resident_count.fetch_sub(1, std::memory_order_release);
+        if (const lana_device_backend* be = s.backend.load(std::memory_order_acquire)) {
+            be->csr_release(be->self, handle_);
+        }
+    }
+    handle_ = nullptr;
+}
+
+}  // namespace lana::device
+
+namespace lana::detail {
+
+bool device_gemm(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta, MatrixView<float> c) {
+    return device::detail::gemm_impl(alpha, a, b, beta, c);
+}
+bool device_gemm(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+                 MatrixView<double> c) {
+    return device::detail::gemm_impl(alpha, a, b, beta, c);
+}
+
+bool device_getrf(MatrixView<float> a, std::int32_t* ipiv, index_t& info) {
+    return device::detail::getrf_impl(a, ipiv, info);
+}
+bool device_getrf(MatrixView<double> a, std::int32_t* ipiv, index_t& info) {
+    return device::detail::getrf_impl(a, ipiv, info);
+}
+
+bool device_potrf(MatrixView<float> a, index_t& info) { return device::detail::potrf_impl(a, info); }
+bool device_potrf(MatrixView<double> a, index_t& info) { return device::detail::potrf_impl(a, info); }
+
+bool device_spmv(float alpha, CsrView<float> a, VectorView<const float> x, float beta, VectorView<float> y) {
+    return device::detail::spmv_impl(alpha, a, x, beta, y);
+}
+bool device_spmv(double alpha, CsrView<double> a, VectorView<const double> x, double beta, VectorView<double> y) {
+    return device::detail::spmv_impl(alpha, a, x, beta, y);
+}
+
+}  // namespace lana::detail
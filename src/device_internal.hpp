@@ -0,0 +1,29 @@
+#pragma once
+
+// Hooks of the device dispatcher (device.cpp) in the public kernels. Each
+// returns true if the operation ran on the device, and false, with every
+// output untouched, if it should run on the CPU: no plugin, too small for
+// the cost model, operands it cannot describe, or a plugin failure.
+
+#include "lana/matrix.hpp"
+#include "lana/sparse.hpp"
+#include "lana/vector.hpp"
+
+#include <cstdint>
+
+namespace lana::detail {
+
+bool device_gemm(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta, MatrixView<float> c);
+bool device_gemm(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+                 MatrixView<double> c);
+
+bool device_getrf(MatrixView<float> a, std::int32_t* ipiv, index_t& info);
+bool device_getrf(MatrixView<double> a, std::int32_t* ipiv, index_t& info);
+
+bool device_potrf(MatrixView<float> a, index_t& info);
+bool device_potrf(MatrixView<double> a, index_t& info);
+
+bool device_spmv(float alpha, CsrView<float> a, VectorView<const float> x, float beta, VectorView<float> y);
+bool device_spmv(double alpha, CsrView<double> a, VectorView<const double> x, double beta, VectorView<double> y);
+
+}  // namespace lana::detail
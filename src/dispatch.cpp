@@ -0,0 +1,256 @@
+// Host ISA detection and kernel-table selection.
+//
+// The tables themselves are constant data. Which one to use is decided on
+// the first kernel call (or by warmup()), not when the library is loaded,
+// so loading it runs no CPUID and reads no environment; after that every
+// kernel call is a guard check and one indirect jump through the table.
+
+#include "kernels/kernels.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <cpuid.h>
+#endif
+#if defined(__x86_64__) && defined(__linux__)
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+#if defined(__aarch64__) && defined(__linux__)
+#  include <asm/hwcap.h>
+#  include <sys/auxv.h>
+#endif
+
+namespace lana {
+namespace detail {
+namespace {
+
+struct HostFeatures {
+    bool sse42 = false;
+    bool avx2 = false;  // AVX2 + FMA3, with OS-enabled YMM state
+    bool avx512 = false;  // AVX-512F, with OS-enabled ZMM/opmask state
+    bool avx512bf16 = false;
+    bool amx_bf16 = false;  // AMX-TILE + AMX-BF16, with OS-enabled tile state
+    bool neon = false;
+};
+
+#if defined(__x86_64__) || defined(__i386__)
+unsigned long long read_xcr0() {
+    unsigned eax = 0;
+    unsigned edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+#endif
+
+HostFeatures probe_host() {
+    HostFeatures f;
+#if defined(__x86_64__) || defined(__i386__)
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+        return f;
+    }
+    f.sse42 = (ecx & bit_SSE4_2) != 0;
+    const bool osxsave = (ecx & bit_OSXSAVE) != 0;
+    const bool fma = (ecx & bit_FMA) != 0;
+    const bool avx = (ecx & bit_AVX) != 0;
+    const unsigned long long xcr0 = osxsave ? read_xcr0() : 0;
+    const bool ymm_state = (xcr0 & 0x6) == 0x6;      // XMM | YMM
+    const bool zmm_state = (xcr0 & 0xe6) == 0xe6;    // XMM | YMM | opmask | ZMM_Hi256 | Hi16_ZMM
+    if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        f.avx2 = avx && fma && ymm_state && (ebx & bit_AVX2) != 0;
+        f.avx512 = f.avx2 && zmm_state && (ebx & bit_AVX512F) != 0;
+    }
+    if (f.avx512 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+        const bool tile_state = (xcr0 & 0x60000) == 0x60000;  // XTILECFG | XTILEDATA
+        f.amx_bf16 = tile_state && (edx & (1u << 24)) != 0 && (edx & (1u << 22)) != 0;
+    }
+    if (f.avx512 && __get_cpuid_count(7, 1, &eax, &ebx, &ecx, &edx)) {
+        f.avx512bf16 = (eax & (1u << 5)) != 0;
+    }
+#elif defined(__aarch64__)
+#  if defined(__linux__)
+    f.neon = (getauxval(AT_HWCAP) & HWCAP_ASIMD) != 0;
+#  else
+    f.neon = true;  // Advanced SIMD is mandatory in AArch64
+#  endif
+#endif
+    return f;
+}
+
+const HostFeatures& host_features() {
+    static const HostFeatures f = probe_host();
+    return f;
+}
+
+bool built_with(Isa isa) {
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::Sse42:
+#if defined(LANA_HAVE_SSE42_KERNELS)
+            return true;
+#else
+            return false;
+#endif
+        case Isa::Avx2:
+#if defined(LANA_HAVE_AVX2_KERNELS)
+            return true;
+#else
+            return false;
+#endif
+        case Isa::Avx512:
+#if defined(LANA_HAVE_AVX512_KERNELS)
+            return true;
+#else
+            return false;
+#endif
+        case Isa::Neon:
+#if defined(LANA_HAVE_NEON_KERNELS)
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+bool host_runs(Isa isa) {
+    const HostFeatures& f = host_features();
+    switch (isa) {
+        case Isa::Scalar:
+            return true;
+        case Isa::Sse42:
+            return f.sse42;
+        case Isa::Avx2:
+            return f.avx2;
+        case Isa::Avx512:
+            return f.avx512;
+        case Isa::Neon:
+            return f.neon;
+    }
+    return false;
+}
+
+constexpr Isa preference_order[] = {Isa::Avx512, Isa::Avx2, Isa::Sse42, Isa::Neon, Isa::Scalar};
+
+Isa select_isa() {
+    if (const char* forced = std::getenv("LANA_ISA")) {
+        for (Isa isa : preference_order) {
+            if (std::strcmp(forced, isa_name(isa)) == 0 && isa_supported(isa)) {
+                return isa;
+            }
+        }
+    }
+    for (Isa isa : preference_order) {
+        if (isa_supported(isa)) {
+            return isa;
+        }
+    }
+    return Isa::Scalar;
+}
+
+struct Dispatch {
+    Isa isa;
+    const KernelTable<float>* f32;
+    const KernelTable<double>* f64;
+};
+
+Dispatch make_dispatch() {
+    const Isa isa = select_isa();
+    switch (isa) {
+#if defined(LANA_HAVE_AVX512_KERNELS)
+        case Isa::Avx512:
+            return {isa, &avx512::kernels_f32(), &avx512::kernels_f64()};
+#endif
+#if defined(LANA_HAVE_AVX2_KERNELS)
+        case Isa::Avx2:
+            return {isa, &avx2::kernels_f32(), &avx2::kernels_f64()};
+#endif
+#if defined(LANA_HAVE_SSE42_KERNELS)
+        case Isa::Sse42:
+            return {isa, &sse42::kernels_f32(), &sse42::kernels_f64()};
+#endif
+#if defined(LANA_HAVE_NEON_KERNELS)
+        case Isa::Neon:
+            return {isa, &neon::kernels_f32(), &neon::kernels_f64()};
+#endif
+        default:
+            return {Isa::Scalar, &scalar::kernels_f32(), &scalar::kernels_f64()};
+    }
+}
+
+const Dispatch& dispatch() {
+    static const Dispatch d = make_dispatch();
+    return d;
+}
+
+#if defined(LANA_HAVE_AMX_KERNELS)
+/// Linux hands out the AMX tile data state per process on request.
+bool request_amx_state() {
+#if defined(__x86_64__) && defined(__linux__)
+    constexpr long arch_req_xcomp_perm = 0x1023;
+    constexpr long xfeature_xtiledata = 18;
+    return syscall(SYS_arch_prctl, arch_req_xcomp_perm, xfeature_xtiledata) == 0;
+#else
+    return false;
+#endif
+}
+#endif
+
+const MixedGemmKernel* select_bf16_kernel() {
+    // Follows the table choice, so LANA_ISA=avx2 also turns these off.
+    if (dispatch().isa != Isa::Avx512) {
+        return nullptr;
+    }
+    const HostFeatures& f = host_features();
+#if defined(LANA_HAVE_AMX_KERNELS)
+    if (f.amx_bf16 && request_amx_state()) {
+        return &amx::gemm_bf16_kernel();
+    }
+#endif
+#if defined(LANA_HAVE_AVX512BF16_KERNELS)
+    if (f.avx512bf16) {
+        return &avx512bf16::gemm_bf16_kernel();
+    }
+#endif
+    (void)f;
+    return nullptr;
+}
+
+}  // namespace
+
+const KernelTable<float>& kernels_f32() { return *dispatch().f32; }
+const KernelTable<double>& kernels_f64() { return *dispatch().f64; }
+
+// Resolved on first use, so processes that never run bfloat16 GEMM do not
+// ask for the AMX state.
+const MixedGemmKernel* gemm_bf16_kernel() {
+    static const MixedGemmKernel* const kern = select_bf16_kernel();
+    return kern;
+}
+
+}  // namespace detail
+
+Isa active_isa() noexcept { return detail::dispatch().isa; }
+
+bool isa_supported(Isa isa) noexcept { return detail::built_with(isa) && detail::host_runs(isa); }
+
+const char* isa_name(Isa isa) noexcept {
+    switch (isa) {
+        case Isa::Scalar:
+            return "scalar";
+        case Isa::Sse42:
+            return "sse4.2";
+        case Isa::Avx2:
+            return "avx2";
+        case Isa::Avx512:
+            return "avx512";
+        case Isa::Neon:
+            return "neon";
+    }
+    return "unknown";
+}
+
+}  // namespace lana
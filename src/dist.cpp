@@ -0,0 +1,501 @@
+// Block-cyclic distributed GEMM (SUMMA) and LU over MPI.
+//
+// Both algorithms move panels: a block column of A and a block row of B
+// for SUMMA, the factored L panel and the U block row for LU. A panel is
+// packed into a contiguous buffer, broadcast nonblocking along the row or
+// column communicator, and consumed by lana's local GEMM and trsm.
+
+#include "lana/dist.hpp"
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/memory.hpp"
+#include "lana/profile.hpp"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace lana::dist {
+namespace detail {
+namespace {
+
+/// Columns of the local SUMMA update between two MPI_Testall calls, which
+/// let the broadcasts of the next panels progress during the update.
+constexpr index_t progress_cols = 256;
+
+template <typename T>
+MPI_Datatype mpi_type() {
+    return std::is_same_v<T, float> ? MPI_FLOAT : MPI_DOUBLE;
+}
+
+void check(int rc, const char* what) {
+    if (rc != MPI_SUCCESS) {
+        throw Error(std::string("lana: ") + what + " failed");
+    }
+}
+
+/// Element count of one message; MPI counts are int.
+int count_of(index_t n, const char* what) {
+    lana::detail::require_dims(n <= INT_MAX, what);
+    return static_cast<int>(n);
+}
+
+template <typename T>
+void pack(MatrixView<const T> v, T* out) {
+    for (index_t j = 0; j < v.cols(); ++j) {
+        for (index_t i = 0; i < v.rows(); ++i) {
+            *out++ = v(i, j);
+        }
+    }
+}
+
+template <typename T>
+void unpack(const T* in, MatrixView<T> v) {
+    for (index_t j = 0; j < v.cols(); ++j) {
+        for (index_t i = 0; i < v.rows(); ++i) {
+            v(i, j) = *in++;
+        }
+    }
+}
+
+/// Local piece of a distributed matrix on process (prow, pcol), as
+/// (global row, global column) of each local index; for scatter/gather
+/// on the root, which handles every process's piece.
+struct Piece {
+    index_t mb, nb;
+    int prows, pcols, prow, pcol;
+
+    index_t rows(index_t m) const { return local_extent(m, mb, prow, prows); }
+    index_t cols(index_t n) const { return local_extent(n, nb, pcol, pcols); }
+    index_t global_row(index_t li) const { return ((li / mb) * prows + prow) * mb + li % mb; }
+    index_t global_col(index_t lj) const { return ((lj / nb) * pcols + pcol) * nb + lj % nb; }
+};
+
+template <typename T>
+void scatter_impl(MatrixView<const T> src, int root, Matrix<T>& dst) {
+    const Grid& g = dst.grid();
+    const MatrixView<T> local = dst.local();
+    const int tag = 0x6c61;
+    if (g.rank() != root) {
+        if (local.rows() * local.cols() > 0) {
+            check(MPI_Recv(local.data(), count_of(local.rows() * local.cols(), "dist::scatter"), mpi_type<T>(), root,
+                           tag, g.comm(), MPI_STATUS_IGNORE),
+                  "MPI_Recv");
+        }
+        return;
+    }
+    lana::detail::require_dims(src.rows() == dst.rows() && src.cols() == dst.cols(), "dist::scatter");
+    std::vector<T> buf;
+    for (int r = 0; r < g.prows() * g.pcols(); ++r) {
+        const Piece p{dst.mb(), dst.nb(), g.prows(), g.pcols(), r / g.pcols(), r % g.pcols()};
+        const index_t lr = p.rows(dst.rows());
+        const index_t lc = p.cols(dst.cols());
+        if (lr * lc == 0) {
+            continue;
+        }
+        buf.resize(static_cast<std::size_t>(lr * lc));
+        for (index_t lj = 0; lj < lc; ++lj) {
+            const index_t j = p.global_col(lj);
+            for (index_t li = 0; li < lr; ++li) {
+                buf[static_cast<std::size_t>(lj * lr + li)] = src(p.global_row(li), j);
+            }
+        }
+        if (r == root) {
+            unpack(buf.data(), local);
+        } else {
+            check(MPI_Send(buf.data(), count_of(lr * lc, "dist::scatter"), mpi_type<T>(), r, tag, g.comm()),
+                  "MPI_Send");
+        }
+    }
+}
+
+template <typename T>
+void gather_impl(const Matrix<T>& src, int root, MatrixView<T> dst) {
+    const Grid& g = src.grid();
+    const MatrixView<const T> local = src.local();
+    const int tag = 0x6c62;
+    if (g.rank() != root) {
+        if (local.rows() * local.cols() > 0) {
+            std::vector<T> buf(static_cast<std::size_t>(local.rows() * local.cols()));
+            pack(local, buf.data());
+            check(MPI_Send(buf.data(), count_of(local.rows() * local.cols(), "dist::gather"), mpi_type<T>(), root, tag,
+                           g.comm()),
+                  "MPI_Send");
+        }
+        return;
+    }
+    lana::detail::require_dims(dst.rows() == src.rows() && dst.cols() == src.cols(), "dist::gather");
+    std::vector<T> buf;
+    for (int r = 0; r < g.prows() * g.pcols(); ++r) {
+        const Piece p{src.mb(), src.nb(), g.prows(), g.pcols(), r / g.pcols(), r % g.pcols()};
+        const index_t lr = p.rows(src.rows());
+        const index_t lc = p.cols(src.cols());
+        if (lr * lc == 0) {
+            continue;
+        }
+        buf.resize(static_cast<std::size_t>(lr * lc));
+        if (r == root) {
+            pack(local, buf.data());
+        } else {
+            check(MPI_Recv(buf.data(), count_of(lr * lc, "dist::gather"), mpi_type<T>(), r, tag, g.comm(),
+                           MPI_STATUS_IGNORE),
+                  "MPI_Recv");
+        }
+        for (index_t lj = 0; lj < lc; ++lj) {
+            const index_t j = p.global_col(lj);
+            for (index_t li = 0; li < lr; ++li) {
+                dst(p.global_row(li), j) = buf[static_cast<std::size_t>(lj * lr + li)];
+            }
+        }
+    }
+}
+
+template <typename T>
+profile::Scope dist_scope(int id, index_t size, double flops, double bytes) {
+    return profile::Scope(id, profile::dtype_of<T>(), size, flops, bytes);
+}
+
+template <typename T>
+void gemm_impl(T alpha, const Matrix<T>& a, const Matrix<T>& b, T beta, Matrix<T>& c) {
+    const Grid& g = c.grid();
+    lana::detail::require_dims(&a.grid() == &g && &b.grid() == &g, "dist::gemm grid");
+    lana::detail::require_dims(a.cols() == b.rows() && c.rows() == a.rows() && c.cols() == b.cols(), "dist::gemm");
+    lana::detail::require_dims(a.nb() == b.mb() && c.mb() == a.mb() && c.nb() == b.nb(), "dist::gemm block size");
+    const index_t k = a.cols();
+    static const int prof_id = profile::detail::kernel_id("dist_gemm");
+    const auto prof = dist_scope<T>(prof_id, std::max({c.rows(), c.cols(), k}),
+                                    2.0 * static_cast<double>(c.local().rows()) *
+                                        static_cast<double>(c.local().cols()) * static_cast<double>(k),
+                                    0);
+
+    const MatrixView<T> cl = c.local();
+    const index_t lr = cl.rows();
+    const index_t lc = cl.cols();
+    if (beta != T(1)) {
+        for (index_t j = 0; j < lc; ++j) {
+            for (index_t i = 0; i < lr; ++i) {
+                cl(i, j) = beta == T(0) ? T(0) : beta * cl(i, j);
+            }
+        }
+    }
+    if (alpha == T(0) || k == 0) {
+        return;
+    }
+
+    const index_t kb = a.nb();
+    const index_t nk = (k + kb - 1) / kb;
+    lana::detail::AlignedBuffer<T> abuf[2] = {lana::detail::AlignedBuffer<T>(static_cast<std::size_t>(lr * kb)),
+                                              lana::detail::AlignedBuffer<T>(static_cast<std::size_t>(lr * kb))};
+    lana::detail::AlignedBuffer<T> bbuf[2] = {lana::detail::AlignedBuffer<T>(static_cast<std::size_t>(kb * lc)),
+                                              lana::detail::AlignedBuffer<T>(static_cast<std::size_t>(kb * lc))};
+    MPI_Request req[2][2] = {{MPI_REQUEST_NULL, MPI_REQUEST_NULL}, {MPI_REQUEST_NULL, MPI_REQUEST_NULL}};
+    const auto width = [&](index_t p) { return std::min(kb, k - p * kb); };
+
+    // Packs and starts the broadcasts of panel p into slot s: A's block
+    // column from process column p mod Q, B's block row from process row
+    // p mod P.
+    const auto post = [&](index_t p, int s) {
+        const index_t k0 = p * kb;
+        const index_t w = width(p);
+        const int root_col = a.owner_col(k0);
+        const int root_row = b.owner_row(k0);
+        if (g.pcol() == root_col) {
+            pack(a.local().block(0, a.local_col(k0), lr, w), abuf[s].data());
+        }
+        if (g.prow() == root_row) {
+            pack(b.local().block(b.local_row(k0), 0, w, lc), bbuf[s].data());
+        }
+        check(MPI_Ibcast(abuf[s].data(), count_of(lr * w, "dist::gemm panel"), mpi_type<T>(), root_col, g.row_comm(),
+                         &req[s][0]),
+              "MPI_Ibcast");
+        check(MPI_Ibcast(bbuf[s].data(), count_of(w * lc, "dist::gemm panel"), mpi_type<T>(), root_row, g.col_comm(),
+                         &req[s][1]),
+              "MPI_Ibcast");
+    };
+
+    post(0, 0);
+    for (index_t p = 0; p < nk; ++p) {
+        const int s = static_cast<int>(p % 2);
+        const int next = 1 - s;
+        if (p + 1 < nk) {
+            post(p + 1, next);
+        }
+        check(MPI_Waitall(2, req[s], MPI_STATUSES_IGNORE), "MPI_Waitall");
+        const index_t w = width(p);
+        const MatrixView<const T> ap(abuf[s].data(), lr, w, std::max<index_t>(lr, 1));
+        const MatrixView<const T> bp(bbuf[s].data(), w, lc, std::max<index_t>(w, 1));
+        for (index_t j0 = 0; j0 < lc; j0 += progress_cols) {
+            const index_t jw = std::min(progress_cols, lc - j0);
+            lana::gemm(alpha, ap, bp.block(0, j0, w, jw), T(1), cl.block(0, j0, lr, jw));
+            if (p + 1 < nk) {
+                int done = 0;
+                check(MPI_Testall(2, req[next], &done, MPI_STATUSES_IGNORE), "MPI_Testall");
+            }
+        }
+    }
+}
+
+/// Interchanges global rows r1 and r2 over the given local column ranges
+/// of `a`, within this process column.
+template <typename T>
+void swap_rows(Matrix<T>& a, index_t r1, index_t r2, const MatrixView<T>* parts, int n_parts, std::vector<T>& buf) {
+    if (r1 == r2) {
+        return;
+    }
+    const Grid& g = a.grid();
+    const int o1 = a.owner_row(r1);
+    const int o2 = a.owner_row(r2);
+    if (g.prow() != o1 && g.prow() != o2) {
+        return;
+    }
+    if (o1 == o2) {
+        const index_t l1 = a.local_row(r1);
+        const index_t l2 = a.local_row(r2);
+        for (int q = 0; q < n_parts; ++q) {
+            for (index_t j = 0; j < parts[q].cols(); ++j) {
+                std::swap(parts[q](l1, j), parts[q](l2, j));
+            }
+        }
+        return;
+    }
+    const index_t mine = a.local_row(g.prow() == o1 ? r1 : r2);
+    const int other = g.prow() == o1 ? o2 : o1;
+    index_t n = 0;
+    for (int q = 0; q < n_parts; ++q) {
+        n += parts[q].cols();
+    }
+    if (n == 0) {
+        return;
+    }
+    buf.resize(static_cast<std::size_t>(n));
+    index_t at = 0;
+    for (int q = 0; q < n_parts; ++q) {
+        for (index_t j = 0; j < parts[q].cols(); ++j) {
+            buf[static_cast<std::size_t>(at++)] = parts[q](mine, j);
+        }
+    }
+    check(MPI_Sendrecv_replace(buf.data(), count_of(n, "dist::getrf row"), mpi_type<T>(), other, 0, other, 0,
+                               g.col_comm(), MPI_STATUS_IGNORE),
+          "MPI_Sendrecv_replace");
+    at = 0;
+    for (int q = 0; q < n_parts; ++q) {
+        for (index_t j = 0; j < parts[q].cols(); ++j) {
+            parts[q](mine, j) = buf[static_cast<std::size_t>(at++)];
+        }
+    }
+}
+
+/// Unblocked LU of the panel holding global columns [k0, k0 + kw), on its
+/// process column: one MAXLOC reduction and one row broadcast per column.
+/// Writes global pivots to piv[0, kw); returns 0 or the first zero pivot
+/// as a global k + 1.
+template <typename T>
+index_t factor_panel(Matrix<T>& a, MatrixView<T> pan, index_t k0, index_t kw, std::int32_t* piv,
+                     std::vector<T>& buf) {
+    const Grid& g = a.grid();
+    const index_t lr = pan.rows();
+    std::vector<T> urow(static_cast<std::size_t>(kw));
+    index_t info = 0;
+    for (index_t jj = 0; jj < kw; ++jj) {
+        const index_t j = k0 + jj;
+        const index_t ls = local_extent(j, a.mb(), g.prow(), g.prows());  // first local row >= j
+        struct {
+            double value;
+            int row;
+        } best{-1.0, INT_MAX}, pick{};
+        for (index_t li = ls; li < lr; ++li) {
+            const double v = std::abs(static_cast<double>(pan(li, jj)));
+            if (v > best.value) {
+                best = {v, static_cast<int>(a.global_row(li))};
+            }
+        }
+        check(MPI_Allreduce(&best, &pick, 1, MPI_DOUBLE_INT, MPI_MAXLOC, g.col_comm()), "MPI_Allreduce");
+        const index_t p = pick.value > 0 ? pick.row : j;
+        piv[jj] = static_cast<std::int32_t>(p);
+        swap_rows(a, j, p, &pan, 1, buf);
+
+        const int owner = a.owner_row(j);
+        if (g.prow() == owner) {
+            const index_t lj = a.local_row(j);
+            for (index_t c = 0; c < kw; ++c) {
+                urow[static_cast<std::size_t>(c)] = pan(lj, c);
+            }
+        }
+        check(MPI_Bcast(urow.data(), count_of(kw, "dist::getrf"), mpi_type<T>(), owner, g.col_comm()), "MPI_Bcast");
+        const T d = urow[static_cast<std::size_t>(jj)];
+        if (d == T(0)) {
+            if (info == 0) {
+                info = j + 1;
+            }
+            continue;
+        }
+        const index_t below = local_extent(j + 1, a.mb(), g.prow(), g.prows());
+        const T inv = T(1) / d;
+        for (index_t li = below; li < lr; ++li) {
+            pan(li, jj) *= inv;
+        }
+        for (index_t c = jj + 1; c < kw; ++c) {
+            const T u = urow[static_cast<std::size_t>(c)];
+            for (index_t li = below; li < lr; ++li) {
+                pan(li, c) -= pan(li, jj) * u;
+            }
+        }
+    }
+    return info;
+}
+
+template <typename T>
+index_t getrf_impl(Matrix<T>& a, std::int32_t* ipiv) {
+    const Grid& g = a.grid();
+    lana::detail::require_dims(a.mb() == a.nb(), "dist::getrf block size");
+    lana::detail::require_dims(a.rows() <= INT32_MAX, "dist::getrf rows");
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    const index_t nb = a.nb();
+    const index_t kmax = std::min(m, n);
+    static const int prof_id = profile::detail::kernel_id("dist_getrf");
+    const auto pm = static_cast<double>(m);
+    const auto pn = static_cast<double>(n);
+    const auto pk = static_cast<double>(kmax);
+    const auto prof = dist_scope<T>(prof_id, std::max(m, n), pm * pn * pk - (pm + pn) * pk * pk / 2 + pk * pk * pk / 3,
+                                    0);
+
+    const MatrixView<T> al = a.local();
+    const index_t lr = al.rows();
+    const index_t lc = al.cols();
+    std::vector<T> rowbuf;
+    std::vector<T> lbuf;
+    std::vector<T> ubuf;
+    std::vector<std::int32_t> piv(static_cast<std::size_t>(nb));
+    index_t info = 0;
+
+    for (index_t k0 = 0; k0 < kmax; k0 += nb) {
+        const index_t kw = std::min(nb, kmax - k0);
+        const int pc = a.owner_col(k0);
+        const int pr = a.owner_row(k0);
+        const index_t lr0 = local_extent(k0, nb, g.prow(), g.prows());        // local rows >= k0 start here
+        const index_t lrr = local_extent(k0 + kw, nb, g.prow(), g.prows());   // rows >= k0 + kw
+        const index_t lck = local_extent(k0, nb, g.pcol(), g.pcols());        // panel columns start here
+        const index_t lcr = local_extent(k0 + kw, nb, g.pcol(), g.pcols());   // columns >= k0 + kw
+
+        // Panel on its process column, then its pivots to the rest of each
+        // process row.
+        if (g.pcol() == pc) {
+            const index_t panel_info = factor_panel(a, al.block(0, lck, lr, kw), k0, kw, piv.data(), rowbuf);
+            if (info == 0 && panel_info != 0) {
+                info = panel_info;
+            }
+        }
+        check(MPI_Bcast(piv.data(), count_of(kw, "dist::getrf"), MPI_INT32_T, pc, g.row_comm()), "MPI_Bcast");
+        std::copy(piv.begin(), piv.begin() + kw, ipiv + k0);
+
+        // L panel (rows >= k0) along process rows, while the interchanges
+        // are applied to the other block columns.
+        const index_t lh = lr - lr0;
+        lbuf.resize(static_cast<std::size_t>(std::max<index_t>(lh * kw, 1)));
+        if (g.pcol() == pc) {
+            pack(MatrixView<const T>(al.block(lr0, lck, lh, kw)), lbuf.data());
+        }
+        MPI_Request lreq = MPI_REQUEST_NULL;
+        check(MPI_Ibcast(lbuf.data(), count_of(lh * kw, "dist::getrf panel"), mpi_type<T>(), pc, g.row_comm(), &lreq),
+              "MPI_Ibcast");
+        // Off the panel's process column lck == lcr, so this is every column.
+        const MatrixView<T> parts[2] = {al.block(0, 0, lr, lck), al.block(0, lcr, lr, lc - lcr)};
+        for (index_t jj = 0; jj < kw; ++jj) {
+            swap_rows(a, k0 + jj, static_cast<index_t>(ipiv[k0 + jj]), parts, 2, rowbuf);
+        }
+        check(MPI_Wait(&lreq, MPI_STATUS_IGNORE), "MPI_Wait");
+
+        // U block row: trsm on process row pr, then down the process columns.
+        const index_t uw = lc - lcr;
+        ubuf.resize(static_cast<std::size_t>(std::max<index_t>(kw * uw, 1)));
+        if (g.prow() == pr && uw > 0) {
+            const MatrixView<T> u12 = al.block(lr0, lcr, kw, uw);
+            trsm(Side::Left, Uplo::Lower, Op::NoTrans, Diag::Unit, T(1),
+                 MatrixView<const T>(lbuf.data(), kw, kw, std::max<index_t>(lh, 1)), u12);
+            pack(MatrixView<const T>(u12), ubuf.data());
+        }
+        check(MPI_Bcast(ubuf.data(), count_of(kw * uw, "dist::getrf panel"), mpi_type<T>(), pr, g.col_comm()),
+              "MPI_Bcast");
+
+        // Trailing update of the local rows >= k0 + kw.
+        const index_t th = lr - lrr;
+        if (th > 0 && uw > 0) {
+            lana::gemm(T(-1), MatrixView<const T>(lbuf.data() + (lrr - lr0), th, kw, std::max<index_t>(lh, 1)),
+                 MatrixView<const T>(ubuf.data(), kw, uw, kw), T(1), al.block(lrr, lcr, th, uw));
+        }
+    }
+
+    // Breakdown was only seen on the owning process columns.
+    long long mine = info == 0 ? LLONG_MAX : static_cast<long long>(info);
+    long long first = 0;
+    check(MPI_Allreduce(&mine, &first, 1, MPI_LONG_LONG, MPI_MIN, g.comm()), "MPI_Allreduce");
+    return first == LLONG_MAX ? 0 : static_cast<index_t>(first);
+}
+
+}  // namespace
+}  // namespace detail
+
+Grid::Grid(MPI_Comm comm, int prows, int pcols) : prows_(prows), pcols_(pcols) {
+    int size = 0;
+    detail::check(MPI_Comm_size(comm, &size), "MPI_Comm_size");
+    lana::detail::require_dims(prows > 0 && pcols > 0 && prows * pcols == size, "dist::Grid");
+    detail::check(MPI_Comm_dup(comm, &comm_), "MPI_Comm_dup");
+    detail::check(MPI_Comm_rank(comm_, &rank_), "MPI_Comm_rank");
+    prow_ = rank_ / pcols_;
+    pcol_ = rank_ % pcols_;
+    detail::check(MPI_Comm_split(comm_, prow_, pcol_, &row_comm_), "MPI_Comm_split");
+    detail::check(MPI_Comm_split(comm_, pcol_, prow_, &col_comm_), "MPI_Comm_split");
+}
+
+namespace {
+
+int square_rows(MPI_Comm comm) {
+    int size = 1;
+    detail::check(MPI_Comm_size(comm, &size), "MPI_Comm_size");
+    int p = static_cast<int>(std::sqrt(static_cast<double>(size)));
+    while (p > 1 && size % p != 0) {
+        --p;
+    }
+    return std::max(p, 1);
+}
+
+int comm_size(MPI_Comm comm) {
+    int size = 1;
+    detail::check(MPI_Comm_size(comm, &size), "MPI_Comm_size");
+    return size;
+}
+
+}  // namespace
+
+Grid::Grid(MPI_Comm comm) : Grid(comm, square_rows(comm), comm_size(comm) / square_rows(comm)) {}
+
+Grid::~Grid() {
+    for (MPI_Comm* c : {&col_comm_, &row_comm_, &comm_}) {
+        if (*c != MPI_COMM_NULL) {
+            MPI_Comm_free(c);
+        }
+    }
+}
+
+void scatter(MatrixView<const float> src, int root, Matrix<float>& dst) { detail::scatter_impl(src, root, dst); }
+void scatter(MatrixView<const double> src, int root, Matrix<double>& dst) { detail::scatter_impl(src, root, dst); }
+
+void gather(const Matrix<float>& src, int root, MatrixView<float> dst) { detail::gather_impl(src, root, dst); }
+void gather(const Matrix<double>& src, int root, MatrixView<double> dst) { detail::gather_impl(src, root, dst); }
+
+void gemm(float alpha, const Matrix<float>& a, const Matrix<float>& b, float beta, Matrix<float>& c) {
+    detail::gemm_impl(alpha, a, b, beta, c);
+}
+void gemm(double alpha, const Matrix<double>& a, const Matrix<double>& b, double beta, Matrix<double>& c) {
+    detail::gemm_impl(alpha, a, b, beta, c);
+}
+
+index_t getrf(Matrix<float>& a, std::int32_t* ipiv) { return detail::getrf_impl(a, ipiv); }
+index_t getrf(Matrix<double>& a, std::int32_t* ipiv) { return detail::getrf_impl(a, ipiv); }
+
+}  // namespace lana::dist
@@ -0,0 +1,1031 @@
+// Two-stage symmetric eigensolver with divide and conquer, and the QDWH
+// polar SVD built on it.
+//
+// Stage 1 takes A to a band of width band_width one panel at a time:
+// geqrf factors the band_width columns below the band, and the trailing
+// matrix gets the two-sided update A -= W V^T + V W^T, with W formed from
+// the panel's compact WY form. That is four GEMM calls per panel. Stage 2 is
+// bulge chasing in band storage. Sweep j annihilates column j with a
+// reflector of length band_width; that leaves a bulge one block further
+// down, and the sweep chases the bulge's first column down the band, block
+// by block. The rest of each bulge is cleared by the next sweep. Sweeps
+// overlap when their windows are four blocks apart, so they form a
+// wavefront on a TaskGraph.
+//
+// The tridiagonal problem is split in half by Cuppen's rank-one tearing
+// and recursively solved. A merge deflates small or nearly equal
+// components, then solves the secular equation for each remaining root in
+// parallel. The root's eigenvector is recomputed from the Gu-Eisenstat
+// z vector, which keeps the vectors orthogonal without extra precision.
+// One GEMM then rotates the halves' eigenvectors.
+
+#include "lana/eigen.hpp"
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+
+#include "task_graph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace lana {
+namespace detail {
+namespace {
+
+/// Band width left by stage 1: wide enough for stage 1 to be GEMM-bound,
+/// narrow enough for the O(n^2 * nb) bulge chasing.
+constexpr index_t band_width = 32;
+/// Order up to which stage 1 is skipped and the matrix chased directly.
+constexpr index_t direct_max = 3 * band_width;
+/// Chase steps per stage-2 task.
+constexpr index_t chase_steps = 8;
+/// Tridiagonal order at which divide and conquer hands over to QL.
+constexpr index_t dc_leaf = 32;
+/// Columns of Z per task when applying the stage-2 reflectors.
+constexpr index_t back_cols = 32;
+/// QL iterations allowed per eigenvalue.
+constexpr int ql_max_iter = 60;
+/// QDWH iterations before giving up; six suffice for cond(A) up to 1e16.
+constexpr int qdwh_max_iter = 20;
+
+template <typename T>
+profile::Scope eigen_scope(int id, index_t size, double flops, double elems) {
+    return profile::Scope(id, profile::dtype_of<T>(), size, flops, elems * sizeof(T));
+}
+
+/// 2-norm of x[0, n), scaled against overflow.
+template <typename T>
+T norm2(index_t n, const T* x) {
+    T scale = T(0);
+    for (index_t i = 0; i < n; ++i) {
+        scale = std::max(scale, std::abs(x[i]));
+    }
+    if (scale == T(0)) {
+        return T(0);
+    }
+    T s = T(0);
+    for (index_t i = 0; i < n; ++i) {
+        const T v = x[i] / scale;
+        s += v * v;
+    }
+    return scale * std::sqrt(s);
+}
+
+/// Householder reflector (LAPACK larfg) for x[0, n): on return x[0] is
+/// beta, x[1, n) the tail of v (v[0] = 1) and the result tau, so that
+/// (I - tau * v * v^T) * x = beta * e_0.
+template <typename T>
+T householder(index_t n, T* x) {
+    const T xnorm = norm2(n - 1, x + 1);
+    if (xnorm == T(0)) {
+        return T(0);
+    }
+    const T alpha = x[0];
+    const T beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+    const T scale = T(1) / (alpha - beta);
+    for (index_t i = 1; i < n; ++i) {
+        x[i] *= scale;
+    }
+    x[0] = beta;
+    return (beta - alpha) / beta;
+}
+
+template <typename T>
+T frobenius(MatrixView<const T> a) {
+    T scale = T(0);
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            scale = std::max(scale, std::abs(a(i, j)));
+        }
+    }
+    if (scale == T(0)) {
+        return T(0);
+    }
+    T s = T(0);
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            const T v = a(i, j) / scale;
+            s += v * v;
+        }
+    }
+    return scale * std::sqrt(s);
+}
+
+template <typename T>
+void copy(MatrixView<const T> src, MatrixView<T> dst) {
+    for (index_t j = 0; j < src.cols(); ++j) {
+        for (index_t i = 0; i < src.rows(); ++i) {
+            dst(i, j) = src(i, j);
+        }
+    }
+}
+
+template <typename T>
+void set_identity(MatrixView<T> a) {
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            a(i, j) = i == j ? T(1) : T(0);
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Stage 1: dense to band
+
+/// Reduces the full symmetric n x n matrix `a` to bandwidth `nb`:
+/// afterwards |i - j| <= nb of the lower triangle holds the band and, below
+/// it, panel k's columns hold its reflectors (taus from tau[k]), as geqrf
+/// leaves them for ormqr.
+template <typename T>
+void reduce_to_band(MatrixView<T> a, index_t nb, T* tau) {
+    const index_t n = a.rows();
+    for (index_t k = 0; k + nb < n; k += nb) {
+        const index_t m = n - k - nb;
+        const index_t kk = std::min(m, nb);
+        const MatrixView<T> panel = a.block(k + nb, k, m, nb);
+        geqrf(panel, VectorView<T>(tau + k, kk));
+
+        // Q = I - V * T * V^T, V unit lower trapezoidal.
+        Matrix<T> v(m, kk);
+        for (index_t j = 0; j < kk; ++j) {
+            v(j, j) = T(1);
+            for (index_t i = j + 1; i < m; ++i) {
+                v(i, j) = panel(i, j);
+            }
+        }
+        Matrix<T> g(kk, kk);
+        gemm(T(1), v.t(), v.view(), T(0), g.view());
+        Matrix<T> t(kk, kk);
+        for (index_t j = 0; j < kk; ++j) {
+            t(j, j) = tau[k + j];
+            for (index_t i = 0; i < j; ++i) {
+                T s = T(0);
+                for (index_t l = i; l < j; ++l) {
+                    s += t(i, l) * g(l, j);
+                }
+                t(i, j) = -tau[k + j] * s;
+            }
+        }
+
+        // Q^T * A22 * Q = A22 - W * V^T - V * W^T with X = A22 * V * T and
+        // W = X - V * (T^T * V^T * X) / 2.
+        const MatrixView<T> a22 = a.block(k + nb, k + nb, m, m);
+        Matrix<T> y(m, kk, uninitialized);
+        gemm(T(1), MatrixView<const T>(a22), v.view(), T(0), y.view());
+        Matrix<T> w(m, kk, uninitialized);
+        gemm(T(1), y.view(), t.view(), T(0), w.view());
+        Matrix<T> s(kk, kk, uninitialized);
+        gemm(T(1), v.t(), w.view(), T(0), s.view());
+        Matrix<T> p(kk, kk, uninitialized);
+        gemm(T(1), t.t(), s.view(), T(0), p.view());
+        gemm(T(-0.5), v.view(), p.view(), T(1), w.view());
+        gemm(T(-1), w.view(), v.t(), T(1), a22);
+        gemm(T(-1), v.view(), w.t(), T(1), a22);
+    }
+}
+
+/// Eigenvectors of A from those of its band: z = Q1 * z, panels last to
+/// first.
+template <typename T>
+void apply_band_q(MatrixView<const T> a, index_t nb, const T* tau, MatrixView<T> z) {
+    const index_t n = a.rows();
+    index_t last = 0;
+    while (last + nb < n) {
+        last += nb;
+    }
+    for (index_t k = last - nb; k >= 0; k -= nb) {
+        const index_t m = n - k - nb;
+        const index_t kk = std::min(m, nb);
+        ormqr(Op::NoTrans, a.block(k + nb, k, m, nb), VectorView<const T>(tau + k, kk),
+              z.block(k + nb, 0, m, z.cols()));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Stage 2: band to tridiagonal
+
+/// Symmetric band matrix with both triangles stored, |i - j| <= kd; column
+/// j holds rows j - kd through j + kd contiguously.
+template <typename T>
+struct Band {
+    index_t n;
+    index_t kd;
+    std::vector<T> data;
+
+    Band(index_t order, index_t bandwidth)
+        : n(order), kd(bandwidth), data(static_cast<std::size_t>((2 * bandwidth + 1) * order), T(0)) {}
+
+    T& operator()(index_t i, index_t j) noexcept { return data[static_cast<std::size_t>(kd + i - j + j * (2 * kd + 1))]; }
+    T* column(index_t i, index_t j) noexcept { return &(*this)(i, j); }
+};
+
+/// Stage-2 reflectors: chase step s of sweep j owns v[(offset[j] + s) * nb,
+/// + nb) and tau[offset[j] + s], acting on rows j + 1 + s * nb onwards.
+template <typename T>
+struct Chase {
+    index_t n;
+    index_t nb;
+    std::vector<index_t> offset;  // per sweep, plus the total
+    std::vector<T> v;
+    std::vector<T> tau;
+
+    index_t sweeps() const noexcept { return static_cast<index_t>(offset.size()) - 1; }
+    index_t steps(index_t j) const noexcept { return offset[j + 1] - offset[j]; }
+    index_t first_row(index_t j, index_t s) const noexcept { return j + 1 + s * nb; }
+    index_t length(index_t j, index_t s) const noexcept { return std::min(nb, n - first_row(j, s)); }
+};
+
+/// One chase step: the reflector for rows [r0, r0 + len) of column c,
+/// applied from both sides to the window of rows and columns [lo, hi]
+/// around it, as the symmetric rank-2 update B -= u p^T + p u^T.
+template <typename T>
+void chase_step(Band<T>& band, index_t nb, index_t c, index_t r0, index_t len, T* v, T& tau_out) {
+    const index_t n = band.n;
+    T* x = band.column(r0, c);
+    std::copy(x, x + len, v);
+    const T tau = householder(len, v);
+    tau_out = tau;
+    const T beta = v[0];
+    v[0] = T(1);
+    if (tau == T(0)) {
+        return;
+    }
+    const index_t lo = std::max(index_t(0), r0 - nb);
+    const index_t hi = std::min(n - 1, r0 + len - 1 + nb);
+    const index_t wn = hi - lo + 1;
+    const index_t off = r0 - lo;  // u = v placed at [off, off + len) of the window
+    T p[4 * band_width];
+    std::vector<T> heap;
+    T* pw = p;
+    if (wn > 4 * band_width) {
+        heap.resize(static_cast<std::size_t>(wn));
+        pw = heap.data();
+    }
+    // y = tau * B * u, read down the columns of the rows it needs by symmetry.
+    T uy = T(0);
+    for (index_t i = 0; i < wn; ++i) {
+        const T* col = band.column(r0, lo + i);
+        T s = T(0);
+        for (index_t r = 0; r < len; ++r) {
+            s += col[r] * v[r];
+        }
+        pw[i] = tau * s;
+        if (i >= off && i < off + len) {
+            uy += v[i - off] * pw[i];
+        }
+    }
+    const T half = T(0.5) * tau * uy;
+    for (index_t r = 0; r < len; ++r) {
+        pw[off + r] -= half * v[r];
+    }
+    for (index_t jj = 0; jj < wn; ++jj) {
+        const bool in_r = jj >= off && jj < off + len;
+        if (in_r) {
+            const T uj = v[jj - off];
+            const T pj = pw[jj];
+            T* col = band.column(lo, lo + jj);
+            for (index_t ii = 0; ii < wn; ++ii) {
+                const T ui = ii >= off && ii < off + len ? v[ii - off] : T(0);
+                col[ii] -= ui * pj + pw[ii] * uj;
+            }
+        } else {
+            const T pj = pw[jj];
+            T* col = band.column(r0, lo + jj);
+            for (index_t r = 0; r < len; ++r) {
+                col[r] -= v[r] * pj;
+            }
+        }
+    }
+    band(r0, c) = beta;
+    band(c, r0) = beta;
+    for (index_t r = 1; r < len; ++r) {
+        band(r0 + r, c) = T(0);
+        band(c, r0 + r) = T(0);
+    }
+}
+
+/// Runs steps [s0, s1) of sweep j.
+template <typename T>
+void chase_sweep(Band<T>& band, Chase<T>& ch, index_t j, index_t s0, index_t s1) {
+    for (index_t s = s0; s < s1; ++s) {
+        const index_t r0 = ch.first_row(j, s);
+        const index_t c = s == 0 ? j : r0 - ch.nb;
+        const index_t len = ch.length(j, s);
+        const std::size_t at = static_cast<std::size_t>(ch.offset[j] + s);
+        if (len < 2) {
+            ch.tau[at] = T(0);
+            continue;
+        }
+        chase_step(band, ch.nb, c, r0, len, &ch.v[at * static_cast<std::size_t>(ch.nb)], ch.tau[at]);
+    }
+}
+
+/// Reduces the band to tridiagonal (d, e), recording the reflectors in `ch`.
+/// Task (j, g) runs chase_steps steps of sweep j. A step's window overlaps
+/// those of steps up to three ahead in the previous sweep, so the task
+/// waits for the previous sweep to get four steps past its last one.
+template <typename T>
+void band_to_tridiagonal(Band<T>& band, index_t nb, Chase<T>& ch, T* d, T* e) {
+    const index_t n = band.n;
+    ch.n = n;
+    ch.nb = nb;
+    const index_t sweeps = std::max(index_t(0), n - 2);
+    ch.offset.assign(static_cast<std::size_t>(sweeps + 1), 0);
+    for (index_t j = 0; j < sweeps; ++j) {
+        ch.offset[j + 1] = ch.offset[j] + (n - 1 - j + nb - 1) / nb;
+    }
+    ch.v.assign(static_cast<std::size_t>(ch.offset[sweeps] * nb), T(0));
+    ch.tau.assign(static_cast<std::size_t>(ch.offset[sweeps]), T(0));
+
+    if (sweeps > 1 && parallel_concurrency() > 1) {
+        TaskGraph g;
+        std::vector<TaskGraph::Id> prev;
+        std::vector<TaskGraph::Id> cur;
+        for (index_t j = 0; j < sweeps; ++j) {
+            const index_t steps = ch.steps(j);
+            const index_t tasks = (steps + chase_steps - 1) / chase_steps;
+            cur.assign(static_cast<std::size_t>(tasks), 0);
+            for (index_t t = 0; t < tasks; ++t) {
+                const index_t s0 = t * chase_steps;
+                const index_t s1 = std::min(steps, s0 + chase_steps);
+                cur[static_cast<std::size_t>(t)] =
+                    g.add([&band, &ch, j, s0, s1] { chase_sweep(band, ch, j, s0, s1); }, j);
+                if (t > 0) {
+                    g.depend(cur[static_cast<std::size_t>(t)], cur[static_cast<std::size_t>(t - 1)]);
+                }
+                if (!prev.empty()) {
+                    const index_t need = std::min<index_t>(static_cast<index_t>(prev.size()) - 1,
+                                                           (s1 - 1 + 3) / chase_steps);
+                    g.depend(cur[static_cast<std::size_t>(t)], prev[static_cast<std::size_t>(need)]);
+                }
+            }
+            std::swap(prev, cur);
+        }
+        g.run();
+    } else {
+        for (index_t j = 0; j < sweeps; ++j) {
+            chase_sweep(band, ch, j, 0, ch.steps(j));
+        }
+    }
+    for (index_t i = 0; i < n; ++i) {
+        d[i] = band(i, i);
+        e[i] = i + 1 < n ? band(i + 1, i) : T(0);
+    }
+}
+
+/// z = Q2 * z: the reflectors in reverse order, on column blocks of z in
+/// parallel.
+template <typename T>
+void apply_chase_q(const Chase<T>& ch, MatrixView<T> z) {
+    parallel_for(0, z.cols(), back_cols, [&](index_t lo, index_t hi) {
+        for (index_t j = ch.sweeps() - 1; j >= 0; --j) {
+            for (index_t s = ch.steps(j) - 1; s >= 0; --s) {
+                const std::size_t at = static_cast<std::size_t>(ch.offset[j] + s);
+                const T tau = ch.tau[at];
+                if (tau == T(0)) {
+                    continue;
+                }
+                const T* v = &ch.v[at * static_cast<std::size_t>(ch.nb)];
+                const index_t r0 = ch.first_row(j, s);
+                const index_t len = ch.length(j, s);
+                for (index_t c = lo; c < hi; ++c) {
+                    T* zc = &z(r0, c);
+                    T dot = T(0);
+                    for (index_t r = 0; r < len; ++r) {
+                        dot += v[r] * zc[r];
+                    }
+                    dot *= tau;
+                    for (index_t r = 0; r < len; ++r) {
+                        zc[r] -= dot * v[r];
+                    }
+                }
+            }
+        }
+    });
+}
+
+// ---------------------------------------------------------------------------
+// Tridiagonal eigensolvers
+
+/// Implicit QL on the tridiagonal (d, e), e[i] coupling rows i and i + 1;
+/// e is destroyed. Rotations are accumulated into the columns of z unless
+/// it is empty. Returns 0 or l + 1 if eigenvalue l did not converge.
+template <typename T>
+index_t tridiagonal_ql(index_t n, T* d, T* e, MatrixView<T> z) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    if (n > 0) {
+        e[n - 1] = T(0);
+    }
+    // e is negligible at eps * |T|: tiny eigenvalues in a cluster at zero
+    // never meet a test relative to their own d.
+    T tnorm = T(0);
+    for (index_t i = 0; i < n; ++i) {
+        tnorm = std::max(tnorm, std::abs(d[i]) + 2 * std::abs(e[i]));
+    }
+    const T small = eps * tnorm;
+    for (index_t l = 0; l < n; ++l) {
+        int iter = 0;
+        for (;;) {
+            index_t m = l;
+            for (; m < n - 1; ++m) {
+                if (std::abs(e[m]) <= small) {
+                    break;
+                }
+            }
+            if (m == l) {
+                break;
+            }
+            if (++iter > ql_max_iter) {
+                return l + 1;
+            }
+            T g = (d[l + 1] - d[l]) / (T(2) * e[l]);
+            T r = std::hypot(g, T(1));
+            g = d[m] - d[l] + e[l] / (g + std::copysign(r, g));
+            T s = T(1);
+            T c = T(1);
+            T p = T(0);
+            index_t i = m - 1;
+            bool underflow = false;
+            for (; i >= l; --i) {
+                const T f = s * e[i];
+                const T b = c * e[i];
+                r = std::hypot(f, g);
+                e[i + 1] = r;
+                if (r == T(0)) {
+                    d[i + 1] -= p;
+                    e[m] = T(0);
+                    underflow = true;
+                    break;
+                }
+                s = f / r;
+                c = g / r;
+                g = d[i + 1] - p;
+                r = (d[i] - g) * s + T(2) * c * b;
+                p = s * r;
+                d[i + 1] = g + p;
+                g = c * r - b;
+                if (!z.empty()) {
+                    T* zi = &z(0, i);
+                    T* zi1 = &z(0, i + 1);
+                    for (index_t k = 0; k < z.rows(); ++k) {
+                        const T t = zi1[k];
+                        zi1[k] = s * zi[k] + c * t;
+                        zi[k] = c * zi[k] - s * t;
+                    }
+                }
+            }
+            if (underflow) {
+                continue;
+            }
+            d[l] -= p;
+            e[l] = g;
+            e[m] = T(0);
+        }
+    }
+    return 0;
+}
+
+/// Sorts d ascending, permuting the columns of z alongside.
+template <typename T>
+void sort_eigen(index_t n, T* d, MatrixView<T> z) {
+    for (index_t i = 0; i + 1 < n; ++i) {
+        index_t k = i;
+        for (index_t j = i + 1; j < n; ++j) {
+            if (d[j] < d[k]) {
+                k = j;
+            }
+        }
+        if (k != i) {
+            std::swap(d[i], d[k]);
+            for (index_t r = 0; r < z.rows(); ++r) {
+                std::swap(z(r, i), z(r, k));
+            }
+        }
+    }
+}
+
+/// Root j of the secular equation 1 + rho * sum z_i^2 / (d_i - lambda) = 0,
+/// d ascending: lambda = d[origin] + mu, with mu found relative to the
+/// nearer pole so that every d_i - lambda can be formed without
+/// cancellation. Solves h(mu) = -mu * f(mu), which has no pole at the
+/// origin, by the Illinois variant of regula falsi.
+template <typename T>
+void secular_root(index_t k, const T* d, const T* zsq, T rho, index_t j, index_t& origin, T& mu) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    const auto h = [&](index_t o, T x) {
+        T s = T(1);
+        for (index_t i = 0; i < k; ++i) {
+            if (i != o) {
+                s += rho * zsq[i] / ((d[i] - d[o]) - x);
+            }
+        }
+        return rho * zsq[o] - x * s;
+    };
+    index_t o = j;
+    T a = T(0);
+    T b;
+    if (j + 1 < k) {
+        const T half = (d[j + 1] - d[j]) / 2;
+        // f(midpoint) >= 0 puts the root in the lower half, nearer d[j].
+        if (h(j, half) <= T(0)) {
+            b = half;
+        } else {
+            o = j + 1;
+            a = T(0);
+            b = -half;
+        }
+    } else {
+        T zz = T(0);
+        for (index_t i = 0; i < k; ++i) {
+            zz += zsq[i];
+        }
+        b = rho * zz;
+    }
+    // h(a) > 0 at the origin and h(b) <= 0 at the far end of the bracket.
+    T ha = h(o, a);
+    T hb = h(o, b);
+    int side = 0;
+    for (int it = 0; it < 200; ++it) {
+        if (hb == T(0)) {
+            a = b;
+            break;
+        }
+        T x = (a * hb - b * ha) / (hb - ha);
+        if (!(x > std::min(a, b) && x < std::max(a, b))) {
+            x = (a + b) / 2;
+        }
+        if (x == a || x == b || std::abs(b - a) <= 2 * eps * std::max(std::abs(a), std::abs(b))) {
+            break;
+        }
+        const T hx = h(o, x);
+        if (hx > T(0)) {
+            a = x;
+            ha = hx;
+            if (side == -1) {
+                hb /= 2;
+            }
+            side = -1;
+        } else {
+            b = x;
+            hb = hx;
+            if (side == 1) {
+                ha /= 2;
+            }
+            side = 1;
+        }
+    }
+    origin = o;
+    mu = (a + b) / 2;
+    if (hb == T(0)) {
+        mu = b;
+    }
+}
+
+/// Merges the solved halves [0, m) and [m, n) of a torn tridiagonal: d
+/// holds their eigenvalues, q (n x n) their eigenvectors block-diagonally,
+/// and the tear added rho * w * w^T with w = e_{m-1} + sign * e_m.
+template <typename T>
+void dc_merge(index_t n, index_t m, T* d, MatrixView<T> q, T rho, T sign) {
+    const T eps = std::numeric_limits<T>::epsilon();
+    std::vector<T> z(static_cast<std::size_t>(n));
+    for (index_t i = 0; i < m; ++i) {
+        z[i] = q(m - 1, i);
+    }
+    for (index_t i = m; i < n; ++i) {
+        z[i] = sign * q(m, i);
+    }
+    const T zn = norm2(n, z.data());
+    for (T& v : z) {
+        v /= zn;
+    }
+    rho *= zn * zn;
+
+    std::vector<index_t> order(static_cast<std::size_t>(n));
+    std::iota(order.begin(), order.end(), index_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](index_t x, index_t y) { return d[x] < d[y]; });
+    T dmax = T(0);
+    T zmax = T(0);
+    for (index_t i = 0; i < n; ++i) {
+        dmax = std::max(dmax, std::abs(d[i]));
+        zmax = std::max(zmax, std::abs(z[i]));
+    }
+    const T tol = 8 * eps * std::max(dmax, rho * zmax);
+
+    // Deflation: tiny z components, and pairs of close eigenvalues, where a
+    // rotation moves all of z onto one of them.
+    std::vector<index_t> keep;
+    std::vector<index_t> deflated;
+    for (const index_t i : order) {
+        if (rho * std::abs(z[i]) <= tol) {
+            deflated.push_back(i);
+            continue;
+        }
+        // A rotation changes d[i], so compare it again with the new last one.
+        while (!keep.empty()) {
+            const index_t p = keep.back();
+            const T tau = std::hypot(z[p], z[i]);
+            const T c = z[i] / tau;
+            const T s = -z[p] / tau;
+            if (std::abs((d[i] - d[p]) * c * s) > tol) {
+                break;
+            }
+            for (index_t r = 0; r < n; ++r) {
+                const T qp = q(r, p);
+                const T qi = q(r, i);
+                q(r, p) = c * qp + s * qi;
+                q(r, i) = -s * qp + c * qi;
+            }
+            const T dp = c * c * d[p] + s * s * d[i];
+            d[i] = s * s * d[p] + c * c * d[i];
+            d[p] = dp;
+            z[p] = T(0);
+            z[i] = tau;
+            keep.pop_back();
+            deflated.push_back(p);
+        }
+        keep.push_back(i);
+    }
+
+    const index_t k = static_cast<index_t>(keep.size());
+    std::vector<T> lambda(static_cast<std::size_t>(n));
+    Matrix<T> out(n, n, uninitialized);
+    if (k > 0) {
+        std::vector<T> dk(static_cast<std::size_t>(k));
+        std::vector<T> zk(static_cast<std::size_t>(k));
+        std::vector<T> zsq(static_cast<std::size_t>(k));
+        for (index_t i = 0; i < k; ++i) {
+            dk[i] = d[keep[i]];
+            zk[i] = z[keep[i]];
+            zsq[i] = zk[i] * zk[i];
+        }
+        std::vector<index_t> origin(static_cast<std::size_t>(k));
+        std::vector<T> mu(static_cast<std::size_t>(k));
+        parallel_for(0, k, 16, [&](index_t lo, index_t hi) {
+            for (index_t j = lo; j < hi; ++j) {
+                secular_root(k, dk.data(), zsq.data(), rho, j, origin[j], mu[j]);
+            }
+        });
+        // lambda_j - d_i, formed from the root's own origin.
+        const auto gap = [&](index_t j, index_t i) { return (dk[origin[j]] - dk[i]) + mu[j]; };
+
+        // Gu-Eisenstat: the z for which the computed roots are exact.
+        std::vector<T> zhat(static_cast<std::size_t>(k));
+        parallel_for(0, k, 64, [&](index_t lo, index_t hi) {
+            for (index_t i = lo; i < hi; ++i) {
+                T prod = gap(k - 1, i) / rho;
+                for (index_t j = 0; j < i; ++j) {
+                    prod *= gap(j, i) / (dk[j] - dk[i]);
+                }
+                for (index_t j = i; j + 1 < k; ++j) {
+                    prod *= gap(j, i) / (dk[j + 1] - dk[i]);
+                }
+                zhat[i] = std::copysign(std::sqrt(std::abs(prod)), zk[i]);
+            }
+        });
+        Matrix<T> u(k, k, uninitialized);
+        parallel_for(0, k, 16, [&](index_t lo, index_t hi) {
+            for (index_t j = lo; j < hi; ++j) {
+                for (index_t i = 0; i < k; ++i) {
+                    u(i, j) = zhat[i] / -gap(j, i);
+                }
+                const T nrm = norm2(k, &u(0, j));
+                for (index_t i = 0; i < k; ++i) {
+                    u(i, j) /= nrm;
+                }
+            }
+        });
+        Matrix<T> qk(n, k, uninitialized);
+        for (index_t j = 0; j < k; ++j) {
+            std::copy_n(&q(0, keep[j]), n, &qk(0, j));
+        }
+        gemm(T(1), qk.view(), u.view(), T(0), out.block(0, 0, n, k));
+        for (index_t j = 0; j < k; ++j) {
+            lambda[j] = dk[origin[j]] + mu[j];
+        }
+    }
+    for (index_t j = 0; j < n - k; ++j) {
+        const index_t i = deflated[static_cast<std::size_t>(j)];
+        lambda[k + j] = d[i];
+        std::copy_n(&q(0, i), n, &out(0, k + j));
+    }
+    std::vector<index_t> rank(static_cast<std::size_t>(n));
+    std::iota(rank.begin(), rank.end(), index_t(0));
+    std::stable_sort(rank.begin(), rank.end(), [&](index_t x, index_t y) { return lambda[x] < lambda[y]; });
+    for (index_t j = 0; j < n; ++j) {
+        d[j] = lambda[rank[j]];
+        std::copy_n(&out(0, rank[j]), n, &q(0, j));
+    }
+}
+
+/// Eigenvectors of the tridiagonal (d, e) into q (n x n) by divide and
+/// conquer; d comes back ascending. e is destroyed.
+template <typename T>
+index_t tridiagonal_dc(index_t n, T* d, T* e, MatrixView<T> q) {
+    if (n <= dc_leaf) {
+        set_identity(q);
+        const index_t info = tridiagonal_ql(n, d, e, q);
+        sort_eigen(n, d, q);
+        return info;
+    }
+    const index_t m = n / 2;
+    const T beta = e[m - 1];
+    const T rho = std::abs(beta);
+    const T sign = beta < T(0) ? T(-1) : T(1);
+    d[m - 1] -= rho;
+    d[m] -= rho;
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j < m ? m : 0; i < (j < m ? n : m); ++i) {
+            q(i, j) = T(0);
+        }
+    }
+    if (const index_t info = tridiagonal_dc(m, d, e, q.block(0, 0, m, m)); info != 0) {
+        return info;
+    }
+    if (const index_t info = tridiagonal_dc(n - m, d + m, e + m, q.block(m, m, n - m, n - m)); info != 0) {
+        return info + m;
+    }
+    if (rho == T(0)) {
+        sort_eigen(n, d, q);
+        return 0;
+    }
+    dc_merge(n, m, d, q, rho, sign);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// syevd
+
+template <typename T>
+index_t syevd_impl(EigenJob job, MatrixView<T> a, VectorView<T> w) {
+    const index_t n = a.rows();
+    require_dims(a.cols() == n && w.size() == n, "syevd");
+    static const int prof_id = profile::detail::kernel_id("syevd");
+    const auto pn = static_cast<double>(n);
+    const bool vectors = job == EigenJob::Vectors;
+    const auto prof = eigen_scope<T>(prof_id, n, (vectors ? 9.0 : 4.0 / 3.0) * pn * pn * pn, 2 * pn * pn);
+    if (n == 0) {
+        return 0;
+    }
+    // Both triangles from the lower one.
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < j; ++i) {
+            a(i, j) = a(j, i);
+        }
+    }
+    const index_t nb = n <= direct_max ? std::max(index_t(1), n - 1) : band_width;
+    std::vector<T> tau(static_cast<std::size_t>(n), T(0));
+    if (n > direct_max) {
+        reduce_to_band(a, nb, tau.data());
+    }
+    Band<T> band(n, 2 * nb);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j; i <= std::min(n - 1, j + nb); ++i) {
+            band(i, j) = a(i, j);
+            band(j, i) = a(i, j);
+        }
+    }
+    std::vector<T> d(static_cast<std::size_t>(n));
+    std::vector<T> e(static_cast<std::size_t>(n));
+    Chase<T> ch;
+    band_to_tridiagonal(band, nb, ch, d.data(), e.data());
+    band.data = {};
+
+    index_t info = 0;
+    if (!vectors) {
+        info = tridiagonal_ql(n, d.data(), e.data(), MatrixView<T>());
+        std::sort(d.begin(), d.end());
+    } else {
+        Matrix<T> z(n, n, uninitialized);
+        info = tridiagonal_dc(n, d.data(), e.data(), z.view());
+        apply_chase_q(ch, z.view());
+        if (n > direct_max) {
+            apply_band_q(MatrixView<const T>(a), nb, tau.data(), z.view());
+        }
+        copy(MatrixView<const T>(z.view()), a);
+    }
+    for (index_t i = 0; i < n; ++i) {
+        w[i] = d[i];
+    }
+    return info;
+}
+
+// ---------------------------------------------------------------------------
+// gesdd
+
+/// QDWH weights (a, b, c) for lower bound l on the smallest singular value.
+void qdwh_weights(double l, double& a, double& b, double& c) {
+    const double l2 = l * l;
+    const double gamma = std::cbrt(4 * (1 - l2) / (l2 * l2));
+    const double sg = std::sqrt(1 + gamma);
+    a = sg + 0.5 * std::sqrt(8 - 4 * gamma + 8 * (2 - l2) / (l2 * sg));
+    b = (a - 1) * (a - 1) / 4;
+    c = a + b - 1;
+}
+
+/// Replaces x (m x n, m >= n, |x|_2 <= 1) with its orthonormal polar factor
+/// by the dynamically weighted Halley (QDWH) iteration. Early steps, with
+/// large c, use the QR form; later ones the cheaper Cholesky form.
+template <typename T>
+index_t qdwh(MatrixView<T> x) {
+    const index_t m = x.rows();
+    const index_t n = x.cols();
+    const double eps = std::numeric_limits<T>::epsilon();
+    double l = eps;
+    Matrix<T> prev(m, n, uninitialized);
+    for (int it = 0; it < qdwh_max_iter; ++it) {
+        double a, b, c;
+        qdwh_weights(l, a, b, c);
+        copy(MatrixView<const T>(x), prev.view());
+        bool done = false;
+        if (c <= 100) {
+            // X = b/c X + (a - b/c) X (I + c X^T X)^-1.
+            Matrix<T> zm(n, n, uninitialized);
+            set_identity(zm.view());
+            gemm(T(c), MatrixView<const T>(x).t(), MatrixView<const T>(x), T(1), zm.view());
+            if (potrf(zm.view()) == 0) {
+                Matrix<T> y(prev);
+                trsm(Side::Right, Uplo::Lower, Op::Trans, Diag::NonUnit, T(1), zm.view(), y.view());
+                trsm(Side::Right, Uplo::Lower, Op::NoTrans, Diag::NonUnit, T(1), zm.view(), y.view());
+                for (index_t j = 0; j < n; ++j) {
+                    for (index_t i = 0; i < m; ++i) {
+                        x(i, j) = T(b / c) * x(i, j) + T(a - b / c) * y(i, j);
+                    }
+                }
+                done = true;
+            }
+        }
+        if (!done) {
+            // [sqrt(c) X; I] = [Q1; Q2] R, X = b/c X + (a - b/c)/sqrt(c) Q1 Q2^T.
+            Matrix<T> s(m + n, n);
+            const T sc = T(std::sqrt(c));
+            for (index_t j = 0; j < n; ++j) {
+                for (index_t i = 0; i < m; ++i) {
+                    s(i, j) = sc * x(i, j);
+                }
+                s(m + j, j) = T(1);
+            }
+            Vector<T> tau(n);
+            geqrf(s.view(), tau.view());
+            Matrix<T> q(m + n, n);
+            set_identity(q.block(0, 0, n, n));
+            ormqr(Op::NoTrans, s.view(), tau.view(), q.view());
+            gemm(T((a - b / c) / std::sqrt(c)), q.block(0, 0, m, n), q.block(m, 0, n, n).t(), T(b / c), x);
+        }
+        l = std::min(1.0, l * (a + b * l * l) / (1 + c * l * l));
+        for (index_t j = 0; j < n; ++j) {
+            for (index_t i = 0; i < m; ++i) {
+                prev(i, j) -= x(i, j);
+            }
+        }
+        const double diff = static_cast<double>(frobenius(MatrixView<const T>(prev.view())));
+        if (std::abs(1 - l) <= 10 * eps && diff <= std::cbrt(5 * eps)) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/// Makes the columns of u that are not unit length (those of singular
+/// values at rounding level, which the polar factor does not resolve) an
+/// orthonormal completion of the others.
+template <typename T>
+void complete_columns(MatrixView<T> u) {
+    const index_t m = u.rows();
+    const index_t n = u.cols();
+    const T tol = std::sqrt(std::numeric_limits<T>::epsilon());
+    std::vector<char> good(static_cast<std::size_t>(n));
+    for (index_t j = 0; j < n; ++j) {
+        good[j] = std::abs(norm2(m, &u(0, j)) - T(1)) <= tol;
+    }
+    index_t next_unit = 0;
+    for (index_t j = 0; j < n; ++j) {
+        if (good[j]) {
+            continue;
+        }
+        T* uj = &u(0, j);
+        T nrm = norm2(m, uj);
+        for (int attempt = 0;; ++attempt) {
+            for (int pass = 0; pass < 2; ++pass) {
+                for (index_t p = 0; p < n; ++p) {
+                    if (!good[p]) {
+                        continue;
+                    }
+                    const T* up = &u(0, p);
+                    T dot = T(0);
+                    for (index_t i = 0; i < m; ++i) {
+                        dot += up[i] * uj[i];
+                    }
+                    for (index_t i = 0; i < m; ++i) {
+                        uj[i] -= dot * up[i];
+                    }
+                }
+            }
+            const T left = norm2(m, uj);
+            if (left > T(0.5) * nrm && left > T(0)) {
+                for (index_t i = 0; i < m; ++i) {
+                    uj[i] /= left;
+                }
+                break;
+            }
+            // Too little of the vector was new; start over from a unit vector.
+            std::fill_n(uj, m, T(0));
+            uj[next_unit++ % m] = T(1);
+            nrm = T(1);
+        }
+        good[j] = 1;
+    }
+}
+
+template <typename T>
+index_t gesdd_impl(MatrixView<const T> a, VectorView<T> s, MatrixView<T> u, MatrixView<T> vt) {
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    if (m < n) {
+        return gesdd_impl(a.t(), s, vt.t(), u.t());
+    }
+    const bool vectors = !(u.empty() && vt.empty());
+    require_dims(s.size() == n && (!vectors || (u.rows() == m && u.cols() == n && vt.rows() == n && vt.cols() == n)),
+                 "gesdd");
+    static const int prof_id = profile::detail::kernel_id("gesdd");
+    const auto pm = static_cast<double>(m);
+    const auto pn = static_cast<double>(n);
+    const auto prof = eigen_scope<T>(prof_id, n, 30 * pm * pn * pn + 9 * pn * pn * pn, 4 * pm * pn);
+    if (n == 0) {
+        return 0;
+    }
+    const T alpha = frobenius(a);
+    if (alpha == T(0)) {
+        for (index_t i = 0; i < n; ++i) {
+            s[i] = T(0);
+        }
+        if (vectors) {
+            set_identity(u);
+            set_identity(vt);
+        }
+        return 0;
+    }
+    Matrix<T> up(m, n, uninitialized);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < m; ++i) {
+            up(i, j) = a(i, j) / alpha;
+        }
+    }
+    const index_t info = qdwh(up.view());
+
+    // A = U_p * H with H = U_p^T * A symmetric positive semidefinite.
+    Matrix<T> h(n, n, uninitialized);
+    gemm(T(1), up.t(), a, T(0), h.view());
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j + 1; i < n; ++i) {
+            h(i, j) = (h(i, j) + h(j, i)) / 2;
+        }
+    }
+    Vector<T> w(n, uninitialized);
+    syevd(vectors ? EigenJob::Vectors : EigenJob::ValuesOnly, h.view(), w.view());
+    // Descending |lambda|: H is semidefinite up to rounding, and a slightly
+    // negative eigenvalue flips its left vector instead.
+    std::vector<index_t> order(static_cast<std::size_t>(n));
+    std::iota(order.begin(), order.end(), index_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](index_t x, index_t y) { return std::abs(w[x]) > std::abs(w[y]); });
+    for (index_t i = 0; i < n; ++i) {
+        s[i] = std::abs(w[order[i]]);
+    }
+    if (vectors) {
+        Matrix<T> v(n, n, uninitialized);
+        for (index_t j = 0; j < n; ++j) {
+            const index_t src = order[j];
+            const T sign = w[src] < T(0) ? T(-1) : T(1);
+            for (index_t i = 0; i < n; ++i) {
+                vt(j, i) = h(i, src);
+                v(i, j) = sign * h(i, src);
+            }
+        }
+        Matrix<T> uf(m, n, uninitialized);
+        gemm(T(1), up.view(), v.view(), T(0), uf.view());
+        complete_columns(uf.view());
+        copy(MatrixView<const T>(uf.view()), u);
+    }
+    return info;
+}
+
+}  // namespace
+}  // namespace detail
+
+index_t syevd(EigenJob job, MatrixView<float> a, VectorView<float> w) { return detail::syevd_impl(job, a, w); }
+index_t syevd(EigenJob job, MatrixView<double> a, VectorView<double> w) { return detail::syevd_impl(job, a, w); }
+
+index_t gesdd(MatrixView<const float> a, VectorView<float> s, MatrixView<float> u, MatrixView<float> vt) {
+    return detail::gesdd_impl(a, s, u, vt);
+}
+index_t gesdd(MatrixView<const double> a, VectorView<double> s, MatrixView<double> u, MatrixView<double> vt) {
+    return detail::gesdd_impl(a, s, u, vt);
+}
+
+}  // namespace lana
@@ -0,0 +1,1206 @@
+// Blocked LU, Cholesky and QR.
+//
+// A panel is factored recursively (LU, Cholesky) or in narrow sub-blocks
+// (QR), so even the panel spends most of its time in GEMM. Matrices wider
+// than one tile are then factored as a TaskGraph over nb x nb tiles: a
+// tile update is one gemm_local call, and priorities order tasks by the
+// tile column they write, so the column the next panel needs is finished
+// first and that panel starts while the rest of the update is still
+// running. Tasks never nest parallel regions of their own.
+
+#include "lana/factor.hpp"
+#include "lana/error.hpp"
+#include "lana/gemm.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/tiled.hpp"
+#include "lana/workspace.hpp"
+
+#include "device_internal.hpp"
+#include "factor_internal.hpp"
+#include "gemm_internal.hpp"
+#include "kernels/kernels.hpp"
+#include "task_graph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace lana {
+namespace detail {
+namespace {
+
+std::atomic<index_t> factor_block_override{0};
+
+/// Columns below which the recursive LU and Cholesky panels stop splitting.
+constexpr index_t panel_leaf = 16;
+/// Order below which trsm and syrk work element by element.
+constexpr index_t trsm_leaf = 32;
+/// Width of the sub-blocks a QR panel is factored in.
+constexpr index_t qr_inner = 32;
+/// Right-hand sides per task when trsm splits B between threads.
+constexpr index_t trsm_min_cols = 64;
+
+/// Profile scope of a public routine of order `size` touching `elems`
+/// elements of T.
+template <typename T>
+profile::Scope factor_scope(int id, index_t size, double flops, double elems) {
+    return profile::Scope(id, profile::dtype_of<T>(), size, flops, elems * sizeof(T));
+}
+
+index_t block_for(index_t n) {
+    const index_t nb = factor_block_override.load(std::memory_order_relaxed);
+    if (nb > 0) {
+        return nb;
+    }
+    return n >= 4096 ? 256 : 128;
+}
+
+index_t blocks(index_t n, index_t nb) { return (n + nb - 1) / nb; }
+
+template <typename T>
+void gemm_on(bool local, T alpha, MatrixView<const T> a, MatrixView<const T> b, T beta, MatrixView<T> c) {
+    if (c.empty()) {
+        return;
+    }
+    if (local) {
+        gemm_local(alpha, a, b, beta, c);
+    } else {
+        gemm(alpha, a, b, beta, c);
+    }
+}
+
+/// Row interchanges: row k with row ipiv[k] for k in [k0, k1), in order, or
+/// in reverse order when `forward` is false.
+template <typename T>
+void laswp(MatrixView<T> a, const std::int32_t* ipiv, index_t k0, index_t k1, bool forward = true) {
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t s = 0; s < k1 - k0; ++s) {
+            const index_t k = forward ? k0 + s : k1 - 1 - s;
+            const index_t p = ipiv[k];
+            if (p != k) {
+                std::swap(a(k, j), a(p, j));
+            }
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Triangular solves
+
+/// B = A^-1 * B for A lower or upper triangular, by column-oriented
+/// substitution. A row-major B (a transposed view, as the Cholesky trsm
+/// steps pass) is swept a whole row at a time instead, so the inner loop
+/// stays contiguous.
+template <typename T>
+void substitute(bool lower, bool unit, MatrixView<const T> a, MatrixView<T> b) {
+    const index_t n = a.rows();
+    if (b.row_stride() != 1 && b.col_stride() == 1) {
+        const index_t m = b.cols();
+        for (index_t s = 0; s < n; ++s) {
+            const index_t p = lower ? s : n - 1 - s;
+            T* LANA_RESTRICT bp = &b(p, 0);
+            if (!unit) {
+                const T inv = T(1) / a(p, p);
+                for (index_t c = 0; c < m; ++c) {
+                    bp[c] *= inv;
+                }
+            }
+            const index_t lo = lower ? p + 1 : 0;
+            const index_t hi = lower ? n : p;
+            for (index_t i = lo; i < hi; ++i) {
+                const T x = a(i, p);
+                T* LANA_RESTRICT bi = &b(i, 0);
+                for (index_t c = 0; c < m; ++c) {
+                    bi[c] -= x * bp[c];
+                }
+            }
+        }
+        return;
+    }
+    for (index_t c = 0; c < b.cols(); ++c) {
+        for (index_t s = 0; s < n; ++s) {
+            const index_t p = lower ? s : n - 1 - s;
+            if (!unit) {
+                b(p, c) /= a(p, p);
+            }
+            const T x = b(p, c);
+            if (x == T(0)) {
+                continue;
+            }
+            const index_t lo = lower ? p + 1 : 0;
+            const index_t hi = lower ? n : p;
+            for (index_t i = lo; i < hi; ++i) {
+                b(i, c) -= a(i, p) * x;
+            }
+        }
+    }
+}
+
+/// B = A^-1 * B, split in halves so the off-diagonal work is two large
+/// GEMMs rather than many thin ones.
+template <typename T>
+void trsm_left(bool lower, bool unit, MatrixView<const T> a, MatrixView<T> b, bool local) {
+    const index_t n = a.rows();
+    const index_t m = b.cols();
+    if (n == 0 || m == 0) {
+        return;
+    }
+    if (n <= trsm_leaf) {
+        substitute(lower, unit, a, b);
+        return;
+    }
+    const index_t n1 = n / 2;
+    const index_t n2 = n - n1;
+    const MatrixView<T> b1 = b.block(0, 0, n1, m);
+    const MatrixView<T> b2 = b.block(n1, 0, n2, m);
+    if (lower) {
+        trsm_left(lower, unit, a.block(0, 0, n1, n1), b1, local);
+        gemm_on<T>(local, T(-1), a.block(n1, 0, n2, n1), b1, T(1), b2);
+        trsm_left(lower, unit, a.block(n1, n1, n2, n2), b2, local);
+    } else {
+        trsm_left(lower, unit, a.block(n1, n1, n2, n2), b2, local);
+        gemm_on<T>(local, T(-1), a.block(0, n1, n1, n2), b2, T(1), b1);
+        trsm_left(lower, unit, a.block(0, 0, n1, n1), b1, local);
+    }
+}
+
+/// trsm_left with the columns of B shared out between threads.
+template <typename T>
+void trsm_parallel(bool lower, bool unit, MatrixView<const T> a, MatrixView<T> b) {
+    const index_t m = b.cols();
+    const index_t threads = parallel_concurrency();
+    if (threads == 1 || m < 2 * trsm_min_cols) {
+        // Few right-hand sides: the GEMMs inside go parallel instead.
+        trsm_left(lower, unit, a, b, false);
+        return;
+    }
+    const index_t grain = std::max(trsm_min_cols, (m + threads - 1) / threads);
+    parallel_for(0, m, grain, [&](index_t lo, index_t hi) {
+        trsm_left(lower, unit, a, b.block(0, lo, b.rows(), hi - lo), true);
+    });
+}
+
+template <typename T>
+void trsm_impl(Side side, Uplo uplo, Op op, Diag diag, T alpha, MatrixView<const T> a, MatrixView<T> b) {
+    static const int prof_id = profile::detail::kernel_id("trsm");
+    const auto na = static_cast<double>(a.rows());
+    const auto nb = static_cast<double>(b.rows() * b.cols());
+    const auto prof = factor_scope<T>(prof_id, std::max(b.rows(), b.cols()), na * nb, na * na / 2 + 2 * nb);
+    require_dims(a.rows() == a.cols() && (side == Side::Left ? b.rows() : b.cols()) == a.rows(), "trsm");
+    if (alpha != T(1)) {
+        for (index_t j = 0; j < b.cols(); ++j) {
+            for (index_t i = 0; i < b.rows(); ++i) {
+                b(i, j) = alpha == T(0) ? T(0) : alpha * b(i, j);
+            }
+        }
+        if (alpha == T(0)) {
+            return;
+        }
+    }
+    bool lower = uplo == Uplo::Lower;
+    if (op == Op::Trans) {
+        a = a.t();
+        lower = !lower;
+    }
+    if (side == Side::Right) {
+        // X * op(A) = B  <=>  op(A)^T * X^T = B^T.
+        a = a.t();
+        lower = !lower;
+        b = b.t();
+    }
+    trsm_parallel(lower, diag == Diag::Unit, a, b);
+}
+
+// ---------------------------------------------------------------------------
+// LU
+
+/// Unblocked LU with partial pivoting of a narrow panel; local info.
+template <typename T>
+index_t getf2(MatrixView<T> a, std::int32_t* ipiv) {
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    index_t info = 0;
+    for (index_t k = 0; k < std::min(m, n); ++k) {
+        index_t p = k;
+        T best = std::abs(a(k, k));
+        for (index_t i = k + 1; i < m; ++i) {
+            if (std::abs(a(i, k)) > best) {
+                best = std::abs(a(i, k));
+                p = i;
+            }
+        }
+        ipiv[k] = static_cast<std::int32_t>(p);
+        if (best != T(0)) {
+            if (p != k) {
+                for (index_t j = 0; j < n; ++j) {
+                    std::swap(a(k, j), a(p, j));
+                }
+            }
+            const T inv = T(1) / a(k, k);
+            for (index_t i = k + 1; i < m; ++i) {
+                a(i, k) *= inv;
+            }
+        } else if (info == 0) {
+            info = k + 1;
+        }
+        for (index_t j = k + 1; j < n; ++j) {
+            const T x = a(k, j);
+            if (x != T(0)) {
+                for (index_t i = k + 1; i < m; ++i) {
+                    a(i, j) -= a(i, k) * x;
+                }
+            }
+        }
+    }
+    return info;
+}
+
+/// Recursive LU of a panel (Toledo): factor the left half, update the right
+/// half with trsm and one GEMM, factor what remains of it, then carry its
+/// interchanges back into the left half.
+template <typename T>
+index_t getrf_rec(MatrixView<T> a, std::int32_t* ipiv) {
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    const index_t kmax = std::min(m, n);
+    if (n <= panel_leaf || kmax < 2) {
+        return getf2(a, ipiv);
+    }
+    const index_t n1 = kmax / 2;
+    const index_t n2 = n - n1;
+    index_t info = getrf_rec(a.block(0, 0, m, n1), ipiv);
+    const MatrixView<T> right = a.block(0, n1, m, n2);
+    laswp(right, ipiv, 0, n1);
+    trsm_left<T>(true, true, a.block(0, 0, n1, n1), right.block(0, 0, n1, n2), true);
+    gemm_local(T(-1), a.block(n1, 0, m - n1, n1), right.block(0, 0, n1, n2), T(1), right.block(n1, 0, m - n1, n2));
+    const index_t info2 = getrf_rec(right.block(n1, 0, m - n1, n2), ipiv + n1);
+    for (index_t k = n1; k < kmax; ++k) {
+        ipiv[k] += static_cast<std::int32_t>(n1);
+    }
+    laswp(a.block(0, 0, m, n1), ipiv, n1, kmax);
+    if (info == 0 && info2 != 0) {
+        info = info2 + n1;
+    }
+    return info;
+}
+
+template <typename T>
+index_t getrf_impl(MatrixView<T> a, std::int32_t* ipiv) {
+    static const int prof_id = profile::detail::kernel_id("getrf");
+    const auto pm = static_cast<double>(a.rows());
+    const auto pn = static_cast<double>(a.cols());
+    const double pk = std::min(pm, pn);
+    const auto prof = factor_scope<T>(prof_id, std::max(a.rows(), a.cols()),
+                                      pm * pn * pk - (pm + pn) * pk * pk / 2 + pk * pk * pk / 3, 2 * pm * pn);
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    const index_t kmax = std::min(m, n);
+    if (kmax == 0) {
+        return 0;
+    }
+    if (index_t info = 0; device_getrf(a, ipiv, info)) {
+        return info;
+    }
+    const index_t nb = block_for(kmax);
+    if (kmax <= nb) {
+        return getrf_rec(a, ipiv);
+    }
+
+    const index_t kp = blocks(kmax, nb);
+    const index_t nc = blocks(n, nb);
+    const index_t mr = blocks(m, nb);
+    const auto width = [&](index_t j) { return std::min(nb, n - j * nb); };
+    const auto height = [&](index_t i) { return std::min(nb, m - i * nb); };
+    const auto pivots = [&](index_t k) { return std::min(width(k), m - k * nb); };
+    std::vector<index_t> panel_info(static_cast<std::size_t>(kp), 0);
+
+    TaskGraph g;
+    constexpr TaskGraph::Id none = -1;
+    // upd[(i * nc + j)] is the most recent update of tile (i, j); swp the
+    // interchange + trsm step of the panel row in tile column j.
+    std::vector<TaskGraph::Id> upd(static_cast<std::size_t>(mr * nc), none);
+    std::vector<TaskGraph::Id> panel(static_cast<std::size_t>(kp), none);
+    const auto after_updates = [&](TaskGraph::Id t, index_t k, index_t j) {
+        for (index_t i = k; i < mr; ++i) {
+            if (const TaskGraph::Id u = upd[static_cast<std::size_t>(i * nc + j)]; u != none) {
+                g.depend(t, u);
+            }
+        }
+    };
+    for (index_t k = 0; k < kp; ++k) {
+        const index_t k0 = k * nb;
+        const index_t kw = pivots(k);
+        const TaskGraph::Id p = g.add(
+            [=, &panel_info] {
+                const index_t info = getrf_rec(a.block(k0, k0, m - k0, width(k)), ipiv + k0);
+                for (index_t t = k0; t < k0 + kw; ++t) {
+                    ipiv[t] += static_cast<std::int32_t>(k0);
+                }
+                panel_info[static_cast<std::size_t>(k)] = info == 0 ? 0 : info + k0;
+            },
+            k * kp + k);
+        after_updates(p, k, k);
+        panel[static_cast<std::size_t>(k)] = p;
+        for (index_t j = k + 1; j < nc; ++j) {
+            const index_t j0 = j * nb;
+            const index_t jw = width(j);
+            const TaskGraph::Id s = g.add(
+                [=] {
+                    const MatrixView<T> col = a.block(0, j0, m, jw);
+                    laswp(col, ipiv, k0, k0 + kw);
+                    trsm_left<T>(true, true, a.block(k0, k0, kw, kw), col.block(k0, 0, kw, jw), true);
+                },
+                j * kp + k);
+            g.depend(s, p);
+            after_updates(s, k, j);
+            for (index_t i = k + 1; i < mr; ++i) {
+                const index_t i0 = i * nb;
+                const index_t ih = height(i);
+                const TaskGraph::Id u = g.add(
+                    [=] {
+                        gemm_local(T(-1), a.block(i0, k0, ih, kw), a.block(k0, j0, kw, jw), T(1),
+                                   a.block(i0, j0, ih, jw));
+                    },
+                    j * kp + k);
+                g.depend(u, s);
+                upd[static_cast<std::size_t>(i * nc + j)] = u;
+            }
+        }
+    }
+    g.run();
+
+    // Later panels' interchanges, applied to the tile columns left of them.
+    parallel_for(0, kp - 1, 1, [&](index_t lo, index_t hi) {
+        for (index_t j = lo; j < hi; ++j) {
+            laswp(a.block(0, j * nb, m, width(j)), ipiv, (j + 1) * nb, kmax);
+        }
+    });
+
+    for (const index_t info : panel_info) {
+        if (info != 0) {
+            return info;
+        }
+    }
+    return 0;
+}
+
+template <typename T>
+void getrs_impl(Op op, MatrixView<const T> lu, const std::int32_t* ipiv, MatrixView<T> b) {
+    static const int prof_id = profile::detail::kernel_id("getrs");
+    const auto pn = static_cast<double>(lu.rows());
+    const auto pr = static_cast<double>(b.cols());
+    const auto prof = factor_scope<T>(prof_id, lu.rows(), 2 * pn * pn * pr, pn * pn + 2 * pn * pr);
+    const index_t n = lu.rows();
+    require_dims(lu.cols() == n && b.rows() == n, "getrs");
+    if (op == Op::NoTrans) {
+        laswp(b, ipiv, 0, n);
+        trsm_parallel<T>(true, true, lu, b);
+        trsm_parallel<T>(false, false, lu, b);
+    } else {
+        // A^T = U^T * L^T * P.
+        trsm_parallel<T>(true, false, lu.t(), b);
+        trsm_parallel<T>(false, true, lu.t(), b);
+        laswp(b, ipiv, 0, n, false);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Cholesky
+
+/// C -= A * A^T on the lower triangle of C only.
+template <typename T>
+void syrk_lower(MatrixView<const T> a, MatrixView<T> c, bool local) {
+    const index_t n = c.rows();
+    const index_t k = a.cols();
+    if (n == 0 || k == 0) {
+        return;
+    }
+    if (n <= trsm_leaf) {
+        Workspace& ws = thread_workspace();
+        Workspace::Scope scope(ws);
+        const MatrixView<T> t = ws.matrix<T>(n, n);
+        gemm_local(T(1), a, a.t(), T(0), t);
+        for (index_t j = 0; j < n; ++j) {
+            for (index_t i = j; i < n; ++i) {
+                c(i, j) -= t(i, j);
+            }
+        }
+        return;
+    }
+    const index_t n1 = n / 2;
+    const index_t n2 = n - n1;
+    syrk_lower(a.block(0, 0, n1, k), c.block(0, 0, n1, n1), local);
+    gemm_on<T>(local, T(-1), a.block(n1, 0, n2, k), a.block(0, 0, n1, k).t(), T(1), c.block(n1, 0, n2, n1));
+    syrk_lower(a.block(n1, 0, n2, k), c.block(n1, n1, n2, n2), local);
+}
+
+/// Unblocked left-looking Cholesky; local info.
+template <typename T>
+index_t potf2(MatrixView<T> a) {
+    const index_t n = a.rows();
+    for (index_t j = 0; j < n; ++j) {
+        T d = a(j, j);
+        for (index_t p = 0; p < j; ++p) {
+            d -= a(j, p) * a(j, p);
+        }
+        if (!(d > T(0))) {
+            return j + 1;
+        }
+        d = std::sqrt(d);
+        a(j, j) = d;
+        for (index_t p = 0; p < j; ++p) {
+            const T x = a(j, p);
+            for (index_t i = j + 1; i < n; ++i) {
+                a(i, j) -= a(i, p) * x;
+            }
+        }
+        const T inv = T(1) / d;
+        for (index_t i = j + 1; i < n; ++i) {
+            a(i, j) *= inv;
+        }
+    }
+    return 0;
+}
+
+template <typename T>
+index_t potrf_rec(MatrixView<T> a) {
+    const index_t n = a.rows();
+    if (n <= panel_leaf) {
+        return potf2(a);
+    }
+    const index_t n1 = n / 2;
+    const index_t n2 = n - n1;
+    if (const index_t info = potrf_rec(a.block(0, 0, n1, n1)); info != 0) {
+        return info;
+    }
+    const MatrixView<T> a21 = a.block(n1, 0, n2, n1);
+    trsm_left<T>(true, false, a.block(0, 0, n1, n1), a21.t(), true);
+    syrk_lower<T>(a21, a.block(n1, n1, n2, n2), true);
+    const index_t info = potrf_rec(a.block(n1, n1, n2, n2));
+    return info == 0 ? 0 : info + n1;
+}
+
+/// The Cholesky tile DAG over an n x n matrix of nb x nb tiles (the last
+/// ones shorter); tile(i, j) is the view of tile (i, j), i >= j.
+template <typename T, typename Tile>
+index_t potrf_dag(index_t n, index_t nb, const Tile& tile) {
+    const index_t kt = blocks(n, nb);
+    std::atomic<index_t> info{0};
+
+    TaskGraph g;
+    constexpr TaskGraph::Id none = -1;
+    std::vector<TaskGraph::Id> upd(static_cast<std::size_t>(kt * kt), none);  // last update of tile (i, j)
+    std::vector<TaskGraph::Id> solve(static_cast<std::size_t>(kt), none);      // trsm of tile (i, k)
+    const auto after_update = [&](TaskGraph::Id t, index_t i, index_t j) {
+        if (const TaskGraph::Id u = upd[static_cast<std::size_t>(i * kt + j)]; u != none) {
+            g.depend(t, u);
+        }
+    };
+    for (index_t k = 0; k < kt; ++k) {
+        const TaskGraph::Id d = g.add(
+            [=, &info] {
+                if (info.load(std::memory_order_relaxed) != 0) {
+                    return;
+                }
+                if (const index_t r = potrf_rec(tile(k, k)); r != 0) {
+                    info.store(r + k * nb, std::memory_order_relaxed);
+                }
+            },
+            k * kt + k);
+        after_update(d, k, k);
+        for (index_t i = k + 1; i < kt; ++i) {
+            const TaskGraph::Id s = g.add(
+                [=, &info] {
+                    if (info.load(std::memory_order_relaxed) == 0) {
+                        trsm_left<T>(true, false, tile(k, k), tile(i, k).t(), true);
+                    }
+                },
+                k * kt + k);
+            g.depend(s, d);
+            after_update(s, i, k);
+            solve[static_cast<std::size_t>(i)] = s;
+        }
+        for (index_t j = k + 1; j < kt; ++j) {
+            for (index_t i = j; i < kt; ++i) {
+                const TaskGraph::Id u = g.add(
+                    [=, &info] {
+                        if (info.load(std::memory_order_relaxed) != 0) {
+                            return;
+                        }
+                        if (i == j) {
+                            syrk_lower<T>(tile(i, k), tile(i, i), true);
+                        } else {
+                            gemm_local(T(-1), tile(i, k), tile(j, k).t(), T(1), tile(i, j));
+                        }
+                    },
+                    j * kt + k);
+                g.depend(u, solve[static_cast<std::size_t>(i)]);
+                if (j != i) {
+                    g.depend(u, solve[static_cast<std::size_t>(j)]);
+                }
+                after_update(u, i, j);
+                upd[static_cast<std::size_t>(i * kt + j)] = u;
+            }
+        }
+    }
+    g.run();
+    return info.load();
+}
+
+template <typename T>
+index_t potrf_impl(MatrixView<T> a) {
+    static const int prof_id = profile::detail::kernel_id("potrf");
+    const auto pn = static_cast<double>(a.rows());
+    const auto prof = factor_scope<T>(prof_id, a.rows(), pn * pn * pn / 3, pn * pn);
+    const index_t n = a.rows();
+    require_dims(a.cols() == n, "potrf");
+    if (index_t info = 0; device_potrf(a, info)) {
+        return info;
+    }
+    const index_t nb = block_for(n);
+    if (n <= nb) {
+        return potrf_rec(a);
+    }
+    const auto size = [&](index_t i) { return std::min(nb, n - i * nb); };
+    return potrf_dag<T>(n, nb, [&](index_t i, index_t j) { return a.block(i * nb, j * nb, size(i), size(j)); });
+}
+
+template <typename T>
+index_t potrf_tiled_impl(TiledMatrix<T>& a) {
+    const index_t n = a.rows();
+    require_dims(a.cols() == n, "potrf");
+    if (a.tile_count() <= 1) {
+        return n == 0 ? 0 : potrf_impl(a.tile(0, 0));
+    }
+    static const int prof_id = profile::detail::kernel_id("potrf");
+    const auto pn = static_cast<double>(n);
+    const auto prof = factor_scope<T>(prof_id, n, pn * pn * pn / 3, pn * pn);
+    return potrf_dag<T>(n, a.tile_size(), [&](index_t i, index_t j) { return a.tile(i, j); });
+}
+
+template <typename T>
+void potrs_impl(MatrixView<const T> l, MatrixView<T> b) {
+    static const int prof_id = profile::detail::kernel_id("potrs");
+    const auto pn = static_cast<double>(l.rows());
+    const auto pr = static_cast<double>(b.cols());
+    const auto prof = factor_scope<T>(prof_id, l.rows(), 2 * pn * pn * pr, pn * pn / 2 + 2 * pn * pr);
+    require_dims(l.rows() == l.cols() && b.rows() == l.rows(), "potrs");
+    trsm_parallel<T>(true, false, l, b);
+    trsm_parallel<T>(false, false, l.t(), b);
+}
+
+/// Rank-k Cholesky update in column blocks of nb. Within a block the
+/// rotations are generated column by column on the diagonal block, as in
+/// LINPACK's dchud and dchdd, and stored; the rows below the block only
+/// ever combine L(i, j) with X(i, p), so they take all of the block's
+/// rotations independently, in parallel row chunks.
+template <typename T>
+index_t potrf_update_impl(MatrixView<T> l, MatrixView<T> x, UpdateSign sign) {
+    static const int prof_id = profile::detail::kernel_id("potrf_update");
+    const index_t n = l.rows();
+    const index_t k = x.cols();
+    const auto pn = static_cast<double>(n);
+    const auto pk = static_cast<double>(k);
+    const auto prof = factor_scope<T>(prof_id, n, 4 * pk * pn * pn, pn * pn / 2 + pn * pk);
+    require_dims(l.cols() == n && x.rows() == n, "potrf_update");
+    const T sg = sign == UpdateSign::Plus ? T(1) : T(-1);
+    const index_t nb = std::min(block_for(n), std::max<index_t>(n, 1));
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    T* cs = ws.allocate_n<T>(static_cast<std::size_t>(2 * nb * k));
+
+    // (L(i, j), X(i, p)) <- ((L + sg * s * X) / c, c * X - s * L_new).
+    const auto rotate = [&](index_t j, index_t p, index_t i0, index_t i1) {
+        const T c = cs[2 * ((j % nb) * k + p)];
+        const T s = cs[2 * ((j % nb) * k + p) + 1];
+        T* lj = &l(0, j);
+        T* xp = &x(0, p);
+        for (index_t i = i0; i < i1; ++i) {
+            const T v = (lj[i] + sg * s * xp[i]) / c;
+            xp[i] = c * xp[i] - s * v;
+            lj[i] = v;
+        }
+    };
+    for (index_t j0 = 0; j0 < n; j0 += nb) {
+        const index_t j1 = std::min(n, j0 + nb);
+        for (index_t j = j0; j < j1; ++j) {
+            for (index_t p = 0; p < k; ++p) {
+                const T d = l(j, j);
+                const T w = x(j, p);
+                const T r2 = d * d + sg * w * w;
+                if (!(r2 > T(0)) || d == T(0)) {
+                    return j + 1;
+                }
+                const T r = std::sqrt(r2);
+                cs[2 * ((j % nb) * k + p)] = r / d;
+                cs[2 * ((j % nb) * k + p) + 1] = w / d;
+                l(j, j) = r;
+                x(j, p) = T(0);
+                rotate(j, p, j + 1, j1);
+            }
+        }
+        const index_t grain = std::max<index_t>(64, (index_t(1) << 15) / std::max<index_t>((j1 - j0) * k, 1));
+        parallel_for(j1, n, grain, [&](index_t i0, index_t i1) {
+            for (index_t j = j0; j < j1; ++j) {
+                for (index_t p = 0; p < k; ++p) {
+                    rotate(j, p, i0, i1);
+                }
+            }
+        });
+    }
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// QR
+
+/// Unblocked Householder QR (LAPACK geqr2/larfg).
+template <typename T>
+void geqr2(MatrixView<T> a, VectorView<T> tau) {
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    for (index_t k = 0; k < std::min(m, n); ++k) {
+        T ss = T(0);
+        for (index_t i = k + 1; i < m; ++i) {
+            ss += a(i, k) * a(i, k);
+        }
+        T xnorm;
+        if (std::isfinite(ss) && ss >= std::numeric_limits<T>::min() / std::numeric_limits<T>::epsilon()) {
+            xnorm = std::sqrt(ss);
+        } else {
+            T scale = T(0);
+            for (index_t i = k + 1; i < m; ++i) {
+                scale = std::max(scale, std::abs(a(i, k)));
+            }
+            ss = T(0);
+            if (scale > T(0)) {
+                for (index_t i = k + 1; i < m; ++i) {
+                    const T x = a(i, k) / scale;
+                    ss += x * x;
+                }
+            }
+            xnorm = scale * std::sqrt(ss);
+        }
+        if (xnorm == T(0)) {
+            tau[k] = T(0);
+            continue;
+        }
+        const T alpha = a(k, k);
+        const T beta = -std::copysign(std::hypot(alpha, xnorm), alpha);
+        const T t = (beta - alpha) / beta;
+        const T scal = T(1) / (alpha - beta);
+        for (index_t i = k + 1; i < m; ++i) {
+            a(i, k) *= scal;
+        }
+        a(k, k) = beta;
+        tau[k] = t;
+        for (index_t j = k + 1; j < n; ++j) {
+            T w = a(k, j);
+            for (index_t i = k + 1; i < m; ++i) {
+                w += a(i, k) * a(i, j);
+            }
+            w *= t;
+            a(k, j) -= w;
+            for (index_t i = k + 1; i < m; ++i) {
+                a(i, j) -= a(i, k) * w;
+            }
+        }
+    }
+}
+
+/// Compact WY form of the reflectors in the m x k panel v (geqrf storage):
+/// v1 gets the top k x k of V with its unit diagonal and zeros written out,
+/// and t the upper triangle T with H_0 ... H_{k-1} = I - V * T * V^T
+/// (LAPACK larft). T is built from the Gram matrix V^T * V, which comes out
+/// of two GEMMs, rather than one matrix-vector product per reflector.
+template <typename T>
+void larft(MatrixView<const T> v, VectorView<const T> tau, MatrixView<T> v1, MatrixView<T> t) {
+    const index_t m = v.rows();
+    const index_t k = v.cols();
+    for (index_t j = 0; j < k; ++j) {
+        for (index_t i = 0; i < k; ++i) {
+            v1(i, j) = i == j ? T(1) : i > j ? v(i, j) : T(0);
+        }
+    }
+    gemm_local(T(1), MatrixView<const T>(v1).t(), v1, T(0), t);
+    if (m > k) {
+        const MatrixView<const T> v2 = v.block(k, 0, m - k, k);
+        gemm_local(T(1), v2.t(), v2, T(1), t);
+    }
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    T* w = ws.allocate_n<T>(static_cast<std::size_t>(k));
+    for (index_t i = 0; i < k; ++i) {
+        // T(0:i, i) = -tau_i * T(0:i, 0:i) * (V^T v_i)(0:i), with t(0:i, i)
+        // still holding that Gram column.
+        for (index_t q = 0; q < i; ++q) {
+            w[q] = -tau[i] * t(q, i);
+        }
+        for (index_t p = 0; p < i; ++p) {
+            T s = T(0);
+            for (index_t q = p; q < i; ++q) {
+                s += t(p, q) * w[q];
+            }
+            t(p, i) = s;
+        }
+        t(i, i) = tau[i];
+    }
+    for (index_t j = 0; j < k; ++j) {
+        for (index_t i = j + 1; i < k; ++i) {
+            t(i, j) = T(0);
+        }
+    }
+}
+
+/// C = H^T * C (trans) or H * C for H = I - V * T * V^T, V split into its
+/// explicit top v1 and the panel rows below it, v2 (LAPACK larfb).
+template <typename T>
+void larfb(bool trans, MatrixView<const T> v1, MatrixView<const T> v2, MatrixView<const T> t, MatrixView<T> c,
+           bool local) {
+    const index_t k = v1.cols();
+    const index_t n = c.cols();
+    if (k == 0 || n == 0) {
+        return;
+    }
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    const MatrixView<T> w = ws.matrix<T>(k, n);
+    const MatrixView<T> tw = ws.matrix<T>(k, n);
+    const MatrixView<T> c1 = c.block(0, 0, k, n);
+    const MatrixView<T> c2 = c.block(k, 0, c.rows() - k, n);
+    gemm_on<T>(local, T(1), v1.t(), c1, T(0), w);
+    gemm_on<T>(local, T(1), v2.t(), c2, T(1), w);
+    gemm_on<T>(local, T(1), trans ? t.t() : t, w, T(0), tw);
+    gemm_on<T>(local, T(-1), v1, tw, T(1), c1);
+    gemm_on<T>(local, T(-1), v2, tw, T(1), c2);
+}
+
+/// QR of a panel in qr_inner-wide sub-blocks, each applied to the rest of
+/// the panel as a block reflector.
+template <typename T>
+void geqrf_panel(MatrixView<T> a, VectorView<T> tau) {
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    const index_t kmax = std::min(m, n);
+    for (index_t s = 0; s < kmax; s += qr_inner) {
+        const index_t sw = std::min(qr_inner, kmax - s);
+        const MatrixView<T> sub = a.block(s, s, m - s, sw);
+        geqr2(sub, tau.segment(s, sw));
+        if (s + sw < n) {
+            Workspace& ws = thread_workspace();
+            Workspace::Scope scope(ws);
+            const MatrixView<T> v1 = ws.matrix<T>(sw, sw);
+            const MatrixView<T> t = ws.matrix<T>(sw, sw);
+            larft<T>(sub, tau.segment(s, sw), v1, t);
+            larfb<T>(true, v1, sub.block(sw, 0, m - s - sw, sw), t, a.block(s, s + sw, m - s, n - s - sw), true);
+        }
+    }
+}
+
+template <typename T>
+void geqrf_impl(MatrixView<T> a, VectorView<T> tau) {
+    static const int prof_id = profile::detail::kernel_id("geqrf");
+    const auto pm = static_cast<double>(a.rows());
+    const auto pn = static_cast<double>(a.cols());
+    const double pk = std::min(pm, pn);
+    const auto prof = factor_scope<T>(prof_id, std::max(a.rows(), a.cols()),
+                                      2 * pm * pn * pk - (pm + pn) * pk * pk + 2 * pk * pk * pk / 3, 2 * pm * pn);
+    const index_t m = a.rows();
+    const index_t n = a.cols();
+    const index_t kmax = std::min(m, n);
+    require_dims(tau.size() == kmax, "geqrf");
+    const index_t nb = block_for(kmax);
+    if (kmax <= nb) {
+        geqrf_panel(a, tau);
+        return;
+    }
+
+    const index_t kp = blocks(kmax, nb);
+    const index_t nc = blocks(n, nb);
+    const auto width = [&](index_t j) { return std::min(nb, n - j * nb); };
+    // Per panel: the explicit top of V, then T.
+    std::vector<T> wy(static_cast<std::size_t>(kp * 2 * nb * nb));
+    const auto v1_of = [&, nb](index_t k, index_t kw) {
+        return MatrixView<T>(wy.data() + k * 2 * nb * nb, kw, kw, 1, kw);
+    };
+    const auto t_of = [&, nb](index_t k, index_t kw) {
+        return MatrixView<T>(wy.data() + (k * 2 + 1) * nb * nb, kw, kw, 1, kw);
+    };
+
+    TaskGraph g;
+    constexpr TaskGraph::Id none = -1;
+    std::vector<TaskGraph::Id> upd(static_cast<std::size_t>(nc), none);  // last update of tile column j
+    for (index_t k = 0; k < kp; ++k) {
+        const index_t k0 = k * nb;
+        const index_t kw = std::min(width(k), m - k0);
+        const TaskGraph::Id p = g.add(
+            [=] {
+                const MatrixView<T> panel = a.block(k0, k0, m - k0, width(k));
+                geqrf_panel(panel, tau.segment(k0, kw));
+                if (k + 1 < nc) {
+                    larft<T>(panel.block(0, 0, m - k0, kw), tau.segment(k0, kw), v1_of(k, kw), t_of(k, kw));
+                }
+            },
+            k * kp + k);
+        if (upd[static_cast<std::size_t>(k)] != none) {
+            g.depend(p, upd[static_cast<std::size_t>(k)]);
+        }
+        for (index_t j = k + 1; j < nc; ++j) {
+            const index_t j0 = j * nb;
+            const TaskGraph::Id u = g.add(
+                [=] {
+                    larfb<T>(true, v1_of(k, kw), a.block(k0 + kw, k0, m - k0 - kw, kw), t_of(k, kw),
+                             a.block(k0, j0, m - k0, width(j)), true);
+                },
+                j * kp + k);
+            g.depend(u, p);
+            if (upd[static_cast<std::size_t>(j)] != none) {
+                g.depend(u, upd[static_cast<std::size_t>(j)]);
+            }
+            upd[static_cast<std::size_t>(j)] = u;
+        }
+    }
+    g.run();
+}
+
+template <typename T>
+void ormqr_impl(Op op, MatrixView<const T> qr, VectorView<const T> tau, MatrixView<T> c) {
+    static const int prof_id = profile::detail::kernel_id("ormqr");
+    const auto pk = static_cast<double>(tau.size());
+    const auto pm = static_cast<double>(c.rows());
+    const auto pn = static_cast<double>(c.cols());
+    const auto prof = factor_scope<T>(prof_id, std::max(c.rows(), c.cols()), 4 * pm * pn * pk - 2 * pn * pk * pk,
+                                      pm * pk + 2 * pm * pn);
+    const index_t m = qr.rows();
+    const index_t k = tau.size();
+    require_dims(k == std::min(m, qr.cols()) && c.rows() == m, "ormqr");
+    const bool trans = op == Op::Trans;
+    const index_t nb = block_for(k);
+    const index_t kb = blocks(k, nb);
+    const index_t threads = parallel_concurrency();
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    const MatrixView<T> v1 = ws.matrix<T>(nb, nb);
+    const MatrixView<T> t = ws.matrix<T>(nb, nb);
+    // Q^T = H_{k-1} ... H_0 applies the blocks first to last; Q the reverse.
+    for (index_t s = 0; s < kb; ++s) {
+        const index_t b = trans ? s : kb - 1 - s;
+        const index_t k0 = b * nb;
+        const index_t kw = std::min(nb, k - k0);
+        const MatrixView<const T> v = qr.block(k0, k0, m - k0, kw);
+        const MatrixView<T> bv1 = v1.block(0, 0, kw, kw);
+        const MatrixView<T> bt = t.block(0, 0, kw, kw);
+        larft<T>(v, tau.segment(k0, kw), bv1, bt);
+        const MatrixView<const T> v2 = v.block(kw, 0, m - k0 - kw, kw);
+        const MatrixView<T> cb = c.block(k0, 0, m - k0, c.cols());
+        if (threads == 1 || c.cols() < 2 * trsm_min_cols) {
+            larfb<T>(trans, bv1, v2, bt, cb, false);
+        } else {
+            const index_t grain = std::max(trsm_min_cols, (c.cols() + threads - 1) / threads);
+            parallel_for(0, c.cols(), grain, [&](index_t lo, index_t hi) {
+                larfb<T>(trans, bv1, v2, bt, cb.block(0, lo, cb.rows(), hi - lo), true);
+            });
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Mixed-precision solves (LAPACK dsgesv/dsposv)
+
+/// dst = float(src), columns in parallel; only the lower triangle when
+/// `lower`. False if a finite entry is out of float range.
+bool narrow(MatrixView<const double> src, MatrixView<float> dst, bool lower) {
+    std::atomic<bool> ok{true};
+    const index_t grain = std::max<index_t>(1, (index_t(1) << 15) / std::max<index_t>(src.rows(), 1));
+    parallel_for(0, src.cols(), grain, [&](index_t lo, index_t hi) {
+        constexpr double limit = std::numeric_limits<float>::max();
+        bool in_range = true;
+        for (index_t j = lo; j < hi; ++j) {
+            for (index_t i = lower ? j : 0; i < src.rows(); ++i) {
+                const double v = src(i, j);
+                in_range = in_range && std::fabs(v) <= limit;
+                dst(i, j) = static_cast<float>(v);
+            }
+        }
+        if (!in_range) {
+            ok.store(false, std::memory_order_relaxed);
+        }
+    });
+    return ok.load(std::memory_order_relaxed);
+}
+
+/// Infinity norm of A, or of the symmetric matrix held in its lower
+/// triangle when `sym`.
+double norm_inf(MatrixView<const double> a, bool sym) {
+    std::vector<double> rows(static_cast<std::size_t>(a.rows()), 0.0);
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = sym ? j : 0; i < a.rows(); ++i) {
+            const double v = std::fabs(a(i, j));
+            rows[static_cast<std::size_t>(i)] += v;
+            if (sym && i != j) {
+                rows[static_cast<std::size_t>(j)] += v;
+            }
+        }
+    }
+    return rows.empty() ? 0.0 : *std::max_element(rows.begin(), rows.end());
+}
+
+/// Right-hand sides up to which residual() streams A instead of calling gemm.
+constexpr index_t residual_max_streamed = 8;
+
+/// R = B - A * X, reading only the lower triangle of A when `sym`.
+void residual(bool sym, MatrixView<const double> a, MatrixView<const double> x, MatrixView<const double> b,
+              MatrixView<double> r) {
+    const index_t n = a.rows();
+    const index_t nrhs = b.cols();
+    for (index_t j = 0; j < nrhs; ++j) {
+        for (index_t i = 0; i < n; ++i) {
+            r(i, j) = b(i, j);
+        }
+    }
+    if (nrhs <= residual_max_streamed && a.row_stride() == 1 && r.row_stride() == 1) {
+        // GEMM would repack all of A for a handful of columns; stream it
+        // instead, rows split between threads. The strict upper half of a
+        // symmetric A is applied as dots with its lower columns.
+        const KernelTable<double>& kern = kernels<double>();
+        parallel_for(0, n, 1024, [&](index_t lo, index_t hi) {
+            for (index_t j = 0; j < (sym ? hi : n); ++j) {
+                const index_t i0 = sym ? std::max(lo, j) : lo;
+                for (index_t c = 0; c < nrhs; ++c) {
+                    kern.axpy(hi - i0, -x(j, c), &a(i0, j), &r(i0, c));
+                }
+            }
+            if (sym) {
+                for (index_t j = lo; j < hi && j + 1 < n; ++j) {
+                    for (index_t c = 0; c < nrhs; ++c) {
+                        if (x.row_stride() == 1) {
+                            r(j, c) -= kern.dot(n - j - 1, &a(j + 1, j), &x(j + 1, c));
+                        } else {
+                            for (index_t i = j + 1; i < n; ++i) {
+                                r(j, c) -= a(i, j) * x(i, c);
+                            }
+                        }
+                    }
+                }
+            }
+        });
+        return;
+    }
+    if (!sym) {
+        gemm(-1.0, a, x, 1.0, r);
+        return;
+    }
+    // Tile column by tile column: the symmetrized diagonal tile, then the
+    // tiles below it and, transposed, their mirror images above.
+    const index_t nb = block_for(n);
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    const MatrixView<double> d = ws.matrix<double>(std::min(nb, n), std::min(nb, n));
+    for (index_t j0 = 0; j0 < n; j0 += nb) {
+        const index_t jb = std::min(nb, n - j0);
+        const index_t j1 = j0 + jb;
+        for (index_t jj = 0; jj < jb; ++jj) {
+            for (index_t ii = jj; ii < jb; ++ii) {
+                d(ii, jj) = d(jj, ii) = a(j0 + ii, j0 + jj);
+            }
+        }
+        gemm(-1.0, d.block(0, 0, jb, jb), x.block(j0, 0, jb, nrhs), 1.0, r.block(j0, 0, jb, nrhs));
+        if (j1 < n) {
+            const MatrixView<const double> a21 = a.block(j1, j0, n - j1, jb);
+            gemm(-1.0, a21, x.block(j0, 0, jb, nrhs), 1.0, r.block(j1, 0, n - j1, nrhs));
+            gemm(-1.0, a21.t(), x.block(j1, 0, n - j1, nrhs), 1.0, r.block(j0, 0, jb, nrhs));
+        }
+    }
+}
+
+/// Every column has max|r| <= max|x| * cte.
+bool refined(MatrixView<const double> x, MatrixView<const double> r, double cte) {
+    for (index_t j = 0; j < x.cols(); ++j) {
+        double xmax = 0.0;
+        double rmax = 0.0;
+        for (index_t i = 0; i < x.rows(); ++i) {
+            xmax = std::max(xmax, std::fabs(x(i, j)));
+            rmax = std::max(rmax, std::fabs(r(i, j)));
+        }
+        if (!(rmax <= xmax * cte)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/// Factors A in float, then refines X with double residuals until the
+/// residual is at the level of a backward-stable double solve; otherwise
+/// solves again with a double factorization.
+RefineResult solve_refine(bool sym, MatrixView<const double> a, MatrixView<double> b, const RefineOptions& opts) {
+    static const int gesv_id = profile::detail::kernel_id("gesv_refine");
+    static const int posv_id = profile::detail::kernel_id("posv_refine");
+    const auto pn = static_cast<double>(a.rows());
+    const auto pr = static_cast<double>(b.cols());
+    const auto prof = factor_scope<double>(sym ? posv_id : gesv_id, a.rows(),
+                                           pn * pn * pn * (sym ? 1.0 / 3 : 2.0 / 3) + 2 * pn * pn * pr,
+                                           pn * pn + 2 * pn * pr);
+    const index_t n = a.rows();
+    const index_t nrhs = b.cols();
+    require_dims(a.cols() == n && b.rows() == n, sym ? "posv_refine" : "gesv_refine");
+    RefineResult res;
+    if (n == 0 || nrhs == 0) {
+        return res;
+    }
+    const double cte = norm_inf(a, sym) * (std::numeric_limits<double>::epsilon() / 2) *
+                       std::sqrt(static_cast<double>(n));
+    std::vector<std::int32_t> ipiv(static_cast<std::size_t>(sym ? 0 : n));
+    {
+        Matrix<float> af(n, n, uninitialized);
+        Matrix<float> zf(n, nrhs, uninitialized);
+        Matrix<double> x(n, nrhs, uninitialized);
+        Matrix<double> r(n, nrhs, uninitialized);
+        const auto solve = [&](MatrixView<float> z) {
+            if (sym) {
+                potrs(af.view(), z);
+            } else {
+                getrs(Op::NoTrans, af.view(), ipiv.data(), z);
+            }
+        };
+        bool ok = narrow(a, af.view(), sym) && (sym ? potrf(af.view()) : getrf(af.view(), ipiv.data())) == 0 &&
+                  narrow(b, zf.view(), false);
+        if (ok) {
+            solve(zf.view());
+            for (index_t j = 0; j < nrhs; ++j) {
+                for (index_t i = 0; i < n; ++i) {
+                    x(i, j) = zf(i, j);
+                }
+            }
+        }
+        while (ok) {
+            residual(sym, a, x, b, r);
+            if (refined(x, r, cte)) {
+                for (index_t j = 0; j < nrhs; ++j) {
+                    for (index_t i = 0; i < n; ++i) {
+                        b(i, j) = x(i, j);
+                    }
+                }
+                return res;
+            }
+            if (res.iterations == opts.max_iterations || !narrow(r, zf.view(), false)) {
+                break;
+            }
+            ++res.iterations;
+            solve(zf.view());
+            for (index_t j = 0; j < nrhs; ++j) {
+                for (index_t i = 0; i < n; ++i) {
+                    x(i, j) += zf(i, j);
+                }
+            }
+        }
+    }
+
+    res.mixed = false;
+    Matrix<double> ad(a);
+    if (sym) {
+        res.info = potrf(ad.view());
+        if (res.info == 0) {
+            potrs(ad.view(), b);
+        }
+    } else {
+        ipiv.resize(static_cast<std::size_t>(n));
+        res.info = getrf(ad.view(), ipiv.data());
+        if (res.info == 0) {
+            getrs(Op::NoTrans, ad.view(), ipiv.data(), b);
+        }
+    }
+    return res;
+}
+
+}  // namespace
+
+index_t potrf_on(bool local, MatrixView<float> a) { return local ? potrf_rec(a) : potrf_impl(a); }
+index_t potrf_on(bool local, MatrixView<double> a) { return local ? potrf_rec(a) : potrf_impl(a); }
+
+index_t getrf_on(bool local, MatrixView<float> a, std::int32_t* ipiv) {
+    return local ? getrf_rec(a, ipiv) : getrf_impl(a, ipiv);
+}
+index_t getrf_on(bool local, MatrixView<double> a, std::int32_t* ipiv) {
+    return local ? getrf_rec(a, ipiv) : getrf_impl(a, ipiv);
+}
+
+void trsm_on(bool local, bool lower, bool unit, MatrixView<const float> a, MatrixView<float> b) {
+    local ? trsm_left(lower, unit, a, b, true) : trsm_parallel(lower, unit, a, b);
+}
+void trsm_on(bool local, bool lower, bool unit, MatrixView<const double> a, MatrixView<double> b) {
+    local ? trsm_left(lower, unit, a, b, true) : trsm_parallel(lower, unit, a, b);
+}
+
+void syrk_on(bool local, MatrixView<const float> a, MatrixView<float> c) { syrk_lower(a, c, local); }
+void syrk_on(bool local, MatrixView<const double> a, MatrixView<double> c) { syrk_lower(a, c, local); }
+
+void gemm_on(bool local, float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta,
+             MatrixView<float> c) {
+    gemm_on<float>(local, alpha, a, b, beta, c);
+}
+void gemm_on(bool local, double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+             MatrixView<double> c) {
+    gemm_on<double>(local, alpha, a, b, beta, c);
+}
+
+}  // namespace detail
+
+index_t factor_block_size() noexcept { return detail::factor_block_override.load(std::memory_order_relaxed); }
+void set_factor_block_size(index_t nb) noexcept {
+    detail::factor_block_override.store(std::max<index_t>(nb, 0), std::memory_order_relaxed);
+}
+
+void trsm(Side side, Uplo uplo, Op op, Diag diag, float alpha, MatrixView<const float> a, MatrixView<float> b) {
+    detail::trsm_impl(side, uplo, op, diag, alpha, a, b);
+}
+void trsm(Side side, Uplo uplo, Op op, Diag diag, double alpha, MatrixView<const double> a, MatrixView<double> b) {
+    detail::trsm_impl(side, uplo, op, diag, alpha, a, b);
+}
+
+index_t getrf(MatrixView<float> a, std::int32_t* ipiv) { return detail::getrf_impl(a, ipiv); }
+index_t getrf(MatrixView<double> a, std::int32_t* ipiv) { return detail::getrf_impl(a, ipiv); }
+
+void getrs(Op op, MatrixView<const float> lu, const std::int32_t* ipiv, MatrixView<float> b) {
+    detail::getrs_impl(op, lu, ipiv, b);
+}
+void getrs(Op op, MatrixView<const double> lu, const std::int32_t* ipiv, MatrixView<double> b) {
+    detail::getrs_impl(op, lu, ipiv, b);
+}
+
+index_t potrf(MatrixView<float> a) { return detail::potrf_impl(a); }
+index_t potrf(MatrixView<double> a) { return detail::potrf_impl(a); }
+index_t potrf(TiledMatrix<float>& a) { return detail::potrf_tiled_impl(a); }
+index_t potrf(TiledMatrix<double>& a) { return detail::potrf_tiled_impl(a); }
+
+void potrs(MatrixView<const float> l, MatrixView<float> b) { detail::potrs_impl(l, b); }
+void potrs(MatrixView<const double> l, MatrixView<double> b) { detail::potrs_impl(l, b); }
+
+index_t potrf_update(MatrixView<float> l, MatrixView<float> x, UpdateSign sign) {
+    return detail::potrf_update_impl(l, x, sign);
+}
+index_t potrf_update(MatrixView<double> l, MatrixView<double> x, UpdateSign sign) {
+    return detail::potrf_update_impl(l, x, sign);
+}
+
+void geqrf(MatrixView<float> a, VectorView<float> tau) { detail::geqrf_impl(a, tau); }
+void geqrf(MatrixView<double> a, VectorView<double> tau) { detail::geqrf_impl(a, tau); }
+
+void ormqr(Op op, MatrixView<const float> qr, VectorView<const float> tau, MatrixView<float> c) {
+    detail::ormqr_impl(op, qr, tau, c);
+}
+void ormqr(Op op, MatrixView<const double> qr, VectorView<const double> tau, MatrixView<double> c) {
+    detail::ormqr_impl(op, qr, tau, c);
+}
+
+RefineResult gesv_refine(MatrixView<const double> a, MatrixView<double> b, const RefineOptions& opts) {
+    return detail::solve_refine(false, a, b, opts);
+}
+RefineResult posv_refine(MatrixView<const double> a, MatrixView<double> b, const RefineOptions& opts) {
+    return detail::solve_refine(true, a, b, opts);
+}
+
+}  // namespace lana
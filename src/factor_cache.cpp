@@ -0,0 +1,278 @@
+// FactorCache bookkeeping and content keys.
+//
+// Entries live in a list ordered from most to least recently used, with a
+// hash map from slot to list position, all under one mutex; the factors
+// themselves are type-erased shared_ptrs built by the header templates, so
+// nothing here depends on the factor types. Content keys are a 64-bit
+// hash in the style of xxHash64: four independent multiply-rotate lanes
+// over 8-byte words, so the hash runs at memory bandwidth, folded and
+// finalized with a murmur-style avalanche.
+
+#include "lana/factor_cache.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace lana {
+namespace detail {
+namespace {
+
+constexpr std::uint64_t prime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+
+std::uint64_t rotl(std::uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+std::uint64_t avalanche(std::uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xFF51AFD7ED558CCDull;
+    h ^= h >> 33;
+    h *= 0xC4CEB9FE1A85EC53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+class Hasher {
+public:
+    void bytes(const void* data, std::size_t n) {
+        const auto* p = static_cast<const unsigned char*>(data);
+        std::size_t i = 0;
+        for (; i + 32 <= n; i += 32) {
+            for (int l = 0; l < 4; ++l) {
+                lane_[l] = round(lane_[l], word(p + i + 8 * l));
+            }
+        }
+        for (; i + 8 <= n; i += 8) {
+            lane_[0] = round(lane_[0], word(p + i));
+        }
+        std::uint64_t tail = 0;
+        std::memcpy(&tail, p + i, n - i);
+        lane_[1] = round(lane_[1], tail ^ (n - i));
+        total_ += n;
+    }
+
+    template <typename T>
+    void value(const T& v) {
+        bytes(&v, sizeof(v));
+    }
+
+    std::uint64_t finish() const {
+        std::uint64_t h = total_;
+        for (int l = 0; l < 4; ++l) {
+            h = rotl(h ^ avalanche(lane_[l]), 27) * prime1;
+        }
+        return avalanche(h);
+    }
+
+private:
+    static std::uint64_t word(const unsigned char* p) {
+        std::uint64_t w;
+        std::memcpy(&w, p, sizeof(w));
+        return w;
+    }
+    static std::uint64_t round(std::uint64_t acc, std::uint64_t w) { return rotl(acc + w * prime2, 31) * prime1; }
+
+    std::uint64_t lane_[4] = {prime1 + prime2, prime2, 0, 0 - prime1};
+    std::uint64_t total_ = 0;
+};
+
+template <typename T>
+FactorKey dense_key(MatrixView<const T> a) {
+    Hasher h;
+    h.value(std::uint8_t(sizeof(T)));
+    h.value(a.rows());
+    h.value(a.cols());
+    // Column by column, gathering strided columns first, so that the key
+    // does not depend on the layout.
+    std::vector<T> col(a.row_stride() == 1 ? 0 : static_cast<std::size_t>(a.rows()));
+    for (index_t j = 0; j < a.cols(); ++j) {
+        const T* p = &a(0, j);
+        if (a.row_stride() != 1) {
+            for (index_t i = 0; i < a.rows(); ++i) {
+                col[static_cast<std::size_t>(i)] = a(i, j);
+            }
+            p = col.data();
+        }
+        h.bytes(p, static_cast<std::size_t>(a.rows()) * sizeof(T));
+    }
+    return {h.finish(), 0, true};
+}
+
+template <typename T>
+FactorKey sparse_key(CsrView<T> a) {
+    Hasher h;
+    h.value(std::uint8_t(sizeof(T) | 0x80));
+    h.value(a.rows());
+    h.value(a.cols());
+    const auto nnz = static_cast<std::size_t>(a.nnz());
+    h.bytes(a.row_ptr(), (static_cast<std::size_t>(a.rows()) + 1) * sizeof(index_t));
+    h.bytes(a.col_idx(), nnz * sizeof(sparse_index_t));
+    h.bytes(a.values(), nnz * sizeof(T));
+    return {h.finish(), 0, true};
+}
+
+struct SlotHash {
+    std::size_t operator()(const FactorSlot& s) const noexcept {
+        std::uint64_t h = avalanche(s.key.id ^ rotl(s.key.version, 17) ^ (std::uint64_t(s.key.content) << 63));
+        h ^= (static_cast<std::uint64_t>(s.kind) << 1 | std::uint64_t(s.f64)) * prime1;
+        return static_cast<std::size_t>(avalanche(h));
+    }
+};
+
+struct Entry {
+    FactorSlot slot;
+    std::shared_ptr<void> value;
+    std::size_t bytes;
+};
+
+}  // namespace
+
+class FactorCacheImpl {
+public:
+    explicit FactorCacheImpl(std::size_t budget) : budget_(budget) {}
+
+    std::shared_ptr<void> find(const FactorSlot& slot) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = index_.find(slot);
+        if (it == index_.end()) {
+            ++stats_.misses;
+            return nullptr;
+        }
+        ++stats_.hits;
+        lru_.splice(lru_.begin(), lru_, it->second);
+        return it->second->value;
+    }
+
+    std::shared_ptr<void> insert(const FactorSlot& slot, std::shared_ptr<void> value, std::size_t bytes) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (const auto it = index_.find(slot); it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            return it->second->value;
+        }
+        if (bytes > budget_) {
+            return value;
+        }
+        lru_.push_front(Entry{slot, value, bytes});
+        index_.emplace(slot, lru_.begin());
+        stats_.bytes += bytes;
+        evict();
+        return value;
+    }
+
+    std::shared_ptr<void> take(const FactorSlot& slot, bool& shared) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = index_.find(slot);
+        if (it == index_.end()) {
+            return nullptr;
+        }
+        std::shared_ptr<void> value = std::move(it->second->value);
+        // A copy can only be made from an existing reference, so once ours
+        // is the only one none can appear. Other holders may have released
+        // theirs on any thread, though, and use_count() is a relaxed load:
+        // the fence orders their last accesses to the factor before the
+        // caller starts updating it in place.
+        shared = value.use_count() > 1;
+        if (!shared) {
+            std::atomic_thread_fence(std::memory_order_acquire);
+        }
+        remove(it);
+        return value;
+    }
+
+    void erase(const FactorKey& key) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto e = lru_.begin(); e != lru_.end();) {
+            const auto next = std::next(e);
+            if (e->slot.key == key) {
+                remove(index_.find(e->slot));
+            }
+            e = next;
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        index_.clear();
+        lru_.clear();
+        stats_.bytes = 0;
+    }
+
+    std::size_t budget() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return budget_;
+    }
+
+    void set_budget(std::size_t budget) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        budget_ = budget;
+        evict();
+    }
+
+    void note_update() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.updates;
+    }
+
+    FactorCacheStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FactorCacheStats s = stats_;
+        s.entries = index_.size();
+        return s;
+    }
+
+private:
+    using Index = std::unordered_map<FactorSlot, std::list<Entry>::iterator, SlotHash>;
+
+    void remove(Index::iterator it) {
+        stats_.bytes -= it->second->bytes;
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    void evict() {
+        while (stats_.bytes > budget_ && !lru_.empty()) {
+            remove(index_.find(lru_.back().slot));
+            ++stats_.evictions;
+        }
+    }
+
+    mutable std::mutex mutex_;
+    std::size_t budget_;
+    std::list<Entry> lru_;
+    Index index_;
+    FactorCacheStats stats_;
+};
+
+}  // namespace detail
+
+FactorKey content_key(MatrixView<const float> a) { return detail::dense_key(a); }
+FactorKey content_key(MatrixView<const double> a) { return detail::dense_key(a); }
+FactorKey content_key(CsrView<float> a) { return detail::sparse_key(a); }
+FactorKey content_key(CsrView<double> a) { return detail::sparse_key(a); }
+
+FactorCache::FactorCache(std::size_t budget_bytes)
+    : impl_(std::make_unique<detail::FactorCacheImpl>(budget_bytes)) {}
+FactorCache::~FactorCache() = default;
+
+void FactorCache::erase(const FactorKey& key) { impl_->erase(key); }
+void FactorCache::clear() { impl_->clear(); }
+std::size_t FactorCache::budget() const { return impl_->budget(); }
+void FactorCache::set_budget(std::size_t budget_bytes) { impl_->set_budget(budget_bytes); }
+FactorCacheStats FactorCache::stats() const { return impl_->stats(); }
+
+std::shared_ptr<void> FactorCache::find(const detail::FactorSlot& slot) { return impl_->find(slot); }
+std::shared_ptr<void> FactorCache::insert(const detail::FactorSlot& slot, std::shared_ptr<void> value,
+                                          std::size_t bytes) {
+    return impl_->insert(slot, std::move(value), bytes);
+}
+std::shared_ptr<void> FactorCache::take(const detail::FactorSlot& slot, bool& shared) {
+    return impl_->take(slot, shared);
+}
+void FactorCache::note_update() { impl_->note_update(); }
+
+}  // namespace lana
@@ -0,0 +1,37 @@
+#pragma once
+
+// Dense factorization kernels for other lana translation units. With
+// `local` set they keep all of their work on the calling thread, for
+// callers whose work is already one task of a TaskGraph; otherwise they
+// run on the pool like the public routines.
+
+#include "lana/matrix.hpp"
+
+#include <cstdint>
+
+namespace lana::detail {
+
+/// Lower Cholesky of `a` in place; 0 or the 1-based failing column.
+index_t potrf_on(bool local, MatrixView<float> a);
+index_t potrf_on(bool local, MatrixView<double> a);
+
+/// LU with partial pivoting of `a` in place, zero-based local pivots; 0
+/// or the 1-based first zero pivot.
+index_t getrf_on(bool local, MatrixView<float> a, std::int32_t* ipiv);
+index_t getrf_on(bool local, MatrixView<double> a, std::int32_t* ipiv);
+
+/// B = A^-1 * B for A lower or upper triangular.
+void trsm_on(bool local, bool lower, bool unit, MatrixView<const float> a, MatrixView<float> b);
+void trsm_on(bool local, bool lower, bool unit, MatrixView<const double> a, MatrixView<double> b);
+
+/// C -= A * A^T on the lower triangle of C only.
+void syrk_on(bool local, MatrixView<const float> a, MatrixView<float> c);
+void syrk_on(bool local, MatrixView<const double> a, MatrixView<double> c);
+
+/// C = alpha * A * B + beta * C, via gemm_local or lana::gemm.
+void gemm_on(bool local, float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta,
+             MatrixView<float> c);
+void gemm_on(bool local, double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+             MatrixView<double> c);
+
+}  // namespace lana::detail
@@ -0,0 +1,630 @@
+// Cache-blocked GEMM engine.
+//
+// The loop nest follows the Goto/BLIS structure:
+//
+//   jc: NC-wide column blocks of B and C          (B block lives in L3)
+//     pc: KC-deep slices of the inner dimension   (pack B[pc, jc])
+//       ic: MC-tall row blocks of A and C         (pack A[ic, pc], lives in L2)
+//         jr / ir: NR x MR register tiles         (micro-kernel, B panel in L1)
+//
+// Packing rewrites each operand into contiguous micro-panels, so the
+// micro-kernel streams unit-stride memory whatever the source strides are.
+//
+// The loops are written against an engine that owns the micro-kernel and
+// the matching packing routines. WideningEngine packs into the element type
+// of C, converting 16-bit operands on the way, and runs the table's kernel;
+// Bf16Engine keeps bfloat16 in the packed panels for the AMX or AVX512_BF16
+// kernels, in whichever layout the kernel asks for.
+
+#include "lana/gemm.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/tiled.hpp"
+#include "lana/workspace.hpp"
+
+#include "device_internal.hpp"
+#include "gemm_internal.hpp"
+#include "host.hpp"
+#include "kernels/kernels.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace lana {
+namespace detail {
+namespace {
+
+struct BlockingSlot {
+    explicit BlockingSlot(const GemmBlocking& b)
+        : mc(b.mc), kc(b.kc), nc(b.nc), mr(b.mr), nr(b.nr), n_split(b.n_split) {}
+
+    std::atomic<index_t> mc;
+    std::atomic<index_t> kc;
+    std::atomic<index_t> nc;
+    std::atomic<index_t> mr;
+    std::atomic<index_t> nr;
+    std::atomic<int> n_split;
+};
+
+/// Starts from this host's entry of the tuning file, if there is one.
+template <typename T>
+BlockingSlot& blocking_slot() {
+    static BlockingSlot slot(tuned_blocking(std::is_same_v<T, double>));
+    return slot;
+}
+
+/// The table kernel matching the selected tile, or the table's default.
+template <typename T>
+const GemmKernel<T>& gemm_kernel() {
+    const BlockingSlot& slot = blocking_slot<T>();
+    const index_t mr = slot.mr.load(std::memory_order_relaxed);
+    const index_t nr = slot.nr.load(std::memory_order_relaxed);
+    const KernelTable<T>& table = kernels<T>();
+    for (const GemmKernel<T>& alt : table.gemm_alt) {
+        if (alt.ukernel != nullptr && alt.mr == mr && alt.nr == nr) {
+            return alt;
+        }
+    }
+    return table.gemm;
+}
+
+template <typename T>
+std::vector<GemmTile> gemm_tiles() {
+    const KernelTable<T>& table = kernels<T>();
+    std::vector<GemmTile> tiles{{table.gemm.mr, table.gemm.nr}};
+    for (const GemmKernel<T>& alt : table.gemm_alt) {
+        if (alt.ukernel != nullptr) {
+            tiles.push_back({alt.mr, alt.nr});
+        }
+    }
+    return tiles;
+}
+
+index_t round_down(index_t v, index_t m) { return std::max(m, v / m * m); }
+
+index_t round_up(index_t v, index_t m) { return (v + m - 1) / m * m; }
+
+/// Blocking for an mr x nr kernel over packed elements of `elem` bytes,
+/// kc a multiple of `k_step`; overrides are shared by every kernel whose C
+/// has element type T.
+template <typename T>
+GemmBlocking resolve_blocking(index_t mr, index_t nr, index_t elem, index_t k_step = 1) {
+    const BlockingSlot& slot = blocking_slot<T>();
+    const CacheSizes& cache = host_cache_sizes();
+
+    // Half of each cache level holds the packed operand; the rest is left for
+    // the C tile, the other operand's stream and whatever else is resident.
+    index_t kc = slot.kc.load(std::memory_order_relaxed);
+    if (kc <= 0) {
+        kc = std::clamp<index_t>(static_cast<index_t>(cache.l1d) / 2 / (nr * elem), 64, 1024);
+    }
+    kc = round_down(kc, std::max<index_t>(8, k_step));
+
+    index_t mc = slot.mc.load(std::memory_order_relaxed);
+    if (mc <= 0) {
+        mc = std::clamp<index_t>(static_cast<index_t>(cache.l2) / 2 / (kc * elem), mr, 4096);
+    }
+    mc = round_down(mc, mr);
+
+    index_t nc = slot.nc.load(std::memory_order_relaxed);
+    if (nc <= 0) {
+        nc = std::clamp<index_t>(static_cast<index_t>(cache.l3) / 2 / (kc * elem), nr, 8192);
+    }
+    nc = round_down(nc, nr);
+    return {mc, kc, nc, mr, nr, std::max(1, slot.n_split.load(std::memory_order_relaxed))};
+}
+
+template <typename T>
+void store_blocking(const GemmBlocking& b) {
+    BlockingSlot& slot = blocking_slot<T>();
+    slot.mc.store(std::max<index_t>(b.mc, 0), std::memory_order_relaxed);
+    slot.kc.store(std::max<index_t>(b.kc, 0), std::memory_order_relaxed);
+    slot.nc.store(std::max<index_t>(b.nc, 0), std::memory_order_relaxed);
+    slot.mr.store(std::max<index_t>(b.mr, 0), std::memory_order_relaxed);
+    slot.nr.store(std::max<index_t>(b.nr, 0), std::memory_order_relaxed);
+    slot.n_split.store(std::max(b.n_split, 0), std::memory_order_relaxed);
+}
+
+/// Packs alpha * A[0:mc, 0:kc] into MR-row micro-panels, zero-padding the
+/// last panel so the micro-kernel never needs an edge case on its A side.
+template <typename T, typename S>
+void pack_a(MatrixView<const S> a, T alpha, index_t mr, T* LANA_RESTRICT dst) {
+    const index_t mc = a.rows();
+    const index_t kc = a.cols();
+    for (index_t ir = 0; ir < mc; ir += mr) {
+        const index_t mr_eff = std::min(mr, mc - ir);
+        if (a.row_stride() == 1) {
+            for (index_t p = 0; p < kc; ++p) {
+                const S* src = &a(ir, p);
+                index_t i = 0;
+                for (; i < mr_eff; ++i) {
+                    dst[i] = alpha * static_cast<T>(src[i]);
+                }
+                for (; i < mr; ++i) {
+                    dst[i] = T(0);
+                }
+                dst += mr;
+            }
+        } else {
+            for (index_t i = 0; i < mr_eff; ++i) {
+                const S* src = &a(ir + i, 0);
+                for (index_t p = 0; p < kc; ++p) {
+                    dst[p * mr + i] = alpha * static_cast<T>(src[p * a.col_stride()]);
+                }
+            }
+            for (index_t i = mr_eff; i < mr; ++i) {
+                for (index_t p = 0; p < kc; ++p) {
+                    dst[p * mr + i] = T(0);
+                }
+            }
+            dst += kc * mr;
+        }
+    }
+}
+
+/// Packs B[0:kc, 0:nc] into NR-column micro-panels, zero-padded.
+template <typename T, typename S>
+void pack_b(MatrixView<const S> b, index_t nr, T* LANA_RESTRICT dst) {
+    const index_t kc = b.rows();
+    const index_t nc = b.cols();
+    for (index_t jr = 0; jr < nc; jr += nr) {
+        const index_t nr_eff = std::min(nr, nc - jr);
+        if (b.col_stride() == 1) {
+            for (index_t p = 0; p < kc; ++p) {
+                const S* src = &b(p, jr);
+                index_t j = 0;
+                for (; j < nr_eff; ++j) {
+                    dst[j] = static_cast<T>(src[j]);
+                }
+                for (; j < nr; ++j) {
+                    dst[j] = T(0);
+                }
+                dst += nr;
+            }
+        } else {
+            for (index_t j = 0; j < nr_eff; ++j) {
+                const S* src = &b(0, jr + j);
+                for (index_t p = 0; p < kc; ++p) {
+                    dst[p * nr + j] = static_cast<T>(src[p * b.row_stride()]);
+                }
+            }
+            for (index_t j = nr_eff; j < nr; ++j) {
+                for (index_t p = 0; p < kc; ++p) {
+                    dst[p * nr + j] = T(0);
+                }
+            }
+            dst += kc * nr;
+        }
+    }
+}
+
+/// Packs X[0:rows, 0:kc] into w-row micro-panels in the k-pair layout of
+/// MixedGemmKernel, zero-padded to full panels of depth kp. B is packed
+/// through its transpose, which gives exactly the B panel layout.
+void pack_pairs(MatrixView<const bfloat16> x, index_t w, index_t kp, std::uint16_t* LANA_RESTRICT dst) {
+    const index_t rows = x.rows();
+    const index_t kc = x.cols();
+    for (index_t r0 = 0; r0 < rows; r0 += w) {
+        const index_t w_eff = std::min(w, rows - r0);
+        if (w_eff < w || kp != kc) {
+            std::fill_n(dst, kp * w, std::uint16_t(0));
+        }
+        if (x.row_stride() == 1) {
+            for (index_t p = 0; p < kc; ++p) {
+                const bfloat16* src = &x(r0, p);
+                std::uint16_t* d = dst + (p / 2) * 2 * w + (p & 1);
+                for (index_t i = 0; i < w_eff; ++i) {
+                    d[2 * i] = src[i].bits;
+                }
+            }
+        } else {
+            for (index_t i = 0; i < w_eff; ++i) {
+                const bfloat16* src = &x(r0 + i, 0);
+                std::uint16_t* d = dst + 2 * i;
+                for (index_t p = 0; p < kc; ++p) {
+                    d[(p / 2) * 2 * w + (p & 1)] = src[p * x.col_stride()].bits;
+                }
+            }
+        }
+        dst += kp * w;
+    }
+}
+
+/// Packs B[0:kc, 0:nc] into nr-column panels with each column k-contiguous
+/// (MixedGemmKernel::b_by_column), zero-padded to depth kp.
+void pack_columns(MatrixView<const bfloat16> b, index_t nr, index_t kp, std::uint16_t* LANA_RESTRICT dst) {
+    const index_t kc = b.rows();
+    const index_t nc = b.cols();
+    for (index_t jr = 0; jr < nc; jr += nr) {
+        const index_t nr_eff = std::min(nr, nc - jr);
+        for (index_t j = 0; j < nr_eff; ++j) {
+            std::uint16_t* d = dst + j * kp;
+            if (b.row_stride() == 1) {
+                const bfloat16* src = &b(0, jr + j);
+                for (index_t p = 0; p < kc; ++p) {
+                    d[p] = src[p].bits;
+                }
+            } else {
+                for (index_t p = 0; p < kc; ++p) {
+                    d[p] = b(p, jr + j).bits;
+                }
+            }
+            std::fill(d + kc, d + kp, std::uint16_t(0));
+        }
+        std::fill_n(dst + nr_eff * kp, (nr - nr_eff) * kp, std::uint16_t(0));
+        dst += kp * nr;
+    }
+}
+
+/// C of type T from A and B of type S, packed as T (alpha folded into A)
+/// for the active table's micro-kernel.
+template <typename T, typename S>
+struct WideningEngine {
+    using value_type = T;
+    using packed_type = T;
+
+    GemmKernel<T> kern;
+    T alpha;
+
+    index_t mr() const { return kern.mr; }
+    index_t nr() const { return kern.nr; }
+    index_t k_step() const { return 1; }
+    void pack_a(MatrixView<const S> a, T* dst) const { detail::pack_a(a, alpha, kern.mr, dst); }
+    void pack_b(MatrixView<const S> b, T* dst) const { detail::pack_b(b, kern.nr, dst); }
+    void tile(index_t kc, const T* a, const T* b, T beta, T* c, index_t ldc) const {
+        kern.ukernel(kc, a, b, beta, c, ldc);
+    }
+};
+
+/// bfloat16 A and B kept 16-bit in the panel layouts of a MixedGemmKernel,
+/// which accumulates in float and applies alpha itself.
+struct Bf16Engine {
+    using value_type = float;
+    using packed_type = std::uint16_t;
+
+    MixedGemmKernel kern;
+    float alpha;
+
+    index_t mr() const { return kern.mr; }
+    index_t nr() const { return kern.nr; }
+    index_t k_step() const { return kern.k_step; }
+    void pack_a(MatrixView<const bfloat16> a, std::uint16_t* dst) const {
+        pack_pairs(a, kern.mr, round_up(a.cols(), kern.k_step), dst);
+    }
+    void pack_b(MatrixView<const bfloat16> b, std::uint16_t* dst) const {
+        const index_t kp = round_up(b.rows(), kern.k_step);
+        if (kern.b_by_column) {
+            pack_columns(b, kern.nr, kp, dst);
+        } else {
+            pack_pairs(b.t(), kern.nr, kp, dst);
+        }
+    }
+    void tile(index_t kc, const std::uint16_t* a, const std::uint16_t* b, float beta, float* c, index_t ldc) const {
+        kern.ukernel(kc, a, b, alpha, beta, c, ldc);
+    }
+};
+
+/// Runs the micro-kernel over every register tile of an mc x nc block of C.
+/// Full tiles of a unit-row-stride C are updated in place; edge tiles and
+/// general-stride C go through a small column-major scratch tile.
+/// `kc` is the packed depth (a multiple of the engine's k_step()). A
+/// non-null `ep` is applied to each tile as soon as it is stored; the block
+/// starts at (i0, j0) of the whole C.
+template <typename E, typename T = typename E::value_type, typename P = typename E::packed_type>
+void macro_kernel(const E& eng, index_t kc, const P* ap, const P* bp, T beta, MatrixView<T> c,
+                  const GemmEpilogue<T>* ep = nullptr, index_t i0 = 0, index_t j0 = 0) {
+    const index_t mr = eng.mr();
+    const index_t nr = eng.nr();
+    alignas(default_alignment) T tile[max_tile_elems];
+    for (index_t jr = 0; jr < c.cols(); jr += nr) {
+        const index_t nr_eff = std::min(nr, c.cols() - jr);
+        const P* b_panel = bp + jr * kc;
+        for (index_t ir = 0; ir < c.rows(); ir += mr) {
+            const index_t mr_eff = std::min(mr, c.rows() - ir);
+            const P* a_panel = ap + ir * kc;
+            if (mr_eff == mr && nr_eff == nr && c.row_stride() == 1) {
+                eng.tile(kc, a_panel, b_panel, beta, &c(ir, jr), c.col_stride());
+            } else {
+                eng.tile(kc, a_panel, b_panel, T(0), tile, mr);
+                for (index_t j = 0; j < nr_eff; ++j) {
+                    for (index_t i = 0; i < mr_eff; ++i) {
+                        T& dst = c(ir + i, jr + j);
+                        dst = beta == T(0) ? tile[i + j * mr] : beta * dst + tile[i + j * mr];
+                    }
+                }
+            }
+            if (ep != nullptr) {
+                apply_epilogue(*ep, i0 + ir, j0 + jr, c.block(ir, jr, mr_eff, nr_eff));
+            }
+        }
+    }
+}
+
+template <typename T>
+void scale_matrix(T beta, MatrixView<T> c) {
+    for (index_t j = 0; j < c.cols(); ++j) {
+        for (index_t i = 0; i < c.rows(); ++i) {
+            c(i, j) = beta == T(0) ? T(0) : beta * c(i, j);
+        }
+    }
+}
+
+/// Below this many flops a parallel region costs more than it saves.
+constexpr double parallel_min_flops = 2.0 * 128 * 128 * 128;
+
+template <typename E, typename S, typename T>
+void gemm_serial(const E& eng, const GemmBlocking& blk, MatrixView<const S> a, MatrixView<const S> b, T beta,
+                 MatrixView<T> c, const GemmEpilogue<T>* ep) {
+    using P = typename E::packed_type;
+    const index_t m = c.rows();
+    const index_t n = c.cols();
+    const index_t k = a.cols();
+    const index_t kc_max = round_up(std::min(blk.kc, k), eng.k_step());
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    P* a_pack = ws.allocate_n<P>(static_cast<std::size_t>(round_up(std::min(blk.mc, m), eng.mr()) * kc_max));
+    P* b_pack = ws.allocate_n<P>(static_cast<std::size_t>(kc_max * round_up(std::min(blk.nc, n), eng.nr())));
+
+    for (index_t jc = 0; jc < n; jc += blk.nc) {
+        const index_t nc = std::min(blk.nc, n - jc);
+        for (index_t pc = 0; pc < k; pc += blk.kc) {
+            const index_t kc = std::min(blk.kc, k - pc);
+            const index_t kcp = round_up(kc, eng.k_step());
+            const T beta_eff = pc == 0 ? beta : T(1);
+            const GemmEpilogue<T>* ep_eff = pc + kc == k ? ep : nullptr;
+            eng.pack_b(b.block(pc, jc, kc, nc), b_pack);
+            for (index_t ic = 0; ic < m; ic += blk.mc) {
+                const index_t mc = std::min(blk.mc, m - ic);
+                eng.pack_a(a.block(ic, pc, mc, kc), a_pack);
+                macro_kernel(eng, kcp, a_pack, b_pack, beta_eff, c.block(ic, jc, mc, nc), ep_eff, ic, jc);
+            }
+        }
+    }
+}
+
+/// Parallel driver: the packed B block is shared, packed cooperatively, and
+/// the C block is split into (MC row block) x (slice of NR panels) tasks.
+/// Each task packs its own A block into the running thread's workspace.
+template <typename E, typename S, typename T>
+void gemm_parallel(const E& eng, const GemmBlocking& blk, int threads, MatrixView<const S> a, MatrixView<const S> b,
+                   T beta, MatrixView<T> c, const GemmEpilogue<T>* ep) {
+    using P = typename E::packed_type;
+    const index_t m = c.rows();
+    const index_t n = c.cols();
+    const index_t k = a.cols();
+    const index_t mr = eng.mr();
+    const index_t nr = eng.nr();
+    // Shrink MC when M is short so that every group of n_split threads gets
+    // a row block.
+    const index_t row_ways = std::max(1, threads / std::max(1, blk.n_split));
+    const index_t mc_max = std::min(blk.mc, round_up((m + row_ways - 1) / row_ways, mr));
+    const index_t mblocks = (m + mc_max - 1) / mc_max;
+
+    // While this thread waits for a region it may run tasks of other GEMM
+    // calls; their workspace scopes nest inside this one, so that is safe.
+    const index_t kc_max = round_up(std::min(blk.kc, k), eng.k_step());
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    P* const bp = ws.allocate_n<P>(static_cast<std::size_t>(kc_max * round_up(std::min(blk.nc, n), nr)));
+
+    for (index_t jc = 0; jc < n; jc += blk.nc) {
+        const index_t nc = std::min(blk.nc, n - jc);
+        const index_t npanels = (nc + nr - 1) / nr;
+        const index_t slices = std::clamp<index_t>((threads + mblocks - 1) / mblocks, 1, npanels);
+        const index_t panels_per_slice = (npanels + slices - 1) / slices;
+        for (index_t pc = 0; pc < k; pc += blk.kc) {
+            const index_t kc = std::min(blk.kc, k - pc);
+            const index_t kcp = round_up(kc, eng.k_step());
+            const T beta_eff = pc == 0 ? beta : T(1);
+            const GemmEpilogue<T>* ep_eff = pc + kc == k ? ep : nullptr;
+
+            parallel_for(0, npanels, std::max<index_t>(1, npanels / threads), [&](index_t lo, index_t hi) {
+                const index_t j0 = lo * nr;
+                eng.pack_b(b.block(pc, jc + j0, kc, std::min(nc, hi * nr) - j0), bp + j0 * kcp);
+            });
+
+            parallel_run(mblocks * slices, [&](index_t t) {
+                const index_t ic = (t / slices) * mc_max;
+                const index_t p0 = (t % slices) * panels_per_slice;
+                const index_t p1 = std::min(npanels, p0 + panels_per_slice);
+                if (p0 >= p1) {
+                    return;
+                }
+                const index_t mc = std::min(mc_max, m - ic);
+                const index_t j0 = p0 * nr;
+                Workspace& tws = thread_workspace();
+                Workspace::Scope task_scope(tws);
+                P* const ap = tws.allocate_n<P>(static_cast<std::size_t>(round_up(mc, mr) * kcp));
+                eng.pack_a(a.block(ic, pc, mc, kc), ap);
+                macro_kernel(eng, kcp, ap, bp + j0 * kcp, beta_eff,
+                             c.block(ic, jc + j0, mc, std::min(nc, p1 * nr) - j0), ep_eff, ic, jc + j0);
+            });
+        }
+    }
+}
+
+template <typename E, typename S, typename T>
+void gemm_run(const E& eng, int threads, MatrixView<const S> a, MatrixView<const S> b, T beta, MatrixView<T> c,
+              const GemmEpilogue<T>* ep) {
+    const GemmBlocking blk =
+        resolve_blocking<T>(eng.mr(), eng.nr(), static_cast<index_t>(sizeof(typename E::packed_type)), eng.k_step());
+    if (threads == 1) {
+        gemm_serial(eng, blk, a, b, beta, c, ep);
+    } else {
+        gemm_parallel(eng, blk, threads, a, b, beta, c, ep);
+    }
+}
+
+/// C (type T) from A and B of type S, then `ep` if given. `parallel` false
+/// keeps the whole product on the calling thread.
+template <typename T, typename S>
+void gemm_impl(T alpha, MatrixView<const S> a, MatrixView<const S> b, T beta, MatrixView<T> c, bool parallel,
+               const GemmEpilogue<T>* ep = nullptr) {
+    require_dims(a.rows() == c.rows() && b.cols() == c.cols() && a.cols() == b.rows(), "gemm");
+    const index_t m = c.rows();
+    const index_t n = c.cols();
+    const index_t k = a.cols();
+    if (m == 0 || n == 0) {
+        return;
+    }
+    if (k == 0 || alpha == T(0)) {
+        if (beta != T(1)) {
+            scale_matrix(beta, c);
+        }
+        if (ep != nullptr) {
+            apply_epilogue(*ep, 0, 0, c);
+        }
+        return;
+    }
+    // The micro-kernel writes C columns; for a row-major C compute the
+    // transposed product instead so stores stay unit-stride.
+    if (c.row_stride() != 1 && c.col_stride() == 1) {
+        if (ep != nullptr) {
+            const GemmEpilogue<T> ep_t{ep->col_bias, ep->row_bias, ep->act};
+            gemm_impl(alpha, b.t(), a.t(), beta, c.t(), parallel, &ep_t);
+        } else {
+            gemm_impl(alpha, b.t(), a.t(), beta, c.t(), parallel);
+        }
+        return;
+    }
+
+    const double flops = 2.0 * static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(k);
+    const int threads = parallel && flops >= parallel_min_flops ? parallel_concurrency() : 1;
+    if constexpr (std::is_same_v<S, bfloat16>) {
+        if (const MixedGemmKernel* kern = gemm_bf16_kernel()) {
+            gemm_run(Bf16Engine{*kern, alpha}, threads, a, b, beta, c, ep);
+            return;
+        }
+    }
+    gemm_run(WideningEngine<T, S>{gemm_kernel<T>(), alpha}, threads, a, b, beta, c, ep);
+}
+
+/// Public entry: gemm_impl on the pool, counted by lana::profile.
+template <typename T, typename S>
+void gemm_counted(T alpha, MatrixView<const S> a, MatrixView<const S> b, T beta, MatrixView<T> c,
+                  const GemmEpilogue<T>* ep = nullptr) {
+    static const int prof_id = profile::detail::kernel_id("gemm");
+    const auto m = static_cast<double>(c.rows());
+    const auto n = static_cast<double>(c.cols());
+    const auto k = static_cast<double>(a.cols());
+    const profile::Scope prof(prof_id, profile::dtype_of<S>(), std::max({c.rows(), c.cols(), a.cols()}),
+                              2.0 * m * n * k,
+                              (m * k + k * n) * sizeof(S) + (beta == T(0) ? 1.0 : 2.0) * m * n * sizeof(T));
+    if constexpr (std::is_same_v<T, S>) {
+        if (device_gemm(alpha, a, b, beta, c)) {
+            if (ep != nullptr) {
+                apply_epilogue(*ep, 0, 0, c);
+            }
+            return;
+        }
+    }
+    gemm_impl(alpha, a, b, beta, c, true, ep);
+}
+
+/// Tiled C = alpha * A * B + beta * C. With enough C tiles to go round
+/// each task takes a run of them in storage order, every gemm on its
+/// thread; otherwise the tiles go one at a time with a parallel gemm each.
+template <typename T>
+void gemm_tiled(T alpha, const TiledMatrix<T>& a, const TiledMatrix<T>& b, T beta, TiledMatrix<T>& c) {
+    require_dims(a.rows() == c.rows() && b.cols() == c.cols() && a.cols() == b.rows(), "gemm");
+    require_dims(a.tile_size() == c.tile_size() && b.tile_size() == c.tile_size(), "gemm (tile sizes)");
+    static const int prof_id = profile::detail::kernel_id("gemm");
+    const auto m = static_cast<double>(c.rows());
+    const auto n = static_cast<double>(c.cols());
+    const auto k = static_cast<double>(a.cols());
+    const profile::Scope prof(prof_id, profile::dtype_of<T>(), std::max({c.rows(), c.cols(), a.cols()}),
+                              2.0 * m * n * k, ((m * k + k * n) + (beta == T(0) ? 1.0 : 2.0) * m * n) * sizeof(T));
+    const index_t kt = a.col_tiles();
+    const index_t tiles = c.tile_count();
+    const bool spread = tiles >= 2 * static_cast<index_t>(parallel_concurrency());
+    const auto update = [&](index_t s) {
+        const auto [i, j] = c.tile_at(s);
+        const MatrixView<T> ct = c.tile(i, j);
+        if (kt == 0) {
+            gemm_impl(alpha, MatrixView<const T>(nullptr, ct.rows(), 0, 1, ct.rows()),
+                      MatrixView<const T>(nullptr, 0, ct.cols(), 1, 0), beta, ct, !spread);
+        }
+        for (index_t p = 0; p < kt; ++p) {
+            gemm_impl(alpha, a.tile(i, p), b.tile(p, j), p == 0 ? beta : T(1), ct, !spread);
+        }
+    };
+    if (!spread) {
+        for (index_t s = 0; s < tiles; ++s) {
+            update(s);
+        }
+        return;
+    }
+    parallel_for(0, tiles, 1, [&](index_t lo, index_t hi) {
+        for (index_t s = lo; s < hi; ++s) {
+            update(s);
+        }
+    });
+}
+
+}  // namespace
+
+void gemm_local(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta, MatrixView<float> c) {
+    gemm_impl(alpha, a, b, beta, c, false);
+}
+void gemm_local(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+                MatrixView<double> c) {
+    gemm_impl(alpha, a, b, beta, c, false);
+}
+
+}  // namespace detail
+
+GemmBlocking gemm_blocking_f32() {
+    const detail::GemmKernel<float>& kern = detail::gemm_kernel<float>();
+    return detail::resolve_blocking<float>(kern.mr, kern.nr, sizeof(float));
+}
+GemmBlocking gemm_blocking_f64() {
+    const detail::GemmKernel<double>& kern = detail::gemm_kernel<double>();
+    return detail::resolve_blocking<double>(kern.mr, kern.nr, sizeof(double));
+}
+void set_gemm_blocking_f32(const GemmBlocking& b) { detail::store_blocking<float>(b); }
+void set_gemm_blocking_f64(const GemmBlocking& b) { detail::store_blocking<double>(b); }
+
+std::vector<GemmTile> gemm_tiles_f32() { return detail::gemm_tiles<float>(); }
+std::vector<GemmTile> gemm_tiles_f64() { return detail::gemm_tiles<double>(); }
+
+void gemm(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta, MatrixView<float> c) {
+    detail::gemm_counted(alpha, a, b, beta, c);
+}
+
+void gemm(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+          MatrixView<double> c) {
+    detail::gemm_counted(alpha, a, b, beta, c);
+}
+
+void gemm(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta, MatrixView<float> c,
+          const GemmEpilogue<float>& epilogue) {
+    detail::gemm_counted(alpha, a, b, beta, c, &epilogue);
+}
+
+void gemm(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta, MatrixView<double> c,
+          const GemmEpilogue<double>& epilogue) {
+    detail::gemm_counted(alpha, a, b, beta, c, &epilogue);
+}
+
+void gemm(float alpha, const TiledMatrix<float>& a, const TiledMatrix<float>& b, float beta, TiledMatrix<float>& c) {
+    detail::gemm_tiled(alpha, a, b, beta, c);
+}
+
+void gemm(double alpha, const TiledMatrix<double>& a, const TiledMatrix<double>& b, double beta,
+          TiledMatrix<double>& c) {
+    detail::gemm_tiled(alpha, a, b, beta, c);
+}
+
+void gemm(float alpha, MatrixView<const bfloat16> a, MatrixView<const bfloat16> b, float beta,
+          MatrixView<float> c) {
+    detail::gemm_counted(alpha, a, b, beta, c);
+}
+
+void gemm(float alpha, MatrixView<const half> a, MatrixView<const half> b, float beta, MatrixView<float> c) {
+    detail::gemm_counted(alpha, a, b, beta, c);
+}
+
+}  // namespace lana
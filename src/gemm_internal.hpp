@@ -0,0 +1,75 @@
+#pragma once
+
+// Entry points into the GEMM engine for other lana translation units.
+
+#include "lana/gemm.hpp"
+#include "lana/matrix.hpp"
+
+#include <cmath>
+#include <type_traits>
+
+namespace lana::detail {
+
+/// lana::gemm kept on the calling thread, for callers whose work is
+/// already one task among many running in parallel.
+void gemm_local(float alpha, MatrixView<const float> a, MatrixView<const float> b, float beta, MatrixView<float> c);
+void gemm_local(double alpha, MatrixView<const double> a, MatrixView<const double> b, double beta,
+                MatrixView<double> c);
+
+template <Activation A, typename T>
+LANA_ALWAYS_INLINE T activate(T x) noexcept {
+    if constexpr (A == Activation::Relu) {
+        return x > T(0) ? x : T(0);
+    } else if constexpr (A == Activation::Sigmoid) {
+        return T(1) / (T(1) + std::exp(-x));
+    } else if constexpr (A == Activation::Tanh) {
+        return std::tanh(x);
+    } else if constexpr (A == Activation::Gelu) {
+        return T(0.5) * x * (T(1) + std::tanh(T(0.7978845608028654) * (x + T(0.044715) * x * x * x)));
+    } else {
+        return x;
+    }
+}
+
+/// Calls f(std::integral_constant<Activation, act>{}), so loops over
+/// activate<A>() are compiled once per activation.
+template <typename F>
+decltype(auto) with_activation(Activation act, F&& f) {
+    switch (act) {
+    case Activation::Relu:
+        return f(std::integral_constant<Activation, Activation::Relu>{});
+    case Activation::Sigmoid:
+        return f(std::integral_constant<Activation, Activation::Sigmoid>{});
+    case Activation::Tanh:
+        return f(std::integral_constant<Activation, Activation::Tanh>{});
+    case Activation::Gelu:
+        return f(std::integral_constant<Activation, Activation::Gelu>{});
+    case Activation::None:
+        break;
+    }
+    return f(std::integral_constant<Activation, Activation::None>{});
+}
+
+/// Applies `ep` to the rows x cols block of C at (i0, j0): the biases are
+/// indexed from there.
+template <typename T>
+void apply_epilogue(const GemmEpilogue<T>& ep, index_t i0, index_t j0, MatrixView<T> c) {
+    with_activation(ep.act, [&](auto act) {
+        for (index_t j = 0; j < c.cols(); ++j) {
+            const T cb = ep.col_bias != nullptr ? ep.col_bias[j0 + j] : T(0);
+            for (index_t i = 0; i < c.rows(); ++i) {
+                T v = c(i, j) + cb;
+                if (ep.row_bias != nullptr) {
+                    v += ep.row_bias[i0 + i];
+                }
+                c(i, j) = activate<decltype(act)::value>(v);
+            }
+        }
+    });
+}
+
+/// This host's entry in the tuning file for float (or double) GEMM; all
+/// zero if there is none. Read once, on the first call.
+GemmBlocking tuned_blocking(bool f64);
+
+}  // namespace lana::detail
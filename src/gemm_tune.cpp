@@ -0,0 +1,187 @@
+// Per-machine GEMM tuning file.
+//
+//   # lana gemm tuning v1
+//   [Intel(R) Xeon(R) Platinum 8480+;avx512]
+//   f32 mc=384 kc=384 nc=4080 mr=32 nr=12 n_split=1
+//   f64 mc=192 kc=384 nc=2040 mr=16 nr=12 n_split=1
+//
+// One section per gemm_tuning_host(). Loading is lenient: a missing file,
+// an unknown key or a malformed line only means fewer settings are taken.
+
+#include "lana/cpu.hpp"
+#include "lana/error.hpp"
+#include "lana/gemm.hpp"
+
+#include "gemm_internal.hpp"
+#include "host.hpp"
+
+#include <unistd.h>
+
+#include <array>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace lana {
+namespace detail {
+namespace {
+
+constexpr const char* file_banner = "# lana gemm tuning v1";
+
+std::string section_header(const std::string& host) { return "[" + host + "]"; }
+
+void parse_entry(const std::string& line, std::array<GemmBlocking, 2>& out) {
+    std::istringstream in(line);
+    std::string dtype;
+    in >> dtype;
+    if (dtype != "f32" && dtype != "f64") {
+        return;
+    }
+    GemmBlocking& b = out[dtype == "f64" ? 1 : 0];
+    for (std::string field; in >> field;) {
+        const auto eq = field.find('=');
+        if (eq == std::string::npos) {
+            continue;
+        }
+        const std::string key = field.substr(0, eq);
+        char* end = nullptr;
+        const long long v = std::strtoll(field.c_str() + eq + 1, &end, 10);
+        if (*end != '\0' || v < 0) {
+            continue;
+        }
+        if (key == "mc") {
+            b.mc = static_cast<index_t>(v);
+        } else if (key == "kc") {
+            b.kc = static_cast<index_t>(v);
+        } else if (key == "nc") {
+            b.nc = static_cast<index_t>(v);
+        } else if (key == "mr") {
+            b.mr = static_cast<index_t>(v);
+        } else if (key == "nr") {
+            b.nr = static_cast<index_t>(v);
+        } else if (key == "n_split") {
+            b.n_split = static_cast<int>(v);
+        }
+    }
+}
+
+std::array<GemmBlocking, 2> load_tuning() {
+    std::array<GemmBlocking, 2> out{};
+    const std::string path = gemm_tuning_path();
+    if (path.empty()) {
+        return out;
+    }
+    std::ifstream in(path);
+    const std::string header = section_header(gemm_tuning_host());
+    bool mine = false;
+    for (std::string line; std::getline(in, line);) {
+        if (!line.empty() && line[0] == '[') {
+            mine = line == header;
+        } else if (mine) {
+            parse_entry(line, out);
+        }
+    }
+    return out;
+}
+
+std::string entry(const char* dtype, const GemmBlocking& b) {
+    std::ostringstream os;
+    os << dtype << " mc=" << b.mc << " kc=" << b.kc << " nc=" << b.nc << " mr=" << b.mr << " nr=" << b.nr
+       << " n_split=" << b.n_split;
+    return os.str();
+}
+
+}  // namespace
+
+GemmBlocking tuned_blocking(bool f64) {
+    static const std::array<GemmBlocking, 2> tuned = load_tuning();
+    return tuned[f64 ? 1 : 0];
+}
+
+}  // namespace detail
+
+std::string gemm_tuning_path() {
+    if (const char* env = std::getenv("LANA_TUNE_FILE")) {
+        return env;
+    }
+    if (const char* xdg = std::getenv("XDG_CACHE_HOME"); xdg != nullptr && *xdg != '\0') {
+        return std::string(xdg) + "/lana/gemm_tuning.txt";
+    }
+    if (const char* home = std::getenv("HOME"); home != nullptr && *home != '\0') {
+        return std::string(home) + "/.cache/lana/gemm_tuning.txt";
+    }
+    return {};
+}
+
+std::string gemm_tuning_host() {
+    std::string key = detail::host_cpu_model() + ";" + isa_name(active_isa());
+    for (char& ch : key) {
+        if (ch == '[' || ch == ']' || ch == '\n') {
+            ch = ' ';
+        }
+    }
+    return key;
+}
+
+void save_gemm_tuning(const std::string& path_in) {
+    const std::string path = path_in.empty() ? gemm_tuning_path() : path_in;
+    if (path.empty()) {
+        throw IoError("lana: no tuning file path (set LANA_TUNE_FILE or HOME)");
+    }
+    const std::string header = detail::section_header(gemm_tuning_host());
+
+    // Keep every other host's section as it was.
+    std::vector<std::string> kept;
+    {
+        std::ifstream in(path);
+        bool mine = false;
+        for (std::string line; std::getline(in, line);) {
+            if (line == detail::file_banner) {
+                continue;
+            }
+            if (!line.empty() && line[0] == '[') {
+                mine = line == header;
+            }
+            if (!mine && !line.empty()) {
+                kept.push_back(line);
+            }
+        }
+    }
+
+    std::error_code ec;
+    const std::filesystem::path target(path);
+    if (target.has_parent_path()) {
+        std::filesystem::create_directories(target.parent_path(), ec);
+    }
+    // Written aside and renamed, so a process starting meanwhile reads
+    // either the old file or the new one.
+    const std::string tmp = path + ".tmp." + std::to_string(::getpid());
+    {
+        std::ofstream out(tmp, std::ios::trunc);
+        out << detail::file_banner << '\n';
+        for (const std::string& line : kept) {
+            out << line << '\n';
+        }
+        out << header << '\n'
+            << detail::entry("f32", gemm_blocking_f32()) << '\n'
+            << detail::entry("f64", gemm_blocking_f64()) << '\n';
+        out.flush();
+        if (!out) {
+            const int err = errno;
+            std::filesystem::remove(tmp, ec);
+            throw IoError("lana: cannot write '" + tmp + "': " + std::strerror(err));
+        }
+    }
+    std::filesystem::rename(tmp, target, ec);
+    if (ec) {
+        const std::string why = ec.message();
+        std::filesystem::remove(tmp, ec);
+        throw IoError("lana: cannot replace '" + path + "': " + why);
+    }
+}
+
+}  // namespace lana
@@ -0,0 +1,61 @@
+#include "host.hpp"
+
+#include <fstream>
+
+#if defined(__linux__)
+#  include <unistd.h>
+#endif
+
+namespace lana::detail {
+
+namespace {
+
+CacheSizes probe_cache_sizes() {
+    CacheSizes c;
+#if defined(__linux__) && defined(_SC_LEVEL1_DCACHE_SIZE)
+    auto query = [](int name, std::size_t fallback) {
+        const long v = sysconf(name);
+        return v > 0 ? static_cast<std::size_t>(v) : fallback;
+    };
+    c.l1d = query(_SC_LEVEL1_DCACHE_SIZE, c.l1d);
+    c.l2 = query(_SC_LEVEL2_CACHE_SIZE, c.l2);
+    c.l3 = query(_SC_LEVEL3_CACHE_SIZE, c.l3);
+#endif
+    return c;
+}
+
+std::string probe_cpu_model() {
+    std::string part;
+    std::ifstream in("/proc/cpuinfo");
+    for (std::string line; std::getline(in, line);) {
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon);
+        key.erase(key.find_last_not_of(" \t") + 1);
+        const auto v0 = line.find_first_not_of(' ', colon + 1);
+        const std::string value = v0 == std::string::npos ? std::string() : line.substr(v0);
+        if (key == "model name" && !value.empty()) {
+            return value;
+        }
+        if ((key == "CPU implementer" || key == "CPU part") && part.find(key) == std::string::npos) {
+            part += (part.empty() ? "" : " ") + key + " " + value;
+        }
+    }
+    return part.empty() ? "unknown" : part;
+}
+
+}  // namespace
+
+const std::string& host_cpu_model() {
+    static const std::string model = probe_cpu_model();
+    return model;
+}
+
+const CacheSizes& host_cache_sizes() {
+    static const CacheSizes sizes = probe_cache_sizes();
+    return sizes;
+}
+
+}  // namespace lana::detail
@@ -0,0 +1,24 @@
+#pragma once
+
+// Internal queries about the machine lana is running on.
+
+#include <cstddef>
+#include <string>
+
+namespace lana::detail {
+
+struct CacheSizes {
+    std::size_t l1d = 32 * 1024;
+    std::size_t l2 = 256 * 1024;
+    std::size_t l3 = 8 * 1024 * 1024;
+};
+
+/// Per-core data cache sizes in bytes; falls back to conservative defaults
+/// when the OS does not report them.
+const CacheSizes& host_cache_sizes();
+
+/// CPU model as the OS reports it ("model name" in /proc/cpuinfo, or the
+/// implementer/part pair on AArch64); "unknown" elsewhere.
+const std::string& host_cpu_model();
+
+}  // namespace lana::detail
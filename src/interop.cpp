@@ -0,0 +1,263 @@
+// DLPack, buffer-protocol and Arrow descriptors of lana matrices.
+//
+// Imports only read the foreign descriptor and build a strided view of the
+// memory it names. Exports attach a heap holder (the moved Matrix plus the
+// shape, stride and child arrays the descriptor points at) to the
+// descriptor's own release hook, so the memory lives exactly as long as
+// the consumer holds it.
+
+#include "lana/interop.hpp"
+#include "lana/error.hpp"
+
+#include <bit>
+#include <memory>
+#include <string>
+#include <utility>
+
+namespace lana::interop {
+namespace detail {
+namespace {
+
+using lana::detail::require_dims;
+
+/// Byte strides as whole elements of `size` bytes.
+bool whole_elements(index_t stride, index_t size) noexcept { return stride % size == 0; }
+
+/// DLPack tensor shared by both exports; `keep` holds the matrix, if any.
+template <typename T>
+struct DlpackHolder {
+    DLManagedTensor managed{};
+    std::int64_t shape[2];
+    std::int64_t strides[2];
+    Matrix<T> keep;
+};
+
+template <typename T>
+void dlpack_delete(DLManagedTensor* self) {
+    delete static_cast<DlpackHolder<T>*>(self->manager_ctx);
+}
+
+/// Fills the holder's tensor with `v` and gives the holder to its deleter.
+template <typename T>
+DLManagedTensor* make_dlpack(std::unique_ptr<DlpackHolder<T>> h, MatrixView<T> v) {
+    h->shape[0] = v.rows();
+    h->shape[1] = v.cols();
+    h->strides[0] = v.row_stride();
+    h->strides[1] = v.col_stride();
+    DLTensor& t = h->managed.dl_tensor;
+    t.data = v.data();
+    t.device = DLDevice{kDLCPU, 0};
+    t.ndim = 2;
+    t.dtype = DLDataType{static_cast<std::uint8_t>(kDLFloat), static_cast<std::uint8_t>(8 * sizeof(T)), 1};
+    t.shape = h->shape;
+    t.strides = h->strides;
+    t.byte_offset = 0;
+    h->managed.manager_ctx = h.get();
+    h->managed.deleter = &dlpack_delete<T>;
+    return &h.release()->managed;
+}
+
+template <typename T>
+DLManagedTensor* owning_dlpack(Matrix<T>&& m) {
+    auto h = std::make_unique<DlpackHolder<T>>();
+    h->keep = std::move(m);
+    const MatrixView<T> v = h->keep.view();
+    return make_dlpack(std::move(h), v);
+}
+
+template <typename T>
+DLManagedTensor* lent_dlpack(MatrixView<T> v) {
+    return make_dlpack(std::make_unique<DlpackHolder<T>>(), v);
+}
+
+/// Arrow array memory: the parent's and the child's buffer tables and the
+/// matrix behind them. Parent and child each hold a reference, since the
+/// Arrow spec lets a consumer move the child out and release it separately.
+template <typename T>
+struct ArrowArrays {
+    Matrix<T> keep;
+    const void* parent_buffers[1] = {nullptr};
+    const void* child_buffers[2] = {nullptr, nullptr};
+    ArrowArray child{};
+    ArrowArray* children[1] = {nullptr};
+};
+
+template <typename T>
+using ArrowRef = std::shared_ptr<ArrowArrays<T>>;
+
+template <typename T>
+void arrow_child_release(ArrowArray* a) {
+    delete static_cast<ArrowRef<T>*>(a->private_data);
+    a->release = nullptr;
+}
+
+template <typename T>
+void arrow_parent_release(ArrowArray* a) {
+    auto* ref = static_cast<ArrowRef<T>*>(a->private_data);
+    ArrowArray& child = (*ref)->child;
+    if (child.release != nullptr) {
+        child.release(&child);
+    }
+    delete ref;
+    a->release = nullptr;
+}
+
+struct ArrowSchemas {
+    std::string format;
+    ArrowSchema child{};
+    ArrowSchema* children[1] = {nullptr};
+};
+
+/// The child schema holds only string literals, so it owns nothing.
+void arrow_child_schema_release(ArrowSchema* s) { s->release = nullptr; }
+
+void arrow_schema_release(ArrowSchema* s) {
+    auto* h = static_cast<ArrowSchemas*>(s->private_data);
+    if (h->child.release != nullptr) {
+        h->child.release(&h->child);
+    }
+    delete h;
+    s->release = nullptr;
+}
+
+template <typename T>
+void to_arrow_impl(Matrix<T>&& m, ArrowArray* array, ArrowSchema* schema) {
+    require_dims(array != nullptr && schema != nullptr, "interop::to_arrow");
+    const index_t rows = m.rows();
+    const index_t cols = m.cols();
+    require_dims(rows <= 0x7fffffff, "interop::to_arrow (list size)");
+
+    auto sh = std::make_unique<ArrowSchemas>();
+    sh->format = "+w:" + std::to_string(rows);
+    sh->child.format = sizeof(T) == 8 ? "g" : "f";
+    sh->child.name = "item";
+    sh->child.release = &arrow_child_schema_release;
+    sh->children[0] = &sh->child;
+
+    auto ah = std::make_shared<ArrowArrays<T>>();
+    ah->keep = std::move(m);
+    ah->child_buffers[1] = ah->keep.data();
+    ah->child.length = rows * cols;
+    ah->child.n_buffers = 2;
+    ah->child.buffers = ah->child_buffers;
+    ah->child.private_data = new ArrowRef<T>(ah);
+    ah->child.release = &arrow_child_release<T>;
+    ah->children[0] = &ah->child;
+
+    *array = ArrowArray{};
+    array->length = cols;
+    array->n_buffers = 1;
+    array->buffers = ah->parent_buffers;
+    array->n_children = 1;
+    array->children = ah->children;
+    array->private_data = new ArrowRef<T>(std::move(ah));
+    array->release = &arrow_parent_release<T>;
+
+    *schema = ArrowSchema{};
+    schema->format = sh->format.c_str();
+    schema->name = "";
+    schema->n_children = 1;
+    schema->children = sh->children;
+    schema->private_data = sh.get();
+    schema->release = &arrow_schema_release;
+    sh.release();
+}
+
+template <typename T>
+BufferInfo to_buffer_impl(MatrixView<T> v, bool readonly) {
+    const auto size = static_cast<index_t>(sizeof(T));
+    BufferInfo b;
+    b.buf = v.data();
+    b.itemsize = size;
+    b.format = size == 8 ? "d" : "f";
+    b.ndim = 2;
+    b.shape[0] = v.rows();
+    b.shape[1] = v.cols();
+    b.strides[0] = v.row_stride() * size;
+    b.strides[1] = v.col_stride() * size;
+    b.readonly = readonly;
+    return b;
+}
+
+}  // namespace
+
+Strided dlpack_strided(const DLTensor& t, int bits) {
+    const DLDeviceType dev = t.device.device_type;
+    require_dims(dev == kDLCPU || dev == kDLCUDAHost || dev == kDLROCMHost, "interop::from_dlpack (device memory)");
+    require_dims(t.dtype.code == kDLFloat && t.dtype.bits == bits && t.dtype.lanes == 1,
+                 "interop::from_dlpack (dtype)");
+    require_dims(t.ndim == 1 || t.ndim == 2, "interop::from_dlpack (ndim)");
+    Strided s;
+    s.data = static_cast<char*>(t.data) + t.byte_offset;
+    s.rows = t.shape[0];
+    s.cols = t.ndim == 2 ? t.shape[1] : 1;
+    if (t.strides == nullptr) {
+        s.row_stride = s.cols;
+        s.col_stride = 1;
+    } else {
+        s.row_stride = t.strides[0];
+        s.col_stride = t.ndim == 2 ? t.strides[1] : s.rows;
+    }
+    return s;
+}
+
+Strided buffer_strided(const BufferInfo& b, int bits) {
+    const char* f = b.format != nullptr ? b.format : "B";
+    if (*f == '@' || *f == '=' || (*f == '<' && std::endian::native == std::endian::little)) {
+        ++f;
+    }
+    const char want = bits == 64 ? 'd' : 'f';
+    require_dims(f[0] == want && f[1] == '\0' && b.itemsize * 8 == bits, "interop::from_buffer (format)");
+    require_dims(b.ndim == 1 || b.ndim == 2, "interop::from_buffer (ndim)");
+    require_dims(whole_elements(b.strides[0], b.itemsize) && (b.ndim == 1 || whole_elements(b.strides[1], b.itemsize)),
+                 "interop::from_buffer (unaligned strides)");
+    Strided s;
+    s.data = b.buf;
+    s.rows = b.shape[0];
+    s.cols = b.ndim == 2 ? b.shape[1] : 1;
+    s.row_stride = b.strides[0] / b.itemsize;
+    s.col_stride = b.ndim == 2 ? b.strides[1] / b.itemsize : s.rows;
+    return s;
+}
+
+Strided arrow_strided(const ArrowArray& a, const ArrowSchema& s, int bits) {
+    const std::string format = s.format != nullptr ? s.format : "";
+    require_dims(format.rfind("+w:", 0) == 0 && s.n_children == 1 && a.n_children == 1,
+                 "interop::from_arrow (not a fixed-size list)");
+    const ArrowSchema& cs = *s.children[0];
+    const ArrowArray& ca = *a.children[0];
+    require_dims(cs.format != nullptr && std::string(cs.format) == (bits == 64 ? "g" : "f"),
+                 "interop::from_arrow (value type)");
+    const auto no_nulls = [](const ArrowArray& x) {
+        return x.null_count == 0 || x.n_buffers == 0 || x.buffers[0] == nullptr;
+    };
+    require_dims(no_nulls(a) && no_nulls(ca) && ca.n_buffers == 2, "interop::from_arrow (nulls)");
+    const index_t width = std::stoll(format.substr(3));
+    Strided m;
+    m.rows = a.length;
+    m.cols = width;
+    m.row_stride = width;
+    m.col_stride = 1;
+    const index_t first = ca.offset + a.offset * width;
+    m.data = const_cast<char*>(static_cast<const char*>(ca.buffers[1])) + first * (bits / 8);
+    return m;
+}
+
+}  // namespace detail
+
+DLManagedTensor* to_dlpack(Matrix<float>&& m) { return detail::owning_dlpack(std::move(m)); }
+DLManagedTensor* to_dlpack(Matrix<double>&& m) { return detail::owning_dlpack(std::move(m)); }
+DLManagedTensor* to_dlpack(MatrixView<float> v) { return detail::lent_dlpack(v); }
+DLManagedTensor* to_dlpack(MatrixView<double> v) { return detail::lent_dlpack(v); }
+
+void to_arrow(Matrix<float>&& m, ArrowArray* array, ArrowSchema* schema) {
+    detail::to_arrow_impl(std::move(m), array, schema);
+}
+void to_arrow(Matrix<double>&& m, ArrowArray* array, ArrowSchema* schema) {
+    detail::to_arrow_impl(std::move(m), array, schema);
+}
+
+BufferInfo to_buffer(MatrixView<float> v, bool readonly) { return detail::to_buffer_impl(v, readonly); }
+BufferInfo to_buffer(MatrixView<double> v, bool readonly) { return detail::to_buffer_impl(v, readonly); }
+
+}  // namespace lana::interop
@@ -0,0 +1,443 @@
+#include "lana/io.hpp"
+
+#include "io_format.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace lana {
+
+static_assert(sizeof(index_t) == sizeof(std::int64_t), "CSR row pointers are stored as int64");
+
+namespace detail {
+namespace {
+
+[[noreturn]] void fail(const std::string& what, const std::string& path, int err = 0) {
+    std::string msg = "lana: " + what + " '" + path + "'";
+    if (err != 0) {
+        msg += ": ";
+        msg += std::strerror(err);
+    }
+    throw IoError(msg);
+}
+
+template <typename T>
+constexpr std::uint32_t dtype_of() {
+    return std::is_same_v<T, float> ? file::dtype_f32 : file::dtype_f64;
+}
+
+std::size_t dtype_size(std::uint32_t dtype) { return dtype == file::dtype_f32 ? sizeof(float) : sizeof(double); }
+
+}  // namespace
+
+class FileWriterImpl {
+public:
+    explicit FileWriterImpl(const std::string& path) : path_(path) {
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            fail("cannot create", path_, errno);
+        }
+        // A zeroed header until close(): an unfinished file fails the magic check.
+        const file::FileHeader blank{};
+        write_all(&blank, sizeof(blank));
+    }
+
+    ~FileWriterImpl() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    template <typename T>
+    void add_dense(const std::string& name, MatrixView<const T> a) {
+        file::SectionEntry e = entry(name, file::kind_dense, dtype_of<T>(), a.rows(), a.cols());
+        pad();
+        e.offset[0] = pos_;
+        const index_t m = a.rows();
+        const index_t n = a.cols();
+        const auto elem = sizeof(T);
+        if (a.row_stride() == 1 && (a.col_stride() == m || n <= 1)) {
+            e.layout = file::layout_col_major;
+            e.ld = std::max<index_t>(m, 1);
+            write_all(a.data(), static_cast<std::size_t>(m * n) * elem);
+        } else if (a.col_stride() == 1 && (a.row_stride() == n || m <= 1)) {
+            e.layout = file::layout_row_major;
+            e.ld = std::max<index_t>(n, 1);
+            write_all(a.data(), static_cast<std::size_t>(m * n) * elem);
+        } else if (a.row_stride() == 1) {
+            e.layout = file::layout_col_major;
+            e.ld = std::max<index_t>(m, 1);
+            for (index_t j = 0; j < n; ++j) {
+                write_all(a.data() + j * a.col_stride(), static_cast<std::size_t>(m) * elem);
+            }
+        } else {
+            e.layout = file::layout_col_major;
+            e.ld = std::max<index_t>(m, 1);
+            std::vector<T> column(static_cast<std::size_t>(m));
+            for (index_t j = 0; j < n; ++j) {
+                for (index_t i = 0; i < m; ++i) {
+                    column[static_cast<std::size_t>(i)] = a(i, j);
+                }
+                write_all(column.data(), column.size() * elem);
+            }
+        }
+        entries_.push_back(e);
+    }
+
+    template <typename T>
+    void add_csr(const std::string& name, CsrView<T> a) {
+        file::SectionEntry e = entry(name, file::kind_csr, dtype_of<T>(), a.rows(), a.cols());
+        e.nnz = a.nnz();
+        pad();
+        e.offset[0] = pos_;
+        write_all(a.row_ptr(), static_cast<std::size_t>(a.rows() + 1) * sizeof(index_t));
+        pad();
+        e.offset[1] = pos_;
+        write_all(a.col_idx(), static_cast<std::size_t>(a.nnz()) * sizeof(sparse_index_t));
+        pad();
+        e.offset[2] = pos_;
+        write_all(a.values(), static_cast<std::size_t>(a.nnz()) * sizeof(T));
+        entries_.push_back(e);
+    }
+
+    void close() {
+        if (fd_ < 0) {
+            return;
+        }
+        pad();
+        file::FileHeader h{};
+        std::memcpy(h.magic, file::magic, sizeof(h.magic));
+        h.version = file::version;
+        h.byte_order = file::byte_order_mark;
+        h.section_count = entries_.size();
+        h.table_offset = pos_;
+        write_all(entries_.data(), entries_.size() * sizeof(file::SectionEntry));
+        h.file_size = pos_;
+        if (::pwrite(fd_, &h, sizeof(h), 0) != static_cast<ssize_t>(sizeof(h))) {
+            fail("cannot write", path_, errno);
+        }
+        const int fd = std::exchange(fd_, -1);
+        if (::close(fd) != 0) {
+            fail("cannot close", path_, errno);
+        }
+    }
+
+private:
+    file::SectionEntry entry(const std::string& name, std::uint32_t kind, std::uint32_t dtype, index_t rows,
+                             index_t cols) {
+        if (fd_ < 0) {
+            throw IoError("lana: FileWriter is already closed");
+        }
+        if (name.empty() || name.size() >= file::max_name) {
+            throw IoError("lana: section name must be 1 to 47 bytes: '" + name + "'");
+        }
+        for (const file::SectionEntry& e : entries_) {
+            if (name == e.name) {
+                throw IoError("lana: duplicate section '" + name + "' in '" + path_ + "'");
+            }
+        }
+        file::SectionEntry e{};
+        std::memcpy(e.name, name.data(), name.size());
+        e.kind = kind;
+        e.dtype = dtype;
+        e.rows = rows;
+        e.cols = cols;
+        return e;
+    }
+
+    void write_all(const void* data, std::size_t bytes) {
+        const char* p = static_cast<const char*>(data);
+        while (bytes > 0) {
+            const ssize_t w = ::write(fd_, p, std::min<std::size_t>(bytes, std::size_t(1) << 30));
+            if (w < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                fail("cannot write", path_, errno);
+            }
+            p += w;
+            bytes -= static_cast<std::size_t>(w);
+            pos_ += static_cast<std::uint64_t>(w);
+        }
+    }
+
+    void pad() {
+        static const char zeros[file::file_alignment] = {};
+        const std::uint64_t target = file::align_up(pos_);
+        write_all(zeros, static_cast<std::size_t>(target - pos_));
+    }
+
+    std::string path_;
+    int fd_ = -1;
+    std::uint64_t pos_ = 0;
+    std::vector<file::SectionEntry> entries_;
+};
+
+}  // namespace detail
+
+FileWriter::FileWriter(const std::string& path) : impl_(std::make_unique<detail::FileWriterImpl>(path)) {}
+
+FileWriter::~FileWriter() {
+    try {
+        impl_->close();
+    } catch (const IoError&) {
+        // Destructors cannot report; call close() to see the error.
+    }
+}
+
+void FileWriter::add(const std::string& name, MatrixView<const float> a) { impl_->add_dense(name, a); }
+void FileWriter::add(const std::string& name, MatrixView<const double> a) { impl_->add_dense(name, a); }
+void FileWriter::add(const std::string& name, CsrView<float> a) { impl_->add_csr(name, a); }
+void FileWriter::add(const std::string& name, CsrView<double> a) { impl_->add_csr(name, a); }
+void FileWriter::close() { impl_->close(); }
+
+void save(const std::string& path, MatrixView<const float> a) {
+    FileWriter w(path);
+    w.add("matrix", a);
+    w.close();
+}
+
+void save(const std::string& path, MatrixView<const double> a) {
+    FileWriter w(path);
+    w.add("matrix", a);
+    w.close();
+}
+
+namespace {
+
+/// True when `count` elements of `elem` bytes starting at `offset` fit below `end`.
+bool fits(std::uint64_t offset, std::uint64_t count, std::uint64_t elem, std::uint64_t end) {
+    return offset <= end && offset % elem == 0 && count <= (end - offset) / elem;
+}
+
+int advice_flag(MapAdvice a) {
+    switch (a) {
+        case MapAdvice::Sequential: return MADV_SEQUENTIAL;
+        case MapAdvice::Random: return MADV_RANDOM;
+        case MapAdvice::WillNeed: return MADV_WILLNEED;
+        case MapAdvice::Normal: break;
+    }
+    return MADV_NORMAL;
+}
+
+}  // namespace
+
+MappedFile::MappedFile(const std::string& path, MapOptions options) {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        detail::fail("cannot open", path, errno);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+        const int err = errno;
+        ::close(fd);
+        detail::fail("cannot stat", path, err);
+    }
+    const auto size = static_cast<std::uint64_t>(st.st_size);
+    if (size < sizeof(detail::file::FileHeader)) {
+        ::close(fd);
+        detail::fail("not a lana file (too short)", path);
+    }
+    int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+    if (options.populate) {
+        flags |= MAP_POPULATE;
+    }
+#endif
+    void* p = ::mmap(nullptr, static_cast<std::size_t>(size), PROT_READ, flags, fd, 0);
+    const int map_err = errno;
+    ::close(fd);  // the mapping keeps the file referenced
+    if (p == MAP_FAILED) {
+        detail::fail("cannot map", path, map_err);
+    }
+    base_ = static_cast<const std::byte*>(p);
+    size_ = static_cast<std::size_t>(size);
+    if (options.advice != MapAdvice::Normal) {
+        ::madvise(p, size_, advice_flag(options.advice));
+    }
+
+    try {
+        namespace file = detail::file;
+        file::FileHeader h;
+        std::memcpy(&h, base_, sizeof(h));
+        if (std::memcmp(h.magic, file::magic, sizeof(h.magic)) != 0) {
+            detail::fail("not a lana file (bad magic or unfinished write)", path);
+        }
+        if (h.byte_order != file::byte_order_mark) {
+            detail::fail("lana file has foreign byte order", path);
+        }
+        if (h.version != file::version) {
+            detail::fail("unsupported lana file version " + std::to_string(h.version) + " in", path);
+        }
+        if (h.file_size != size || !fits(h.table_offset, h.section_count, sizeof(file::SectionEntry), size)) {
+            detail::fail("truncated lana file", path);
+        }
+        sections_.reserve(static_cast<std::size_t>(h.section_count));
+        offsets_.reserve(static_cast<std::size_t>(3 * h.section_count));
+        const std::uint64_t payload_end = h.table_offset;
+        for (std::uint64_t s = 0; s < h.section_count; ++s) {
+            file::SectionEntry e;
+            std::memcpy(&e, base_ + h.table_offset + s * sizeof(e), sizeof(e));
+            const char* nul = static_cast<const char*>(std::memchr(e.name, '\0', sizeof(e.name)));
+            const bool dtype_ok = e.dtype == file::dtype_f32 || e.dtype == file::dtype_f64;
+            bool ok = nul != nullptr && nul != e.name && dtype_ok && e.rows >= 0 && e.cols >= 0;
+            const std::uint64_t elem = dtype_ok ? detail::dtype_size(e.dtype) : 1;
+            const auto rows = static_cast<std::uint64_t>(e.rows);
+            const auto cols = static_cast<std::uint64_t>(e.cols);
+            if (ok && e.kind == file::kind_dense) {
+                const bool col_major = e.layout == file::layout_col_major;
+                const std::uint64_t inner = col_major ? rows : cols;
+                const std::uint64_t outer = col_major ? cols : rows;
+                ok = (col_major || e.layout == file::layout_row_major) && e.ld >= 1 &&
+                     static_cast<std::uint64_t>(e.ld) >= inner;
+                // Elements spanned: ld * (outer - 1) + inner, or none when empty.
+                const std::uint64_t ld = static_cast<std::uint64_t>(e.ld);
+                ok = ok && (inner == 0 || outer == 0 ||
+                            (outer - 1 <= (payload_end / elem) / ld &&
+                             fits(e.offset[0], ld * (outer - 1) + inner, elem, payload_end)));
+            } else if (ok && e.kind == file::kind_csr) {
+                ok = e.nnz >= 0 && e.rows <= std::numeric_limits<sparse_index_t>::max() &&
+                     e.cols <= std::numeric_limits<sparse_index_t>::max() &&
+                     fits(e.offset[0], rows + 1, sizeof(index_t), payload_end) &&
+                     fits(e.offset[1], static_cast<std::uint64_t>(e.nnz), sizeof(sparse_index_t), payload_end) &&
+                     fits(e.offset[2], static_cast<std::uint64_t>(e.nnz), elem, payload_end);
+                if (ok) {
+                    // Cheap consistency check that touches two pages at most.
+                    const auto* rp = reinterpret_cast<const index_t*>(base_ + e.offset[0]);
+                    ok = rp[0] == 0 && rp[e.rows] == e.nnz;
+                }
+            } else {
+                ok = false;
+            }
+            std::string name(e.name, nul ? static_cast<std::size_t>(nul - e.name) : 0);
+            if (!ok) {
+                detail::fail("malformed section '" + name + "' in", path);
+            }
+            if (contains(name)) {
+                detail::fail("duplicate section '" + name + "' in", path);
+            }
+            sections_.push_back(SectionInfo{std::move(name), static_cast<SectionKind>(e.kind),
+                                            static_cast<Dtype>(e.dtype), static_cast<Layout>(e.layout), e.rows,
+                                            e.cols, e.ld, e.nnz});
+            offsets_.insert(offsets_.end(), e.offset, e.offset + 3);
+        }
+    } catch (...) {
+        ::munmap(const_cast<std::byte*>(base_), size_);
+        throw;
+    }
+}
+
+MappedFile::~MappedFile() {
+    if (base_ != nullptr) {
+        ::munmap(const_cast<std::byte*>(base_), size_);
+    }
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+    : base_(std::exchange(other.base_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      sections_(std::move(other.sections_)),
+      offsets_(std::move(other.offsets_)) {}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        if (base_ != nullptr) {
+            ::munmap(const_cast<std::byte*>(base_), size_);
+        }
+        base_ = std::exchange(other.base_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        sections_ = std::move(other.sections_);
+        offsets_ = std::move(other.offsets_);
+    }
+    return *this;
+}
+
+bool MappedFile::contains(const std::string& name) const noexcept {
+    return std::any_of(sections_.begin(), sections_.end(), [&](const SectionInfo& s) { return s.name == name; });
+}
+
+const SectionInfo& MappedFile::section(const std::string& name) const {
+    for (const SectionInfo& s : sections_) {
+        if (s.name == name) {
+            return s;
+        }
+    }
+    throw IoError("lana: no section '" + name + "' in mapped file");
+}
+
+const SectionInfo& MappedFile::expect(const std::string& name, SectionKind kind, Dtype dtype) const {
+    const SectionInfo& s = section(name);
+    if (s.kind != kind || s.dtype != dtype) {
+        throw IoError("lana: section '" + name + "' has a different kind or element type");
+    }
+    return s;
+}
+
+const void* MappedFile::payload(const SectionInfo& s, int array) const noexcept {
+    const auto idx = static_cast<std::size_t>(&s - sections_.data());
+    return base_ + offsets_[3 * idx + static_cast<std::size_t>(array)];
+}
+
+namespace {
+
+template <typename T>
+MatrixView<const T> dense_view(const SectionInfo& s, const void* p) {
+    const auto* data = static_cast<const T*>(p);
+    return s.layout == Layout::ColMajor ? MatrixView<const T>(data, s.rows, s.cols, 1, s.ld)
+                                        : MatrixView<const T>(data, s.rows, s.cols, s.ld, 1);
+}
+
+}  // namespace
+
+MatrixView<const float> MappedFile::matrix_f32(const std::string& name) const {
+    const SectionInfo& s = expect(name, SectionKind::Dense, Dtype::F32);
+    return dense_view<float>(s, payload(s, 0));
+}
+
+MatrixView<const double> MappedFile::matrix_f64(const std::string& name) const {
+    const SectionInfo& s = expect(name, SectionKind::Dense, Dtype::F64);
+    return dense_view<double>(s, payload(s, 0));
+}
+
+CsrView<float> MappedFile::csr_f32(const std::string& name) const {
+    const SectionInfo& s = expect(name, SectionKind::Csr, Dtype::F32);
+    return CsrView<float>(s.rows, s.cols, static_cast<const index_t*>(payload(s, 0)),
+                          static_cast<const sparse_index_t*>(payload(s, 1)), static_cast<const float*>(payload(s, 2)));
+}
+
+CsrView<double> MappedFile::csr_f64(const std::string& name) const {
+    const SectionInfo& s = expect(name, SectionKind::Csr, Dtype::F64);
+    return CsrView<double>(s.rows, s.cols, static_cast<const index_t*>(payload(s, 0)),
+                           static_cast<const sparse_index_t*>(payload(s, 1)),
+                           static_cast<const double*>(payload(s, 2)));
+}
+
+void MappedFile::prefetch(const std::string& name) const noexcept {
+    for (std::size_t i = 0; i < sections_.size(); ++i) {
+        if (sections_[i].name != name) {
+            continue;
+        }
+        // The section's arrays lie between its first offset and the next
+        // section's (or the table); advise that whole page-aligned span.
+        const std::uint64_t begin = offsets_[3 * i] / detail::file::file_alignment * detail::file::file_alignment;
+        std::uint64_t end = size_;
+        for (std::size_t j = 0; j < sections_.size(); ++j) {
+            if (offsets_[3 * j] > offsets_[3 * i]) {
+                end = std::min(end, offsets_[3 * j]);
+            }
+        }
+        ::madvise(const_cast<std::byte*>(base_) + begin, static_cast<std::size_t>(end - begin), MADV_WILLNEED);
+        return;
+    }
+}
+
+}  // namespace lana
@@ -0,0 +1,76 @@
+#pragma once
+
+// On-disk layout of lana matrix files (see lana/io.hpp).
+//
+//   offset 0     FileHeader (64 bytes)
+//   ...          payloads, each starting on a file_alignment boundary
+//   table_offset section_count x SectionEntry (128 bytes each)
+//
+// All integers are little-endian and host-sized as written below; the
+// byte-order mark lets a reader reject files written on a different-endian
+// host instead of misreading them. Readers must ignore unknown flags and
+// reject unknown versions, kinds or dtypes.
+
+#include "lana/config.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace lana::detail::file {
+
+inline constexpr char magic[8] = {'\x89', 'L', 'A', 'N', 'A', '\r', '\n', '\x1a'};
+inline constexpr std::uint32_t version = 1;
+inline constexpr std::uint32_t byte_order_mark = 0x01020304;
+/// Payload alignment: one small page, enough for SIMD loads and for mapping
+/// ranges of a payload on its own.
+inline constexpr std::uint64_t file_alignment = 4096;
+inline constexpr std::size_t max_name = 48;
+
+/// Section payload kinds.
+enum Kind : std::uint32_t {
+    kind_dense = 1,  ///< offset[0]: rows x cols values with leading dimension ld
+    kind_csr = 2,    ///< offset[0]: row_ptr (int64, rows + 1), offset[1]: col_idx (int32, nnz),
+                     ///< offset[2]: values (nnz)
+};
+
+/// Element types.
+enum Dtype : std::uint32_t {
+    dtype_f32 = 1,
+    dtype_f64 = 2,
+};
+
+/// Dense element order.
+enum Layout : std::uint32_t {
+    layout_col_major = 0,  ///< (i, j) at i + j * ld
+    layout_row_major = 1,  ///< (i, j) at i * ld + j
+};
+
+struct FileHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t section_count;
+    std::uint64_t table_offset;
+    std::uint64_t file_size;  ///< for truncation checks
+    std::uint8_t reserved[24];
+};
+static_assert(sizeof(FileHeader) == 64);
+
+struct SectionEntry {
+    char name[max_name];  ///< NUL-padded, unique within a file
+    std::uint32_t kind;
+    std::uint32_t dtype;
+    std::uint32_t layout;
+    std::uint32_t reserved0;
+    std::int64_t rows;
+    std::int64_t cols;
+    std::int64_t ld;
+    std::int64_t nnz;
+    std::uint64_t offset[3];
+    std::uint64_t reserved1;
+};
+static_assert(sizeof(SectionEntry) == 128);
+
+inline std::uint64_t align_up(std::uint64_t v) { return (v + file_alignment - 1) / file_alignment * file_alignment; }
+
+}  // namespace lana::detail::file
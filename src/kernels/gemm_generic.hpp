@@ -0,0 +1,44 @@
+#pragma once
+
+// Portable GEMM micro-kernel. Written so that the compiler can keep the
+// MR x NR accumulator tile in registers and vectorize along MR.
+
+#include "lana/config.hpp"
+
+namespace lana::detail::LANA_KERNEL_NS {
+
+/// C[0:MR, 0:NR] = beta * C + A_panel * B_panel.
+///
+/// `a` is a packed MR-wide panel (k-major), `b` a packed NR-wide panel
+/// (k-major) and C is column-major with leading dimension `ldc`. C is not
+/// read when beta is zero.
+template <typename T, int MR, int NR>
+void gemm_ukernel_generic(index_t k, const T* LANA_RESTRICT a, const T* LANA_RESTRICT b, T beta,
+                          T* LANA_RESTRICT c, index_t ldc) {
+    T acc[MR * NR] = {};
+    for (index_t p = 0; p < k; ++p) {
+        const T* ap = a + p * MR;
+        const T* bp = b + p * NR;
+        for (int j = 0; j < NR; ++j) {
+            const T bj = bp[j];
+            for (int i = 0; i < MR; ++i) {
+                acc[j * MR + i] += ap[i] * bj;
+            }
+        }
+    }
+    if (beta == T(0)) {
+        for (int j = 0; j < NR; ++j) {
+            for (int i = 0; i < MR; ++i) {
+                c[i + j * ldc] = acc[j * MR + i];
+            }
+        }
+    } else {
+        for (int j = 0; j < NR; ++j) {
+            for (int i = 0; i < MR; ++i) {
+                c[i + j * ldc] = beta * c[i + j * ldc] + acc[j * MR + i];
+            }
+        }
+    }
+}
+
+}  // namespace lana::detail::LANA_KERNEL_NS
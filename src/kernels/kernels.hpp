@@ -0,0 +1,137 @@
+#pragma once
+
+// Kernel dispatch table.
+//
+// Every ISA-specific translation unit fills in one KernelTable per element
+// type; dispatch.cpp picks the best table the host can run and the rest of
+// the library calls through it. All kernels work on unit-stride data; the
+// public entry points deal with strides and argument checking.
+
+#include "lana/batched.hpp"
+#include "lana/config.hpp"
+#include "lana/cpu.hpp"
+#include "lana/expr.hpp"
+
+#include <cstdint>
+
+namespace lana::detail {
+
+/// Packed-panel GEMM micro-kernel: C[0:mr, 0:nr] = beta * C + A_panel * B_panel,
+/// C column-major with leading dimension `ldc`, not read when beta is zero.
+template <typename T>
+using GemmUkernelFn = void (*)(index_t k, const T* a, const T* b, T beta, T* c, index_t ldc);
+
+template <typename T>
+struct GemmKernel {
+    index_t mr;
+    index_t nr;
+    GemmUkernelFn<T> ukernel;
+};
+
+/// Alternative micro-kernel tiles a table can offer next to its default.
+inline constexpr int gemm_alt_max = 3;
+
+template <typename T>
+struct KernelTable {
+    Isa isa;
+    GemmKernel<T> gemm;
+    /// Other tiles the GEMM blocking may select instead of `gemm` (see
+    /// GemmBlocking::mr); unused entries have a null ukernel.
+    GemmKernel<T> gemm_alt[gemm_alt_max];
+    T (*dot)(index_t n, const T* x, const T* y);
+    void (*axpy)(index_t n, T alpha, const T* x, T* y);
+    T (*sum)(index_t n, const T* x);
+    /// Sum of squares; nrm2 takes the square root (with rescaling on overflow).
+    T (*sumsq)(index_t n, const T* x);
+    /// y = sum of coeffs[t] * xs[t] over 1 <= terms <= lincomb_max_terms;
+    /// y may be one of the xs.
+    void (*lincomb)(index_t n, int terms, const T* coeffs, const T* const* xs, T* y);
+    /// sum of vals[i] * x[idx[i]]: one CSR row times a dense vector.
+    T (*sparse_dot)(index_t n, const T* vals, const std::int32_t* idx, const T* x);
+
+    // Interleaved batches (see batched::InterleavedView): groups of
+    // G = batched::interleave_width<T> matrices, element e of lane l at
+    // p[e * G + l] within its group, groups back to back. Kernels run whole
+    // groups; pivots and info are written only for lanes below `count`.
+    /// C = alpha * A * B + beta * C for every lane, A m x k, B k x n.
+    void (*soa_gemm)(index_t m, index_t n, index_t k, index_t groups, T alpha, const T* a, const T* b, T beta, T* c);
+    /// LU with partial pivoting of n x n lanes; 0-based pivots of matrix b
+    /// at ipiv[b * n], info[b] as for batched::getrf.
+    void (*soa_getrf)(index_t n, index_t groups, index_t count, T* a, std::int32_t* ipiv, std::int32_t* info);
+    /// Lower Cholesky factor of n x n lanes; info[b] as for batched::potrf.
+    void (*soa_potrf)(index_t n, index_t groups, index_t count, T* a, std::int32_t* info);
+};
+
+/// Mixed-precision micro-kernel: C[0:mr, 0:nr] = alpha * A_panel * B_panel +
+/// beta * C in float, the panels holding bfloat16 bit patterns. Element
+/// (i, p) of an A panel is at a[(p / 2) * 2 * mr + 2 * i + p % 2] (k in
+/// pairs). B panels use the same layout with nr, or with `b_by_column` hold
+/// each column k-contiguous, element (p, j) at b[j * k + p]. `k` is a
+/// multiple of `k_step`; packing zero-pads up to it.
+using MixedGemmUkernelFn = void (*)(index_t k, const std::uint16_t* a, const std::uint16_t* b, float alpha,
+                                    float beta, float* c, index_t ldc);
+
+struct MixedGemmKernel {
+    index_t mr;
+    index_t nr;
+    index_t k_step;
+    bool b_by_column;
+    MixedGemmUkernelFn ukernel;
+};
+
+/// Upper bound on mr * nr over every micro-kernel shape.
+inline constexpr index_t max_tile_elems = 1024;
+
+// Per-ISA tables. Only the ones the library was built with are defined;
+// see LANA_HAVE_*_KERNELS in CMakeLists.txt.
+namespace scalar {
+const KernelTable<float>& kernels_f32();
+const KernelTable<double>& kernels_f64();
+}  // namespace scalar
+namespace sse42 {
+const KernelTable<float>& kernels_f32();
+const KernelTable<double>& kernels_f64();
+}  // namespace sse42
+namespace avx2 {
+const KernelTable<float>& kernels_f32();
+const KernelTable<double>& kernels_f64();
+}  // namespace avx2
+namespace avx512 {
+const KernelTable<float>& kernels_f32();
+const KernelTable<double>& kernels_f64();
+}  // namespace avx512
+namespace neon {
+const KernelTable<float>& kernels_f32();
+const KernelTable<double>& kernels_f64();
+}  // namespace neon
+
+namespace avx512bf16 {
+/// bfloat16 GEMM on vdpbf16ps (AVX512_BF16).
+const MixedGemmKernel& gemm_bf16_kernel();
+}  // namespace avx512bf16
+namespace amx {
+/// bfloat16 GEMM on AMX tiles; the caller must have been granted the
+/// XTILEDATA state (see dispatch.cpp).
+const MixedGemmKernel& gemm_bf16_kernel();
+}  // namespace amx
+
+/// The tables selected for this process (see active_isa()).
+const KernelTable<float>& kernels_f32();
+const KernelTable<double>& kernels_f64();
+
+/// The best bfloat16 kernel the host runs under the active ISA, else null
+/// (bfloat16 GEMM then widens to float while packing).
+const MixedGemmKernel* gemm_bf16_kernel();
+
+template <typename T>
+const KernelTable<T>& kernels();
+template <>
+inline const KernelTable<float>& kernels<float>() {
+    return kernels_f32();
+}
+template <>
+inline const KernelTable<double>& kernels<double>() {
+    return kernels_f64();
+}
+
+}  // namespace lana::detail
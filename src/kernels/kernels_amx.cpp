@@ -0,0 +1,99 @@
+// AMX (AMX-TILE + AMX-BF16) GEMM micro-kernel. Compiled with the matching
+// target flags; only called after dispatch.cpp has confirmed the host
+// supports it and the kernel has granted this process the tile state.
+//
+// tdpbf16ps computes a 16 x 16 float tile += (16 x 32 bf16) * (32 x 16 bf16),
+// the right-hand tile in k pairs. lana's C is column-major, so the kernel
+// computes C^T = B^T * A^T: B panels, packed k-contiguous per column, are
+// the left tiles, and the k-pair A panels are the right tiles as they are.
+// Four accumulator tiles cover a 32 x 32 block of C; the result is staged
+// through a scratch block so alpha and beta are applied with AVX-512.
+
+#include "kernels/kernels.hpp"
+
+#include <immintrin.h>
+
+namespace lana::detail::amx {
+namespace {
+
+constexpr index_t mr = 32;
+constexpr index_t nr = 32;
+constexpr index_t kblock = 32;
+
+struct alignas(64) TileConfig {
+    std::uint8_t palette;
+    std::uint8_t start_row;
+    std::uint8_t reserved[14];
+    std::uint16_t colsb[16];
+    std::uint8_t rows[16];
+};
+
+const TileConfig& tile_config() {
+    static const TileConfig cfg = [] {
+        TileConfig c{};
+        c.palette = 1;
+        for (int t = 0; t < 8; ++t) {
+            c.colsb[t] = 64;
+            c.rows[t] = 16;
+        }
+        return c;
+    }();
+    return cfg;
+}
+
+void gemm_ukernel(index_t k, const std::uint16_t* LANA_RESTRICT a, const std::uint16_t* LANA_RESTRICT b,
+                  float alpha, float beta, float* LANA_RESTRICT c, index_t ldc) {
+    // Tile configuration is per thread and cheap to reload; doing it on
+    // every call keeps the kernel independent of whatever ran before.
+    _tile_loadconfig(&tile_config());
+    _tile_zero(0);
+    _tile_zero(1);
+    _tile_zero(2);
+    _tile_zero(3);
+    const auto b_stride = static_cast<long>(k * sizeof(std::uint16_t));
+    constexpr long a_stride = 2 * mr * sizeof(std::uint16_t);
+    for (index_t p = 0; p < k; p += kblock) {
+        const std::uint16_t* ap = a + p * mr;
+        const std::uint16_t* bp = b + p;
+        _tile_loadd(4, bp, b_stride);
+        _tile_loadd(5, bp + 16 * k, b_stride);
+        _tile_loadd(6, ap, a_stride);
+        _tile_loadd(7, ap + 32, a_stride);
+        _tile_dpbf16ps(0, 4, 6);
+        _tile_dpbf16ps(1, 4, 7);
+        _tile_dpbf16ps(2, 5, 6);
+        _tile_dpbf16ps(3, 5, 7);
+    }
+    // s[j * mr + i] = (A * B)(i, j).
+    alignas(64) float s[nr * mr];
+    _tile_stored(0, s, mr * sizeof(float));
+    _tile_stored(1, s + 16, mr * sizeof(float));
+    _tile_stored(2, s + 16 * mr, mr * sizeof(float));
+    _tile_stored(3, s + 16 * mr + 16, mr * sizeof(float));
+
+    const __m512 va = _mm512_set1_ps(alpha);
+    if (beta == 0.0f) {
+        for (index_t j = 0; j < nr; ++j) {
+            _mm512_storeu_ps(c + j * ldc, _mm512_mul_ps(va, _mm512_load_ps(s + j * mr)));
+            _mm512_storeu_ps(c + j * ldc + 16, _mm512_mul_ps(va, _mm512_load_ps(s + j * mr + 16)));
+        }
+    } else {
+        const __m512 vb = _mm512_set1_ps(beta);
+        for (index_t j = 0; j < nr; ++j) {
+            for (index_t v = 0; v < mr; v += 16) {
+                float* cp = c + j * ldc + v;
+                _mm512_storeu_ps(cp, _mm512_fmadd_ps(va, _mm512_load_ps(s + j * mr + v),
+                                                     _mm512_mul_ps(vb, _mm512_loadu_ps(cp))));
+            }
+        }
+    }
+}
+
+}  // namespace
+
+const MixedGemmKernel& gemm_bf16_kernel() {
+    static const MixedGemmKernel kern{mr, nr, kblock, true, &gemm_ukernel};
+    return kern;
+}
+
+}  // namespace lana::detail::amx
@@ -0,0 +1,21 @@
+// AVX2/FMA3 kernels. Compiled with the matching target flags; only called after
+// dispatch.cpp has confirmed the host supports them.
+
+#define LANA_KERNEL_NS avx2
+#include "kernels/kernels_impl.hpp"
+
+namespace lana::detail::avx2 {
+
+const KernelTable<float>& kernels_f32() {
+    static const KernelTable<float> table =
+        with_tiles(make_table<float, 2, 6>(Isa::Avx2), Tile<3, 4>{}, Tile<1, 12>{});
+    return table;
+}
+
+const KernelTable<double>& kernels_f64() {
+    static const KernelTable<double> table =
+        with_tiles(make_table<double, 2, 6>(Isa::Avx2), Tile<3, 4>{}, Tile<1, 12>{});
+    return table;
+}
+
+}  // namespace lana::detail::avx2
@@ -0,0 +1,21 @@
+// AVX-512F kernels. Compiled with the matching target flags; only called after
+// dispatch.cpp has confirmed the host supports them.
+
+#define LANA_KERNEL_NS avx512
+#include "kernels/kernels_impl.hpp"
+
+namespace lana::detail::avx512 {
+
+const KernelTable<float>& kernels_f32() {
+    static const KernelTable<float> table =
+        with_tiles(make_table<float, 2, 12>(Isa::Avx512), Tile<3, 8>{}, Tile<4, 6>{}, Tile<1, 24>{});
+    return table;
+}
+
+const KernelTable<double>& kernels_f64() {
+    static const KernelTable<double> table =
+        with_tiles(make_table<double, 2, 12>(Isa::Avx512), Tile<3, 8>{}, Tile<4, 6>{}, Tile<1, 24>{});
+    return table;
+}
+
+}  // namespace lana::detail::avx512
@@ -0,0 +1,79 @@
+// AVX512_BF16 GEMM micro-kernel. Compiled with the matching target flags;
+// only called after dispatch.cpp has confirmed the host supports it.
+//
+// vdpbf16ps multiplies adjacent bfloat16 pairs and adds both products into
+// one float lane, so the packed panels interleave k in pairs: each A load
+// covers 16 rows x 2 k, and B broadcasts one 32-bit pair per column.
+
+#include "kernels/kernels.hpp"
+
+#include <immintrin.h>
+
+#include <cstring>
+
+namespace lana::detail::avx512bf16 {
+namespace {
+
+constexpr int mv = 2;
+constexpr int nr = 12;
+constexpr int mr = mv * 16;
+
+void gemm_ukernel(index_t k, const std::uint16_t* LANA_RESTRICT a, const std::uint16_t* LANA_RESTRICT b,
+                  float alpha, float beta, float* LANA_RESTRICT c, index_t ldc) {
+    __m512 acc[nr][mv];
+#pragma GCC unroll 16
+    for (int j = 0; j < nr; ++j) {
+#pragma GCC unroll 4
+        for (int v = 0; v < mv; ++v) {
+            acc[j][v] = _mm512_setzero_ps();
+        }
+    }
+    for (index_t p = 0; p < k; p += 2) {
+        __m512bh av[mv];
+#pragma GCC unroll 4
+        for (int v = 0; v < mv; ++v) {
+            av[v] = (__m512bh)_mm512_loadu_si512(a + v * 32);
+        }
+#pragma GCC unroll 16
+        for (int j = 0; j < nr; ++j) {
+            std::int32_t pair;
+            std::memcpy(&pair, b + 2 * j, sizeof(pair));
+            const __m512bh bj = (__m512bh)_mm512_set1_epi32(pair);
+#pragma GCC unroll 4
+            for (int v = 0; v < mv; ++v) {
+                acc[j][v] = _mm512_dpbf16_ps(acc[j][v], av[v], bj);
+            }
+        }
+        a += 2 * mr;
+        b += 2 * nr;
+    }
+    const __m512 va = _mm512_set1_ps(alpha);
+    if (beta == 0.0f) {
+#pragma GCC unroll 16
+        for (int j = 0; j < nr; ++j) {
+#pragma GCC unroll 4
+            for (int v = 0; v < mv; ++v) {
+                _mm512_storeu_ps(c + j * ldc + v * 16, _mm512_mul_ps(va, acc[j][v]));
+            }
+        }
+    } else {
+        const __m512 vb = _mm512_set1_ps(beta);
+#pragma GCC unroll 16
+        for (int j = 0; j < nr; ++j) {
+#pragma GCC unroll 4
+            for (int v = 0; v < mv; ++v) {
+                float* cp = c + j * ldc + v * 16;
+                _mm512_storeu_ps(cp, _mm512_fmadd_ps(va, acc[j][v], _mm512_mul_ps(vb, _mm512_loadu_ps(cp))));
+            }
+        }
+    }
+}
+
+}  // namespace
+
+const MixedGemmKernel& gemm_bf16_kernel() {
+    static const MixedGemmKernel kern{mr, nr, 2, false, &gemm_ukernel};
+    return kern;
+}
+
+}  // namespace lana::detail::avx512bf16
@@ -0,0 +1,409 @@
+#pragma once
+
+// ISA-generic kernel bodies, instantiated once per kernel translation unit.
+// The including unit defines LANA_KERNEL_NS and is compiled with matching
+// target flags; see kernels_<isa>.cpp.
+
+#include "kernels/kernels.hpp"
+#include "kernels/simd.hpp"
+
+#include <algorithm>
+
+namespace lana::detail::LANA_KERNEL_NS {
+
+/// Register-blocked micro-kernel with an (MV * lanes) x NR accumulator tile.
+template <typename T, int MV, int NR>
+void gemm_ukernel(index_t k, const T* LANA_RESTRICT a, const T* LANA_RESTRICT b, T beta, T* LANA_RESTRICT c,
+                  index_t ldc) {
+    using V = Vec<T>;
+    constexpr int L = V::lanes;
+    constexpr int MR = MV * L;
+    typename V::reg acc[NR][MV];
+#pragma GCC unroll 16
+    for (int j = 0; j < NR; ++j) {
+#pragma GCC unroll 4
+        for (int v = 0; v < MV; ++v) {
+            acc[j][v] = V::zero();
+        }
+    }
+    for (index_t p = 0; p < k; ++p) {
+        typename V::reg av[MV];
+#pragma GCC unroll 4
+        for (int v = 0; v < MV; ++v) {
+            av[v] = V::load(a + v * L);
+        }
+#pragma GCC unroll 16
+        for (int j = 0; j < NR; ++j) {
+            const typename V::reg bj = V::set1(b[j]);
+#pragma GCC unroll 4
+            for (int v = 0; v < MV; ++v) {
+                acc[j][v] = V::fmadd(av[v], bj, acc[j][v]);
+            }
+        }
+        a += MR;
+        b += NR;
+    }
+    if (beta == T(0)) {
+#pragma GCC unroll 16
+        for (int j = 0; j < NR; ++j) {
+#pragma GCC unroll 4
+            for (int v = 0; v < MV; ++v) {
+                V::store(c + j * ldc + v * L, acc[j][v]);
+            }
+        }
+    } else {
+        const typename V::reg vb = V::set1(beta);
+#pragma GCC unroll 16
+        for (int j = 0; j < NR; ++j) {
+#pragma GCC unroll 4
+            for (int v = 0; v < MV; ++v) {
+                T* cp = c + j * ldc + v * L;
+                V::store(cp, V::fmadd(vb, V::load(cp), acc[j][v]));
+            }
+        }
+    }
+}
+
+template <typename T>
+T dot(index_t n, const T* LANA_RESTRICT x, const T* LANA_RESTRICT y) {
+    using V = Vec<T>;
+    constexpr index_t L = V::lanes;
+    typename V::reg a0 = V::zero(), a1 = V::zero(), a2 = V::zero(), a3 = V::zero();
+    index_t i = 0;
+    for (; i + 4 * L <= n; i += 4 * L) {
+        a0 = V::fmadd(V::load(x + i), V::load(y + i), a0);
+        a1 = V::fmadd(V::load(x + i + L), V::load(y + i + L), a1);
+        a2 = V::fmadd(V::load(x + i + 2 * L), V::load(y + i + 2 * L), a2);
+        a3 = V::fmadd(V::load(x + i + 3 * L), V::load(y + i + 3 * L), a3);
+    }
+    for (; i + L <= n; i += L) {
+        a0 = V::fmadd(V::load(x + i), V::load(y + i), a0);
+    }
+    T s = V::hsum(V::add(V::add(a0, a1), V::add(a2, a3)));
+    for (; i < n; ++i) {
+        s += x[i] * y[i];
+    }
+    return s;
+}
+
+template <typename T>
+void axpy(index_t n, T alpha, const T* LANA_RESTRICT x, T* LANA_RESTRICT y) {
+    using V = Vec<T>;
+    constexpr index_t L = V::lanes;
+    const typename V::reg va = V::set1(alpha);
+    index_t i = 0;
+    for (; i + 2 * L <= n; i += 2 * L) {
+        V::store(y + i, V::fmadd(va, V::load(x + i), V::load(y + i)));
+        V::store(y + i + L, V::fmadd(va, V::load(x + i + L), V::load(y + i + L)));
+    }
+    for (; i + L <= n; i += L) {
+        V::store(y + i, V::fmadd(va, V::load(x + i), V::load(y + i)));
+    }
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+
+template <typename T>
+T sum(index_t n, const T* LANA_RESTRICT x) {
+    using V = Vec<T>;
+    constexpr index_t L = V::lanes;
+    typename V::reg a0 = V::zero(), a1 = V::zero(), a2 = V::zero(), a3 = V::zero();
+    index_t i = 0;
+    for (; i + 4 * L <= n; i += 4 * L) {
+        a0 = V::add(V::load(x + i), a0);
+        a1 = V::add(V::load(x + i + L), a1);
+        a2 = V::add(V::load(x + i + 2 * L), a2);
+        a3 = V::add(V::load(x + i + 3 * L), a3);
+    }
+    for (; i + L <= n; i += L) {
+        a0 = V::add(V::load(x + i), a0);
+    }
+    T s = V::hsum(V::add(V::add(a0, a1), V::add(a2, a3)));
+    for (; i < n; ++i) {
+        s += x[i];
+    }
+    return s;
+}
+
+template <typename T>
+T sumsq(index_t n, const T* LANA_RESTRICT x) {
+    return dot(n, x, x);
+}
+
+/// Fused linear combination with a compile-time term count. No restrict on
+/// y: it is allowed to alias one of the inputs element-for-element.
+template <typename T, int Terms>
+void lincomb_n(index_t n, const T* coeffs, const T* const* xs, T* y) {
+    using V = Vec<T>;
+    constexpr index_t L = V::lanes;
+    typename V::reg vc[Terms];
+    const T* x[Terms];
+#pragma GCC unroll 8
+    for (int t = 0; t < Terms; ++t) {
+        vc[t] = V::set1(coeffs[t]);
+        x[t] = xs[t];
+    }
+    index_t i = 0;
+    for (; i + 2 * L <= n; i += 2 * L) {
+        typename V::reg a0 = V::mul(vc[0], V::load(x[0] + i));
+        typename V::reg a1 = V::mul(vc[0], V::load(x[0] + i + L));
+#pragma GCC unroll 8
+        for (int t = 1; t < Terms; ++t) {
+            a0 = V::fmadd(vc[t], V::load(x[t] + i), a0);
+            a1 = V::fmadd(vc[t], V::load(x[t] + i + L), a1);
+        }
+        V::store(y + i, a0);
+        V::store(y + i + L, a1);
+    }
+    for (; i + L <= n; i += L) {
+        typename V::reg a0 = V::mul(vc[0], V::load(x[0] + i));
+#pragma GCC unroll 8
+        for (int t = 1; t < Terms; ++t) {
+            a0 = V::fmadd(vc[t], V::load(x[t] + i), a0);
+        }
+        V::store(y + i, a0);
+    }
+    for (; i < n; ++i) {
+        T s = coeffs[0] * x[0][i];
+        for (int t = 1; t < Terms; ++t) {
+            s += coeffs[t] * x[t][i];
+        }
+        y[i] = s;
+    }
+}
+
+template <typename T>
+void lincomb(index_t n, int terms, const T* coeffs, const T* const* xs, T* y) {
+    static_assert(lincomb_max_terms == 8, "update the switch below");
+    switch (terms) {
+        case 1: return lincomb_n<T, 1>(n, coeffs, xs, y);
+        case 2: return lincomb_n<T, 2>(n, coeffs, xs, y);
+        case 3: return lincomb_n<T, 3>(n, coeffs, xs, y);
+        case 4: return lincomb_n<T, 4>(n, coeffs, xs, y);
+        case 5: return lincomb_n<T, 5>(n, coeffs, xs, y);
+        case 6: return lincomb_n<T, 6>(n, coeffs, xs, y);
+        case 7: return lincomb_n<T, 7>(n, coeffs, xs, y);
+        default: return lincomb_n<T, 8>(n, coeffs, xs, y);
+    }
+}
+
+template <typename T>
+T sparse_dot(index_t n, const T* LANA_RESTRICT vals, const std::int32_t* LANA_RESTRICT idx, const T* LANA_RESTRICT x) {
+    using V = Vec<T>;
+    constexpr index_t L = V::lanes;
+    index_t i = 0;
+    T s = T(0);
+    if constexpr (requires { V::gather(x, idx); }) {
+        typename V::reg a0 = V::zero(), a1 = V::zero();
+        for (; i + 2 * L <= n; i += 2 * L) {
+            a0 = V::fmadd(V::load(vals + i), V::gather(x, idx + i), a0);
+            a1 = V::fmadd(V::load(vals + i + L), V::gather(x, idx + i + L), a1);
+        }
+        for (; i + L <= n; i += L) {
+            a0 = V::fmadd(V::load(vals + i), V::gather(x, idx + i), a0);
+        }
+        s = V::hsum(V::add(a0, a1));
+    }
+    for (; i < n; ++i) {
+        s += vals[i] * x[idx[i]];
+    }
+    return s;
+}
+
+template <typename T>
+void soa_gemm(index_t m, index_t n, index_t k, index_t groups, T alpha, const T* a, const T* b, T beta, T* c) {
+    using V = Vec<T>;
+    using R = typename V::reg;
+    constexpr index_t L = V::lanes;
+    constexpr index_t G = batched::interleave_width<T>;
+    constexpr index_t MB = 4;
+    static_assert(G % L == 0, "a group must hold whole registers");
+    const R va = V::set1(alpha);
+    const R vb = V::set1(beta);
+    for (index_t g = 0; g < groups; ++g) {
+        for (index_t l = 0; l < G; l += L) {
+            const T* al = a + g * m * k * G + l;
+            const T* bl = b + g * k * n * G + l;
+            T* cl = c + g * m * n * G + l;
+            for (index_t j = 0; j < n; ++j) {
+                // Rows in blocks of MB, so each B element feeds MB accumulators.
+                for (index_t i0 = 0; i0 < m; i0 += MB) {
+                    const index_t mb = std::min(MB, m - i0);
+                    R acc[MB] = {V::zero(), V::zero(), V::zero(), V::zero()};
+                    for (index_t p = 0; p < k; ++p) {
+                        const R bpj = V::load(bl + (p + j * k) * G);
+                        const T* ap = al + (i0 + p * m) * G;
+                        if (mb == MB) {
+#pragma GCC unroll 4
+                            for (index_t i = 0; i < MB; ++i) {
+                                acc[i] = V::fmadd(V::load(ap + i * G), bpj, acc[i]);
+                            }
+                        } else {
+                            for (index_t i = 0; i < mb; ++i) {
+                                acc[i] = V::fmadd(V::load(ap + i * G), bpj, acc[i]);
+                            }
+                        }
+                    }
+                    for (index_t i = 0; i < mb; ++i) {
+                        T* cp = cl + (i0 + i + j * m) * G;
+                        const R r = V::mul(va, acc[i]);
+                        V::store(cp, beta == T(0) ? r : V::fmadd(vb, V::load(cp), r));
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void soa_getrf(index_t n, index_t groups, index_t count, T* a, std::int32_t* ipiv, std::int32_t* info) {
+    using V = Vec<T>;
+    using R = typename V::reg;
+    constexpr index_t L = V::lanes;
+    constexpr index_t G = batched::interleave_width<T>;
+    const R zero = V::zero();
+    const R one = V::set1(T(1));
+    alignas(64) T tmp[L];
+    for (index_t g = 0; g < groups; ++g) {
+        for (index_t l = 0; l < G; l += L) {
+            T* al = a + g * n * n * G + l;
+            auto at = [&](index_t i, index_t j) { return al + (i + j * n) * G; };
+            const index_t b0 = g * G + l;
+            const index_t live = std::clamp<index_t>(count - b0, 0, L);
+            for (index_t b = 0; b < live; ++b) {
+                info[b0 + b] = 0;
+            }
+            for (index_t k = 0; k < n; ++k) {
+                // Per-lane argmax of |A(i, k)| over i >= k, tracked as a T.
+                R best = V::abs(V::load(at(k, k)));
+                R piv = V::set1(T(k));
+                for (index_t i = k + 1; i < n; ++i) {
+                    const R v = V::abs(V::load(at(i, k)));
+                    const typename V::mask gt = V::gt(v, best);
+                    best = V::select(gt, v, best);
+                    piv = V::select(gt, V::set1(T(i)), piv);
+                }
+                V::store(tmp, piv);
+                bool swap = false;
+                for (index_t b = 0; b < L; ++b) {
+                    const auto p = static_cast<index_t>(tmp[b]);
+                    if (b < live) {
+                        ipiv[(b0 + b) * n + k] = static_cast<std::int32_t>(p);
+                    }
+                    swap |= p != k;
+                }
+                // Lanes pivot on different rows, so the swap runs as masked
+                // selects over every candidate row.
+                if (swap) {
+                    for (index_t j = 0; j < n; ++j) {
+                        const R rk = V::load(at(k, j));
+                        R nk = rk;
+                        for (index_t i = k + 1; i < n; ++i) {
+                            const typename V::mask hit = V::eq(piv, V::set1(T(i)));
+                            const R rij = V::load(at(i, j));
+                            nk = V::select(hit, rij, nk);
+                            V::store(at(i, j), V::select(hit, rk, rij));
+                        }
+                        V::store(at(k, j), nk);
+                    }
+                }
+                const R pk = V::load(at(k, k));
+                V::store(tmp, pk);
+                for (index_t b = 0; b < live; ++b) {
+                    if (tmp[b] == T(0) && info[b0 + b] == 0) {
+                        info[b0 + b] = static_cast<std::int32_t>(k + 1);
+                    }
+                }
+                // A zero pivot means a zero column below it: leave it unscaled.
+                const R inv = V::div(one, V::select(V::eq(pk, zero), one, pk));
+                for (index_t i = k + 1; i < n; ++i) {
+                    V::store(at(i, k), V::mul(V::load(at(i, k)), inv));
+                }
+                for (index_t j = k + 1; j < n; ++j) {
+                    const R u = V::sub(zero, V::load(at(k, j)));
+                    for (index_t i = k + 1; i < n; ++i) {
+                        V::store(at(i, j), V::fmadd(V::load(at(i, k)), u, V::load(at(i, j))));
+                    }
+                }
+            }
+        }
+    }
+}
+
+template <typename T>
+void soa_potrf(index_t n, index_t groups, index_t count, T* a, std::int32_t* info) {
+    using V = Vec<T>;
+    using R = typename V::reg;
+    constexpr index_t L = V::lanes;
+    constexpr index_t G = batched::interleave_width<T>;
+    const R zero = V::zero();
+    const R one = V::set1(T(1));
+    alignas(64) T tmp[L];
+    for (index_t g = 0; g < groups; ++g) {
+        for (index_t l = 0; l < G; l += L) {
+            T* al = a + g * n * n * G + l;
+            auto at = [&](index_t i, index_t j) { return al + (i + j * n) * G; };
+            const index_t b0 = g * G + l;
+            const index_t live = std::clamp<index_t>(count - b0, 0, L);
+            for (index_t b = 0; b < live; ++b) {
+                info[b0 + b] = 0;
+            }
+            for (index_t j = 0; j < n; ++j) {
+                const R d = V::load(at(j, j));
+                V::store(tmp, d);
+                for (index_t b = 0; b < live; ++b) {
+                    if (!(tmp[b] > T(0)) && info[b0 + b] == 0) {
+                        info[b0 + b] = static_cast<std::int32_t>(j + 1);
+                    }
+                }
+                const R r = V::sqrt(d);
+                V::store(at(j, j), r);
+                const R inv = V::div(one, r);
+                for (index_t i = j + 1; i < n; ++i) {
+                    V::store(at(i, j), V::mul(V::load(at(i, j)), inv));
+                }
+                for (index_t k = j + 1; k < n; ++k) {
+                    const R u = V::sub(zero, V::load(at(k, j)));
+                    for (index_t i = k; i < n; ++i) {
+                        V::store(at(i, k), V::fmadd(V::load(at(i, j)), u, V::load(at(i, k))));
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Table whose GEMM micro-kernel is (MV * lanes) x NR.
+template <typename T, int MV, int NR>
+KernelTable<T> make_table(Isa isa) {
+    static_assert(MV * Vec<T>::lanes * NR <= max_tile_elems, "micro-kernel tile too large");
+    KernelTable<T> t{};
+    t.isa = isa;
+    t.gemm = {MV * Vec<T>::lanes, NR, &gemm_ukernel<T, MV, NR>};
+    t.dot = &dot<T>;
+    t.axpy = &axpy<T>;
+    t.sum = &sum<T>;
+    t.sumsq = &sumsq<T>;
+    t.lincomb = &lincomb<T>;
+    t.sparse_dot = &sparse_dot<T>;
+    t.soa_gemm = &soa_gemm<T>;
+    t.soa_getrf = &soa_getrf<T>;
+    t.soa_potrf = &soa_potrf<T>;
+    return t;
+}
+
+template <int MV, int NR>
+struct Tile {};
+
+/// `t` with the given (MV * lanes) x NR tiles as its alternative GEMM kernels.
+template <typename T, int... MV, int... NR>
+KernelTable<T> with_tiles(KernelTable<T> t, Tile<MV, NR>...) {
+    static_assert(sizeof...(MV) <= gemm_alt_max, "too many alternative tiles");
+    static_assert(((MV * Vec<T>::lanes * NR <= max_tile_elems) && ...), "micro-kernel tile too large");
+    int i = 0;
+    ((t.gemm_alt[i++] = GemmKernel<T>{MV * Vec<T>::lanes, NR, &gemm_ukernel<T, MV, NR>}), ...);
+    return t;
+}
+
+}  // namespace lana::detail::LANA_KERNEL_NS
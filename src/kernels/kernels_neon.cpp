@@ -0,0 +1,21 @@
+// NEON kernels. Compiled with the matching target flags; only called after
+// dispatch.cpp has confirmed the host supports them.
+
+#define LANA_KERNEL_NS neon
+#include "kernels/kernels_impl.hpp"
+
+namespace lana::detail::neon {
+
+const KernelTable<float>& kernels_f32() {
+    static const KernelTable<float> table =
+        with_tiles(make_table<float, 2, 12>(Isa::Neon), Tile<3, 8>{}, Tile<4, 6>{});
+    return table;
+}
+
+const KernelTable<double>& kernels_f64() {
+    static const KernelTable<double> table =
+        with_tiles(make_table<double, 3, 8>(Isa::Neon), Tile<2, 12>{}, Tile<4, 6>{});
+    return table;
+}
+
+}  // namespace lana::detail::neon
@@ -0,0 +1,34 @@
+// Portable kernels, built for the baseline target of every architecture.
+// The GEMM micro-kernel is the plain C++ one, which the compiler vectorizes
+// for whatever baseline SIMD the target guarantees.
+
+#define LANA_KERNEL_NS scalar
+#include "kernels/gemm_generic.hpp"
+#include "kernels/kernels_impl.hpp"
+
+namespace lana::detail::scalar {
+
+namespace {
+
+template <typename T>
+KernelTable<T> make_scalar_table() {
+    constexpr int mr = 64 / sizeof(T);
+    constexpr int nr = 4;
+    KernelTable<T> t = make_table<T, 1, 1>(Isa::Scalar);
+    t.gemm = {mr, nr, &gemm_ukernel_generic<T, mr, nr>};
+    return t;
+}
+
+}  // namespace
+
+const KernelTable<float>& kernels_f32() {
+    static const KernelTable<float> table = make_scalar_table<float>();
+    return table;
+}
+
+const KernelTable<double>& kernels_f64() {
+    static const KernelTable<double> table = make_scalar_table<double>();
+    return table;
+}
+
+}  // namespace lana::detail::scalar
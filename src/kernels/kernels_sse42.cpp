@@ -0,0 +1,21 @@
+// SSE4.2 kernels. Compiled with the matching target flags; only called after
+// dispatch.cpp has confirmed the host supports them.
+
+#define LANA_KERNEL_NS sse42
+#include "kernels/kernels_impl.hpp"
+
+namespace lana::detail::sse42 {
+
+const KernelTable<float>& kernels_f32() {
+    static const KernelTable<float> table =
+        with_tiles(make_table<float, 2, 4>(Isa::Sse42), Tile<3, 4>{}, Tile<1, 8>{});
+    return table;
+}
+
+const KernelTable<double>& kernels_f64() {
+    static const KernelTable<double> table =
+        with_tiles(make_table<double, 2, 4>(Isa::Sse42), Tile<3, 4>{}, Tile<1, 8>{});
+    return table;
+}
+
+}  // namespace lana::detail::sse42
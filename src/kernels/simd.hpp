@@ -0,0 +1,277 @@
+#pragma once
+
+// Thin per-ISA vector wrappers used by kernels_impl.hpp.
+//
+// This header is compiled once per kernel translation unit with that unit's
+// target flags, so `Vec<T>` maps to whichever register type the flags
+// enable. select(m, a, b) picks a where the mask from gt()/eq() is set. Only
+// the AVX2 and AVX-512 wrappers provide gather(); kernels test for it with a
+// requires-expression. Everything lives in the namespace named by
+// LANA_KERNEL_NS, which each unit defines: inline functions compiled with
+// different flags must never be merged by the linker.
+
+#include "lana/config.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__AVX512F__) || defined(__AVX2__) || defined(__SSE4_2__)
+#  include <immintrin.h>
+#elif defined(__ARM_NEON)
+#  include <arm_neon.h>
+#endif
+
+#if !defined(LANA_KERNEL_NS)
+#  error "simd.hpp must be included from a kernel unit that defines LANA_KERNEL_NS"
+#endif
+
+namespace lana::detail::LANA_KERNEL_NS {
+
+template <typename T>
+struct Vec;
+
+// GCC 12's x86 headers self-initialize `__Y = __Y` for undefined vectors
+// (used by the AVX-512 kernels and by gathers), which -W(maybe-)uninitialized
+// reports at every inlining site.
+#if (defined(__AVX512F__) || defined(__AVX2__)) && defined(__GNUC__) && !defined(__clang__)
+#  pragma GCC diagnostic ignored "-Wuninitialized"
+#  pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+#if defined(__AVX512F__)
+
+template <>
+struct Vec<float> {
+    using reg = __m512;
+    static constexpr int lanes = 16;
+    static LANA_ALWAYS_INLINE reg zero() { return _mm512_setzero_ps(); }
+    static LANA_ALWAYS_INLINE reg set1(float v) { return _mm512_set1_ps(v); }
+    static LANA_ALWAYS_INLINE reg load(const float* p) { return _mm512_loadu_ps(p); }
+    static LANA_ALWAYS_INLINE void store(float* p, reg v) { _mm512_storeu_ps(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return _mm512_add_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return _mm512_mul_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_ps(a, b, c); }
+    static LANA_ALWAYS_INLINE float hsum(reg v) { return _mm512_reduce_add_ps(v); }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return _mm512_sub_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return _mm512_div_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return _mm512_sqrt_ps(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return _mm512_abs_ps(a); }
+    using mask = __mmask16;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return _mm512_mask_blend_ps(m, b, a); }
+    static LANA_ALWAYS_INLINE reg gather(const float* base, const std::int32_t* idx) {
+        return _mm512_i32gather_ps(_mm512_loadu_si512(idx), base, 4);
+    }
+};
+
+template <>
+struct Vec<double> {
+    using reg = __m512d;
+    static constexpr int lanes = 8;
+    static LANA_ALWAYS_INLINE reg zero() { return _mm512_setzero_pd(); }
+    static LANA_ALWAYS_INLINE reg set1(double v) { return _mm512_set1_pd(v); }
+    static LANA_ALWAYS_INLINE reg load(const double* p) { return _mm512_loadu_pd(p); }
+    static LANA_ALWAYS_INLINE void store(double* p, reg v) { _mm512_storeu_pd(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return _mm512_add_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return _mm512_mul_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return _mm512_fmadd_pd(a, b, c); }
+    static LANA_ALWAYS_INLINE double hsum(reg v) { return _mm512_reduce_add_pd(v); }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return _mm512_sub_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return _mm512_div_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return _mm512_sqrt_pd(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return _mm512_abs_pd(a); }
+    using mask = __mmask8;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return _mm512_mask_blend_pd(m, b, a); }
+    static LANA_ALWAYS_INLINE reg gather(const double* base, const std::int32_t* idx) {
+        return _mm512_i32gather_pd(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx)), base, 8);
+    }
+};
+
+#elif defined(__AVX2__)
+
+template <>
+struct Vec<float> {
+    using reg = __m256;
+    static constexpr int lanes = 8;
+    static LANA_ALWAYS_INLINE reg zero() { return _mm256_setzero_ps(); }
+    static LANA_ALWAYS_INLINE reg set1(float v) { return _mm256_set1_ps(v); }
+    static LANA_ALWAYS_INLINE reg load(const float* p) { return _mm256_loadu_ps(p); }
+    static LANA_ALWAYS_INLINE void store(float* p, reg v) { _mm256_storeu_ps(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return _mm256_add_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return _mm256_mul_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_ps(a, b, c); }
+    static LANA_ALWAYS_INLINE float hsum(reg v) {
+        __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+        s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+        s = _mm_add_ss(s, _mm_movehdup_ps(s));
+        return _mm_cvtss_f32(s);
+    }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return _mm256_sub_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return _mm256_div_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return _mm256_sqrt_ps(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+    using mask = __m256;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return _mm256_blendv_ps(b, a, m); }
+    static LANA_ALWAYS_INLINE reg gather(const float* base, const std::int32_t* idx) {
+        return _mm256_i32gather_ps(base, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(idx)), 4);
+    }
+};
+
+template <>
+struct Vec<double> {
+    using reg = __m256d;
+    static constexpr int lanes = 4;
+    static LANA_ALWAYS_INLINE reg zero() { return _mm256_setzero_pd(); }
+    static LANA_ALWAYS_INLINE reg set1(double v) { return _mm256_set1_pd(v); }
+    static LANA_ALWAYS_INLINE reg load(const double* p) { return _mm256_loadu_pd(p); }
+    static LANA_ALWAYS_INLINE void store(double* p, reg v) { _mm256_storeu_pd(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return _mm256_add_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return _mm256_mul_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return _mm256_fmadd_pd(a, b, c); }
+    static LANA_ALWAYS_INLINE double hsum(reg v) {
+        __m128d s = _mm_add_pd(_mm256_castpd256_pd128(v), _mm256_extractf128_pd(v, 1));
+        return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+    }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return _mm256_sub_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return _mm256_div_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return _mm256_sqrt_pd(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+    using mask = __m256d;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return _mm256_blendv_pd(b, a, m); }
+    static LANA_ALWAYS_INLINE reg gather(const double* base, const std::int32_t* idx) {
+        return _mm256_i32gather_pd(base, _mm_loadu_si128(reinterpret_cast<const __m128i*>(idx)), 8);
+    }
+};
+
+#elif defined(__SSE4_2__)
+
+// SSE4.2 hosts predate FMA3, so fmadd is a separate multiply and add.
+template <>
+struct Vec<float> {
+    using reg = __m128;
+    static constexpr int lanes = 4;
+    static LANA_ALWAYS_INLINE reg zero() { return _mm_setzero_ps(); }
+    static LANA_ALWAYS_INLINE reg set1(float v) { return _mm_set1_ps(v); }
+    static LANA_ALWAYS_INLINE reg load(const float* p) { return _mm_loadu_ps(p); }
+    static LANA_ALWAYS_INLINE void store(float* p, reg v) { _mm_storeu_ps(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return _mm_add_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return _mm_mul_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    static LANA_ALWAYS_INLINE float hsum(reg v) {
+        v = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        v = _mm_add_ss(v, _mm_movehdup_ps(v));
+        return _mm_cvtss_f32(v);
+    }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return _mm_sub_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return _mm_div_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return _mm_sqrt_ps(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+    using mask = __m128;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return _mm_cmpgt_ps(a, b); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return _mm_cmpeq_ps(a, b); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return _mm_blendv_ps(b, a, m); }
+};
+
+template <>
+struct Vec<double> {
+    using reg = __m128d;
+    static constexpr int lanes = 2;
+    static LANA_ALWAYS_INLINE reg zero() { return _mm_setzero_pd(); }
+    static LANA_ALWAYS_INLINE reg set1(double v) { return _mm_set1_pd(v); }
+    static LANA_ALWAYS_INLINE reg load(const double* p) { return _mm_loadu_pd(p); }
+    static LANA_ALWAYS_INLINE void store(double* p, reg v) { _mm_storeu_pd(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return _mm_add_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return _mm_mul_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return _mm_add_pd(_mm_mul_pd(a, b), c); }
+    static LANA_ALWAYS_INLINE double hsum(reg v) { return _mm_cvtsd_f64(_mm_add_sd(v, _mm_unpackhi_pd(v, v))); }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return _mm_sub_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return _mm_div_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return _mm_sqrt_pd(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return _mm_andnot_pd(_mm_set1_pd(-0.0), a); }
+    using mask = __m128d;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return _mm_cmpgt_pd(a, b); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return _mm_cmpeq_pd(a, b); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return _mm_blendv_pd(b, a, m); }
+};
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+template <>
+struct Vec<float> {
+    using reg = float32x4_t;
+    static constexpr int lanes = 4;
+    static LANA_ALWAYS_INLINE reg zero() { return vdupq_n_f32(0.0f); }
+    static LANA_ALWAYS_INLINE reg set1(float v) { return vdupq_n_f32(v); }
+    static LANA_ALWAYS_INLINE reg load(const float* p) { return vld1q_f32(p); }
+    static LANA_ALWAYS_INLINE void store(float* p, reg v) { vst1q_f32(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return vaddq_f32(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return vmulq_f32(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return vfmaq_f32(c, a, b); }
+    static LANA_ALWAYS_INLINE float hsum(reg v) { return vaddvq_f32(v); }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return vsubq_f32(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return vdivq_f32(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return vsqrtq_f32(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return vabsq_f32(a); }
+    using mask = uint32x4_t;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return vcgtq_f32(a, b); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return vceqq_f32(a, b); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return vbslq_f32(m, a, b); }
+};
+
+template <>
+struct Vec<double> {
+    using reg = float64x2_t;
+    static constexpr int lanes = 2;
+    static LANA_ALWAYS_INLINE reg zero() { return vdupq_n_f64(0.0); }
+    static LANA_ALWAYS_INLINE reg set1(double v) { return vdupq_n_f64(v); }
+    static LANA_ALWAYS_INLINE reg load(const double* p) { return vld1q_f64(p); }
+    static LANA_ALWAYS_INLINE void store(double* p, reg v) { vst1q_f64(p, v); }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return vaddq_f64(a, b); }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return vmulq_f64(a, b); }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return vfmaq_f64(c, a, b); }
+    static LANA_ALWAYS_INLINE double hsum(reg v) { return vaddvq_f64(v); }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return vsubq_f64(a, b); }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return vdivq_f64(a, b); }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return vsqrtq_f64(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return vabsq_f64(a); }
+    using mask = uint64x2_t;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return vcgtq_f64(a, b); }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return vceqq_f64(a, b); }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return vbslq_f64(m, a, b); }
+};
+
+#else
+
+// Portable fallback: one lane, left to the compiler's auto-vectorizer.
+template <typename T>
+struct Vec {
+    using reg = T;
+    static constexpr int lanes = 1;
+    static LANA_ALWAYS_INLINE reg zero() { return T(0); }
+    static LANA_ALWAYS_INLINE reg set1(T v) { return v; }
+    static LANA_ALWAYS_INLINE reg load(const T* p) { return *p; }
+    static LANA_ALWAYS_INLINE void store(T* p, reg v) { *p = v; }
+    static LANA_ALWAYS_INLINE reg add(reg a, reg b) { return a + b; }
+    static LANA_ALWAYS_INLINE reg mul(reg a, reg b) { return a * b; }
+    static LANA_ALWAYS_INLINE reg fmadd(reg a, reg b, reg c) { return a * b + c; }
+    static LANA_ALWAYS_INLINE T hsum(reg v) { return v; }
+    static LANA_ALWAYS_INLINE reg sub(reg a, reg b) { return a - b; }
+    static LANA_ALWAYS_INLINE reg div(reg a, reg b) { return a / b; }
+    static LANA_ALWAYS_INLINE reg sqrt(reg a) { return std::sqrt(a); }
+    static LANA_ALWAYS_INLINE reg abs(reg a) { return std::abs(a); }
+    using mask = bool;
+    static LANA_ALWAYS_INLINE mask gt(reg a, reg b) { return a > b; }
+    static LANA_ALWAYS_INLINE mask eq(reg a, reg b) { return a == b; }
+    static LANA_ALWAYS_INLINE reg select(mask m, reg a, reg b) { return m ? a : b; }
+};
+
+#endif
+
+}  // namespace lana::detail::LANA_KERNEL_NS
@@ -0,0 +1,639 @@
+// Optimizer and evaluator behind lana::lazy.
+//
+// eval_into() runs three passes over the recorded graph:
+//
+//   lower    pushes transposes into the inputs (a transposed view is free)
+//            and through products, t(A * B) = t(B) * t(A);
+//   reorder  flattens each chain of products, with its scalars, and rebuilds
+//            it in the order of least flops (the matrix-chain DP);
+//   run      evaluates from the root. A linear combination of products and
+//            other terms becomes GEMMs accumulating into the destination,
+//            with bias and activation in the last one's epilogue; any other
+//            elementwise subtree is one tiled pass over its operands.
+//
+// Every pass is memoized on node identity, so a subexpression shared in the
+// DAG stays shared and is computed once. explain() runs the same passes in
+// a dry mode that logs the steps instead of computing them.
+
+#include "lana/lazy.hpp"
+#include "lana/thread_pool.hpp"
+
+#include "gemm_internal.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <map>
+#include <set>
+#include <sstream>
+#include <vector>
+
+namespace lana::lazy::detail {
+namespace {
+
+template <typename T>
+using NodePtr = std::shared_ptr<const Node<T>>;
+
+/// Rows per slice of the elementwise pass; one slice of every intermediate
+/// stays in L1.
+constexpr index_t slice_rows = 256;
+
+/// Slices per task of the elementwise pass.
+constexpr index_t slices_per_task = 32;
+
+template <typename T>
+NodePtr<T> share(Node<T> n) {
+    return std::make_shared<const Node<T>>(std::move(n));
+}
+
+template <typename T>
+class Planner {
+public:
+    /// Logs to `log` instead of computing when it is non-null.
+    explicit Planner(std::ostringstream* log = nullptr) : log_(log) {}
+
+    void eval(const Expr<T>& e, MatrixView<T> dst) {
+        lana::detail::require_dims(dst.rows() == e.rows() && dst.cols() == e.cols(), "lazy eval");
+        const NodePtr<T> root = reorder(lower(e.node(), false));
+        count_parents(root);  // of the final graph, for run()
+        run(root, dst, "out");
+    }
+
+private:
+    // ---- lower: transposes into the inputs ----
+
+    NodePtr<T> lower(const NodePtr<T>& n, bool tr) {
+        const auto key = std::make_pair(n.get(), tr);
+        if (auto it = lowered_.find(key); it != lowered_.end()) {
+            return it->second;
+        }
+        NodePtr<T> out = lower_uncached(n, tr);
+        lowered_.emplace(key, out);
+        return out;
+    }
+
+    NodePtr<T> lower_uncached(const NodePtr<T>& n, bool tr) {
+        Node<T> out = *n;
+        switch (n->kind) {
+        case Kind::Input:
+            if (!tr) {
+                return n;
+            }
+            out.input = n->input.t();
+            out.transposed = !n->transposed;
+            break;
+        case Kind::Transpose:
+            return lower(n->lhs, !tr);
+        case Kind::Product:
+            if (tr) {
+                out.lhs = lower(n->rhs, true);
+                out.rhs = lower(n->lhs, true);
+            } else {
+                out.lhs = lower(n->lhs, false);
+                out.rhs = lower(n->rhs, false);
+            }
+            break;
+        case Kind::Add:
+        case Kind::CwiseMul:
+            out.lhs = lower(n->lhs, tr);
+            out.rhs = lower(n->rhs, tr);
+            break;
+        case Kind::Scale:
+        case Kind::Activate:
+            out.lhs = lower(n->lhs, tr);
+            break;
+        case Kind::Bias:
+            out.lhs = lower(n->lhs, tr);
+            out.per_row = tr ? !n->per_row : n->per_row;
+            break;
+        case Kind::Sum:
+            out.lhs = lower(n->lhs, false);
+            return out.lhs == n->lhs ? n : share(std::move(out));
+        }
+        if (tr) {
+            std::swap(out.rows, out.cols);
+        } else if (out.lhs == n->lhs && out.rhs == n->rhs) {
+            return n;
+        }
+        return share(std::move(out));
+    }
+
+    // ---- reorder: matrix-chain order ----
+
+    /// Parents of every node of the graph rooted at `n`.
+    void count_parents(const NodePtr<T>& n) {
+        if (!seen_.insert(n.get()).second) {
+            return;
+        }
+        for (const NodePtr<T>* c : {&n->lhs, &n->rhs}) {
+            if (*c) {
+                ++parents_[c->get()];
+                count_parents(*c);
+            }
+        }
+    }
+
+    NodePtr<T> reorder(const NodePtr<T>& root) {
+        count_parents(root);
+        NodePtr<T> out = reorder_node(root);
+        seen_.clear();
+        parents_.clear();
+        return out;
+    }
+
+    NodePtr<T> reorder_node(const NodePtr<T>& n) {
+        if (auto it = reordered_.find(n.get()); it != reordered_.end()) {
+            return it->second;
+        }
+        NodePtr<T> out;
+        if (n->kind == Kind::Product) {
+            std::vector<NodePtr<T>> factors;
+            T coef = T(1);
+            collect_factors(n, true, factors, coef);
+            out = chain(factors);
+            if (coef != T(1)) {
+                Node<T> s;
+                s.kind = Kind::Scale;
+                s.rows = out->rows;
+                s.cols = out->cols;
+                s.lhs = out;
+                s.scale = coef;
+                out = share(std::move(s));
+            }
+        } else if (n->lhs) {
+            Node<T> m = *n;
+            m.lhs = reorder_node(n->lhs);
+            if (n->rhs) {
+                m.rhs = reorder_node(n->rhs);
+            }
+            out = m.lhs == n->lhs && m.rhs == n->rhs ? n : share(std::move(m));
+        } else {
+            out = n;
+        }
+        reordered_.emplace(n.get(), out);
+        return out;
+    }
+
+    /// Splits a product chain into its factors and scalar; products and
+    /// scalings used elsewhere in the graph are kept whole.
+    void collect_factors(const NodePtr<T>& n, bool top, std::vector<NodePtr<T>>& factors, T& coef) {
+        const bool own = top || parents_[n.get()] == 1;
+        if (n->kind == Kind::Product && own) {
+            collect_factors(n->lhs, false, factors, coef);
+            collect_factors(n->rhs, false, factors, coef);
+        } else if (n->kind == Kind::Scale && own) {
+            coef *= n->scale;
+            collect_factors(n->lhs, false, factors, coef);
+        } else {
+            factors.push_back(reorder_node(n));
+        }
+    }
+
+    /// The factors' product, parenthesized for the fewest multiply-adds.
+    static NodePtr<T> chain(const std::vector<NodePtr<T>>& f) {
+        const std::size_t k = f.size();
+        std::vector<double> dim(k + 1);
+        for (std::size_t i = 0; i < k; ++i) {
+            dim[i] = static_cast<double>(f[i]->rows);
+        }
+        dim[k] = static_cast<double>(f[k - 1]->cols);
+        // cost[i][j]: cheapest product of f[i..j]; split[i][j]: its last split.
+        std::vector<std::vector<double>> cost(k, std::vector<double>(k, 0.0));
+        std::vector<std::vector<std::size_t>> split(k, std::vector<std::size_t>(k, 0));
+        for (std::size_t len = 2; len <= k; ++len) {
+            for (std::size_t i = 0; i + len <= k; ++i) {
+                const std::size_t j = i + len - 1;
+                cost[i][j] = std::numeric_limits<double>::infinity();
+                for (std::size_t s = i; s < j; ++s) {
+                    const double c = cost[i][s] + cost[s + 1][j] + dim[i] * dim[s + 1] * dim[j + 1];
+                    if (c < cost[i][j]) {
+                        cost[i][j] = c;
+                        split[i][j] = s;
+                    }
+                }
+            }
+        }
+        return build(f, split, 0, k - 1);
+    }
+
+    static NodePtr<T> build(const std::vector<NodePtr<T>>& f, const std::vector<std::vector<std::size_t>>& split,
+                            std::size_t i, std::size_t j) {
+        if (i == j) {
+            return f[i];
+        }
+        Node<T> p;
+        p.kind = Kind::Product;
+        p.lhs = build(f, split, i, split[i][j]);
+        p.rhs = build(f, split, split[i][j] + 1, j);
+        p.rows = p.lhs->rows;
+        p.cols = p.rhs->cols;
+        return share(std::move(p));
+    }
+
+    // ---- run ----
+
+    struct Term {
+        T coef;
+        NodePtr<T> node;
+    };
+
+    /// Flattens sums and scalings into coef * node terms.
+    static void collect_terms(const NodePtr<T>& n, T coef, std::vector<Term>& terms) {
+        if (n->kind == Kind::Add) {
+            collect_terms(n->lhs, coef, terms);
+            collect_terms(n->rhs, coef, terms);
+        } else if (n->kind == Kind::Scale) {
+            collect_terms(n->lhs, coef * n->scale, terms);
+        } else {
+            terms.push_back({coef, n});
+        }
+    }
+
+    void run(const NodePtr<T>& n, MatrixView<T> dst, const std::string& dst_name) {
+        if (n->kind == Kind::Sum) {
+            Program prog(*this);
+            prog.reduce(n->lhs, dst, dst_name);
+            return;
+        }
+        // act(sum of terms + bias) with at least one product among the
+        // terms runs as GEMMs; the last carries the bias and activation.
+        NodePtr<T> body = n;
+        Activation act = Activation::None;
+        const Node<T>* bias = nullptr;
+        if (body->kind == Kind::Activate) {
+            act = body->act;
+            body = body->lhs;
+        }
+        if (body->kind == Kind::Bias) {
+            bias = body.get();
+            body = body->lhs;
+        }
+        std::vector<Term> terms;
+        collect_terms(body, T(1), terms);
+        std::vector<Term> products;
+        std::vector<Term> rest;
+        for (const Term& tm : terms) {
+            // A product with other consumers is computed once, as an operand
+            // (unless this call is the one computing it).
+            const bool own =
+                tm.node->kind == Kind::Product && (tm.node == n || parents_[tm.node.get()] <= 1);
+            (own ? products : rest).push_back(tm);
+        }
+        if (products.empty()) {
+            Program prog(*this);
+            prog.store(n, dst, dst_name);
+            return;
+        }
+
+        T beta = T(0);
+        if (!rest.empty()) {
+            Program prog(*this);
+            prog.store_terms(rest, dst, dst_name);
+            beta = T(1);
+        }
+        GemmEpilogue<T> ep;
+        ep.act = act;
+        if (bias != nullptr) {
+            (bias->per_row ? ep.row_bias : ep.col_bias) = contiguous(bias->bias);
+        }
+        const bool has_epilogue = act != Activation::None || bias != nullptr;
+        for (std::size_t i = 0; i < products.size(); ++i) {
+            const Term& p = products[i];
+            const MatrixView<const T> a = operand(p.node->lhs);
+            const MatrixView<const T> b = operand(p.node->rhs);
+            const bool last = i + 1 == products.size();
+            if (log_ != nullptr) {
+                *log_ << dst_name << " = gemm(" << p.coef << ", " << name(p.node->lhs) << ", " << name(p.node->rhs)
+                      << ", beta=" << beta << ")";
+                if (last && bias != nullptr) {
+                    *log_ << " +bias(" << (bias->per_row ? "row" : "col") << ")";
+                }
+                if (last && act != Activation::None) {
+                    *log_ << " +" << act_name(act);
+                }
+                *log_ << '\n';
+            } else if (last && has_epilogue) {
+                gemm(p.coef, a, b, beta, dst, ep);
+            } else {
+                gemm(p.coef, a, b, beta, dst);
+            }
+            beta = T(1);
+        }
+    }
+
+    /// The node as a readable view: inputs as they are, anything else
+    /// evaluated once into a temporary.
+    MatrixView<const T> operand(const NodePtr<T>& n) {
+        if (n->kind == Kind::Input) {
+            return n->input;
+        }
+        if (auto it = temps_.find(n.get()); it != temps_.end()) {
+            return it->second.view();
+        }
+        std::string nm = std::to_string(names_.size());
+        nm.insert(nm.begin(), 't');
+        names_.emplace(n.get(), nm);
+        Matrix<T>& m = temps_.emplace(n.get(), log_ != nullptr ? Matrix<T>() : Matrix<T>(n->rows, n->cols, uninitialized))
+                           .first->second;
+        run(n, m.view(), nm);
+        return m.view();
+    }
+
+    const T* contiguous(VectorView<const T> v) {
+        if (v.stride() == 1) {
+            return v.data();
+        }
+        return biases_.emplace_back(v).data();
+    }
+
+    std::string name(const NodePtr<T>& n) const {
+        if (n->kind == Kind::Input) {
+            std::ostringstream os;
+            os << "in[" << n->rows << "x" << n->cols << "]" << (n->transposed ? "^T" : "");
+            return os.str();
+        }
+        auto it = names_.find(n.get());
+        return it != names_.end() ? it->second : "?";
+    }
+
+    static const char* act_name(Activation act) {
+        switch (act) {
+        case Activation::Relu:
+            return "relu";
+        case Activation::Sigmoid:
+            return "sigmoid";
+        case Activation::Tanh:
+            return "tanh";
+        case Activation::Gelu:
+            return "gelu";
+        case Activation::None:
+            break;
+        }
+        return "none";
+    }
+
+    /// One elementwise pass: the subtree compiled to a list of ops over
+    /// slices of slice_rows elements, run slice by slice so intermediates
+    /// never leave L1. Products, sums and other non-elementwise nodes enter
+    /// as operands.
+    class Program {
+    public:
+        explicit Program(Planner& p) : planner_(p) {}
+
+        void store(const NodePtr<T>& n, MatrixView<T> dst, const std::string& dst_name) {
+            const int out = compile(n);
+            describe(dst_name, out);
+            execute(out, n->rows, n->cols, [&](index_t i0, index_t len, index_t j, const T* v, index_t) {
+                for (index_t i = 0; i < len; ++i) {
+                    dst(i0 + i, j) = v[i];
+                }
+            });
+        }
+
+        /// dst = sum of coef * node over `terms`.
+        void store_terms(const std::vector<Term>& terms, MatrixView<T> dst, const std::string& dst_name) {
+            int acc = -1;
+            for (const Term& tm : terms) {
+                int slot = compile(tm.node);
+                if (tm.coef != T(1)) {
+                    slot = push(Kind::Scale, slot, -1, tm.coef);
+                }
+                acc = acc < 0 ? slot : push(Kind::Add, acc, slot);
+            }
+            describe(dst_name, acc);
+            execute(acc, dst.rows(), dst.cols(), [&](index_t i0, index_t len, index_t j, const T* v, index_t) {
+                for (index_t i = 0; i < len; ++i) {
+                    dst(i0 + i, j) = v[i];
+                }
+            });
+        }
+
+        /// dst(0, 0) = sum of every element of n.
+        void reduce(const NodePtr<T>& n, MatrixView<T> dst, const std::string& dst_name) {
+            const int out = compile(n);
+            if (planner_.log_ != nullptr) {
+                *planner_.log_ << dst_name << " = sum(" << text(out) << ")\n";
+                return;
+            }
+            const index_t slices = (n->rows + slice_rows - 1) / slice_rows;
+            std::vector<T> partial(static_cast<std::size_t>(slices * n->cols), T(0));
+            execute(out, n->rows, n->cols, [&](index_t, index_t len, index_t j, const T* v, index_t slice) {
+                T s = T(0);
+                for (index_t i = 0; i < len; ++i) {
+                    s += v[i];
+                }
+                partial[static_cast<std::size_t>(j * slices + slice)] = s;
+            });
+            // Fixed summation order, whatever the task split was.
+            T total = T(0);
+            for (T p : partial) {
+                total += p;
+            }
+            dst(0, 0) = total;
+        }
+
+    private:
+        struct Op {
+            Kind kind = Kind::Input;
+            int a = -1;
+            int b = -1;
+            T scale = T(1);
+            Activation act = Activation::None;
+            VectorView<const T> bias;
+            bool per_row = true;
+            MatrixView<const T> src;  // Input
+            std::string name;         // Input
+        };
+
+        int push(Op op) {
+            ops_.push_back(std::move(op));
+            return static_cast<int>(ops_.size()) - 1;
+        }
+
+        int push(Kind kind, int a, int b = -1, T scale = T(1)) {
+            Op op;
+            op.kind = kind;
+            op.a = a;
+            op.b = b;
+            op.scale = scale;
+            return push(std::move(op));
+        }
+
+        int compile(const NodePtr<T>& n) {
+            if (auto it = slots_.find(n.get()); it != slots_.end()) {
+                return it->second;
+            }
+            int slot;
+            switch (n->kind) {
+            case Kind::Add:
+            case Kind::CwiseMul: {
+                const int a = compile(n->lhs);
+                const int b = compile(n->rhs);
+                slot = push(n->kind, a, b);
+                break;
+            }
+            case Kind::Scale:
+                slot = push(Kind::Scale, compile(n->lhs), -1, n->scale);
+                break;
+            case Kind::Activate:
+            case Kind::Bias: {
+                Op op;
+                op.kind = n->kind;
+                op.a = compile(n->lhs);
+                op.act = n->act;
+                op.bias = n->bias;
+                op.per_row = n->per_row;
+                slot = push(std::move(op));
+                break;
+            }
+            default: {
+                Op op;
+                op.src = planner_.operand(n);
+                op.name = planner_.name(n);
+                slot = push(std::move(op));
+                break;
+            }
+            }
+            slots_.emplace(n.get(), slot);
+            return slot;
+        }
+
+        std::string text(int slot) const {
+            const Op& op = ops_[static_cast<std::size_t>(slot)];
+            std::ostringstream os;
+            switch (op.kind) {
+            case Kind::Add:
+                os << "(" << text(op.a) << " + " << text(op.b) << ")";
+                break;
+            case Kind::CwiseMul:
+                os << "(" << text(op.a) << " .* " << text(op.b) << ")";
+                break;
+            case Kind::Scale:
+                os << op.scale << "*" << text(op.a);
+                break;
+            case Kind::Activate:
+                os << act_name(op.act) << "(" << text(op.a) << ")";
+                break;
+            case Kind::Bias:
+                os << "(" << text(op.a) << " +bias(" << (op.per_row ? "row" : "col") << "))";
+                break;
+            default:
+                os << op.name;
+                break;
+            }
+            return os.str();
+        }
+
+        void describe(const std::string& dst_name, int out) const {
+            if (planner_.log_ != nullptr) {
+                *planner_.log_ << dst_name << " = " << text(out) << '\n';
+            }
+        }
+
+        /// Calls sink(i0, len, j, values, slice) for every slice of the
+        /// rows x cols result held in `out`, in parallel over slices.
+        template <typename Sink>
+        void execute(int out, index_t rows, index_t cols, Sink&& sink) const {
+            if (planner_.log_ != nullptr || rows == 0 || cols == 0) {
+                return;
+            }
+            const index_t slices = (rows + slice_rows - 1) / slice_rows;
+            parallel_for(0, slices * cols, slices_per_task, [&](index_t lo, index_t hi) {
+                std::vector<T> buf(ops_.size() * static_cast<std::size_t>(slice_rows));
+                for (index_t s = lo; s < hi; ++s) {
+                    const index_t j = s / slices;
+                    const index_t i0 = (s % slices) * slice_rows;
+                    const index_t len = std::min(slice_rows, rows - i0);
+                    for (std::size_t k = 0; k < ops_.size(); ++k) {
+                        slice(ops_[k], buf.data(), buf.data() + k * slice_rows, i0, len, j);
+                    }
+                    sink(i0, len, j, buf.data() + static_cast<std::size_t>(out) * slice_rows, s % slices);
+                }
+            });
+        }
+
+        static void slice(const Op& op, T* buf, T* LANA_RESTRICT y, index_t i0, index_t len, index_t j) {
+            const T* a = op.a >= 0 ? buf + op.a * slice_rows : nullptr;
+            const T* b = op.b >= 0 ? buf + op.b * slice_rows : nullptr;
+            switch (op.kind) {
+            case Kind::Add:
+                for (index_t i = 0; i < len; ++i) {
+                    y[i] = a[i] + b[i];
+                }
+                break;
+            case Kind::CwiseMul:
+                for (index_t i = 0; i < len; ++i) {
+                    y[i] = a[i] * b[i];
+                }
+                break;
+            case Kind::Scale:
+                for (index_t i = 0; i < len; ++i) {
+                    y[i] = op.scale * a[i];
+                }
+                break;
+            case Kind::Activate:
+                lana::detail::with_activation(op.act, [&](auto act) {
+                    for (index_t i = 0; i < len; ++i) {
+                        y[i] = lana::detail::activate<decltype(act)::value>(a[i]);
+                    }
+                });
+                break;
+            case Kind::Bias:
+                if (op.per_row) {
+                    for (index_t i = 0; i < len; ++i) {
+                        y[i] = a[i] + op.bias[i0 + i];
+                    }
+                } else {
+                    for (index_t i = 0; i < len; ++i) {
+                        y[i] = a[i] + op.bias[j];
+                    }
+                }
+                break;
+            default: {
+                const MatrixView<const T> src = op.src.block(i0, j, len, 1);
+                if (src.row_stride() == 1) {
+                    std::copy_n(src.data(), len, y);
+                } else {
+                    for (index_t i = 0; i < len; ++i) {
+                        y[i] = src(i, 0);
+                    }
+                }
+                break;
+            }
+            }
+        }
+
+        Planner& planner_;
+        std::vector<Op> ops_;
+        std::map<const Node<T>*, int> slots_;
+    };
+
+    std::ostringstream* log_;
+    std::map<std::pair<const Node<T>*, bool>, NodePtr<T>> lowered_;
+    std::map<const Node<T>*, NodePtr<T>> reordered_;
+    std::set<const Node<T>*> seen_;
+    std::map<const Node<T>*, int> parents_;
+    std::map<const Node<T>*, Matrix<T>> temps_;
+    std::map<const Node<T>*, std::string> names_;
+    std::deque<Vector<T>> biases_;
+};
+
+template <typename T>
+std::string explain_impl(const Expr<T>& e) {
+    std::ostringstream log;
+    Planner<T>(&log).eval(e, MatrixView<T>(nullptr, e.rows(), e.cols(), 1, e.rows()));
+    return log.str();
+}
+
+}  // namespace
+}  // namespace lana::lazy::detail
+
+namespace lana::lazy {
+
+void eval_into(const Expr<float>& e, MatrixView<float> dst) { detail::Planner<float>().eval(e, dst); }
+void eval_into(const Expr<double>& e, MatrixView<double> dst) { detail::Planner<double>().eval(e, dst); }
+
+std::string explain(const Expr<float>& e) { return detail::explain_impl(e); }
+std::string explain(const Expr<double>& e) { return detail::explain_impl(e); }
+
+}  // namespace lana::lazy
@@ -0,0 +1,320 @@
+#include "lana/memory.hpp"
+#include "lana/thread_pool.hpp"
+
+#include "topology.hpp"
+
+#include <array>
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__linux__)
+#  include <sys/mman.h>
+#  include <sys/syscall.h>
+#  include <unistd.h>
+#endif
+
+// Policy allocations are anonymous mappings whose length is the request
+// rounded up to the requested page size, whatever pages the kernel ended up
+// providing, so policy_free can recompute it. Explicit huge pages fall back
+// 1 GiB -> 2 MiB -> transparent when none are reserved; the NUMA policy is
+// set with mbind (the raw syscall: libnuma is not a dependency) before any
+// page is touched, since placement happens at first touch.
+
+namespace lana {
+
+void* aligned_alloc(std::size_t bytes, std::size_t alignment) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    if (alignment < sizeof(void*)) {
+        alignment = sizeof(void*);
+    }
+    void* p = nullptr;
+    if (posix_memalign(&p, alignment, bytes) != 0) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void aligned_free(void* p) noexcept { std::free(p); }
+
+namespace {
+
+constexpr std::size_t small_page_bytes = std::size_t(4) << 10;
+constexpr std::size_t page_2m_bytes = std::size_t(2) << 20;
+constexpr std::size_t page_1g_bytes = std::size_t(1) << 30;
+
+std::size_t round_up(std::size_t x, std::size_t a) { return (x + a - 1) / a * a; }
+
+std::size_t page_bytes(PageSize pages) {
+    switch (pages) {
+        case PageSize::Transparent:
+        case PageSize::Huge2M:
+            return page_2m_bytes;
+        case PageSize::Huge1G:
+            return page_1g_bytes;
+        case PageSize::Default:
+            break;
+    }
+    return small_page_bytes;
+}
+
+#if defined(__linux__)
+
+#  ifndef MAP_HUGE_SHIFT
+#    define MAP_HUGE_SHIFT 26
+#  endif
+
+/// MAP_HUGETLB mapping of `bytes` (a multiple of 1 << shift) in pages of
+/// 1 << shift bytes, or nullptr when the pool has none to give.
+void* map_hugetlb(std::size_t bytes, int shift) {
+#  ifdef MAP_HUGETLB
+    void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+                     MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | (shift << MAP_HUGE_SHIFT), -1, 0);
+    return p == MAP_FAILED ? nullptr : p;
+#  else
+    (void)bytes;
+    (void)shift;
+    return nullptr;
+#  endif
+}
+
+/// `bytes` of anonymous memory aligned to `align`, trimmed from an
+/// over-sized mapping, with a transparent-huge-page hint when `hint`.
+void* map_aligned(std::size_t bytes, std::size_t align, bool hint) {
+    const std::size_t span = bytes + (align > small_page_bytes ? align : 0);
+    void* p = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        return nullptr;
+    }
+    const auto base = reinterpret_cast<std::uintptr_t>(p);
+    const std::uintptr_t aligned = round_up(base, align);
+    if (aligned > base) {
+        ::munmap(p, aligned - base);
+    }
+    if (const std::size_t tail = base + span - (aligned + bytes); tail > 0) {
+        ::munmap(reinterpret_cast<void*>(aligned + bytes), tail);
+    }
+#  ifdef MADV_HUGEPAGE
+    if (hint) {
+        ::madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+    }
+#  else
+    (void)hint;
+#  endif
+    return reinterpret_cast<void*>(aligned);
+}
+
+/// Applies policy.numa to [p, p + bytes); false if the kernel refused.
+bool bind_numa(void* p, std::size_t bytes, const AllocPolicy& policy) {
+    const int nodes = detail::host_topology().num_nodes;
+    if (policy.numa == NumaPolicy::Local || (nodes <= 1 && policy.node == 0)) {
+        return true;
+    }
+    if (policy.numa == NumaPolicy::Bind && (policy.node < 0 || policy.node >= nodes)) {
+        return false;
+    }
+    constexpr int bits = 8 * sizeof(unsigned long);
+    std::vector<unsigned long> mask(static_cast<std::size_t>(nodes / bits + 1), 0);
+    for (int n = 0; n < nodes; ++n) {
+        if (policy.numa == NumaPolicy::Interleave || n == policy.node) {
+            mask[static_cast<std::size_t>(n / bits)] |= 1ul << (n % bits);
+        }
+    }
+    constexpr long mpol_bind = 2;
+    constexpr long mpol_interleave = 3;
+    const long mode = policy.numa == NumaPolicy::Interleave ? mpol_interleave : mpol_bind;
+    // maxnode counts one past the highest bit the kernel should read.
+    return ::syscall(SYS_mbind, p, bytes, mode, mask.data(), mask.size() * bits, 0) == 0;
+}
+
+#endif
+
+}  // namespace
+
+void* policy_alloc(std::size_t bytes, const AllocPolicy& policy) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    if (!policy.mapped()) {
+        return detail::pooled_alloc(bytes);
+    }
+#if defined(__linux__)
+    const std::size_t len = round_up(bytes, page_bytes(policy.pages));
+    void* p = nullptr;
+    if (policy.pages == PageSize::Huge1G) {
+        p = map_hugetlb(len, 30);
+    }
+    if (p == nullptr && (policy.pages == PageSize::Huge2M || (policy.pages == PageSize::Huge1G && !policy.strict))) {
+        p = map_hugetlb(len, 21);
+    }
+    if (p == nullptr) {
+        const bool huge = policy.pages != PageSize::Default;
+        if (huge && policy.pages != PageSize::Transparent && policy.strict) {
+            throw std::bad_alloc();
+        }
+        p = map_aligned(len, huge ? page_2m_bytes : small_page_bytes, huge);
+        if (p == nullptr) {
+            throw std::bad_alloc();
+        }
+    }
+    if (!bind_numa(p, len, policy) && policy.strict) {
+        ::munmap(p, len);
+        throw std::bad_alloc();
+    }
+    return p;
+#else
+    // No mappings to place: zeroed ordinary memory keeps the contract.
+    void* p = lana::aligned_alloc(round_up(bytes, small_page_bytes), small_page_bytes);
+    std::memset(p, 0, bytes);
+    return p;
+#endif
+}
+
+void policy_free(void* p, std::size_t bytes, const AllocPolicy& policy) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    if (!policy.mapped()) {
+        detail::pooled_free(p, bytes);
+        return;
+    }
+#if defined(__linux__)
+    ::munmap(p, round_up(bytes, page_bytes(policy.pages)));
+#else
+    lana::aligned_free(p);
+#endif
+}
+
+namespace detail {
+namespace {
+
+// Size classes are powers of two from default_alignment to pooled_max_bytes.
+constexpr int min_class_shift = std::countr_zero(default_alignment);
+constexpr int num_classes = std::countr_zero(pooled_max_bytes) - min_class_shift + 1;
+
+/// Each class caches at most this many bytes (and at least a few blocks).
+constexpr std::size_t class_cache_bytes = std::size_t(256) << 10;
+
+int size_class(std::size_t bytes) noexcept {
+    const int shift = std::bit_width(std::max(bytes, default_alignment) - 1);
+    return shift - min_class_shift;
+}
+
+/// Free list of cached blocks per size class; the link lives in the block.
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct ThreadCache {
+    std::array<FreeBlock*, num_classes> head{};
+    std::array<std::size_t, num_classes> count{};
+
+    ~ThreadCache() { clear(); }
+
+    void clear() noexcept {
+        for (int c = 0; c < num_classes; ++c) {
+            while (FreeBlock* b = head[c]) {
+                head[c] = b->next;
+                lana::aligned_free(b);
+            }
+            count[c] = 0;
+        }
+    }
+};
+
+// The cache object is non-trivially destructible, so it can disappear before
+// other thread-local or static destructors that still free containers; the
+// trivially destructible flag lets those fall through to aligned_free.
+thread_local bool tls_cache_dead = false;
+
+ThreadCache* thread_cache() noexcept {
+    if (tls_cache_dead) {
+        return nullptr;
+    }
+    struct Holder {
+        ThreadCache cache;
+        ~Holder() { tls_cache_dead = true; }
+    };
+    thread_local Holder holder;
+    return &holder.cache;
+}
+
+}  // namespace
+
+void* pooled_alloc(std::size_t bytes) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    if (bytes > pooled_max_bytes) {
+        return lana::aligned_alloc(bytes);
+    }
+    const int c = size_class(bytes);
+    if (ThreadCache* tc = thread_cache(); tc != nullptr && tc->head[c] != nullptr) {
+        FreeBlock* b = tc->head[c];
+        tc->head[c] = b->next;
+        --tc->count[c];
+        return b;
+    }
+    return lana::aligned_alloc(std::size_t(1) << (c + min_class_shift));
+}
+
+void pooled_free(void* p, std::size_t bytes) noexcept {
+    if (p == nullptr) {
+        return;
+    }
+    if (bytes <= pooled_max_bytes) {
+        const int c = size_class(bytes);
+        const std::size_t limit = std::max<std::size_t>(4, class_cache_bytes >> (c + min_class_shift));
+        if (ThreadCache* tc = thread_cache(); tc != nullptr && tc->count[c] < limit) {
+            auto* b = static_cast<FreeBlock*>(p);
+            b->next = tc->head[c];
+            tc->head[c] = b;
+            ++tc->count[c];
+            return;
+        }
+    }
+    lana::aligned_free(p);
+}
+
+void first_touch(void* p, std::size_t bytes, std::size_t unit, bool zero) {
+    if (p == nullptr || bytes == 0) {
+        return;
+    }
+    unit = std::max<std::size_t>(unit, 1);
+    auto* base = static_cast<unsigned char*>(p);
+    const auto touch = [&](std::size_t lo, std::size_t hi) {
+        if (zero) {
+            std::memset(base + lo, 0, hi - lo);
+            return;
+        }
+        // First byte of every page that starts in [lo, hi), plus lo's own.
+        base[lo] = 0;
+        for (std::size_t b = round_up(lo + 1, small_page_bytes); b < hi; b += small_page_bytes) {
+            base[b] = 0;
+        }
+    };
+    // Below a few pages per thread the pool costs more than it places.
+    if (bytes < 16 * small_page_bytes || parallel_concurrency() <= 1) {
+        touch(0, bytes);
+        return;
+    }
+    const auto pieces = static_cast<index_t>((bytes + unit - 1) / unit);
+    parallel_for(0, pieces, 1, [&](index_t lo, index_t hi) {
+        touch(static_cast<std::size_t>(lo) * unit, std::min(bytes, static_cast<std::size_t>(hi) * unit));
+    });
+}
+
+}  // namespace detail
+
+void release_thread_cache() noexcept {
+    if (detail::ThreadCache* tc = detail::thread_cache()) {
+        tc->clear();
+    }
+}
+
+}  // namespace lana
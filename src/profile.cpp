@@ -0,0 +1,363 @@
+// lana::profile counters.
+//
+// Every thread that records owns a fixed table of counter slots, found by
+// open addressing on (kernel, dtype, size bucket). Only the owner writes a
+// table, so updates are plain relaxed load/store pairs with no read-modify-
+// write; snapshot() and reset() read or zero all tables under the registry
+// lock. Tables outlive their threads (counts are kept) and are reused by
+// threads started later.
+
+#include "lana/profile.hpp"
+
+#include "profile_internal.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+
+#if defined(LANA_WITH_ITT)
+#  include <ittnotify.h>
+#endif
+#if defined(LANA_WITH_SDT)
+#  include <sys/sdt.h>
+#endif
+
+namespace lana::profile {
+namespace detail {
+
+constinit std::atomic<State> enabled_state{State::unknown};
+
+bool enabled_from_env() noexcept {
+    const char* env = std::getenv("LANA_PROFILE");
+    const bool on = env != nullptr && *env != '\0' && std::strcmp(env, "0") != 0;
+    State expected = State::unknown;
+    if (enabled_state.compare_exchange_strong(expected, on ? State::on : State::off, std::memory_order_relaxed)) {
+        return on;
+    }
+    return expected == State::on;
+}
+
+namespace {
+
+constexpr int max_kernels = 256;
+constexpr std::size_t slot_count = 1024;
+constexpr int bucket_bits = 6;
+constexpr int dtype_bits = 3;
+
+std::array<std::atomic<const char*>, max_kernels> g_names{};
+std::atomic<int> g_name_count{0};
+std::mutex g_name_mutex;
+
+#if defined(LANA_WITH_ITT)
+__itt_domain* itt_domain() {
+    static __itt_domain* const d = __itt_domain_create("lana");
+    return d;
+}
+std::array<std::atomic<__itt_string_handle*>, max_kernels> g_itt_names{};
+#endif
+
+struct Slot {
+    std::atomic<std::uint32_t> key{0};
+    std::atomic<std::uint64_t> calls{0};
+    std::atomic<std::uint64_t> nanos{0};
+    std::atomic<double> flops{0};
+    std::atomic<double> bytes{0};
+};
+
+constexpr int pool_fields = 8;
+enum PoolField { f_region, f_task, f_steal, f_injected, f_sleep, f_pushes, f_depth_sum, f_depth_max };
+
+struct Table {
+    std::array<Slot, slot_count> slots;
+    std::array<std::atomic<std::uint64_t>, pool_fields> pool{};
+    std::atomic<std::uint64_t> dropped{0};
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<Table>> tables;
+    std::vector<Table*> free;
+};
+
+/// Leaked: threads may still exit (and return tables) during static
+/// destruction.
+Registry& registry() {
+    static Registry* const r = new Registry;
+    return *r;
+}
+
+struct TableLease {
+    Table* table = nullptr;
+    ~TableLease() {
+        if (table != nullptr) {
+            Registry& r = registry();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            r.free.push_back(table);
+        }
+    }
+};
+
+Table& my_table() {
+    thread_local TableLease lease;
+    if (lease.table == nullptr) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        if (!r.free.empty()) {
+            lease.table = r.free.back();
+            r.free.pop_back();
+        } else {
+            r.tables.push_back(std::make_unique<Table>());
+            lease.table = r.tables.back().get();
+        }
+    }
+    return *lease.table;
+}
+
+template <typename T>
+void bump(std::atomic<T>& v, T d) noexcept {
+    v.store(v.load(std::memory_order_relaxed) + d, std::memory_order_relaxed);
+}
+
+/// Bucket b > 0 holds sizes in [2^(b-1), 2^b - 1]; bucket 0 holds size 0.
+int bucket_of(std::int64_t size) noexcept {
+    return size <= 0 ? 0 : std::bit_width(static_cast<std::uint64_t>(size));
+}
+
+std::uint32_t make_key(int id, Dtype dtype, int bucket) noexcept {
+    return (static_cast<std::uint32_t>(id + 1) << (bucket_bits + dtype_bits)) |
+           (static_cast<std::uint32_t>(dtype) << bucket_bits) | static_cast<std::uint32_t>(bucket);
+}
+
+std::atomic<const MarkerHooks*> g_hooks{nullptr};
+
+}  // namespace
+
+int kernel_id(const char* name) {
+    std::lock_guard<std::mutex> lock(g_name_mutex);
+    const int n = g_name_count.load(std::memory_order_relaxed);
+    for (int i = 0; i < n; ++i) {
+        if (std::strcmp(g_names[static_cast<std::size_t>(i)].load(std::memory_order_relaxed), name) == 0) {
+            return i;
+        }
+    }
+    if (n == max_kernels) {
+        return max_kernels - 1;  // shares the last slot rather than failing
+    }
+#if defined(LANA_WITH_ITT)
+    g_itt_names[static_cast<std::size_t>(n)].store(__itt_string_handle_create(name), std::memory_order_relaxed);
+#endif
+    g_names[static_cast<std::size_t>(n)].store(name, std::memory_order_relaxed);
+    g_name_count.store(n + 1, std::memory_order_release);
+    return n;
+}
+
+void record(int id, Dtype dtype, std::int64_t size, double flops, double bytes,
+            std::chrono::steady_clock::duration elapsed) noexcept {
+    Table* t = nullptr;
+    try {
+        t = &my_table();
+    } catch (...) {
+        return;
+    }
+    const std::uint32_t key = make_key(id, dtype, bucket_of(size));
+    const std::size_t h = (key * 2654435761u) >> 22;
+    for (std::size_t probe = 0; probe < slot_count; ++probe) {
+        Slot& s = t->slots[(h + probe) % slot_count];
+        const std::uint32_t k = s.key.load(std::memory_order_relaxed);
+        if (k != key && k != 0) {
+            continue;
+        }
+        if (k == 0) {
+            s.key.store(key, std::memory_order_release);
+        }
+        bump<std::uint64_t>(s.calls, 1);
+        bump<std::uint64_t>(s.nanos,
+                            static_cast<std::uint64_t>(
+                                std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+        bump(s.flops, flops);
+        bump(s.bytes, bytes);
+        return;
+    }
+    bump<std::uint64_t>(t->dropped, 1);
+}
+
+void marker_begin(int id) noexcept {
+    const char* name = g_names[static_cast<std::size_t>(id)].load(std::memory_order_relaxed);
+    if (const MarkerHooks* h = g_hooks.load(std::memory_order_acquire)) {
+        h->begin(name, h->user);
+    }
+#if defined(LANA_WITH_ITT)
+    __itt_task_begin(itt_domain(), __itt_null, __itt_null,
+                     g_itt_names[static_cast<std::size_t>(id)].load(std::memory_order_relaxed));
+#endif
+#if defined(LANA_WITH_SDT)
+    DTRACE_PROBE1(lana, kernel_begin, name);
+#endif
+    (void)name;
+}
+
+void marker_end(int id) noexcept {
+    const char* name = g_names[static_cast<std::size_t>(id)].load(std::memory_order_relaxed);
+#if defined(LANA_WITH_SDT)
+    DTRACE_PROBE1(lana, kernel_end, name);
+#endif
+#if defined(LANA_WITH_ITT)
+    __itt_task_end(itt_domain());
+#endif
+    if (const MarkerHooks* h = g_hooks.load(std::memory_order_acquire); h != nullptr && h->end != nullptr) {
+        h->end(name, h->user);
+    }
+    (void)name;
+}
+
+void count(PoolEvent e, std::uint64_t n) noexcept {
+    try {
+        bump(my_table().pool[static_cast<std::size_t>(e)], n);
+    } catch (...) {
+    }
+}
+
+void count_push(std::uint64_t depth) noexcept {
+    try {
+        Table& t = my_table();
+        bump<std::uint64_t>(t.pool[f_pushes], 1);
+        bump(t.pool[f_depth_sum], depth);
+        if (depth > t.pool[f_depth_max].load(std::memory_order_relaxed)) {
+            t.pool[f_depth_max].store(depth, std::memory_order_relaxed);
+        }
+    } catch (...) {
+    }
+}
+
+}  // namespace detail
+
+void set_enabled(bool on) noexcept {
+    detail::enabled_state.store(on ? detail::State::on : detail::State::off, std::memory_order_relaxed);
+}
+
+void reset() noexcept {
+    detail::Registry& r = detail::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& t : r.tables) {
+        // Keys stay: a slot's owner may be between its key check and update.
+        for (detail::Slot& s : t->slots) {
+            s.calls.store(0, std::memory_order_relaxed);
+            s.nanos.store(0, std::memory_order_relaxed);
+            s.flops.store(0, std::memory_order_relaxed);
+            s.bytes.store(0, std::memory_order_relaxed);
+        }
+        for (auto& p : t->pool) {
+            p.store(0, std::memory_order_relaxed);
+        }
+        t->dropped.store(0, std::memory_order_relaxed);
+    }
+}
+
+const char* dtype_name(Dtype d) noexcept {
+    switch (d) {
+        case Dtype::f32:
+            return "f32";
+        case Dtype::f64:
+            return "f64";
+        case Dtype::bf16:
+            return "bf16";
+        case Dtype::f16:
+            return "f16";
+        case Dtype::other:
+            break;
+    }
+    return "other";
+}
+
+Snapshot snapshot() {
+    using detail::bucket_bits;
+    using detail::dtype_bits;
+    std::map<std::tuple<std::string, int, int>, KernelCounters> merged;
+    Snapshot snap;
+    detail::Registry& r = detail::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (const auto& t : r.tables) {
+        for (const detail::Slot& s : t->slots) {
+            const std::uint32_t key = s.key.load(std::memory_order_acquire);
+            const std::uint64_t calls = s.calls.load(std::memory_order_relaxed);
+            if (key == 0 || calls == 0) {
+                continue;
+            }
+            const int id = static_cast<int>(key >> (bucket_bits + dtype_bits)) - 1;
+            const auto dtype = static_cast<Dtype>((key >> bucket_bits) & ((1u << dtype_bits) - 1));
+            const int bucket = static_cast<int>(key & ((1u << bucket_bits) - 1));
+            const std::string name = detail::g_names[static_cast<std::size_t>(id)].load(std::memory_order_relaxed);
+            KernelCounters& c = merged[{name, static_cast<int>(dtype), bucket}];
+            c.kernel = name;
+            c.dtype = dtype;
+            c.size_lo = bucket == 0 ? 0 : std::int64_t{1} << (bucket - 1);
+            c.size_hi = bucket == 0 ? 0 : static_cast<std::int64_t>((std::uint64_t{1} << bucket) - 1);
+            c.calls += calls;
+            c.seconds += static_cast<double>(s.nanos.load(std::memory_order_relaxed)) * 1e-9;
+            c.flops += s.flops.load(std::memory_order_relaxed);
+            c.bytes += s.bytes.load(std::memory_order_relaxed);
+        }
+        const auto pool = [&](int f) { return t->pool[static_cast<std::size_t>(f)].load(std::memory_order_relaxed); };
+        snap.pool.regions += pool(detail::f_region);
+        snap.pool.tasks += pool(detail::f_task);
+        snap.pool.steals += pool(detail::f_steal);
+        snap.pool.injected += pool(detail::f_injected);
+        snap.pool.sleeps += pool(detail::f_sleep);
+        snap.pool.pushes += pool(detail::f_pushes);
+        snap.pool.depth_sum += pool(detail::f_depth_sum);
+        snap.pool.depth_max = std::max(snap.pool.depth_max, pool(detail::f_depth_max));
+        snap.dropped += t->dropped.load(std::memory_order_relaxed);
+    }
+    snap.kernels.reserve(merged.size());
+    for (auto& [key, c] : merged) {
+        snap.kernels.push_back(std::move(c));
+    }
+    return snap;
+}
+
+void write_report(std::ostream& os, const Snapshot& snap) {
+    char line[256];
+    std::snprintf(line, sizeof line, "%-16s %-6s %10s %10s %10s %12s %10s %14s\n", "kernel", "dtype", "size_lo",
+                  "size_hi", "calls", "seconds", "gflops", "bytes_per_flop");
+    os << line;
+    for (const KernelCounters& c : snap.kernels) {
+        std::snprintf(line, sizeof line, "%-16s %-6s %10lld %10lld %10llu %12.6f %10.3f %14.5f\n", c.kernel.c_str(),
+                      dtype_name(c.dtype), static_cast<long long>(c.size_lo), static_cast<long long>(c.size_hi),
+                      static_cast<unsigned long long>(c.calls), c.seconds,
+                      c.seconds > 0 ? c.flops / c.seconds * 1e-9 : 0.0, c.flops > 0 ? c.bytes / c.flops : 0.0);
+        os << line;
+    }
+    const PoolCounters& p = snap.pool;
+    std::snprintf(line, sizeof line,
+                  "pool regions=%llu tasks=%llu steals=%llu injected=%llu sleeps=%llu depth_mean=%.2f "
+                  "depth_max=%llu\n",
+                  static_cast<unsigned long long>(p.regions), static_cast<unsigned long long>(p.tasks),
+                  static_cast<unsigned long long>(p.steals), static_cast<unsigned long long>(p.injected),
+                  static_cast<unsigned long long>(p.sleeps),
+                  p.pushes > 0 ? static_cast<double>(p.depth_sum) / static_cast<double>(p.pushes) : 0.0,
+                  static_cast<unsigned long long>(p.depth_max));
+    os << line;
+    if (snap.dropped > 0) {
+        os << "dropped=" << snap.dropped << '\n';
+    }
+}
+
+void set_marker_hooks(const MarkerHooks& hooks) noexcept {
+    // Hook sets are never freed: a marker may still be running on another
+    // thread with the previous set.
+    const MarkerHooks* h = nullptr;
+    if (hooks.begin != nullptr) {
+        h = new (std::nothrow) MarkerHooks(hooks);
+    }
+    detail::g_hooks.store(h, std::memory_order_release);
+}
+
+}  // namespace lana::profile
@@ -0,0 +1,19 @@
+#pragma once
+
+// Pool-side counters of lana::profile. Callers check profile::enabled()
+// first; these only touch the calling thread's table.
+
+#include "lana/profile.hpp"
+
+#include <cstdint>
+
+namespace lana::profile::detail {
+
+enum class PoolEvent { region, task, steal, injected, sleep };
+
+void count(PoolEvent e, std::uint64_t n = 1) noexcept;
+
+/// A push that left `depth` tasks in the queue it went to.
+void count_push(std::uint64_t depth) noexcept;
+
+}  // namespace lana::profile::detail
@@ -0,0 +1,144 @@
+// SolveQueue's batching thread.
+//
+// Requests wait in a FIFO with their arrival time. The thread sleeps until
+// there is one, then until the oldest has waited out the window, the queue
+// holds max_batch columns, flush() is called or the queue is destroyed;
+// it takes requests from the front up to max_batch columns (always at
+// least one), solves them outside the lock and completes their futures.
+
+#include "lana/solve_queue.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+namespace lana::detail {
+
+class SolveBatcherImpl {
+public:
+    SolveBatcherImpl(SolveBatcher::Run run, const SolveQueueOptions& options)
+        : run_(std::move(run)),
+          window_(std::max(options.window, std::chrono::microseconds(0))),
+          max_batch_(std::max<index_t>(options.max_batch, 1)),
+          worker_([this] { loop(); }) {}
+
+    ~SolveBatcherImpl() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    async::Future<void> push(const SolveRequest& request) {
+        auto state = std::make_shared<async::detail::State<void>>();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back({request, state, Clock::now()});
+            queued_cols_ += request.cols;
+            ++stats_.requests;
+        }
+        cv_.notify_all();
+        return async::detail::Access::make(std::move(state));
+    }
+
+    void flush() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            // loop() clears the flag once the queue drains; set on an empty
+            // queue it would never be cleared and would send the next
+            // request off alone.
+            if (queue_.empty()) {
+                return;
+            }
+            flush_ = true;
+        }
+        cv_.notify_all();
+    }
+
+    SolveQueueStats stats() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return stats_;
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Queued {
+        SolveRequest request;
+        std::shared_ptr<async::detail::State<void>> state;
+        Clock::time_point arrival;
+    };
+
+    void loop() {
+        std::vector<SolveRequest> batch;
+        std::vector<std::shared_ptr<async::detail::State<void>>> states;
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (queue_.empty()) {
+                return;
+            }
+            const auto ready = [&] { return stop_ || flush_ || queued_cols_ >= max_batch_; };
+            cv_.wait_until(lock, queue_.front().arrival + window_, ready);
+
+            index_t cols = 0;
+            while (!queue_.empty() && (batch.empty() || cols + queue_.front().request.cols <= max_batch_)) {
+                Queued& q = queue_.front();
+                cols += q.request.cols;
+                batch.push_back(q.request);
+                states.push_back(std::move(q.state));
+                queue_.pop_front();
+            }
+            queued_cols_ -= cols;
+            if (queue_.empty()) {
+                flush_ = false;
+            }
+            ++stats_.batches;
+            stats_.columns += static_cast<std::uint64_t>(cols);
+            stats_.largest_batch = std::max(stats_.largest_batch, cols);
+            lock.unlock();
+
+            std::exception_ptr error;
+            try {
+                run_(batch, cols);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            for (const auto& st : states) {
+                st->finish(error);
+            }
+            batch.clear();
+            states.clear();
+            lock.lock();
+        }
+    }
+
+    SolveBatcher::Run run_;
+    const std::chrono::microseconds window_;
+    const index_t max_batch_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Queued> queue_;
+    index_t queued_cols_ = 0;
+    bool flush_ = false;
+    bool stop_ = false;
+    SolveQueueStats stats_;
+    std::thread worker_;  // last, so it starts after everything it uses
+};
+
+SolveBatcher::SolveBatcher(Run run, const SolveQueueOptions& options)
+    : impl_(std::make_unique<SolveBatcherImpl>(std::move(run), options)) {}
+SolveBatcher::~SolveBatcher() = default;
+
+async::Future<void> SolveBatcher::push(const SolveRequest& request) { return impl_->push(request); }
+void SolveBatcher::flush() { impl_->flush(); }
+SolveQueueStats SolveBatcher::stats() const { return impl_->stats(); }
+
+}  // namespace lana::detail
@@ -0,0 +1,335 @@
+#include "lana/profile.hpp"
+#include "lana/sparse.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/workspace.hpp"
+
+#include "device_internal.hpp"
+#include "kernels/kernels.hpp"
+
+#include <algorithm>
+
+namespace lana {
+namespace detail {
+namespace {
+
+/// Work (nonzeros plus rows) per task below which a product stays serial.
+constexpr index_t sparse_min_work = index_t(1) << 15;
+
+/// Tasks for a product touching `work` units, as for BLAS-1.
+index_t sparse_tasks(index_t work) {
+    if (work < 2 * sparse_min_work) {
+        return 1;
+    }
+    return std::min<index_t>(parallel_concurrency(), work / sparse_min_work);
+}
+
+/// Row boundaries bounds[0, parts] splitting [0, rows) into `parts` ranges
+/// of about equal cost, where row r costs its nonzeros plus one (so empty
+/// rows still count).
+void balanced_rows(const index_t* ptr, index_t rows, index_t parts, index_t* bounds) {
+    bounds[0] = 0;
+    const index_t total = ptr[rows] + rows;
+    index_t r = 0;
+    for (index_t p = 1; p < parts; ++p) {
+        const index_t target = total / parts * p + total % parts * p / parts;
+        // First row whose prefix cost reaches the target; cost is monotone.
+        index_t lo = r;
+        index_t hi = rows;
+        while (lo < hi) {
+            const index_t mid = lo + (hi - lo) / 2;
+            if (ptr[mid] + mid < target) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        r = lo;
+        bounds[p] = r;
+    }
+    bounds[parts] = rows;
+}
+
+/// Runs body(lo, hi) over nnz-balanced row ranges.
+template <typename F>
+void for_row_ranges(const index_t* ptr, index_t rows, index_t weight, F&& body) {
+    const index_t tasks = sparse_tasks(weight * ptr[rows] + rows);
+    if (tasks <= 1) {
+        body(index_t(0), rows);
+        return;
+    }
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    index_t* bounds = ws.allocate_n<index_t>(static_cast<std::size_t>(tasks) + 1);
+    balanced_rows(ptr, rows, tasks, bounds);
+    parallel_run(tasks, [&](index_t t) {
+        const index_t lo = bounds[t];
+        const index_t hi = bounds[t + 1];
+        if (lo < hi) {
+            body(lo, hi);
+        }
+    });
+}
+
+template <typename T>
+void store(T alpha, T acc, T beta, T& y) {
+    y = beta == T(0) ? alpha * acc : alpha * acc + beta * y;
+}
+
+/// Unit-stride x: the original data, or a copy in the thread workspace
+/// (the caller holds the scope).
+template <typename T>
+const T* contiguous(VectorView<const T> x, Workspace& ws) {
+    if (x.stride() == 1) {
+        return x.data();
+    }
+    T* copy = ws.allocate_n<T>(static_cast<std::size_t>(x.size()));
+    for (index_t i = 0; i < x.size(); ++i) {
+        copy[i] = x[i];
+    }
+    return copy;
+}
+
+template <typename T>
+void spmv_csr(T alpha, CsrView<T> a, VectorView<const T> x, T beta, VectorView<T> y) {
+    require_dims(x.size() == a.cols() && y.size() == a.rows(), "spmv");
+    if (device_spmv(alpha, a, x, beta, y)) {
+        return;
+    }
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    const T* xp = contiguous(x, ws);
+    const auto kdot = kernels<T>().sparse_dot;
+    const index_t* rp = a.row_ptr();
+    const sparse_index_t* ci = a.col_idx();
+    const T* av = a.values();
+    for_row_ranges(rp, a.rows(), 1, [&](index_t lo, index_t hi) {
+        for (index_t i = lo; i < hi; ++i) {
+            store(alpha, kdot(rp[i + 1] - rp[i], av + rp[i], ci + rp[i], xp), beta, y[i]);
+        }
+    });
+}
+
+template <typename T>
+void spmv_csc(T alpha, const Csc<T>& a, VectorView<const T> x, T beta, VectorView<T> y) {
+    require_dims(x.size() == a.cols() && y.size() == a.rows(), "spmv");
+    for (index_t i = 0; i < y.size(); ++i) {
+        y[i] = beta == T(0) ? T(0) : beta * y[i];
+    }
+    const index_t* cp = a.col_ptr().data();
+    const sparse_index_t* ri = a.row_idx().data();
+    const T* av = a.values().data();
+    for (index_t j = 0; j < a.cols(); ++j) {
+        const T s = alpha * x[j];
+        for (index_t k = cp[j]; k < cp[j + 1]; ++k) {
+            y[ri[k]] += s * av[k];
+        }
+    }
+}
+
+/// One block row of y += A * x with the block shape known at compile time
+/// where possible, so the per-block loops unroll and vectorize.
+template <typename T, int BR, int BC>
+void bsr_block_row(index_t br_rt, index_t bc_rt, index_t s0, index_t s1, const sparse_index_t* bcol, const T* av,
+                   const T* xp, T* acc) {
+    const index_t br = BR > 0 ? BR : br_rt;
+    const index_t bc = BC > 0 ? BC : bc_rt;
+    for (index_t s = s0; s < s1; ++s) {
+        const T* blk = av + s * br * bc;
+        const T* xb = xp + static_cast<index_t>(bcol[s]) * bc;
+        for (index_t j = 0; j < bc; ++j) {
+            const T xj = xb[j];
+            for (index_t i = 0; i < br; ++i) {
+                acc[i] += blk[i + j * br] * xj;
+            }
+        }
+    }
+}
+
+template <typename T>
+using BsrRowFn = void (*)(index_t, index_t, index_t, index_t, const sparse_index_t*, const T*, const T*, T*);
+
+template <typename T>
+BsrRowFn<T> bsr_row_fn(index_t br, index_t bc) {
+    if (br == bc) {
+        switch (br) {
+            case 2: return &bsr_block_row<T, 2, 2>;
+            case 3: return &bsr_block_row<T, 3, 3>;
+            case 4: return &bsr_block_row<T, 4, 4>;
+            case 6: return &bsr_block_row<T, 6, 6>;
+            case 8: return &bsr_block_row<T, 8, 8>;
+            default: break;
+        }
+    }
+    return &bsr_block_row<T, 0, 0>;
+}
+
+/// Runs body(acc, ib, column) for each block row ib and each of `ncols`
+/// right-hand sides; acc holds br zeroed accumulators.
+template <typename T, typename F>
+void bsr_rows(const Bsr<T>& a, index_t ncols, F&& body) {
+    for_row_ranges(a.block_ptr().data(), a.block_row_count(), a.block_rows() * a.block_cols(),
+                   [&](index_t lo, index_t hi) {
+                       Workspace& ws = thread_workspace();
+                       Workspace::Scope scope(ws);
+                       T* acc = ws.allocate_n<T>(static_cast<std::size_t>(a.block_rows()));
+                       for (index_t ib = lo; ib < hi; ++ib) {
+                           for (index_t j = 0; j < ncols; ++j) {
+                               std::fill_n(acc, a.block_rows(), T(0));
+                               body(acc, ib, j);
+                           }
+                       }
+                   });
+}
+
+template <typename T>
+void spmv_bsr(T alpha, const Bsr<T>& a, VectorView<const T> x, T beta, VectorView<T> y) {
+    require_dims(x.size() == a.cols() && y.size() == a.rows(), "spmv");
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    const T* xp = contiguous(x, ws);
+    const index_t br = a.block_rows();
+    const index_t bc = a.block_cols();
+    const BsrRowFn<T> row = bsr_row_fn<T>(br, bc);
+    const index_t* bp = a.block_ptr().data();
+    bsr_rows(a, 1, [&](T* acc, index_t ib, index_t) {
+        row(br, bc, bp[ib], bp[ib + 1], a.block_col().data(), a.values().data(), xp, acc);
+        for (index_t i = 0; i < br; ++i) {
+            store(alpha, acc[i], beta, y[ib * br + i]);
+        }
+    });
+}
+
+template <typename T>
+void spmm_csr(T alpha, CsrView<T> a, MatrixView<const T> b, T beta, MatrixView<T> c) {
+    require_dims(b.rows() == a.cols() && c.rows() == a.rows() && c.cols() == b.cols(), "spmm");
+    // Each row of A is streamed once per group of `width` columns of B.
+    constexpr index_t width = 8;
+    const index_t n = b.cols();
+    const index_t* rp = a.row_ptr();
+    const sparse_index_t* ci = a.col_idx();
+    const T* av = a.values();
+    const index_t brs = b.row_stride();
+    const index_t bcs = b.col_stride();
+    for_row_ranges(rp, a.rows(), std::max<index_t>(1, n), [&](index_t lo, index_t hi) {
+        for (index_t j0 = 0; j0 < n; j0 += width) {
+            const index_t w = std::min(width, n - j0);
+            const T* bj = b.data() + j0 * bcs;
+            for (index_t i = lo; i < hi; ++i) {
+                T acc[width] = {};
+                for (index_t k = rp[i]; k < rp[i + 1]; ++k) {
+                    const T v = av[k];
+                    const T* brow = bj + static_cast<index_t>(ci[k]) * brs;
+                    for (index_t jj = 0; jj < w; ++jj) {
+                        acc[jj] += v * brow[jj * bcs];
+                    }
+                }
+                for (index_t jj = 0; jj < w; ++jj) {
+                    store(alpha, acc[jj], beta, c(i, j0 + jj));
+                }
+            }
+        }
+    });
+}
+
+template <typename T>
+void spmm_bsr(T alpha, const Bsr<T>& a, MatrixView<const T> b, T beta, MatrixView<T> c) {
+    require_dims(b.rows() == a.cols() && c.rows() == a.rows() && c.cols() == b.cols(), "spmm");
+    if (b.row_stride() != 1) {
+        // The block kernel wants unit-stride columns of B.
+        Workspace& ws = thread_workspace();
+        Workspace::Scope scope(ws);
+        MatrixView<T> packed = ws.matrix<T>(b.rows(), b.cols());
+        packed.assign(b);
+        spmm_bsr(alpha, a, MatrixView<const T>(packed), beta, c);
+        return;
+    }
+    const index_t br = a.block_rows();
+    const index_t bc = a.block_cols();
+    const BsrRowFn<T> row = bsr_row_fn<T>(br, bc);
+    const index_t* bp = a.block_ptr().data();
+    bsr_rows(a, b.cols(), [&](T* acc, index_t ib, index_t j) {
+        row(br, bc, bp[ib], bp[ib + 1], a.block_col().data(), a.values().data(), b.data() + j * b.col_stride(), acc);
+        for (index_t i = 0; i < br; ++i) {
+            store(alpha, acc[i], beta, c(ib * br + i, j));
+        }
+    });
+}
+
+template <typename A>
+index_t stored(const A& a) {
+    return a.nnz();
+}
+template <typename T>
+index_t stored(const Bsr<T>& a) {
+    return static_cast<index_t>(a.values().size());
+}
+
+/// Profile scope for a product of `a` with `width` right-hand columns:
+/// each stored value and index is read once, x or B once per column.
+template <typename T, typename A>
+profile::Scope sparse_scope(int id, const A& a, index_t width) {
+    const auto nnz = static_cast<double>(stored(a));
+    const auto w = static_cast<double>(width);
+    return profile::Scope(id, profile::dtype_of<T>(), std::max(a.rows(), a.cols()), 2.0 * nnz * w,
+                          nnz * (sizeof(T) + sizeof(sparse_index_t)) +
+                              static_cast<double>(a.rows() + a.cols()) * w * sizeof(T));
+}
+
+template <typename T, typename A>
+profile::Scope spmv_scope(const A& a) {
+    static const int id = profile::detail::kernel_id("spmv");
+    return sparse_scope<T>(id, a, 1);
+}
+
+template <typename T, typename A>
+profile::Scope spmm_scope(const A& a, MatrixView<const T> b) {
+    static const int id = profile::detail::kernel_id("spmm");
+    return sparse_scope<T>(id, a, b.cols());
+}
+
+}  // namespace
+}  // namespace detail
+
+void spmv(float alpha, CsrView<float> a, VectorView<const float> x, float beta, VectorView<float> y) {
+    const auto prof = detail::spmv_scope<float>(a);
+    detail::spmv_csr(alpha, a, x, beta, y);
+}
+void spmv(double alpha, CsrView<double> a, VectorView<const double> x, double beta, VectorView<double> y) {
+    const auto prof = detail::spmv_scope<double>(a);
+    detail::spmv_csr(alpha, a, x, beta, y);
+}
+void spmv(float alpha, const Csc<float>& a, VectorView<const float> x, float beta, VectorView<float> y) {
+    const auto prof = detail::spmv_scope<float>(a);
+    detail::spmv_csc(alpha, a, x, beta, y);
+}
+void spmv(double alpha, const Csc<double>& a, VectorView<const double> x, double beta, VectorView<double> y) {
+    const auto prof = detail::spmv_scope<double>(a);
+    detail::spmv_csc(alpha, a, x, beta, y);
+}
+void spmv(float alpha, const Bsr<float>& a, VectorView<const float> x, float beta, VectorView<float> y) {
+    const auto prof = detail::spmv_scope<float>(a);
+    detail::spmv_bsr(alpha, a, x, beta, y);
+}
+void spmv(double alpha, const Bsr<double>& a, VectorView<const double> x, double beta, VectorView<double> y) {
+    const auto prof = detail::spmv_scope<double>(a);
+    detail::spmv_bsr(alpha, a, x, beta, y);
+}
+
+void spmm(float alpha, CsrView<float> a, MatrixView<const float> b, float beta, MatrixView<float> c) {
+    const auto prof = detail::spmm_scope(a, b);
+    detail::spmm_csr(alpha, a, b, beta, c);
+}
+void spmm(double alpha, CsrView<double> a, MatrixView<const double> b, double beta, MatrixView<double> c) {
+    const auto prof = detail::spmm_scope(a, b);
+    detail::spmm_csr(alpha, a, b, beta, c);
+}
+void spmm(float alpha, const Bsr<float>& a, MatrixView<const float> b, float beta, MatrixView<float> c) {
+    const auto prof = detail::spmm_scope(a, b);
+    detail::spmm_bsr(alpha, a, b, beta, c);
+}
+void spmm(double alpha, const Bsr<double>& a, MatrixView<const double> b, double beta, MatrixView<double> c) {
+    const auto prof = detail::spmm_scope(a, b);
+    detail::spmm_bsr(alpha, a, b, beta, c);
+}
+
+}  // namespace lana
@@ -0,0 +1,1288 @@
+// Fill-reducing orderings and supernodal multifrontal factorizations.
+//
+// Orderings work on the adjacency graph of A + A^T. AMD follows Amestoy,
+// Davis and Duff: a quotient graph of variables and elements (eliminated
+// cliques), approximate external degrees from |Le \ Lp|, aggressive
+// absorption of elements covered by the new one, and indistinguishable
+// variables merged into supervariables by hashing their adjacency. Nested
+// dissection cuts each connected piece at the middle level of a
+// breadth-first level structure rooted at a pseudo-peripheral node (the
+// level's vertices that touch the next level form the separator), orders
+// both halves recursively and the separator last, and hands pieces of at
+// most nd_leaf vertices to AMD.
+//
+// The analysis numbers the pivots in a postorder of the elimination tree,
+// so every supernode is a contiguous column range, takes fundamental
+// supernodes from the column counts and merges a supernode into its parent
+// (CHOLMOD's relaxed amalgamation rule) when few explicit zeros result.
+//
+// Factorization is multifrontal: front s is a dense m x m matrix over the
+// rows of supernode s, kept as its ns pivot columns (stored in place in
+// the factor) plus the (m - ns) x (m - ns) update matrix handed to the
+// parent. Each front is one TaskGraph task depending on its children, run
+// with the calling-thread dense kernels; fronts at least wide_front wide,
+// and the ancestors of such fronts, are factored after the graph, one at a
+// time, with the parallel kernels.
+//
+// LU runs on A Q, Q from a maximum transversal (MC21 depth-first
+// augmenting paths after a greedy pass that takes large entries first),
+// so structurally zero diagonals do not become perturbed pivots. A
+// matching that leaves rows over means A is structurally singular, and no
+// pivoting can factor it.
+
+#include "lana/sparse_factor.hpp"
+#include "lana/error.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/workspace.hpp"
+
+#include "factor_internal.hpp"
+#include "task_graph.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace lana {
+namespace detail {
+namespace {
+
+/// Pieces of a nested dissection at most this large are ordered by AMD.
+constexpr index_t nd_leaf = 200;
+/// Columns beyond which a supernode is split.
+constexpr index_t max_supernode = 256;
+/// A pivot of LU is weak when an entry below it, outside the front's
+/// pivot block, is larger than the pivot over this factor.
+constexpr double pivot_threshold = 0.1;
+/// Front order from which fronts run outside the task graph.
+constexpr index_t wide_front = 512;
+/// Front rows times right-hand sides below which a solve step stays on
+/// the calling thread.
+constexpr index_t solve_local_work = index_t(1) << 16;
+
+std::size_t at(index_t i) { return static_cast<std::size_t>(i); }
+
+// ---------------------------------------------------------------------------
+// Graphs and orderings
+
+/// Adjacency lists of a symmetric pattern, diagonal excluded.
+struct Graph {
+    std::vector<index_t> ptr;
+    std::vector<sparse_index_t> adj;
+
+    index_t size() const noexcept { return static_cast<index_t>(ptr.size()) - 1; }
+    index_t degree(index_t v) const noexcept { return ptr[at(v) + 1] - ptr[at(v)]; }
+};
+
+Graph symmetrize(index_t n, const index_t* ptr, const sparse_index_t* idx, bool lower) {
+    Graph g;
+    g.ptr.assign(at(n) + 1, 0);
+    const auto used = [&](index_t i, index_t j) { return j != i && !(lower && j > i); };
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+            if (used(i, idx[k])) {
+                ++g.ptr[at(i) + 1];
+                ++g.ptr[at(idx[k]) + 1];
+            }
+        }
+    }
+    std::partial_sum(g.ptr.begin(), g.ptr.end(), g.ptr.begin());
+    g.adj.resize(at(g.ptr.back()));
+    std::vector<index_t> next(g.ptr.begin(), g.ptr.end() - 1);
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t k = ptr[i]; k < ptr[i + 1]; ++k) {
+            const sparse_index_t j = idx[k];
+            if (used(i, j)) {
+                g.adj[at(next[at(i)]++)] = j;
+                g.adj[at(next[at(j)]++)] = static_cast<sparse_index_t>(i);
+            }
+        }
+    }
+    // Entries present on both sides of the diagonal appear twice.
+    index_t w = 0;
+    for (index_t i = 0; i < n; ++i) {
+        const auto lo = g.adj.begin() + g.ptr[at(i)];
+        const auto hi = g.adj.begin() + g.ptr[at(i) + 1];
+        std::sort(lo, hi);
+        const auto end = std::unique(lo, hi);
+        g.ptr[at(i)] = w;
+        w = static_cast<index_t>(std::copy(lo, end, g.adj.begin() + w) - g.adj.begin());
+    }
+    g.ptr[at(n)] = w;
+    g.adj.resize(at(w));
+    return g;
+}
+
+/// Approximate minimum degree order of g.
+std::vector<sparse_index_t> amd(const Graph& g) {
+    enum State : char { Variable, Element, Absorbed };
+    const index_t n = g.size();
+    std::vector<std::vector<sparse_index_t>> var(at(n));      // adjacent variables
+    std::vector<std::vector<sparse_index_t>> elt(at(n));      // adjacent elements
+    std::vector<std::vector<sparse_index_t>> lst(at(n));      // variables of an element
+    std::vector<std::vector<sparse_index_t>> members(at(n));  // variables merged into a supervariable
+    std::vector<State> state(at(n), Variable);
+    std::vector<index_t> nv(at(n), 1);
+    std::vector<index_t> degree(at(n));
+
+    // Degree lists.
+    std::vector<index_t> head(at(n) + 1, -1);
+    std::vector<index_t> next(at(n), -1);
+    std::vector<index_t> prev(at(n), -1);
+    const auto insert = [&](index_t v) {
+        const index_t d = degree[at(v)];
+        next[at(v)] = head[at(d)];
+        prev[at(v)] = -1;
+        if (head[at(d)] >= 0) {
+            prev[at(head[at(d)])] = v;
+        }
+        head[at(d)] = v;
+    };
+    const auto remove = [&](index_t v) {
+        if (prev[at(v)] >= 0) {
+            next[at(prev[at(v)])] = next[at(v)];
+        } else {
+            head[at(degree[at(v)])] = next[at(v)];
+        }
+        if (next[at(v)] >= 0) {
+            prev[at(next[at(v)])] = prev[at(v)];
+        }
+    };
+
+    for (index_t v = 0; v < n; ++v) {
+        var[at(v)].assign(g.adj.begin() + g.ptr[at(v)], g.adj.begin() + g.ptr[at(v) + 1]);
+        degree[at(v)] = g.degree(v);
+        insert(v);
+    }
+
+    std::vector<index_t> mark(at(n), -1);   // == step: in Lp
+    std::vector<index_t> seen(at(n), -1);   // == step: w[e] is current
+    std::vector<index_t> w(at(n), 0);       // |Le \ Lp|
+    std::vector<sparse_index_t> lp;
+    std::vector<std::pair<std::uint64_t, sparse_index_t>> hashes;
+    std::vector<sparse_index_t> order;
+    order.reserve(at(n));
+    index_t done = 0;
+    index_t mindeg = 0;
+    for (index_t step = 0; done < n; ++step) {
+        while (head[at(mindeg)] < 0) {
+            ++mindeg;
+        }
+        const index_t p = head[at(mindeg)];
+        remove(p);
+
+        // Lp: the variables of p's elements and p's own variables.
+        lp.clear();
+        index_t lp_weight = 0;
+        mark[at(p)] = step;
+        const auto take = [&](sparse_index_t v) {
+            if (state[at(v)] == Variable && mark[at(v)] != step) {
+                mark[at(v)] = step;
+                lp.push_back(v);
+                lp_weight += nv[at(v)];
+            }
+        };
+        for (const sparse_index_t e : elt[at(p)]) {
+            if (state[at(e)] == Element) {
+                for (const sparse_index_t v : lst[at(e)]) {
+                    take(v);
+                }
+                state[at(e)] = Absorbed;
+                std::vector<sparse_index_t>().swap(lst[at(e)]);
+            }
+        }
+        for (const sparse_index_t v : var[at(p)]) {
+            take(v);
+        }
+        std::vector<sparse_index_t>().swap(var[at(p)]);
+        std::vector<sparse_index_t>().swap(elt[at(p)]);
+        state[at(p)] = Element;
+        lst[at(p)] = lp;
+        order.push_back(static_cast<sparse_index_t>(p));
+        order.insert(order.end(), members[at(p)].begin(), members[at(p)].end());
+        std::vector<sparse_index_t>().swap(members[at(p)]);
+        done += nv[at(p)];
+
+        // Element p replaces the absorbed elements and the edges inside Lp.
+        for (const sparse_index_t i : lp) {
+            remove(i);
+            auto& e = elt[at(i)];
+            e.erase(std::remove_if(e.begin(), e.end(), [&](sparse_index_t x) { return state[at(x)] != Element; }),
+                    e.end());
+            e.push_back(static_cast<sparse_index_t>(p));
+            auto& a = var[at(i)];
+            a.erase(std::remove_if(a.begin(), a.end(),
+                                   [&](sparse_index_t x) { return state[at(x)] != Variable || mark[at(x)] == step; }),
+                    a.end());
+        }
+
+        // w[e] = |Le \ Lp| for the other elements next to Lp.
+        for (const sparse_index_t i : lp) {
+            for (const sparse_index_t e : elt[at(i)]) {
+                if (e == p) {
+                    continue;
+                }
+                if (seen[at(e)] != step) {
+                    seen[at(e)] = step;
+                    auto& le = lst[at(e)];
+                    le.erase(std::remove_if(le.begin(), le.end(),
+                                            [&](sparse_index_t x) { return state[at(x)] != Variable; }),
+                             le.end());
+                    w[at(e)] = 0;
+                    for (const sparse_index_t x : le) {
+                        w[at(e)] += nv[at(x)];
+                    }
+                }
+                w[at(e)] -= nv[at(i)];
+            }
+        }
+
+        // Approximate degrees; elements inside Lp are absorbed into p.
+        hashes.clear();
+        for (const sparse_index_t i : lp) {
+            index_t d = lp_weight - nv[at(i)];
+            std::uint64_t h = 0;
+            for (const sparse_index_t x : var[at(i)]) {
+                d += nv[at(x)];
+                h += static_cast<std::uint64_t>(x);
+            }
+            for (const sparse_index_t e : elt[at(i)]) {
+                if (e != p) {
+                    if (w[at(e)] == 0) {
+                        state[at(e)] = Absorbed;
+                    } else {
+                        d += w[at(e)];
+                    }
+                }
+            }
+            d = std::min({d, degree[at(i)] + lp_weight - nv[at(i)], n - done - nv[at(i)]});
+            degree[at(i)] = std::max<index_t>(d, 0);
+            hashes.emplace_back(h, i);
+        }
+        for (const sparse_index_t i : lp) {
+            auto& e = elt[at(i)];
+            e.erase(std::remove_if(e.begin(), e.end(), [&](sparse_index_t x) { return state[at(x)] != Element; }),
+                    e.end());
+        }
+        for (auto& [h, i] : hashes) {
+            for (const sparse_index_t e : elt[at(i)]) {
+                h += static_cast<std::uint64_t>(e) * 0x9e3779b97f4a7c15ull;
+            }
+        }
+
+        // Variables of Lp with identical adjacency become one supervariable.
+        std::sort(hashes.begin(), hashes.end());
+        for (std::size_t a = 0; a < hashes.size();) {
+            std::size_t b = a + 1;
+            while (b < hashes.size() && hashes[b].first == hashes[a].first) {
+                ++b;
+            }
+            for (std::size_t x = a; b - a > 1 && x < b; ++x) {
+                std::sort(var[at(hashes[x].second)].begin(), var[at(hashes[x].second)].end());
+                std::sort(elt[at(hashes[x].second)].begin(), elt[at(hashes[x].second)].end());
+            }
+            for (std::size_t x = a; x < b; ++x) {
+                const sparse_index_t i = hashes[x].second;
+                for (std::size_t y = x + 1; nv[at(i)] > 0 && y < b; ++y) {
+                    const sparse_index_t j = hashes[y].second;
+                    if (nv[at(j)] == 0 || var[at(i)] != var[at(j)] || elt[at(i)] != elt[at(j)]) {
+                        continue;
+                    }
+                    nv[at(i)] += nv[at(j)];
+                    degree[at(i)] -= nv[at(j)];
+                    nv[at(j)] = 0;
+                    state[at(j)] = Absorbed;
+                    members[at(i)].push_back(j);
+                    members[at(i)].insert(members[at(i)].end(), members[at(j)].begin(), members[at(j)].end());
+                    std::vector<sparse_index_t>().swap(members[at(j)]);
+                    std::vector<sparse_index_t>().swap(var[at(j)]);
+                    std::vector<sparse_index_t>().swap(elt[at(j)]);
+                }
+            }
+            a = b;
+        }
+        for (const sparse_index_t i : lp) {
+            if (nv[at(i)] > 0) {
+                degree[at(i)] = std::max<index_t>(degree[at(i)], 0);
+                insert(i);
+                mindeg = std::min(mindeg, degree[at(i)]);
+            }
+        }
+    }
+    return order;
+}
+
+/// The subgraph of g induced by `nodes`, renumbered 0..size-1; local[v]
+/// must be -1 outside `nodes` and is left that way.
+Graph induced(const Graph& g, const std::vector<sparse_index_t>& nodes, std::vector<index_t>& local) {
+    for (std::size_t k = 0; k < nodes.size(); ++k) {
+        local[at(nodes[k])] = static_cast<index_t>(k);
+    }
+    Graph s;
+    s.ptr.assign(nodes.size() + 1, 0);
+    for (std::size_t k = 0; k < nodes.size(); ++k) {
+        const sparse_index_t v = nodes[k];
+        for (index_t q = g.ptr[at(v)]; q < g.ptr[at(v) + 1]; ++q) {
+            if (const index_t u = local[at(g.adj[at(q)])]; u >= 0) {
+                s.adj.push_back(static_cast<sparse_index_t>(u));
+            }
+        }
+        s.ptr[k + 1] = static_cast<index_t>(s.adj.size());
+    }
+    for (const sparse_index_t v : nodes) {
+        local[at(v)] = -1;
+    }
+    return s;
+}
+
+class Dissection {
+public:
+    explicit Dissection(const Graph& g)
+        : g_(g), label_(at(g.size()), 0), level_(at(g.size()), -1), local_(at(g.size()), -1) {}
+
+    std::vector<sparse_index_t> run() {
+        std::vector<sparse_index_t> all(at(g_.size()));
+        std::iota(all.begin(), all.end(), sparse_index_t(0));
+        order_.reserve(all.size());
+        split_components(std::move(all), 0);
+        return std::move(order_);
+    }
+
+private:
+    /// Orders each connected component of `nodes` (all labelled `id`).
+    void split_components(std::vector<sparse_index_t> nodes, index_t id) {
+        std::vector<std::vector<sparse_index_t>> parts;
+        for (const sparse_index_t v : nodes) {
+            if (level_[at(v)] < 0) {
+                parts.emplace_back();
+                for (const auto& lv : levels(v, id)) {
+                    parts.back().insert(parts.back().end(), lv.begin(), lv.end());
+                }
+            }
+        }
+        for (const sparse_index_t v : nodes) {
+            level_[at(v)] = -1;
+        }
+        if (parts.size() == 1) {
+            dissect(std::move(parts.front()), id);
+            return;
+        }
+        for (auto& part : parts) {
+            const index_t pid = ++labels_;
+            for (const sparse_index_t v : part) {
+                label_[at(v)] = pid;
+            }
+            dissect(std::move(part), pid);
+        }
+    }
+
+    /// Breadth-first level structure of the component of `root` within
+    /// label `id`, leaving each vertex's level in level_.
+    const std::vector<std::vector<sparse_index_t>>& levels(sparse_index_t root, index_t id) {
+        levels_.assign(1, {root});
+        level_[at(root)] = 0;
+        for (index_t d = 0;; ++d) {
+            std::vector<sparse_index_t> nxt;
+            for (const sparse_index_t v : levels_[at(d)]) {
+                for (index_t q = g_.ptr[at(v)]; q < g_.ptr[at(v) + 1]; ++q) {
+                    const sparse_index_t u = g_.adj[at(q)];
+                    if (label_[at(u)] == id && level_[at(u)] < 0) {
+                        level_[at(u)] = d + 1;
+                        nxt.push_back(u);
+                    }
+                }
+            }
+            if (nxt.empty()) {
+                break;
+            }
+            levels_.push_back(std::move(nxt));
+        }
+        return levels_;
+    }
+
+    void clear_levels() {
+        for (const auto& lv : levels_) {
+            for (const sparse_index_t v : lv) {
+                level_[at(v)] = -1;
+            }
+        }
+    }
+
+    /// Orders a connected piece: AMD when small, else separator last.
+    void dissect(std::vector<sparse_index_t> nodes, index_t id) {
+        if (static_cast<index_t>(nodes.size()) <= nd_leaf) {
+            leaf(nodes);
+            return;
+        }
+        // Pseudo-peripheral root: restart from a least-degree vertex of the
+        // last level while the eccentricity grows.
+        sparse_index_t root = nodes.front();
+        std::size_t depth = 0;
+        for (int pass = 0; pass < 4; ++pass) {
+            levels(root, id);
+            const std::size_t d = levels_.size();
+            const auto& last = levels_.back();
+            const sparse_index_t far = *std::min_element(last.begin(), last.end(), [&](sparse_index_t a, sparse_index_t b) {
+                return g_.degree(a) < g_.degree(b);
+            });
+            clear_levels();
+            if (d <= depth) {
+                break;
+            }
+            depth = d;
+            root = far;
+        }
+        levels(root, id);
+        if (levels_.size() < 3) {
+            clear_levels();
+            leaf(nodes);
+            return;
+        }
+
+        // Middle level by vertex count; its vertices with no neighbour
+        // beyond it do not separate anything and join the near half.
+        const std::size_t half = nodes.size() / 2;
+        std::size_t k = 0;
+        for (std::size_t seen = 0; k + 1 < levels_.size(); ++k) {
+            seen += levels_[k].size();
+            if (seen >= half) {
+                break;
+            }
+        }
+        k = std::clamp<std::size_t>(k, 1, levels_.size() - 2);
+        const index_t near_id = ++labels_;
+        const index_t far_id = ++labels_;
+        std::vector<sparse_index_t> near;
+        std::vector<sparse_index_t> far;
+        std::vector<sparse_index_t> sep;
+        for (std::size_t d = 0; d < levels_.size(); ++d) {
+            for (const sparse_index_t v : levels_[d]) {
+                bool cut = false;
+                if (d == k) {
+                    for (index_t q = g_.ptr[at(v)]; q < g_.ptr[at(v) + 1] && !cut; ++q) {
+                        const sparse_index_t u = g_.adj[at(q)];
+                        cut = label_[at(u)] == id && level_[at(u)] == static_cast<index_t>(k) + 1;
+                    }
+                }
+                (cut ? sep : d <= k ? near : far).push_back(v);
+            }
+        }
+        clear_levels();
+        for (const sparse_index_t v : near) {
+            label_[at(v)] = near_id;
+        }
+        for (const sparse_index_t v : far) {
+            label_[at(v)] = far_id;
+        }
+        for (const sparse_index_t v : sep) {
+            label_[at(v)] = -1;
+        }
+        split_components(std::move(near), near_id);
+        split_components(std::move(far), far_id);
+        order_.insert(order_.end(), sep.begin(), sep.end());
+    }
+
+    void leaf(const std::vector<sparse_index_t>& nodes) {
+        for (const sparse_index_t v : amd(induced(g_, nodes, local_))) {
+            order_.push_back(nodes[at(v)]);
+        }
+    }
+
+    const Graph& g_;
+    std::vector<index_t> label_;
+    std::vector<index_t> level_;
+    std::vector<index_t> local_;
+    std::vector<std::vector<sparse_index_t>> levels_;
+    std::vector<sparse_index_t> order_;
+    index_t labels_ = 0;
+};
+
+std::vector<sparse_index_t> order_graph(const Graph& g, Ordering ordering) {
+    switch (ordering) {
+        case Ordering::Amd: return amd(g);
+        case Ordering::NestedDissection: return Dissection(g).run();
+        case Ordering::Natural: break;
+    }
+    std::vector<sparse_index_t> perm(at(g.size()));
+    std::iota(perm.begin(), perm.end(), sparse_index_t(0));
+    return perm;
+}
+
+// ---------------------------------------------------------------------------
+// Symbolic factorization
+
+/// Relaxed amalgamation rule: merge when the front stays small or gains
+/// few zeros (fraction `z` of its entries).
+bool relax(index_t cols, double z) {
+    return cols <= 4 || (cols <= 16 && z < 0.8) || (cols <= 48 && z < 0.1) || z < 0.05;
+}
+
+SupernodalSymbolic symbolic(const Graph& g, std::vector<sparse_index_t> perm) {
+    const index_t n = g.size();
+    std::vector<sparse_index_t> iperm(at(n));
+    for (index_t k = 0; k < n; ++k) {
+        iperm[at(perm[at(k)])] = static_cast<sparse_index_t>(k);
+    }
+    const auto neighbours = [&](index_t k, auto&& f) {
+        const sparse_index_t v = perm[at(k)];
+        for (index_t q = g.ptr[at(v)]; q < g.ptr[at(v) + 1]; ++q) {
+            f(static_cast<index_t>(iperm[at(g.adj[at(q)])]));
+        }
+    };
+
+    // Elimination tree (Liu, with path compression).
+    std::vector<index_t> parent(at(n), -1);
+    {
+        std::vector<index_t> ancestor(at(n), -1);
+        for (index_t k = 0; k < n; ++k) {
+            neighbours(k, [&](index_t i) {
+                while (i != -1 && i < k) {
+                    const index_t up = ancestor[at(i)];
+                    ancestor[at(i)] = k;
+                    if (up == -1) {
+                        parent[at(i)] = k;
+                    }
+                    i = up;
+                }
+            });
+        }
+    }
+
+    // Postorder, folded into the permutation.
+    {
+        std::vector<index_t> child_head(at(n), -1);
+        std::vector<index_t> sibling(at(n), -1);
+        for (index_t j = n - 1; j >= 0; --j) {
+            if (parent[at(j)] >= 0) {
+                sibling[at(j)] = child_head[at(parent[at(j)])];
+                child_head[at(parent[at(j)])] = j;
+            }
+        }
+        std::vector<index_t> post;
+        post.reserve(at(n));
+        std::vector<index_t> stack;
+        for (index_t r = 0; r < n; ++r) {
+            if (parent[at(r)] != -1) {
+                continue;
+            }
+            stack.push_back(r);
+            while (!stack.empty()) {
+                const index_t v = stack.back();
+                if (const index_t c = child_head[at(v)]; c >= 0) {
+                    child_head[at(v)] = sibling[at(c)];
+                    stack.push_back(c);
+                } else {
+                    post.push_back(v);
+                    stack.pop_back();
+                }
+            }
+        }
+        std::vector<index_t> ipost(at(n));
+        for (index_t k = 0; k < n; ++k) {
+            ipost[at(post[at(k)])] = k;
+        }
+        std::vector<sparse_index_t> p2(at(n));
+        std::vector<index_t> parent2(at(n));
+        for (index_t k = 0; k < n; ++k) {
+            p2[at(k)] = perm[at(post[at(k)])];
+            const index_t up = parent[at(post[at(k)])];
+            parent2[at(k)] = up < 0 ? -1 : ipost[at(up)];
+        }
+        perm = std::move(p2);
+        parent = std::move(parent2);
+        for (index_t k = 0; k < n; ++k) {
+            iperm[at(perm[at(k)])] = static_cast<sparse_index_t>(k);
+        }
+    }
+
+    // Column counts of L from the row subtrees.
+    std::vector<index_t> count(at(n), 1);
+    std::vector<index_t> children(at(n), 0);
+    {
+        std::vector<index_t> mark(at(n), -1);
+        for (index_t i = 0; i < n; ++i) {
+            mark[at(i)] = i;
+            neighbours(i, [&](index_t k) {
+                for (index_t j = k; k < i && mark[at(j)] != i; j = parent[at(j)]) {
+                    mark[at(j)] = i;
+                    ++count[at(j)];
+                }
+            });
+            if (parent[at(i)] >= 0) {
+                ++children[at(parent[at(i)])];
+            }
+        }
+    }
+
+    // Fundamental supernodes: chains j-1 -> j where j has one child and
+    // column j-1 is column j plus its diagonal.
+    std::vector<index_t> fund;
+    for (index_t j = 0; j < n; ++j) {
+        const bool chain = j > 0 && parent[at(j) - 1] == j && children[at(j)] == 1 &&
+                           count[at(j) - 1] == count[at(j)] + 1 && j - fund.back() < max_supernode;
+        if (!chain) {
+            fund.push_back(j);
+        }
+    }
+    fund.push_back(n);
+    const index_t nf = static_cast<index_t>(fund.size()) - 1;
+
+    // Relaxed amalgamation, from the root end: a supernode whose parent
+    // starts right after it is merged into the group holding the parent.
+    std::vector<char> starts(at(nf), 1);
+    index_t g_cols = 0;
+    index_t g_height = 0;
+    double g_zeros = 0;
+    double g_entries = 0;
+    for (index_t s = nf - 1; s >= 0; --s) {
+        const index_t ns = fund[at(s) + 1] - fund[at(s)];
+        const index_t h = count[at(fund[at(s)])];
+        const index_t up = parent[at(fund[at(s) + 1]) - 1];
+        const auto own_entries = static_cast<double>(ns) * static_cast<double>(h) -
+                                 static_cast<double>(ns) * static_cast<double>(ns - 1) / 2;
+        if (s < nf - 1 && up == fund[at(s) + 1] && ns + g_cols <= max_supernode) {
+            const double zeros = g_zeros + static_cast<double>(ns) * static_cast<double>(ns + g_height - h);
+            const double entries = g_entries + static_cast<double>(ns) * static_cast<double>(ns + g_height) -
+                                   static_cast<double>(ns) * static_cast<double>(ns - 1) / 2;
+            if (relax(ns + g_cols, zeros / entries)) {
+                starts[at(s) + 1] = 0;
+                g_cols += ns;
+                g_height += ns;
+                g_zeros = zeros;
+                g_entries = entries;
+                continue;
+            }
+        }
+        g_cols = ns;
+        g_height = h;
+        g_zeros = 0;
+        g_entries = own_entries;
+    }
+
+    SupernodalSymbolic sym;
+    sym.n = n;
+    for (index_t s = 0; s < nf; ++s) {
+        if (starts[at(s)] != 0) {
+            sym.first.push_back(fund[at(s)]);
+        }
+    }
+    sym.first.push_back(n);
+    const index_t ns_total = sym.supernodes();
+    std::vector<index_t> super_of(at(n));
+    for (index_t s = 0; s < ns_total; ++s) {
+        std::fill(super_of.begin() + sym.first[at(s)], super_of.begin() + sym.first[at(s) + 1], s);
+    }
+    sym.parent.assign(at(ns_total), -1);
+    std::vector<std::vector<index_t>> kids(at(ns_total));
+    for (index_t s = 0; s < ns_total; ++s) {
+        const index_t up = parent[at(sym.first[at(s) + 1]) - 1];
+        if (up >= 0) {
+            sym.parent[at(s)] = super_of[at(up)];
+            kids[at(super_of[at(up)])].push_back(s);
+        }
+    }
+
+    // Front rows: own pivots, then the union of the columns' entries and
+    // the children's rows below the last pivot.
+    sym.row_ptr.assign(1, 0);
+    sym.l_ptr.assign(1, 0);
+    sym.u_ptr.assign(1, 0);
+    std::vector<index_t> mark(at(n), -1);
+    for (index_t s = 0; s < ns_total; ++s) {
+        const index_t f = sym.first[at(s)];
+        const index_t l = sym.first[at(s) + 1];
+        const std::size_t base = sym.rows.size();
+        for (index_t j = f; j < l; ++j) {
+            sym.rows.push_back(static_cast<sparse_index_t>(j));
+        }
+        const auto add = [&](index_t i) {
+            if (i >= l && mark[at(i)] != s) {
+                mark[at(i)] = s;
+                sym.rows.push_back(static_cast<sparse_index_t>(i));
+            }
+        };
+        for (index_t j = f; j < l; ++j) {
+            neighbours(j, add);
+        }
+        for (const index_t c : kids[at(s)]) {
+            const index_t cn = sym.first[at(c) + 1] - sym.first[at(c)];
+            for (index_t q = sym.row_ptr[at(c)] + cn; q < sym.row_ptr[at(c) + 1]; ++q) {
+                add(sym.rows[at(q)]);
+            }
+        }
+        std::sort(sym.rows.begin() + static_cast<std::ptrdiff_t>(base) + (l - f), sym.rows.end());
+        const auto m = static_cast<index_t>(sym.rows.size() - base);
+        sym.row_ptr.push_back(static_cast<index_t>(sym.rows.size()));
+        sym.l_ptr.push_back(sym.l_ptr.back() + m * (l - f));
+        sym.u_ptr.push_back(sym.u_ptr.back() + (l - f) * (m - l + f));
+    }
+    sym.perm = std::move(perm);
+    sym.iperm = std::move(iperm);
+    return sym;
+}
+
+// ---------------------------------------------------------------------------
+// Numeric factorization
+
+/// P A P^T compressed by column (entries at and below the diagonal only
+/// when `lower`, read from the lower triangle of A) or, with `by_row`, by
+/// row.
+template <typename T>
+Compressed<T> permuted(const SupernodalSymbolic& s, CsrView<T> a, bool lower, bool by_row) {
+    const index_t* rp = a.row_ptr();
+    const sparse_index_t* ci = a.col_idx();
+    std::vector<index_t> keep;
+    std::vector<sparse_index_t> row_of;
+    keep.reserve(at(a.nnz()));
+    row_of.reserve(at(a.nnz()));
+    for (index_t r = 0; r < a.rows(); ++r) {
+        for (index_t k = rp[r]; k < rp[r + 1]; ++k) {
+            if (!lower || ci[k] <= r) {
+                keep.push_back(k);
+                row_of.push_back(static_cast<sparse_index_t>(r));
+            }
+        }
+    }
+    const auto row = [&](index_t k) -> index_t {
+        const index_t i = s.iperm[at(row_of[at(k)])];
+        const index_t j = s.iperm[at(ci[keep[at(k)]])];
+        return lower ? std::max(i, j) : i;
+    };
+    const auto col = [&](index_t k) -> index_t {
+        const index_t i = s.iperm[at(row_of[at(k)])];
+        const index_t j = s.iperm[at(ci[keep[at(k)]])];
+        return lower ? std::min(i, j) : j;
+    };
+    const auto val = [&](index_t k) { return a.values()[keep[at(k)]]; };
+    const auto nnz = static_cast<index_t>(keep.size());
+    return by_row ? compress<T>(s.n, s.n, nnz, row, col, val) : compress<T>(s.n, s.n, nnz, col, row, val);
+}
+
+/// Position in the sorted front rows `r` of each of the `len` sorted rows
+/// in `sub`, all of which occur in `r`.
+void positions(const sparse_index_t* r, const sparse_index_t* sub, index_t len, index_t* pos) {
+    index_t q = 0;
+    for (index_t k = 0; k < len; ++k) {
+        while (r[q] != sub[k]) {
+            ++q;
+        }
+        pos[k] = q;
+    }
+}
+
+/// Flop count of the factorization (`lu` twice Cholesky's).
+double factor_flops(const SupernodalSymbolic& s, bool lu) {
+    double flops = 0;
+    for (index_t k = 0; k < s.supernodes(); ++k) {
+        const auto ns = static_cast<double>(s.first[at(k) + 1] - s.first[at(k)]);
+        const auto r = static_cast<double>(s.row_ptr[at(k) + 1] - s.row_ptr[at(k)]) - ns;
+        flops += ns * ns * ns / 3 + ns * ns * r + ns * r * r;
+    }
+    return lu ? 2 * flops : flops;
+}
+
+/// Front scheduling: `wide[s]` fronts run after the graph with parallel
+/// kernels, in postorder; the rest are graph tasks after their children.
+template <typename F>
+void run_fronts(const SupernodalSymbolic& s, F&& front) {
+    const index_t ns = s.supernodes();
+    std::vector<char> wide(at(ns), 0);
+    if (parallel_concurrency() > 1) {
+        for (index_t k = 0; k < ns; ++k) {
+            wide[at(k)] =
+                wide[at(k)] != 0 || s.row_ptr[at(k) + 1] - s.row_ptr[at(k)] >= wide_front ? char(1) : char(0);
+            if (wide[at(k)] != 0 && s.parent[at(k)] >= 0) {
+                wide[at(s.parent[at(k)])] = 1;
+            }
+        }
+    }
+    TaskGraph g;
+    std::vector<TaskGraph::Id> task(at(ns), -1);
+    for (index_t k = 0; k < ns; ++k) {
+        if (wide[at(k)] == 0) {
+            task[at(k)] = g.add([&front, k] { front(k, true); }, k);
+        }
+    }
+    for (index_t k = 0; k < ns; ++k) {
+        if (const index_t up = s.parent[at(k)]; task[at(k)] >= 0 && up >= 0 && task[at(up)] >= 0) {
+            g.depend(task[at(up)], task[at(k)]);
+        }
+    }
+    g.run();
+    for (index_t k = 0; k < ns; ++k) {
+        if (wide[at(k)] != 0) {
+            front(k, false);
+        }
+    }
+}
+
+/// Children of every supernode, in order.
+std::vector<std::vector<index_t>> children_of(const SupernodalSymbolic& s) {
+    std::vector<std::vector<index_t>> kids(at(s.supernodes()));
+    for (index_t k = 0; k < s.supernodes(); ++k) {
+        if (s.parent[at(k)] >= 0) {
+            kids[at(s.parent[at(k)])].push_back(k);
+        }
+    }
+    return kids;
+}
+
+template <typename T>
+index_t cholesky_impl(const SupernodalSymbolic& s, CsrView<T> a, T* l) {
+    static const int prof_id = profile::detail::kernel_id("sparse_cholesky");
+    const auto prof = profile::Scope(prof_id, profile::dtype_of<T>(), s.n, factor_flops(s, false),
+                                     static_cast<double>(s.l_ptr.back()) * sizeof(T));
+    const Compressed<T> ap = permuted(s, a, true, false);
+    const std::vector<std::vector<index_t>> kids = children_of(s);
+    std::vector<Matrix<T>> update(at(s.supernodes()));
+    std::atomic<index_t> info{0};
+
+    run_fronts(s, [&](index_t k, bool local) {
+        if (info.load(std::memory_order_relaxed) != 0) {
+            return;
+        }
+        const index_t f = s.first[at(k)];
+        const index_t ns = s.first[at(k) + 1] - f;
+        const sparse_index_t* rows = s.rows.data() + s.row_ptr[at(k)];
+        const index_t m = s.row_ptr[at(k) + 1] - s.row_ptr[at(k)];
+        const MatrixView<T> panel(l + s.l_ptr[at(k)], m, ns, 1, m);
+        std::fill_n(panel.data(), m * ns, T(0));
+        Matrix<T> c(m - ns, m - ns);
+
+        for (index_t j = 0; j < ns; ++j) {
+            for (index_t q = ap.ptr[at(f + j)]; q < ap.ptr[at(f + j) + 1]; ++q) {
+                const index_t i = std::lower_bound(rows, rows + m, ap.idx[at(q)]) - rows;
+                panel(i, j) += ap.val[at(q)];
+            }
+        }
+        Workspace& ws = thread_workspace();
+        for (const index_t ch : kids[at(k)]) {
+            Workspace::Scope scope(ws);
+            const index_t cn = s.first[at(ch) + 1] - s.first[at(ch)];
+            const index_t len = s.row_ptr[at(ch) + 1] - s.row_ptr[at(ch)] - cn;
+            index_t* pos = ws.allocate_n<index_t>(at(len));
+            positions(rows, s.rows.data() + s.row_ptr[at(ch)] + cn, len, pos);
+            const Matrix<T>& cu = update[at(ch)];
+            for (index_t jb = 0; jb < len; ++jb) {
+                const index_t pj = pos[jb];
+                for (index_t ib = jb; ib < len; ++ib) {
+                    const T v = cu(ib, jb);
+                    if (pj < ns) {
+                        panel(pos[ib], pj) += v;
+                    } else {
+                        c(pos[ib] - ns, pj - ns) += v;
+                    }
+                }
+            }
+            update[at(ch)] = Matrix<T>();
+        }
+
+        const MatrixView<T> l11 = panel.block(0, 0, ns, ns);
+        const MatrixView<T> l21 = panel.block(ns, 0, m - ns, ns);
+        if (const index_t r = potrf_on(local, l11); r != 0) {
+            index_t none = 0;
+            info.compare_exchange_strong(none, f + r);
+            return;
+        }
+        if (m > ns) {
+            trsm_on(local, true, false, l11, l21.t());
+            syrk_on(local, l21, c.view());
+        }
+        update[at(k)] = std::move(c);
+    });
+    return info.load();
+}
+
+/// Unblocked LU with partial pivoting whose pivots below `tiny` in
+/// magnitude are replaced by +-tiny; returns how many were.
+template <typename T>
+index_t getf2_static(MatrixView<T> a, std::int32_t* ipiv, T tiny) {
+    const index_t n = a.rows();
+    index_t perturbed = 0;
+    for (index_t k = 0; k < n; ++k) {
+        index_t p = k;
+        for (index_t i = k + 1; i < n; ++i) {
+            if (std::abs(a(i, k)) > std::abs(a(p, k))) {
+                p = i;
+            }
+        }
+        ipiv[k] = static_cast<std::int32_t>(p);
+        if (p != k) {
+            for (index_t j = 0; j < n; ++j) {
+                std::swap(a(k, j), a(p, j));
+            }
+        }
+        if (std::abs(a(k, k)) < tiny) {
+            a(k, k) = a(k, k) < T(0) ? -tiny : tiny;
+            ++perturbed;
+        }
+        const T inv = T(1) / a(k, k);
+        for (index_t i = k + 1; i < n; ++i) {
+            a(i, k) *= inv;
+        }
+        for (index_t j = k + 1; j < n; ++j) {
+            const T x = a(k, j);
+            for (index_t i = k + 1; i < n; ++i) {
+                a(i, j) -= a(i, k) * x;
+            }
+        }
+    }
+    return perturbed;
+}
+
+/// Row interchanges k <-> ipiv[k], in order (or reversed), on rows of b.
+template <typename T>
+void swap_rows(MatrixView<T> b, const std::int32_t* ipiv, index_t n, bool forward) {
+    for (index_t s = 0; s < n; ++s) {
+        const index_t k = forward ? s : n - 1 - s;
+        if (ipiv[k] != k) {
+            for (index_t j = 0; j < b.cols(); ++j) {
+                std::swap(b(k, j), b(ipiv[k], j));
+            }
+        }
+    }
+}
+
+template <typename T>
+index_t lu_impl(const SupernodalSymbolic& s, CsrView<T> a, T* l, T* u, std::int32_t* ipiv) {
+    static const int prof_id = profile::detail::kernel_id("sparse_lu");
+    const auto prof = profile::Scope(prof_id, profile::dtype_of<T>(), s.n, factor_flops(s, true),
+                                     static_cast<double>(s.l_ptr.back() + s.u_ptr.back()) * sizeof(T));
+    const Compressed<T> by_col = permuted(s, a, false, false);
+    const Compressed<T> by_row = permuted(s, a, false, true);
+    T amax = T(0);
+    for (const T v : by_col.val) {
+        amax = std::max(amax, std::abs(v));
+    }
+    const T tiny = std::sqrt(std::numeric_limits<T>::epsilon()) * amax;
+    const std::vector<std::vector<index_t>> kids = children_of(s);
+    std::vector<Matrix<T>> update(at(s.supernodes()));
+    std::atomic<index_t> weak{0};
+
+    run_fronts(s, [&](index_t k, bool local) {
+        const index_t f = s.first[at(k)];
+        const index_t ns = s.first[at(k) + 1] - f;
+        const sparse_index_t* rows = s.rows.data() + s.row_ptr[at(k)];
+        const index_t m = s.row_ptr[at(k) + 1] - s.row_ptr[at(k)];
+        const MatrixView<T> panel(l + s.l_ptr[at(k)], m, ns, 1, m);
+        const MatrixView<T> u12(u + s.u_ptr[at(k)], ns, m - ns, 1, ns);
+        std::fill_n(panel.data(), m * ns, T(0));
+        std::fill_n(u12.data(), ns * (m - ns), T(0));
+        Matrix<T> c(m - ns, m - ns);
+        const auto find = [&](sparse_index_t i) { return std::lower_bound(rows, rows + m, i) - rows; };
+
+        for (index_t j = 0; j < ns; ++j) {
+            for (index_t q = by_col.ptr[at(f + j)]; q < by_col.ptr[at(f + j) + 1]; ++q) {
+                if (by_col.idx[at(q)] >= f) {
+                    panel(find(by_col.idx[at(q)]), j) += by_col.val[at(q)];
+                }
+            }
+            for (index_t q = by_row.ptr[at(f + j)]; q < by_row.ptr[at(f + j) + 1]; ++q) {
+                if (by_row.idx[at(q)] >= f + ns) {
+                    u12(j, find(by_row.idx[at(q)]) - ns) += by_row.val[at(q)];
+                }
+            }
+        }
+        Workspace& ws = thread_workspace();
+        for (const index_t ch : kids[at(k)]) {
+            Workspace::Scope scope(ws);
+            const index_t cn = s.first[at(ch) + 1] - s.first[at(ch)];
+            const index_t len = s.row_ptr[at(ch) + 1] - s.row_ptr[at(ch)] - cn;
+            index_t* pos = ws.allocate_n<index_t>(at(len));
+            positions(rows, s.rows.data() + s.row_ptr[at(ch)] + cn, len, pos);
+            const Matrix<T>& cu = update[at(ch)];
+            for (index_t jb = 0; jb < len; ++jb) {
+                const index_t pj = pos[jb];
+                for (index_t ib = 0; ib < len; ++ib) {
+                    const index_t pi = pos[ib];
+                    const T v = cu(ib, jb);
+                    if (pj < ns) {
+                        panel(pi, pj) += v;
+                    } else if (pi < ns) {
+                        u12(pi, pj - ns) += v;
+                    } else {
+                        c(pi - ns, pj - ns) += v;
+                    }
+                }
+            }
+            update[at(ch)] = Matrix<T>();
+        }
+
+        // Pivot within the front's own rows; fall back to static pivoting
+        // if that leaves a pivot below `tiny`.
+        const MatrixView<T> f11 = panel.block(0, 0, ns, ns);
+        std::int32_t* piv = ipiv + f;
+        {
+            Workspace::Scope scope(ws);
+            const MatrixView<T> saved = ws.matrix<T>(ns, ns);
+            saved.assign(f11);
+            bool ok = getrf_on(local, f11, piv) == 0;
+            for (index_t j = 0; ok && j < ns; ++j) {
+                ok = std::abs(f11(j, j)) >= tiny;
+            }
+            if (!ok) {
+                f11.assign(saved);
+                weak.fetch_add(getf2_static(f11, piv, tiny), std::memory_order_relaxed);
+            }
+        }
+        if (m > ns) {
+            const MatrixView<T> l21 = panel.block(ns, 0, m - ns, ns);
+            swap_rows(u12, piv, ns, true);
+            trsm_on(local, true, true, f11, u12);
+            trsm_on(local, true, false, f11.t(), l21.t());
+            gemm_on(local, T(-1), l21, u12, T(1), c.view());
+            index_t grown = 0;
+            for (index_t j = 0; j < ns; ++j) {
+                for (index_t i = 0; i < m - ns; ++i) {
+                    if (std::abs(l21(i, j)) * T(pivot_threshold) > T(1)) {
+                        ++grown;
+                        break;
+                    }
+                }
+            }
+            weak.fetch_add(grown, std::memory_order_relaxed);
+        }
+        update[at(k)] = std::move(c);
+    });
+    return weak.load();
+}
+
+// ---------------------------------------------------------------------------
+// Solves
+
+/// X = P * B into workspace, or B = P^T * X back.
+template <typename T>
+void permute_rows(const SupernodalSymbolic& s, MatrixView<T> b, MatrixView<T> x, bool in) {
+    for (index_t j = 0; j < b.cols(); ++j) {
+        for (index_t i = 0; i < s.n; ++i) {
+            T& orig = b(s.perm[at(i)], j);
+            if (in) {
+                x(i, j) = orig;
+            } else {
+                orig = x(i, j);
+            }
+        }
+    }
+}
+
+/// Solve skeleton over the supernodes: lower(k, xs, local) and
+/// upper(k, xs, local) do the diagonal-block solves, and the off-diagonal
+/// panels `below(k)` (m - ns x ns) and `right(k)` (ns x m - ns) are
+/// applied through gathered rows of x.
+template <typename T, typename Below, typename Right, typename Lower, typename Upper>
+void supernodal_solve(const SupernodalSymbolic& s, MatrixView<T> b, Below&& below, Right&& right, Lower&& lower,
+                      Upper&& upper) {
+    const index_t nrhs = b.cols();
+    Workspace& ws = thread_workspace();
+    Workspace::Scope scope(ws);
+    const MatrixView<T> x = ws.matrix<T>(s.n, nrhs);
+    permute_rows(s, b, x, true);
+    const auto front = [&](index_t k, index_t& f, index_t& ns, index_t& len, const sparse_index_t*& tail) {
+        f = s.first[at(k)];
+        ns = s.first[at(k) + 1] - f;
+        len = s.row_ptr[at(k) + 1] - s.row_ptr[at(k)] - ns;
+        tail = s.rows.data() + s.row_ptr[at(k)] + ns;
+        return (ns + len) * nrhs < solve_local_work;
+    };
+    for (index_t k = 0; k < s.supernodes(); ++k) {
+        index_t f, ns, len;
+        const sparse_index_t* tail;
+        const bool local = front(k, f, ns, len, tail);
+        const MatrixView<T> xs = x.block(f, 0, ns, nrhs);
+        lower(k, xs, local);
+        if (len > 0) {
+            Workspace::Scope inner(ws);
+            const MatrixView<T> t = ws.matrix<T>(len, nrhs);
+            gemm_on(local, T(1), below(k), MatrixView<const T>(xs), T(0), t);
+            for (index_t j = 0; j < nrhs; ++j) {
+                for (index_t i = 0; i < len; ++i) {
+                    x(tail[i], j) -= t(i, j);
+                }
+            }
+        }
+    }
+    for (index_t k = s.supernodes() - 1; k >= 0; --k) {
+        index_t f, ns, len;
+        const sparse_index_t* tail;
+        const bool local = front(k, f, ns, len, tail);
+        const MatrixView<T> xs = x.block(f, 0, ns, nrhs);
+        if (len > 0) {
+            Workspace::Scope inner(ws);
+            const MatrixView<T> t = ws.matrix<T>(len, nrhs);
+            for (index_t j = 0; j < nrhs; ++j) {
+                for (index_t i = 0; i < len; ++i) {
+                    t(i, j) = x(tail[i], j);
+                }
+            }
+            gemm_on(local, T(-1), right(k), MatrixView<const T>(t), T(1), xs);
+        }
+        upper(k, xs, local);
+    }
+    permute_rows(s, b, x, false);
+}
+
+template <typename T>
+void cholesky_solve_impl(const SupernodalSymbolic& s, const T* l, MatrixView<T> b) {
+    const auto panel = [&](index_t k) {
+        const index_t ns = s.first[at(k) + 1] - s.first[at(k)];
+        const index_t m = s.row_ptr[at(k) + 1] - s.row_ptr[at(k)];
+        return MatrixView<const T>(l + s.l_ptr[at(k)], m, ns, 1, m);
+    };
+    const auto diag = [&](index_t k) { return panel(k).block(0, 0, panel(k).cols(), panel(k).cols()); };
+    supernodal_solve(
+        s, b,
+        [&](index_t k) {
+            const MatrixView<const T> p = panel(k);
+            return p.block(p.cols(), 0, p.rows() - p.cols(), p.cols());
+        },
+        [&](index_t k) {
+            const MatrixView<const T> p = panel(k);
+            return p.block(p.cols(), 0, p.rows() - p.cols(), p.cols()).t();
+        },
+        [&](index_t k, MatrixView<T> xs, bool local) { trsm_on(local, true, false, diag(k), xs); },
+        [&](index_t k, MatrixView<T> xs, bool local) { trsm_on(local, false, false, diag(k).t(), xs); });
+}
+
+template <typename T>
+void lu_solve_impl(const SupernodalSymbolic& s, const T* l, const T* u, const std::int32_t* ipiv, MatrixView<T> b) {
+    const auto panel = [&](index_t k) {
+        const index_t ns = s.first[at(k) + 1] - s.first[at(k)];
+        const index_t m = s.row_ptr[at(k) + 1] - s.row_ptr[at(k)];
+        return MatrixView<const T>(l + s.l_ptr[at(k)], m, ns, 1, m);
+    };
+    const auto diag = [&](index_t k) { return panel(k).block(0, 0, panel(k).cols(), panel(k).cols()); };
+    supernodal_solve(
+        s, b,
+        [&](index_t k) {
+            const MatrixView<const T> p = panel(k);
+            return p.block(p.cols(), 0, p.rows() - p.cols(), p.cols());
+        },
+        [&](index_t k) {
+            const MatrixView<const T> p = panel(k);
+            return MatrixView<const T>(u + s.u_ptr[at(k)], p.cols(), p.rows() - p.cols(), 1, p.cols());
+        },
+        [&](index_t k, MatrixView<T> xs, bool local) {
+            swap_rows(xs, ipiv + s.first[at(k)], xs.rows(), true);
+            trsm_on(local, true, true, diag(k), xs);
+        },
+        [&](index_t k, MatrixView<T> xs, bool local) { trsm_on(local, false, false, diag(k), xs); });
+}
+
+template <typename T>
+index_t transversal_impl(CsrView<T> a, sparse_index_t* match) {
+    const index_t n = a.rows();
+    const index_t* rp = a.row_ptr();
+    const sparse_index_t* ci = a.col_idx();
+    const T* av = a.values();
+    std::fill_n(match, n, sparse_index_t(-1));
+    std::vector<index_t> owner(at(n), -1);
+    // Cheap pass: each row takes its largest entry in a free column.
+    for (index_t i = 0; i < n; ++i) {
+        index_t best = -1;
+        for (index_t k = rp[i]; k < rp[i + 1]; ++k) {
+            if (owner[at(ci[k])] < 0 && (best < 0 || std::abs(av[k]) > std::abs(av[best]))) {
+                best = k;
+            }
+        }
+        if (best >= 0) {
+            match[at(i)] = ci[best];
+            owner[at(ci[best])] = i;
+        }
+    }
+    // Depth-first augmenting paths for the rows still unmatched.
+    std::vector<index_t> seen(at(n), -1);
+    std::vector<index_t> next(at(n));
+    std::vector<index_t> path;
+    for (index_t i0 = 0; i0 < n; ++i0) {
+        if (match[at(i0)] >= 0) {
+            continue;
+        }
+        path.assign(1, i0);
+        next[at(i0)] = rp[i0];
+        index_t free_col = -1;
+        while (!path.empty() && free_col < 0) {
+            const index_t r = path.back();
+            bool descended = false;
+            while (next[at(r)] < rp[r + 1]) {
+                const index_t j = ci[next[at(r)]++];
+                if (seen[at(j)] == i0) {
+                    continue;
+                }
+                seen[at(j)] = i0;
+                if (owner[at(j)] < 0) {
+                    free_col = j;
+                } else {
+                    const index_t r2 = owner[at(j)];
+                    next[at(r2)] = rp[r2];
+                    path.push_back(r2);
+                    descended = true;
+                }
+                break;
+            }
+            if (free_col < 0 && !descended) {
+                path.pop_back();
+            }
+        }
+        // Each row on the path takes the column its successor held.
+        for (index_t j = free_col, t = static_cast<index_t>(path.size()) - 1; j >= 0 && t >= 0; --t) {
+            const index_t r = path[at(t)];
+            const index_t prev = match[at(r)];
+            match[at(r)] = static_cast<sparse_index_t>(j);
+            owner[at(j)] = r;
+            j = prev;
+        }
+    }
+    // A structurally singular pattern leaves rows over, still at -1.
+    return static_cast<index_t>(std::count_if(match, match + n, [](sparse_index_t j) { return j >= 0; }));
+}
+
+}  // namespace
+
+index_t transversal(CsrView<float> a, sparse_index_t* match) { return transversal_impl(a, match); }
+index_t transversal(CsrView<double> a, sparse_index_t* match) { return transversal_impl(a, match); }
+
+std::vector<sparse_index_t> fill_order(index_t n, const index_t* ptr, const sparse_index_t* idx, Ordering ordering,
+                                       bool lower) {
+    require_sparse_dims(n, n);
+    return order_graph(symmetrize(n, ptr, idx, lower), ordering);
+}
+
+SupernodalSymbolic analyse(index_t n, const index_t* ptr, const sparse_index_t* idx, Ordering ordering, bool lower) {
+    require_sparse_dims(n, n);
+    const Graph g = symmetrize(n, ptr, idx, lower);
+    return symbolic(g, order_graph(g, ordering));
+}
+
+index_t cholesky_numeric(const SupernodalSymbolic& s, CsrView<float> a, float* l) { return cholesky_impl(s, a, l); }
+index_t cholesky_numeric(const SupernodalSymbolic& s, CsrView<double> a, double* l) {
+    return cholesky_impl(s, a, l);
+}
+index_t lu_numeric(const SupernodalSymbolic& s, CsrView<float> a, float* l, float* u, std::int32_t* ipiv) {
+    return lu_impl(s, a, l, u, ipiv);
+}
+index_t lu_numeric(const SupernodalSymbolic& s, CsrView<double> a, double* l, double* u, std::int32_t* ipiv) {
+    return lu_impl(s, a, l, u, ipiv);
+}
+
+void cholesky_solve(const SupernodalSymbolic& s, const float* l, MatrixView<float> b) {
+    cholesky_solve_impl(s, l, b);
+}
+void cholesky_solve(const SupernodalSymbolic& s, const double* l, MatrixView<double> b) {
+    cholesky_solve_impl(s, l, b);
+}
+void lu_solve(const SupernodalSymbolic& s, const float* l, const float* u, const std::int32_t* ipiv,
+              MatrixView<float> b) {
+    lu_solve_impl(s, l, u, ipiv, b);
+}
+void lu_solve(const SupernodalSymbolic& s, const double* l, const double* u, const std::int32_t* ipiv,
+              MatrixView<double> b) {
+    lu_solve_impl(s, l, u, ipiv, b);
+}
+
+}  // namespace detail
+}  // namespace lana
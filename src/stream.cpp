@@ -0,0 +1,802 @@
+// Streaming (out-of-core) operations over dense sections of lana files.
+//
+// Every operation is a loop over tiles of the section, double-buffered:
+// while tile t is being computed on the pool, tile t + 1 is being read into
+// the other buffer. Reads are batches of (offset, length) segments, one per
+// stored row or column, since a tile is contiguous only when it spans the
+// section's full leading dimension. io_uring takes a whole batch with one
+// enter; without it a helper thread preads the segments in order.
+
+#include "lana/stream.hpp"
+#include "lana/error.hpp"
+#include "lana/gemm.hpp"
+#include "lana/memory.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#  include <linux/io_uring.h>
+#  include <sys/syscall.h>
+#  define LANA_HAVE_IO_URING 1
+#else
+#  define LANA_HAVE_IO_URING 0
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace lana::stream {
+namespace detail {
+namespace {
+
+/// Largest single read; pread and readv may return short past 2 GiB.
+constexpr std::size_t max_read = std::size_t(1) << 30;
+
+/// Tiles of a tall or wide section keep at least this extent across
+/// the storage order, so each tile's GEMM has a useful inner dimension.
+constexpr index_t min_tile_extent = 256;
+
+struct Segment {
+    std::uint64_t offset;
+    std::byte* dst;
+    std::size_t len;
+};
+
+/// The reads filling one tile buffer.
+struct Batch {
+    std::vector<Segment> segs;
+    std::size_t pending = 0;
+    int error = 0;  // errno of the first failure, or EIO for end of file
+};
+
+class Reader {
+public:
+    virtual ~Reader() = default;
+    /// Queues every segment of `b`; `b` must stay alive until wait(b).
+    virtual void start(Batch& b) = 0;
+    /// Blocks until every segment of `b` has been read.
+    virtual void wait(Batch& b) = 0;
+};
+
+/// preads on a helper thread, one segment at a time.
+class ThreadReader final : public Reader {
+public:
+    explicit ThreadReader(int fd) : fd_(fd), worker_([this] { loop(); }) {}
+
+    ~ThreadReader() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+            queue_.clear();
+        }
+        cv_.notify_all();
+        worker_.join();
+    }
+
+    void start(Batch& b) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            b.pending = b.segs.size();
+            for (std::size_t i = 0; i < b.segs.size(); ++i) {
+                queue_.push_back({&b, i});
+            }
+        }
+        cv_.notify_all();
+    }
+
+    void wait(Batch& b) override {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_.wait(lock, [&] { return b.pending == 0; });
+    }
+
+private:
+    struct Item {
+        Batch* batch;
+        std::size_t seg;
+    };
+
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+            if (stop_) {
+                return;
+            }
+            const Item it = queue_.front();
+            queue_.pop_front();
+            lock.unlock();
+            const int err = read_segment(it.batch->segs[it.seg]);
+            lock.lock();
+            if (err != 0 && it.batch->error == 0) {
+                it.batch->error = err;
+            }
+            if (--it.batch->pending == 0) {
+                done_.notify_all();
+            }
+        }
+    }
+
+    int read_segment(const Segment& s) const {
+        std::size_t done = 0;
+        while (done < s.len) {
+            const ssize_t r = ::pread(fd_, s.dst + done, std::min(s.len - done, max_read),
+                                      static_cast<off_t>(s.offset + done));
+            if (r < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return errno;
+            }
+            if (r == 0) {
+                return EIO;
+            }
+            done += static_cast<std::size_t>(r);
+        }
+        return 0;
+    }
+
+    int fd_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable done_;
+    std::deque<Item> queue_;
+    bool stop_ = false;
+    std::thread worker_;
+};
+
+#if LANA_HAVE_IO_URING
+
+/// io_uring through the raw system calls (no liburing dependency). Holds
+/// at most `entries` reads in flight; the rest wait in a queue and are
+/// submitted as completions free slots.
+class UringReader final : public Reader {
+public:
+    /// Null when the kernel (or a seccomp policy) does not allow io_uring.
+    static std::unique_ptr<Reader> open(int fd) {
+        auto r = std::unique_ptr<UringReader>(new UringReader(fd));
+        if (r->ring_fd_ < 0) {
+            return nullptr;
+        }
+        return r;
+    }
+
+    ~UringReader() override {
+        queue_.clear();
+        while (inflight_ > 0 && enter(0, 1)) {
+            reap();
+        }
+        if (sqes_ != nullptr) {
+            ::munmap(sqes_, sqes_size_);
+        }
+        if (cq_ptr_ != nullptr && cq_ptr_ != sq_ptr_) {
+            ::munmap(cq_ptr_, cq_size_);
+        }
+        if (sq_ptr_ != nullptr) {
+            ::munmap(sq_ptr_, sq_size_);
+        }
+        if (ring_fd_ >= 0) {
+            ::close(ring_fd_);
+        }
+    }
+
+    void start(Batch& b) override {
+        b.pending = b.segs.size();
+        for (std::size_t i = 0; i < b.segs.size(); ++i) {
+            queue_.push_back({&b, i, 0, {}});
+        }
+        submit();
+    }
+
+    void wait(Batch& b) override {
+        while (b.pending > 0) {
+            submit();
+            if (!enter(0, 1)) {
+                fail_ring();
+            }
+            reap();
+        }
+    }
+
+private:
+    static constexpr unsigned entries = 64;
+
+    struct Pending {
+        Batch* batch;
+        std::size_t seg;
+        std::size_t done;
+        iovec iov;
+    };
+
+    explicit UringReader(int fd) : fd_(fd) {
+        io_uring_params p{};
+        ring_fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &p));
+        if (ring_fd_ < 0) {
+            return;
+        }
+        sq_size_ = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+        cq_size_ = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+        const bool single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single) {
+            sq_size_ = cq_size_ = std::max(sq_size_, cq_size_);
+        }
+        sq_ptr_ = map(sq_size_, IORING_OFF_SQ_RING);
+        cq_ptr_ = single ? sq_ptr_ : map(cq_size_, IORING_OFF_CQ_RING);
+        sqes_size_ = p.sq_entries * sizeof(io_uring_sqe);
+        sqes_ = static_cast<io_uring_sqe*>(map(sqes_size_, IORING_OFF_SQES));
+        if (sq_ptr_ == nullptr || cq_ptr_ == nullptr || sqes_ == nullptr) {
+            ::close(ring_fd_);
+            ring_fd_ = -1;
+            return;
+        }
+        auto* sq = static_cast<std::byte*>(sq_ptr_);
+        auto* cq = static_cast<std::byte*>(cq_ptr_);
+        sq_tail_ = reinterpret_cast<unsigned*>(sq + p.sq_off.tail);
+        sq_mask_ = *reinterpret_cast<unsigned*>(sq + p.sq_off.ring_mask);
+        sq_array_ = reinterpret_cast<unsigned*>(sq + p.sq_off.array);
+        cq_head_ = reinterpret_cast<unsigned*>(cq + p.cq_off.head);
+        cq_tail_ = reinterpret_cast<unsigned*>(cq + p.cq_off.tail);
+        cq_mask_ = *reinterpret_cast<unsigned*>(cq + p.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + p.cq_off.cqes);
+        slots_.resize(entries);
+        for (unsigned i = 0; i < entries; ++i) {
+            free_.push_back(entries - 1 - i);
+        }
+    }
+
+    void* map(std::size_t size, std::uint64_t off) const {
+        void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd_,
+                         static_cast<off_t>(off));
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    /// io_uring_enter; false on failure other than EINTR.
+    bool enter(unsigned to_submit, unsigned min_complete) const {
+        for (;;) {
+            const long r = ::syscall(__NR_io_uring_enter, ring_fd_, to_submit, min_complete,
+                                     min_complete > 0 ? IORING_ENTER_GETEVENTS : 0u, nullptr, 0);
+            if (r >= 0) {
+                return true;
+            }
+            if (errno != EINTR) {
+                return false;
+            }
+        }
+    }
+
+    /// Moves queued reads into free ring slots and submits them.
+    void submit() {
+        unsigned tail = *sq_tail_;
+        unsigned added = 0;
+        while (!queue_.empty() && !free_.empty()) {
+            const unsigned slot = free_.back();
+            free_.pop_back();
+            Pending& pd = slots_[slot];
+            pd = queue_.front();
+            queue_.pop_front();
+            const Segment& s = pd.batch->segs[pd.seg];
+            pd.iov.iov_base = s.dst + pd.done;
+            pd.iov.iov_len = std::min(s.len - pd.done, max_read);
+
+            const unsigned idx = tail & sq_mask_;
+            io_uring_sqe& sqe = sqes_[idx];
+            std::memset(&sqe, 0, sizeof(sqe));
+            sqe.opcode = IORING_OP_READV;
+            sqe.fd = fd_;
+            sqe.addr = reinterpret_cast<std::uint64_t>(&pd.iov);
+            sqe.len = 1;
+            sqe.off = s.offset + pd.done;
+            sqe.user_data = slot;
+            sq_array_[idx] = idx;
+            ++tail;
+            ++added;
+        }
+        if (added == 0) {
+            return;
+        }
+        std::atomic_ref<unsigned>(*sq_tail_).store(tail, std::memory_order_release);
+        inflight_ += added;
+        if (!enter(added, 0)) {
+            fail_ring();
+        }
+    }
+
+    /// Consumes completions: finished segments count down their batch,
+    /// short reads go back to the queue for the remainder.
+    void reap() {
+        unsigned head = *cq_head_;
+        const unsigned tail = std::atomic_ref<unsigned>(*cq_tail_).load(std::memory_order_acquire);
+        for (; head != tail; ++head) {
+            const io_uring_cqe& cqe = cqes_[head & cq_mask_];
+            const auto slot = static_cast<unsigned>(cqe.user_data);
+            Pending pd = slots_[slot];
+            free_.push_back(slot);
+            --inflight_;
+            const int res = cqe.res;
+            const Segment& s = pd.batch->segs[pd.seg];
+            if (res == -EINTR || res == -EAGAIN) {
+                queue_.push_front(pd);
+            } else if (res <= 0) {
+                finish(*pd.batch, res < 0 ? -res : EIO);
+            } else if (pd.done + static_cast<std::size_t>(res) < s.len) {
+                pd.done += static_cast<std::size_t>(res);
+                queue_.push_front(pd);
+            } else {
+                finish(*pd.batch, 0);
+            }
+        }
+        std::atomic_ref<unsigned>(*cq_head_).store(head, std::memory_order_release);
+    }
+
+    static void finish(Batch& b, int err) {
+        if (err != 0 && b.error == 0) {
+            b.error = err;
+        }
+        --b.pending;
+    }
+
+    /// The ring itself failed; reads already submitted are drained by the
+    /// destructor.
+    [[noreturn]] void fail_ring() {
+        const int err = errno;
+        queue_.clear();
+        throw IoError(std::string("lana: io_uring_enter failed: ") + std::strerror(err));
+    }
+
+    int fd_;
+    int ring_fd_ = -1;
+    void* sq_ptr_ = nullptr;
+    void* cq_ptr_ = nullptr;
+    std::size_t sq_size_ = 0;
+    std::size_t cq_size_ = 0;
+    std::size_t sqes_size_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    unsigned* sq_tail_ = nullptr;
+    unsigned sq_mask_ = 0;
+    unsigned* sq_array_ = nullptr;
+    unsigned* cq_head_ = nullptr;
+    unsigned* cq_tail_ = nullptr;
+    unsigned cq_mask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    unsigned inflight_ = 0;
+    std::deque<Pending> queue_;
+    std::vector<Pending> slots_;
+    std::vector<unsigned> free_;
+};
+
+#endif  // LANA_HAVE_IO_URING
+
+std::unique_ptr<Reader> make_reader(int fd, const StreamOptions& opts) {
+#if LANA_HAVE_IO_URING
+    if (opts.io_uring) {
+        if (std::unique_ptr<Reader> r = UringReader::open(fd)) {
+            return r;
+        }
+    }
+#else
+    (void)opts;
+#endif
+    return std::make_unique<ThreadReader>(fd);
+}
+
+/// Which tile shapes an operation accepts.
+enum class Tiling {
+    Storage,    ///< any; follow the storage order
+    RowPanels,  ///< full rows only
+};
+
+struct Rect {
+    index_t r0, c0, rows, cols;
+};
+
+template <typename T>
+void check_dtype(const Source& a, const char* what) {
+    const Dtype want = std::is_same_v<T, float> ? Dtype::F32 : Dtype::F64;
+    if (a.info().dtype != want) {
+        throw IoError(std::string("lana: ") + what + ": section '" + a.info().name + "' in '" + a.path() +
+                      "' has a different element type");
+    }
+}
+
+/// Tiles covering the section in storage order. Shapes are given for a
+/// column-major section; a row-major one is tiled through its transpose.
+std::vector<Rect> tiles(index_t rows, index_t cols, bool row_major, Tiling how, std::size_t budget) {
+    // inner: the contiguous extent; outer: the other one.
+    const index_t inner = row_major ? cols : rows;
+    const index_t outer = row_major ? rows : cols;
+    const auto b = static_cast<index_t>(std::max<std::size_t>(budget, 1));
+    index_t ti = inner;
+    index_t to = std::clamp<index_t>(b / std::max<index_t>(inner, 1), 1, std::max<index_t>(outer, 1));
+    const bool full_rows_needed = how == Tiling::RowPanels;
+    if (full_rows_needed && !row_major) {
+        // Full rows of a column-major section: every column, few rows.
+        to = std::max<index_t>(outer, 1);
+        ti = std::clamp<index_t>(b / to, 1, std::max<index_t>(inner, 1));
+    } else if (!full_rows_needed || !row_major) {
+        if (to < std::min(outer, min_tile_extent)) {
+            to = std::min(outer, min_tile_extent);
+            ti = std::clamp<index_t>(b / to, 1, std::max<index_t>(inner, 1));
+        }
+    }
+    // A row-major section in row panels keeps full rows (ti = inner).
+    std::vector<Rect> out;
+    for (index_t o = 0; o < outer; o += to) {
+        for (index_t i = 0; i < inner; i += ti) {
+            const index_t oi = std::min(to, outer - o);
+            const index_t ii = std::min(ti, inner - i);
+            out.push_back(row_major ? Rect{o, i, oi, ii} : Rect{i, o, ii, oi});
+        }
+    }
+    return out;
+}
+
+/// Calls fn(tile, rect) for each tile of `a`, each one read while the
+/// previous is computed. `tile` views a buffer the callee may modify.
+template <typename T, typename F>
+void for_each_tile(const Source& a, Tiling how, const StreamOptions& opts, F&& fn) {
+    const SectionInfo& s = a.info();
+    if (s.rows == 0 || s.cols == 0) {
+        return;
+    }
+    const bool row_major = s.layout == Layout::RowMajor;
+    const std::vector<Rect> rects = tiles(s.rows, s.cols, row_major, how, opts.tile_bytes / sizeof(T));
+    std::size_t max_elems = 0;
+    for (const Rect& r : rects) {
+        max_elems = std::max(max_elems, static_cast<std::size_t>(r.rows * r.cols));
+    }
+
+    using Buffer = lana::detail::AlignedBuffer<T>;
+    Buffer buf[2] = {Buffer(max_elems), Buffer(rects.size() > 1 ? max_elems : 0)};
+    Batch batch[2];
+    const std::unique_ptr<Reader> reader = make_reader(a.fd(), opts);
+
+    // Segments of one tile: one per stored column (row) across it, merged
+    // where they are adjacent in the file.
+    auto prepare = [&](const Rect& r, T* dst, Batch& b) {
+        b.segs.clear();
+        b.error = 0;
+        const index_t n_seg = row_major ? r.rows : r.cols;
+        const index_t len = row_major ? r.cols : r.rows;
+        for (index_t k = 0; k < n_seg; ++k) {
+            const index_t first = row_major ? (r.r0 + k) * s.ld + r.c0 : (r.c0 + k) * s.ld + r.r0;
+            const std::uint64_t off = a.offset() + static_cast<std::uint64_t>(first) * sizeof(T);
+            auto* d = reinterpret_cast<std::byte*>(dst + k * len);
+            const std::size_t bytes = static_cast<std::size_t>(len) * sizeof(T);
+            if (!b.segs.empty()) {
+                Segment& last = b.segs.back();
+                if (last.offset + last.len == off && last.dst + last.len == d) {
+                    last.len += bytes;
+                    continue;
+                }
+            }
+            b.segs.push_back({off, d, bytes});
+        }
+        reader->start(b);
+    };
+
+    prepare(rects[0], buf[0].data(), batch[0]);
+    for (std::size_t t = 0; t < rects.size(); ++t) {
+        Batch& cur = batch[t % 2];
+        reader->wait(cur);
+        if (cur.error != 0) {
+            throw IoError("lana: cannot read section '" + s.name + "' of '" + a.path() +
+                          "': " + std::strerror(cur.error));
+        }
+        if (t + 1 < rects.size()) {
+            prepare(rects[t + 1], buf[(t + 1) % 2].data(), batch[(t + 1) % 2]);
+        }
+        const Rect& r = rects[t];
+        T* data = buf[t % 2].data();
+        const MatrixView<T> tile =
+            row_major ? MatrixView<T>(data, r.rows, r.cols, r.cols, 1) : MatrixView<T>(data, r.rows, r.cols, 1, r.rows);
+        fn(tile, r);
+        if (opts.drop_cache) {
+            const std::uint64_t lo = cur.segs.front().offset;
+            const std::uint64_t hi = cur.segs.back().offset + cur.segs.back().len;
+            ::posix_fadvise(a.fd(), static_cast<off_t>(lo), static_cast<off_t>(hi - lo), POSIX_FADV_DONTNEED);
+        }
+    }
+}
+
+template <typename T>
+void scale(T beta, MatrixView<T> c) {
+    if (beta == T(1)) {
+        return;
+    }
+    for (index_t j = 0; j < c.cols(); ++j) {
+        for (index_t i = 0; i < c.rows(); ++i) {
+            c(i, j) = beta == T(0) ? T(0) : beta * c(i, j);
+        }
+    }
+}
+
+profile::Scope stream_scope(int id, const Source& a, double flops) {
+    const double elems = static_cast<double>(a.rows()) * static_cast<double>(a.cols());
+    const std::size_t elem = a.info().dtype == Dtype::F32 ? sizeof(float) : sizeof(double);
+    return profile::Scope(id, a.info().dtype == Dtype::F32 ? profile::Dtype::f32 : profile::Dtype::f64,
+                          std::max(a.rows(), a.cols()), flops, elems * static_cast<double>(elem));
+}
+
+template <typename T>
+void gemm_impl(Op op, T alpha, const Source& a, MatrixView<const T> b, T beta, MatrixView<T> c,
+               const StreamOptions& opts) {
+    check_dtype<T>(a, "stream::gemm");
+    const index_t m = op == Op::NoTrans ? a.rows() : a.cols();
+    const index_t k = op == Op::NoTrans ? a.cols() : a.rows();
+    lana::detail::require_dims(c.rows() == m && b.rows() == k && c.cols() == b.cols(), "stream::gemm");
+    static const int prof_id = profile::detail::kernel_id("stream_gemm");
+    const profile::Scope prof =
+        stream_scope(prof_id, a, 2.0 * static_cast<double>(m) * static_cast<double>(k) * static_cast<double>(c.cols()));
+    scale(beta, c);
+    if (alpha == T(0) || c.cols() == 0) {
+        return;
+    }
+    const index_t n = c.cols();
+    for_each_tile<T>(a, Tiling::Storage, opts, [&](MatrixView<T> tile, const Rect& r) {
+        const MatrixView<const T> t = tile;
+        if (op == Op::NoTrans) {
+            lana::gemm(alpha, t, b.block(r.c0, 0, r.cols, n), T(1), c.block(r.r0, 0, r.rows, n));
+        } else {
+            lana::gemm(alpha, t.t(), b.block(r.r0, 0, r.rows, n), T(1), c.block(r.c0, 0, r.cols, n));
+        }
+    });
+}
+
+/// Below this order the lower-triangle recursion computes whole blocks.
+constexpr index_t gram_leaf = 128;
+
+/// Lower triangle of C += alpha * P^T P.
+template <typename T>
+void gram_lower(T alpha, MatrixView<const T> p, MatrixView<T> c) {
+    const index_t n = c.rows();
+    if (n <= gram_leaf) {
+        lana::gemm(alpha, p.t(), p, T(1), c);
+        return;
+    }
+    const index_t n1 = n / 2;
+    const index_t h = p.rows();
+    const MatrixView<const T> p1 = p.block(0, 0, h, n1);
+    const MatrixView<const T> p2 = p.block(0, n1, h, n - n1);
+    gram_lower(alpha, p1, c.block(0, 0, n1, n1));
+    lana::gemm(alpha, p2.t(), p1, T(1), c.block(n1, 0, n - n1, n1));
+    gram_lower(alpha, p2, c.block(n1, n1, n - n1, n - n1));
+}
+
+template <typename T>
+void mirror_lower(MatrixView<T> c) {
+    for (index_t j = 1; j < c.cols(); ++j) {
+        for (index_t i = 0; i < j; ++i) {
+            c(i, j) = c(j, i);
+        }
+    }
+}
+
+template <typename T>
+void gram_impl(T alpha, const Source& a, T beta, MatrixView<T> c, const StreamOptions& opts) {
+    check_dtype<T>(a, "stream::gram");
+    const index_t n = a.cols();
+    lana::detail::require_dims(c.rows() == n && c.cols() == n, "stream::gram");
+    static const int prof_id = profile::detail::kernel_id("stream_gram");
+    const profile::Scope prof =
+        stream_scope(prof_id, a, static_cast<double>(a.rows()) * static_cast<double>(n) * static_cast<double>(n));
+    if (alpha == T(0)) {
+        scale(beta, c);
+        return;
+    }
+    // Only the lower triangle of the product is accumulated. With beta = 0
+    // that is C itself; otherwise the upper triangle of beta * C must
+    // survive, so the product goes through a temporary.
+    Matrix<T> g;
+    MatrixView<T> acc = c;
+    if (beta != T(0)) {
+        g = Matrix<T>(n, n);
+        acc = g.view();
+    } else {
+        scale(T(0), c);
+    }
+    for_each_tile<T>(a, Tiling::RowPanels, opts,
+                     [&](MatrixView<T> tile, const Rect&) { gram_lower(alpha, MatrixView<const T>(tile), acc); });
+    mirror_lower(acc);
+    if (beta != T(0)) {
+        for (index_t j = 0; j < n; ++j) {
+            for (index_t i = 0; i < n; ++i) {
+                c(i, j) = beta * c(i, j) + g(i, j);
+            }
+        }
+    }
+}
+
+template <typename T>
+void covariance_impl(const Source& a, MatrixView<T> c, VectorView<T> mean, const StreamOptions& opts) {
+    check_dtype<T>(a, "stream::covariance");
+    const index_t n = a.cols();
+    const index_t m = a.rows();
+    lana::detail::require_dims(c.rows() == n && c.cols() == n && (mean.empty() || mean.size() == n) && m >= 2,
+                               "stream::covariance");
+    static const int prof_id = profile::detail::kernel_id("stream_covariance");
+    const profile::Scope prof =
+        stream_scope(prof_id, a, static_cast<double>(m) * static_cast<double>(n) * static_cast<double>(n));
+
+    // Accumulate G = sum (x - s)(x - s)^T and d = sum (x - s) with s the
+    // first row; then cov = (G - d d^T / m) / (m - 1).
+    std::vector<T> shift(static_cast<std::size_t>(n));
+    std::vector<double> d(static_cast<std::size_t>(n), 0.0);
+    scale(T(0), c);
+    bool first = true;
+    for_each_tile<T>(a, Tiling::RowPanels, opts, [&](MatrixView<T> tile, const Rect&) {
+        if (first) {
+            for (index_t j = 0; j < n; ++j) {
+                shift[static_cast<std::size_t>(j)] = tile(0, j);
+            }
+            first = false;
+        }
+        parallel_for(0, n, std::max<index_t>(1, 8192 / std::max<index_t>(tile.rows(), 1)), [&](index_t lo, index_t hi) {
+            for (index_t j = lo; j < hi; ++j) {
+                const T sj = shift[static_cast<std::size_t>(j)];
+                double sum = 0;
+                for (index_t i = 0; i < tile.rows(); ++i) {
+                    tile(i, j) -= sj;
+                    sum += tile(i, j);
+                }
+                d[static_cast<std::size_t>(j)] += sum;
+            }
+        });
+        gram_lower(T(1), MatrixView<const T>(tile), c);
+    });
+    const double inv_m = 1.0 / static_cast<double>(m);
+    const double inv_m1 = 1.0 / static_cast<double>(m - 1);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j; i < n; ++i) {
+            const double g = static_cast<double>(c(i, j)) -
+                             d[static_cast<std::size_t>(i)] * d[static_cast<std::size_t>(j)] * inv_m;
+            c(i, j) = static_cast<T>(g * inv_m1);
+        }
+    }
+    mirror_lower(c);
+    if (!mean.empty()) {
+        for (index_t j = 0; j < n; ++j) {
+            mean[j] = static_cast<T>(static_cast<double>(shift[static_cast<std::size_t>(j)]) +
+                                     d[static_cast<std::size_t>(j)] * inv_m);
+        }
+    }
+}
+
+template <typename T>
+void column_sums_impl(const Source& a, VectorView<T> out, const StreamOptions& opts) {
+    check_dtype<T>(a, "stream::column_sums");
+    lana::detail::require_dims(out.size() == a.cols(), "stream::column_sums");
+    static const int prof_id = profile::detail::kernel_id("stream_column_sums");
+    const profile::Scope prof =
+        stream_scope(prof_id, a, static_cast<double>(a.rows()) * static_cast<double>(a.cols()));
+    std::vector<double> acc(static_cast<std::size_t>(a.cols()), 0.0);
+    for_each_tile<T>(a, Tiling::Storage, opts, [&](MatrixView<T> tile, const Rect& r) {
+        for (index_t j = 0; j < tile.cols(); ++j) {
+            double s = 0;
+            for (index_t i = 0; i < tile.rows(); ++i) {
+                s += tile(i, j);
+            }
+            acc[static_cast<std::size_t>(r.c0 + j)] += s;
+        }
+    });
+    for (index_t j = 0; j < a.cols(); ++j) {
+        out[j] = static_cast<T>(acc[static_cast<std::size_t>(j)]);
+    }
+}
+
+template <typename T>
+double frobenius_impl(const Source& a, const StreamOptions& opts) {
+    double ss = 0;
+    for_each_tile<T>(a, Tiling::Storage, opts, [&](MatrixView<T> tile, const Rect&) {
+        for (index_t j = 0; j < tile.cols(); ++j) {
+            for (index_t i = 0; i < tile.rows(); ++i) {
+                const auto v = static_cast<double>(tile(i, j));
+                ss += v * v;
+            }
+        }
+    });
+    return std::sqrt(ss);
+}
+
+}  // namespace
+}  // namespace detail
+
+Source::Source(const std::string& path, const std::string& section) : path_(path) {
+    {
+        // Validation and the payload offset come from a mapping that is
+        // dropped again; nothing but the table is read through it.
+        const MappedFile file(path);
+        info_ = file.section(section);
+        if (info_.kind != SectionKind::Dense) {
+            throw IoError("lana: section '" + section + "' of '" + path + "' is not dense");
+        }
+        const void* p = info_.dtype == Dtype::F32 ? static_cast<const void*>(file.matrix_f32(section).data())
+                                                   : static_cast<const void*>(file.matrix_f64(section).data());
+        offset_ = static_cast<std::uint64_t>(static_cast<const std::byte*>(p) - file.data());
+    }
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        const int err = errno;
+        throw IoError("lana: cannot open '" + path + "': " + std::strerror(err));
+    }
+    ::posix_fadvise(fd_, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+Source::~Source() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+Source::Source(Source&& other) noexcept
+    : path_(std::move(other.path_)),
+      info_(std::move(other.info_)),
+      offset_(other.offset_),
+      fd_(std::exchange(other.fd_, -1)) {}
+
+Source& Source::operator=(Source&& other) noexcept {
+    if (this != &other) {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+        path_ = std::move(other.path_);
+        info_ = std::move(other.info_);
+        offset_ = other.offset_;
+        fd_ = std::exchange(other.fd_, -1);
+    }
+    return *this;
+}
+
+void gemm(Op op, float alpha, const Source& a, MatrixView<const float> b, float beta, MatrixView<float> c,
+          const StreamOptions& opts) {
+    detail::gemm_impl(op, alpha, a, b, beta, c, opts);
+}
+void gemm(Op op, double alpha, const Source& a, MatrixView<const double> b, double beta, MatrixView<double> c,
+          const StreamOptions& opts) {
+    detail::gemm_impl(op, alpha, a, b, beta, c, opts);
+}
+
+void gram(float alpha, const Source& a, float beta, MatrixView<float> c, const StreamOptions& opts) {
+    detail::gram_impl(alpha, a, beta, c, opts);
+}
+void gram(double alpha, const Source& a, double beta, MatrixView<double> c, const StreamOptions& opts) {
+    detail::gram_impl(alpha, a, beta, c, opts);
+}
+
+void covariance(const Source& a, MatrixView<float> c, VectorView<float> mean, const StreamOptions& opts) {
+    detail::covariance_impl(a, c, mean, opts);
+}
+void covariance(const Source& a, MatrixView<double> c, VectorView<double> mean, const StreamOptions& opts) {
+    detail::covariance_impl(a, c, mean, opts);
+}
+
+void column_sums(const Source& a, VectorView<float> out, const StreamOptions& opts) {
+    detail::column_sums_impl(a, out, opts);
+}
+void column_sums(const Source& a, VectorView<double> out, const StreamOptions& opts) {
+    detail::column_sums_impl(a, out, opts);
+}
+
+double frobenius_norm(const Source& a, const StreamOptions& opts) {
+    static const int prof_id = profile::detail::kernel_id("stream_frobenius_norm");
+    const profile::Scope prof =
+        detail::stream_scope(prof_id, a, 2.0 * static_cast<double>(a.rows()) * static_cast<double>(a.cols()));
+    return a.info().dtype == Dtype::F32 ? detail::frobenius_impl<float>(a, opts)
+                                        : detail::frobenius_impl<double>(a, opts);
+}
+
+}  // namespace lana::stream
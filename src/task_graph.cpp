@@ -0,0 +1,98 @@
+#include "task_graph.hpp"
+
+#include "lana/error.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <queue>
+#include <utility>
+
+namespace lana::detail {
+
+TaskGraph::Id TaskGraph::add(std::function<void()> fn, index_t priority) {
+    nodes_.push_back(Node{std::move(fn), priority, 0, {}});
+    return static_cast<Id>(nodes_.size()) - 1;
+}
+
+void TaskGraph::depend(Id task, Id before) {
+    nodes_[static_cast<std::size_t>(before)].next.push_back(task);
+    ++nodes_[static_cast<std::size_t>(task)].pending;
+}
+
+void TaskGraph::run() {
+    using Entry = std::pair<index_t, Id>;  // (priority, id), smallest first
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<>> ready;
+    for (Id i = 0; i < size(); ++i) {
+        if (nodes_[static_cast<std::size_t>(i)].pending == 0) {
+            ready.emplace(nodes_[static_cast<std::size_t>(i)].priority, i);
+        }
+    }
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    index_t remaining = size();
+    index_t running = 0;
+    std::exception_ptr error;
+
+    const auto driver = [&](index_t) {
+        std::unique_lock lock(mutex);
+        for (;;) {
+            if (!error && !ready.empty()) {
+                const Id id = ready.top().second;
+                ready.pop();
+                ++running;
+                lock.unlock();
+                Node& node = nodes_[static_cast<std::size_t>(id)];
+                std::exception_ptr failed;
+                try {
+                    node.fn();
+                } catch (...) {
+                    failed = std::current_exception();
+                }
+                lock.lock();
+                --running;
+                --remaining;
+                if (failed && !error) {
+                    error = failed;
+                }
+                std::size_t released = 0;
+                for (const Id n : node.next) {
+                    Node& succ = nodes_[static_cast<std::size_t>(n)];
+                    if (--succ.pending == 0) {
+                        ready.emplace(succ.priority, n);
+                        ++released;
+                    }
+                }
+                if (released > 1 || remaining == 0 || error) {
+                    cv.notify_all();
+                } else if (released == 1) {
+                    cv.notify_one();
+                }
+                continue;
+            }
+            if (remaining == 0 || (error && running == 0)) {
+                return;
+            }
+            if (running == 0) {
+                // Unfinished tasks but none ready or running: a cycle.
+                error = std::make_exception_ptr(Error("lana: task graph has a cycle"));
+                cv.notify_all();
+                return;
+            }
+            cv.wait(lock);
+        }
+    };
+
+    const index_t drivers = std::min<index_t>(parallel_concurrency(), size());
+    if (drivers > 0) {
+        parallel_run(drivers, driver);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}  // namespace lana::detail
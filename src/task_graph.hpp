@@ -0,0 +1,49 @@
+#pragma once
+
+// Dependency-graph scheduling on top of parallel_run.
+
+#include "lana/config.hpp"
+
+#include <functional>
+#include <vector>
+
+namespace lana::detail {
+
+/// A DAG of tasks run on the current executor.
+///
+/// run() opens one parallel region whose chunks act as drivers: each takes
+/// the ready task with the lowest priority value, runs it, and releases the
+/// tasks that were waiting on it. A driver with nothing ready sleeps only
+/// while some other driver is in the middle of a task, which keeps the
+/// Executor rule (never wait on work nobody has started), so the graph also
+/// completes on a single thread, in priority order.
+///
+/// Tasks should keep their own work on the calling thread (gemm_local
+/// rather than lana::gemm): the graph already occupies every driver.
+class TaskGraph {
+public:
+    using Id = index_t;
+
+    /// Adds a task; among ready tasks lower `priority` runs first.
+    Id add(std::function<void()> fn, index_t priority);
+
+    /// `task` runs only after `before` has finished.
+    void depend(Id task, Id before);
+
+    index_t size() const noexcept { return static_cast<index_t>(nodes_.size()); }
+
+    /// Runs every task. If one throws, no further tasks are started and the
+    /// first exception is rethrown once the running ones have finished.
+    void run();
+
+private:
+    struct Node {
+        std::function<void()> fn;
+        index_t priority;
+        index_t pending = 0;
+        std::vector<Id> next;
+    };
+    std::vector<Node> nodes_;
+};
+
+}  // namespace lana::detail
@@ -0,0 +1,581 @@
+#include "lana/thread_pool.hpp"
+
+#include "lana/error.hpp"
+#include "lana/workspace.hpp"
+
+#include "profile_internal.hpp"
+#include "topology.hpp"
+#include "work_deque.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#  include <immintrin.h>
+#endif
+
+namespace lana {
+
+Executor::~Executor() = default;
+
+namespace detail {
+
+namespace {
+
+inline void cpu_relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
+
+/// Spin iterations an idle worker polls for work before it sleeps.
+constexpr int idle_spins = 2048;
+
+int default_num_threads() {
+    if (const char* env = std::getenv("LANA_NUM_THREADS")) {
+        const int n = std::atoi(env);
+        if (n > 0) {
+            return n;
+        }
+    }
+    return static_cast<int>(host_topology().cpus.size());
+}
+
+std::atomic<Determinism>& determinism_slot() noexcept {
+    static std::atomic<Determinism> slot{[] {
+        const char* env = std::getenv("LANA_DETERMINISM");
+        return env != nullptr && std::strcmp(env, "bitwise") == 0 ? Determinism::Bitwise : Determinism::Fast;
+    }()};
+    return slot;
+}
+
+}  // namespace
+
+struct Task {
+    void (*fn)(Task*) = nullptr;
+};
+
+namespace {
+
+struct RunGroup {
+    explicit RunGroup(index_t n, FunctionRef<void(index_t)> b) : pending(n), body(b) {}
+    std::atomic<index_t> pending;
+    std::atomic<bool> failed{false};
+    std::mutex error_mutex;
+    std::exception_ptr error;
+    FunctionRef<void(index_t)> body;
+};
+
+struct RunTask : Task {
+    RunGroup* group = nullptr;
+    index_t index = 0;
+
+    static void invoke(Task* base) {
+        auto* t = static_cast<RunTask*>(base);
+        RunGroup* g = t->group;
+        if (!g->failed.load(std::memory_order_relaxed)) {
+            try {
+                g->body(t->index);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(g->error_mutex);
+                if (!g->error) {
+                    g->error = std::current_exception();
+                }
+                g->failed.store(true, std::memory_order_relaxed);
+            }
+        }
+        g->pending.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+struct HeapTask : Task {
+    std::function<void()> body;
+
+    // Like std::thread, an exception escaping a detached job terminates.
+    static void invoke(Task* base) noexcept {
+        std::unique_ptr<HeapTask> t(static_cast<HeapTask*>(base));
+        t->body();
+    }
+};
+
+}  // namespace
+
+class PoolImpl {
+public:
+    explicit PoolImpl(const ThreadPoolOptions& opts)
+        : concurrency_(opts.num_threads > 0 ? opts.num_threads : default_num_threads()) {
+        const Topology& topo = host_topology();
+        const int nworkers = concurrency_ - 1;
+        workers_.reserve(static_cast<std::size_t>(nworkers));
+        for (int w = 0; w < nworkers; ++w) {
+            auto worker = std::make_unique<Worker>();
+            if (opts.pin_threads && !topo.cpus.empty()) {
+                // Worker w takes CPU slot w + 1: slot 0 is left to the caller.
+                const std::size_t slot = static_cast<std::size_t>(w + 1) % topo.cpus.size();
+                worker->cpu = topo.cpus[slot];
+                worker->node = topo.nodes[slot];
+            }
+            workers_.push_back(std::move(worker));
+        }
+        build_victim_lists();
+        for (int w = 0; w < nworkers; ++w) {
+            workers_[static_cast<std::size_t>(w)]->thread = std::thread([this, w] { worker_main(w + 1); });
+        }
+    }
+
+    ~PoolImpl() {
+        stop_.store(true, std::memory_order_seq_cst);
+        wake(concurrency_);
+        for (auto& w : workers_) {
+            if (w->thread.joinable()) {
+                w->thread.join();
+            }
+        }
+    }
+
+    int concurrency() const noexcept { return concurrency_; }
+
+    int worker_node(int w) const noexcept {
+        if (w <= 0 || w > static_cast<int>(workers_.size())) {
+            return -1;
+        }
+        return workers_[static_cast<std::size_t>(w - 1)]->node;
+    }
+
+    int current_worker() const noexcept { return tls_pool == this ? tls_index : 0; }
+
+    static PoolImpl* current_pool() noexcept { return tls_pool; }
+
+    void submit(std::function<void()> fn) {
+        auto* t = new HeapTask;
+        t->fn = &HeapTask::invoke;
+        t->body = std::move(fn);
+        Task* tp = t;
+        push(&tp, 1);
+    }
+
+    void run(index_t n, FunctionRef<void(index_t)> body) {
+        if (n <= 0) {
+            return;
+        }
+        if (n == 1 || concurrency_ == 1) {
+            for (index_t i = 0; i < n; ++i) {
+                body(i);
+            }
+            return;
+        }
+        if (profile::enabled()) {
+            profile::detail::count(profile::detail::PoolEvent::region);
+        }
+        RunGroup group(n, body);
+        // The tasks live in the caller's workspace: regions nested inside
+        // this one (run by this thread while it waits) release theirs first,
+        // and a repeated region allocates nothing.
+        Workspace& ws = thread_workspace();
+        Workspace::Scope scope(ws);
+        RunTask* tasks = ws.allocate_n<RunTask>(static_cast<std::size_t>(n));
+        Task** ptrs = ws.allocate_n<Task*>(static_cast<std::size_t>(n));
+        // Pushed in reverse so the owner's LIFO pops start at index 0 while
+        // thieves take the far end of the range.
+        for (index_t i = 0; i < n; ++i) {
+            RunTask* t = ::new (tasks + i) RunTask;
+            t->fn = &RunTask::invoke;
+            t->group = &group;
+            t->index = i;
+            ptrs[n - 1 - i] = t;
+        }
+        push(ptrs, n);
+
+        const int self = current_worker();
+        while (group.pending.load(std::memory_order_acquire) > 0) {
+            if (Task* t = find_task(self)) {
+                execute(t);
+            } else {
+                cpu_relax();
+            }
+        }
+        if (group.error) {
+            std::rethrow_exception(group.error);
+        }
+    }
+
+private:
+    struct Worker {
+        WorkDeque<Task*> deque;
+        std::thread thread;
+        int cpu = -1;
+        int node = -1;
+        std::vector<int> victims;  // worker indices (1-based), same node first
+    };
+
+    void build_victim_lists() {
+        const int n = static_cast<int>(workers_.size());
+        for (int w = 0; w < n; ++w) {
+            std::vector<int> near;
+            std::vector<int> far;
+            for (int k = 1; k < n; ++k) {
+                const int v = (w + k) % n;
+                (workers_[static_cast<std::size_t>(v)]->node == workers_[static_cast<std::size_t>(w)]->node ? near
+                                                                                                             : far)
+                    .push_back(v + 1);
+            }
+            near.insert(near.end(), far.begin(), far.end());
+            workers_[static_cast<std::size_t>(w)]->victims = std::move(near);
+        }
+        for (int v = 0; v < n; ++v) {
+            outside_victims_.push_back(v + 1);
+        }
+    }
+
+    void push(Task* const* tasks, index_t n) {
+        const int self = current_worker();
+        if (self > 0) {
+            WorkDeque<Task*>& dq = workers_[static_cast<std::size_t>(self - 1)]->deque;
+            for (index_t i = 0; i < n; ++i) {
+                dq.push(tasks[i]);
+            }
+            if (profile::enabled()) {
+                profile::detail::count_push(static_cast<std::uint64_t>(dq.size()));
+            }
+        } else {
+            index_t depth = 0;
+            {
+                std::lock_guard<std::mutex> lock(inject_mutex_);
+                // Drop the consumed front before growing; erasing keeps the
+                // capacity, so the queue stops allocating once it has grown.
+                if (inject_head_ > 0 && 2 * inject_head_ >= inject_.size()) {
+                    inject_.erase(inject_.begin(), inject_.begin() + static_cast<std::ptrdiff_t>(inject_head_));
+                    inject_head_ = 0;
+                }
+                inject_.insert(inject_.end(), tasks, tasks + n);
+                depth = static_cast<index_t>(inject_.size() - inject_head_);
+                inject_size_.store(depth, std::memory_order_release);
+            }
+            if (profile::enabled()) {
+                profile::detail::count(profile::detail::PoolEvent::injected, static_cast<std::uint64_t>(n));
+                profile::detail::count_push(static_cast<std::uint64_t>(depth));
+            }
+        }
+        wake(static_cast<int>(n));
+    }
+
+    Task* pop_injected() {
+        if (inject_size_.load(std::memory_order_acquire) == 0) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> lock(inject_mutex_);
+        if (inject_head_ == inject_.size()) {
+            return nullptr;
+        }
+        Task* t = inject_[inject_head_++];
+        if (inject_head_ == inject_.size()) {
+            inject_.clear();
+            inject_head_ = 0;
+        }
+        inject_size_.store(static_cast<index_t>(inject_.size() - inject_head_), std::memory_order_release);
+        return t;
+    }
+
+    Task* find_task(int self) {
+        if (self > 0) {
+            Worker& me = *workers_[static_cast<std::size_t>(self - 1)];
+            if (Task* t = me.deque.pop()) {
+                return t;
+            }
+            if (Task* t = pop_injected()) {
+                return t;
+            }
+            return steal_from(me.victims);
+        }
+        if (Task* t = pop_injected()) {
+            return t;
+        }
+        return steal_from(outside_victims_);
+    }
+
+    Task* steal_from(const std::vector<int>& victims) {
+        for (int v : victims) {
+            if (Task* t = workers_[static_cast<std::size_t>(v - 1)]->deque.steal()) {
+                if (profile::enabled()) {
+                    profile::detail::count(profile::detail::PoolEvent::steal);
+                }
+                return t;
+            }
+        }
+        return nullptr;
+    }
+
+    static void execute(Task* t) {
+        if (profile::enabled()) {
+            profile::detail::count(profile::detail::PoolEvent::task);
+        }
+        t->fn(t);
+    }
+
+    void wake(int n) {
+        epoch_.fetch_add(1, std::memory_order_seq_cst);
+        if (sleepers_.load(std::memory_order_seq_cst) > 0) {
+            std::lock_guard<std::mutex> lock(sleep_mutex_);
+            if (n <= 1) {
+                sleep_cv_.notify_one();
+            } else {
+                sleep_cv_.notify_all();
+            }
+        }
+    }
+
+    void worker_main(int self) {
+        tls_pool = this;
+        tls_index = self;
+        Worker& me = *workers_[static_cast<std::size_t>(self - 1)];
+        if (me.cpu >= 0) {
+            pin_current_thread(me.cpu);
+        }
+        // Nearly every task draws scratch from this thread's workspace. Its
+        // first chunk is made here rather than by whichever task this
+        // worker happens to steal first, so that a repeated call allocates
+        // nothing whatever the steal pattern.
+        thread_workspace().reserve(1);
+        for (;;) {
+            Task* t = find_task(self);
+            for (int spin = 0; !t && spin < idle_spins; ++spin) {
+                cpu_relax();
+                t = find_task(self);
+            }
+            if (t) {
+                execute(t);
+                continue;
+            }
+            const std::uint64_t seen = epoch_.load(std::memory_order_seq_cst);
+            if ((t = find_task(self)) != nullptr) {
+                execute(t);
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(sleep_mutex_);
+            if (stop_.load(std::memory_order_seq_cst)) {
+                break;
+            }
+            if (profile::enabled()) {
+                profile::detail::count(profile::detail::PoolEvent::sleep);
+            }
+            sleepers_.fetch_add(1, std::memory_order_seq_cst);
+            while (!stop_.load(std::memory_order_seq_cst) && epoch_.load(std::memory_order_seq_cst) == seen) {
+                sleep_cv_.wait(lock);
+            }
+            sleepers_.fetch_sub(1, std::memory_order_seq_cst);
+        }
+        tls_pool = nullptr;
+        tls_index = 0;
+    }
+
+    const int concurrency_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<int> outside_victims_;
+
+    std::mutex inject_mutex_;
+    std::vector<Task*> inject_;  // [inject_head_, size) still queued
+    std::size_t inject_head_ = 0;
+    std::atomic<index_t> inject_size_{0};
+
+    std::atomic<std::uint64_t> epoch_{0};
+    std::atomic<int> sleepers_{0};
+    std::atomic<bool> stop_{false};
+    std::mutex sleep_mutex_;
+    std::condition_variable sleep_cv_;
+
+    static thread_local PoolImpl* tls_pool;
+    static thread_local int tls_index;
+};
+
+thread_local PoolImpl* PoolImpl::tls_pool = nullptr;
+thread_local int PoolImpl::tls_index = 0;
+
+namespace {
+
+// Loading the library starts nothing: the pool is made by the first
+// parallel region (or warmup()). The shared_ptr slots have destructors,
+// which as namespace-scope globals would need a load-time initializer to
+// register them, so they are function-local statics, set up on first use;
+// the mutex and the thread count are trivially destructible.
+constinit std::mutex g_pool_mutex;
+constinit int g_requested_threads = 0;
+
+std::atomic<std::shared_ptr<Executor>>& executor_slot() noexcept {
+    static std::atomic<std::shared_ptr<Executor>> slot;
+    return slot;
+}
+
+std::atomic<std::shared_ptr<ThreadPool>>& pool_slot() noexcept {
+    static std::atomic<std::shared_ptr<ThreadPool>> slot;
+    return slot;
+}
+
+std::shared_ptr<ThreadPool> global_pool() {
+    std::shared_ptr<ThreadPool> p = pool_slot().load(std::memory_order_acquire);
+    if (!p) {
+        std::lock_guard<std::mutex> lock(g_pool_mutex);
+        p = pool_slot().load(std::memory_order_acquire);
+        if (!p) {
+            ThreadPoolOptions opts;
+            opts.num_threads = g_requested_threads;
+            p = std::make_shared<ThreadPool>(opts);
+            pool_slot().store(p, std::memory_order_release);
+        }
+    }
+    return p;
+}
+
+/// Parallel region on a foreign executor: helpers and the caller claim
+/// indices from a shared counter, so late-starting helpers find nothing to do
+/// and never touch the (by then finished) body. As on the pool, indices
+/// claimed after a call threw are skipped.
+struct ForeignRegion {
+    explicit ForeignRegion(index_t count, FunctionRef<void(index_t)> b) : n(count), body(b) {}
+    const index_t n;
+    FunctionRef<void(index_t)> body;
+    std::atomic<index_t> next{0};
+    std::atomic<index_t> done{0};
+    std::atomic<bool> failed{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::exception_ptr error;
+
+    void work() {
+        for (;;) {
+            const index_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= n) {
+                return;
+            }
+            if (!failed.load(std::memory_order_relaxed)) {
+                try {
+                    body(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) {
+                        error = std::current_exception();
+                    }
+                    failed.store(true, std::memory_order_relaxed);
+                }
+            }
+            if (done.fetch_add(1, std::memory_order_acq_rel) + 1 == n) {
+                std::lock_guard<std::mutex> lock(mutex);
+                cv.notify_all();
+            }
+        }
+    }
+};
+
+void run_on_foreign(Executor& ex, index_t n, FunctionRef<void(index_t)> body) {
+    auto region = std::make_shared<ForeignRegion>(n, body);
+    const index_t helpers = std::min<index_t>(n, ex.concurrency()) - 1;
+    for (index_t h = 0; h < helpers; ++h) {
+        ex.execute([region] { region->work(); });
+    }
+    region->work();
+    std::unique_lock<std::mutex> lock(region->mutex);
+    region->cv.wait(lock, [&] { return region->done.load(std::memory_order_acquire) == n; });
+    if (region->error) {
+        std::rethrow_exception(region->error);
+    }
+}
+
+}  // namespace
+
+void parallel_run(index_t n, FunctionRef<void(index_t)> body) {
+    if (n <= 0) {
+        return;
+    }
+    if (n == 1) {
+        body(0);
+        return;
+    }
+    // Nested region on one of our own workers: stay on that pool.
+    if (PoolImpl* pool = PoolImpl::current_pool()) {
+        pool->run(n, body);
+        return;
+    }
+    if (std::shared_ptr<Executor> ex = executor_slot().load(std::memory_order_acquire)) {
+        if (auto* tp = dynamic_cast<ThreadPool*>(ex.get())) {
+            tp->run(n, body);
+        } else {
+            run_on_foreign(*ex, n, body);
+        }
+        return;
+    }
+    global_pool()->run(n, body);
+}
+
+int parallel_concurrency() noexcept {
+    if (PoolImpl* pool = PoolImpl::current_pool()) {
+        return pool->concurrency();
+    }
+    if (std::shared_ptr<Executor> ex = executor_slot().load(std::memory_order_acquire)) {
+        return std::max(1, ex->concurrency());
+    }
+    try {
+        return global_pool()->concurrency();
+    } catch (...) {
+        return 1;
+    }
+}
+
+void post(std::function<void()> fn) {
+    if (std::shared_ptr<Executor> ex = executor_slot().load(std::memory_order_acquire)) {
+        if (dynamic_cast<ThreadPool*>(ex.get()) == nullptr || ex->concurrency() > 1) {
+            ex->execute(std::move(fn));
+            return;
+        }
+    } else if (std::shared_ptr<ThreadPool> pool = global_pool(); pool->concurrency() > 1) {
+        pool->execute(std::move(fn));
+        return;
+    }
+    fn();
+}
+
+}  // namespace detail
+
+ThreadPool::ThreadPool(ThreadPoolOptions options) : impl_(std::make_unique<detail::PoolImpl>(options)) {}
+ThreadPool::~ThreadPool() = default;
+
+int ThreadPool::concurrency() const noexcept { return impl_->concurrency(); }
+void ThreadPool::execute(std::function<void()> fn) { impl_->submit(std::move(fn)); }
+void ThreadPool::run(index_t n, detail::FunctionRef<void(index_t)> body) { impl_->run(n, body); }
+int ThreadPool::worker_node(int w) const noexcept { return impl_->worker_node(w); }
+int ThreadPool::current_worker() const noexcept { return impl_->current_worker(); }
+
+void set_num_threads(int n) {
+    if (detail::PoolImpl::current_pool() != nullptr) {
+        throw Error("lana: set_num_threads called from inside a lana worker thread");
+    }
+    std::shared_ptr<ThreadPool> old;
+    {
+        std::lock_guard<std::mutex> lock(detail::g_pool_mutex);
+        detail::g_requested_threads = std::max(n, 0);
+        old = detail::pool_slot().exchange(nullptr, std::memory_order_acq_rel);
+    }
+    // `old` shuts down here, or when the last region still using it returns.
+}
+
+int num_threads() { return detail::parallel_concurrency(); }
+
+void set_executor(std::shared_ptr<Executor> executor) {
+    detail::executor_slot().store(std::move(executor), std::memory_order_release);
+}
+
+ThreadPool& default_thread_pool() { return *detail::global_pool(); }
+
+void set_determinism(Determinism mode) noexcept {
+    detail::determinism_slot().store(mode, std::memory_order_relaxed);
+}
+Determinism determinism() noexcept { return detail::determinism_slot().load(std::memory_order_relaxed); }
+
+}  // namespace lana
@@ -0,0 +1,120 @@
+#include "topology.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#  include <pthread.h>
+#  include <sched.h>
+#endif
+
+namespace lana::detail {
+namespace {
+
+/// Parses a sysfs cpulist such as "0-3,8,10-11".
+std::vector<int> parse_cpulist(const std::string& text) {
+    std::vector<int> out;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const auto dash = item.find('-');
+        try {
+            if (dash == std::string::npos) {
+                out.push_back(std::stoi(item));
+            } else {
+                const int lo = std::stoi(item.substr(0, dash));
+                const int hi = std::stoi(item.substr(dash + 1));
+                for (int c = lo; c <= hi; ++c) {
+                    out.push_back(c);
+                }
+            }
+        } catch (const std::exception&) {
+            // Malformed entry; skip it.
+        }
+    }
+    return out;
+}
+
+Topology probe_topology() {
+    Topology t;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof set, &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) {
+                t.cpus.push_back(c);
+            }
+        }
+    }
+#endif
+    if (t.cpus.empty()) {
+        t.cpus.resize(std::max(1u, std::thread::hardware_concurrency()));
+        std::iota(t.cpus.begin(), t.cpus.end(), 0);
+    }
+
+    // Node directories may be sparse (node0, node2, ...); stop after a run
+    // of missing ones.
+    std::vector<int> node_of_cpu;
+    int max_node = 0;
+#if defined(__linux__)
+    for (int n = 0, misses = 0; misses < 8; ++n) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(n) + "/cpulist");
+        if (!f) {
+            ++misses;
+            continue;
+        }
+        misses = 0;
+        std::string line;
+        std::getline(f, line);
+        for (int cpu : parse_cpulist(line)) {
+            if (cpu >= 0) {
+                if (static_cast<std::size_t>(cpu) >= node_of_cpu.size()) {
+                    node_of_cpu.resize(static_cast<std::size_t>(cpu) + 1, 0);
+                }
+                node_of_cpu[static_cast<std::size_t>(cpu)] = n;
+                max_node = std::max(max_node, n);
+            }
+        }
+    }
+#endif
+    std::vector<std::pair<int, int>> by_node;  // (node, cpu)
+    for (int cpu : t.cpus) {
+        const auto c = static_cast<std::size_t>(cpu);
+        by_node.emplace_back(c < node_of_cpu.size() ? node_of_cpu[c] : 0, cpu);
+    }
+    std::sort(by_node.begin(), by_node.end());
+    t.cpus.clear();
+    for (const auto& [node, cpu] : by_node) {
+        t.cpus.push_back(cpu);
+        t.nodes.push_back(node);
+    }
+    t.num_nodes = max_node + 1;
+    return t;
+}
+
+}  // namespace
+
+const Topology& host_topology() {
+    static const Topology t = probe_topology();
+    return t;
+}
+
+bool pin_current_thread(int cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof set, &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+}  // namespace lana::detail
@@ -0,0 +1,22 @@
+#pragma once
+
+// CPU / NUMA topology as seen by this process.
+
+#include <vector>
+
+namespace lana::detail {
+
+struct Topology {
+    /// CPUs in the process affinity mask, sorted by (NUMA node, CPU id).
+    std::vector<int> cpus;
+    /// NUMA node of cpus[i]; 0 when the system exposes no NUMA information.
+    std::vector<int> nodes;
+    int num_nodes = 1;
+};
+
+const Topology& host_topology();
+
+/// Pins the calling thread to `cpu`. Returns false if the OS refused.
+bool pin_current_thread(int cpu);
+
+}  // namespace lana::detail
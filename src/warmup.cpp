@@ -0,0 +1,35 @@
+// warmup(): touches each piece of lazily initialized state once. Every one
+// of them is a function-local static (or the pool's double-checked pointer)
+// that a kernel would otherwise fill on its first call.
+
+#include "lana/warmup.hpp"
+#include "lana/cpu.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+
+#include "gemm_internal.hpp"
+#include "host.hpp"
+#include "kernels/kernels.hpp"
+#include "topology.hpp"
+
+#include <mutex>
+
+namespace lana {
+
+void warmup() {
+    static std::once_flag once;
+    std::call_once(once, [] {
+        (void)detail::kernels_f32();
+        (void)detail::kernels_f64();
+        (void)detail::host_cache_sizes();
+        (void)detail::host_topology();
+        (void)detail::tuned_blocking(false);
+        (void)detail::tuned_blocking(true);
+        (void)profile::enabled();
+        // parallel_concurrency() creates the default pool, which starts its
+        // workers; the region makes sure the executor has run work once.
+        detail::parallel_run(detail::parallel_concurrency(), [](index_t) {});
+    });
+}
+
+}  // namespace lana
@@ -0,0 +1,116 @@
+#pragma once
+
+// Chase-Lev work-stealing deque (Chase & Lev, SPAA'05), with the C11 memory
+// orderings from Le, Pop, Cohen & Zappa Nardelli, PPoPP'13.
+//
+// The owning thread pushes and pops at the bottom; any thread may steal from
+// the top. The ring grows by doubling; retired rings are kept until the
+// deque is destroyed because a concurrent thief may still be reading one.
+
+#include "lana/config.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+namespace lana::detail {
+
+template <typename T>
+class WorkDeque {
+    static_assert(std::is_pointer_v<T>, "WorkDeque stores pointers");
+
+public:
+    explicit WorkDeque(std::int64_t capacity = 256) : ring_(new Ring(capacity)) { rings_.emplace_back(ring_.load()); }
+
+    WorkDeque(const WorkDeque&) = delete;
+    WorkDeque& operator=(const WorkDeque&) = delete;
+
+    /// Owner only.
+    void push(T item) {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_acquire);
+        Ring* r = ring_.load(std::memory_order_relaxed);
+        if (b - t > r->capacity - 1) {
+            r = grow(r, t, b);
+        }
+        r->put(b, item);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+
+    /// Owner only. Returns nullptr when empty.
+    T pop() {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+        Ring* r = ring_.load(std::memory_order_relaxed);
+        bottom_.store(b, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        std::int64_t t = top_.load(std::memory_order_relaxed);
+        if (t > b) {
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T item = r->get(b);
+        if (t == b) {
+            // Last element: race any thief for it.
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(b + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    /// Any thread. Returns nullptr when empty or when it lost a race.
+    T steal() {
+        std::int64_t t = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const std::int64_t b = bottom_.load(std::memory_order_acquire);
+        if (t >= b) {
+            return nullptr;
+        }
+        Ring* r = ring_.load(std::memory_order_acquire);
+        T item = r->get(t);
+        if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    /// Approximate number of queued items.
+    std::int64_t size() const noexcept {
+        const std::int64_t b = bottom_.load(std::memory_order_relaxed);
+        const std::int64_t t = top_.load(std::memory_order_relaxed);
+        return b > t ? b - t : 0;
+    }
+
+private:
+    struct Ring {
+        explicit Ring(std::int64_t cap) : capacity(cap), mask(cap - 1), slots(new std::atomic<T>[cap]) {}
+        std::int64_t capacity;
+        std::int64_t mask;
+        std::unique_ptr<std::atomic<T>[]> slots;
+
+        void put(std::int64_t i, T v) noexcept { slots[i & mask].store(v, std::memory_order_relaxed); }
+        T get(std::int64_t i) const noexcept { return slots[i & mask].load(std::memory_order_relaxed); }
+    };
+
+    Ring* grow(Ring* old, std::int64_t t, std::int64_t b) {
+        auto bigger = std::make_unique<Ring>(old->capacity * 2);
+        for (std::int64_t i = t; i < b; ++i) {
+            bigger->put(i, old->get(i));
+        }
+        Ring* r = bigger.get();
+        rings_.push_back(std::move(bigger));
+        ring_.store(r, std::memory_order_release);
+        return r;
+    }
+
+    alignas(64) std::atomic<std::int64_t> top_{0};
+    alignas(64) std::atomic<std::int64_t> bottom_{0};
+    std::atomic<Ring*> ring_;
+    std::vector<std::unique_ptr<Ring>> rings_;  // owner-only; keeps retired rings alive
+};
+
+}  // namespace lana::detail
@@ -0,0 +1,208 @@
+#include "lana/workspace.hpp"
+#include "lana/memory.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+namespace lana {
+namespace {
+
+constexpr std::size_t min_chunk_bytes = std::size_t(64) << 10;
+constexpr std::size_t max_alignment = 4096;
+
+std::size_t round_up(std::size_t x, std::size_t a) { return (x + a - 1) / a * a; }
+
+std::size_t page_bytes(PageSize pages) {
+    switch (pages) {
+        case PageSize::Transparent:
+        case PageSize::Huge2M:
+            return std::size_t(2) << 20;
+        case PageSize::Huge1G:
+            return std::size_t(1) << 30;
+        case PageSize::Default:
+            break;
+    }
+    return max_alignment;
+}
+
+}  // namespace
+
+Workspace::Workspace(WorkspaceOptions options) : options_(options) {
+    if (options_.initial_bytes > 0) {
+        add_chunk(options_.initial_bytes);
+    }
+}
+
+Workspace::~Workspace() {
+    for (Chunk& c : chunks_) {
+        free_chunk(c);
+    }
+}
+
+Workspace::Workspace(Workspace&& other) noexcept
+    : options_(other.options_),
+      chunks_(std::move(other.chunks_)),
+      cur_(std::exchange(other.cur_, 0)),
+      high_water_(std::exchange(other.high_water_, 0)) {
+    other.chunks_.clear();
+}
+
+Workspace& Workspace::operator=(Workspace&& other) noexcept {
+    if (this != &other) {
+        for (Chunk& c : chunks_) {
+            free_chunk(c);
+        }
+        options_ = other.options_;
+        chunks_ = std::move(other.chunks_);
+        other.chunks_.clear();
+        cur_ = std::exchange(other.cur_, 0);
+        high_water_ = std::exchange(other.high_water_, 0);
+    }
+    return *this;
+}
+
+void* Workspace::allocate(std::size_t bytes, std::size_t alignment) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+    alignment = std::clamp<std::size_t>(alignment, 1, max_alignment);
+    for (;;) {
+        if (cur_ < chunks_.size()) {
+            Chunk& c = chunks_[cur_];
+            const auto base = reinterpret_cast<std::uintptr_t>(c.data);
+            const std::size_t offset = round_up(base + c.used, alignment) - base;
+            if (offset <= c.size && bytes <= c.size - offset) {
+                c.used = offset + bytes;
+                high_water_ = std::max(high_water_, used());
+                return c.data + offset;
+            }
+            // Chunks past cur_ are empty after a release; try the next one
+            // before growing.
+            if (cur_ + 1 < chunks_.size()) {
+                ++cur_;
+                continue;
+            }
+        }
+        add_chunk(bytes + alignment);
+        cur_ = chunks_.size() - 1;
+    }
+}
+
+void Workspace::release(Mark m) noexcept {
+    if (chunks_.empty()) {
+        return;
+    }
+    for (std::size_t i = m.chunk + 1; i <= cur_ && i < chunks_.size(); ++i) {
+        chunks_[i].used = 0;
+    }
+    chunks_[m.chunk].used = m.offset;
+    cur_ = m.chunk;
+    if (m.chunk == 0 && m.offset == 0 && chunks_.size() > 1) {
+        merge_chunks();
+    }
+}
+
+void Workspace::reserve(std::size_t bytes) {
+    if (used() != 0) {
+        throw Error("lana: Workspace::reserve called while allocations are live");
+    }
+    if (capacity() >= bytes && chunks_.size() <= 1) {
+        return;
+    }
+    for (Chunk& c : chunks_) {
+        free_chunk(c);
+    }
+    chunks_.clear();
+    cur_ = 0;
+    add_chunk(std::max(bytes, capacity()));
+}
+
+std::size_t Workspace::used() const noexcept {
+    std::size_t n = 0;
+    for (std::size_t i = 0; i <= cur_ && i < chunks_.size(); ++i) {
+        n += chunks_[i].used;
+    }
+    return n;
+}
+
+std::size_t Workspace::capacity() const noexcept {
+    std::size_t n = 0;
+    for (const Chunk& c : chunks_) {
+        n += c.size;
+    }
+    return n;
+}
+
+AllocPolicy Workspace::chunk_policy() const noexcept {
+    AllocPolicy policy = options_.policy;
+    if (options_.huge_pages && policy.pages == PageSize::Default) {
+        policy.pages = PageSize::Transparent;
+    }
+    policy.first_touch = false;
+    return policy;
+}
+
+void Workspace::add_chunk(std::size_t min_bytes) {
+    std::size_t bytes = std::max(min_bytes, min_chunk_bytes);
+    if (!chunks_.empty()) {
+        bytes = std::max(bytes, 2 * chunks_.back().size);
+    }
+    chunks_.reserve(chunks_.size() + 1);
+    Chunk c;
+    if (const AllocPolicy policy = chunk_policy(); policy.mapped()) {
+        // Whole pages, since the mapping holds them anyway.
+        const std::size_t page = page_bytes(policy.pages);
+        try {
+            c.data = static_cast<char*>(policy_alloc(round_up(bytes, page), policy));
+            bytes = round_up(bytes, page);
+            c.mapped = true;
+        } catch (const std::bad_alloc&) {
+            if (policy.strict) {
+                throw;
+            }
+        }
+    }
+    if (c.data == nullptr) {
+        bytes = round_up(bytes, max_alignment);
+        c.data = static_cast<char*>(lana::aligned_alloc(bytes, max_alignment));
+    }
+    c.size = bytes;
+    chunks_.push_back(c);
+}
+
+void Workspace::free_chunk(Chunk& c) noexcept {
+    if (c.data == nullptr) {
+        return;
+    }
+    if (c.mapped) {
+        policy_free(c.data, c.size, chunk_policy());
+    } else {
+        lana::aligned_free(c.data);
+    }
+    c.data = nullptr;
+}
+
+void Workspace::merge_chunks() noexcept {
+    const std::size_t total = capacity();
+    std::vector<Chunk> old;
+    old.swap(chunks_);
+    try {
+        add_chunk(total);
+    } catch (...) {
+        // Keep the fragmented chunks rather than fail a release.
+        chunks_.swap(old);
+        return;
+    }
+    for (Chunk& c : old) {
+        free_chunk(c);
+    }
+}
+
+Workspace& thread_workspace() {
+    thread_local Workspace ws;
+    return ws;
+}
+
+}  // namespace lana
@@ -0,0 +1,191 @@
+// Heap allocations on warm paths. This executable replaces the global
+// operator new to count calls from every thread, liblana's included; each
+// case runs its body until workspaces and queues have grown, then expects
+// a call to allocate nothing.
+
+#include "check.hpp"
+
+#include "lana/blas1.hpp"
+#include "lana/gemm.hpp"
+#include "lana/krylov.hpp"
+#include "lana/matrix.hpp"
+#include "lana/sparse.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <atomic>
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+#include <new>
+
+namespace {
+
+std::atomic<long> g_allocations{0};
+
+void* counted(std::size_t bytes, std::size_t alignment) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    void* p = nullptr;
+    if (alignment <= alignof(std::max_align_t)) {
+        p = std::malloc(bytes == 0 ? 1 : bytes);
+    } else {
+        p = std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+    }
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+}  // namespace
+
+void* operator new(std::size_t bytes) { return counted(bytes, alignof(std::max_align_t)); }
+void* operator new(std::size_t bytes, std::align_val_t al) { return counted(bytes, static_cast<std::size_t>(al)); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+namespace {
+
+using lana::index_t;
+
+/// 5-point Laplacian on a g x g grid.
+lana::Csr<double> poisson(index_t g) {
+    lana::Coo<double> coo(g * g, g * g);
+    for (index_t y = 0; y < g; ++y) {
+        for (index_t x = 0; x < g; ++x) {
+            const index_t i = y * g + x;
+            coo.add(i, i, 4);
+            if (x > 0) coo.add(i, i - 1, -1);
+            if (x + 1 < g) coo.add(i, i + 1, -1);
+            if (y > 0) coo.add(i, i - g, -1);
+            if (y + 1 < g) coo.add(i, i + g, -1);
+        }
+    }
+    return lana::Csr<double>(coo);
+}
+
+/// Allocations a warm call to f makes. A pool worker's workspace grows the
+/// first time it steals a task needing more scratch than it holds, and
+/// which call that is depends on scheduling; so this is the fewest over
+/// several calls after two warm-ups, which is zero unless every call
+/// allocates.
+template <typename F>
+long warm_allocations(F&& f) {
+    f();
+    f();
+    long fewest = std::numeric_limits<long>::max();
+    for (int i = 0; i < 8 && fewest > 0; ++i) {
+        const long before = g_allocations.load();
+        f();
+        fewest = std::min(fewest, g_allocations.load() - before);
+    }
+    return fewest;
+}
+
+LANA_TEST(parallel_region_is_allocation_free) {
+    std::atomic<index_t> sum{0};
+    CHECK(warm_allocations([&] {
+              lana::detail::parallel_run(64, [&](index_t i) { sum.fetch_add(i, std::memory_order_relaxed); });
+          }) == 0);
+    // Regions nested in a region's tasks push to the workers' own deques.
+    CHECK(warm_allocations([&] {
+              lana::parallel_for(0, 8, 1, [&](index_t lo, index_t hi) {
+                  for (index_t i = lo; i < hi; ++i) {
+                      lana::detail::parallel_run(8, [&](index_t j) { sum.fetch_add(j, std::memory_order_relaxed); });
+                  }
+              });
+          }) == 0);
+    CHECK(sum.load() > 0);
+}
+
+LANA_TEST(parallel_reduction_is_allocation_free) {
+    // Large enough to split across tasks (Determinism::Fast).
+    const lana::Vector<double> x = lana::test::random_vector<double>(1 << 20, 1);
+    const lana::Vector<double> y = lana::test::random_vector<double>(1 << 20, 2);
+    double d = 0;
+    CHECK(warm_allocations([&] { d = lana::dot(x.view(), y.view()); }) == 0);
+    CHECK(std::isfinite(d));
+    // Determinism::Bitwise keeps one partial per fixed block instead.
+    lana::set_determinism(lana::Determinism::Bitwise);
+    double bitwise = 0;
+    const long n = warm_allocations([&] { bitwise = lana::dot(x.view(), y.view()); });
+    lana::set_determinism(lana::Determinism::Fast);
+    CHECK(n == 0);
+    CHECK_NEAR(bitwise, d, 1e-9);
+}
+
+LANA_TEST(sparse_products_are_allocation_free) {
+    // Enough nonzeros for the nnz-balanced parallel split.
+    const lana::Csr<double> a = poisson(200);
+    const lana::Bsr<double> b(a, 4, 4);
+    const lana::Vector<double> x = lana::test::random_vector<double>(a.cols(), 3);
+    lana::Vector<double> y(a.rows());
+    const lana::Matrix<double> xs = lana::test::random_matrix<double>(a.cols(), 4, 4);
+    lana::Matrix<double> ys(a.rows(), 4);
+    CHECK(warm_allocations([&] { lana::spmv(1.0, a.view(), x.view(), 0.0, y.view()); }) == 0);
+    CHECK(warm_allocations([&] { lana::spmv(1.0, b, x.view(), 0.5, y.view()); }) == 0);
+    CHECK(warm_allocations([&] { lana::spmm(1.0, a.view(), xs.view(), 0.0, ys.view()); }) == 0);
+    CHECK(warm_allocations([&] { lana::spmm(1.0, b, xs.view(), 1.0, ys.view()); }) == 0);
+}
+
+template <typename M, typename Solve>
+void check_warm_solve(const lana::Csr<double>& a, const M& m, Solve solve) {
+    const lana::Vector<double> b = lana::test::random_vector<double>(a.rows(), 5);
+    lana::Vector<double> x(a.rows());
+    lana::krylov::Options opts;
+    opts.max_iterations = 20;
+    opts.restart = 10;
+    for (lana::Determinism mode : {lana::Determinism::Fast, lana::Determinism::Bitwise}) {
+        lana::set_determinism(mode);
+        const long n = warm_allocations([&] {
+            x.fill(0.0);
+            solve(a, lana::VectorView<const double>(b.view()), x.view(), m, opts);
+        });
+        lana::set_determinism(lana::Determinism::Fast);
+        CHECK(n == 0);
+    }
+}
+
+LANA_TEST(krylov_solve_is_allocation_free) {
+    const lana::Csr<double> a = poisson(200);
+    const auto cg = [](const auto& op, auto b, auto x, const auto& m, const auto& o) {
+        return lana::krylov::cg(op, b, x, m, o);
+    };
+    const auto gmres = [](const auto& op, auto b, auto x, const auto& m, const auto& o) {
+        return lana::krylov::gmres(op, b, x, m, o);
+    };
+    const auto bicgstab = [](const auto& op, auto b, auto x, const auto& m, const auto& o) {
+        return lana::krylov::bicgstab(op, b, x, m, o);
+    };
+    check_warm_solve(a, lana::krylov::Identity{}, cg);
+    check_warm_solve(a, lana::krylov::Jacobi<double>(a.view()), cg);
+    check_warm_solve(a, lana::krylov::Identity{}, gmres);
+    check_warm_solve(a, lana::krylov::Ilu0<double>(a.view()), gmres);
+    check_warm_solve(a, lana::krylov::BlockJacobi<double>(a.view(), 64), bicgstab);
+}
+
+LANA_TEST(gemm_is_allocation_free) {
+    const lana::Matrix<double> a = lana::test::random_matrix<double>(300, 300, 6);
+    const lana::Matrix<double> b = lana::test::random_matrix<double>(300, 300, 7);
+    lana::Matrix<double> c(300, 300);
+    CHECK(warm_allocations([&] { lana::gemm(1.0, a.view(), b.view(), 0.0, c.view()); }) == 0);
+    const lana::Matrix<float> af = lana::test::random_matrix<float>(300, 200, 8);
+    lana::Matrix<float> cf(300, 300);
+    CHECK(warm_allocations([&] { lana::gemm(1.0f, af.view(), af.view().t(), 0.0f, cf.view()); }) == 0);
+}
+
+LANA_TEST(fixed_size_math_is_allocation_free) {
+    using M = lana::Matrix<double, 4, 4>;
+    const M a(lana::test::random_matrix<double>(4, 4, 9).view());
+    M acc = M::identity();
+    const long before = g_allocations.load();
+    for (int i = 0; i < 100; ++i) {
+        const M p = a * acc;
+        acc = 0.5 * p + 0.25 * lana::inverse(M(p + 4.0 * M::identity())) - a / 8.0;
+    }
+    CHECK(g_allocations.load() == before);
+    CHECK(std::isfinite(lana::det(acc)));
+}
+
+}  // namespace
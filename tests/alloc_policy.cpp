@@ -0,0 +1,254 @@
+// AllocPolicy storage: every page size and NUMA policy hands back aligned,
+// zeroed, writable memory, or falls back unless strict; first_touch writes
+// what it promises; Matrix, TiledMatrix and Workspace built under a policy
+// start at zero, keep it across copies as documented, and compute as
+// ordinary storage does.
+
+#include "check.hpp"
+
+#include "lana/gemm.hpp"
+#include "lana/memory.hpp"
+#include "lana/tiled.hpp"
+#include "lana/workspace.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lana::AllocPolicy;
+using lana::index_t;
+using lana::Matrix;
+using lana::NumaPolicy;
+using lana::PageSize;
+
+constexpr std::size_t page = std::size_t(4) << 10;
+constexpr std::size_t page_2m = std::size_t(2) << 20;
+
+bool aligned(const void* p, std::size_t alignment) { return reinterpret_cast<std::uintptr_t>(p) % alignment == 0; }
+
+bool all_zero(const unsigned char* p, std::size_t bytes) {
+    for (std::size_t i = 0; i < bytes; ++i) {
+        if (p[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+AllocPolicy policy_of(PageSize pages, NumaPolicy numa = NumaPolicy::Local, bool first_touch = false) {
+    AllocPolicy p;
+    p.pages = pages;
+    p.numa = numa;
+    p.first_touch = first_touch;
+    return p;
+}
+
+/// Every policy that must succeed without strict on any host.
+std::vector<AllocPolicy> every_policy() {
+    std::vector<AllocPolicy> out;
+    for (PageSize pages : {PageSize::Default, PageSize::Transparent, PageSize::Huge2M, PageSize::Huge1G}) {
+        for (NumaPolicy numa : {NumaPolicy::Local, NumaPolicy::Interleave, NumaPolicy::Bind}) {
+            for (bool first_touch : {false, true}) {
+                out.push_back(policy_of(pages, numa, first_touch));
+            }
+        }
+    }
+    return out;
+}
+
+LANA_TEST(policy_alloc_is_aligned_and_zeroed) {
+    for (const AllocPolicy& policy : every_policy()) {
+        CHECK(lana::policy_alloc(0, policy) == nullptr);
+        for (std::size_t bytes : {std::size_t(1), std::size_t(5000), std::size_t(3) << 20}) {
+            auto* p = static_cast<unsigned char*>(lana::policy_alloc(bytes, policy));
+            CHECK(p != nullptr && aligned(p, policy.mapped() ? page : 64));
+            if (policy.mapped()) {
+                CHECK(all_zero(p, bytes));
+            }
+            std::memset(p, 0x5a, bytes);
+            CHECK(p[bytes - 1] == 0x5a);
+            lana::policy_free(p, bytes, policy);
+        }
+    }
+    lana::policy_free(nullptr, 100, policy_of(PageSize::Transparent));
+
+    // Transparent pages come from a 2 MiB-aligned mapping, so that the
+    // kernel can back it with huge pages.
+    const AllocPolicy thp = policy_of(PageSize::Transparent);
+    const std::size_t bytes = std::size_t(3) << 20;
+    void* p = lana::policy_alloc(bytes, thp);
+    CHECK(aligned(p, page_2m) && all_zero(static_cast<unsigned char*>(p), bytes));
+    lana::policy_free(p, bytes, thp);
+}
+
+LANA_TEST(policy_alloc_strict_refuses_to_fall_back) {
+    // A node that does not exist: placement fails, which only strict
+    // reports.
+    for (int node : {-1, 1 << 20}) {
+        AllocPolicy bind = policy_of(PageSize::Default, NumaPolicy::Bind);
+        bind.node = node;
+        void* p = lana::policy_alloc(100000, bind);
+        CHECK(p != nullptr);
+        lana::policy_free(p, 100000, bind);
+        bind.strict = true;
+        CHECK_THROWS(lana::policy_alloc(100000, bind), std::bad_alloc);
+        CHECK_THROWS(Matrix<double>(100, 100, bind), std::bad_alloc);
+    }
+
+    // Explicit huge pages either come from the reservation, aligned to
+    // their size, or strict throws; none are reserved on most hosts.
+    for (PageSize pages : {PageSize::Huge2M, PageSize::Huge1G}) {
+        AllocPolicy strict = policy_of(pages);
+        strict.strict = true;
+        const std::size_t size = pages == PageSize::Huge1G ? std::size_t(1) << 30 : page_2m;
+        try {
+            void* p = lana::policy_alloc(size, strict);
+            CHECK(aligned(p, size) && all_zero(static_cast<unsigned char*>(p), 4096));
+            lana::policy_free(p, size, strict);
+        } catch (const std::bad_alloc&) {
+        }
+    }
+    // Transparent pages are only a hint: strict changes nothing.
+    AllocPolicy thp = policy_of(PageSize::Transparent);
+    thp.strict = true;
+    void* p = lana::policy_alloc(page_2m, thp);
+    CHECK(aligned(p, page_2m));
+    lana::policy_free(p, page_2m, thp);
+}
+
+LANA_TEST(first_touch_writes_pages) {
+    // Small ranges run on the caller, large ones on the pool; units that
+    // do not divide the range or a page included.
+    for (std::size_t bytes : {std::size_t(100), 3 * page + 7, 64 * page, (std::size_t(5) << 20) + 123}) {
+        for (std::size_t unit : {std::size_t(1), std::size_t(1000), page, 3 * page + 17, bytes}) {
+            std::vector<unsigned char> buf(bytes, 0xab);
+            lana::detail::first_touch(buf.data(), bytes, unit, true);
+            CHECK(all_zero(buf.data(), bytes));
+
+            // Without zeroing: one byte per page, plus the start of each
+            // piece, and nothing else.
+            std::memset(buf.data(), 0xab, bytes);
+            lana::detail::first_touch(buf.data(), bytes, unit, false);
+            std::size_t others = 0;
+            bool pages = true;
+            for (std::size_t i = 0; i < bytes; ++i) {
+                if (i % page == 0) {
+                    pages = pages && buf[i] == 0;
+                } else if (buf[i] != 0xab) {
+                    others += buf[i] == 0 ? 1 : bytes;
+                }
+            }
+            CHECK(pages);
+            CHECK_LE(others, (bytes + unit - 1) / unit);
+        }
+    }
+    lana::detail::first_touch(nullptr, 100, 8, true);
+    unsigned char one = 7;
+    lana::detail::first_touch(&one, 0, 8, true);
+    CHECK(one == 7);
+}
+
+template <typename T>
+void matrices() {
+    const index_t m = 300, n = 200;
+    for (const AllocPolicy& policy : every_policy()) {
+        const Matrix<T> z(m, n, policy);
+        CHECK(z.alloc_policy() == policy && z.rows() == m && z.cols() == n);
+        CHECK(lana::test::max_abs<T>(z.view()) == 0);
+        CHECK(aligned(z.data(), policy.mapped() ? page : 64));
+
+        // Uninitialized storage under the policy computes like any other.
+        const Matrix<T> a = lana::test::random_matrix<T>(m, 70, 1);
+        const Matrix<T> b = lana::test::random_matrix<T>(70, n, 2);
+        Matrix<T> c(m, n, lana::uninitialized, policy);
+        CHECK(c.alloc_policy() == policy);
+        lana::gemm(T(1), a.view(), b.view(), T(0), c.view());
+        Matrix<T> ref(m, n);
+        lana::test::reference_gemm<T>(1.0, a.view(), b.view(), 0.0, ref.view());
+        CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(70));
+
+        // Copies keep the source's policy, assignment the target's, also
+        // when it has to reallocate; moves take the storage along.
+        const Matrix<T> copy = c;
+        CHECK(copy.alloc_policy() == policy && lana::test::max_abs_diff<T>(copy.view(), c.view()) == 0);
+        Matrix<T> target(3, 4);
+        target = c;
+        CHECK(target.alloc_policy() == AllocPolicy{} && lana::test::max_abs_diff<T>(target.view(), c.view()) == 0);
+        Matrix<T> back(10, 10, policy);
+        back = ref;
+        CHECK(back.alloc_policy() == policy && lana::test::max_abs_diff<T>(back.view(), ref.view()) == 0);
+        const T* storage = c.data();
+        const Matrix<T> moved = std::move(c);
+        CHECK(moved.data() == storage && moved.alloc_policy() == policy);
+    }
+    const Matrix<T> empty(0, 5, policy_of(PageSize::Transparent, NumaPolicy::Local, true));
+    CHECK(empty.empty() && empty.cols() == 5);
+}
+
+LANA_TEST(policy_f32_matrix) { matrices<float>(); }
+LANA_TEST(policy_f64_matrix) { matrices<double>(); }
+
+template <typename T>
+void tiled() {
+    const Matrix<T> src = lana::test::random_matrix<T>(130, 90, 3);
+    for (const AllocPolicy& policy : every_policy()) {
+        for (lana::TileOrder order : {lana::TileOrder::ColumnMajor, lana::TileOrder::Morton}) {
+            lana::TiledMatrix<T> t(130, 90, 32, order, policy);
+            CHECK(t.alloc_policy() == policy && lana::test::max_abs<T>(t.to_matrix().view()) == 0);
+            t.copy_from(src.view());
+            const lana::TiledMatrix<T> copy = t;
+            CHECK(copy.alloc_policy() == policy);
+            CHECK(lana::test::max_abs_diff<T>(copy.to_matrix().view(), src.view()) == 0);
+            lana::TiledMatrix<T> scratch(130, 90, 32, order, lana::uninitialized, policy);
+            scratch.copy_from(src.view());
+            CHECK(lana::test::max_abs_diff<T>(scratch.to_matrix().view(), src.view()) == 0);
+        }
+    }
+}
+
+LANA_TEST(policy_f32_tiled) { tiled<float>(); }
+LANA_TEST(policy_f64_tiled) { tiled<double>(); }
+
+LANA_TEST(policy_workspace_chunks) {
+    for (const AllocPolicy& policy : every_policy()) {
+        lana::WorkspaceOptions opt;
+        opt.policy = policy;
+        lana::Workspace ws(opt);
+        // Enough to grow into several chunks, then merge them on reset.
+        std::vector<std::pair<double*, std::size_t>> blocks;
+        for (std::size_t n : {std::size_t(1000), std::size_t(300000), std::size_t(700000)}) {
+            auto* p = ws.allocate_n<double>(n);
+            CHECK(aligned(p, 64));
+            for (std::size_t i = 0; i < n; ++i) {
+                p[i] = double(i);
+            }
+            blocks.emplace_back(p, n);
+        }
+        for (const auto& [p, n] : blocks) {
+            CHECK(p[n - 1] == double(n - 1));
+        }
+        const std::size_t capacity = ws.capacity();
+        ws.reset();
+        CHECK(ws.capacity() == capacity);
+        auto* big = static_cast<char*>(ws.allocate(capacity - 4096, 4096));
+        CHECK(aligned(big, 4096) && ws.capacity() == capacity);
+        big[capacity - 4097] = 1;
+    }
+
+    // Only strict turns a failed placement into an error.
+    lana::WorkspaceOptions opt;
+    opt.policy = policy_of(PageSize::Default, NumaPolicy::Bind);
+    opt.policy.node = 1 << 20;
+    lana::Workspace loose(opt);
+    CHECK(loose.allocate(100000) != nullptr);
+    opt.policy.strict = true;
+    lana::Workspace strict(opt);
+    CHECK_THROWS(strict.allocate(100000), std::bad_alloc);
+    CHECK(strict.capacity() == 0);
+}
+
+}  // namespace
@@ -0,0 +1,231 @@
+// lana::async: operations give the results of the blocking calls, run in
+// the order their after() dependencies impose, pass a failure on to every
+// operation after it without running them, and work from coroutines.
+
+#include "check.hpp"
+
+#include "lana/async.hpp"
+#include "lana/error.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace async = lana::async;
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+
+LANA_TEST(async_gemm_matches_the_blocking_call) {
+    const Matrix<double> a = lana::test::random_matrix<double>(120, 80, 1);
+    const Matrix<double> b = lana::test::random_matrix<double>(80, 90, 2);
+    Matrix<double> c(120, 90);
+    async::Future<void> f = async::gemm(2.0, a.view(), b.view(), 0.0, c.view());
+    CHECK(f.valid());
+    f.get();
+    CHECK(f.ready());
+    Matrix<double> ref(120, 90);
+    lana::test::reference_gemm<double>(2.0, a.view(), b.view(), 0.0, ref.view());
+    CHECK_LE(lana::test::max_abs_diff<double>(c.view(), ref.view()), lana::test::tolerance<double>(80));
+
+    const lana::Vector<float> x = lana::test::random_vector<float>(1000, 3);
+    const async::Future<float> d = async::dot(x.view(), x.view());
+    CHECK_NEAR(d.get(), lana::dot(x.view(), x.view()), 0);
+    CHECK(!async::Future<int>().valid());
+}
+
+LANA_TEST(async_chain_solves_without_waiting_between_steps) {
+    const index_t n = 150;
+    const Matrix<double> a0 = lana::test::random_matrix<double>(n, n, 4);
+    const Matrix<double> b0 = lana::test::random_matrix<double>(n, 3, 5);
+    Matrix<double> a = a0;
+    Matrix<double> x = b0;
+    Matrix<double> r = b0;
+    std::vector<std::int32_t> ipiv(static_cast<std::size_t>(n));
+
+    // The residual r = b - A0 x of the solve, as the header's example.
+    const async::Future<index_t> lu = async::getrf(a.view(), ipiv.data());
+    const async::Future<void> solved =
+        async::getrs(async::after(lu), lana::Op::NoTrans, MatrixView<const double>(a.view()), ipiv.data(), x.view());
+    const async::Future<void> res = async::gemm(async::after(solved), -1.0, a0.view(), x.view(), 1.0, r.view());
+    res.get();
+    CHECK(lu.get() == 0 && solved.ready());
+    CHECK_LE(lana::test::max_abs<double>(r.view()), 1e-10);
+}
+
+LANA_TEST(async_after_orders_operations) {
+    std::mutex mutex;
+    std::vector<int> order;
+    const auto note = [&](int i) {
+        std::lock_guard<std::mutex> lock(mutex);
+        order.push_back(i);
+    };
+    // A chain of 100: each operation waits for the one before it.
+    async::Future<void> prev = async::submit([&] { note(0); });
+    for (int i = 1; i < 100; ++i) {
+        prev = async::submit(async::after(prev), [&note, i] { note(i); });
+    }
+    prev.get();
+    CHECK(order.size() == 100);
+    for (int i = 0; i < 100; ++i) {
+        CHECK(order[static_cast<std::size_t>(i)] == i);
+    }
+
+    // Fan-in: one operation after 50 independent ones sees all of them.
+    std::atomic<int> done{0};
+    std::vector<async::Future<int>> parts;
+    for (int i = 0; i < 50; ++i) {
+        parts.push_back(async::submit([&done, i] {
+            done.fetch_add(1);
+            return i;
+        }));
+    }
+    // after() takes a fixed list; fold the vector through when_all.
+    async::After deps;
+    for (const auto& p : parts) {
+        deps = async::after(p, async::when_all(std::move(deps)));
+    }
+    const async::Future<int> seen = async::submit(std::move(deps), [&] { return done.load(); });
+    CHECK(seen.get() == 50);
+    CHECK(parts[49].get() == 49);
+    async::when_all(parts[0], parts[1], seen).get();
+}
+
+LANA_TEST(async_failure_skips_what_comes_after) {
+    const async::Future<int> bad = async::submit([]() -> int { throw std::runtime_error("bad input"); });
+    std::atomic<bool> ran{false};
+    const async::Future<void> next = async::submit(async::after(bad), [&] { ran = true; });
+    const async::Future<void> last = async::submit(async::after(next), [&] { ran = true; });
+    const async::Future<int> fine = async::submit([] { return 7; });
+    const async::Future<void> all = async::when_all(fine, bad);
+
+    for (const async::Future<void>* f : {&next, &last, &all}) {
+        std::string message;
+        try {
+            f->get();
+        } catch (const std::runtime_error& e) {
+            message = e.what();
+        }
+        CHECK(message == "bad input");
+    }
+    CHECK(!ran.load());
+    CHECK(fine.get() == 7);
+
+    // A lana error surfaces the same way.
+    Matrix<double> a(3, 4);
+    Matrix<double> c(3, 3);
+    CHECK_THROWS(async::gemm(1.0, a.view(), a.view(), 0.0, c.view()).get(), lana::DimensionError);
+}
+
+async::Future<double> norm_of_product(const Matrix<double>& a, Matrix<double>& c) {
+    co_await async::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+    const lana::VectorView<const double> col(c.data(), c.rows());
+    const double n = co_await async::nrm2(col);
+    // An operation already complete does not suspend.
+    const async::Future<int> ready = async::submit([] { return 2; });
+    ready.wait();
+    co_return n * co_await ready;
+}
+
+async::Future<void> throws_after_await(std::atomic<int>& steps) {
+    co_await async::submit([] {});
+    steps.fetch_add(1);
+    throw lana::Error("from the coroutine");
+}
+
+LANA_TEST(async_futures_are_awaitable) {
+    const Matrix<double> a = lana::test::random_matrix<double>(40, 40, 6);
+    Matrix<double> c(40, 40);
+    const async::Future<double> f = norm_of_product(a, c);
+    const double got = f.get();
+    Matrix<double> ref(40, 40);
+    lana::test::reference_gemm<double>(1.0, a.view(), a.view(), 0.0, ref.view());
+    double sq = 0;
+    for (index_t i = 0; i < 40; ++i) {
+        sq += ref(i, 0) * ref(i, 0);
+    }
+    CHECK_NEAR(got, 2 * std::sqrt(sq), 1e-12);
+
+    std::atomic<int> steps{0};
+    const async::Future<void> t = throws_after_await(steps);
+    CHECK_THROWS(t.get(), lana::Error);
+    CHECK(steps.load() == 1);
+    // A later operation can depend on a coroutine.
+    const async::Future<bool> later = async::submit(async::after(f), [&] { return f.ready(); });
+    CHECK(later.get());
+}
+
+/// Runs every job inline, as a host with no threads to spare would.
+class InlineExecutor final : public lana::Executor {
+public:
+    int concurrency() const noexcept override { return 1; }
+    void execute(std::function<void()> fn) override { fn(); }
+};
+
+LANA_TEST(async_inline_executor_runs_in_the_call) {
+    lana::set_executor(std::make_shared<InlineExecutor>());
+    int calls = 0;
+    const async::Future<int> first = async::submit([&] { return ++calls; });
+    CHECK(first.ready());
+    const async::Future<int> second = async::submit(async::after(first), [&] { return ++calls; });
+    CHECK(second.ready() && second.get() == 2);
+    lana::set_executor(nullptr);
+}
+
+/// Holds jobs until run_held(), and throws instead once `refuse` is set,
+/// as an executor shutting down might.
+class RefusingExecutor final : public lana::Executor {
+public:
+    std::atomic<bool> refuse{false};
+
+    int concurrency() const noexcept override { return 2; }
+    void execute(std::function<void()> fn) override {
+        if (refuse.load()) {
+            throw std::runtime_error("executor: shutting down");
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        held_.push_back(std::move(fn));
+    }
+    void run_held() {
+        std::vector<std::function<void()>> jobs;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs.swap(held_);
+        }
+        for (auto& fn : jobs) {
+            fn();
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::function<void()>> held_;
+};
+
+LANA_TEST(async_refused_post_runs_the_continuation_inline) {
+    const auto ex = std::make_shared<RefusingExecutor>();
+    lana::set_executor(ex);
+    const async::Future<int> first = async::submit([] { return 20; });
+    const async::Future<int> second = async::submit(async::after(first), [&] { return first.get() + 1; });
+    CHECK(!first.ready() && !second.ready());
+    // Completing `first` posts `second`, from inside the noexcept finish();
+    // the executor refuses, so it runs right there instead.
+    ex->refuse = true;
+    ex->run_held();
+    CHECK(second.ready() && second.get() == 21);
+    // With no dependencies the same holds for the submitting thread.
+    CHECK(async::submit([] { return 5; }).get() == 5);
+    lana::set_executor(nullptr);
+}
+
+}  // namespace
@@ -0,0 +1,279 @@
+// Batched small-matrix kernels in all three layouts (strided, pointer,
+// interleaved) against per-matrix references: GEMM products, LU by
+// P * A = L * U and Cholesky by L * L^T = A, including singular and
+// indefinite members, at the compile-time sizes and ones between them.
+
+#include "check.hpp"
+
+#include "lana/batched.hpp"
+#include "lana/error.hpp"
+
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+namespace batched = lana::batched;
+
+enum class Layout { Strided, Pointer, Interleaved };
+constexpr Layout layouts[] = {Layout::Strided, Layout::Pointer, Layout::Interleaved};
+
+/// Sizes with a compiled kernel and sizes between them.
+constexpr index_t sizes[] = {1, 2, 3, 4, 5, 7, 8, 12, 13, 16, 32};
+
+/// A batch of matrices held in one layout: strided with a padded leading
+/// dimension and gaps between matrices, separate allocations behind a
+/// pointer array, or interleaved. get() copies them back out.
+template <typename T>
+class Stored {
+public:
+    Stored(Layout layout, const std::vector<Matrix<T>>& ms)
+        : layout_(layout), rows_(ms[0].rows()), cols_(ms[0].cols()), count_(static_cast<index_t>(ms.size())) {
+        ld_ = rows_ + 1;
+        stride_ = ld_ * cols_ + 3;
+        strided_.assign(static_cast<std::size_t>(stride_ * count_), T(-99));
+        for (index_t b = 0; b < count_; ++b) {
+            strided_batch()[b].assign(ms[static_cast<std::size_t>(b)].view());
+        }
+        if (layout == Layout::Pointer) {
+            for (index_t b = 0; b < count_; ++b) {
+                ptrs_.push_back(strided_batch().ptr(b));
+            }
+        } else if (layout == Layout::Interleaved) {
+            interleaved_ = batched::InterleavedBatch<T>(rows_, cols_, count_);
+            batched::pack<T>(strided_batch(), interleaved_.view());
+        }
+    }
+
+    template <typename F>
+    decltype(auto) visit(F&& f) {
+        switch (layout_) {
+            case Layout::Strided:
+                return f(strided_batch());
+            case Layout::Pointer:
+                return f(batched::PointerBatch<T>(ptrs_.data(), rows_, cols_, ld_, count_));
+            case Layout::Interleaved:
+                break;
+        }
+        return f(interleaved_.view());
+    }
+
+    std::vector<Matrix<T>> get() {
+        if (layout_ == Layout::Interleaved) {
+            batched::unpack<T>(interleaved_.view(), strided_batch());
+        }
+        std::vector<Matrix<T>> out;
+        for (index_t b = 0; b < count_; ++b) {
+            out.emplace_back(MatrixView<const T>(strided_batch()[b]));
+        }
+        return out;
+    }
+
+    /// The padding between strided matrices is never written.
+    bool gaps_untouched() const {
+        for (index_t b = 0; b < count_; ++b) {
+            for (index_t j = 0; j < cols_; ++j) {
+                if (strided_[static_cast<std::size_t>(b * stride_ + j * ld_ + rows_)] != T(-99)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    batched::StridedBatch<T> strided_batch() { return {strided_.data(), rows_, cols_, ld_, stride_, count_}; }
+
+    Layout layout_;
+    index_t rows_;
+    index_t cols_;
+    index_t count_;
+    index_t ld_ = 0;
+    index_t stride_ = 0;
+    std::vector<T> strided_;
+    std::vector<T*> ptrs_;
+    batched::InterleavedBatch<T> interleaved_;
+};
+
+template <typename T>
+std::vector<Matrix<T>> random_batch(index_t rows, index_t cols, index_t count, std::uint64_t seed) {
+    std::vector<Matrix<T>> ms;
+    for (index_t b = 0; b < count; ++b) {
+        ms.push_back(lana::test::random_matrix<T>(rows, cols, seed * 1000 + static_cast<std::uint64_t>(b)));
+    }
+    return ms;
+}
+
+template <typename T>
+void gemm_batches() {
+    const index_t count = 37;  // not a multiple of any interleave width
+    for (Layout layout : layouts) {
+        for (index_t n : sizes) {
+            for (const auto& [m, k] : {std::pair<index_t, index_t>{n, n}, {n + 1, 2}}) {
+                const auto a = random_batch<T>(m, k, count, 1);
+                const auto b = random_batch<T>(k, n, count, 2);
+                const auto c0 = random_batch<T>(m, n, count, 3);
+                for (const auto& [alpha, beta] : {std::pair<T, T>{1, 0}, {T(-0.5), T(2)}}) {
+                    Stored<T> sa(layout, a);
+                    Stored<T> sb(layout, b);
+                    std::vector<Matrix<T>> c_in = c0;
+                    if (beta == 0) {
+                        for (auto& c : c_in) {
+                            c.fill(std::numeric_limits<T>::quiet_NaN());
+                        }
+                    }
+                    Stored<T> sc(layout, c_in);
+                    sa.visit([&](auto ba) {
+                        sb.visit([&](auto bb) {
+                            sc.visit([&](auto bc) {
+                                // Every layout is the same; the other branches only compile.
+                                using A = std::remove_cvref_t<decltype(ba)>;
+                                if constexpr (std::is_same_v<A, std::remove_cvref_t<decltype(bb)>> &&
+                                              std::is_same_v<A, std::remove_cvref_t<decltype(bc)>>) {
+                                    batched::gemm(alpha, ba, bb, beta, bc);
+                                }
+                            });
+                        });
+                    });
+                    const auto c = sc.get();
+                    CHECK(sc.gaps_untouched());
+                    for (index_t i = 0; i < count; ++i) {
+                        const auto u = static_cast<std::size_t>(i);
+                        Matrix<T> ref = c0[u];
+                        lana::test::reference_gemm<T>(double(alpha), a[u].view(), b[u].view(), double(beta),
+                                                      ref.view());
+                        CHECK_LE(lana::test::max_abs_diff<T>(c[u].view(), ref.view()), lana::test::tolerance<T>(k));
+                    }
+                }
+            }
+        }
+    }
+}
+
+LANA_TEST(batched_f32_gemm) { gemm_batches<float>(); }
+LANA_TEST(batched_f64_gemm) { gemm_batches<double>(); }
+
+template <typename T>
+void getrf_batches() {
+    const index_t count = 21;
+    for (Layout layout : layouts) {
+        for (index_t n : sizes) {
+            auto a = random_batch<T>(n, n, count, 4);
+            // Matrix 5 has a zero column 1 in exact arithmetic (n > 1), so
+            // its U(1, 1) pivot search finds nothing.
+            const bool has_singular = n > 1;
+            if (has_singular) {
+                for (index_t i = 0; i < n; ++i) {
+                    a[5](i, 1) = T(0);
+                }
+            }
+            Stored<T> s(layout, a);
+            std::vector<std::int32_t> ipiv(static_cast<std::size_t>(n * count), -1);
+            std::vector<std::int32_t> info(static_cast<std::size_t>(count), -1);
+            const index_t singular =
+                s.visit([&](auto batch) { return batched::getrf(batch, ipiv.data(), info.data()); });
+            CHECK(singular == (has_singular ? 1 : 0));
+            const auto lu = s.get();
+            for (index_t b = 0; b < count; ++b) {
+                const auto u = static_cast<std::size_t>(b);
+                CHECK(info[u] == (has_singular && b == 5 ? 2 : 0));
+                // P * A, by the recorded swaps in order.
+                Matrix<T> pa = a[u];
+                for (index_t k = 0; k < n; ++k) {
+                    const index_t p = ipiv[static_cast<std::size_t>(b * n + k)];
+                    CHECK(p >= k && p < n);
+                    for (index_t j = 0; j < n; ++j) {
+                        std::swap(pa(k, j), pa(p, j));
+                    }
+                }
+                Matrix<T> l(n, n);
+                Matrix<T> up(n, n);
+                for (index_t j = 0; j < n; ++j) {
+                    for (index_t i = 0; i < n; ++i) {
+                        (i > j ? l : up)(i, j) = lu[u](i, j);
+                    }
+                    l(j, j) = T(1);
+                }
+                const Matrix<T> prod = lana::test::reference_product<T>(l.view(), up.view());
+                CHECK_LE(lana::test::max_abs_diff<T>(prod.view(), pa.view()), 4 * lana::test::tolerance<T>(n));
+            }
+        }
+    }
+}
+
+LANA_TEST(batched_f32_getrf) { getrf_batches<float>(); }
+LANA_TEST(batched_f64_getrf) { getrf_batches<double>(); }
+
+template <typename T>
+void potrf_batches() {
+    const index_t count = 19;
+    for (Layout layout : layouts) {
+        for (index_t n : sizes) {
+            std::vector<Matrix<T>> a;
+            for (index_t b = 0; b < count; ++b) {
+                a.push_back(lana::test::random_spd<T>(n, 500 + static_cast<std::uint64_t>(b)));
+                // A marker in the strict upper triangle, which must survive.
+                for (index_t j = 1; j < n; ++j) {
+                    a.back()(0, j) = T(42);
+                }
+            }
+            // Matrix 3 loses definiteness at its last diagonal entry.
+            a[3](n - 1, n - 1) = T(-1);
+            Stored<T> s(layout, a);
+            std::vector<std::int32_t> info(static_cast<std::size_t>(count), -1);
+            CHECK(s.visit([&](auto batch) { return batched::potrf(batch, info.data()); }) == 1);
+            const auto l = s.get();
+            for (index_t b = 0; b < count; ++b) {
+                const auto u = static_cast<std::size_t>(b);
+                if (b == 3) {
+                    CHECK(info[u] == n);
+                    continue;
+                }
+                CHECK(info[u] == 0);
+                Matrix<T> low(n, n);
+                for (index_t j = 0; j < n; ++j) {
+                    for (index_t i = j; i < n; ++i) {
+                        low(i, j) = l[u](i, j);
+                    }
+                    for (index_t i = 0; i < j; ++i) {
+                        CHECK(l[u](i, j) == a[u](i, j));
+                    }
+                }
+                const Matrix<T> llt = lana::test::reference_product<T>(low.view(), low.view().t());
+                for (index_t j = 0; j < n; ++j) {
+                    for (index_t i = j; i < n; ++i) {
+                        CHECK_NEAR(llt(i, j), a[u](i, j), 4 * lana::test::tolerance<T>(n));
+                    }
+                }
+            }
+        }
+    }
+}
+
+LANA_TEST(batched_f32_potrf) { potrf_batches<float>(); }
+LANA_TEST(batched_f64_potrf) { potrf_batches<double>(); }
+
+LANA_TEST(batched_pack_unpack_round_trip) {
+    const auto ms = random_batch<double>(3, 5, 11, 7);
+    Stored<double> s(Layout::Interleaved, ms);
+    const auto back = s.get();
+    for (std::size_t b = 0; b < ms.size(); ++b) {
+        CHECK(lana::test::max_abs_diff<double>(back[b].view(), ms[b].view()) == 0);
+    }
+
+    batched::InterleavedBatch<double> v(3, 5, 11);
+    CHECK(v.size() == 2 * 3 * 5 * batched::interleave_width<double>);
+    v(9, 2, 4) = 1.5;
+    CHECK(v.view()[9](2, 4) == 1.5);
+    std::vector<double> out(3 * 5 * 10);
+    CHECK_THROWS(batched::unpack<double>(v.view(), batched::StridedBatch<double>(out.data(), 3, 5, 10)),
+                 lana::DimensionError);
+}
+
+}  // namespace
@@ -0,0 +1,194 @@
+// The benchmark harness's statistics and reports: percentiles, timing
+// loops, merged rounds, and text reports that read back what was written
+// and reject what was not.
+
+#include "check.hpp"
+
+#include "harness.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using lana::bench::Metadata;
+using lana::bench::Result;
+
+Result result(const char* kernel, const char* dtype, lana::index_t n, int threads, double p50_us) {
+    Result r;
+    r.kernel = kernel;
+    r.dtype = dtype;
+    r.n = n;
+    r.threads = threads;
+    r.samples = 40;
+    r.p50_s = p50_us * 1e-6;
+    r.p99_s = 2 * p50_us * 1e-6;
+    r.mad_s = 0.25 * p50_us * 1e-6;
+    r.flops = 2e6;
+    r.bytes = 8e6;
+    return r;
+}
+
+LANA_TEST(bench_percentile_is_nearest_rank) {
+    using lana::bench::percentile;
+    CHECK(percentile({}, 0.5) == 0);
+    CHECK(percentile({5, 1, 4, 2, 3}, 0.5) == 3);
+    CHECK(percentile({5, 1, 4, 2, 3}, 0.0) == 1);
+    CHECK(percentile({5, 1, 4, 2, 3}, 1.0) == 5);
+    std::vector<double> hundred;
+    for (int i = 100; i >= 1; --i) {
+        hundred.push_back(i);
+    }
+    CHECK(percentile(hundred, 0.99) == 99);
+    CHECK(percentile(hundred, 0.50) == 50);
+    CHECK(percentile({7}, 0.99) == 7);
+}
+
+LANA_TEST(bench_measure_honours_sample_limits) {
+    int calls = 0;
+    lana::bench::Workload w;
+    w.flops = 1e3;
+    w.bytes = 4e3;
+    w.run = [&calls] { ++calls; };
+
+    lana::bench::TimingOptions opt;
+    opt.min_time_s = 0;
+    opt.min_samples = 7;
+    opt.max_samples = 7;
+    opt.warmup = 2;
+    const Result r = lana::bench::measure(w, opt);
+    CHECK(calls == 9);
+    CHECK(r.samples == 7);
+    CHECK(r.flops == 1e3 && r.bytes == 4e3);
+    CHECK_LE(r.min_s, r.p50_s);
+    CHECK_LE(r.p50_s, r.p99_s);
+    CHECK_LE(r.mad_s, r.p99_s);
+
+    // A time budget the samples never reach still stops at max_samples.
+    calls = 0;
+    opt.min_time_s = 1e6;
+    opt.max_samples = 12;
+    opt.warmup = 0;
+    CHECK(lana::bench::measure(w, opt).samples == 12);
+    CHECK(calls == 12);
+}
+
+LANA_TEST(bench_combine_rounds_keeps_the_fastest_round) {
+    std::vector<Result> rounds;
+    const double p50_us[] = {3, 1, 2};
+    const double p99_us[] = {9, 8, 10};
+    for (int i = 0; i < 3; ++i) {
+        Result r = result("gemm", "f64", 64, 1, p50_us[i]);
+        r.p99_s = p99_us[i] * 1e-6;
+        r.mad_s = 0.1 * (i + 1) * 1e-6;
+        r.min_s = 0.5 * p50_us[i] * 1e-6;
+        r.samples = 10 * (i + 1);
+        rounds.push_back(r);
+    }
+    const Result c = lana::bench::combine_rounds(rounds);
+    CHECK_NEAR(c.p50_s, 1e-6, 1e-15);
+    CHECK_NEAR(c.mad_s, 0.2e-6, 1e-15);  // the fastest round's own spread
+    CHECK_NEAR(c.p99_s, 8e-6, 1e-15);
+    CHECK_NEAR(c.min_s, 0.5e-6, 1e-15);
+    CHECK(c.samples == 60);
+    CHECK(c.rounds == 3);
+    // p50s {3, 1, 2}: median 2, deviations {1, 1, 0}, MAD 1.
+    CHECK_NEAR(c.round_mad_s, 1e-6, 1e-15);
+
+    const Result one = lana::bench::combine_rounds({rounds[0]});
+    CHECK(one.rounds == 1 && one.round_mad_s == 0 && one.p50_s == rounds[0].p50_s);
+}
+
+LANA_TEST(bench_text_report_round_trips) {
+    std::vector<Result> results = {result("spmv_csr", "f32", 1000, 4, 12.5), result("gemm", "f64", 256, 1, 850.25),
+                                   result("gemm", "f32", 256, 1, 400.75), result("gemm", "f32", 64, 1, 7.125)};
+    results[1].rounds = 5;
+    results[1].round_mad_s = 3.5e-6;
+    const Metadata meta = {{"isa", "avx2"}, {"threads", "1"}, {"gate.tolerance", "0.2"}};
+    std::stringstream report;
+    lana::bench::write_text(report, meta, results);
+
+    Metadata meta_in;
+    std::vector<Result> in;
+    lana::bench::read_text(report, meta_in, in);
+    CHECK(meta_in == meta);
+    CHECK(in.size() == results.size());
+    // Written sorted by (kernel, dtype, n, threads).
+    const Result* expected[] = {&results[3], &results[2], &results[1], &results[0]};
+    // Times are printed to the nanosecond.
+    const double ns = 0.5e-9;
+    for (std::size_t i = 0; i < in.size(); ++i) {
+        const Result& a = in[i];
+        const Result& b = *expected[i];
+        CHECK(a.kernel == b.kernel && a.dtype == b.dtype && a.n == b.n && a.threads == b.threads);
+        CHECK(a.samples == b.samples && a.rounds == b.rounds);
+        CHECK_NEAR(a.p50_s, b.p50_s, ns);
+        CHECK_NEAR(a.p99_s, b.p99_s, ns);
+        CHECK_NEAR(a.mad_s, b.mad_s, ns);
+        CHECK_NEAR(a.round_mad_s, b.round_mad_s, ns);
+        CHECK_NEAR(a.gflops(), b.gflops(), 1e-3);
+        CHECK_NEAR(a.bytes_per_flop(), b.bytes_per_flop(), 1e-5);
+    }
+
+    // Writing what was read gives the same report.
+    std::stringstream again;
+    lana::bench::write_text(again, meta_in, in);
+    std::stringstream first;
+    lana::bench::write_text(first, meta, results);
+    CHECK(again.str() == first.str());
+}
+
+LANA_TEST(bench_reads_v1_reports_and_stops_at_the_profile_table) {
+    std::istringstream v1(
+        "# lana_bench report v1\n"
+        "# isa=sse4.2\n"
+        "kernel dtype n threads gflops bytes_per_flop p50_us p99_us samples\n"
+        "dot f64 4096 1 2.000 8.00000 4.096 5.000 100\n"
+        "\n"
+        "kernel calls total_us\n"
+        "dot 100 409.6\n");
+    Metadata meta;
+    std::vector<Result> in;
+    lana::bench::read_text(v1, meta, in);
+    CHECK(meta.size() == 1 && meta[0].first == "isa" && meta[0].second == "sse4.2");
+    CHECK(in.size() == 1);
+    CHECK(in[0].kernel == "dot" && in[0].n == 4096 && in[0].samples == 100);
+    CHECK(in[0].rounds == 1 && in[0].mad_s == 0 && in[0].round_mad_s == 0);
+    CHECK_NEAR(in[0].p50_s, 4.096e-6, 1e-15);
+    CHECK_NEAR(in[0].gflops(), 2.0, 1e-9);
+}
+
+LANA_TEST(bench_read_text_rejects_malformed_reports) {
+    const auto read = [](const std::string& text) {
+        std::istringstream is(text);
+        Metadata meta;
+        std::vector<Result> results;
+        lana::bench::read_text(is, meta, results);
+        return results.size();
+    };
+    CHECK_THROWS(read(""), std::runtime_error);
+    CHECK_THROWS(read("gemm f64 64 1 1 1 1 1 1\n"), std::runtime_error);
+    CHECK_THROWS(read("# lana_bench report v3\n"), std::runtime_error);
+    CHECK(read("# lana_bench report v2\n") == 0);
+
+    // The message names the offending line.
+    std::string message;
+    try {
+        read("# lana_bench report v2\nkernel dtype\ngemm f64 64 1 1.0 0.5 2.0 3.0 10\n");
+    } catch (const std::runtime_error& e) {
+        message = e.what();
+    }
+    CHECK(message.rfind("line 3:", 0) == 0);
+}
+
+LANA_TEST(bench_split_list_drops_empty_items) {
+    using lana::bench::split_list;
+    CHECK(split_list("").empty());
+    CHECK(split_list("gemm") == std::vector<std::string>{"gemm"});
+    CHECK((split_list("f32,f64,bf16") == std::vector<std::string>{"f32", "f64", "bf16"}));
+    CHECK((split_list(",a,,b,") == std::vector<std::string>{"a", "b"}));
+}
+
+}  // namespace
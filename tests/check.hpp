@@ -0,0 +1,223 @@
+#pragma once
+
+// Minimal test harness for lana's test executables.
+//
+// Each test file defines cases with LANA_TEST(name) and checks with the
+// CHECK macros below; main.cpp runs every registered case and exits with
+// 1 if any check failed. A failing check aborts its case only. ctest runs
+// each executable under several LANA_ISA / LANA_NUM_THREADS settings (see
+// tests/CMakeLists.txt), and an executable asked for an ISA this host or
+// build cannot run exits with skip_code instead of testing another one.
+
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace lana::test {
+
+/// ctest's SKIP_RETURN_CODE for the test executables.
+constexpr int skip_code = 77;
+
+struct Case {
+    const char* name;
+    void (*run)();
+};
+
+std::vector<Case>& registry();
+
+struct Register {
+    Register(const char* name, void (*run)()) { registry().push_back({name, run}); }
+};
+
+/// Thrown by a failing check; main.cpp reports it and moves to the next case.
+struct Failure {
+    std::string message;
+};
+
+[[noreturn]] void fail(const char* file, int line, const std::string& what);
+
+/// Deterministic values in [-1, 1) (xorshift), so failures reproduce.
+class Rng {
+public:
+    explicit Rng(std::uint64_t seed) : s_(seed * 0x9e3779b97f4a7c15ull + 1) {}
+    double next() {
+        s_ ^= s_ << 13;
+        s_ ^= s_ >> 7;
+        s_ ^= s_ << 17;
+        return static_cast<double>(s_ >> 11) * 0x1.0p-52 - 1.0;
+    }
+
+private:
+    std::uint64_t s_;
+};
+
+template <typename T>
+Matrix<T> random_matrix(index_t rows, index_t cols, std::uint64_t seed) {
+    Rng rng(seed);
+    Matrix<T> m(rows, cols, uninitialized);
+    for (index_t j = 0; j < cols; ++j) {
+        for (index_t i = 0; i < rows; ++i) {
+            m(i, j) = static_cast<T>(rng.next());
+        }
+    }
+    return m;
+}
+
+template <typename T>
+Vector<T> random_vector(index_t n, std::uint64_t seed) {
+    Rng rng(seed);
+    Vector<T> v(n, uninitialized);
+    for (index_t i = 0; i < n; ++i) {
+        v[i] = static_cast<T>(rng.next());
+    }
+    return v;
+}
+
+/// Symmetric positive definite: B * B^T / n + I.
+template <typename T>
+Matrix<T> random_spd(index_t n, std::uint64_t seed) {
+    const Matrix<T> b = random_matrix<T>(n, n, seed);
+    Matrix<T> a(n, n);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < n; ++i) {
+            double s = 0;
+            for (index_t p = 0; p < n; ++p) {
+                s += double(b(i, p)) * double(b(j, p));
+            }
+            a(i, j) = static_cast<T>(s / double(n) + (i == j ? 1.0 : 0.0));
+        }
+    }
+    return a;
+}
+
+/// C = alpha * A * B + beta * C by the textbook triple loop, in double.
+template <typename T>
+void reference_gemm(double alpha, MatrixView<const T> a, MatrixView<const T> b, double beta, MatrixView<T> c) {
+    for (index_t j = 0; j < c.cols(); ++j) {
+        for (index_t i = 0; i < c.rows(); ++i) {
+            double s = 0;
+            for (index_t p = 0; p < a.cols(); ++p) {
+                s += double(a(i, p)) * double(b(p, j));
+            }
+            c(i, j) = static_cast<T>(alpha * s + (beta == 0 ? 0.0 : beta * double(c(i, j))));
+        }
+    }
+}
+
+template <typename T>
+Matrix<T> reference_product(MatrixView<const T> a, MatrixView<const T> b) {
+    Matrix<T> c(a.rows(), b.cols());
+    reference_gemm<T>(1.0, a, b, 0.0, c.view());
+    return c;
+}
+
+/// Both maxima are NaN when any element is, so a NaN fails every bound.
+template <typename T>
+double max_abs(MatrixView<const T> a) {
+    double m = 0;
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            const double d = std::abs(double(a(i, j)));
+            if (std::isnan(d)) {
+                return d;
+            }
+            m = std::max(m, d);
+        }
+    }
+    return m;
+}
+
+template <typename T>
+double max_abs_diff(MatrixView<const T> a, MatrixView<const T> b) {
+    double m = 0;
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            const double d = std::abs(double(a(i, j)) - double(b(i, j)));
+            if (std::isnan(d)) {
+                return d;
+            }
+            m = std::max(m, d);
+        }
+    }
+    return m;
+}
+
+/// max |Q^T Q - I| over the columns of q.
+template <typename T>
+double orthogonality_error(MatrixView<const T> q) {
+    double m = 0;
+    for (index_t j = 0; j < q.cols(); ++j) {
+        for (index_t k = 0; k < q.cols(); ++k) {
+            double s = 0;
+            for (index_t i = 0; i < q.rows(); ++i) {
+                s += double(q(i, j)) * double(q(i, k));
+            }
+            m = std::max(m, std::abs(s - (j == k ? 1.0 : 0.0)));
+        }
+    }
+    return m;
+}
+
+/// Relative tolerance for n-term sums in T.
+template <typename T>
+double tolerance(index_t n) {
+    return 8.0 * double(std::numeric_limits<T>::epsilon()) * double(std::max<index_t>(n, 1));
+}
+
+}  // namespace lana::test
+
+#define LANA_TEST(name)                                                   \
+    static void name();                                                   \
+    static const ::lana::test::Register name##_registration(#name, name); \
+    static void name()
+
+#define CHECK(cond)                                                     \
+    do {                                                                \
+        if (!(cond)) {                                                  \
+            ::lana::test::fail(__FILE__, __LINE__, "CHECK(" #cond ")"); \
+        }                                                               \
+    } while (0)
+
+/// |a - b| <= tol, printing both values when it is not.
+#define CHECK_NEAR(a, b, tol)                                                                        \
+    do {                                                                                             \
+        const double check_a_ = static_cast<double>(a);                                              \
+        const double check_b_ = static_cast<double>(b);                                              \
+        if (!(std::abs(check_a_ - check_b_) <= static_cast<double>(tol))) {                          \
+            std::ostringstream check_os_;                                                            \
+            check_os_ << "CHECK_NEAR(" #a ", " #b ", " #tol "): " << check_a_ << " vs " << check_b_; \
+            ::lana::test::fail(__FILE__, __LINE__, check_os_.str());                                 \
+        }                                                                                            \
+    } while (0)
+
+/// a <= b, printing both values when it is not.
+#define CHECK_LE(a, b)                                                                  \
+    do {                                                                                \
+        const double check_a_ = static_cast<double>(a);                                 \
+        const double check_b_ = static_cast<double>(b);                                 \
+        if (!(check_a_ <= check_b_)) {                                                  \
+            std::ostringstream check_os_;                                               \
+            check_os_ << "CHECK_LE(" #a ", " #b "): " << check_a_ << " > " << check_b_; \
+            ::lana::test::fail(__FILE__, __LINE__, check_os_.str());                    \
+        }                                                                               \
+    } while (0)
+
+#define CHECK_THROWS(expr, type)                                                          \
+    do {                                                                                  \
+        bool check_thrown_ = false;                                                       \
+        try {                                                                             \
+            (void)(expr);                                                                 \
+        } catch (const type&) {                                                           \
+            check_thrown_ = true;                                                         \
+        }                                                                                 \
+        if (!check_thrown_) {                                                             \
+            ::lana::test::fail(__FILE__, __LINE__, "CHECK_THROWS(" #expr ", " #type ")"); \
+        }                                                                                 \
+    } while (0)
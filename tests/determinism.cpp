@@ -0,0 +1,91 @@
+// Determinism::Bitwise: reductions, and the solvers built on them, give
+// the same bits whatever the pool size. Each pool size is set in-process,
+// so every kernel path (LANA_ISA) is compared against itself.
+
+#include "check.hpp"
+
+#include "lana/blas1.hpp"
+#include "lana/krylov.hpp"
+#include "lana/sparse.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <cstring>
+
+namespace {
+
+using lana::index_t;
+using lana::Vector;
+using lana::VectorView;
+
+struct Outcome {
+    double dot = 0, sum = 0, nrm2 = 0;
+    float dot_f32 = 0;
+    Vector<double> x;
+    index_t iterations = 0;
+};
+
+bool same_bits(double a, double b) { return std::memcmp(&a, &b, sizeof a) == 0; }
+
+Outcome run() {
+    // Odd lengths, so the last block is partial.
+    const index_t n = (index_t(1) << 19) + 13;
+    const Vector<double> a = lana::test::random_vector<double>(n, 1);
+    const Vector<double> b = lana::test::random_vector<double>(n, 2);
+    const Vector<float> af = lana::test::random_vector<float>(n, 3);
+    const Vector<float> bf = lana::test::random_vector<float>(n, 4);
+    Outcome o;
+    o.dot = lana::dot(a.view(), b.view());
+    o.sum = lana::sum(a.view());
+    o.nrm2 = lana::nrm2(b.view());
+    o.dot_f32 = lana::dot(af.view(), bf.view());
+
+    const index_t g = 300;
+    lana::Coo<double> coo(g * g, g * g);
+    for (index_t i = 0; i < g * g; ++i) {
+        coo.add(i, i, 4.01);
+        if (i % g > 0) coo.add(i, i - 1, -1);
+        if (i % g + 1 < g) coo.add(i, i + 1, -1);
+        if (i >= g) coo.add(i, i - g, -1);
+        if (i + g < g * g) coo.add(i, i + g, -1);
+    }
+    const lana::Csr<double> m(coo);
+    const Vector<double> rhs = lana::test::random_vector<double>(g * g, 5);
+    o.x = Vector<double>(g * g);
+    lana::krylov::Options opts;
+    opts.max_iterations = 40;
+    o.iterations = lana::krylov::cg(m, VectorView<const double>(rhs.view()), o.x.view(), lana::krylov::Identity{}, opts)
+                       .iterations;
+    return o;
+}
+
+LANA_TEST(bitwise_results_ignore_pool_size) {
+    lana::set_determinism(lana::Determinism::Bitwise);
+    lana::set_num_threads(1);
+    const Outcome ref = run();
+    for (int threads : {2, 3, 4}) {
+        lana::set_num_threads(threads);
+        const Outcome o = run();
+        CHECK(same_bits(o.dot, ref.dot));
+        CHECK(same_bits(o.sum, ref.sum));
+        CHECK(same_bits(o.nrm2, ref.nrm2));
+        CHECK(std::memcmp(&o.dot_f32, &ref.dot_f32, sizeof(float)) == 0);
+        CHECK(o.iterations == ref.iterations);
+        for (index_t i = 0; i < o.x.size(); ++i) {
+            CHECK(same_bits(o.x[i], ref.x[i]));
+        }
+    }
+    lana::set_num_threads(0);
+    lana::set_determinism(lana::Determinism::Fast);
+}
+
+LANA_TEST(fast_and_bitwise_agree_to_rounding) {
+    const Vector<double> a = lana::test::random_vector<double>(1 << 20, 6);
+    const Vector<double> b = lana::test::random_vector<double>(1 << 20, 7);
+    const double fast = lana::dot(a.view(), b.view());
+    lana::set_determinism(lana::Determinism::Bitwise);
+    const double bitwise = lana::dot(a.view(), b.view());
+    lana::set_determinism(lana::Determinism::Fast);
+    CHECK_NEAR(fast, bitwise, 1e-10 * std::sqrt(double(a.size())));
+}
+
+}  // namespace
@@ -0,0 +1,353 @@
+// Device offload through a mock plugin that runs host loops: lana finds
+// the plugin through LANA_DEVICE_PLUGIN or load(), rejects files that are
+// not plugins, sends gemm, getrf, potrf and resident spmv to it only when
+// the policy and cost model say so, and runs the call on the CPU when the
+// plugin fails it. Results are the same either way.
+
+#include "check.hpp"
+
+#include "lana/device.hpp"
+#include "lana/device_plugin.hpp"
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/sparse.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <dlfcn.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+namespace device = lana::device;
+
+/// Mirrors the mock's control block (tests/device_mock.cpp).
+struct Control {
+    std::uint32_t abi_version;
+    int no_device;
+    int fail_query;
+    int fail_ops;
+    int live;
+    int gemm_calls;
+    int getrf_calls;
+    int potrf_calls;
+    int spmv_calls;
+    int uploads;
+    int releases;
+    int shutdowns;
+    int dead_calls;
+};
+
+/// The mock's control block. Holding our own handle keeps the mock, and
+/// its counters, loaded across lana's unload().
+Control& mock() {
+    static Control* c = [] {
+        void* lib = ::dlopen(LANA_TEST_DEVICE_MOCK, RTLD_NOW | RTLD_LOCAL);
+        CHECK(lib != nullptr);
+        const auto get = reinterpret_cast<Control* (*)()>(::dlsym(lib, "lana_mock_control_block"));
+        CHECK(get != nullptr);
+        return get();
+    }();
+    return *c;
+}
+
+/// Offload anything the device is asked about.
+device::Policy eager() {
+    device::Policy p;
+    p.min_flops = 0;
+    p.min_dim = 1;
+    p.min_spmv_nnz = 0;
+    p.cpu_gflops_f32 = 1;
+    p.cpu_gflops_f64 = 1;
+    return p;
+}
+
+/// The policy in force for one case.
+struct WithPolicy {
+    explicit WithPolicy(const device::Policy& p) : saved(device::policy()) { device::set_policy(p); }
+    ~WithPolicy() { device::set_policy(saved); }
+    device::Policy saved;
+};
+
+// First: the environment is read on the first device query in a process.
+LANA_TEST(device_plugin_loads_from_the_environment) {
+    mock();
+    ::setenv("LANA_DEVICE_PLUGIN", LANA_TEST_DEVICE_MOCK, 1);
+    CHECK(device::available());
+    const device::Info info = device::info();
+    CHECK(info.name == "lana mock device" && info.platform == "mock");
+    CHECK(info.gflops_f64 == 1e9 && info.memory_bytes == std::size_t(16) << 30);
+    CHECK(mock().live == 1);
+
+    // Loading it again keeps the live backend.
+    device::load(LANA_TEST_DEVICE_MOCK);
+    CHECK(mock().live == 1 && mock().shutdowns == 0);
+}
+
+LANA_TEST(device_load_rejects_what_is_not_a_plugin) {
+    CHECK_THROWS(device::load("/nonexistent/liblana_none.so"), lana::Error);
+    CHECK_THROWS(device::load(LANA_TEST_NOT_A_PLUGIN), lana::Error);
+    // A failed load leaves the loaded plugin in place.
+    CHECK(device::available() && mock().live == 1);
+
+    device::unload();
+    CHECK(!device::available() && mock().live == 0 && mock().shutdowns == 1);
+    CHECK_THROWS(device::info(), lana::Error);
+    CHECK(!device::offloads_gemm(4096, 4096, 4096, false));
+
+    mock().abi_version = LANA_DEVICE_ABI_VERSION + 1;
+    CHECK_THROWS(device::load(LANA_TEST_DEVICE_MOCK), lana::Error);
+    mock().abi_version = LANA_DEVICE_ABI_VERSION;
+    mock().no_device = 1;
+    CHECK_THROWS(device::load(LANA_TEST_DEVICE_MOCK), lana::Error);
+    mock().no_device = 0;
+    mock().fail_query = 1;
+    CHECK_THROWS(device::load(LANA_TEST_DEVICE_MOCK), lana::Error);
+    mock().fail_query = 0;
+    CHECK(!device::available());
+
+    device::load(LANA_TEST_DEVICE_MOCK);
+    CHECK(device::available() && mock().live == 1);
+}
+
+template <typename T>
+void offloaded_gemm() {
+    const Matrix<T> a = lana::test::random_matrix<T>(70, 40, 1);
+    const Matrix<T> b = lana::test::random_matrix<T>(40, 50, 2);
+    const Matrix<T> c0 = lana::test::random_matrix<T>(70, 50, 3);
+    Matrix<T> ref = c0;
+    lana::test::reference_gemm<T>(1.5, a.view(), b.view(), -1.0, ref.view());
+    const bool f64 = std::is_same_v<T, double>;
+    const auto run = [&] {
+        Matrix<T> c = c0;
+        lana::gemm(T(1.5), a.view(), b.view(), T(-1), c.view());
+        CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(40));
+    };
+    const WithPolicy on(eager());
+
+    int calls = mock().gemm_calls;
+    run();
+    CHECK(mock().gemm_calls == calls + 1);
+    CHECK(device::offloads_gemm(70, 50, 40, f64));
+
+    // A transposed operand is still a unit-stride view.
+    Matrix<T> c = c0;
+    const Matrix<T> at(a.view().t());
+    lana::gemm(T(1.5), at.view().t(), b.view(), T(-1), c.view());
+    CHECK(mock().gemm_calls == calls + 2);
+    CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(40));
+
+    // A failed call runs on the CPU instead, with the same result.
+    mock().fail_ops = 1;
+    run();
+    mock().fail_ops = 0;
+    CHECK(mock().gemm_calls == calls + 3);
+
+    // Stays on the CPU: a view with no unit stride, the policy off, a
+    // dimension below the floor, too few flops, or a slow device.
+    calls = mock().gemm_calls;
+    Matrix<T> wide(140, 40);
+    const auto strided = lana::MatrixView<const T>(wide.data(), 70, 40, 2, 140);
+    Matrix<T> cs(70, 50);
+    lana::gemm(T(1), strided, b.view(), T(0), cs.view());
+    device::Policy p = eager();
+    p.enabled = false;
+    device::set_policy(p);
+    run();
+    CHECK(!device::offloads_gemm(70, 50, 40, f64));
+    p = eager();
+    p.min_dim = 41;
+    device::set_policy(p);
+    run();
+    CHECK(!device::offloads_gemm(70, 50, 40, f64) && device::offloads_gemm(70, 50, 41, f64));
+    p = eager();
+    p.min_flops = 2.0 * 70 * 50 * 40 + 1;
+    device::set_policy(p);
+    run();
+    p = eager();
+    p.cpu_gflops_f32 = p.cpu_gflops_f64 = 1e12;
+    device::set_policy(p);
+    run();
+    CHECK(!device::offloads_gemm(70, 50, 40, f64));
+    CHECK(mock().gemm_calls == calls);
+
+    // Bitwise determinism keeps everything on the host.
+    device::set_policy(eager());
+    lana::set_determinism(lana::Determinism::Bitwise);
+    run();
+    lana::set_determinism(lana::Determinism::Fast);
+    CHECK(mock().gemm_calls == calls);
+}
+
+LANA_TEST(device_f32_gemm) { offloaded_gemm<float>(); }
+LANA_TEST(device_f64_gemm) { offloaded_gemm<double>(); }
+
+template <typename T>
+void offloaded_factorizations() {
+    const WithPolicy on(eager());
+    const index_t n = 60;
+    const Matrix<T> a0 = lana::test::random_matrix<T>(n, n, 4);
+    const Matrix<T> s0 = lana::test::random_spd<T>(n, 5);
+    const double tol = 100 * lana::test::tolerance<T>(n);
+
+    // On the CPU first, for the reference.
+    device::Policy off = eager();
+    off.enabled = false;
+    device::set_policy(off);
+    Matrix<T> lu_ref = a0;
+    std::vector<std::int32_t> piv_ref(n);
+    CHECK(lana::getrf(lu_ref.view(), piv_ref.data()) == 0);
+    Matrix<T> ch_ref = s0;
+    CHECK(lana::potrf(ch_ref.view()) == 0);
+    device::set_policy(eager());
+
+    const int getrfs = mock().getrf_calls;
+    const int potrfs = mock().potrf_calls;
+    Matrix<T> lu = a0;
+    std::vector<std::int32_t> piv(n);
+    CHECK(lana::getrf(lu.view(), piv.data()) == 0);
+    CHECK(mock().getrf_calls == getrfs + 1);
+    CHECK(piv == piv_ref);
+    CHECK_LE(lana::test::max_abs_diff<T>(lu.view(), lu_ref.view()), tol);
+
+    Matrix<T> ch = s0;
+    CHECK(lana::potrf(ch.view()) == 0);
+    CHECK(mock().potrf_calls == potrfs + 1);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j; i < n; ++i) {
+            CHECK_NEAR(ch(i, j), ch_ref(i, j), tol);
+        }
+    }
+
+    // The device's info comes back as the CPU's would.
+    Matrix<T> singular = a0;
+    for (index_t i = 0; i < n; ++i) {
+        singular(i, 3) = T(0);
+    }
+    CHECK(lana::getrf(singular.view(), piv.data()) == 4);
+    Matrix<T> indefinite = s0;
+    indefinite(7, 7) = T(-1);
+    CHECK(lana::potrf(indefinite.view()) == 8);
+
+    // A failed factorization runs on the CPU from the untouched input.
+    mock().fail_ops = 1;
+    lu = a0;
+    CHECK(lana::getrf(lu.view(), piv.data()) == 0);
+    ch = s0;
+    CHECK(lana::potrf(ch.view()) == 0);
+    mock().fail_ops = 0;
+    CHECK(lana::test::max_abs_diff<T>(lu.view(), lu_ref.view()) == 0 && piv == piv_ref);
+    CHECK(ch(n - 1, n - 1) == ch_ref(n - 1, n - 1));
+}
+
+LANA_TEST(device_f32_factorizations) { offloaded_factorizations<float>(); }
+LANA_TEST(device_f64_factorizations) { offloaded_factorizations<double>(); }
+
+template <typename T>
+void resident_spmv() {
+    Matrix<T> dense = lana::test::random_matrix<T>(90, 70, 6);
+    for (index_t j = 0; j < 70; ++j) {
+        for (index_t i = 0; i < 90; ++i) {
+            if ((i + 3 * j) % 4 != 0) {
+                dense(i, j) = T(0);
+            }
+        }
+    }
+    const lana::Csr<T> a = lana::Csr<T>::from_dense(dense.view());
+    const lana::Vector<T> x = lana::test::random_vector<T>(70, 7);
+    const lana::Vector<T> y0 = lana::test::random_vector<T>(90, 8);
+    const auto ref = [&] {
+        Matrix<T> r(90, 1);
+        for (index_t i = 0; i < 90; ++i) {
+            r(i, 0) = -y0[i];
+            for (index_t j = 0; j < 70; ++j) {
+                r(i, 0) += T(2) * dense(i, j) * x[j];
+            }
+        }
+        return r;
+    }();
+    const auto check = [&] {
+        lana::Vector<T> y = y0;
+        lana::spmv(T(2), a.view(), x.view(), T(-1), y.view());
+        for (index_t i = 0; i < 90; ++i) {
+            CHECK_NEAR(y[i], ref(i, 0), lana::test::tolerance<T>(70));
+        }
+    };
+    const WithPolicy on(eager());
+
+    // Not resident: the CPU, however large.
+    const int spmvs = mock().spmv_calls;
+    check();
+    CHECK(mock().spmv_calls == spmvs);
+    {
+        device::Policy p = eager();
+        p.min_spmv_nnz = a.nnz() + 1;
+        device::set_policy(p);
+        const device::ResidentCsr small(a.view());
+        CHECK(!small.resident());
+        device::set_policy(eager());
+    }
+
+    const int releases = mock().releases;
+    {
+        device::ResidentCsr r(a.view());
+        CHECK(r.resident());
+        check();
+        CHECK(mock().spmv_calls == spmvs + 1);
+        device::ResidentCsr moved = std::move(r);
+        CHECK(!r.resident() && moved.resident());
+        check();
+        CHECK(mock().spmv_calls == spmvs + 2);
+
+        // Another matrix with the same shape is not the resident one.
+        const lana::Csr<T> other = lana::Csr<T>::from_dense(dense.view());
+        lana::Vector<T> y = y0;
+        lana::spmv(T(2), other.view(), x.view(), T(-1), y.view());
+        CHECK(mock().spmv_calls == spmvs + 2);
+
+        mock().fail_ops = 1;
+        check();
+        mock().fail_ops = 0;
+        CHECK(mock().spmv_calls == spmvs + 3);
+    }
+    CHECK(mock().releases == releases + 1);
+    check();
+    CHECK(mock().spmv_calls == spmvs + 3);
+}
+
+LANA_TEST(device_f32_resident_spmv) { resident_spmv<float>(); }
+LANA_TEST(device_f64_resident_spmv) { resident_spmv<double>(); }
+
+LANA_TEST(device_unload_with_resident_matrices) {
+    const WithPolicy on(eager());
+    const Matrix<double> dense = lana::test::random_matrix<double>(30, 30, 9);
+    const lana::Csr<double> a = lana::Csr<double>::from_dense(dense.view());
+    const lana::Vector<double> x = lana::test::random_vector<double>(30, 10);
+    lana::Vector<double> y(30);
+    const int releases = mock().releases;
+    {
+        const device::ResidentCsr r(a.view());
+        CHECK(r.resident());
+        // unload() releases it; the ResidentCsr outliving the plugin must
+        // not release it twice or reach the dead backend.
+        device::unload();
+        CHECK(mock().releases == releases + 1);
+        lana::spmv(1.0, a.view(), x.view(), 0.0, y.view());
+    }
+    CHECK(mock().releases == releases + 1 && mock().dead_calls == 0);
+    Matrix<double> c(30, 30);
+    lana::gemm(1.0, dense.view(), dense.view(), 0.0, c.view());
+    CHECK(mock().dead_calls == 0);
+    device::load(LANA_TEST_DEVICE_MOCK);
+    CHECK(device::available());
+}
+
+}  // namespace
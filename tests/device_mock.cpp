@@ -0,0 +1,240 @@
+// A device plugin that "offloads" to plain host loops, for test_device.
+// It speaks the plugin ABI only (no lana headers beyond it, no lana link),
+// counts every call, and can be told through lana_mock_control() to fail
+// in each of the ways a real backend can.
+
+#include "lana/device_plugin.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+
+struct lana_mock_control {
+    std::uint32_t abi_version;  ///< reported by the next entry call
+    int no_device;              ///< entry returns null
+    int fail_query;
+    int fail_ops;  ///< every operation returns nonzero without running
+    int live;      ///< between entry and shutdown
+    int gemm_calls;
+    int getrf_calls;
+    int potrf_calls;
+    int spmv_calls;
+    int uploads;
+    int releases;
+    int shutdowns;
+    int dead_calls;  ///< operations called after shutdown
+};
+
+__attribute__((visibility("default"))) lana_mock_control* lana_mock_control_block(void);
+__attribute__((visibility("default"))) const lana_device_backend* lana_device_backend_v1(void);
+
+}  // extern "C"
+
+namespace {
+
+lana_mock_control control = {LANA_DEVICE_ABI_VERSION, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+double load(const lana_device_matrix* m, std::int64_t i, std::int64_t j) {
+    const std::int64_t at = i * m->row_stride + j * m->col_stride;
+    return m->dtype == LANA_DEVICE_F64 ? static_cast<const double*>(m->data)[at]
+                                       : static_cast<const float*>(m->data)[at];
+}
+
+void store(const lana_device_matrix* m, std::int64_t i, std::int64_t j, double v) {
+    const std::int64_t at = i * m->row_stride + j * m->col_stride;
+    if (m->dtype == LANA_DEVICE_F64) {
+        static_cast<double*>(m->data)[at] = v;
+    } else {
+        static_cast<float*>(m->data)[at] = static_cast<float>(v);
+    }
+}
+
+/// Zero when the call may run; counts calls after shutdown.
+int refuse() {
+    if (control.live == 0) {
+        ++control.dead_calls;
+        return 1;
+    }
+    return control.fail_ops;
+}
+
+int query(void*, lana_device_info* out) {
+    if (control.fail_query != 0) {
+        return 1;
+    }
+    std::memset(out, 0, sizeof(*out));
+    std::strcpy(out->name, "lana mock device");
+    std::strcpy(out->platform, "mock");
+    // Fast enough that every size past the policy floors is worth sending.
+    out->gflops_f32 = 1e9;
+    out->gflops_f64 = 1e9;
+    out->link_gbps = 1e9;
+    out->memory_bytes = std::uint64_t(16) << 30;
+    return 0;
+}
+
+int gemm(void*, double alpha, const lana_device_matrix* a, const lana_device_matrix* b, double beta,
+         const lana_device_matrix* c) {
+    ++control.gemm_calls;
+    if (const int r = refuse()) {
+        return r;
+    }
+    for (std::int64_t j = 0; j < c->cols; ++j) {
+        for (std::int64_t i = 0; i < c->rows; ++i) {
+            double s = 0;
+            for (std::int64_t p = 0; p < a->cols; ++p) {
+                s += load(a, i, p) * load(b, p, j);
+            }
+            store(c, i, j, alpha * s + (beta == 0 ? 0.0 : beta * load(c, i, j)));
+        }
+    }
+    return 0;
+}
+
+int getrf(void*, const lana_device_matrix* a, std::int32_t* ipiv, std::int64_t* info) {
+    ++control.getrf_calls;
+    if (const int r = refuse()) {
+        return r;
+    }
+    *info = 0;
+    const std::int64_t kmax = a->rows < a->cols ? a->rows : a->cols;
+    for (std::int64_t k = 0; k < kmax; ++k) {
+        std::int64_t p = k;
+        for (std::int64_t i = k + 1; i < a->rows; ++i) {
+            if (std::abs(load(a, i, k)) > std::abs(load(a, p, k))) {
+                p = i;
+            }
+        }
+        ipiv[k] = static_cast<std::int32_t>(p);
+        if (load(a, p, k) == 0) {
+            if (*info == 0) {
+                *info = k + 1;
+            }
+            continue;
+        }
+        for (std::int64_t j = 0; j < a->cols; ++j) {
+            const double t = load(a, k, j);
+            store(a, k, j, load(a, p, j));
+            store(a, p, j, t);
+        }
+        const double d = load(a, k, k);
+        for (std::int64_t i = k + 1; i < a->rows; ++i) {
+            store(a, i, k, load(a, i, k) / d);
+        }
+        for (std::int64_t j = k + 1; j < a->cols; ++j) {
+            for (std::int64_t i = k + 1; i < a->rows; ++i) {
+                store(a, i, j, load(a, i, j) - load(a, i, k) * load(a, k, j));
+            }
+        }
+    }
+    return 0;
+}
+
+int potrf(void*, const lana_device_matrix* a, std::int64_t* info) {
+    ++control.potrf_calls;
+    if (const int r = refuse()) {
+        return r;
+    }
+    *info = 0;
+    for (std::int64_t j = 0; j < a->rows; ++j) {
+        double d = load(a, j, j);
+        for (std::int64_t p = 0; p < j; ++p) {
+            d -= load(a, j, p) * load(a, j, p);
+        }
+        if (!(d > 0)) {
+            *info = j + 1;
+            return 0;
+        }
+        const double l = std::sqrt(d);
+        store(a, j, j, l);
+        for (std::int64_t i = j + 1; i < a->rows; ++i) {
+            double s = load(a, i, j);
+            for (std::int64_t p = 0; p < j; ++p) {
+                s -= load(a, i, p) * load(a, j, p);
+            }
+            store(a, i, j, s / l);
+        }
+    }
+    return 0;
+}
+
+/// The "device copy" of a CSR matrix.
+struct Csr {
+    std::int64_t rows;
+    std::vector<std::int64_t> row_ptr;
+    std::vector<std::int32_t> col_idx;
+    std::vector<double> values;
+    std::int32_t dtype;
+};
+
+int csr_upload(void*, const lana_device_csr* a, void** handle) {
+    ++control.uploads;
+    if (const int r = refuse()) {
+        return r;
+    }
+    auto* c = new Csr{a->rows, std::vector<std::int64_t>(a->row_ptr, a->row_ptr + a->rows + 1),
+                      std::vector<std::int32_t>(a->col_idx, a->col_idx + a->nnz),
+                      std::vector<double>(static_cast<std::size_t>(a->nnz)), a->dtype};
+    for (std::int64_t p = 0; p < a->nnz; ++p) {
+        c->values[static_cast<std::size_t>(p)] = a->dtype == LANA_DEVICE_F64 ? static_cast<const double*>(a->values)[p]
+                                                                             : static_cast<const float*>(a->values)[p];
+    }
+    *handle = c;
+    return 0;
+}
+
+void csr_release(void*, void* handle) {
+    ++control.releases;
+    delete static_cast<Csr*>(handle);
+}
+
+int spmv(void*, void* handle, double alpha, const void* x, std::int64_t incx, double beta, void* y,
+         std::int64_t incy) {
+    ++control.spmv_calls;
+    if (const int r = refuse()) {
+        return r;
+    }
+    const Csr& a = *static_cast<const Csr*>(handle);
+    const bool f64 = a.dtype == LANA_DEVICE_F64;
+    for (std::int64_t i = 0; i < a.rows; ++i) {
+        double s = 0;
+        for (std::int64_t p = a.row_ptr[static_cast<std::size_t>(i)]; p < a.row_ptr[static_cast<std::size_t>(i) + 1];
+             ++p) {
+            const std::int64_t j = a.col_idx[static_cast<std::size_t>(p)];
+            s += a.values[static_cast<std::size_t>(p)] *
+                 (f64 ? static_cast<const double*>(x)[j * incx] : static_cast<const float*>(x)[j * incx]);
+        }
+        if (f64) {
+            double& out = static_cast<double*>(y)[i * incy];
+            out = alpha * s + (beta == 0 ? 0.0 : beta * out);
+        } else {
+            float& out = static_cast<float*>(y)[i * incy];
+            out = static_cast<float>(alpha * s + (beta == 0 ? 0.0 : beta * out));
+        }
+    }
+    return 0;
+}
+
+void shutdown(void*) {
+    ++control.shutdowns;
+    control.live = 0;
+}
+
+lana_device_backend table = {LANA_DEVICE_ABI_VERSION, nullptr, query, gemm, getrf, potrf,
+                             csr_upload, csr_release, spmv, shutdown};
+
+}  // namespace
+
+lana_mock_control* lana_mock_control_block(void) { return &control; }
+
+const lana_device_backend* lana_device_backend_v1(void) {
+    if (control.no_device != 0) {
+        return nullptr;
+    }
+    table.abi_version = control.abi_version;
+    control.live = 1;
+    return &table;
+}
@@ -0,0 +1,223 @@
+// lana::dist, run under mpiexec: the block-cyclic index maps agree with
+// each other, scatter and gather round-trip, and SUMMA GEMM and the
+// distributed LU give what the serial routines give, on every grid shape
+// the process count allows. Results are gathered to rank 0, and every
+// check is agreed on by all ranks, so a failure on one does not leave the
+// others waiting in a collective.
+
+#include "check.hpp"
+
+#include "lana/dist.hpp"
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+
+#include <mpi.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::MatrixView;
+namespace dist = lana::dist;
+
+/// MPI is up for the whole run: initialized before main() runs the cases
+/// and finalized after, once every Grid is gone.
+struct Session {
+    Session() { MPI_Init(nullptr, nullptr); }
+    ~Session() { MPI_Finalize(); }
+} const session;
+
+int world_size() {
+    int size = 1;
+    MPI_Comm_size(MPI_COMM_WORLD, &size);
+    return size;
+}
+
+/// The near-square grid, and the 1 x N and N x 1 ones when they differ.
+std::vector<std::unique_ptr<dist::Grid>> every_grid() {
+    std::vector<std::unique_ptr<dist::Grid>> out;
+    const int n = world_size();
+    out.push_back(std::make_unique<dist::Grid>(MPI_COMM_WORLD));
+    if (n > 1) {
+        out.push_back(std::make_unique<dist::Grid>(MPI_COMM_WORLD, 1, n));
+        out.push_back(std::make_unique<dist::Grid>(MPI_COMM_WORLD, n, 1));
+    }
+    return out;
+}
+
+/// Every rank's flag, true only if all are.
+bool all_ranks(bool ok) {
+    int v = ok ? 1 : 0;
+    MPI_Allreduce(MPI_IN_PLACE, &v, 1, MPI_INT, MPI_MIN, MPI_COMM_WORLD);
+    return v == 1;
+}
+
+/// `a` on rank 0 (empty elsewhere).
+template <typename T>
+lana::Matrix<T> gathered(const dist::Matrix<T>& a) {
+    lana::Matrix<T> out(a.grid().rank() == 0 ? a.rows() : 0, a.grid().rank() == 0 ? a.cols() : 0);
+    dist::gather(a, 0, out.view());
+    return out;
+}
+
+LANA_TEST(dist_index_maps_agree) {
+    // numroc: 10 in blocks of 3 over 2 processes is 3 + 1 on one and 3 + 3
+    // on the other.
+    static_assert(dist::local_extent(10, 3, 0, 2) == 6 && dist::local_extent(10, 3, 1, 2) == 4);
+    static_assert(dist::local_extent(0, 4, 0, 3) == 0 && dist::local_extent(5, 8, 1, 2) == 0);
+    bool ok = true;
+    const std::vector<std::unique_ptr<dist::Grid>> grids = every_grid();
+    ok = ok && grids[0]->prows() <= grids[0]->pcols();
+    for (const auto& grid : grids) {
+        ok = ok && grid->prows() * grid->pcols() == world_size();
+        ok = ok && grid->prow() == grid->rank() / grid->pcols() && grid->pcol() == grid->rank() % grid->pcols();
+        const dist::Matrix<double> a(*grid, 53, 38, 7, 5);
+        for (index_t li = 0; li < a.local().rows(); ++li) {
+            const index_t i = a.global_row(li);
+            ok = ok && a.owner_row(i) == grid->prow() && a.local_row(i) == li;
+        }
+        for (index_t lj = 0; lj < a.local().cols(); ++lj) {
+            const index_t j = a.global_col(lj);
+            ok = ok && a.owner_col(j) == grid->pcol() && a.local_col(j) == lj;
+        }
+        // The local extents cover the matrix exactly once.
+        index_t rows = 0;
+        for (int p = 0; p < grid->prows(); ++p) {
+            rows += dist::local_extent(53, 7, p, grid->prows());
+        }
+        ok = ok && rows == 53;
+    }
+    CHECK(all_ranks(ok));
+}
+
+template <typename T>
+void scatter_gather() {
+    const lana::Matrix<T> src = lana::test::random_matrix<T>(37, 23, 1);
+    for (const auto& grid : every_grid()) {
+        const bool root = grid->rank() == 0;
+        for (const auto& [mb, nb] : {std::pair<index_t, index_t>{7, 5}, {1, 1}, {64, 64}}) {
+            dist::Matrix<T> a(*grid, 37, 23, mb, nb);
+            dist::scatter(root ? src.view() : MatrixView<const T>(), 0, a);
+            // Each local element is the global one it maps to.
+            bool ok = true;
+            for (index_t lj = 0; lj < a.local().cols(); ++lj) {
+                for (index_t li = 0; li < a.local().rows(); ++li) {
+                    ok = ok && a.local()(li, lj) == src(a.global_row(li), a.global_col(lj));
+                }
+            }
+            CHECK(all_ranks(ok));
+            const lana::Matrix<T> back = gathered(a);
+            CHECK(all_ranks(!root || lana::test::max_abs_diff<T>(back.view(), src.view()) == 0));
+        }
+        // generate() fills the same elements scatter would.
+        dist::Matrix<T> g(*grid, 37, 23, 4, 6);
+        g.generate([&](index_t i, index_t j) { return src(i, j); });
+        const lana::Matrix<T> back = gathered(g);
+        CHECK(all_ranks(!root || lana::test::max_abs_diff<T>(back.view(), src.view()) == 0));
+    }
+}
+
+LANA_TEST(dist_f32_scatter_gather) { scatter_gather<float>(); }
+LANA_TEST(dist_f64_scatter_gather) { scatter_gather<double>(); }
+
+template <typename T>
+void summa() {
+    for (const auto& grid : every_grid()) {
+        const bool root = grid->rank() == 0;
+        for (const auto& [m, n, k, nb] : {std::tuple<index_t, index_t, index_t, index_t>{130, 90, 110, 16},
+                                          {64, 64, 64, 64},
+                                          {5, 70, 3, 2},
+                                          {90, 1, 200, 32}}) {
+            const lana::Matrix<T> a0 = lana::test::random_matrix<T>(m, k, 2);
+            const lana::Matrix<T> b0 = lana::test::random_matrix<T>(k, n, 3);
+            const lana::Matrix<T> c0 = lana::test::random_matrix<T>(m, n, 4);
+            dist::Matrix<T> a(*grid, m, k, nb);
+            dist::Matrix<T> b(*grid, k, n, nb);
+            dist::Matrix<T> c(*grid, m, n, nb);
+            a.generate([&](index_t i, index_t j) { return a0(i, j); });
+            b.generate([&](index_t i, index_t j) { return b0(i, j); });
+            c.generate([&](index_t i, index_t j) { return c0(i, j); });
+            dist::gemm(T(0.5), a, b, T(-2), c);
+            const lana::Matrix<T> got = gathered(c);
+            lana::Matrix<T> ref = c0;
+            lana::test::reference_gemm<T>(0.5, a0.view(), b0.view(), -2.0, ref.view());
+            CHECK(all_ranks(!root || lana::test::max_abs_diff<T>(got.view(), ref.view()) <=
+                                         lana::test::tolerance<T>(k)));
+        }
+
+        // Blockings that do not line up are rejected on every rank alike.
+        dist::Matrix<T> a(*grid, 20, 30, 8, 6);
+        dist::Matrix<T> b(*grid, 30, 10, 8, 8);
+        dist::Matrix<T> c(*grid, 20, 10, 8, 8);
+        dist::Matrix<T> wrong(*grid, 21, 10, 8, 8);
+        CHECK_THROWS(dist::gemm(T(1), a, b, T(0), c), lana::DimensionError);
+        CHECK_THROWS(dist::gemm(T(1), b, b, T(0), wrong), lana::DimensionError);
+    }
+}
+
+LANA_TEST(dist_f32_gemm) { summa<float>(); }
+LANA_TEST(dist_f64_gemm) { summa<double>(); }
+
+template <typename T>
+void lu() {
+    for (const auto& grid : every_grid()) {
+        const bool root = grid->rank() == 0;
+        for (const auto& [m, n, nb] : {std::tuple<index_t, index_t, index_t>{150, 150, 16},
+                                       {97, 60, 8},
+                                       {40, 75, 12}}) {
+            const lana::Matrix<T> a0 = lana::test::random_matrix<T>(m, n, 5);
+            dist::Matrix<T> a(*grid, m, n, nb);
+            a.generate([&](index_t i, index_t j) { return a0(i, j); });
+            std::vector<std::int32_t> ipiv(static_cast<std::size_t>(std::min(m, n)), -1);
+            CHECK(all_ranks(dist::getrf(a, ipiv.data()) == 0));
+
+            // The same pivots as the serial LU, on every rank, and factors
+            // that agree to rounding.
+            lana::Matrix<T> serial = a0;
+            std::vector<std::int32_t> serial_ipiv(ipiv.size());
+            lana::getrf(serial.view(), serial_ipiv.data());
+            CHECK(all_ranks(ipiv == serial_ipiv));
+            const lana::Matrix<T> got = gathered(a);
+            CHECK(all_ranks(!root || lana::test::max_abs_diff<T>(got.view(), serial.view()) <=
+                                         50 * lana::test::tolerance<T>(m)));
+        }
+
+        // An exactly zero column: info names its pivot, as getrf's does.
+        lana::Matrix<T> s0 = lana::test::random_matrix<T>(48, 48, 6);
+        for (index_t i = 0; i < 48; ++i) {
+            s0(i, 5) = T(0);
+        }
+        dist::Matrix<T> s(*grid, 48, 48, 8);
+        s.generate([&](index_t i, index_t j) { return s0(i, j); });
+        std::vector<std::int32_t> ipiv(48);
+        const index_t info = dist::getrf(s, ipiv.data());
+        CHECK(all_ranks(info == lana::getrf(s0.view(), ipiv.data())) && info == 6);
+
+        dist::Matrix<T> rect(*grid, 20, 20, 4, 8);
+        CHECK_THROWS(dist::getrf(rect, ipiv.data()), lana::DimensionError);
+    }
+}
+
+LANA_TEST(dist_f32_getrf) { lu<float>(); }
+LANA_TEST(dist_f64_getrf) { lu<double>(); }
+
+LANA_TEST(dist_grid_shape_must_match) {
+    const int n = world_size();
+    CHECK_THROWS(dist::Grid(MPI_COMM_WORLD, n + 1, 1), lana::DimensionError);
+    CHECK_THROWS(dist::Grid(MPI_COMM_WORLD, 0, n), lana::DimensionError);
+    // A grid over a sub-communicator: every rank on its own.
+    const dist::Grid self(MPI_COMM_SELF);
+    CHECK(self.prows() == 1 && self.pcols() == 1 && self.rank() == 0);
+    const lana::Matrix<double> src = lana::test::random_matrix<double>(9, 4, 7);
+    dist::Matrix<double> a(self, 9, 4, 2);
+    dist::scatter(src.view(), 0, a);
+    CHECK(lana::test::max_abs_diff<double>(a.local(), src.view()) == 0);
+}
+
+}  // namespace
@@ -0,0 +1,182 @@
+// syevd and gesdd by reconstruction: A * V = V * diag(w) with V orthonormal
+// and w ascending, A = U * diag(s) * V^T with orthonormal U and V and s
+// descending, and the values-only paths agreeing with the full ones.
+
+#include "check.hpp"
+
+#include "lana/eigen.hpp"
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+
+/// Symmetric with a prescribed spectrum: Q * diag(values) * Q^T.
+Matrix<double> with_spectrum(const std::vector<double>& values, std::uint64_t seed) {
+    const index_t n = static_cast<index_t>(values.size());
+    Matrix<double> q = lana::test::random_matrix<double>(n, n, seed);
+    // Orthonormalize by modified Gram-Schmidt; the test only needs some Q.
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t k = 0; k < j; ++k) {
+            double d = 0;
+            for (index_t i = 0; i < n; ++i) {
+                d += q(i, j) * q(i, k);
+            }
+            for (index_t i = 0; i < n; ++i) {
+                q(i, j) -= d * q(i, k);
+            }
+        }
+        double norm = 0;
+        for (index_t i = 0; i < n; ++i) {
+            norm += q(i, j) * q(i, j);
+        }
+        for (index_t i = 0; i < n; ++i) {
+            q(i, j) /= std::sqrt(norm);
+        }
+    }
+    Matrix<double> qd = q;
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < n; ++i) {
+            qd(i, j) *= values[static_cast<std::size_t>(j)];
+        }
+    }
+    return lana::test::reference_product<double>(qd.view(), q.view().t());
+}
+
+template <typename T>
+Matrix<T> symmetric(index_t n, std::uint64_t seed) {
+    Matrix<T> a = lana::test::random_matrix<T>(n, n, seed);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < j; ++i) {
+            a(i, j) = a(j, i);
+        }
+    }
+    return a;
+}
+
+template <typename T>
+void check_eigen(const Matrix<T>& a) {
+    const index_t n = a.rows();
+    Matrix<T> v = a;
+    lana::Vector<T> w(n);
+    CHECK(lana::syevd(lana::EigenJob::Vectors, v.view(), w.view()) == 0);
+    for (index_t i = 1; i < n; ++i) {
+        CHECK(w[i - 1] <= w[i]);
+    }
+    const double tol = lana::test::tolerance<T>(n) * std::max(1.0, lana::test::max_abs<T>(a.view()));
+    CHECK_LE(lana::test::orthogonality_error<T>(v.view()), lana::test::tolerance<T>(n));
+    Matrix<T> av = lana::test::reference_product<T>(a.view(), v.view());
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < n; ++i) {
+            CHECK_NEAR(double(av(i, j)), double(v(i, j)) * double(w[j]), tol);
+        }
+    }
+    // Values only reads just the lower triangle: garbage above must not matter.
+    Matrix<T> lower = a;
+    for (index_t j = 1; j < n; ++j) {
+        for (index_t i = 0; i < j; ++i) {
+            lower(i, j) = T(1e3);
+        }
+    }
+    lana::Vector<T> w2(n);
+    CHECK(lana::syevd(lana::EigenJob::ValuesOnly, lower.view(), w2.view()) == 0);
+    for (index_t i = 0; i < n; ++i) {
+        CHECK_NEAR(double(w2[i]), double(w[i]), tol);
+    }
+}
+
+LANA_TEST(syevd_f64_random) {
+    for (index_t n : {1, 2, 10, 65, 200}) {
+        check_eigen<double>(symmetric<double>(n, 10 + n));
+    }
+}
+
+LANA_TEST(syevd_f32_random) {
+    for (index_t n : {3, 48, 100}) {
+        check_eigen<float>(symmetric<float>(n, 20 + n));
+    }
+}
+
+LANA_TEST(syevd_known_spectrum) {
+    // Clustered and repeated eigenvalues exercise deflation in the merges.
+    std::vector<double> values;
+    for (int i = 0; i < 90; ++i) {
+        values.push_back(i < 30 ? 1.0 : i < 60 ? 2.0 + 1e-10 * i : double(i));
+    }
+    const Matrix<double> a = with_spectrum(values, 77);
+    check_eigen<double>(a);
+    Matrix<double> v = a;
+    lana::Vector<double> w(90);
+    CHECK(lana::syevd(lana::EigenJob::Vectors, v.view(), w.view()) == 0);
+    for (index_t i = 0; i < 90; ++i) {
+        CHECK_NEAR(w[i], values[static_cast<std::size_t>(i)], 1e-9);
+    }
+    // Already diagonal.
+    Matrix<double> d(5, 5);
+    for (index_t i = 0; i < 5; ++i) {
+        d(i, i) = double(5 - i);
+    }
+    check_eigen<double>(d);
+}
+
+template <typename T>
+void check_svd(index_t m, index_t n, std::uint64_t seed) {
+    const Matrix<T> a = lana::test::random_matrix<T>(m, n, seed);
+    const index_t k = std::min(m, n);
+    lana::Vector<T> s(k);
+    Matrix<T> u(m, k), vt(k, n);
+    CHECK(lana::gesdd(a.view(), s.view(), u.view(), vt.view()) == 0);
+    for (index_t i = 0; i < k; ++i) {
+        CHECK(s[i] >= T(0));
+        if (i > 0) {
+            CHECK(s[i - 1] >= s[i]);
+        }
+    }
+    const double tol = lana::test::tolerance<T>(std::max(m, n)) * std::max(1.0, double(s[0]));
+    CHECK_LE(lana::test::orthogonality_error<T>(u.view()), lana::test::tolerance<T>(std::max(m, n)));
+    CHECK_LE(lana::test::orthogonality_error<T>(MatrixView<const T>(vt.view().t())),
+             lana::test::tolerance<T>(std::max(m, n)));
+    Matrix<T> us = u;
+    for (index_t j = 0; j < k; ++j) {
+        for (index_t i = 0; i < m; ++i) {
+            us(i, j) *= s[j];
+        }
+    }
+    const Matrix<T> back = lana::test::reference_product<T>(us.view(), vt.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(back.view(), a.view()), tol);
+    lana::Vector<T> s2(k);
+    CHECK(lana::gesdd(a.view(), s2.view(), MatrixView<T>(), MatrixView<T>()) == 0);
+    for (index_t i = 0; i < k; ++i) {
+        CHECK_NEAR(double(s2[i]), double(s[i]), tol);
+    }
+}
+
+LANA_TEST(gesdd_f64_reconstruction) {
+    check_svd<double>(50, 30, 1);
+    check_svd<double>(30, 50, 2);
+    check_svd<double>(64, 64, 3);
+    check_svd<double>(1, 5, 4);
+    check_svd<double>(6, 1, 5);
+}
+
+LANA_TEST(gesdd_f32_reconstruction) {
+    check_svd<float>(40, 25, 6);
+    check_svd<float>(25, 40, 7);
+}
+
+LANA_TEST(gesdd_rank_deficient) {
+    // Rank 2 out of 20 columns: the trailing singular values vanish.
+    const Matrix<double> x = lana::test::random_matrix<double>(40, 2, 8);
+    const Matrix<double> y = lana::test::random_matrix<double>(2, 20, 9);
+    const Matrix<double> a = lana::test::reference_product<double>(x.view(), y.view());
+    lana::Vector<double> s(20);
+    Matrix<double> u(40, 20), vt(20, 20);
+    CHECK(lana::gesdd(a.view(), s.view(), u.view(), vt.view()) == 0);
+    CHECK(s[1] > 1e-3);
+    for (index_t i = 2; i < 20; ++i) {
+        CHECK_LE(s[i], 1e-10);
+    }
+}
+
+}  // namespace
@@ -0,0 +1,153 @@
+// Elementwise expressions: linear combinations through the dispatched
+// lincomb kernel and everything else through the inlined loops, into
+// contiguous, strided and aliased destinations, against an element-by-
+// element reference.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/matrix.hpp"
+#include "lana/vector.hpp"
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::Vector;
+
+template <typename T>
+void linear_combinations() {
+    const index_t n = 1003;
+    const Vector<T> x = lana::test::random_vector<T>(n, 1);
+    const Vector<T> w = lana::test::random_vector<T>(n, 2);
+    const Vector<T> z = lana::test::random_vector<T>(n, 3);
+    const double tol = lana::test::tolerance<T>(4);
+
+    const Vector<T> y = T(2) * x + w * T(3) - z / T(4);
+    CHECK(y.size() == n);
+    for (index_t i = 0; i < n; ++i) {
+        const double ref = 2.0 * double(x[i]) + 3.0 * double(w[i]) - double(z[i]) / 4.0;
+        CHECK_NEAR(y[i], ref, tol);
+    }
+
+    // Unary minus and nested scaling fold into the coefficients.
+    const Vector<T> u = -(T(2) * (x - T(0.5) * (w + z)));
+    for (index_t i = 0; i < n; ++i) {
+        const double ref = -2.0 * (double(x[i]) - 0.5 * (double(w[i]) + double(z[i])));
+        CHECK_NEAR(u[i], ref, tol);
+    }
+
+    // Nine terms is one more than lincomb takes; the loop evaluates it.
+    const Vector<T> nine = x + w + z + x + w + z + x + w + T(2) * z;
+    for (index_t i = 0; i < n; ++i) {
+        CHECK_NEAR(nine[i], 3.0 * double(x[i]) + 3.0 * double(w[i]) + 4.0 * double(z[i]), tol);
+    }
+}
+
+LANA_TEST(expr_f32_linear_combinations) { linear_combinations<float>(); }
+LANA_TEST(expr_f64_linear_combinations) { linear_combinations<double>(); }
+
+LANA_TEST(expr_nonlinear_terms) {
+    const index_t n = 517;
+    const Vector<double> x = lana::test::random_vector<double>(n, 4);
+    Vector<double> d = lana::test::random_vector<double>(n, 5);
+    for (index_t i = 0; i < n; ++i) {
+        d[i] += d[i] < 0 ? -1.0 : 1.0;  // away from zero for the quotient
+    }
+    const Vector<double> y = lana::cwise_mul(x, d) + 2.0 * lana::cwise_div(x, d) - x;
+    for (index_t i = 0; i < n; ++i) {
+        CHECK_NEAR(y[i], x[i] * d[i] + 2.0 * (x[i] / d[i]) - x[i], 1e-15);
+    }
+
+    const Vector<int> a{1, 2, 3, 4};
+    const Vector<int> b{10, 20, 30, 40};
+    const Vector<int> c = 3 * a - b + lana::cwise_mul(a, a);
+    CHECK(c[0] == -6 && c[1] == -10 && c[2] == -12 && c[3] == -12);
+}
+
+LANA_TEST(expr_destination_may_appear_in_the_expression) {
+    Vector<double> x = lana::test::random_vector<double>(300, 6);
+    const Vector<double> y = lana::test::random_vector<double>(300, 7);
+    const Vector<double> x0 = x;
+    x = 2.0 * x + y;
+    for (index_t i = 0; i < 300; ++i) {
+        CHECK_NEAR(x[i], 2.0 * x0[i] + y[i], 1e-15);
+    }
+    x += y;
+    x -= 0.5 * y;
+    x *= 4.0;
+    for (index_t i = 0; i < 300; ++i) {
+        CHECK_NEAR(x[i], 4.0 * (2.0 * x0[i] + 1.5 * y[i]), 1e-14);
+    }
+
+    // Compound assignment through a view writes only the viewed elements.
+    Vector<double> v(10, 1.0);
+    v.view().segment(2, 5) *= 3.0;
+    CHECK(v[1] == 1 && v[2] == 3 && v[6] == 3 && v[7] == 1);
+}
+
+LANA_TEST(expr_strided_operands_and_destinations) {
+    const Matrix<double> a = lana::test::random_matrix<double>(23, 17, 8);
+    const Matrix<double> b = lana::test::random_matrix<double>(17, 23, 9);
+    const Matrix<double> c = lana::test::random_matrix<double>(40, 30, 10);
+
+    // A transposed operand and a block of a wider matrix.
+    const Matrix<double> m = a.view().t() + 2.0 * b - c.block(5, 3, 17, 23);
+    for (index_t j = 0; j < 23; ++j) {
+        for (index_t i = 0; i < 17; ++i) {
+            CHECK_NEAR(m(i, j), a(j, i) + 2.0 * b(i, j) - c(5 + i, 3 + j), 1e-15);
+        }
+    }
+
+    // A block destination leaves the rest of its matrix alone.
+    Matrix<double> dst = c;
+    dst.block(1, 2, 17, 23) = a.view().t() - b;
+    for (index_t j = 0; j < 30; ++j) {
+        for (index_t i = 0; i < 40; ++i) {
+            const bool inside = i >= 1 && i < 18 && j >= 2 && j < 25;
+            const double ref = inside ? a(j - 2, i - 1) - b(i - 1, j - 2) : c(i, j);
+            CHECK_NEAR(dst(i, j), ref, 1e-15);
+        }
+    }
+
+    // A row of a matrix is a strided vector-shaped operand.
+    Matrix<double> row_out(1, 30);
+    row_out.view() = 3.0 * c.view().row(7);
+    for (index_t j = 0; j < 30; ++j) {
+        CHECK_NEAR(row_out(0, j), 3.0 * c(7, j), 1e-15);
+    }
+}
+
+LANA_TEST(expr_assignment_resizes_owning_containers) {
+    Vector<double> x(3, 1.0);
+    const Vector<double> y = lana::test::random_vector<double>(50, 11);
+    x = 2.0 * y;
+    CHECK(x.size() == 50);
+    CHECK(x[49] == 2.0 * y[49]);
+
+    Matrix<float> m(2, 2);
+    const Matrix<float> a = lana::test::random_matrix<float>(9, 4, 12);
+    m = a - a;
+    CHECK(m.rows() == 9 && m.cols() == 4);
+    CHECK(lana::test::max_abs<float>(m.view()) == 0);
+}
+
+LANA_TEST(expr_dimension_mismatch_throws) {
+    const Vector<double> x(10);
+    const Vector<double> y(11);
+    CHECK_THROWS(x + y, lana::DimensionError);
+    CHECK_THROWS(lana::cwise_mul(x, y), lana::DimensionError);
+
+    Vector<double> out(10);
+    CHECK_THROWS(out.view().segment(0, 5).assign(2.0 * x), lana::DimensionError);
+    CHECK_THROWS(out += y, lana::DimensionError);
+
+    const Matrix<double> a(4, 5);
+    Matrix<double> b(5, 4);
+    CHECK_THROWS(b.view() = a + a, lana::DimensionError);
+    CHECK_THROWS(a + b, lana::DimensionError);
+    // A matrix expression is not a vector.
+    CHECK_THROWS(Vector<double>(a + a), lana::DimensionError);
+}
+
+}  // namespace
@@ -0,0 +1,252 @@
+// Dense factorizations by their residuals: LU and Cholesky solves against
+// the original matrix, the reconstructions P * A = L * U and A = Q * R,
+// and trsm in every side / triangle / transpose / diagonal combination.
+// Each runs with the default and a forced small block size, so both the
+// unblocked panel and the blocked update paths are covered.
+
+#include "check.hpp"
+
+#include "lana/factor.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+using lana::Op;
+
+constexpr index_t sizes[] = {1, 2, 7, 33, 64, 150};
+constexpr index_t block_sizes[] = {0, 8};
+
+/// max |A * X - B| relative to max|A| * max|X| * n.
+template <typename T>
+double residual(MatrixView<const T> a, MatrixView<const T> x, MatrixView<const T> b) {
+    Matrix<T> r(b);
+    lana::test::reference_gemm<T>(1.0, a, x, -1.0, r.view());
+    const double scale = lana::test::max_abs(a) * lana::test::max_abs(x) * double(a.cols()) + 1e-300;
+    return lana::test::max_abs<T>(r.view()) / scale;
+}
+
+template <typename T>
+Matrix<T> identity(index_t n) {
+    Matrix<T> m(n, n);
+    for (index_t i = 0; i < n; ++i) {
+        m(i, i) = T(1);
+    }
+    return m;
+}
+
+/// Restores the default block size when a case returns or fails.
+struct BlockSize {
+    explicit BlockSize(index_t nb) { lana::set_factor_block_size(nb); }
+    ~BlockSize() { lana::set_factor_block_size(0); }
+};
+
+template <typename T>
+void lu_solve() {
+    for (index_t nb : block_sizes) {
+        BlockSize scope(nb);
+        for (index_t n : sizes) {
+            const Matrix<T> a = lana::test::random_matrix<T>(n, n, 100 + n);
+            const Matrix<T> b = lana::test::random_matrix<T>(n, 3, 200 + n);
+            for (Op op : {Op::NoTrans, Op::Trans}) {
+                Matrix<T> lu = a;
+                std::vector<std::int32_t> ipiv(static_cast<std::size_t>(n));
+                CHECK(lana::getrf(lu.view(), ipiv.data()) == 0);
+                Matrix<T> x = b;
+                lana::getrs(op, lu.view(), ipiv.data(), x.view());
+                const MatrixView<const T> opa = op == Op::Trans ? a.view().t() : a.view();
+                CHECK_LE(residual<T>(opa, x.view(), b.view()), lana::test::tolerance<T>(n));
+            }
+        }
+    }
+}
+
+LANA_TEST(getrf_f32_solve) { lu_solve<float>(); }
+LANA_TEST(getrf_f64_solve) { lu_solve<double>(); }
+
+LANA_TEST(getrf_rectangular_reconstruction) {
+    for (index_t nb : block_sizes) {
+        BlockSize scope(nb);
+        for (auto [m, n] : {std::pair<index_t, index_t>{90, 40}, {40, 90}, {17, 1}, {1, 17}}) {
+            const Matrix<double> a = lana::test::random_matrix<double>(m, n, 7 * m + n);
+            Matrix<double> lu = a;
+            const index_t k = std::min(m, n);
+            std::vector<std::int32_t> ipiv(static_cast<std::size_t>(k));
+            CHECK(lana::getrf(lu.view(), ipiv.data()) == 0);
+            Matrix<double> l(m, k), u(k, n);
+            for (index_t j = 0; j < k; ++j) {
+                l(j, j) = 1;
+                for (index_t i = j + 1; i < m; ++i) {
+                    l(i, j) = lu(i, j);
+                }
+            }
+            for (index_t j = 0; j < n; ++j) {
+                for (index_t i = 0; i <= std::min(j, k - 1); ++i) {
+                    u(i, j) = lu(i, j);
+                }
+            }
+            Matrix<double> pa = a;
+            for (index_t i = 0; i < k; ++i) {
+                for (index_t j = 0; j < n; ++j) {
+                    std::swap(pa(i, j), pa(ipiv[static_cast<std::size_t>(i)], j));
+                }
+            }
+            const Matrix<double> prod = lana::test::reference_product<double>(l.view(), u.view());
+            CHECK_LE(lana::test::max_abs_diff<double>(prod.view(), pa.view()), lana::test::tolerance<double>(k));
+        }
+    }
+}
+
+LANA_TEST(getrf_reports_zero_pivot) {
+    Matrix<double> a{{1, 2, 3}, {2, 4, 6}, {1, 0, 1}};
+    std::int32_t ipiv[3];
+    CHECK(lana::getrf(a.view(), ipiv) == 3);
+}
+
+template <typename T>
+void cholesky_solve() {
+    for (index_t nb : block_sizes) {
+        BlockSize scope(nb);
+        for (index_t n : sizes) {
+            const Matrix<T> a = lana::test::random_spd<T>(n, 300 + n);
+            const Matrix<T> b = lana::test::random_matrix<T>(n, 2, 400 + n);
+            Matrix<T> l = a;
+            CHECK(lana::potrf(l.view()) == 0);
+            // The strict upper triangle is left alone.
+            for (index_t j = 1; j < n; ++j) {
+                CHECK(l(0, j) == a(0, j));
+            }
+            Matrix<T> x = b;
+            lana::potrs(l.view(), x.view());
+            CHECK_LE(residual<T>(a.view(), x.view(), b.view()), lana::test::tolerance<T>(n));
+        }
+    }
+}
+
+LANA_TEST(potrf_f32_solve) { cholesky_solve<float>(); }
+LANA_TEST(potrf_f64_solve) { cholesky_solve<double>(); }
+
+LANA_TEST(potrf_reports_indefinite_minor) {
+    Matrix<double> a{{4, 2, 0}, {2, 1, 0}, {0, 0, 1}};
+    CHECK(lana::potrf(a.view()) == 2);
+}
+
+LANA_TEST(potrf_rank_update) {
+    const index_t n = 40, k = 3;
+    const Matrix<double> a = lana::test::random_spd<double>(n, 51);
+    const Matrix<double> x = lana::test::random_matrix<double>(n, k, 52);
+    Matrix<double> updated = a;
+    lana::test::reference_gemm<double>(1.0, x.view(), x.view().t(), 1.0, updated.view());
+    Matrix<double> l = a;
+    CHECK(lana::potrf(l.view()) == 0);
+    Matrix<double> work = x;
+    CHECK(lana::potrf_update(l.view(), work.view(), lana::UpdateSign::Plus) == 0);
+    Matrix<double> expect = updated;
+    CHECK(lana::potrf(expect.view()) == 0);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j; i < n; ++i) {
+            CHECK_NEAR(l(i, j), expect(i, j), 1e-10);
+        }
+    }
+    work = x;
+    CHECK(lana::potrf_update(l.view(), work.view(), lana::UpdateSign::Minus) == 0);
+    Matrix<double> original = a;
+    CHECK(lana::potrf(original.view()) == 0);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = j; i < n; ++i) {
+            CHECK_NEAR(l(i, j), original(i, j), 1e-10);
+        }
+    }
+}
+
+template <typename T>
+void qr_reconstruction() {
+    for (index_t nb : block_sizes) {
+        BlockSize scope(nb);
+        for (auto [m, n] : {std::pair<index_t, index_t>{120, 50}, {50, 120}, {64, 64}, {9, 1}}) {
+            const Matrix<T> a = lana::test::random_matrix<T>(m, n, 11 * m + n);
+            Matrix<T> qr = a;
+            const index_t k = std::min(m, n);
+            lana::Vector<T> tau(k);
+            lana::geqrf(qr.view(), tau.view());
+            // Q = Q * I, then Q * R against A.
+            Matrix<T> q = identity<T>(m);
+            lana::ormqr(Op::NoTrans, qr.view(), tau.view(), q.view());
+            CHECK_LE(lana::test::orthogonality_error<T>(q.view()), lana::test::tolerance<T>(m));
+            Matrix<T> r(m, n);
+            for (index_t j = 0; j < n; ++j) {
+                for (index_t i = 0; i <= std::min(j, m - 1); ++i) {
+                    r(i, j) = qr(i, j);
+                }
+            }
+            const Matrix<T> prod = lana::test::reference_product<T>(q.view(), r.view());
+            CHECK_LE(lana::test::max_abs_diff<T>(prod.view(), a.view()), lana::test::tolerance<T>(m));
+            // Q^T undoes Q.
+            Matrix<T> c = lana::test::random_matrix<T>(m, 4, 5);
+            const Matrix<T> c0 = c;
+            lana::ormqr(Op::NoTrans, qr.view(), tau.view(), c.view());
+            lana::ormqr(Op::Trans, qr.view(), tau.view(), c.view());
+            CHECK_LE(lana::test::max_abs_diff<T>(c.view(), c0.view()), lana::test::tolerance<T>(m));
+        }
+    }
+}
+
+LANA_TEST(geqrf_f32_reconstruction) { qr_reconstruction<float>(); }
+LANA_TEST(geqrf_f64_reconstruction) { qr_reconstruction<double>(); }
+
+LANA_TEST(trsm_all_variants) {
+    using lana::Diag;
+    using lana::Side;
+    using lana::Uplo;
+    const index_t n = 37, rhs = 21;
+    // Well conditioned triangles: a dominant diagonal, small off-diagonals.
+    Matrix<double> a = lana::test::random_matrix<double>(n, n, 61);
+    for (index_t i = 0; i < n; ++i) {
+        a(i, i) = 4 + a(i, i);
+    }
+    for (Side side : {Side::Left, Side::Right}) {
+        for (Uplo uplo : {Uplo::Lower, Uplo::Upper}) {
+            for (Op op : {Op::NoTrans, Op::Trans}) {
+                for (Diag diag : {Diag::NonUnit, Diag::Unit}) {
+                    Matrix<double> tri(n, n);
+                    for (index_t j = 0; j < n; ++j) {
+                        for (index_t i = 0; i < n; ++i) {
+                            const bool keep = uplo == Uplo::Lower ? i > j : i < j;
+                            tri(i, j) = i == j ? (diag == Diag::Unit ? 1.0 : a(i, i)) : keep ? a(i, j) / n : 0.0;
+                        }
+                    }
+                    const index_t br = side == Side::Left ? n : rhs;
+                    const index_t bc = side == Side::Left ? rhs : n;
+                    const Matrix<double> b = lana::test::random_matrix<double>(br, bc, 62);
+                    Matrix<double> x = b;
+                    // Garbage where trsm must not look: the other triangle, and
+                    // the diagonal of a unit triangle.
+                    Matrix<double> stored = tri;
+                    for (index_t j = 0; j < n; ++j) {
+                        for (index_t i = 0; i < n; ++i) {
+                            const bool unread = i == j ? diag == Diag::Unit : (uplo == Uplo::Lower) == (i < j);
+                            if (unread) {
+                                stored(i, j) = 1e6;
+                            }
+                        }
+                    }
+                    lana::trsm(side, uplo, op, diag, 2.0, stored.view(), x.view());
+                    const MatrixView<const double> opt = op == Op::Trans ? tri.view().t() : tri.view();
+                    Matrix<double> back(br, bc);
+                    if (side == Side::Left) {
+                        lana::test::reference_gemm<double>(0.5, opt, x.view(), 0.0, back.view());
+                    } else {
+                        lana::test::reference_gemm<double>(0.5, x.view(), opt, 0.0, back.view());
+                    }
+                    CHECK_LE(lana::test::max_abs_diff<double>(back.view(), b.view()), lana::test::tolerance<double>(n));
+                }
+            }
+        }
+    }
+}
+
+}  // namespace
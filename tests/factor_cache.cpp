@@ -0,0 +1,365 @@
+// FactorCache: content keys follow the values and not the layout, lookups
+// hit and miss per key, kind and precision, entries leave least recently
+// used first under the byte budget while held factors stay usable, rank-k
+// updates move a Cholesky factor to a new key, and concurrent lookups of
+// one matrix all get a working factor.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/factor_cache.hpp"
+#include "lana/sparse.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using lana::Csr;
+using lana::FactorCache;
+using lana::FactorKey;
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+using lana::version_key;
+
+/// max |A X - B| / (max|A| max|X| n).
+template <typename T>
+double residual(MatrixView<const T> a, MatrixView<const T> x, MatrixView<const T> b) {
+    Matrix<T> r(b);
+    lana::test::reference_gemm<T>(1.0, a, x, -1.0, r.view());
+    const double scale = lana::test::max_abs(a) * lana::test::max_abs(x) * double(a.cols()) + 1e-300;
+    return lana::test::max_abs<T>(r.view()) / scale;
+}
+
+/// Solves A X = B with `f` and returns the residual.
+template <typename T, typename F>
+double solve_residual(const F& f, MatrixView<const T> a, std::uint64_t seed) {
+    const Matrix<T> b = lana::test::random_matrix<T>(a.rows(), 3, seed);
+    Matrix<T> x = b;
+    f.solve(x.view());
+    return residual<T>(a, x.view(), b.view());
+}
+
+/// Well conditioned and nonsymmetric: random plus n on the diagonal.
+template <typename T>
+Matrix<T> dominant(index_t n, std::uint64_t seed) {
+    Matrix<T> a = lana::test::random_matrix<T>(n, n, seed);
+    for (index_t i = 0; i < n; ++i) {
+        a(i, i) += T(n);
+    }
+    return a;
+}
+
+template <typename T>
+void content_keys() {
+    const Matrix<T> a = lana::test::random_matrix<T>(30, 20, 1);
+    const FactorKey k = lana::content_key(a.view());
+    CHECK(k.content && k != version_key(k.id, k.version));
+    CHECK(lana::content_key(Matrix<T>(a).view()) == k);
+
+    // The same values through a block of a larger matrix and a row-major
+    // view hash alike.
+    Matrix<T> big = lana::test::random_matrix<T>(50, 40, 2);
+    big.block(5, 7, 30, 20).assign(a.view());
+    CHECK(lana::content_key(MatrixView<const T>(big.block(5, 7, 30, 20))) == k);
+    const Matrix<T> at(a.view().t());
+    CHECK(lana::content_key(at.view().t()) == k);
+
+    // One ulp anywhere, the shape, or the precision changes the key.
+    Matrix<T> nudged = a;
+    nudged(29, 19) = std::nextafter(nudged(29, 19), T(2));
+    CHECK(lana::content_key(nudged.view()) != k);
+    nudged = a;
+    nudged(0, 0) = std::nextafter(nudged(0, 0), T(-2));
+    CHECK(lana::content_key(nudged.view()) != k);
+    const std::vector<T> buf(24, T(1));
+    CHECK(lana::content_key(MatrixView<const T>(buf.data(), 4, 6, 1, 4)) !=
+          lana::content_key(MatrixView<const T>(buf.data(), 6, 4, 1, 6)));
+    const Matrix<float> narrow = lana::test::random_matrix<float>(30, 20, 1);
+    Matrix<double> wide(30, 20);
+    for (index_t j = 0; j < 20; ++j) {
+        for (index_t i = 0; i < 30; ++i) {
+            wide(i, j) = narrow(i, j);
+        }
+    }
+    CHECK(lana::content_key(narrow.view()) != lana::content_key(wide.view()));
+
+    // CSR keys cover the pattern as well as the values.
+    const Matrix<T> d = dominant<T>(12, 3);
+    const Csr<T> s = Csr<T>::from_dense(d.view());
+    CHECK(lana::content_key(Csr<T>(s.view()).view()) == lana::content_key(s.view()));
+    Matrix<T> d2 = d;
+    d2(3, 4) = std::nextafter(d2(3, 4), T(2));
+    CHECK(lana::content_key(Csr<T>::from_dense(d2.view()).view()) != lana::content_key(s.view()));
+    // Move one entry to another column of its row, keeping the values.
+    d2 = d;
+    d2(5, 6) = T(0);
+    d2(5, 7) = T(0);
+    Matrix<T> d3 = d2;
+    d2(5, 6) = T(0.5);
+    d3(5, 7) = T(0.5);
+    const Csr<T> s2 = Csr<T>::from_dense(d2.view());
+    const Csr<T> s3 = Csr<T>::from_dense(d3.view());
+    CHECK(s2.nnz() == s3.nnz() && lana::content_key(s2.view()) != lana::content_key(s3.view()));
+}
+
+LANA_TEST(factor_cache_f32_content_keys) { content_keys<float>(); }
+LANA_TEST(factor_cache_f64_content_keys) { content_keys<double>(); }
+
+template <typename T>
+void lookups() {
+    const index_t n = 70;
+    const Matrix<T> a = dominant<T>(n, 4);
+    const Matrix<T> s = lana::test::random_spd<T>(n, 5);
+    FactorCache cache;
+
+    const auto lu = cache.lu(a.view());
+    CHECK(lu->rows() == n);
+    CHECK_LE(solve_residual<T>(*lu, a.view(), 6), lana::test::tolerance<T>(n));
+    // The cached factor solves exactly as a direct getrf / getrs does.
+    const Matrix<T> b = lana::test::random_matrix<T>(n, 4, 7);
+    Matrix<T> x = b;
+    lu->solve(x.view());
+    Matrix<T> direct = a;
+    std::vector<std::int32_t> ipiv(static_cast<std::size_t>(n));
+    CHECK(lana::getrf(direct.view(), ipiv.data()) == 0);
+    Matrix<T> y = b;
+    lana::getrs(lana::Op::NoTrans, MatrixView<const T>(direct.view()), ipiv.data(), y.view());
+    CHECK(lana::test::max_abs_diff<T>(x.view(), y.view()) == 0);
+    lana::Vector<T> v = lana::test::random_vector<T>(n, 8);
+    Matrix<T> vm(n, 1);
+    for (index_t i = 0; i < n; ++i) {
+        vm(i, 0) = v[i];
+    }
+    lu->solve(v.view());
+    lu->solve(vm.view());
+    bool same = true;
+    for (index_t i = 0; i < n; ++i) {
+        same = same && v[i] == vm(i, 0);
+    }
+    CHECK(same);
+
+    CHECK(cache.lu(a.view()) == lu && cache.lu(Matrix<T>(a).view()) == lu);
+    lana::FactorCacheStats st = cache.stats();
+    CHECK(st.misses == 1 && st.hits == 2 && st.entries == 1 && st.bytes == lu->bytes());
+
+    const auto ch = cache.cholesky(s.view());
+    CHECK_LE(solve_residual<T>(*ch, s.view(), 9), lana::test::tolerance<T>(n));
+    CHECK(cache.cholesky(s.view()) == ch);
+
+    // One key, different kinds and precisions: separate entries.
+    const FactorKey key = version_key(42, 1);
+    const Matrix<float> sf = lana::test::random_spd<float>(n, 5);
+    const Matrix<double> sd = lana::test::random_spd<double>(n, 5);
+    const auto lu_key = cache.lu(key, s.view());
+    const auto ch_key = cache.cholesky(key, s.view());
+    const auto lu_f = cache.lu(key, sf.view());
+    const auto lu_d = cache.lu(key, sd.view());
+    CHECK(static_cast<const void*>(lu_key.get()) != static_cast<const void*>(ch_key.get()));
+    CHECK(static_cast<const void*>(lu_f.get()) != static_cast<const void*>(lu_d.get()));
+    st = cache.stats();
+    CHECK(st.entries == 5 && st.misses == 5);
+    CHECK(st.bytes == lu->bytes() + ch->bytes() + lu_key->bytes() + ch_key->bytes() +
+                          (std::is_same_v<T, float> ? lu_d->bytes() : lu_f->bytes()));
+
+    // A version key is trusted: the same stamp over new values is stale.
+    CHECK(cache.lu(key, a.view()) == lu_key);
+    const auto fresh = cache.lu(version_key(42, 2), a.view());
+    CHECK(fresh != lu_key);
+    CHECK_LE(solve_residual<T>(*fresh, a.view(), 10), lana::test::tolerance<T>(n));
+
+    // erase() drops every kind under the key, and nothing else.
+    cache.erase(key);
+    st = cache.stats();
+    CHECK(st.entries == 3 && st.bytes == lu->bytes() + ch->bytes() + fresh->bytes());
+    CHECK(cache.cholesky(key, s.view()) != ch_key && cache.lu(a.view()) == lu);
+    cache.clear();
+    st = cache.stats();
+    CHECK(st.entries == 0 && st.bytes == 0 && st.evictions == 0);
+    CHECK_LE(solve_residual<T>(*lu, a.view(), 11), lana::test::tolerance<T>(n));
+}
+
+LANA_TEST(factor_cache_f32_lookups) { lookups<float>(); }
+LANA_TEST(factor_cache_f64_lookups) { lookups<double>(); }
+
+template <typename T>
+void sparse_lookups() {
+    const index_t n = 40;
+    const Matrix<T> a = dominant<T>(n, 12);
+    const Matrix<T> s = lana::test::random_spd<T>(n, 13);
+    const Csr<T> as = Csr<T>::from_dense(a.view());
+    const Csr<T> ss = Csr<T>::from_dense(s.view());
+    FactorCache cache;
+    const auto lu = cache.sparse_lu(as.view());
+    CHECK_LE(solve_residual<T>(*lu, a.view(), 14), 10 * lana::test::tolerance<T>(n));
+    CHECK(cache.sparse_lu(as.view()) == lu);
+    const auto ch = cache.sparse_cholesky(ss.view(), lana::Ordering::Natural);
+    CHECK_LE(solve_residual<T>(*ch, s.view(), 15), 10 * lana::test::tolerance<T>(n));
+    CHECK(cache.sparse_cholesky(ss.view()) == ch);
+    const lana::FactorCacheStats st = cache.stats();
+    CHECK(st.entries == 2 && st.hits == 2 && st.bytes == lu->bytes() + ch->bytes());
+}
+
+LANA_TEST(factor_cache_f32_sparse) { sparse_lookups<float>(); }
+LANA_TEST(factor_cache_f64_sparse) { sparse_lookups<double>(); }
+
+LANA_TEST(factor_cache_failures_are_not_cached) {
+    FactorCache cache;
+    Matrix<double> singular = dominant<double>(20, 16);
+    for (index_t i = 0; i < 20; ++i) {
+        singular(i, 7) = 0;
+    }
+    CHECK_THROWS(cache.lu(singular.view()), lana::Error);
+    Matrix<double> indefinite = lana::test::random_spd<double>(20, 17);
+    indefinite(11, 11) = -1;
+    CHECK_THROWS(cache.cholesky(indefinite.view()), lana::Error);
+    const Matrix<double> rect(20, 19);
+    CHECK_THROWS(cache.lu(rect.view()), lana::DimensionError);
+    CHECK_THROWS(cache.cholesky(version_key(1, 1), rect.view()), lana::DimensionError);
+    const lana::FactorCacheStats st = cache.stats();
+    CHECK(st.entries == 0 && st.bytes == 0 && st.misses == 4);
+}
+
+LANA_TEST(factor_cache_evicts_least_recently_used) {
+    const index_t n = 64;
+    const Matrix<double> a = dominant<double>(n, 18);
+    const std::size_t one = lana::LuFactor<double>(a.view()).bytes();
+    CHECK(one == std::size_t(n * n) * sizeof(double) + std::size_t(n) * sizeof(std::int32_t));
+
+    FactorCache cache(2 * one + one / 2);
+    CHECK(cache.budget() == 2 * one + one / 2);
+    const auto f1 = cache.lu(version_key(1, 0), a.view());
+    std::shared_ptr<const lana::LuFactor<double>> f2 = cache.lu(version_key(2, 0), a.view());
+    CHECK(cache.lu(version_key(1, 0), a.view()) == f1);  // 1 is now the most recent
+    cache.lu(version_key(3, 0), a.view());
+    lana::FactorCacheStats st = cache.stats();
+    CHECK(st.entries == 2 && st.evictions == 1 && st.bytes == 2 * one);
+    const std::uint64_t hits = st.hits;
+    CHECK(cache.lu(version_key(1, 0), a.view()) == f1 && cache.stats().hits == hits + 1);
+
+    // 2 was evicted while held: a new lookup refactors, and the held one
+    // still solves.
+    const auto f2_again = cache.lu(version_key(2, 0), a.view());
+    CHECK(f2_again != f2);
+    CHECK_LE(solve_residual<double>(*f2, a.view(), 19), lana::test::tolerance<double>(n));
+    f2.reset();
+    st = cache.stats();
+    CHECK(st.entries == 2 && st.evictions == 2);
+
+    // A factor over the budget is returned but not kept.
+    FactorCache tiny(one - 1);
+    const auto big = tiny.lu(a.view());
+    CHECK_LE(solve_residual<double>(*big, a.view(), 20), lana::test::tolerance<double>(n));
+    CHECK(tiny.stats().entries == 0 && tiny.lu(a.view()) != big && tiny.stats().misses == 2);
+
+    // Shrinking the budget evicts at once, oldest first.
+    cache.set_budget(one);
+    st = cache.stats();
+    CHECK(st.entries == 1 && st.evictions == 3 && cache.budget() == one);
+    CHECK(cache.lu(version_key(2, 0), a.view()) == f2_again);
+    cache.set_budget(0);
+    CHECK(cache.stats().entries == 0 && cache.stats().bytes == 0);
+}
+
+template <typename T>
+void cholesky_updates() {
+    const index_t n = 60, k = 3;
+    const Matrix<T> a = lana::test::random_spd<T>(n, 21);
+    const Matrix<T> x = lana::test::random_matrix<T>(n, k, 22);
+    Matrix<T> updated = a;
+    lana::test::reference_gemm<T>(1.0, x.view(), x.view().t(), 1.0, updated.view());
+    Matrix<T> expect = updated;
+    CHECK(lana::potrf(expect.view()) == 0);
+    const double bound = 100 * lana::test::tolerance<T>(n) * lana::test::max_abs<T>(expect.view());
+
+    const auto lower_diff = [&](MatrixView<const T> l, MatrixView<const T> e) {
+        double d = 0;
+        for (index_t j = 0; j < n; ++j) {
+            for (index_t i = j; i < n; ++i) {
+                d = std::max(d, std::abs(double(l(i, j)) - double(e(i, j))));
+            }
+        }
+        return d;
+    };
+
+    // Nobody else holds the factor: updated in place and moved.
+    FactorCache cache;
+    const FactorKey v1 = version_key(7, 1), v2 = version_key(7, 2);
+    const T* storage = cache.cholesky(v1, a.view())->factor().data();
+    const auto up = cache.cholesky_update(v1, v2, x.view(), lana::UpdateSign::Plus);
+    CHECK(up != nullptr && up->factor().data() == storage);
+    CHECK_LE(lower_diff(up->factor(), expect.view()), bound);
+    CHECK_LE(solve_residual<T>(*up, updated.view(), 23), 10 * lana::test::tolerance<T>(n));
+    lana::FactorCacheStats st = cache.stats();
+    CHECK(st.updates == 1 && st.entries == 1 && cache.cholesky(v2, updated.view()) == up);
+    CHECK(cache.cholesky_update(v1, v2, x.view(), lana::UpdateSign::Plus) == nullptr);
+
+    // And back down, while the caller still holds the updated factor: that
+    // one is copied and left as it was.
+    const Matrix<T> held(up->factor());
+    const auto down = cache.cholesky_update(v2, v1, x.view(), lana::UpdateSign::Minus);
+    CHECK(down != nullptr && down != up && down->factor().data() != up->factor().data());
+    CHECK(lana::test::max_abs_diff<T>(up->factor(), held.view()) == 0);
+    Matrix<T> original = a;
+    CHECK(lana::potrf(original.view()) == 0);
+    CHECK_LE(lower_diff(down->factor(), original.view()), 10 * bound);
+    st = cache.stats();
+    CHECK(st.updates == 2 && st.entries == 1 && st.bytes == down->bytes());
+
+    // A downdate that loses definiteness returns null and drops the entry.
+    Matrix<T> spike(n, 1);
+    spike(0, 0) = T(100);
+    CHECK(cache.cholesky_update(v1, v2, spike.view(), lana::UpdateSign::Minus) == nullptr);
+    st = cache.stats();
+    CHECK(st.updates == 2 && st.entries == 0 && st.bytes == 0);
+
+    // Only dense Cholesky entries of the same precision are updated.
+    cache.lu(v1, a.view());
+    CHECK(cache.cholesky_update(v1, v2, x.view(), lana::UpdateSign::Plus) == nullptr);
+    CHECK(cache.stats().entries == 1);
+}
+
+LANA_TEST(factor_cache_f32_cholesky_update) { cholesky_updates<float>(); }
+LANA_TEST(factor_cache_f64_cholesky_update) { cholesky_updates<double>(); }
+
+LANA_TEST(factor_cache_concurrent_lookups) {
+    const index_t n = 80;
+    const Matrix<double> a = dominant<double>(n, 24);
+    // Room for two: the threads also churn through keys of their own.
+    FactorCache cache(2 * lana::LuFactor<double>(a.view()).bytes());
+    constexpr int threads = 6, rounds = 15;
+    std::vector<int> bad(threads, 0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (int r = 0; r < rounds; ++r) {
+                const auto shared = cache.lu(a.view());
+                const auto own = cache.lu(version_key(std::uint64_t(t), std::uint64_t(r)), a.view());
+                bad[static_cast<std::size_t>(t)] +=
+                    solve_residual<double>(*shared, a.view(), std::uint64_t(r)) > lana::test::tolerance<double>(n);
+                bad[static_cast<std::size_t>(t)] +=
+                    solve_residual<double>(*own, a.view(), std::uint64_t(r)) > lana::test::tolerance<double>(n);
+            }
+        });
+    }
+    for (std::thread& th : pool) {
+        th.join();
+    }
+    int failures = 0;
+    for (int b : bad) {
+        failures += b;
+    }
+    CHECK(failures == 0);
+    const lana::FactorCacheStats st = cache.stats();
+    CHECK(st.hits + st.misses == std::uint64_t(2 * threads * rounds));
+    CHECK(st.entries <= 2 && st.bytes <= cache.budget());
+}
+
+}  // namespace
@@ -0,0 +1,202 @@
+// Fixed-size matrices: the unrolled product, determinant, solve and inverse
+// against the dynamic references, elementwise expressions into inline
+// storage, and the round trip through MatrixView into the dynamic API.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/gemm.hpp"
+#include "lana/matrix.hpp"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+
+template <typename T, index_t R, index_t C>
+Matrix<T, R, C> random_fixed(std::uint64_t seed) {
+    return Matrix<T, R, C>(lana::test::random_matrix<T>(R, C, seed).view());
+}
+
+/// Diagonally dominant, so the solves below are well conditioned.
+template <typename T, index_t N>
+Matrix<T, N, N> random_dominant(std::uint64_t seed) {
+    Matrix<T, N, N> a = random_fixed<T, N, N>(seed);
+    for (index_t i = 0; i < N; ++i) {
+        a(i, i) += a(i, i) < T(0) ? T(-N) : T(N);
+    }
+    return a;
+}
+
+static_assert(std::is_trivially_copyable_v<Matrix<double, 4, 4>>);
+static_assert(sizeof(Matrix<float, 3, 3>) == 9 * sizeof(float));
+static_assert(Matrix<double, 6, 2>::rows() == 6 && Matrix<double, 6, 2>::cols() == 2);
+
+// The kernels run in constant expressions.
+constexpr Matrix<double, 2, 2> m22{{1, 2}, {3, 4}};
+static_assert(lana::det(m22) == -2);
+static_assert((m22 * m22)(1, 0) == 15);
+static_assert(m22.transpose()(0, 1) == 3);
+// Every step of this inverse is exact in binary: pivot 4, multiplier 0.5.
+constexpr Matrix<double, 2, 2> inv22 = lana::inverse(Matrix<double, 2, 2>{{4, 2}, {2, 2}});
+static_assert(inv22(0, 0) == 0.5 && inv22(0, 1) == -0.5 && inv22(1, 0) == -0.5 && inv22(1, 1) == 1);
+
+LANA_TEST(fixed_construction_and_layout) {
+    const Matrix<double, 2, 3> z;
+    CHECK(lana::test::max_abs<double>(z.view()) == 0);
+
+    // The initializer is row by row; storage is column-major.
+    const Matrix<double, 2, 3> m{{1, 2, 3}, {4, 5, 6}};
+    CHECK(m(0, 2) == 3 && m(1, 0) == 4);
+    CHECK(m[0] == 1 && m[1] == 4 && m[2] == 2 && m[5] == 6);
+    CHECK(m.view().col_stride() == 2 && m.view().data() == m.data());
+    CHECK_THROWS((Matrix<double, 2, 3>{{1, 2, 3}}), lana::DimensionError);
+    CHECK_THROWS((Matrix<double, 2, 3>{{1, 2}, {3, 4}}), lana::DimensionError);
+
+    Matrix<float, 3, 3> f = Matrix<float, 3, 3>::identity();
+    CHECK(f(0, 0) == 1 && f(1, 1) == 1 && f(2, 2) == 1 && f(0, 1) == 0);
+    f.fill(2.5f);
+    f *= 2.0f;
+    CHECK(f(2, 1) == 5.0f);
+
+    const Matrix<double, 3, 2> t = m.transpose();
+    for (index_t i = 0; i < 2; ++i) {
+        for (index_t j = 0; j < 3; ++j) {
+            CHECK(t(j, i) == m(i, j) && m.t()(j, i) == m(i, j));
+        }
+    }
+    CHECK(m.block(1, 1, 1, 2)(0, 1) == 6);
+}
+
+template <typename T, index_t R, index_t K, index_t C>
+void product_matches_reference() {
+    const Matrix<T, R, K> a = random_fixed<T, R, K>(1);
+    const Matrix<T, K, C> b = random_fixed<T, K, C>(2);
+    const Matrix<T, R, C> c = a * b;
+    const Matrix<T> ref = lana::test::reference_product<T>(a.view(), b.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(K));
+}
+
+template <typename T>
+void products() {
+    product_matches_reference<T, 3, 3, 3>();
+    product_matches_reference<T, 4, 4, 4>();
+    product_matches_reference<T, 6, 6, 6>();
+    product_matches_reference<T, 2, 5, 3>();
+    product_matches_reference<T, 4, 1, 7>();
+    product_matches_reference<T, 1, 6, 1>();
+}
+
+LANA_TEST(fixed_f32_products) { products<float>(); }
+LANA_TEST(fixed_f64_products) { products<double>(); }
+
+template <typename T, index_t N>
+void solve_and_inverse() {
+    const Matrix<T, N, N> a = random_dominant<T, N>(3);
+    const Matrix<T, N, 2> b = random_fixed<T, N, 2>(4);
+    const double tol = 4 * lana::test::tolerance<T>(N);
+
+    const Matrix<T, N, 2> x = lana::solve(a, b);
+    const Matrix<T, N, 2> r = a * x - b;
+    CHECK_LE(lana::test::max_abs<T>(r.view()), tol);
+
+    const Matrix<T, N, N> inv = lana::inverse(a);
+    const Matrix<T, N, N> e = a * inv - Matrix<T, N, N>::identity();
+    CHECK_LE(lana::test::max_abs<T>(e.view()), tol);
+
+    // det is the product of the eigenvalues: det(A * A) = det(A)^2, and a
+    // row swap flips the sign.
+    const T d = lana::det(a);
+    CHECK(d != T(0));
+    CHECK_NEAR(lana::det(Matrix<T, N, N>(a * a)) / (d * d), 1.0, tol * N);
+    Matrix<T, N, N> swapped = a;
+    for (index_t j = 0; j < N; ++j) {
+        std::swap(swapped(0, j), swapped(N - 1, j));
+    }
+    CHECK_NEAR(lana::det(swapped) / d, -1.0, tol * N);
+
+    // A zero column stays exactly zero through elimination.
+    Matrix<T, N, N> s = a;
+    for (index_t i = 0; i < N; ++i) {
+        s(i, N - 1) = T(0);
+    }
+    CHECK(lana::det(s) == T(0));
+    CHECK_THROWS(lana::solve(s, b), lana::Error);
+    CHECK_THROWS(lana::inverse(s), lana::Error);
+}
+
+template <typename T>
+void solves() {
+    solve_and_inverse<T, 2>();
+    solve_and_inverse<T, 3>();
+    solve_and_inverse<T, 4>();
+    solve_and_inverse<T, 6>();
+}
+
+LANA_TEST(fixed_f32_solve_and_inverse) { solves<float>(); }
+LANA_TEST(fixed_f64_solve_and_inverse) { solves<double>(); }
+
+LANA_TEST(fixed_elementwise_expressions) {
+    const Matrix<double, 4, 4> a = random_fixed<double, 4, 4>(5);
+    const Matrix<double, 4, 4> b = random_fixed<double, 4, 4>(6);
+    Matrix<double, 4, 4> c = 2.0 * a - b / 4.0;
+    for (index_t j = 0; j < 4; ++j) {
+        for (index_t i = 0; i < 4; ++i) {
+            CHECK_NEAR(c(i, j), 2.0 * a(i, j) - b(i, j) / 4.0, 1e-15);
+        }
+    }
+    c += a;
+    c -= 2.0 * b;
+    for (index_t j = 0; j < 4; ++j) {
+        for (index_t i = 0; i < 4; ++i) {
+            CHECK_NEAR(c(i, j), 3.0 * a(i, j) - 2.25 * b(i, j), 1e-15);
+        }
+    }
+
+    // A strided operand: the transpose of a dynamic matrix's block.
+    const Matrix<double> d = lana::test::random_matrix<double>(6, 7, 7);
+    const Matrix<double, 4, 4> m = a + d.block(1, 2, 4, 4).t();
+    for (index_t j = 0; j < 4; ++j) {
+        for (index_t i = 0; i < 4; ++i) {
+            CHECK_NEAR(m(i, j), a(i, j) + d(1 + j, 2 + i), 1e-15);
+        }
+    }
+
+    const Matrix<double> wrong(4, 3);
+    CHECK_THROWS((Matrix<double, 4, 4>(wrong + wrong)), lana::DimensionError);
+    Matrix<double, 4, 4> out;
+    CHECK_THROWS(out = d + d, lana::DimensionError);
+}
+
+LANA_TEST(fixed_matrices_work_with_the_dynamic_api) {
+    const Matrix<double, 6, 6> a = random_fixed<double, 6, 6>(8);
+    const Matrix<double, 6, 6> b = random_fixed<double, 6, 6>(9);
+    Matrix<double, 6, 6> c = random_fixed<double, 6, 6>(10);
+    const Matrix<double, 6, 6> c0 = c;
+    // Straight into gemm through the implicit view conversions.
+    lana::gemm(2.0, a, b, -1.0, c);
+    const Matrix<double, 6, 6> ref = 2.0 * Matrix<double, 6, 6>(a * b) - c0;
+    CHECK_LE(lana::test::max_abs_diff<double>(c.view(), ref.view()), lana::test::tolerance<double>(6));
+
+    // Into a dynamic matrix and back.
+    const Matrix<double> dyn(a.view());
+    CHECK(dyn.rows() == 6 && dyn.cols() == 6);
+    const Matrix<double, 6, 6> back(dyn.view());
+    CHECK(lana::test::max_abs_diff<double>(back.view(), a.view()) == 0);
+    const Matrix<double> bigger = lana::test::random_matrix<double>(8, 9, 11);
+    const Matrix<double, 3, 2> part(bigger.block(2, 4, 3, 2));
+    CHECK(part(2, 1) == bigger(4, 5));
+    CHECK_THROWS((Matrix<double, 6, 6>(bigger.view())), lana::DimensionError);
+
+    // Writes through a view land in the inline storage.
+    Matrix<double, 3, 3> w;
+    w.view()(2, 1) = 7;
+    w.block(0, 0, 2, 2).assign(2.0 * part.block(0, 0, 2, 2));
+    CHECK(w(2, 1) == 7 && w(1, 1) == 2 * part(1, 1));
+}
+
+}  // namespace
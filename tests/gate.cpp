@@ -0,0 +1,218 @@
+// The regression gate's decisions: its settings from baseline metadata,
+// the per-case and per-kernel verdicts against tolerance plus noise, the
+// merge of re-measurements and the failure count it exits with.
+
+#include "check.hpp"
+
+#include "compare.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+using lana::bench::Comparison;
+using lana::bench::GateOptions;
+using lana::bench::Result;
+using lana::bench::Verdict;
+
+/// A case with the given p50, p99 twice that, and `spread` as its samples'
+/// MAD relative to p50.
+Result timing(const char* kernel, lana::index_t n, double p50_us, double spread = 0, int samples = 40) {
+    Result r;
+    r.kernel = kernel;
+    r.dtype = "f64";
+    r.n = n;
+    r.samples = samples;
+    r.p50_s = p50_us * 1e-6;
+    r.p99_s = 2 * p50_us * 1e-6;
+    r.mad_s = spread * r.p50_s;
+    return r;
+}
+
+Verdict verdict(const Result& base, const Result& cur, const GateOptions& opt = {}) {
+    const std::vector<Comparison> cases = lana::bench::compare({base}, {cur}, opt);
+    CHECK(cases.size() == 1);
+    return cases[0].verdict;
+}
+
+LANA_TEST(gate_options_come_from_baseline_metadata) {
+    const GateOptions opt = lana::bench::gate_options({{"isa", "avx2"},
+                                                       {"gate.tolerance", "0.2"},
+                                                       {"gate.tolerance.spmv_csr", "0.35"},
+                                                       {"gate.tail_tolerance", "1"},
+                                                       {"gate.z", "2.5"},
+                                                       {"gate.tail_min_samples", "50"}});
+    CHECK(opt.tolerance == 0.2);
+    CHECK(opt.tolerance_for("gemm") == 0.2);
+    CHECK(opt.tolerance_for("spmv_csr") == 0.35);
+    CHECK(opt.tail_tolerance == 1);
+    CHECK(opt.z == 2.5);
+    CHECK(opt.tail_min_samples == 50);
+
+    const GateOptions defaults = lana::bench::gate_options({});
+    CHECK(defaults.tolerance == 0.10 && defaults.z == 3 && defaults.fail_missing);
+
+    using Metadata = lana::bench::Metadata;
+    CHECK_THROWS(lana::bench::gate_options(Metadata{{"gate.z", "three"}}), std::runtime_error);
+    CHECK_THROWS(lana::bench::gate_options(Metadata{{"gate.tolerance", "0.1x"}}), std::runtime_error);
+    CHECK_THROWS(lana::bench::gate_options(Metadata{{"gate.tolerance", "-0.1"}}), std::runtime_error);
+    CHECK_THROWS(lana::bench::gate_options(Metadata{{"gate.tolerence", "0.1"}}), std::runtime_error);
+}
+
+LANA_TEST(gate_verdicts_without_noise_follow_the_tolerance) {
+    const Result base = timing("gemm", 64, 100);
+    CHECK(verdict(base, timing("gemm", 64, 100)) == Verdict::Same);
+    CHECK(verdict(base, timing("gemm", 64, 109)) == Verdict::Same);
+    CHECK(verdict(base, timing("gemm", 64, 111)) == Verdict::Slower);
+    CHECK(verdict(base, timing("gemm", 64, 92)) == Verdict::Same);
+    CHECK(verdict(base, timing("gemm", 64, 90)) == Verdict::Faster);
+
+    GateOptions loose;
+    loose.kernel_tolerance["gemm"] = 0.25;
+    CHECK(verdict(base, timing("gemm", 64, 120), loose) == Verdict::Same);
+    CHECK(verdict(base, timing("gemm", 64, 130), loose) == Verdict::Slower);
+
+    const Comparison c = lana::bench::compare({base}, {timing("gemm", 64, 150)}, {})[0];
+    CHECK_NEAR(c.change, 0.5, 1e-12);
+    CHECK_NEAR(c.threshold, 0.10, 1e-12);
+    CHECK(c.se == 0);
+    CHECK(c.fails({}));
+}
+
+LANA_TEST(gate_noise_widens_the_threshold) {
+    // 30% slower is beyond the tolerance, but not beyond three standard
+    // errors of samples this spread out.
+    const Result base = timing("spmv_csr", 1000, 100, 0.3, 9);
+    const Result slower = timing("spmv_csr", 1000, 130, 0.3, 9);
+    const Comparison c = lana::bench::compare({base}, {slower}, {})[0];
+    CHECK(c.se > 0);
+    CHECK_NEAR(c.threshold, 0.10 + 3 * c.se, 1e-12);
+    CHECK(c.verdict == Verdict::Same);
+
+    // More samples shrink the standard error until the loss shows.
+    CHECK(verdict(timing("spmv_csr", 1000, 100, 0.3, 2000), timing("spmv_csr", 1000, 130, 0.3, 2000)) ==
+          Verdict::Slower);
+
+    // With several rounds the spread between rounds counts, not the
+    // spread of the samples within one.
+    Result base_rounds = base;
+    Result slower_rounds = slower;
+    base_rounds.rounds = slower_rounds.rounds = 5;
+    CHECK(verdict(base_rounds, slower_rounds) == Verdict::Slower);
+    base_rounds.round_mad_s = 0.3 * base_rounds.p50_s;
+    slower_rounds.round_mad_s = 0.3 * slower_rounds.p50_s;
+    CHECK(verdict(base_rounds, slower_rounds) == Verdict::Same);
+}
+
+LANA_TEST(gate_checks_p99_only_with_enough_samples) {
+    Result base = timing("dot", 4096, 100, 0, 200);
+    Result cur = timing("dot", 4096, 100, 0, 200);
+    cur.p99_s = 2 * base.p99_s;
+    CHECK(verdict(base, cur) == Verdict::SlowerTail);
+    cur.p99_s = 1.4 * base.p99_s;
+    CHECK(verdict(base, cur) == Verdict::Same);
+
+    cur.p99_s = 2 * base.p99_s;
+    base.samples = 50;
+    CHECK(verdict(base, cur) == Verdict::Same);
+    GateOptions opt;
+    opt.tail_min_samples = 50;
+    CHECK(verdict(base, cur, opt) == Verdict::SlowerTail);
+}
+
+LANA_TEST(gate_matches_cases_by_key) {
+    const std::vector<Result> base = {timing("gemm", 128, 100), timing("dot", 1000, 5), timing("gemm", 64, 10)};
+    std::vector<Result> cur = {timing("gemm", 64, 10), timing("axpy", 1000, 3), timing("gemm", 128, 100)};
+    cur[0].threads = 4;  // a different case from the baseline's gemm 64
+    const std::vector<Comparison> cases = lana::bench::compare(base, cur, {});
+    CHECK(cases.size() == 5);
+    CHECK(cases[0].kernel == "axpy" && cases[0].verdict == Verdict::Added);
+    CHECK(cases[1].kernel == "dot" && cases[1].verdict == Verdict::Missing);
+    CHECK(cases[2].n == 64 && cases[2].threads == 1 && cases[2].verdict == Verdict::Missing);
+    CHECK(cases[3].n == 64 && cases[3].threads == 4 && cases[3].verdict == Verdict::Added);
+    CHECK(cases[4].n == 128 && cases[4].verdict == Verdict::Same);
+
+    GateOptions opt;
+    CHECK(cases[1].fails(opt) && !cases[0].fails(opt) && !cases[4].fails(opt));
+    opt.fail_missing = false;
+    CHECK(!cases[1].fails(opt));
+}
+
+LANA_TEST(gate_summary_catches_a_loss_spread_over_every_case) {
+    // Sixteen gemm cases 15% slower, each noisy enough to pass on its own;
+    // their geometric mean has a quarter of one case's standard error.
+    std::vector<Result> base;
+    std::vector<Result> cur;
+    for (int i = 0; i < 16; ++i) {
+        base.push_back(timing("gemm", 32 * (i + 1), 100, 0.05, 4));
+        cur.push_back(timing("gemm", 32 * (i + 1), 115, 0.05, 4));
+        base.push_back(timing("dot", 1000 * (i + 1), 100));
+        cur.push_back(timing("dot", 1000 * (i + 1), i % 2 == 0 ? 104 : 97));
+        base.push_back(timing("axpy", 1000 * (i + 1), 100));
+        cur.push_back(timing("axpy", 1000 * (i + 1), 80));
+    }
+    GateOptions opt;
+    opt.tolerance = 0.05;
+    const std::vector<Comparison> cases = lana::bench::compare(base, cur, opt);
+    for (const Comparison& c : cases) {
+        if (c.kernel == "gemm") {
+            CHECK(c.verdict == Verdict::Same);
+        }
+    }
+    const auto kernels = lana::bench::summarize(cases, opt);
+    CHECK(kernels.size() == 3);
+    CHECK(kernels[0].kernel == "axpy" && kernels[0].cases == 16 && kernels[0].verdict == Verdict::Faster);
+    CHECK(kernels[1].kernel == "dot" && kernels[1].verdict == Verdict::Same);
+    CHECK(kernels[2].kernel == "gemm" && kernels[2].verdict == Verdict::Slower);
+    CHECK_NEAR(kernels[2].change, 0.15, 1e-9);
+    CHECK_LE(kernels[2].threshold, 0.15);
+    CHECK_NEAR(kernels[0].change, -0.20, 1e-9);
+}
+
+LANA_TEST(gate_merge_fastest_keeps_the_best_of_each_case) {
+    std::vector<Result> into = {timing("gemm", 64, 10), timing("dot", 1000, 5)};
+    into[0].p99_s = 30e-6;
+    Result again = timing("gemm", 64, 8);
+    again.p99_s = 40e-6;
+    Result slower = timing("dot", 1000, 6);
+    slower.p99_s = 1e-6;
+    lana::bench::merge_fastest(into, {again, slower, timing("axpy", 1000, 3)});
+    CHECK(into.size() == 3);
+    CHECK_NEAR(into[0].p50_s, 8e-6, 1e-15);
+    CHECK_NEAR(into[0].p99_s, 30e-6, 1e-15);
+    CHECK_NEAR(into[1].p50_s, 5e-6, 1e-15);
+    CHECK_NEAR(into[1].p99_s, 1e-6, 1e-15);
+    CHECK(into[2].kernel == "axpy");
+}
+
+LANA_TEST(gate_report_counts_failing_cases_and_kernels) {
+    const std::vector<Result> base = {timing("gemm", 64, 100), timing("gemm", 128, 100), timing("dot", 1000, 100)};
+    const std::vector<Result> cur = {timing("gemm", 64, 150), timing("gemm", 128, 100), timing("spmv_csr", 1000, 9)};
+    const GateOptions opt;
+    const auto cases = lana::bench::compare(base, cur, opt);
+    const auto kernels = lana::bench::summarize(cases, opt);
+
+    // gemm 64 slower, dot missing, and gemm as a whole slower.
+    std::ostringstream os;
+    CHECK(lana::bench::write_gate(os, cases, kernels, opt, false) == 3);
+    const std::string report = os.str();
+    CHECK(report.find("gate: 4 cases, 1 slower, 0 slower p99, 1 missing, 0 faster, 1 new; 1 of 1 kernels slower: "
+                      "FAIL\n") != std::string::npos);
+    CHECK(report.find("SLOWER") != std::string::npos && report.find("MISSING") != std::string::npos);
+    // Only rows that are not Same are listed without `all`.
+    CHECK(report.find("    128 ") == std::string::npos);
+    std::ostringstream all;
+    lana::bench::write_gate(all, cases, kernels, opt, true);
+    CHECK(all.str().find("    128 ") != std::string::npos);
+
+    std::ostringstream same;
+    const auto unchanged = lana::bench::compare(base, base, opt);
+    CHECK(lana::bench::write_gate(same, unchanged, lana::bench::summarize(unchanged, opt), opt, false) == 0);
+    CHECK(same.str().find(": PASS\n") != std::string::npos);
+}
+
+}  // namespace
@@ -0,0 +1,166 @@
+// GEMM against the textbook triple loop: every transpose combination,
+// strided and sub-block operands, edge sizes around the micro-kernel
+// tiles, every tile the active ISA offers, and forced small blocking so
+// that the packed loops wrap several times.
+
+#include "check.hpp"
+
+#include "lana/gemm.hpp"
+
+#include <limits>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+
+struct Shape {
+    index_t m, n, k;
+};
+
+constexpr Shape shapes[] = {{1, 1, 1},     {3, 5, 7},      {17, 13, 9},    {8, 24, 1},
+                            {64, 64, 64},  {100, 37, 129}, {33, 130, 257}, {257, 65, 31}};
+
+/// op(A) as m x k: stored k x m and transposed when `trans`.
+template <typename T>
+Matrix<T> operand(index_t rows, index_t cols, bool trans, std::uint64_t seed) {
+    return trans ? lana::test::random_matrix<T>(cols, rows, seed) : lana::test::random_matrix<T>(rows, cols, seed);
+}
+
+template <typename T>
+MatrixView<const T> op(const Matrix<T>& m, bool trans) {
+    return trans ? m.view().t() : m.view();
+}
+
+template <typename T>
+void check_gemm(const Shape& s, bool ta, bool tb, T alpha, T beta) {
+    const Matrix<T> a = operand<T>(s.m, s.k, ta, 1 + s.m);
+    const Matrix<T> b = operand<T>(s.k, s.n, tb, 2 + s.n);
+    Matrix<T> c = lana::test::random_matrix<T>(s.m, s.n, 3 + s.k);
+    Matrix<T> ref = c;
+    lana::gemm(alpha, op(a, ta), op(b, tb), beta, c.view());
+    lana::test::reference_gemm<T>(alpha, op(a, ta), op(b, tb), beta, ref.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(s.k));
+}
+
+template <typename T>
+void all_transposes() {
+    for (const Shape& s : shapes) {
+        for (int t = 0; t < 4; ++t) {
+            check_gemm<T>(s, (t & 1) != 0, (t & 2) != 0, T(1.5), T(-0.5));
+        }
+    }
+}
+
+LANA_TEST(gemm_f32_transposes) { all_transposes<float>(); }
+LANA_TEST(gemm_f64_transposes) { all_transposes<double>(); }
+
+template <typename T>
+void strided_operands() {
+    const index_t m = 45, n = 38, k = 51;
+    // Sub-blocks of larger matrices (ld > rows), a row-major C and views
+    // whose row stride is not 1.
+    const Matrix<T> abig = lana::test::random_matrix<T>(m + 7, k + 3, 11);
+    const Matrix<T> bstore = lana::test::random_matrix<T>(2 * k, n, 12);
+    const MatrixView<const T> a = abig.block(5, 2, m, k);
+    const MatrixView<const T> b(bstore.data(), k, n, 2, 2 * k);
+    Matrix<T> cbig = lana::test::random_matrix<T>(n + 4, m + 6, 13);
+    const Matrix<T> before = cbig;
+    const MatrixView<T> c = cbig.block(3, 4, n, m).t();  // m x n, row-major
+    Matrix<T> ref(m, n);
+    ref.copy_from(MatrixView<const T>(c));
+    lana::gemm(T(2), a, b, T(1), c);
+    lana::test::reference_gemm<T>(2.0, a, b, 1.0, ref.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(MatrixView<const T>(c), ref.view()), lana::test::tolerance<T>(k));
+    // Nothing outside the block was written.
+    for (index_t j = 0; j < cbig.cols(); ++j) {
+        for (index_t i = 0; i < cbig.rows(); ++i) {
+            const bool inside = i >= 3 && i < 3 + n && j >= 4 && j < 4 + m;
+            if (!inside) {
+                CHECK(cbig(i, j) == before(i, j));
+            }
+        }
+    }
+}
+
+LANA_TEST(gemm_f32_strided) { strided_operands<float>(); }
+LANA_TEST(gemm_f64_strided) { strided_operands<double>(); }
+
+LANA_TEST(gemm_beta_zero_ignores_c) {
+    const Matrix<double> a = lana::test::random_matrix<double>(20, 30, 21);
+    const Matrix<double> b = lana::test::random_matrix<double>(30, 25, 22);
+    Matrix<double> c(20, 25, std::numeric_limits<double>::quiet_NaN());
+    lana::gemm(1.0, a.view(), b.view(), 0.0, c.view());
+    const Matrix<double> ref = lana::test::reference_product<double>(a.view(), b.view());
+    CHECK_LE(lana::test::max_abs_diff<double>(c.view(), ref.view()), lana::test::tolerance<double>(30));
+}
+
+LANA_TEST(gemm_degenerate_sizes) {
+    // k = 0 scales C by beta; an empty C is left alone.
+    const Matrix<double> a(6, 0);
+    const Matrix<double> b(0, 4);
+    Matrix<double> c(6, 4, 3.0);
+    lana::gemm(1.0, a.view(), b.view(), 0.5, c.view());
+    for (index_t j = 0; j < 4; ++j) {
+        for (index_t i = 0; i < 6; ++i) {
+            CHECK(c(i, j) == 1.5);
+        }
+    }
+    Matrix<double> empty(0, 4);
+    lana::gemm(1.0, Matrix<double>(0, 5).view(), Matrix<double>(5, 4).view(), 0.0, empty.view());
+    CHECK_THROWS(lana::gemm(1.0, a.view(), Matrix<double>(3, 4).view(), 0.0, c.view()), lana::DimensionError);
+}
+
+template <typename T, typename Tiles, typename Get, typename Set>
+void every_tile(Tiles tiles, Get get, Set set) {
+    for (const lana::GemmTile& tile : tiles) {
+        lana::GemmBlocking b;
+        b.mr = tile.mr;
+        b.nr = tile.nr;
+        set(b);
+        CHECK(get().mr == tile.mr && get().nr == tile.nr);
+        check_gemm<T>({77, 93, 61}, false, true, T(1), T(1));
+        check_gemm<T>({130, 50, 200}, true, false, T(-1), T(0));
+    }
+    // Blocks far smaller than the caches: every loop wraps several times.
+    lana::GemmBlocking small;
+    small.mc = 16;
+    small.kc = 8;
+    small.nc = 32;
+    set(small);
+    check_gemm<T>({100, 90, 70}, false, false, T(1), T(0.25));
+    check_gemm<T>({100, 90, 70}, true, true, T(1), T(0.25));
+    set(lana::GemmBlocking{});
+}
+
+LANA_TEST(gemm_f32_every_tile) {
+    every_tile<float>(lana::gemm_tiles_f32(), lana::gemm_blocking_f32, lana::set_gemm_blocking_f32);
+}
+LANA_TEST(gemm_f64_every_tile) {
+    every_tile<double>(lana::gemm_tiles_f64(), lana::gemm_blocking_f64, lana::set_gemm_blocking_f64);
+}
+
+LANA_TEST(gemm_parallel_size) {
+    // Large enough for the parallel split over row blocks and panels.
+    check_gemm<double>({300, 280, 260}, false, false, 1.0, 0.0);
+    check_gemm<float>({310, 290, 250}, true, false, 1.0f, 1.0f);
+}
+
+LANA_TEST(gemm_epilogue) {
+    const index_t m = 40, n = 33, k = 20;
+    const Matrix<double> a = lana::test::random_matrix<double>(m, k, 31);
+    const Matrix<double> b = lana::test::random_matrix<double>(k, n, 32);
+    const lana::Vector<double> rb = lana::test::random_vector<double>(m, 33);
+    const lana::Vector<double> cb = lana::test::random_vector<double>(n, 34);
+    Matrix<double> c(m, n);
+    lana::gemm(1.0, a.view(), b.view(), 0.0, c.view(), {rb.data(), cb.data(), lana::Activation::Relu});
+    const Matrix<double> ref = lana::test::reference_product<double>(a.view(), b.view());
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < m; ++i) {
+            CHECK_NEAR(c(i, j), std::max(0.0, ref(i, j) + rb[i] + cb[j]), 1e-12);
+        }
+    }
+}
+
+}  // namespace
@@ -0,0 +1,161 @@
+// Round trips through lana files and the interop formats: what goes in
+// comes back bit-identical, in whatever layout it was written from, and
+// malformed input is rejected with the documented exception.
+
+#include "check.hpp"
+
+#include "lana/interop.hpp"
+#include "lana/io.hpp"
+#include "lana/sparse.hpp"
+
+#include <unistd.h>
+
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+
+/// A file in the temp directory, unique per process since ctest runs the
+/// ISA and thread variants of this test in parallel; removed on scope exit.
+struct TempFile {
+    explicit TempFile(const char* tag)
+        : path((std::filesystem::temp_directory_path() /
+                ("lana_test_" + std::to_string(::getpid()) + "_" + tag + ".lana"))
+                   .string()) {}
+    ~TempFile() { std::filesystem::remove(path); }
+    std::string path;
+};
+
+template <typename T>
+bool identical(MatrixView<const T> a, MatrixView<const T> b) {
+    if (a.rows() != b.rows() || a.cols() != b.cols()) {
+        return false;
+    }
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            if (!(a(i, j) == b(i, j))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+LANA_TEST(io_dense_and_csr_round_trip) {
+    TempFile file("round_trip");
+    const Matrix<double> a = lana::test::random_matrix<double>(37, 21, 1);
+    const Matrix<float> f = lana::test::random_matrix<float>(8, 300, 2);
+    const Matrix<double> big = lana::test::random_matrix<double>(50, 40, 3);
+    const MatrixView<const double> block = big.block(3, 5, 20, 17);
+    const Matrix<double> row_major_store = lana::test::random_matrix<double>(13, 9, 4);
+    const MatrixView<const double> row_major = row_major_store.view().t();
+    Matrix<double> sparse_src = lana::test::random_matrix<double>(30, 25, 5);
+    for (index_t j = 0; j < 25; ++j) {
+        for (index_t i = 0; i < 30; ++i) {
+            if ((i * 7 + j) % 5 != 0) {
+                sparse_src(i, j) = 0;
+            }
+        }
+    }
+    const lana::Csr<double> csr = lana::Csr<double>::from_dense(sparse_src.view());
+    {
+        lana::FileWriter w(file.path);
+        w.add("a", a.view());
+        w.add("f", f.view());
+        w.add("block", block);
+        w.add("row_major", row_major);
+        w.add("csr", csr.view());
+        w.close();
+    }
+    const lana::MappedFile m(file.path);
+    CHECK(m.sections().size() == 5);
+    CHECK(m.contains("block") && !m.contains("missing"));
+    CHECK(identical<double>(m.matrix<double>("a"), a.view()));
+    CHECK(identical<float>(m.matrix<float>("f"), f.view()));
+    CHECK(identical<double>(m.matrix<double>("block"), block));
+    CHECK(identical<double>(m.matrix<double>("row_major"), row_major));
+    CHECK(m.section("row_major").layout == lana::Layout::RowMajor);
+    const lana::CsrView<double> back = m.csr<double>("csr");
+    CHECK(back.rows() == 30 && back.cols() == 25 && back.nnz() == csr.nnz());
+    CHECK(identical<double>(lana::Csr<double>(back).to_dense().view(), sparse_src.view()));
+    // Payloads are page aligned, so the views point straight into the map.
+    CHECK(reinterpret_cast<std::uintptr_t>(m.matrix<double>("a").data()) % 4096 == 0);
+}
+
+LANA_TEST(io_rejects_bad_requests) {
+    TempFile file("bad");
+    const Matrix<double> a = lana::test::random_matrix<double>(4, 4, 6);
+    lana::save(file.path, a.view());
+    const lana::MappedFile m(file.path);
+    CHECK(m.sections().size() == 1);
+    const std::string name = m.sections()[0].name;
+    CHECK(identical<double>(m.matrix<double>(name), a.view()));
+    CHECK_THROWS(m.section("missing"), lana::IoError);
+    CHECK_THROWS(m.matrix<float>(name), lana::IoError);
+    CHECK_THROWS(m.csr<double>(name), lana::IoError);
+    CHECK_THROWS(lana::MappedFile(file.path + ".absent"), lana::IoError);
+}
+
+LANA_TEST(io_rejects_truncated_file) {
+    TempFile file("truncated");
+    const Matrix<double> a = lana::test::random_matrix<double>(64, 64, 7);
+    lana::save(file.path, a.view());
+    std::filesystem::resize_file(file.path, std::filesystem::file_size(file.path) / 2);
+    CHECK_THROWS(lana::MappedFile(file.path), lana::IoError);
+    // Not a lana file at all.
+    std::ofstream(file.path, std::ios::trunc) << "not a matrix file";
+    CHECK_THROWS(lana::MappedFile(file.path), lana::IoError);
+}
+
+LANA_TEST(interop_dlpack_round_trip) {
+    Matrix<double> a = lana::test::random_matrix<double>(12, 7, 8);
+    const Matrix<double> copy = a;
+    const double* storage = a.data();
+    {
+        // Owned: the consumer's view is the matrix's own storage.
+        lana::interop::External<double> ext(lana::interop::to_dlpack(std::move(a)));
+        CHECK(ext.view().data() == storage);
+        CHECK(identical<double>(ext.view(), copy.view()));
+    }
+    // Lent, and strided: a transposed sub-block.
+    Matrix<double> b = lana::test::random_matrix<double>(20, 30, 9);
+    const MatrixView<double> v = b.block(2, 3, 10, 15).t();
+    DLManagedTensor* t = lana::interop::to_dlpack(v);
+    const MatrixView<double> seen = lana::interop::from_dlpack<double>(t->dl_tensor);
+    CHECK(seen.data() == v.data());
+    CHECK(identical<double>(seen, v));
+    CHECK_THROWS(lana::interop::from_dlpack<float>(t->dl_tensor), lana::DimensionError);
+    t->deleter(t);
+}
+
+LANA_TEST(interop_buffer_round_trip) {
+    Matrix<float> a = lana::test::random_matrix<float>(9, 11, 10);
+    const MatrixView<float> v = a.block(1, 2, 6, 8);
+    const lana::interop::BufferInfo info = lana::interop::to_buffer(v);
+    CHECK(info.ndim == 2 && info.itemsize == 4 && !info.readonly);
+    const MatrixView<float> back = lana::interop::from_buffer<float>(info);
+    CHECK(back.data() == v.data());
+    CHECK(identical<float>(back, v));
+    CHECK_THROWS(lana::interop::from_buffer<double>(info), lana::DimensionError);
+}
+
+LANA_TEST(interop_arrow_round_trip) {
+    Matrix<double> a = lana::test::random_matrix<double>(5, 8, 11);
+    const Matrix<double> copy = a;
+    ArrowArray array{};
+    ArrowSchema schema{};
+    lana::interop::to_arrow(std::move(a), &array, &schema);
+    CHECK(lana::interop::from_arrow<double>(array, schema).rows() == 8);
+    CHECK_THROWS(lana::interop::from_arrow<float>(array, schema), lana::DimensionError);
+    // One list per column: Arrow sees the transpose.
+    const lana::interop::External<const double> ext(&array, &schema);
+    CHECK(array.release == nullptr && schema.release == nullptr);
+    CHECK(identical<double>(ext.view(), copy.view().t()));
+}
+
+}  // namespace
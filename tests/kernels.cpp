@@ -0,0 +1,145 @@
+// Every entry of the dispatched kernel table against a scalar reference:
+// lengths from 0 through several SIMD widths plus a tail, misaligned
+// starting points, strided views (which bypass the kernels) and, for nrm2,
+// magnitudes that would overflow a naive sum of squares. Registered once per
+// LANA_ISA path.
+
+#include "check.hpp"
+
+#include "lana/blas1.hpp"
+#include "lana/expr.hpp"
+#include "lana/sparse.hpp"
+
+#include <limits>
+
+namespace {
+
+using lana::index_t;
+using lana::Vector;
+using lana::VectorView;
+
+constexpr index_t max_len = 131;
+
+template <typename T>
+void blas1_lengths() {
+    const Vector<T> xs = lana::test::random_vector<T>(max_len + 3, 1);
+    const Vector<T> ys = lana::test::random_vector<T>(max_len + 3, 2);
+    for (index_t off = 0; off < 3; ++off) {
+        for (index_t n = 0; n <= max_len; ++n) {
+            const VectorView<const T> x(xs.data() + off, n);
+            const VectorView<const T> y(ys.data() + 2 - off % 2, n);
+            double d = 0, s = 0, q = 0;
+            for (index_t i = 0; i < n; ++i) {
+                d += double(x[i]) * double(y[i]);
+                s += double(x[i]);
+                q += double(x[i]) * double(x[i]);
+            }
+            const double tol = lana::test::tolerance<T>(n);
+            CHECK_NEAR(double(lana::dot(x, y)), d, tol);
+            CHECK_NEAR(double(lana::sum(x)), s, tol);
+            CHECK_NEAR(double(lana::nrm2(x)), std::sqrt(q), tol);
+            Vector<T> z(n);
+            for (index_t i = 0; i < n; ++i) {
+                z[i] = y[i];
+            }
+            lana::axpy(T(-1.5), x, z.view());
+            for (index_t i = 0; i < n; ++i) {
+                CHECK_NEAR(double(z[i]), double(y[i]) - 1.5 * double(x[i]), 4 * tol);
+            }
+        }
+    }
+}
+
+LANA_TEST(blas1_f32_lengths) { blas1_lengths<float>(); }
+LANA_TEST(blas1_f64_lengths) { blas1_lengths<double>(); }
+
+LANA_TEST(blas1_strided) {
+    const Vector<double> xs = lana::test::random_vector<double>(300, 3);
+    const VectorView<const double> x(xs.data(), 100, 3);
+    double d = 0;
+    for (index_t i = 0; i < 100; ++i) {
+        d += xs[3 * i] * xs[3 * i];
+    }
+    CHECK_NEAR(lana::dot(x, x), d, 1e-12);
+    CHECK_NEAR(lana::nrm2(x), std::sqrt(d), 1e-12);
+}
+
+LANA_TEST(nrm2_extreme_magnitudes) {
+    for (double scale : {1e300, 1e-300}) {
+        Vector<double> x(37, scale);
+        CHECK_NEAR(lana::nrm2(x.view()) / scale, std::sqrt(37.0), 1e-12);
+    }
+    Vector<float> f(50, 1e30f);
+    CHECK_NEAR(double(lana::nrm2(f.view())) / 1e30, std::sqrt(50.0), 1e-5);
+    CHECK(lana::nrm2(Vector<double>(0).view()) == 0.0);
+}
+
+template <typename T>
+void lincomb_terms() {
+    constexpr int max_terms = lana::detail::lincomb_max_terms;
+    std::vector<Vector<T>> xs;
+    for (int t = 0; t < max_terms; ++t) {
+        xs.push_back(lana::test::random_vector<T>(max_len, 10 + t));
+    }
+    for (int terms = 1; terms <= max_terms; ++terms) {
+        for (index_t n : {index_t(0), index_t(1), index_t(7), index_t(16), index_t(33), max_len}) {
+            std::vector<T> coeffs;
+            std::vector<const T*> ptrs;
+            for (int t = 0; t < terms; ++t) {
+                coeffs.push_back(T(0.25) * T(t + 1) * (t % 2 == 0 ? T(1) : T(-1)));
+                ptrs.push_back(xs[static_cast<std::size_t>(t)].data());
+            }
+            Vector<T> y(n, T(7));
+            lana::detail::lincomb(n, terms, coeffs.data(), ptrs.data(), y.data());
+            for (index_t i = 0; i < n; ++i) {
+                double r = 0;
+                for (int t = 0; t < terms; ++t) {
+                    r += double(coeffs[static_cast<std::size_t>(t)]) * double(ptrs[static_cast<std::size_t>(t)][i]);
+                }
+                CHECK_NEAR(double(y[i]), r, lana::test::tolerance<T>(terms));
+            }
+        }
+    }
+    // In place: y may be one of the operands.
+    Vector<T> y = xs[0];
+    const T coeffs[2] = {T(2), T(-1)};
+    const T* ptrs[2] = {y.data(), xs[1].data()};
+    lana::detail::lincomb(max_len, 2, coeffs, ptrs, y.data());
+    for (index_t i = 0; i < max_len; ++i) {
+        CHECK_NEAR(double(y[i]), 2.0 * double(xs[0][i]) - double(xs[1][i]), lana::test::tolerance<T>(2));
+    }
+}
+
+LANA_TEST(lincomb_f32_terms) { lincomb_terms<float>(); }
+LANA_TEST(lincomb_f64_terms) { lincomb_terms<double>(); }
+
+template <typename T>
+void sparse_dot_rows() {
+    // Row i holds i % 41 entries, so every row length up to 40 appears,
+    // gathering from scattered columns.
+    const index_t rows = 200, cols = 300;
+    lana::Coo<T> coo(rows, cols);
+    lana::test::Rng rng(20);
+    for (index_t i = 0; i < rows; ++i) {
+        for (index_t k = 0; k < i % 41; ++k) {
+            coo.add(i, (i * 7 + k * 13) % cols, static_cast<T>(rng.next()));
+        }
+    }
+    const lana::Csr<T> a(coo);
+    const lana::Matrix<T> dense = a.to_dense();
+    const Vector<T> x = lana::test::random_vector<T>(cols, 21);
+    Vector<T> y(rows);
+    lana::spmv(T(2), a.view(), x.view(), T(0), y.view());
+    for (index_t i = 0; i < rows; ++i) {
+        double r = 0;
+        for (index_t j = 0; j < cols; ++j) {
+            r += double(dense(i, j)) * double(x[j]);
+        }
+        CHECK_NEAR(double(y[i]), 2 * r, lana::test::tolerance<T>(41));
+    }
+}
+
+LANA_TEST(sparse_dot_f32_irregular_rows) { sparse_dot_rows<float>(); }
+LANA_TEST(sparse_dot_f64_irregular_rows) { sparse_dot_rows<double>(); }
+
+}  // namespace
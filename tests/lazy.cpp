@@ -0,0 +1,197 @@
+// Deferred evaluation: every graph evaluates to what the eager operations
+// give, and the plan shows the optimizations promised: the cheaper end of
+// a product chain first, transposes folded into the inputs, bias,
+// activation and added matrices fused into the GEMM, shared nodes once.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/lazy.hpp"
+
+#include <cmath>
+#include <string>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+namespace lazy = lana::lazy;
+
+std::size_t count(const std::string& text, const std::string& what) {
+    std::size_t n = 0;
+    for (std::size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+template <typename T>
+Matrix<T> transposed(const Matrix<T>& m) {
+    return Matrix<T>(m.view().t());
+}
+
+template <typename T>
+T activation(lana::Activation act, T x) {
+    switch (act) {
+        case lana::Activation::Relu:
+            return x > T(0) ? x : T(0);
+        case lana::Activation::Sigmoid:
+            return T(1) / (T(1) + std::exp(-x));
+        case lana::Activation::Tanh:
+            return std::tanh(x);
+        case lana::Activation::Gelu:
+            return T(0.5) * x * (T(1) + std::tanh(T(0.7978845608028654) * (x + T(0.044715) * x * x * x)));
+        case lana::Activation::None:
+            break;
+    }
+    return x;
+}
+
+template <typename T>
+void product_chains() {
+    const Matrix<T> a = lana::test::random_matrix<T>(100, 80, 1);
+    const Matrix<T> b = lana::test::random_matrix<T>(80, 60, 2);
+    const Matrix<T> v = lana::test::random_matrix<T>(60, 1, 3);
+    const auto A = lazy::ref(a);
+    const auto B = lazy::ref(b);
+    const auto V = lazy::ref(v);
+    const double tol = 4 * lana::test::tolerance<T>(80) * 80;
+
+    // (A * B) * v runs as A * (B * v): two matrix-vector products.
+    const auto chain = (A * B) * V;
+    const std::string plan = lazy::explain(chain);
+    CHECK(count(plan, "gemm(") == 2);
+    CHECK(plan.find("t0 = gemm(1, in[80x60], in[60x1]") == 0);
+    const Matrix<T> ref = lana::test::reference_product<T>(lana::test::reference_product<T>(a.view(), b.view()).view(),
+                                                           v.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(lazy::eval(chain).view(), ref.view()), tol);
+
+    // v^T * (B^T * A^T), all transposes folded into the input views.
+    const auto row = lazy::t(V) * lazy::t(A * B);
+    const std::string row_plan = lazy::explain(row);
+    CHECK(count(row_plan, "gemm(") == 2 && row_plan.find("^T") != std::string::npos);
+    CHECK_LE(lana::test::max_abs_diff<T>(lazy::eval(row).view(), transposed(ref).view()), tol);
+
+    // t(A * B) is one GEMM on transposed views, no copy.
+    const auto tp = lazy::t(A * B);
+    CHECK(lazy::explain(tp).find("out = gemm(1, in[60x80]^T, in[80x100]^T") == 0);
+    const Matrix<T> ab = lana::test::reference_product<T>(a.view(), b.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(lazy::eval(tp).view(), transposed(ab).view()), tol);
+    CHECK_THROWS(A * V, lana::DimensionError);
+}
+
+LANA_TEST(lazy_f32_product_chains) { product_chains<float>(); }
+LANA_TEST(lazy_f64_product_chains) { product_chains<double>(); }
+
+template <typename T>
+void fused_epilogues() {
+    const Matrix<T> a = lana::test::random_matrix<T>(70, 50, 4);
+    const Matrix<T> b = lana::test::random_matrix<T>(50, 40, 5);
+    const Matrix<T> c = lana::test::random_matrix<T>(70, 40, 6);
+    const lana::Vector<T> bias = lana::test::random_vector<T>(70, 7);
+    const auto A = lazy::ref(a);
+    const auto B = lazy::ref(b);
+    const Matrix<T> ab = lana::test::reference_product<T>(a.view(), b.view());
+    const double tol = 4 * lana::test::tolerance<T>(50) * 50;
+
+    for (lana::Activation act : {lana::Activation::Relu, lana::Activation::Sigmoid, lana::Activation::Tanh,
+                                 lana::Activation::Gelu}) {
+        const auto y = lazy::activate(lazy::add_bias(A * B, bias), act);
+        const std::string plan = lazy::explain(y);
+        CHECK(count(plan, "\n") == 1 && plan.find("+bias(row) +") != std::string::npos);
+        const Matrix<T> got = lazy::eval(y);
+        for (index_t j = 0; j < 40; ++j) {
+            for (index_t i = 0; i < 70; ++i) {
+                CHECK_NEAR(got(i, j), activation<T>(act, ab(i, j) + bias[i]), tol);
+            }
+        }
+    }
+
+    // An added matrix becomes the GEMM's beta = 1 input.
+    const auto sum = T(2) * (A * B) + lazy::ref(c);
+    CHECK(lazy::explain(sum).find("beta=1") != std::string::npos);
+    const Matrix<T> s = lazy::eval(sum);
+    for (index_t j = 0; j < 40; ++j) {
+        for (index_t i = 0; i < 70; ++i) {
+            CHECK_NEAR(s(i, j), 2 * ab(i, j) + c(i, j), tol);
+        }
+    }
+
+    // Transposed, the per-row bias becomes a per-column one.
+    const Matrix<T> tr = lazy::eval(lazy::t(lazy::relu(lazy::add_bias(A * B, bias))));
+    CHECK(tr.rows() == 40 && tr.cols() == 70);
+    for (index_t j = 0; j < 70; ++j) {
+        for (index_t i = 0; i < 40; ++i) {
+            CHECK_NEAR(tr(i, j), activation<T>(lana::Activation::Relu, ab(j, i) + bias[j]), tol);
+        }
+    }
+    CHECK_THROWS(lazy::add_bias(A * B, lana::test::random_vector<T>(40, 8)), lana::DimensionError);
+}
+
+LANA_TEST(lazy_f32_fused_epilogues) { fused_epilogues<float>(); }
+LANA_TEST(lazy_f64_fused_epilogues) { fused_epilogues<double>(); }
+
+LANA_TEST(lazy_elementwise_and_reductions) {
+    const Matrix<double> c = lana::test::random_matrix<double>(33, 21, 9);
+    const Matrix<double> d = lana::test::random_matrix<double>(21, 33, 10);
+    const auto C = lazy::ref(c);
+    const auto D = lazy::ref(d);
+
+    // One pass over the inputs, with no temporaries.
+    const auto e = 2.0 * C - lazy::cwise_mul(C, lazy::t(D)) + -C;
+    const std::string plan = lazy::explain(e);
+    CHECK(count(plan, "\n") == 1 && plan.find("t0") == std::string::npos);
+    const Matrix<double> got = lazy::eval(e);
+    double total = 0;
+    double dot = 0;
+    for (index_t j = 0; j < 21; ++j) {
+        for (index_t i = 0; i < 33; ++i) {
+            CHECK_NEAR(got(i, j), c(i, j) - c(i, j) * d(j, i), 1e-15);
+            total += c(i, j);
+            dot += c(i, j) * d(j, i);
+        }
+    }
+    CHECK_NEAR(lazy::eval_scalar(lazy::sum(C)), total, 1e-13);
+    CHECK_NEAR(lazy::eval_scalar(lazy::dot(C, lazy::t(D))), dot, 1e-13);
+    CHECK_THROWS(lazy::eval_scalar(C), lana::DimensionError);
+    CHECK_THROWS(C + D, lana::DimensionError);
+
+    // Vectors enter as n x 1 matrices.
+    const lana::Vector<double> x = lana::test::random_vector<double>(21, 11);
+    const Matrix<double> cx = lazy::eval(C * lazy::ref(x));
+    CHECK(cx.rows() == 33 && cx.cols() == 1);
+    Matrix<double> ref(33, 1);
+    const Matrix<double> xm(lana::MatrixView<const double>(x.data(), 21, 1, 1, 21));
+    lana::test::reference_gemm<double>(1.0, c.view(), xm.view(), 0.0, ref.view());
+    CHECK_LE(lana::test::max_abs_diff<double>(cx.view(), ref.view()), 1e-13);
+}
+
+LANA_TEST(lazy_shared_nodes_run_once) {
+    const Matrix<double> a = lana::test::random_matrix<double>(30, 20, 12);
+    const Matrix<double> b = lana::test::random_matrix<double>(20, 30, 13);
+    const auto p = lazy::ref(a) * lazy::ref(b);
+    const auto e = p + lazy::t(p) + p;
+    // p is one temporary read twice; t(p) accumulates into the result as
+    // a GEMM on transposed inputs rather than a strided read of it.
+    const std::string plan = lazy::explain(e);
+    CHECK(count(plan, "t0 = gemm(") == 1 && count(plan, "gemm(") == 2);
+    CHECK(plan.find("out = (t0 + t0)") != std::string::npos);
+    CHECK(plan.find("in[30x20]^T, in[20x30]^T, beta=1") != std::string::npos);
+    const Matrix<double> ab = lana::test::reference_product<double>(a.view(), b.view());
+    const Matrix<double> got = lazy::eval(e);
+    for (index_t j = 0; j < 30; ++j) {
+        for (index_t i = 0; i < 30; ++i) {
+            CHECK_NEAR(got(i, j), 2 * ab(i, j) + ab(j, i), 1e-13);
+        }
+    }
+
+    // eval_into a block writes only the block.
+    Matrix<double> big(40, 40, 5.0);
+    lazy::eval_into(e, big.block(3, 4, 30, 30));
+    CHECK(big(2, 4) == 5.0 && big(33, 4) == 5.0 && big(3, 3) == 5.0 && big(3, 34) == 5.0);
+    CHECK_NEAR(big(3, 4), got(0, 0), 0);
+    Matrix<double> wrong(30, 29);
+    CHECK_THROWS(lazy::eval_into(e, wrong.view()), lana::DimensionError);
+}
+
+}  // namespace
@@ -0,0 +1,60 @@
+// Shared main() of the test executables: runs every LANA_TEST case, or
+// those whose name contains argv[1], and reports each failure.
+
+#include "check.hpp"
+
+#include "lana/cpu.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+namespace lana::test {
+
+std::vector<Case>& registry() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void fail(const char* file, int line, const std::string& what) {
+    std::ostringstream os;
+    os << file << ':' << line << ": " << what;
+    throw Failure{os.str()};
+}
+
+}  // namespace lana::test
+
+int main(int argc, char** argv) {
+    // A forced path the host cannot run falls back to another one; testing
+    // that under this ISA's name would pass for the wrong reason.
+    if (const char* forced = std::getenv("LANA_ISA"); forced != nullptr && *forced != '\0') {
+        const char* active = lana::isa_name(lana::active_isa());
+        if (std::strcmp(forced, active) != 0) {
+            std::printf("skipped: LANA_ISA=%s is not available here (active: %s)\n", forced, active);
+            return lana::test::skip_code;
+        }
+    }
+    const char* filter = argc > 1 ? argv[1] : nullptr;
+    int run = 0;
+    int failed = 0;
+    for (const lana::test::Case& c : lana::test::registry()) {
+        if (filter != nullptr && std::strstr(c.name, filter) == nullptr) {
+            continue;
+        }
+        ++run;
+        try {
+            c.run();
+            std::printf("ok   %s\n", c.name);
+        } catch (const lana::test::Failure& f) {
+            ++failed;
+            std::printf("FAIL %s\n     %s\n", c.name, f.message.c_str());
+        } catch (const std::exception& e) {
+            ++failed;
+            std::printf("FAIL %s\n     uncaught exception: %s\n", c.name, e.what());
+        }
+        std::fflush(stdout);
+    }
+    std::printf("%d of %d cases passed\n", run - failed, run);
+    return failed > 0 || run == 0 ? 1 : 0;
+}
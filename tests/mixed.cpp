@@ -0,0 +1,248 @@
+// Mixed precision: bfloat16 and half rounding, the 16-bit GEMMs against a
+// reference over the widened operands, and gesv_refine / posv_refine
+// reaching double accuracy or falling back to a double factorization.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/half.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+using lana::bfloat16;
+using lana::half;
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+
+LANA_TEST(half_rounds_to_nearest_even) {
+    CHECK(half(1.0f).bits == 0x3c00 && half(-2.0f).bits == 0xc000);
+    CHECK(half(65504.0f).bits == 0x7bff);
+    CHECK(half(65520.0f).bits == 0x7c00);  // halfway to the next binade: infinity
+    CHECK(half(1.0f + 0x1p-11f).bits == 0x3c00);
+    CHECK(half(1.0f + 3 * 0x1p-11f).bits == 0x3c02);
+    CHECK(half(0x1p-24f).bits == 0x0001);  // smallest subnormal
+    CHECK(half(0x1p-25f).bits == 0x0000);  // tie to the even zero
+    CHECK(half(3 * 0x1p-25f).bits == 0x0002);
+    CHECK(float(half::from_bits(0x03ff)) == 1023 * 0x1p-24f);
+    CHECK(std::isinf(float(half(std::numeric_limits<float>::infinity()))));
+    CHECK(std::isnan(float(half(std::numeric_limits<float>::quiet_NaN()))));
+
+    // Every finite half survives the round trip through float.
+    index_t mismatches = 0;
+    for (std::uint32_t b = 0; b < 0x10000; ++b) {
+        const half h = half::from_bits(static_cast<std::uint16_t>(b));
+        if ((b & 0x7c00) != 0x7c00 && half(float(h)).bits != h.bits) {
+            ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+LANA_TEST(bfloat16_rounds_to_nearest_even) {
+    CHECK(bfloat16(1.0f).bits == 0x3f80 && bfloat16(-2.0f).bits == 0xc000);
+    CHECK(bfloat16(1.0f + 0x1p-8f).bits == 0x3f80);
+    CHECK(bfloat16(1.0f + 3 * 0x1p-8f).bits == 0x3f82);
+    CHECK(bfloat16(std::numeric_limits<float>::max()).bits == 0x7f80);
+    CHECK(float(bfloat16(1e38f)) > 9.9e37f);  // the range of float
+    const bfloat16 nan(std::numeric_limits<float>::quiet_NaN());
+    CHECK(std::isnan(float(nan)));
+    // A signalling NaN whose payload sits below the kept bits stays a NaN.
+    CHECK(std::isnan(float(bfloat16(std::bit_cast<float>(0x7f800001u)))));
+
+    index_t mismatches = 0;
+    for (std::uint32_t b = 0; b < 0x10000; ++b) {
+        const bfloat16 h = bfloat16::from_bits(static_cast<std::uint16_t>(b));
+        if ((b & 0x7f80) != 0x7f80 && bfloat16(float(h)).bits != h.bits) {
+            ++mismatches;
+        }
+    }
+    CHECK(mismatches == 0);
+}
+
+LANA_TEST(convert_between_precisions) {
+    const Matrix<double> d = lana::test::random_matrix<double>(37, 29, 1);
+    Matrix<half> h(37, 29);
+    lana::convert<half, double>(d.view(), h.view());
+    Matrix<float> f(29, 37);
+    lana::convert<float, half>(h.view(), f.view().t());
+    for (index_t j = 0; j < 29; ++j) {
+        for (index_t i = 0; i < 37; ++i) {
+            CHECK(f(j, i) == float(half(float(d(i, j)))));
+        }
+    }
+    Matrix<bfloat16> wrong(37, 28);
+    CHECK_THROWS((lana::convert<bfloat16, double>(d.view(), wrong.view())), lana::DimensionError);
+}
+
+template <typename H>
+Matrix<H> to_16(const Matrix<float>& a) {
+    Matrix<H> h(a.rows(), a.cols());
+    lana::convert<H, float>(a.view(), h.view());
+    return h;
+}
+
+template <typename H>
+Matrix<float> to_32(MatrixView<const H> a) {
+    Matrix<float> f(a.rows(), a.cols());
+    lana::convert<float, H>(a, f.view());
+    return f;
+}
+
+/// The mixed GEMM against a double reference over the same 16-bit values:
+/// the only error is float accumulation.
+template <typename H>
+void gemm_16() {
+    for (const auto& [m, n, k] : {std::tuple<index_t, index_t, index_t>{1, 1, 1},
+                                  {7, 5, 3},
+                                  {33, 17, 65},
+                                  {64, 64, 64},
+                                  {130, 97, 300},
+                                  {301, 257, 129}}) {
+        const Matrix<H> a = to_16<H>(lana::test::random_matrix<float>(m, k, 2));
+        const Matrix<H> bt = to_16<H>(lana::test::random_matrix<float>(n, k, 3));
+        const MatrixView<const H> b = bt.view().t();  // a transposed operand
+        const Matrix<float> c0 = lana::test::random_matrix<float>(m, n, 4);
+        const Matrix<float> a32 = to_32<H>(a.view());
+        const Matrix<float> b32 = to_32<H>(b);
+        const double tol = lana::test::tolerance<float>(k);
+        for (const auto& [alpha, beta] : {std::pair<float, float>{1, 0}, {-0.5f, 2}}) {
+            Matrix<float> ref = c0;
+            lana::test::reference_gemm<float>(alpha, a32.view(), b32.view(), beta, ref.view());
+            Matrix<float> c = c0;
+            if (beta == 0) {
+                c.fill(std::numeric_limits<float>::quiet_NaN());
+            }
+            lana::gemm(alpha, a.view(), b, beta, c.view());
+            CHECK_LE(lana::test::max_abs_diff<float>(c.view(), ref.view()), tol);
+        }
+    }
+
+    // A block of a larger C is the only part written.
+    const Matrix<H> a = to_16<H>(lana::test::random_matrix<float>(40, 20, 5));
+    const Matrix<H> b = to_16<H>(lana::test::random_matrix<float>(20, 30, 6));
+    Matrix<float> big(50, 40, 3.0f);
+    lana::gemm(1.0f, a.view(), b.view(), 0.0f, big.block(5, 6, 40, 30));
+    CHECK(big(4, 6) == 3.0f && big(45, 6) == 3.0f && big(5, 5) == 3.0f && big(5, 36) == 3.0f);
+
+    Matrix<float> wrong(40, 31);
+    CHECK_THROWS(lana::gemm(1.0f, a.view(), b.view(), 0.0f, wrong.view()), lana::DimensionError);
+}
+
+LANA_TEST(gemm_bf16) { gemm_16<bfloat16>(); }
+LANA_TEST(gemm_f16) { gemm_16<half>(); }
+
+/// max|B - A X| over max|X| * |A|_inf, in units of double epsilon.
+double backward_error(const Matrix<double>& a, const Matrix<double>& x, const Matrix<double>& b) {
+    Matrix<double> r = b;
+    lana::test::reference_gemm<double>(-1.0, a.view(), x.view(), 1.0, r.view());
+    double anorm = 0;
+    for (index_t i = 0; i < a.rows(); ++i) {
+        double row = 0;
+        for (index_t j = 0; j < a.cols(); ++j) {
+            row += std::abs(a(i, j));
+        }
+        anorm = std::max(anorm, row);
+    }
+    return lana::test::max_abs<double>(r.view()) /
+           (lana::test::max_abs<double>(x.view()) * anorm * std::numeric_limits<double>::epsilon());
+}
+
+/// Hilbert matrix: symmetric positive definite, cond(H_10) ~ 1.6e13.
+Matrix<double> hilbert(index_t n) {
+    Matrix<double> h(n, n);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < n; ++i) {
+            h(i, j) = 1.0 / double(i + j + 1);
+        }
+    }
+    return h;
+}
+
+template <bool Sym>
+lana::RefineResult refine(MatrixView<const double> a, MatrixView<double> b) {
+    return Sym ? lana::posv_refine(a, b) : lana::gesv_refine(a, b);
+}
+
+template <bool Sym>
+void refinement() {
+    const index_t n = 300;
+    // Well conditioned: it converges in float to double accuracy.
+    Matrix<double> a = lana::test::random_spd<double>(n, 7);
+    if (!Sym) {
+        const Matrix<double> g = lana::test::random_matrix<double>(n, n, 8);
+        for (index_t j = 0; j < n; ++j) {
+            for (index_t i = 0; i < n; ++i) {
+                a(i, j) += g(i, j);  // no longer symmetric
+            }
+        }
+    }
+    const Matrix<double> b = lana::test::random_matrix<double>(n, 3, 9);
+    Matrix<double> x = b;
+    lana::RefineResult res = refine<Sym>(a.view(), x.view());
+    CHECK(res.info == 0 && res.mixed && res.iterations >= 1);
+    CHECK_LE(backward_error(a, x, b), 4 * std::sqrt(double(n)));
+
+    // Only the lower triangle is read by posv_refine; the upper one would
+    // not even fit in float.
+    if (Sym) {
+        Matrix<double> lower = a;
+        for (index_t j = 1; j < n; ++j) {
+            for (index_t i = 0; i < j; ++i) {
+                lower(i, j) = 1e300;
+            }
+        }
+        Matrix<double> y = b;
+        res = refine<Sym>(lower.view(), y.view());
+        CHECK(res.info == 0 && res.mixed);
+        CHECK_LE(lana::test::max_abs_diff<double>(y.view(), x.view()), 1e-12);
+    }
+
+    // Too ill-conditioned for float: solved in double instead.
+    const Matrix<double> h = hilbert(10);
+    const Matrix<double> hb = lana::test::random_matrix<double>(10, 2, 10);
+    Matrix<double> hx = hb;
+    res = refine<Sym>(h.view(), hx.view());
+    CHECK(res.info == 0 && !res.mixed);
+    CHECK_LE(backward_error(h, hx, hb), 100);
+
+    // Entries beyond the range of float.
+    Matrix<double> big = a;
+    big.view() *= 1e40;
+    Matrix<double> bx = b;
+    res = refine<Sym>(big.view(), bx.view());
+    CHECK(res.info == 0 && !res.mixed && res.iterations == 0);
+    CHECK_LE(backward_error(big, bx, b), 4 * std::sqrt(double(n)));
+
+    // Singular (or, for posv, indefinite): info from the double
+    // factorization and B untouched.
+    Matrix<double> s = a;
+    for (index_t i = 0; i < n; ++i) {
+        s(i, 4) = 0.0;
+        s(4, i) = 0.0;
+    }
+    Matrix<double> sx = b;
+    res = refine<Sym>(s.view(), sx.view());
+    CHECK(!res.mixed && res.info == 5);
+    CHECK(lana::test::max_abs_diff<double>(sx.view(), b.view()) == 0);
+
+    Matrix<double> wrong(n - 1, 1);
+    CHECK_THROWS(refine<Sym>(a.view(), wrong.view()), lana::DimensionError);
+    Matrix<double> none(n, 0);
+    CHECK(refine<Sym>(a.view(), none.view()).info == 0);
+}
+
+LANA_TEST(gesv_refine_general) { refinement<false>(); }
+LANA_TEST(posv_refine_spd) { refinement<true>(); }
+
+}  // namespace
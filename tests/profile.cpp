@@ -0,0 +1,258 @@
+// lana::profile: nothing is counted while it is off; once on, public kernel
+// calls land in the right (kernel, dtype, size) bucket with their flops and
+// bytes, every thread's table is summed, and the marker hooks bracket each
+// counted call.
+
+#include "check.hpp"
+
+#include "lana/blas1.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/profile.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+namespace profile = lana::profile;
+
+/// The counters of one bucket, or null.
+const profile::KernelCounters* find(const profile::Snapshot& s, const char* kernel, profile::Dtype dtype,
+                                    std::int64_t size) {
+    for (const profile::KernelCounters& c : s.kernels) {
+        if (c.kernel == kernel && c.dtype == dtype && c.size_lo <= size && size <= c.size_hi) {
+            return &c;
+        }
+    }
+    return nullptr;
+}
+
+/// Turns profiling on, from zero, for one case.
+struct Profiling {
+    Profiling() {
+        profile::reset();
+        profile::set_enabled(true);
+    }
+    ~Profiling() {
+        profile::set_enabled(false);
+        profile::reset();
+    }
+};
+
+LANA_TEST(profile_off_counts_nothing) {
+    profile::set_enabled(false);
+    profile::reset();
+    const Matrix<double> a = lana::test::random_matrix<double>(50, 50, 1);
+    Matrix<double> c(50, 50);
+    lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+    const profile::Snapshot s = profile::snapshot();
+    CHECK(s.kernels.empty());
+    CHECK(s.dropped == 0);
+}
+
+LANA_TEST(profile_counts_gemm_by_dtype_and_size) {
+    const Profiling on;
+    const Matrix<double> a = lana::test::random_matrix<double>(100, 40, 2);
+    const Matrix<double> b = lana::test::random_matrix<double>(40, 60, 3);
+    Matrix<double> c(100, 60);
+    for (int i = 0; i < 3; ++i) {
+        lana::gemm(1.0, a.view(), b.view(), i == 0 ? 0.0 : 1.0, c.view());
+    }
+    const Matrix<float> f = lana::test::random_matrix<float>(10, 10, 4);
+    Matrix<float> g(10, 10);
+    lana::gemm(1.0f, f.view(), f.view(), 0.0f, g.view());
+
+    const profile::Snapshot s = profile::snapshot();
+    const profile::KernelCounters* d = find(s, "gemm", profile::Dtype::f64, 100);
+    CHECK(d != nullptr);
+    if (d != nullptr) {
+        CHECK(d->calls == 3);
+        CHECK(d->size_lo == 64 && d->size_hi == 127);
+        CHECK(d->flops == 3 * 2.0 * 100 * 60 * 40);
+        // A and B each call, C written once and read twice.
+        CHECK(d->bytes == 8.0 * (3 * (100 * 40 + 40 * 60) + (1 + 2 + 2) * 100 * 60));
+        CHECK(d->seconds > 0);
+    }
+    const profile::KernelCounters* sf = find(s, "gemm", profile::Dtype::f32, 10);
+    CHECK(sf != nullptr && sf->calls == 1 && sf->size_lo == 8 && sf->size_hi == 15);
+
+    // Sorted by kernel, dtype, then size.
+    for (std::size_t i = 1; i < s.kernels.size(); ++i) {
+        const auto& x = s.kernels[i - 1];
+        const auto& y = s.kernels[i];
+        CHECK(std::tie(x.kernel, x.dtype, x.size_lo) < std::tie(y.kernel, y.dtype, y.size_lo));
+    }
+
+    profile::reset();
+    CHECK(profile::snapshot().kernels.empty());
+}
+
+LANA_TEST(profile_counts_vector_kernels_and_factorizations) {
+    const Profiling on;
+    const lana::Vector<float> x = lana::test::random_vector<float>(1000, 5);
+    const lana::Vector<float> y = lana::test::random_vector<float>(1000, 6);
+    volatile float sink = lana::dot(x.view(), y.view());
+    (void)sink;
+    Matrix<double> a = lana::test::random_spd<double>(200, 7);
+    CHECK(lana::potrf(a.view()) == 0);
+
+    const profile::Snapshot s = profile::snapshot();
+    const profile::KernelCounters* dot = find(s, "dot", profile::Dtype::f32, 1000);
+    CHECK(dot != nullptr && dot->calls == 1 && dot->flops == 2000 && dot->size_lo == 512);
+    const profile::KernelCounters* chol = find(s, "potrf", profile::Dtype::f64, 200);
+    CHECK(chol != nullptr && chol->calls == 1 && chol->flops > 0);
+    CHECK(find(s, "getrf", profile::Dtype::f64, 200) == nullptr);
+}
+
+LANA_TEST(profile_sums_every_thread) {
+    const Profiling on;
+    const lana::Vector<double> x = lana::test::random_vector<double>(300, 8);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t) {
+        threads.emplace_back([&x] {
+            for (int i = 0; i < 5; ++i) {
+                volatile double d = lana::nrm2(x.view());
+                (void)d;
+            }
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    // The threads have exited; their counts are kept.
+    const profile::KernelCounters* c = find(profile::snapshot(), "nrm2", profile::Dtype::f64, 300);
+    CHECK(c != nullptr && c->calls == 15);
+}
+
+LANA_TEST(profile_counts_pool_work) {
+    const Profiling on;
+    std::atomic<int> calls{0};
+    lana::detail::parallel_run(64, [&](index_t) { calls.fetch_add(1, std::memory_order_relaxed); });
+    CHECK(calls.load() == 64);
+    const profile::PoolCounters p = profile::snapshot().pool;
+    if (lana::detail::parallel_concurrency() > 1) {
+        CHECK(p.regions >= 1);
+        CHECK(p.tasks >= 1);
+        CHECK(p.pushes >= 1 && p.depth_max >= 1);
+        CHECK(p.depth_sum >= p.depth_max);
+    } else {
+        CHECK(p.regions == 0);
+    }
+}
+
+struct Marks {
+    std::atomic<int> begins{0};
+    std::atomic<int> ends{0};
+    std::atomic<int> gemm{0};
+};
+
+LANA_TEST(profile_marker_hooks_bracket_counted_calls) {
+    Marks marks;
+    profile::MarkerHooks hooks;
+    hooks.begin = [](const char* kernel, void* user) {
+        auto* m = static_cast<Marks*>(user);
+        m->begins.fetch_add(1);
+        if (std::strcmp(kernel, "gemm") == 0) {
+            m->gemm.fetch_add(1);
+        }
+    };
+    hooks.end = [](const char*, void* user) { static_cast<Marks*>(user)->ends.fetch_add(1); };
+    hooks.user = &marks;
+    profile::set_marker_hooks(hooks);
+
+    const Matrix<double> a = lana::test::random_matrix<double>(30, 30, 9);
+    Matrix<double> c(30, 30);
+    // Off: no markers either.
+    lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+    CHECK(marks.begins.load() == 0);
+    {
+        const Profiling on;
+        lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+        lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+        CHECK(marks.gemm.load() == 2);
+        CHECK(marks.begins.load() == marks.ends.load());
+
+        // A begin hook alone is allowed.
+        hooks.end = nullptr;
+        profile::set_marker_hooks(hooks);
+        lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+        CHECK(marks.gemm.load() == 3);
+
+        profile::set_marker_hooks(profile::MarkerHooks{});
+        lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+        CHECK(marks.gemm.load() == 3);
+    }
+}
+
+LANA_TEST(profile_report_lists_every_counter) {
+    const Profiling on;
+    const Matrix<double> a = lana::test::random_matrix<double>(20, 20, 10);
+    Matrix<double> c(20, 20);
+    lana::gemm(1.0, a.view(), a.view(), 0.0, c.view());
+    std::ostringstream os;
+    profile::write_report(os, profile::snapshot());
+    std::istringstream in(os.str());
+    std::string header;
+    std::getline(in, header);
+    CHECK(header.find("kernel") == 0 && header.find("bytes_per_flop") != std::string::npos);
+    bool found = false;
+    std::string line;
+    std::string last;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string kernel;
+        std::string dtype;
+        std::int64_t lo = 0;
+        std::int64_t hi = 0;
+        std::uint64_t calls = 0;
+        if (fields >> kernel >> dtype >> lo >> hi >> calls && kernel == "gemm" && dtype == "f64") {
+            found = lo == 16 && hi == 31 && calls == 1;
+        }
+        last = line;
+    }
+    CHECK(found);
+    CHECK(last.find("pool regions=") == 0);
+    CHECK(os.str().find("dropped=") == std::string::npos);
+
+    CHECK(std::string(profile::dtype_name(profile::Dtype::bf16)) == "bf16");
+    CHECK(profile::dtype_of<double>() == profile::Dtype::f64);
+    CHECK(profile::dtype_of<lana::half>() == profile::Dtype::f16);
+    CHECK(profile::dtype_of<int>() == profile::Dtype::other);
+}
+
+// Last: this fills one thread's table, which outlives the thread and is
+// handed to the next thread started.
+LANA_TEST(profile_full_table_drops_and_counts_the_rest) {
+    const Profiling on;
+    CHECK(profile::detail::kernel_id("gemm") == profile::detail::kernel_id("gemm"));
+    CHECK(profile::detail::kernel_id("gemm") != profile::detail::kernel_id("dot"));
+    const char* names[] = {"axpy", "dot", "gemm", "getrf", "nrm2", "potrf", "spmv", "trsm"};
+    std::thread([&names] {
+        for (const char* name : names) {
+            const int id = profile::detail::kernel_id(name);
+            for (profile::Dtype d : {profile::Dtype::f32, profile::Dtype::f64, profile::Dtype::bf16}) {
+                for (int b = 0; b < 48; ++b) {
+                    profile::detail::record(id, d, std::int64_t{1} << b, 1.0, 1.0, std::chrono::nanoseconds(1));
+                }
+            }
+        }
+    }).join();
+    // 8 * 3 * 48 = 1152 keys for 1024 slots, fewer if the table was reused
+    // and holds other keys: each call is either counted or dropped.
+    const profile::Snapshot s = profile::snapshot();
+    CHECK(s.dropped >= 1152 - 1024);
+    CHECK(s.kernels.size() + s.dropped == 1152);
+}
+
+}  // namespace
@@ -0,0 +1,361 @@
+// SolveQueue: requests of any width and layout are solved in place, the
+// batches they are grouped into follow the window, max_batch and flush(),
+// whatever is queued is solved before the queue goes away, a solver's
+// exception reaches every request of its batch, and many threads
+// submitting at once all get their own solution.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/factor_cache.hpp"
+#include "lana/solve_queue.hpp"
+#include "lana/sparse.hpp"
+#include "lana/sparse_factor.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+using lana::SolveQueue;
+using lana::SolveQueueOptions;
+using Future = lana::async::Future<void>;
+
+/// max |A X - B| / (max|A| max|X| n).
+template <typename T>
+double residual(MatrixView<const T> a, MatrixView<const T> x, MatrixView<const T> b) {
+    Matrix<T> r(b);
+    lana::test::reference_gemm<T>(1.0, a, x, -1.0, r.view());
+    const double scale = lana::test::max_abs(a) * lana::test::max_abs(x) * double(a.cols()) + 1e-300;
+    return lana::test::max_abs<T>(r.view()) / scale;
+}
+
+template <typename T>
+Matrix<T> dominant(index_t n, std::uint64_t seed) {
+    Matrix<T> a = lana::test::random_matrix<T>(n, n, seed);
+    for (index_t i = 0; i < n; ++i) {
+        a(i, i) += T(n);
+    }
+    return a;
+}
+
+/// A never-ready window, so that only max_batch, flush() or the
+/// destructor send a batch off.
+SolveQueueOptions held(index_t max_batch) {
+    SolveQueueOptions o;
+    o.window = std::chrono::minutes(10);
+    o.max_batch = max_batch;
+    return o;
+}
+
+/// Solves by halving (A = 2 I), remembering the width and storage of
+/// every call, and throws on a NaN in the first row.
+struct Recorder {
+    index_t n;
+    mutable std::mutex mutex;
+    mutable std::vector<index_t> widths;
+    mutable const double* last = nullptr;
+
+    index_t rows() const noexcept { return n; }
+    void solve(MatrixView<double> b) const {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            widths.push_back(b.cols());
+            last = b.data();
+        }
+        for (index_t j = 0; j < b.cols(); ++j) {
+            if (b(0, j) != b(0, j)) {
+                throw lana::Error("recorder: NaN");
+            }
+            for (index_t i = 0; i < b.rows(); ++i) {
+                b(i, j) *= 0.5;
+            }
+        }
+    }
+    std::vector<index_t> calls() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return widths;
+    }
+};
+
+template <typename T>
+void layouts() {
+    const index_t n = 50;
+    const Matrix<T> a = dominant<T>(n, 1);
+    lana::FactorCache cache;
+    SolveQueue<T> queue(cache.lu(a.view()), held(256));
+    CHECK(queue.rows() == n);
+
+    // Contiguous, a block of a larger matrix, row-major, and vectors with
+    // unit and non-unit stride.
+    const Matrix<T> b = lana::test::random_matrix<T>(n, 3, 2);
+    Matrix<T> x = b;
+    Matrix<T> big = lana::test::random_matrix<T>(n + 9, 11, 3);
+    big.block(4, 5, n, 3).assign(b.view());
+    Matrix<T> bt(b.view().t());
+    const lana::Vector<T> v0 = lana::test::random_vector<T>(n, 4);
+    lana::Vector<T> v = v0;
+    Matrix<T> rows(3, n);
+    for (index_t i = 0; i < n; ++i) {
+        rows(1, i) = v0[i];
+    }
+    const lana::VectorView<T> strided(&rows(1, 0), n, rows.view().col_stride());
+    std::vector<Future> done = {queue.submit(x.view()), queue.submit(big.block(4, 5, n, 3)),
+                                queue.submit(bt.view().t()), queue.submit(v.view()), queue.submit(strided)};
+    queue.flush();
+    for (const Future& f : done) {
+        f.get();
+        CHECK(f.ready());
+    }
+    CHECK_LE(residual<T>(a.view(), x.view(), b.view()), lana::test::tolerance<T>(n));
+    const double same = lana::test::tolerance<T>(n) * lana::test::max_abs<T>(x.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(big.block(4, 5, n, 3), x.view()), same);
+    CHECK_LE(lana::test::max_abs_diff<T>(bt.view().t(), x.view()), same);
+    Matrix<T> vm(n, 1), vb(n, 1), sm(n, 1);
+    for (index_t i = 0; i < n; ++i) {
+        vm(i, 0) = v[i];
+        vb(i, 0) = v0[i];
+        sm(i, 0) = strided[i];
+    }
+    CHECK_LE(residual<T>(a.view(), vm.view(), vb.view()), lana::test::tolerance<T>(n));
+    CHECK_LE(lana::test::max_abs_diff<T>(sm.view(), vm.view()),
+             lana::test::tolerance<T>(n) * lana::test::max_abs<T>(vm.view()));
+    // The rows around the strided one are untouched.
+    CHECK(rows(0, 0) == T(0) && rows(2, n - 1) == T(0));
+
+    const lana::SolveQueueStats st = queue.stats();
+    CHECK(st.requests == 5 && st.columns == 11 && st.batches == 1 && st.largest_batch == 11);
+    Matrix<T> wrong(n + 1, 2);
+    CHECK_THROWS(queue.submit(wrong.view()), lana::DimensionError);
+    CHECK(queue.stats().requests == 5);
+}
+
+LANA_TEST(solve_queue_f32_layouts) { layouts<float>(); }
+LANA_TEST(solve_queue_f64_layouts) { layouts<double>(); }
+
+LANA_TEST(solve_queue_batches_until_flush) {
+    const auto rec = std::make_shared<Recorder>();
+    rec->n = 6;
+    SolveQueue<double> queue(std::shared_ptr<const Recorder>(rec), held(100));
+    std::vector<Matrix<double>> bs;
+    for (index_t w : {1, 2, 3, 1}) {
+        bs.push_back(lana::test::random_matrix<double>(6, w, std::uint64_t(w)));
+    }
+    const std::vector<Matrix<double>> before = bs;
+    std::vector<Future> done;
+    for (Matrix<double>& b : bs) {
+        done.push_back(queue.submit(b.view()));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(rec->calls().empty() && !done.front().ready());
+    queue.flush();
+    for (const Future& f : done) {
+        f.get();
+    }
+    // One call with all seven columns, each copied back where it came from.
+    CHECK(rec->calls() == std::vector<index_t>{7});
+    for (std::size_t r = 0; r < bs.size(); ++r) {
+        Matrix<double> half = before[r];
+        for (index_t j = 0; j < half.cols(); ++j) {
+            for (index_t i = 0; i < 6; ++i) {
+                half(i, j) *= 0.5;
+            }
+        }
+        CHECK(lana::test::max_abs_diff<double>(bs[r].view(), half.view()) == 0);
+    }
+    const lana::SolveQueueStats st = queue.stats();
+    CHECK(st.requests == 4 && st.batches == 1 && st.columns == 7 && st.largest_batch == 7);
+
+    // A lone request is solved in place, without a gathering copy.
+    Matrix<double> one = lana::test::random_matrix<double>(6, 2, 9);
+    const double first = one(0, 0);
+    Future f = queue.submit(one.view());
+    queue.flush();
+    f.get();
+    CHECK(rec->calls().size() == 2 && rec->calls().back() == 2 && rec->last == one.data());
+    CHECK(one(0, 0) == 0.5 * first);
+}
+
+LANA_TEST(solve_queue_max_batch_sends_early) {
+    const auto rec = std::make_shared<Recorder>();
+    rec->n = 4;
+    SolveQueue<double> queue(std::shared_ptr<const Recorder>(rec), held(4));
+    const auto start = std::chrono::steady_clock::now();
+
+    // Four columns fill a batch: no flush needed.
+    std::vector<Matrix<double>> bs(4, Matrix<double>(4, 1));
+    std::vector<Future> done;
+    for (Matrix<double>& b : bs) {
+        done.push_back(queue.submit(b.view()));
+    }
+    for (const Future& f : done) {
+        f.get();
+    }
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::minutes(5));
+    CHECK(rec->calls() == std::vector<index_t>{4});
+
+    // 3 + 3 columns: the first three go, and the other three, now short
+    // of max_batch, wait for flush().
+    Matrix<double> p(4, 3), q(4, 3), wide(4, 9);
+    Future fp = queue.submit(p.view());
+    Future fq = queue.submit(q.view());
+    fp.get();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    CHECK(!fq.ready());
+    queue.flush();
+    fq.get();
+    // A request wider than max_batch goes at once, on its own.
+    queue.submit(wide.view()).get();
+    const std::vector<index_t> calls = rec->calls();
+    CHECK(calls.size() == 4 && calls[1] == 3 && calls[2] == 3 && calls[3] == 9);
+    const lana::SolveQueueStats st = queue.stats();
+    CHECK(st.batches == 4 && st.columns == 19 && st.largest_batch == 9);
+}
+
+LANA_TEST(solve_queue_idle_flush_does_not_latch) {
+    // A flush() with nothing queued must not send the next request off on
+    // its own: the two below, 20 ms apart, still share one window.
+    const auto rec = std::make_shared<Recorder>();
+    rec->n = 3;
+    SolveQueueOptions o;
+    o.window = std::chrono::milliseconds(500);
+    SolveQueue<double> queue(std::shared_ptr<const Recorder>(rec), o);
+    queue.flush();
+    Matrix<double> p(3, 1), q(3, 1);
+    Future fp = queue.submit(p.view());
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    Future fq = queue.submit(q.view());
+    fp.get();
+    fq.get();
+    CHECK(rec->calls() == std::vector<index_t>{2});
+}
+
+LANA_TEST(solve_queue_window_bounds_latency) {
+    const auto rec = std::make_shared<Recorder>();
+    rec->n = 3;
+    SolveQueueOptions o;
+    o.window = std::chrono::milliseconds(5);
+    SolveQueue<double> queue(std::shared_ptr<const Recorder>(rec), o);
+    Matrix<double> b(3, 1);
+    b(2, 0) = 4;
+    queue.submit(b.view()).get();
+    CHECK(b(2, 0) == 2 && rec->calls().size() == 1);
+    // A negative window is no window at all.
+    o.window = std::chrono::microseconds(-1);
+    SolveQueue<double> eager(std::shared_ptr<const Recorder>(rec), o);
+    eager.submit(b.view()).get();
+    CHECK(b(2, 0) == 1);
+}
+
+LANA_TEST(solve_queue_drains_on_destruction) {
+    const auto rec = std::make_shared<Recorder>();
+    rec->n = 5;
+    std::vector<Matrix<double>> bs(3, Matrix<double>(5, 2));
+    for (Matrix<double>& b : bs) {
+        b(4, 1) = 8;
+    }
+    std::vector<Future> done;
+    {
+        SolveQueue<double> queue(std::shared_ptr<const Recorder>(rec), held(100));
+        for (Matrix<double>& b : bs) {
+            done.push_back(queue.submit(b.view()));
+        }
+    }
+    for (std::size_t r = 0; r < bs.size(); ++r) {
+        CHECK(done[r].ready());
+        done[r].get();
+        CHECK(bs[r](4, 1) == 4);
+    }
+    CHECK(rec->calls() == std::vector<index_t>{6});
+    // The queue held its own reference to the solver.
+    CHECK(rec.use_count() == 1);
+}
+
+LANA_TEST(solve_queue_errors_reach_the_batch) {
+    const auto rec = std::make_shared<Recorder>();
+    rec->n = 2;
+    SolveQueue<double> queue(std::shared_ptr<const Recorder>(rec), held(100));
+    Matrix<double> good(2, 1), bad(2, 1);
+    bad(0, 0) = std::numeric_limits<double>::quiet_NaN();
+    Future fg = queue.submit(good.view());
+    Future fb = queue.submit(bad.view());
+    queue.flush();
+    CHECK_THROWS(fg.get(), lana::Error);
+    CHECK_THROWS(fb.get(), lana::Error);
+    // The queue carries on with the next batch.
+    good(1, 0) = 6;
+    Future again = queue.submit(good.view());
+    queue.flush();
+    again.get();
+    CHECK(good(1, 0) == 3);
+}
+
+LANA_TEST(solve_queue_every_solver) {
+    const index_t n = 40;
+    const Matrix<double> s = lana::test::random_spd<double>(n, 11);
+    const Matrix<double> a = dominant<double>(n, 12);
+    const lana::Csr<double> ss = lana::Csr<double>::from_dense(s.view());
+    const lana::Csr<double> as = lana::Csr<double>::from_dense(a.view());
+    lana::FactorCache cache;
+    const auto check = [&](auto solver, const Matrix<double>& m) {
+        SolveQueue<double> queue(solver);
+        const Matrix<double> b = lana::test::random_matrix<double>(n, 2, 13);
+        Matrix<double> x = b, y = b;
+        Future fx = queue.submit(x.view());
+        Future fy = queue.submit(y.view().col(1));
+        queue.flush();
+        fx.get();
+        fy.get();
+        CHECK_LE(residual<double>(m.view(), x.view(), b.view()), 10 * lana::test::tolerance<double>(n));
+        CHECK_LE(lana::test::max_abs_diff<double>(y.view().col(1), x.view().col(1)),
+                 10 * lana::test::tolerance<double>(n) * lana::test::max_abs<double>(x.view()));
+    };
+    check(cache.cholesky(s.view()), s);
+    check(cache.lu(a.view()), a);
+    check(cache.sparse_cholesky(ss.view()), s);
+    check(cache.sparse_lu(as.view()), a);
+}
+
+LANA_TEST(solve_queue_concurrent_submitters) {
+    const index_t n = 60;
+    const Matrix<double> a = dominant<double>(n, 14);
+    SolveQueueOptions o;
+    o.window = std::chrono::microseconds(200);
+    o.max_batch = 16;
+    SolveQueue<double> queue(std::make_shared<const lana::LuFactor<double>>(a.view()), o);
+    constexpr int threads = 8, rounds = 20;
+    std::vector<int> bad(threads, 0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; ++t) {
+        pool.emplace_back([&, t] {
+            for (int r = 0; r < rounds; ++r) {
+                const Matrix<double> b = lana::test::random_matrix<double>(n, 1, std::uint64_t(t * rounds + r));
+                Matrix<double> x = b;
+                queue.submit(x.view()).get();
+                bad[static_cast<std::size_t>(t)] +=
+                    residual<double>(a.view(), x.view(), b.view()) > lana::test::tolerance<double>(n);
+            }
+        });
+    }
+    for (std::thread& th : pool) {
+        th.join();
+    }
+    int failures = 0;
+    for (int b : bad) {
+        failures += b;
+    }
+    CHECK(failures == 0);
+    const lana::SolveQueueStats st = queue.stats();
+    CHECK(st.requests == std::uint64_t(threads * rounds) && st.columns == std::uint64_t(threads * rounds));
+    CHECK(st.batches >= 1 && st.batches <= st.requests && st.largest_batch <= 16);
+}
+
+}  // namespace
@@ -0,0 +1,217 @@
+// Sparse formats and products: conversions between COO, CSR, CSC and BSR
+// preserve the matrix, malformed arrays are rejected, and every spmv and
+// spmm path matches a dense reference product under each kernel ISA.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/sparse.hpp"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace {
+
+using lana::Csc;
+using lana::Csr;
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+using lana::sparse_index_t;
+
+/// About a tenth of the entries nonzero, plus a few awkward rows: row 0
+/// completely dense (one row holding most of the work), rows 1 and the
+/// last empty.
+template <typename T>
+Matrix<T> sparse_dense(index_t rows, index_t cols, std::uint64_t seed) {
+    lana::test::Rng rng(seed);
+    Matrix<T> a(rows, cols);
+    for (index_t j = 0; j < cols; ++j) {
+        for (index_t i = 0; i < rows; ++i) {
+            const double r = rng.next();
+            if (i == 0 || (i != 1 && i != rows - 1 && std::abs(r) < 0.1)) {
+                a(i, j) = static_cast<T>(rng.next());
+            }
+        }
+    }
+    return a;
+}
+
+template <typename T>
+bool same(MatrixView<const T> a, MatrixView<const T> b) {
+    return a.rows() == b.rows() && a.cols() == b.cols() && lana::test::max_abs_diff<T>(a, b) == 0;
+}
+
+LANA_TEST(sparse_coo_sums_duplicates_and_sorts) {
+    lana::Coo<double> coo(3, 4);
+    coo.add(2, 3, 1.0);
+    coo.add(0, 1, 2.0);
+    coo.add(2, 0, 3.0);
+    coo.add(0, 1, 0.5);  // duplicate
+    coo.add(1, 2, 4.0);
+    coo.add(2, 3, -1.0);  // duplicate summing to an explicit zero
+    CHECK(coo.nnz() == 6);
+    CHECK_THROWS(coo.add(3, 0, 1.0), lana::DimensionError);
+    CHECK_THROWS(coo.add(0, -1, 1.0), lana::DimensionError);
+
+    const Csr<double> csr(coo);
+    CHECK(csr.nnz() == 4);
+    CHECK((csr.row_ptr() == std::vector<index_t>{0, 1, 2, 4}));
+    CHECK((csr.col_idx() == std::vector<sparse_index_t>{1, 2, 0, 3}));
+    CHECK((csr.values() == std::vector<double>{2.5, 4.0, 3.0, 0.0}));
+
+    const Csc<double> csc(coo);
+    CHECK(csc.nnz() == 4);
+    CHECK((csc.col_ptr() == std::vector<index_t>{0, 1, 2, 3, 4}));
+    CHECK((csc.row_idx() == std::vector<sparse_index_t>{2, 0, 1, 2}));
+    CHECK(same<double>(csr.to_dense().view(), csc.to_dense().view()));
+}
+
+LANA_TEST(sparse_conversions_round_trip) {
+    const Matrix<double> d = sparse_dense<double>(57, 43, 1);
+    const Csr<double> csr = Csr<double>::from_dense(d.view());
+    CHECK(same<double>(csr.to_dense().view(), d.view()));
+
+    const Csc<double> csc(csr);
+    CHECK(same<double>(csc.to_dense().view(), d.view()));
+    const Csr<double> back(csc);
+    CHECK(back.row_ptr() == csr.row_ptr() && back.col_idx() == csr.col_idx() && back.values() == csr.values());
+
+    const Csr<double> t = csr.transpose();
+    CHECK(t.rows() == 43 && t.cols() == 57);
+    CHECK(same<double>(t.to_dense().view(), Matrix<double>(d.view().t()).view()));
+    const Csr<double> tt = t.transpose();
+    CHECK(tt.col_idx() == csr.col_idx() && tt.values() == csr.values());
+
+    // A view of the arrays copies back to the same matrix.
+    const Csr<double> copy(csr.view());
+    CHECK(copy.nnz() == csr.nnz() && copy.row_ptr() == csr.row_ptr());
+
+    const lana::Bsr<double> bsr(csr.transpose().transpose(), 1, 1);
+    CHECK(same<double>(bsr.to_dense().view(), d.view()));
+}
+
+LANA_TEST(sparse_bsr_groups_blocks) {
+    const Matrix<float> d = sparse_dense<float>(48, 36, 2);
+    const Csr<float> csr = Csr<float>::from_dense(d.view());
+    for (const auto& [br, bc] : {std::pair<index_t, index_t>{2, 2}, {3, 4}, {4, 3}, {6, 6}}) {
+        const lana::Bsr<float> bsr(csr, br, bc);
+        CHECK(bsr.block_row_count() == 48 / br);
+        CHECK(same<float>(bsr.to_dense().view(), d.view()));
+        // Every block holds at least one nonzero of the source.
+        index_t nonempty = 0;
+        for (index_t s = 0; s < bsr.nnz_blocks(); ++s) {
+            nonempty += lana::test::max_abs<float>(bsr.block(s)) > 0 ? 1 : 0;
+        }
+        CHECK(nonempty == bsr.nnz_blocks());
+    }
+    CHECK_THROWS(lana::Bsr<float>(csr, 5, 4), lana::DimensionError);
+    CHECK_THROWS(lana::Bsr<float>(csr, 0, 4), lana::DimensionError);
+}
+
+LANA_TEST(sparse_rejects_malformed_arrays) {
+    using V = std::vector<double>;
+    using I = std::vector<sparse_index_t>;
+    using P = std::vector<index_t>;
+    CHECK(Csr<double>(2, 3, P{0, 1, 2}, I{2, 0}, V{1, 2}).nnz() == 2);
+    CHECK_THROWS(Csr<double>(2, 3, P{0, 2, 2}, I{2, 0}, V{1, 2}), lana::Error);  // unsorted row
+    CHECK_THROWS(Csr<double>(2, 3, P{0, 2, 2}, I{1, 1}, V{1, 2}), lana::Error);  // duplicate
+    CHECK_THROWS(Csr<double>(2, 3, P{0, 1, 2}, I{3, 0}, V{1, 2}), lana::Error);  // column out of range
+    CHECK_THROWS(Csr<double>(2, 3, P{0, 2, 1}, I{0, 1}, V{1, 2}), lana::Error);  // decreasing row_ptr
+    CHECK_THROWS(Csr<double>(2, 3, P{0, 1}, I{0}, V{1}), lana::Error);           // short row_ptr
+    CHECK_THROWS(Csr<double>(2, 3, P{0, 1, 2}, I{0, 1}, V{1}), lana::Error);     // short values
+    CHECK_THROWS(Csc<double>(3, 2, P{0, 2, 2}, I{2, 0}, V{1, 2}), lana::Error);
+    const index_t too_big = index_t(std::numeric_limits<sparse_index_t>::max()) + 1;
+    CHECK_THROWS(lana::Coo<double>(too_big, 1), lana::DimensionError);
+}
+
+template <typename T>
+void spmv_paths() {
+    const index_t m = 96;
+    const index_t n = 72;
+    const Matrix<T> d = sparse_dense<T>(m, n, 3);
+    const Csr<T> csr = Csr<T>::from_dense(d.view());
+    const Csc<T> csc(csr);
+    const lana::Bsr<T> bsr(csr, 4, 3);
+    const Matrix<T> x = lana::test::random_matrix<T>(n, 1, 4);
+    const Matrix<T> y0 = lana::test::random_matrix<T>(m, 1, 5);
+    const double tol = lana::test::tolerance<T>(n);
+
+    for (const auto& [alpha, beta] : {std::pair<T, T>{1, 0}, {T(-0.5), T(2)}, {0, 1}}) {
+        Matrix<T> ref = y0;
+        lana::test::reference_gemm<T>(double(alpha), d.view(), x.view(), double(beta), ref.view());
+        for (int path = 0; path < 3; ++path) {
+            Matrix<T> y = y0;
+            if (beta == 0) {
+                y.fill(std::numeric_limits<T>::quiet_NaN());  // beta == 0 must not read y
+            }
+            const lana::VectorView<const T> xv(x.data(), n);
+            const lana::VectorView<T> yv(y.data(), m);
+            if (path == 0) {
+                lana::spmv(alpha, csr, xv, beta, yv);
+            } else if (path == 1) {
+                lana::spmv(alpha, csc, xv, beta, yv);
+            } else {
+                lana::spmv(alpha, bsr, xv, beta, yv);
+            }
+            CHECK_LE(lana::test::max_abs_diff<T>(y.view(), ref.view()), tol);
+        }
+    }
+
+    // Strided x and y: every second and every third element of longer arrays.
+    std::vector<T> xs(2 * n, T(7));
+    std::vector<T> ys(3 * m, T(0));
+    for (index_t i = 0; i < n; ++i) {
+        xs[2 * i] = x(i, 0);
+    }
+    lana::spmv(T(1), csr, lana::VectorView<const T>(xs.data(), n, 2), T(0), lana::VectorView<T>(ys.data(), m, 3));
+    Matrix<T> ref(m, 1);
+    lana::test::reference_gemm<T>(1.0, d.view(), x.view(), 0.0, ref.view());
+    for (index_t i = 0; i < m; ++i) {
+        CHECK_NEAR(ys[3 * i], ref(i, 0), tol);
+        CHECK(ys[3 * i + 1] == 0 && ys[3 * i + 2] == 0);
+    }
+
+    const lana::VectorView<const T> x_long(xs.data(), n + 1);
+    CHECK_THROWS(lana::spmv(T(1), csr, x_long, T(0), lana::VectorView<T>(ys.data(), m)), lana::DimensionError);
+}
+
+LANA_TEST(sparse_f32_spmv) { spmv_paths<float>(); }
+LANA_TEST(sparse_f64_spmv) { spmv_paths<double>(); }
+
+template <typename T>
+void spmm_paths() {
+    const index_t m = 64;
+    const index_t n = 48;
+    const index_t k = 11;
+    const Matrix<T> d = sparse_dense<T>(m, n, 6);
+    const Csr<T> csr = Csr<T>::from_dense(d.view());
+    const lana::Bsr<T> bsr(csr, 4, 4);
+    const double tol = lana::test::tolerance<T>(n);
+
+    // B stored transposed and C a block of a larger matrix.
+    const Matrix<T> bt = lana::test::random_matrix<T>(k, n, 7);
+    const MatrixView<const T> b = bt.view().t();
+    const Matrix<T> b_dense(b);
+    const Matrix<T> c0 = lana::test::random_matrix<T>(m + 5, k + 3, 8);
+    Matrix<T> ref = c0;
+    lana::test::reference_gemm<T>(2.0, d.view(), b_dense.view(), -1.0, ref.block(2, 1, m, k));
+    for (int path = 0; path < 2; ++path) {
+        Matrix<T> c = c0;
+        if (path == 0) {
+            lana::spmm(T(2), csr, b, T(-1), c.block(2, 1, m, k));
+        } else {
+            lana::spmm(T(2), bsr, b, T(-1), c.block(2, 1, m, k));
+        }
+        CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), tol);
+    }
+
+    Matrix<T> wrong(m, k + 1);
+    CHECK_THROWS(lana::spmm(T(1), csr, b, T(0), wrong.view()), lana::DimensionError);
+}
+
+LANA_TEST(sparse_f32_spmm) { spmm_paths<float>(); }
+LANA_TEST(sparse_f64_spmm) { spmm_paths<double>(); }
+
+}  // namespace
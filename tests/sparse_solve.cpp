@@ -0,0 +1,215 @@
+// Sparse direct and iterative solvers by their true residuals on model
+// problems: 2-D Poisson (symmetric positive definite), convection-diffusion
+// (nonsymmetric) and a permuted matrix with a zero diagonal, which needs
+// SparseLu's column matching.
+
+#include "check.hpp"
+
+#include "lana/factor_cache.hpp"
+#include "lana/krylov.hpp"
+#include "lana/sparse.hpp"
+#include "lana/sparse_factor.hpp"
+
+namespace {
+
+using lana::Coo;
+using lana::Csr;
+using lana::index_t;
+using lana::Matrix;
+using lana::Vector;
+using lana::VectorView;
+using lana::krylov::Options;
+using lana::krylov::Result;
+
+/// 5-point stencil on a g x g grid; `wind` adds a first-order convection
+/// term that makes the matrix nonsymmetric.
+Csr<double> grid(index_t g, double wind = 0) {
+    Coo<double> coo(g * g, g * g);
+    for (index_t y = 0; y < g; ++y) {
+        for (index_t x = 0; x < g; ++x) {
+            const index_t i = y * g + x;
+            coo.add(i, i, 4);
+            if (x > 0) coo.add(i, i - 1, -1 - wind);
+            if (x + 1 < g) coo.add(i, i + 1, -1 + wind);
+            if (y > 0) coo.add(i, i - g, -1);
+            if (y + 1 < g) coo.add(i, i + g, -1);
+        }
+    }
+    return Csr<double>(coo);
+}
+
+/// max |b - A x| / (max|b|).
+double relative_residual(const Csr<double>& a, const Vector<double>& b, const Vector<double>& x) {
+    Vector<double> r = b;
+    lana::spmv(-1.0, a.view(), VectorView<const double>(x.view()), 1.0, r.view());
+    double rn = 0, bn = 0;
+    for (index_t i = 0; i < b.size(); ++i) {
+        rn = std::max(rn, std::abs(r[i]));
+        bn = std::max(bn, std::abs(b[i]));
+    }
+    return rn / bn;
+}
+
+constexpr lana::Ordering orderings[] = {lana::Ordering::Natural, lana::Ordering::Amd,
+                                        lana::Ordering::NestedDissection};
+
+LANA_TEST(sparse_cholesky_orderings) {
+    const Csr<double> a = grid(23);
+    const Vector<double> b = lana::test::random_vector<double>(a.rows(), 1);
+    for (lana::Ordering ordering : orderings) {
+        lana::SparseCholesky<double> chol(a.view(), ordering);
+        CHECK(static_cast<index_t>(chol.permutation().size()) == a.rows());
+        Vector<double> x = b;
+        chol.solve(x.view());
+        CHECK_LE(relative_residual(a, b, x), 1e-12);
+        // Same pattern, new values.
+        Csr<double> scaled = a;
+        for (index_t k = 0; k < scaled.nnz(); ++k) {
+            scaled.values()[k] *= 3;
+        }
+        chol.refactor(scaled.view());
+        x = b;
+        chol.solve(x.view());
+        CHECK_LE(relative_residual(scaled, b, x), 1e-12);
+    }
+}
+
+LANA_TEST(sparse_cholesky_rejects_indefinite) {
+    Csr<double> a = grid(6);
+    a.values()[0] = -10;
+    CHECK_THROWS(lana::SparseCholesky<double>(a.view()), lana::Error);
+}
+
+LANA_TEST(sparse_lu_orderings) {
+    const Csr<double> a = grid(21, 0.6);
+    const Vector<double> b = lana::test::random_vector<double>(a.rows(), 2);
+    for (lana::Ordering ordering : orderings) {
+        lana::SparseLu<double> lu(a.view(), ordering);
+        CHECK(lu.weak_pivots() == 0);
+        Vector<double> x = b;
+        lu.solve(x.view());
+        CHECK_LE(relative_residual(a, b, x), 1e-12);
+    }
+}
+
+LANA_TEST(sparse_lu_zero_diagonal) {
+    // A cyclic row shift of a nonsymmetric grid: every diagonal entry is
+    // zero, so the factorization only works after the column matching.
+    const Csr<double> g = grid(12, 0.3);
+    const index_t n = g.rows();
+    Coo<double> coo(n, n);
+    for (index_t i = 0; i < n; ++i) {
+        for (index_t k = g.row_ptr()[i]; k < g.row_ptr()[i + 1]; ++k) {
+            coo.add((i + 1) % n, g.col_idx()[k], g.values()[k]);
+        }
+    }
+    const Csr<double> a(coo);
+    const Vector<double> b = lana::test::random_vector<double>(n, 3);
+    lana::SparseLu<double> lu(a.view());
+    Vector<double> x = b;
+    lu.solve(x.view());
+    CHECK_LE(relative_residual(a, b, x), 1e-11);
+}
+
+LANA_TEST(sparse_lu_rejects_structurally_singular) {
+    // Column 1 is empty: structural rank 2, which no pivoting can repair.
+    const Csr<double> empty_column = Csr<double>::from_dense(Matrix<double>{{1, 0, 0}, {1, 0, 0}, {1, 0, 1}}.view());
+    std::vector<lana::sparse_index_t> match(3);
+    CHECK(lana::detail::transversal(empty_column.view(), match.data()) == 2);
+    CHECK(std::count(match.begin(), match.end(), -1) == 1);
+    CHECK_THROWS(lana::SparseLu<double>(empty_column.view()), lana::Error);
+    // Every entry in column 0: structural rank 1.
+    Coo<double> coo(4, 4);
+    for (index_t i = 0; i < 4; ++i) {
+        coo.add(i, 0, double(i + 1));
+    }
+    const Csr<double> one_column(coo);
+    CHECK(lana::detail::transversal(one_column.view(), match.data()) == 1);
+    CHECK_THROWS(lana::SparseLu<double>(one_column.view()), lana::Error);
+    // A full matching, and nothing cached for the singular input.
+    const Csr<double> g = grid(5, 0.2);
+    match.resize(static_cast<std::size_t>(g.rows()));
+    CHECK(lana::detail::transversal(g.view(), match.data()) == g.rows());
+    lana::FactorCache cache;
+    CHECK_THROWS(cache.sparse_lu(empty_column.view()), lana::Error);
+    CHECK(cache.stats().entries == 0);
+}
+
+template <typename M, typename Solve>
+void check_krylov(const Csr<double>& a, const M& m, Solve solve, Options opts = {}) {
+    const Vector<double> b = lana::test::random_vector<double>(a.rows(), 4);
+    Vector<double> x(a.rows());
+    opts.rtol = 1e-10;
+    const Result r = solve(a, VectorView<const double>(b.view()), x.view(), m, opts);
+    CHECK(r.converged);
+    CHECK(r.iterations > 0 && r.iterations <= opts.max_iterations);
+    CHECK_LE(r.residual_norm, 1e-10 * std::sqrt(double(a.rows())) * 2);
+    // The reported residual tracks the true one.
+    CHECK_LE(relative_residual(a, b, x), 1e-8);
+}
+
+const auto cg = [](const auto& a, auto b, auto x, const auto& m, const Options& o) {
+    return lana::krylov::cg(a, b, x, m, o);
+};
+const auto gmres = [](const auto& a, auto b, auto x, const auto& m, const Options& o) {
+    return lana::krylov::gmres(a, b, x, m, o);
+};
+const auto bicgstab = [](const auto& a, auto b, auto x, const auto& m, const Options& o) {
+    return lana::krylov::bicgstab(a, b, x, m, o);
+};
+
+LANA_TEST(krylov_cg_preconditioners) {
+    const Csr<double> a = grid(30);
+    check_krylov(a, lana::krylov::Identity{}, cg);
+    check_krylov(a, lana::krylov::Jacobi<double>(a.view()), cg);
+    check_krylov(a, lana::krylov::Ilu0<double>(a.view()), cg);
+    check_krylov(a, lana::krylov::BlockJacobi<double>(a.view(), 30), cg);
+}
+
+LANA_TEST(krylov_gmres_preconditioners) {
+    const Csr<double> a = grid(30, 0.5);
+    Options restarted;
+    restarted.restart = 10;
+    check_krylov(a, lana::krylov::Identity{}, gmres);
+    check_krylov(a, lana::krylov::Identity{}, gmres, restarted);
+    check_krylov(a, lana::krylov::Ilu0<double>(a.view()), gmres);
+    check_krylov(a, lana::krylov::BlockJacobi<double>(a.view(), 16), gmres);
+}
+
+LANA_TEST(krylov_bicgstab_preconditioners) {
+    const Csr<double> a = grid(30, 0.5);
+    check_krylov(a, lana::krylov::Identity{}, bicgstab);
+    check_krylov(a, lana::krylov::Jacobi<double>(a.view()), bicgstab);
+    check_krylov(a, lana::krylov::Ilu0<double>(a.view()), bicgstab);
+}
+
+LANA_TEST(krylov_iteration_cap) {
+    const Csr<double> a = grid(30);
+    const Vector<double> b = lana::test::random_vector<double>(a.rows(), 5);
+    Vector<double> x(a.rows());
+    Options opts;
+    opts.max_iterations = 3;
+    const Result r = lana::krylov::cg(a, VectorView<const double>(b.view()), x.view(), lana::krylov::Identity{}, opts);
+    CHECK(!r.converged);
+    CHECK(r.iterations == 3);
+}
+
+LANA_TEST(krylov_matrix_free) {
+    // The 1-D Laplacian applied by a lambda instead of a stored matrix.
+    const index_t n = 200;
+    const auto op = lana::make_operator<double>(n, n, [n](VectorView<const double> x, VectorView<double> y) {
+        for (index_t i = 0; i < n; ++i) {
+            y[i] = 2 * x[i] - (i > 0 ? x[i - 1] : 0.0) - (i + 1 < n ? x[i + 1] : 0.0);
+        }
+    });
+    const Vector<double> b(n, 1.0);
+    Vector<double> x(n);
+    const Result r = lana::krylov::cg(op, VectorView<const double>(b.view()), x.view());
+    CHECK(r.converged);
+    // x(i) = (i + 1) * (n - i) / 2 solves it exactly.
+    for (index_t i = 0; i < n; ++i) {
+        CHECK_NEAR(x[i], double(i + 1) * double(n - i) / 2, 1e-5 * double(n * n));
+    }
+}
+
+}  // namespace
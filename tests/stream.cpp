@@ -0,0 +1,242 @@
+// Out-of-core operations: for column- and row-major sections, with one
+// tile or hundreds, through io_uring or the pread thread, each gives what
+// the in-memory operation gives on the same matrix, and bad input is
+// rejected with the documented exception.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/io.hpp"
+#include "lana/stream.hpp"
+
+#include <unistd.h>
+
+#include <cmath>
+#include <filesystem>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+namespace stream = lana::stream;
+
+/// A file in the temp directory, unique per process; removed on scope exit.
+struct TempFile {
+    explicit TempFile(const char* tag)
+        : path((std::filesystem::temp_directory_path() /
+                ("lana_stream_" + std::to_string(::getpid()) + "_" + tag + ".lana"))
+                   .string()) {}
+    ~TempFile() { std::filesystem::remove(path); }
+    std::string path;
+};
+
+/// One tile; a few hundred small ones through io_uring; small ones through
+/// preads with the page cache left alone.
+std::vector<stream::StreamOptions> every_option() {
+    std::vector<stream::StreamOptions> out(3);
+    out[1].tile_bytes = 4096;
+    out[2].tile_bytes = 64 << 10;
+    out[2].io_uring = false;
+    out[2].drop_cache = false;
+    return out;
+}
+
+/// `a` written as section "col" (column-major) and "row" (row-major).
+template <typename T>
+void write_both(const std::string& path, const Matrix<T>& a) {
+    const Matrix<T> at(a.view().t());
+    lana::FileWriter w(path);
+    w.add("col", a.view());
+    w.add("row", at.view().t());
+    w.close();
+}
+
+template <typename T>
+void streamed_gemm() {
+    TempFile file("gemm");
+    const index_t m = 600;
+    const index_t k = 300;
+    const Matrix<T> a = lana::test::random_matrix<T>(m, k, 1);
+    write_both(file.path, a);
+    const Matrix<T> b = lana::test::random_matrix<T>(k, 7, 2);
+    const Matrix<T> bt = lana::test::random_matrix<T>(m, 5, 3);
+    const Matrix<T> c0 = lana::test::random_matrix<T>(m, 7, 4);
+    const Matrix<T> ct0 = lana::test::random_matrix<T>(k, 5, 5);
+
+    Matrix<T> ref = c0;
+    lana::test::reference_gemm<T>(1.5, a.view(), b.view(), -0.5, ref.view());
+    Matrix<T> reft = ct0;
+    lana::test::reference_gemm<T>(2.0, Matrix<T>(a.view().t()).view(), bt.view(), 0.0, reft.view());
+
+    for (const char* section : {"col", "row"}) {
+        const stream::Source src(file.path, section);
+        CHECK(src.rows() == m && src.cols() == k);
+        CHECK(src.info().layout == (section[0] == 'r' ? lana::Layout::RowMajor : lana::Layout::ColMajor));
+        for (const stream::StreamOptions& opts : every_option()) {
+            Matrix<T> c = c0;
+            stream::gemm(lana::Op::NoTrans, T(1.5), src, b.view(), T(-0.5), c.view(), opts);
+            CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(k));
+            Matrix<T> ct = ct0;
+            stream::gemm(lana::Op::Trans, T(2), src, bt.view(), T(0), ct.view(), opts);
+            CHECK_LE(lana::test::max_abs_diff<T>(ct.view(), reft.view()), lana::test::tolerance<T>(m));
+        }
+        // alpha = 0 scales C without reading the file.
+        Matrix<T> c = c0;
+        stream::gemm(lana::Op::NoTrans, T(0), src, b.view(), T(2), c.view());
+        CHECK(c(3, 4) == 2 * c0(3, 4));
+        Matrix<T> wrong(m, 6);
+        CHECK_THROWS(stream::gemm(lana::Op::NoTrans, T(1), src, b.view(), T(0), wrong.view()), lana::DimensionError);
+    }
+}
+
+LANA_TEST(stream_f32_gemm) { streamed_gemm<float>(); }
+LANA_TEST(stream_f64_gemm) { streamed_gemm<double>(); }
+
+template <typename T>
+void streamed_reductions() {
+    TempFile file("reduce");
+    const index_t m = 700;
+    const index_t n = 300;  // above the gram recursion's leaf
+    const Matrix<T> a = lana::test::random_matrix<T>(m, n, 6);
+    write_both(file.path, a);
+    const Matrix<T> c0 = lana::test::random_matrix<T>(n, n, 7);
+    Matrix<T> ref = c0;
+    // C0 is not symmetric: its upper triangle is kept, scaled, as well.
+    lana::test::reference_gemm<T>(0.5, Matrix<T>(a.view().t()).view(), a.view(), 1.0, ref.view());
+    const Matrix<T> ata = lana::test::reference_product<T>(Matrix<T>(a.view().t()).view(), a.view());
+    std::vector<double> sums(static_cast<std::size_t>(n), 0.0);
+    double ss = 0;
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < m; ++i) {
+            sums[static_cast<std::size_t>(j)] += a(i, j);
+            ss += double(a(i, j)) * double(a(i, j));
+        }
+    }
+
+    for (const char* section : {"col", "row"}) {
+        const stream::Source src(file.path, section);
+        for (const stream::StreamOptions& opts : every_option()) {
+            Matrix<T> g = c0;
+            stream::gram(T(0.5), src, T(1), g.view(), opts);
+            CHECK_LE(lana::test::max_abs_diff<T>(g.view(), ref.view()), lana::test::tolerance<T>(m));
+            // beta = 0 overwrites C, NaNs included, with the mirrored product.
+            Matrix<T> g0(n, n, std::numeric_limits<T>::quiet_NaN());
+            stream::gram(T(1), src, T(0), g0.view(), opts);
+            CHECK_LE(lana::test::max_abs_diff<T>(g0.view(), ata.view()), lana::test::tolerance<T>(m));
+            CHECK(g0(10, 200) == g0(200, 10));
+
+            lana::Vector<T> s(n);
+            stream::column_sums(src, s.view(), opts);
+            for (index_t j = 0; j < n; ++j) {
+                CHECK_NEAR(s[j], sums[static_cast<std::size_t>(j)], lana::test::tolerance<T>(m));
+            }
+            CHECK_NEAR(stream::frobenius_norm(src, opts), std::sqrt(ss), 1e-10);
+        }
+        Matrix<T> wrong(n, n + 1);
+        CHECK_THROWS(stream::gram(T(1), src, T(0), wrong.view()), lana::DimensionError);
+        lana::Vector<T> short_sums(n - 1);
+        CHECK_THROWS(stream::column_sums(src, short_sums.view()), lana::DimensionError);
+    }
+}
+
+LANA_TEST(stream_f32_reductions) { streamed_reductions<float>(); }
+LANA_TEST(stream_f64_reductions) { streamed_reductions<double>(); }
+
+LANA_TEST(stream_covariance_is_accurate_one_pass) {
+    TempFile file("cov");
+    const index_t m = 900;
+    const index_t n = 40;
+    // Means of 1e8 against a spread of 1: summing x x^T unshifted would
+    // lose every digit of the covariance.
+    Matrix<double> a = lana::test::random_matrix<double>(m, n, 8);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < m; ++i) {
+            a(i, j) += 1e8 * double(j + 1);
+        }
+    }
+    write_both(file.path, a);
+
+    // Two-pass reference.
+    std::vector<double> mean(static_cast<std::size_t>(n), 0.0);
+    for (index_t j = 0; j < n; ++j) {
+        for (index_t i = 0; i < m; ++i) {
+            mean[static_cast<std::size_t>(j)] += a(i, j) / double(m);
+        }
+    }
+    Matrix<double> ref(n, n);
+    for (index_t q = 0; q < n; ++q) {
+        for (index_t p = 0; p < n; ++p) {
+            double s = 0;
+            for (index_t i = 0; i < m; ++i) {
+                s += (a(i, p) - mean[static_cast<std::size_t>(p)]) * (a(i, q) - mean[static_cast<std::size_t>(q)]);
+            }
+            ref(p, q) = s / double(m - 1);
+        }
+    }
+
+    for (const char* section : {"col", "row"}) {
+        const stream::Source src(file.path, section);
+        for (const stream::StreamOptions& opts : every_option()) {
+            Matrix<double> c(n, n);
+            lana::Vector<double> mu(n);
+            stream::covariance(src, c.view(), mu.view(), opts);
+            CHECK_LE(lana::test::max_abs_diff<double>(c.view(), ref.view()), 1e-6);
+            for (index_t j = 0; j < n; ++j) {
+                CHECK_NEAR(mu[j], mean[static_cast<std::size_t>(j)], 1e-13 * mean[static_cast<std::size_t>(j)]);
+            }
+        }
+        Matrix<double> c(n, n);
+        stream::covariance(src, c.view());  // the means are optional
+        CHECK_LE(lana::test::max_abs_diff<double>(c.view(), ref.view()), 1e-6);
+        lana::Vector<double> short_mean(n - 1);
+        CHECK_THROWS(stream::covariance(src, c.view(), short_mean.view()), lana::DimensionError);
+    }
+
+    // One observation has no sample covariance.
+    TempFile single("cov1");
+    lana::save(single.path, MatrixView<const double>(a.block(0, 0, 1, n)));
+    const stream::Source one(single.path, "matrix");
+    Matrix<double> c(n, n);
+    CHECK_THROWS(stream::covariance(one, c.view()), lana::DimensionError);
+}
+
+LANA_TEST(stream_rejects_what_it_cannot_read) {
+    TempFile file("bad");
+    const Matrix<float> f = lana::test::random_matrix<float>(20, 10, 9);
+    const lana::Csr<float> sparse = lana::Csr<float>::from_dense(f.view());
+    {
+        lana::FileWriter w(file.path);
+        w.add("dense", f.view());
+        w.add("sparse", sparse.view());
+        w.close();
+    }
+    CHECK_THROWS(stream::Source(file.path, "sparse"), lana::IoError);
+    CHECK_THROWS(stream::Source(file.path, "missing"), lana::IoError);
+    CHECK_THROWS(stream::Source(file.path + ".none", "dense"), lana::IoError);
+
+    // An f32 section read as f64.
+    stream::Source src(file.path, "dense");
+    const Matrix<double> b(10, 3);
+    Matrix<double> c(20, 3);
+    CHECK_THROWS(stream::gemm(lana::Op::NoTrans, 1.0, src, b.view(), 0.0, c.view()), lana::IoError);
+    lana::Vector<double> sums(10);
+    CHECK_THROWS(stream::column_sums(src, sums.view()), lana::IoError);
+
+    // A moved-from Source gives up its descriptor to the new one.
+    const stream::Source moved = std::move(src);
+    CHECK(src.fd() < 0 && moved.fd() >= 0);
+    double ss = 0;
+    for (index_t j = 0; j < 10; ++j) {
+        for (index_t i = 0; i < 20; ++i) {
+            ss += double(f(i, j)) * double(f(i, j));
+        }
+    }
+    CHECK_NEAR(stream::frobenius_norm(moved), std::sqrt(ss), 1e-12);
+}
+
+}  // namespace
@@ -0,0 +1,269 @@
+// The pool and the executor hook: every index of a region runs exactly
+// once, exceptions reach the caller after the rest of the region, nested
+// regions stay on the same threads, and a foreign executor sees lana's
+// work without being able to deadlock it.
+
+#include "check.hpp"
+
+#include "lana/blas1.hpp"
+#include "lana/error.hpp"
+#include "lana/thread_pool.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+
+/// An executor over one thread of its own that claims `concurrency`
+/// threads, as a host scheduler sharing a few threads among many users
+/// would.
+class OneThreadExecutor final : public lana::Executor {
+public:
+    explicit OneThreadExecutor(int concurrency) : concurrency_(concurrency), thread_([this] { loop(); }) {}
+    ~OneThreadExecutor() override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        cv_.notify_one();
+        thread_.join();
+    }
+
+    int concurrency() const noexcept override { return concurrency_; }
+    void execute(std::function<void()> fn) override {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            jobs_.push_back(std::move(fn));
+            ++executed;
+        }
+        cv_.notify_one();
+    }
+
+    std::atomic<int> executed{0};
+
+private:
+    void loop() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            cv_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+            if (jobs_.empty()) {
+                return;
+            }
+            std::function<void()> job = std::move(jobs_.front());
+            jobs_.pop_front();
+            lock.unlock();
+            job();
+            lock.lock();
+        }
+    }
+
+    const int concurrency_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::function<void()>> jobs_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+/// Runs n indices on `pool` and checks each was called exactly once.
+void covers_every_index(lana::ThreadPool& pool, index_t n) {
+    std::vector<std::atomic<int>> calls(static_cast<std::size_t>(n));
+    pool.run(n, [&](index_t i) { calls[static_cast<std::size_t>(i)].fetch_add(1, std::memory_order_relaxed); });
+    for (const auto& c : calls) {
+        CHECK(c.load() == 1);
+    }
+}
+
+LANA_TEST(pool_runs_every_index_once) {
+    for (int threads : {1, 2, 4}) {
+        lana::ThreadPoolOptions opt;
+        opt.num_threads = threads;
+        lana::ThreadPool pool(opt);
+        CHECK(pool.concurrency() == threads);
+        CHECK(pool.current_worker() == 0);
+        for (index_t n : {0, 1, 2, 7, 1000}) {
+            covers_every_index(pool, n);
+        }
+
+        std::atomic<int> outside{0};
+        pool.run(64, [&](index_t) {
+            const int w = pool.current_worker();
+            if (w < 0 || w >= threads) {
+                outside.fetch_add(1);
+            }
+        });
+        CHECK(outside.load() == 0);
+    }
+}
+
+/// Opens a region of n calls that throws from call `bad`, and checks the
+/// exception arrives with no call still running, calls after it skipped.
+void throws_once_settled(index_t n, index_t bad) {
+    std::atomic<int> started{0};
+    std::atomic<int> finished{0};
+    std::string message;
+    try {
+        lana::detail::parallel_run(n, [&](index_t i) {
+            started.fetch_add(1);
+            if (i == bad) {
+                finished.fetch_add(1);
+                throw std::runtime_error("call " + std::to_string(i));
+            }
+            std::this_thread::yield();
+            finished.fetch_add(1);
+        });
+    } catch (const std::runtime_error& e) {
+        message = e.what();
+    }
+    CHECK(message == "call " + std::to_string(bad));
+    CHECK(started.load() == finished.load());
+    CHECK(finished.load() >= 1 && finished.load() <= n);
+}
+
+LANA_TEST(pool_rethrows_once_the_region_settles) {
+    throws_once_settled(200, 17);
+    throws_once_settled(200, 0);
+    // Serially the calls after the throw never start.
+    lana::ThreadPoolOptions opt;
+    opt.num_threads = 1;
+    lana::ThreadPool serial(opt);
+    int calls = 0;
+    CHECK_THROWS(serial.run(10, [&](index_t i) {
+        ++calls;
+        if (i == 3) {
+            throw lana::Error("fourth");
+        }
+    }),
+                 lana::Error);
+    CHECK(calls == 4);
+    // The pool is still usable afterwards.
+    covers_every_index(lana::default_thread_pool(), 100);
+}
+
+LANA_TEST(pool_nested_regions_complete) {
+    for (int threads : {1, 2, 4}) {
+        lana::ThreadPoolOptions opt;
+        opt.num_threads = threads;
+        lana::ThreadPool pool(opt);
+        std::atomic<int> inner{0};
+        std::atomic<int> off_pool{0};
+        pool.run(8, [&](index_t) {
+            // On a worker parallel_run reuses this pool, not lana's own.
+            if (pool.current_worker() != 0 && lana::detail::parallel_concurrency() != threads) {
+                off_pool.fetch_add(1);
+            }
+            lana::detail::parallel_run(8, [&](index_t) {
+                lana::detail::parallel_run(4, [&](index_t) { inner.fetch_add(1, std::memory_order_relaxed); });
+            });
+        });
+        CHECK(inner.load() == 8 * 8 * 4);
+        CHECK(off_pool.load() == 0);
+    }
+}
+
+LANA_TEST(pool_set_num_threads_from_a_worker_throws) {
+    lana::ThreadPoolOptions opt;
+    opt.num_threads = 2;
+    lana::ThreadPool pool(opt);
+    std::promise<bool> thrown;
+    std::future<bool> result = thrown.get_future();
+    pool.execute([&] {
+        try {
+            lana::set_num_threads(3);
+            thrown.set_value(false);
+        } catch (const lana::Error&) {
+            thrown.set_value(true);
+        }
+    });
+    CHECK(result.get());
+}
+
+LANA_TEST(pool_execute_and_post_run_the_job) {
+    lana::ThreadPoolOptions opt;
+    opt.num_threads = 2;
+    lana::ThreadPool pool(opt);
+    std::promise<int> done;
+    std::future<int> result = done.get_future();
+    pool.execute([&] { done.set_value(pool.current_worker()); });
+    CHECK(result.get() == 1);
+
+    std::promise<void> posted;
+    std::future<void> ran = posted.get_future();
+    lana::detail::post([&] { posted.set_value(); });
+    ran.get();
+}
+
+LANA_TEST(parallel_for_splits_into_disjoint_ranges) {
+    CHECK(lana::num_threads() >= 1);
+    const index_t begin = 13;
+    const index_t end = 10013;
+    for (index_t grain : {0, 1, 64, 5000, 20000}) {
+        std::vector<std::atomic<int>> hits(static_cast<std::size_t>(end));
+        std::atomic<int> short_ranges{0};
+        lana::parallel_for(begin, end, grain, [&](index_t lo, index_t hi) {
+            if (hi - lo < grain && hi != end) {
+                short_ranges.fetch_add(1);
+            }
+            for (index_t i = lo; i < hi; ++i) {
+                hits[static_cast<std::size_t>(i)].fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+        CHECK(short_ranges.load() == 0);
+        for (index_t i = 0; i < end; ++i) {
+            CHECK(hits[static_cast<std::size_t>(i)].load() == (i >= begin ? 1 : 0));
+        }
+    }
+    int calls = 0;
+    lana::parallel_for(5, 5, 1, [&](index_t, index_t) { ++calls; });
+    lana::parallel_for(5, 2, 1, [&](index_t, index_t) { ++calls; });
+    CHECK(calls == 0);
+}
+
+LANA_TEST(foreign_executor_runs_lana_work) {
+    const int pool_threads = lana::num_threads();
+    const lana::Vector<double> x = lana::test::random_vector<double>(100000, 1);
+    const lana::Vector<double> y = lana::test::random_vector<double>(100000, 2);
+    lana::set_determinism(lana::Determinism::Bitwise);
+    const double expected = lana::dot(x.view(), y.view());
+
+    auto ex = std::make_shared<OneThreadExecutor>(3);
+    lana::set_executor(ex);
+    CHECK(lana::num_threads() == 3);
+    std::vector<std::atomic<int>> calls(500);
+    lana::detail::parallel_run(500, [&](index_t i) { calls[static_cast<std::size_t>(i)].fetch_add(1); });
+    for (const auto& c : calls) {
+        CHECK(c.load() == 1);
+    }
+    CHECK(ex->executed.load() > 0);
+    CHECK(lana::dot(x.view(), y.view()) == expected);
+    throws_once_settled(200, 17);
+
+    std::promise<void> posted;
+    std::future<void> ran = posted.get_future();
+    const int before = ex->executed.load();
+    lana::detail::post([&] { posted.set_value(); });
+    ran.get();
+    CHECK(ex->executed.load() == before + 1);
+
+    // The executor lives on while it is installed, whoever else lets go.
+    std::weak_ptr<OneThreadExecutor> weak = ex;
+    ex.reset();
+    CHECK(!weak.expired());
+    lana::detail::parallel_run(10, [](index_t) {});
+    lana::set_executor(nullptr);
+    CHECK(lana::num_threads() == pool_threads);
+    lana::set_determinism(lana::Determinism::Fast);
+}
+
+}  // namespace
@@ -0,0 +1,226 @@
+// Tile-major storage: each tile sits in its own slot in column-major or
+// Z order, copies in and out are exact from any strided view, tile views
+// feed ordinary kernels, and tiled gemm and potrf match the column-major
+// routines, ragged edge tiles included.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/factor.hpp"
+#include "lana/gemm.hpp"
+#include "lana/tiled.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <tuple>
+#include <utility>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+using lana::MatrixView;
+using lana::TiledMatrix;
+using lana::TileOrder;
+
+static_assert(lana::detail::morton_key(0, 0) == 0 && lana::detail::morton_key(1, 0) == 1);
+static_assert(lana::detail::morton_key(0, 1) == 2 && lana::detail::morton_key(1, 1) == 3);
+static_assert(lana::detail::morton_key(2, 0) == 4 && lana::detail::morton_key(3, 3) == 15);
+static_assert(lana::detail::morton_key(0, 0xffffffff) == 0xaaaaaaaaaaaaaaaau);
+
+template <typename T>
+bool identical(MatrixView<const T> a, MatrixView<const T> b) {
+    if (a.rows() != b.rows() || a.cols() != b.cols()) {
+        return false;
+    }
+    for (index_t j = 0; j < a.cols(); ++j) {
+        for (index_t i = 0; i < a.rows(); ++i) {
+            if (!(a(i, j) == b(i, j))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+LANA_TEST(tiled_slots_follow_the_order) {
+    for (TileOrder order : {TileOrder::ColumnMajor, TileOrder::Morton}) {
+        // 5 x 3 tiles of 8 with a ragged last row and column.
+        const TiledMatrix<double> a(37, 19, 8, order);
+        CHECK(a.row_tiles() == 5 && a.col_tiles() == 3 && a.tile_count() == 15 && a.order() == order);
+        CHECK(a.tile(4, 2).rows() == 5 && a.tile(4, 2).cols() == 3 && a.tile(0, 0).rows() == 8);
+
+        // Slot s starts s tiles into the buffer; every tile has one slot.
+        const double* base = a.tile(a.tile_at(0).first, a.tile_at(0).second).data();
+        std::set<std::pair<index_t, index_t>> seen;
+        for (index_t s = 0; s < a.tile_count(); ++s) {
+            const auto [i, j] = a.tile_at(s);
+            const MatrixView<const double> t = a.tile(i, j);
+            CHECK(t.data() == base + s * 64 && t.row_stride() == 1 && t.col_stride() == 8);
+            seen.insert({i, j});
+            if (order == TileOrder::ColumnMajor) {
+                CHECK(i == s % 5 && j == s / 5);
+            }
+        }
+        CHECK(seen.size() == 15);
+        if (order == TileOrder::Morton) {
+            // The first 2 x 2 block of tiles, then the next one down.
+            CHECK(a.tile_at(0) == std::make_pair(index_t(0), index_t(0)));
+            CHECK(a.tile_at(1) == std::make_pair(index_t(1), index_t(0)));
+            CHECK(a.tile_at(2) == std::make_pair(index_t(0), index_t(1)));
+            CHECK(a.tile_at(3) == std::make_pair(index_t(1), index_t(1)));
+            CHECK(a.tile_at(4) == std::make_pair(index_t(2), index_t(0)));
+        }
+        CHECK(a(36, 18) == 0 && a(0, 0) == 0);
+    }
+    const TiledMatrix<float> empty(0, 7, 4);
+    CHECK(empty.tile_count() == 0 && empty.to_matrix().cols() == 7);
+    CHECK_THROWS(TiledMatrix<float>(4, 4, 0), lana::DimensionError);
+}
+
+template <typename T>
+void copies() {
+    const Matrix<T> src = lana::test::random_matrix<T>(45, 62, 1);
+    const Matrix<T> big = lana::test::random_matrix<T>(80, 90, 2);
+    const MatrixView<const T> block = big.block(7, 11, 45, 62);
+    const Matrix<T> srct(src.view().t());
+    const MatrixView<const T> row_major = srct.view().t();
+    for (TileOrder order : {TileOrder::ColumnMajor, TileOrder::Morton}) {
+        for (index_t tile : {1, 7, 16, 64, 100}) {
+            for (MatrixView<const T> v : {src.view(), block, row_major}) {
+                const TiledMatrix<T> t(v, tile, order);
+                CHECK(identical<T>(t.to_matrix().view(), v));
+                bool same = true;
+                for (index_t j = 0; j < 62; ++j) {
+                    for (index_t i = 0; i < 45; ++i) {
+                        same = same && t(i, j) == v(i, j);
+                    }
+                }
+                CHECK(same);
+            }
+        }
+    }
+
+    // Copies are deep and keep the shape and order.
+    TiledMatrix<T> a(src.view(), 16, TileOrder::ColumnMajor);
+    TiledMatrix<T> b = a;
+    b(3, 4) = T(99);
+    CHECK(a(3, 4) == src(3, 4) && b.order() == TileOrder::ColumnMajor && b.tile_size() == 16);
+    Matrix<T> out(45, 62);
+    b.copy_to(out.view());
+    CHECK(out(3, 4) == T(99));
+    Matrix<T> wrong(45, 61);
+    CHECK_THROWS(a.copy_from(wrong.view()), lana::DimensionError);
+    CHECK_THROWS(a.copy_to(wrong.view()), lana::DimensionError);
+
+    // A kernel on one tile view writes that tile's slot and nothing else.
+    const Matrix<T> before = a.to_matrix();
+    lana::gemm(T(1), src.block(0, 0, 16, 5), src.block(0, 0, 5, 16), T(0), a.tile(1, 2));
+    Matrix<T> expect = before;
+    lana::test::reference_gemm<T>(1.0, src.block(0, 0, 16, 5), src.block(0, 0, 5, 16), 0.0,
+                                  expect.block(16, 32, 16, 16));
+    CHECK_LE(lana::test::max_abs_diff<T>(a.to_matrix().view(), expect.view()), lana::test::tolerance<T>(5));
+    CHECK(a(15, 32) == before(15, 32) && a(16, 31) == before(16, 31) && a(32, 32) == before(32, 32));
+
+    // Storage under an AllocPolicy reads as zero either way.
+    lana::AllocPolicy policy;
+    policy.first_touch = true;
+    const TiledMatrix<T> placed(45, 62, 16, TileOrder::Morton, policy);
+    CHECK(lana::test::max_abs<T>(placed.to_matrix().view()) == 0 && placed.alloc_policy() == policy);
+}
+
+LANA_TEST(tiled_f32_copies) { copies<float>(); }
+LANA_TEST(tiled_f64_copies) { copies<double>(); }
+
+template <typename T>
+void tiled_gemm() {
+    for (const auto& [m, n, k, tile] : {std::tuple<index_t, index_t, index_t, index_t>{64, 64, 64, 64},
+                                        {130, 97, 75, 32},
+                                        {300, 260, 150, 64},
+                                        {17, 5, 300, 8},
+                                        {1, 1, 1, 4}}) {
+        const Matrix<T> a0 = lana::test::random_matrix<T>(m, k, 3);
+        const Matrix<T> b0 = lana::test::random_matrix<T>(k, n, 4);
+        const Matrix<T> c0 = lana::test::random_matrix<T>(m, n, 5);
+        // Mixed orders: only the tile size has to agree.
+        const TiledMatrix<T> a(a0.view(), tile, TileOrder::Morton);
+        const TiledMatrix<T> b(b0.view(), tile, TileOrder::ColumnMajor);
+        for (const auto& [alpha, beta] : {std::pair<double, double>{1, 0}, {-0.5, 2}}) {
+            Matrix<T> ref = c0;
+            lana::test::reference_gemm<T>(alpha, a0.view(), b0.view(), beta, ref.view());
+            TiledMatrix<T> c(c0.view(), tile, TileOrder::Morton);
+            if (beta == 0) {
+                c.fill(std::numeric_limits<T>::quiet_NaN());
+            }
+            lana::gemm(T(alpha), a, b, T(beta), c);
+            CHECK_LE(lana::test::max_abs_diff<T>(c.to_matrix().view(), ref.view()), lana::test::tolerance<T>(k));
+        }
+    }
+
+    // k = 0 leaves beta * C.
+    const TiledMatrix<T> a(20, 0, 8);
+    const TiledMatrix<T> b(0, 30, 8);
+    const Matrix<T> c0 = lana::test::random_matrix<T>(20, 30, 6);
+    TiledMatrix<T> c(c0.view(), 8);
+    lana::gemm(T(1), a, b, T(3), c);
+    CHECK(c(19, 29) == T(3) * c0(19, 29));
+
+    // Tile sizes must agree, as must the shapes.
+    const TiledMatrix<T> square(30, 30, 8);
+    TiledMatrix<T> coarse(20, 30, 16);
+    CHECK_THROWS(lana::gemm(T(1), c, square, T(0), coarse), lana::DimensionError);
+    TiledMatrix<T> d(20, 30, 8);
+    CHECK_THROWS(lana::gemm(T(1), c, c, T(0), d), lana::DimensionError);
+}
+
+LANA_TEST(tiled_f32_gemm) { tiled_gemm<float>(); }
+LANA_TEST(tiled_f64_gemm) { tiled_gemm<double>(); }
+
+template <typename T>
+void tiled_potrf() {
+    for (const auto& [n, tile] : {std::pair<index_t, index_t>{50, 64}, {200, 32}, {333, 64}, {129, 16}}) {
+        const Matrix<T> s = lana::test::random_spd<T>(n, 7);
+        Matrix<T> ref = s;
+        CHECK(lana::potrf(ref.view()) == 0);
+        for (TileOrder order : {TileOrder::ColumnMajor, TileOrder::Morton}) {
+            TiledMatrix<T> a(s.view(), tile, order);
+            CHECK(lana::potrf(a) == 0);
+            const Matrix<T> got = a.to_matrix();
+            double lower = 0;
+            bool upper_kept = true;
+            for (index_t j = 0; j < n; ++j) {
+                for (index_t i = 0; i < n; ++i) {
+                    if (i >= j) {
+                        lower = std::max(lower, std::abs(double(got(i, j)) - double(ref(i, j))));
+                    } else {
+                        upper_kept = upper_kept && got(i, j) == s(i, j);
+                    }
+                }
+            }
+            CHECK_LE(lower, 10 * lana::test::tolerance<T>(n));
+            CHECK(upper_kept);
+        }
+    }
+
+    // Not positive definite: the same info as the column-major routine.
+    Matrix<T> bad = lana::test::random_spd<T>(150, 8);
+    bad(100, 100) = T(-1);
+    Matrix<T> ref = bad;
+    const index_t info = lana::potrf(ref.view());
+    CHECK(info == 101);
+    TiledMatrix<T> a(bad.view(), 32);
+    CHECK(lana::potrf(a) == info);
+
+    TiledMatrix<T> rect(40, 30, 16);
+    CHECK_THROWS(lana::potrf(rect), lana::DimensionError);
+    TiledMatrix<T> none(0, 0, 16);
+    CHECK(lana::potrf(none) == 0);
+}
+
+LANA_TEST(tiled_f32_potrf) { tiled_potrf<float>(); }
+LANA_TEST(tiled_f64_potrf) { tiled_potrf<double>(); }
+
+}  // namespace
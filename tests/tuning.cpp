@@ -0,0 +1,211 @@
+// The per-machine GEMM tuning file and blocking overrides: this host's
+// entry is read on first use and other hosts' are ignored, malformed
+// fields are skipped, save_gemm_tuning rewrites only this host's section,
+// and every tile and blocking the tuner may pick still computes C = A * B.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/gemm.hpp"
+
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace {
+
+using lana::GemmBlocking;
+using lana::index_t;
+using lana::Matrix;
+
+/// A scratch directory for this process, removed at exit.
+const std::filesystem::path& scratch() {
+    static const struct Dir {
+        std::filesystem::path path;
+        Dir() : path(std::filesystem::temp_directory_path() / ("lana_tuning_" + std::to_string(::getpid()))) {
+            std::filesystem::create_directories(path);
+        }
+        ~Dir() {
+            std::error_code ec;
+            std::filesystem::remove_all(path, ec);
+        }
+    } dir;
+    return dir.path;
+}
+
+std::string read_file(const std::filesystem::path& p) {
+    std::ifstream in(p);
+    std::ostringstream os;
+    os << in.rdbuf();
+    return os.str();
+}
+
+std::size_t occurrences(const std::string& text, const std::string& what) {
+    std::size_t n = 0;
+    for (std::size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) {
+        ++n;
+    }
+    return n;
+}
+
+template <typename T>
+void check_gemm(index_t m, index_t n, index_t k) {
+    const Matrix<T> a = lana::test::random_matrix<T>(m, k, 1);
+    const Matrix<T> b = lana::test::random_matrix<T>(k, n, 2);
+    const Matrix<T> c0 = lana::test::random_matrix<T>(m, n, 3);
+    Matrix<T> ref = c0;
+    lana::test::reference_gemm<T>(1.5, a.view(), b.view(), -1.0, ref.view());
+    Matrix<T> c = c0;
+    lana::gemm(T(1.5), a.view(), b.view(), T(-1), c.view());
+    CHECK_LE(lana::test::max_abs_diff<T>(c.view(), ref.view()), lana::test::tolerance<T>(k));
+}
+
+// First, before any GEMM in this process loads the file.
+LANA_TEST(tuning_file_is_read_on_first_use) {
+    const std::vector<lana::GemmTile> tiles = lana::gemm_tiles_f32();
+    CHECK(!tiles.empty());
+    const lana::GemmTile tile = tiles.back();
+    const std::filesystem::path file = scratch() / "load.txt";
+    {
+        std::ofstream out(file);
+        out << "# lana gemm tuning v1\n"
+            << "[some other machine;avx2]\n"
+            << "f32 mc=8 kc=8 nc=8 n_split=4\n"
+            << "f64 mc=8\n"
+            << "[" << lana::gemm_tuning_host() << "]\n"
+            << "f32 mc=" << 12 * tile.mr << " kc=256 nc=" << 120 * tile.nr << " mr=" << tile.mr
+            << " nr=" << tile.nr << " n_split=2\n"
+            << "f64 mc=abc kc=-5 nc bogus=7 kc=200\n"
+            << "f16 mc=64\n";
+    }
+    ::setenv("LANA_TUNE_FILE", file.c_str(), 1);
+    CHECK(lana::gemm_tuning_path() == file.string());
+
+    const GemmBlocking f = lana::gemm_blocking_f32();
+    CHECK(f.mc == 12 * tile.mr && f.kc == 256 && f.nc == 120 * tile.nr);
+    CHECK(f.mr == tile.mr && f.nr == tile.nr && f.n_split == 2);
+    // Only kc=200 is a valid f64 field; the rest is host-derived.
+    const GemmBlocking d = lana::gemm_blocking_f64();
+    CHECK(d.kc == 200);
+    CHECK(d.mc > 8 && d.nc > 8 && d.n_split == 1);
+    check_gemm<float>(300, 200, 500);
+    check_gemm<double>(130, 70, 450);
+    ::setenv("LANA_TUNE_FILE", "", 1);
+}
+
+LANA_TEST(tuning_path_follows_the_environment) {
+    const auto saved = [](const char* name) {
+        const char* v = std::getenv(name);
+        return std::string(v != nullptr ? v : "");
+    };
+    const std::string tune_file = saved("LANA_TUNE_FILE");
+    const std::string xdg = saved("XDG_CACHE_HOME");
+    const std::string home = saved("HOME");
+    ::setenv("LANA_TUNE_FILE", "/x/y.txt", 1);
+    CHECK(lana::gemm_tuning_path() == "/x/y.txt");
+    ::unsetenv("LANA_TUNE_FILE");
+    ::setenv("XDG_CACHE_HOME", "/cache", 1);
+    CHECK(lana::gemm_tuning_path() == "/cache/lana/gemm_tuning.txt");
+    ::setenv("XDG_CACHE_HOME", "", 1);
+    ::setenv("HOME", "/home/u", 1);
+    CHECK(lana::gemm_tuning_path() == "/home/u/.cache/lana/gemm_tuning.txt");
+    ::setenv("LANA_TUNE_FILE", tune_file.c_str(), 1);
+    ::setenv("XDG_CACHE_HOME", xdg.c_str(), 1);
+    ::setenv("HOME", home.c_str(), 1);
+
+    const std::string host = lana::gemm_tuning_host();
+    CHECK(host.find(';') != std::string::npos);
+    CHECK(host.find_first_of("[]\n") == std::string::npos);
+}
+
+LANA_TEST(save_keeps_other_hosts_entries) {
+    const std::filesystem::path file = scratch() / "sub" / "dir" / "save.txt";
+    std::filesystem::create_directories(file.parent_path());
+    std::string mine = "[";
+    mine += lana::gemm_tuning_host();
+    mine += ']';
+    {
+        std::ofstream out(file);
+        out << "# lana gemm tuning v1\n"
+            << "[other;avx2]\n"
+            << "f32 mc=96 kc=128 nc=960 mr=0 nr=0 n_split=1\n"
+            << mine << "\nf32 mc=1 kc=1 nc=1 mr=0 nr=0 n_split=1\n"
+            << "[third;scalar]\n"
+            << "f64 mc=48 kc=64 nc=480 mr=0 nr=0 n_split=3\n";
+    }
+    const GemmBlocking f32_before = lana::gemm_blocking_f32();
+    const GemmBlocking f64_before = lana::gemm_blocking_f64();
+    GemmBlocking b = f64_before;
+    b.kc = 128;
+    b.n_split = 3;
+    lana::set_gemm_blocking_f64(b);
+    lana::save_gemm_tuning(file.string());
+    lana::save_gemm_tuning(file.string());  // idempotent
+
+    const std::string text = read_file(file);
+    CHECK(text.rfind("# lana gemm tuning v1\n", 0) == 0);
+    CHECK(occurrences(text, "# lana gemm tuning") == 1);
+    CHECK(occurrences(text, mine) == 1);
+    CHECK(text.find("[other;avx2]\nf32 mc=96 kc=128 nc=960 mr=0 nr=0 n_split=1\n") != std::string::npos);
+    CHECK(text.find("[third;scalar]\nf64 mc=48 kc=64 nc=480 mr=0 nr=0 n_split=3\n") != std::string::npos);
+    CHECK(text.find("mc=1 kc=1") == std::string::npos);
+    const std::string f64_line = "f64 mc=" + std::to_string(b.mc) + " kc=128";
+    CHECK(text.find(mine + "\n") + mine.size() + 1 == text.find("f32 ", text.find(mine)));
+    CHECK(text.find(f64_line) != std::string::npos);
+    CHECK(!std::filesystem::exists(file.string() + ".tmp." + std::to_string(::getpid())));
+
+    // A directory where the file should be cannot be replaced.
+    const std::filesystem::path blocked = scratch() / "blocked";
+    std::filesystem::create_directories(blocked / "inner");
+    CHECK_THROWS(lana::save_gemm_tuning(blocked.string()), lana::IoError);
+
+    lana::set_gemm_blocking_f32(f32_before);
+    lana::set_gemm_blocking_f64(f64_before);
+}
+
+template <typename T>
+void every_tile_and_split() {
+    const auto get = [] { return std::is_same_v<T, float> ? lana::gemm_blocking_f32() : lana::gemm_blocking_f64(); };
+    const auto set = [](const GemmBlocking& b) {
+        std::is_same_v<T, float> ? lana::set_gemm_blocking_f32(b) : lana::set_gemm_blocking_f64(b);
+    };
+    const std::vector<lana::GemmTile> tiles =
+        std::is_same_v<T, float> ? lana::gemm_tiles_f32() : lana::gemm_tiles_f64();
+    const GemmBlocking before = get();
+    for (const lana::GemmTile& tile : tiles) {
+        for (int split : {1, 2, 3}) {
+            GemmBlocking b;
+            b.mr = tile.mr;
+            b.nr = tile.nr;
+            b.kc = 100;  // rounded down to a multiple of 8
+            b.mc = 5 * tile.mr + 1;
+            b.nc = 7 * tile.nr + 1;
+            b.n_split = split;
+            set(b);
+            const GemmBlocking r = get();
+            CHECK(r.mr == tile.mr && r.nr == tile.nr && r.n_split == split);
+            CHECK(r.kc == 96 && r.mc == 5 * tile.mr && r.nc == 7 * tile.nr);
+            // Several KC, MC and NC blocks with ragged edges on each.
+            check_gemm<T>(11 * tile.mr + 3, 15 * tile.nr + 5, 250);
+            check_gemm<T>(tile.mr - 1 > 0 ? tile.mr - 1 : 1, 3, 7);
+        }
+    }
+    // A tile this ISA does not have selects the default one.
+    GemmBlocking odd;
+    odd.mr = 5;
+    odd.nr = 3;
+    set(odd);
+    CHECK(get().mr == tiles.front().mr && get().nr == tiles.front().nr);
+    set(before);
+}
+
+LANA_TEST(tuning_f32_every_tile_and_split) { every_tile_and_split<float>(); }
+LANA_TEST(tuning_f64_every_tile_and_split) { every_tile_and_split<double>(); }
+
+}  // namespace
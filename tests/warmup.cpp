@@ -0,0 +1,113 @@
+// Lazy start-up: loading lana starts no threads, first use from many
+// threads at once agrees on one kernel path, and warmup() builds the pool
+// once. Cases run in file order, so the first ones see a cold library (in
+// the default-ISA variant even the kernel tables are unselected; a forced
+// LANA_ISA has main() consult active_isa() before any case).
+
+#include "check.hpp"
+
+#include "lana/blas1.hpp"
+#include "lana/cpu.hpp"
+#include "lana/gemm.hpp"
+#include "lana/thread_pool.hpp"
+#include "lana/warmup.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using lana::index_t;
+using lana::Matrix;
+
+/// Threads in this process, from /proc/self/status; -1 where there is none.
+int process_threads() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("Threads:", 0) == 0) {
+            return std::stoi(line.substr(8));
+        }
+    }
+    return -1;
+}
+
+LANA_TEST(loading_starts_no_threads) {
+    const int threads = process_threads();
+    CHECK(threads == 1 || threads == -1);
+}
+
+LANA_TEST(concurrent_first_use) {
+    const index_t n = 96;
+    const Matrix<double> a = lana::test::random_matrix<double>(n, n, 1);
+    const Matrix<double> b = lana::test::random_matrix<double>(n, n, 2);
+    const Matrix<double> ref = lana::test::reference_product<double>(a.view(), b.view());
+    constexpr int racers = 8;
+    std::vector<Matrix<double>> c(racers, Matrix<double>(n, n));
+    std::vector<lana::Isa> seen(racers);
+    std::atomic<int> ready{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < racers; ++t) {
+        threads.emplace_back([&, t] {
+            ready.fetch_add(1);
+            while (ready.load() < racers) {
+            }
+            lana::gemm(1.0, a.view(), b.view(), 0.0, c[static_cast<std::size_t>(t)].view());
+            seen[static_cast<std::size_t>(t)] = lana::active_isa();
+        });
+    }
+    for (std::thread& t : threads) {
+        t.join();
+    }
+    for (int t = 0; t < racers; ++t) {
+        const Matrix<double>& ct = c[static_cast<std::size_t>(t)];
+        CHECK(seen[static_cast<std::size_t>(t)] == seen[0]);
+        CHECK_LE(lana::test::max_abs_diff<double>(ct.view(), ref.view()), lana::test::tolerance<double>(n));
+        // One kernel path, one blocking: the same bits on every thread.
+        CHECK(std::memcmp(ct.data(), c[0].data(), sizeof(double) * std::size_t(n * n)) == 0);
+    }
+}
+
+LANA_TEST(warmup_starts_the_pool_once) {
+    lana::warmup();
+    const int pool = lana::num_threads();
+    CHECK(pool >= 1);
+    if (const char* env = std::getenv("LANA_NUM_THREADS"); env != nullptr && std::atoi(env) > 0) {
+        CHECK(pool == std::atoi(env));
+    }
+    // The caller is one of the pool's threads, so it starts pool - 1.
+    const int threads = process_threads();
+    CHECK(threads == -1 || threads == pool);
+    lana::warmup();
+    CHECK(lana::num_threads() == pool);
+    CHECK(process_threads() == threads);
+}
+
+LANA_TEST(active_isa_is_runnable) {
+    const lana::Isa isa = lana::active_isa();
+    CHECK(lana::isa_supported(isa));
+    CHECK(lana::isa_supported(lana::Isa::Scalar));
+    if (const char* forced = std::getenv("LANA_ISA"); forced != nullptr && *forced != '\0') {
+        CHECK(std::strcmp(lana::isa_name(isa), forced) == 0);
+    }
+    CHECK(!lana::gemm_tiles_f32().empty());
+    CHECK(!lana::gemm_tiles_f64().empty());
+}
+
+LANA_TEST(set_num_threads_rebuilds_the_pool) {
+    lana::set_num_threads(2);
+    std::atomic<int> ran{0};
+    lana::detail::parallel_run(16, [&](index_t) { ran.fetch_add(1); });
+    CHECK(ran.load() == 16);
+    CHECK(lana::num_threads() == 2);
+    CHECK(process_threads() == -1 || process_threads() == 2);
+    lana::set_num_threads(0);
+    const lana::Vector<double> x(1 << 18, 1.0);
+    CHECK(lana::sum(x.view()) == double(1 << 18));
+}
+
+}  // namespace
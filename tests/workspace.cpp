@@ -0,0 +1,183 @@
+// Scratch and container memory: the workspace's alignment, LIFO release,
+// growth and merge back into one chunk, and the small-block pool behind
+// Matrix and Vector storage.
+
+#include "check.hpp"
+
+#include "lana/error.hpp"
+#include "lana/memory.hpp"
+#include "lana/workspace.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+using lana::Workspace;
+
+bool aligned(const void* p, std::size_t alignment) { return reinterpret_cast<std::uintptr_t>(p) % alignment == 0; }
+
+LANA_TEST(workspace_allocations_are_aligned_and_disjoint) {
+    Workspace ws;
+    CHECK(ws.allocate(0) == nullptr);
+    std::vector<std::pair<char*, std::size_t>> blocks;
+    std::size_t total = 0;
+    for (std::size_t alignment : {1, 8, 64, 256, 4096}) {
+        for (std::size_t bytes : {1, 3, 100, 5000}) {
+            auto* p = static_cast<char*>(ws.allocate(bytes, alignment));
+            CHECK(p != nullptr);
+            CHECK(aligned(p, alignment));
+            std::memset(p, static_cast<int>(blocks.size()), bytes);
+            blocks.emplace_back(p, bytes);
+            total += bytes;
+        }
+    }
+    CHECK(aligned(ws.allocate(1), lana::default_alignment));
+    // Each block still holds what was written to it.
+    for (std::size_t b = 0; b < blocks.size(); ++b) {
+        for (std::size_t i = 0; i < blocks[b].second; ++i) {
+            CHECK(blocks[b].first[i] == static_cast<char>(b));
+        }
+    }
+    CHECK_LE(total, ws.used());
+    CHECK_LE(ws.used(), ws.capacity());
+
+    const lana::MatrixView<double> m = ws.matrix<double>(7, 5);
+    CHECK(m.rows() == 7 && m.cols() == 5 && m.col_stride() == 7 && aligned(m.data(), 64));
+    const lana::VectorView<float> v = ws.vector<float>(33);
+    CHECK(v.size() == 33 && v.stride() == 1 && aligned(v.data(), 64));
+}
+
+LANA_TEST(workspace_scopes_release_in_lifo_order) {
+    Workspace ws;
+    void* first = nullptr;
+    {
+        Workspace::Scope outer(ws);
+        first = ws.allocate(1000);
+        const std::size_t after_first = ws.used();
+        void* inner_block = nullptr;
+        {
+            Workspace::Scope inner(ws);
+            inner_block = ws.allocate(2000);
+            CHECK(ws.used() >= after_first + 2000);
+        }
+        CHECK(ws.used() == after_first);
+        // The released space is handed out again.
+        CHECK(ws.allocate(2000) == inner_block);
+    }
+    CHECK(ws.used() == 0);
+    CHECK(ws.allocate(1000) == first);
+
+    const Workspace::Mark mark = ws.mark();
+    ws.allocate(123);
+    ws.release(mark);
+    CHECK(ws.used() == 1000);
+    ws.reset();
+    CHECK(ws.used() == 0);
+    CHECK(ws.high_water() >= 3000);
+}
+
+LANA_TEST(workspace_merges_its_chunks_when_emptied) {
+    lana::WorkspaceOptions opt;
+    opt.initial_bytes = 1024;
+    Workspace ws(opt);
+    const std::size_t initial = ws.capacity();
+    CHECK(initial >= 1024);
+
+    const auto run = [&ws] {
+        Workspace::Scope scope(ws);
+        for (int i = 0; i < 6; ++i) {
+            std::memset(ws.allocate(std::size_t(100) << 10), i, std::size_t(100) << 10);
+        }
+    };
+    run();
+    const std::size_t grown = ws.capacity();
+    CHECK(grown > initial);
+    CHECK(ws.used() == 0);
+    // A repeat of the same workload fits in the merged chunk.
+    run();
+    CHECK(ws.capacity() == grown);
+    // One chunk of the combined size: a block as large as all six fits
+    // without growing.
+    {
+        Workspace::Scope scope(ws);
+        ws.allocate(std::size_t(600) << 10);
+        CHECK(ws.capacity() == grown);
+    }
+}
+
+LANA_TEST(workspace_reserve_and_move) {
+    Workspace ws;
+    ws.reserve(std::size_t(1) << 20);
+    const std::size_t capacity = ws.capacity();
+    CHECK(capacity >= std::size_t(1) << 20);
+    {
+        Workspace::Scope scope(ws);
+        ws.allocate(std::size_t(1) << 20, 64);
+        CHECK(ws.capacity() == capacity);
+        CHECK_THROWS(ws.reserve(16), lana::Error);
+    }
+
+    auto* p = static_cast<int*>(ws.allocate(sizeof(int) * 4));
+    p[3] = 42;
+    Workspace moved(std::move(ws));
+    CHECK(moved.used() >= sizeof(int) * 4);
+    CHECK(moved.capacity() == capacity);
+    CHECK(p[3] == 42);
+    CHECK(ws.capacity() == 0 && ws.used() == 0);
+    Workspace other;
+    other = std::move(moved);
+    CHECK(other.capacity() == capacity);
+}
+
+LANA_TEST(workspace_transparent_huge_pages_fall_back) {
+    lana::WorkspaceOptions opt;
+    opt.huge_pages = true;
+    Workspace ws(opt);
+    auto* p = static_cast<double*>(ws.allocate(sizeof(double) * 100000, 4096));
+    CHECK(aligned(p, 4096));
+    for (int i = 0; i < 100000; ++i) {
+        p[i] = i;
+    }
+    CHECK(p[99999] == 99999);
+}
+
+LANA_TEST(thread_workspace_is_per_thread) {
+    Workspace* mine = &lana::thread_workspace();
+    CHECK(&lana::thread_workspace() == mine);
+    Workspace* theirs = nullptr;
+    std::thread([&theirs] { theirs = &lana::thread_workspace(); }).join();
+    CHECK(theirs != nullptr && theirs != mine);
+}
+
+LANA_TEST(pooled_blocks_are_recycled) {
+    // A freed small block is the next one handed out for that size.
+    void* a = lana::detail::pooled_alloc(1000);
+    CHECK(aligned(a, 64));
+    lana::detail::pooled_free(a, 1000);
+    void* b = lana::detail::pooled_alloc(1000);
+    CHECK(b == a);
+
+    // Blocks may be freed on another thread.
+    void* c = lana::detail::pooled_alloc(3000);
+    std::thread([c] { lana::detail::pooled_free(c, 3000); }).join();
+    lana::detail::pooled_free(b, 1000);
+
+    // Past pooled_max_bytes requests go to the system.
+    const std::size_t big = lana::detail::pooled_max_bytes + 1;
+    auto* d = static_cast<char*>(lana::detail::pooled_alloc(big));
+    CHECK(aligned(d, 64));
+    d[big - 1] = 1;
+    lana::detail::pooled_free(d, big);
+    lana::release_thread_cache();
+
+    CHECK(lana::aligned_alloc(0) == nullptr);
+    void* e = lana::aligned_alloc(100, 512);
+    CHECK(aligned(e, 512));
+    lana::aligned_free(e);
+    lana::aligned_free(nullptr);
+}
+
+}  // namespace